@@ -0,0 +1,460 @@
+#include "accessor.hpp"
+#include "simd.hpp"
+#include "math.hpp"
+
+#if TEST
+    #include "test.hpp"
+#endif
+
+                                        /* Scalar */
+
+static float accessor_component_to_float(const u8 *src, Gltf_Accessor_Type component_type, bool normalized) {
+    switch(component_type) {
+    case GLTF_ACCESSOR_TYPE_BYTE:
+    {
+        s8 x = (s8)src[0];
+        return normalized ? fmaxf(x / 127.0f, -1.0f) : (float)x;
+    }
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_BYTE:
+        return normalized ? src[0] / 255.0f : (float)src[0];
+    case GLTF_ACCESSOR_TYPE_SHORT:
+    {
+        s16 x;
+        memcpy(&x, src, 2);
+        return normalized ? fmaxf(x / 32767.0f, -1.0f) : (float)x;
+    }
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_SHORT:
+    {
+        u16 x;
+        memcpy(&x, src, 2);
+        return normalized ? x / 65535.0f : (float)x;
+    }
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_INT:
+    {
+        u32 x;
+        memcpy(&x, src, 4);
+        return (float)x;
+    }
+    case GLTF_ACCESSOR_TYPE_FLOAT:
+    {
+        float x;
+        memcpy(&x, src, 4);
+        return x;
+    }
+    default:
+        assert(false && "Invalid accessor component type");
+        return 0;
+    }
+}
+
+static u32 accessor_component_to_u32(const u8 *src, Gltf_Accessor_Type component_type) {
+    switch(component_type) {
+    case GLTF_ACCESSOR_TYPE_BYTE:
+        return (u32)(s32)(s8)src[0];
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_BYTE:
+        return src[0];
+    case GLTF_ACCESSOR_TYPE_SHORT:
+    {
+        s16 x;
+        memcpy(&x, src, 2);
+        return (u32)(s32)x;
+    }
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_SHORT:
+    {
+        u16 x;
+        memcpy(&x, src, 2);
+        return x;
+    }
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_INT:
+    {
+        u32 x;
+        memcpy(&x, src, 4);
+        return x;
+    }
+    case GLTF_ACCESSOR_TYPE_FLOAT:
+    {
+        float x;
+        memcpy(&x, src, 4);
+        return (u32)(s32)x;
+    }
+    default:
+        assert(false && "Invalid accessor component type");
+        return 0;
+    }
+}
+
+static void accessor_convert_component(const u8 *src, Gltf_Accessor_Type component_type, bool normalized,
+                                       Accessor_Read_Format format, u8 *dst)
+{
+    switch(format) {
+    case ACCESSOR_READ_FORMAT_FLOAT:
+    {
+        float f = accessor_component_to_float(src, component_type, normalized);
+        memcpy(dst, &f, 4);
+        break;
+    }
+    case ACCESSOR_READ_FORMAT_HALF:
+    {
+        u16 h = float_to_half(accessor_component_to_float(src, component_type, normalized));
+        memcpy(dst, &h, 2);
+        break;
+    }
+    case ACCESSOR_READ_FORMAT_U32:
+    {
+        u32 x = accessor_component_to_u32(src, component_type);
+        memcpy(dst, &x, 4);
+        break;
+    }
+    case ACCESSOR_READ_FORMAT_U16:
+    {
+        u16 x = (u16)accessor_component_to_u32(src, component_type);
+        memcpy(dst, &x, 2);
+        break;
+    }
+    }
+}
+
+                                        /* SIMD */
+
+// Each lane holds a raw component in its low bits (the upper bits are junk for gathered u8/u16).
+inline static __m256 accessor_lanes_to_float(__m256i x, Gltf_Accessor_Type component_type, bool normalized) {
+    __m256 f;
+    switch(component_type) {
+    case GLTF_ACCESSOR_TYPE_BYTE:
+        f = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(x, 24), 24));
+        if (normalized)
+            f = _mm256_max_ps(_mm256_mul_ps(f, _mm256_set1_ps(1.0f / 127.0f)), _mm256_set1_ps(-1.0f));
+        return f;
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_BYTE:
+        f = _mm256_cvtepi32_ps(_mm256_and_si256(x, _mm256_set1_epi32(0xff)));
+        if (normalized)
+            f = _mm256_mul_ps(f, _mm256_set1_ps(1.0f / 255.0f));
+        return f;
+    case GLTF_ACCESSOR_TYPE_SHORT:
+        f = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16));
+        if (normalized)
+            f = _mm256_max_ps(_mm256_mul_ps(f, _mm256_set1_ps(1.0f / 32767.0f)), _mm256_set1_ps(-1.0f));
+        return f;
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_SHORT:
+        f = _mm256_cvtepi32_ps(_mm256_and_si256(x, _mm256_set1_epi32(0xffff)));
+        if (normalized)
+            f = _mm256_mul_ps(f, _mm256_set1_ps(1.0f / 65535.0f));
+        return f;
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_INT:
+        // There is no unsigned convert before avx512. The halves convert exactly, and the one rounding is in the
+        // add, so this matches the scalar path.
+        f = _mm256_cvtepi32_ps(_mm256_srli_epi32(x, 16));
+        return _mm256_add_ps(_mm256_mul_ps(f, _mm256_set1_ps(65536.0f)),
+                             _mm256_cvtepi32_ps(_mm256_and_si256(x, _mm256_set1_epi32(0xffff))));
+    default: // GLTF_ACCESSOR_TYPE_FLOAT
+        return _mm256_castsi256_ps(x);
+    }
+}
+
+inline static __m256i accessor_lanes_to_int(__m256i x, Gltf_Accessor_Type component_type) {
+    switch(component_type) {
+    case GLTF_ACCESSOR_TYPE_BYTE:
+        return _mm256_srai_epi32(_mm256_slli_epi32(x, 24), 24);
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_BYTE:
+        return _mm256_and_si256(x, _mm256_set1_epi32(0xff));
+    case GLTF_ACCESSOR_TYPE_SHORT:
+        return _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16);
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_SHORT:
+        return _mm256_and_si256(x, _mm256_set1_epi32(0xffff));
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_INT:
+        return x;
+    default: // GLTF_ACCESSOR_TYPE_FLOAT
+        return _mm256_cvttps_epi32(_mm256_castsi256_ps(x));
+    }
+}
+
+// Convert 8 lanes and store them as 8 consecutive components of 'format'.
+inline static void accessor_store_lanes(__m256i x, Gltf_Accessor_Type component_type, bool normalized,
+                                        Accessor_Read_Format format, u8 *dst)
+{
+    switch(format) {
+    case ACCESSOR_READ_FORMAT_FLOAT:
+        _mm256_storeu_ps((float*)dst, accessor_lanes_to_float(x, component_type, normalized));
+        break;
+    case ACCESSOR_READ_FORMAT_HALF:
+        _mm_storeu_si128((__m128i*)dst, simd_float_to_half_8(accessor_lanes_to_float(x, component_type, normalized)));
+        break;
+    case ACCESSOR_READ_FORMAT_U32:
+        _mm256_storeu_si256((__m256i*)dst, accessor_lanes_to_int(x, component_type));
+        break;
+    case ACCESSOR_READ_FORMAT_U16:
+    {
+        // Truncate rather than saturate (packus), the same as the scalar cast.
+        const __m256i low_halves = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                    0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+        x = _mm256_shuffle_epi8(accessor_lanes_to_int(x, component_type), low_halves);
+        x = _mm256_permute4x64_epi64(x, 0x08);
+        _mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(x));
+        break;
+    }
+    }
+}
+
+//
+// 'src' points at the first element, 'src_size' is how many bytes may be read from 'src' (to the end of the
+// buffer view): gathers read 4 bytes for every component, so the last few elements of u8/u16 data may have to
+// be left to the scalar tail.
+//
+static void accessor_read_dense(const u8 *src, u64 src_size, u32 byte_stride, u32 count, u32 component_count,
+                                Gltf_Accessor_Type component_type, bool normalized, Accessor_Read_Format format,
+                                u8 *dst)
+{
+    u32 component_size = gltf_accessor_get_component_size(component_type);
+    u32 format_size    = accessor_read_format_get_size(format);
+    u32 element_size   = component_size * component_count;
+
+    u64 total = (u64)count * component_count; // components
+    u64 i     = 0;
+
+    if (byte_stride == 0 || byte_stride == element_size) {
+        // Packed: the accessor is just a flat array of components.
+        __m256i x;
+        switch(component_size) {
+        case 1:
+            for(; i + 8 <= total; i += 8) {
+                x = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(src + i)));
+                accessor_store_lanes(x, component_type, normalized, format, dst + i * format_size);
+            }
+            break;
+        case 2:
+            for(; i + 8 <= total; i += 8) {
+                x = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i*)(src + i * 2)));
+                accessor_store_lanes(x, component_type, normalized, format, dst + i * format_size);
+            }
+            break;
+        default:
+            for(; i + 8 <= total; i += 8) {
+                x = _mm256_loadu_si256((__m256i*)(src + i * 4));
+                accessor_store_lanes(x, component_type, normalized, format, dst + i * format_size);
+            }
+            break;
+        }
+        for(; i < total; ++i)
+            accessor_convert_component(src + i * component_size, component_type, normalized, format,
+                                       dst + i * format_size);
+        return;
+    }
+
+    //
+    // Strided: work in blocks of 8 elements (8 * component_count components). Output component j of a block comes
+    // from element j / component_count, component j % component_count, so the gather offsets for the whole block
+    // are fixed and only the base pointer moves.
+    //
+    assert(component_count <= 16);
+    alignas(32) s32 offsets[16 * 8];
+    for(u32 j = 0; j < component_count * 8; ++j)
+        offsets[j] = (j / component_count) * byte_stride + (j % component_count) * component_size;
+
+    u64 block_read_size = (u64)7 * byte_stride + (component_count - 1) * component_size + 4;
+    u64 block           = 0;
+    const u8 *base;
+    __m256i x;
+    for(; (block + 8) <= count && block * byte_stride + block_read_size <= src_size; block += 8) {
+        base = src + block * byte_stride;
+        for(u32 v = 0; v < component_count; ++v) {
+            x = _mm256_i32gather_epi32((const int*)base, _mm256_load_si256((__m256i*)(offsets + v * 8)), 1);
+            accessor_store_lanes(x, component_type, normalized, format,
+                                 dst + (block * component_count + v * 8) * format_size);
+        }
+    }
+
+    u8 *out = dst + block * component_count * format_size;
+    for(; block < count; ++block) {
+        base = src + block * byte_stride;
+        for(u32 c = 0; c < component_count; ++c) {
+            accessor_convert_component(base + c * component_size, component_type, normalized, format, out);
+            out += format_size;
+        }
+    }
+}
+
+bool gltf_accessor_read(Gltf *gltf, const Gltf_Accessor *accessor, const u8 *const *buffers,
+                        Accessor_Read_Format format, void *dst)
+{
+    u32 component_count = gltf_accessor_get_component_count(accessor->type);
+    u32 component_size  = gltf_accessor_get_component_size(accessor->component_type);
+    u32 format_size     = accessor_read_format_get_size(format);
+
+    // Byte and short matrices pad their columns to 4 bytes. I have never seen one in the wild.
+    if ((accessor->type == GLTF_ACCESSOR_TYPE_MAT2 && component_size == 1) ||
+        (accessor->type == GLTF_ACCESSOR_TYPE_MAT3 && component_size <  4))
+    {
+        return false;
+    }
+
+    if (accessor->buffer_view >= 0) {
+        const Gltf_Buffer_View *view = gltf_buffer_view_by_index(gltf, accessor->buffer_view);
+
+        // @Todo Meshopt views have to be decoded (meshopt_decode_buffer_view(..)) before they can be read.
+        assert(view->meshopt.mode == GLTF_MESHOPT_MODE_NONE && "Cannot read from a compressed buffer view");
+        assert(buffers[view->buffer] && "Buffer view references a buffer with no data");
+
+        const u8 *src = buffers[view->buffer] + view->byte_offset + accessor->byte_offset;
+        u64 src_size  = view->byte_length - accessor->byte_offset;
+
+        accessor_read_dense(src, src_size, accessor->byte_stride, accessor->count, component_count,
+                            accessor->component_type, accessor->normalized, format, (u8*)dst);
+    } else {
+        memset(dst, 0, gltf_accessor_get_read_size(accessor, format));
+    }
+
+    if (accessor->sparse_count) {
+        const Gltf_Buffer_View *indices_view = gltf_buffer_view_by_index(gltf, accessor->indices_buffer_view);
+        const Gltf_Buffer_View *values_view  = gltf_buffer_view_by_index(gltf, accessor->values_buffer_view);
+
+        const u8 *indices = buffers[indices_view->buffer] + indices_view->byte_offset + accessor->indices_byte_offset;
+        const u8 *values  = buffers[values_view->buffer]  + values_view->byte_offset  + accessor->values_byte_offset;
+
+        u32 index_size   = gltf_accessor_get_component_size(accessor->indices_component_type);
+        u32 element_size = component_size * component_count;
+
+        u32 index;
+        u8 *out;
+        for(u32 i = 0; i < (u32)accessor->sparse_count; ++i) {
+            index = accessor_component_to_u32(indices + i * index_size, accessor->indices_component_type);
+            assert(index < (u32)accessor->count && "Sparse index out of range");
+
+            out = (u8*)dst + (u64)index * component_count * format_size;
+            for(u32 c = 0; c < component_count; ++c)
+                accessor_convert_component(values + i * element_size + c * component_size, accessor->component_type,
+                                           accessor->normalized, format, out + c * format_size);
+        }
+    }
+
+    return true;
+}
+
+#if TEST
+static void test_accessor_fill_buffer(u8 *buffer) {
+    // view 0 (0, 256) and view 2 (768, 256): byte pattern for the integer accessors
+    for(u32 i = 0; i < 256; ++i) {
+        buffer[i]       = (u8)(i * 37 + 11);
+        buffer[768 + i] = (u8)(i * 59 + 3);
+    }
+    // view 1 (256, 512): floats
+    float f;
+    for(u32 i = 0; i < 128; ++i) {
+        f = i * 0.37f - 20.0f;
+        memcpy(buffer + 256 + i * 4, &f, 4);
+    }
+    // view 3 (1024, 16): u8 sparse indices, view 4 (1040, 24): float sparse values
+    buffer[1024] = 3;
+    buffer[1025] = 7;
+    float values[6] = {1, 2, 3, -4, -5, -6};
+    memcpy(buffer + 1040, values, sizeof(values));
+}
+
+void test_accessor() {
+    u64 mark = get_mark_temp();
+
+    Gltf gltf = parse_gltf("test/test_accessor.gltf");
+
+    u8 *buffer = (u8*)malloc_t(2048, 16);
+    test_accessor_fill_buffer(buffer);
+    const u8 *buffers[] = {buffer};
+
+    BEGIN_TEST_MODULE("Accessor_Read", false, false);
+
+    float *f   = (float*)malloc_t(sizeof(float) * 1024, 32);
+    u16   *h   = (u16*)  malloc_t(sizeof(u16)   * 1024, 32);
+    u32   *u   = (u32*)  malloc_t(sizeof(u32)   * 1024, 32);
+    u32 fails;
+
+    // 0: u8 normalized vec4, packed (count 11: 5 vector iterations and a tail)
+    Gltf_Accessor *accessor = gltf_accessor_by_index(&gltf, 0);
+    TEST_EQ("unorm8_read", gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_FLOAT, f), true, false);
+    fails = 0;
+    for(u32 i = 0; i < 44; ++i)
+        fails += fabsf(f[i] - buffer[i] / 255.0f) > 1e-6;
+    TEST_EQ("unorm8_to_float", fails, 0, false);
+
+    // 1: s16 normalized vec3, byte stride 8, byte offset 2
+    accessor = gltf_accessor_by_index(&gltf, 1);
+    TEST_EQ("snorm16_read", gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_FLOAT, f), true, false);
+    gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_HALF, h);
+    fails = 0;
+    s16 s;
+    float expect;
+    for(u32 i = 0; i < 20; ++i)
+        for(u32 c = 0; c < 3; ++c) {
+            memcpy(&s, buffer + 768 + 2 + i * 8 + c * 2, 2);
+            expect = fmaxf(s / 32767.0f, -1.0f);
+            fails += fabsf(f[i * 3 + c] - expect) > 1e-6;
+            fails += h[i * 3 + c] != float_to_half(f[i * 3 + c]);
+        }
+    TEST_EQ("snorm16_strided_to_float_and_half", fails, 0, false);
+
+    // 2: float vec3, byte stride 16
+    accessor = gltf_accessor_by_index(&gltf, 2);
+    gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_HALF, h);
+    gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_FLOAT, f);
+    fails = 0;
+    for(u32 i = 0; i < 17; ++i)
+        for(u32 c = 0; c < 3; ++c) {
+            expect = (i * 4 + c) * 0.37f - 20.0f;
+            fails += f[i * 3 + c] != expect;
+            fails += h[i * 3 + c] != float_to_half(expect);
+        }
+    TEST_EQ("float_strided_to_float_and_half", fails, 0, false);
+
+    // 3: u16 scalar, packed
+    accessor = gltf_accessor_by_index(&gltf, 3);
+    gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_U32, u);
+    fails = 0;
+    for(u32 i = 0; i < 30; ++i)
+        fails += u[i] != (u32)(buffer[i * 2] | (buffer[i * 2 + 1] << 8));
+    TEST_EQ("u16_to_u32", fails, 0, false);
+
+    // 4: u32 scalar, packed, narrowed
+    accessor = gltf_accessor_by_index(&gltf, 4);
+    gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_U16, h);
+    fails = 0;
+    for(u32 i = 0; i < 13; ++i)
+        fails += h[i] != (u16)(buffer[i * 4] | (buffer[i * 4 + 1] << 8));
+    TEST_EQ("u32_to_u16", fails, 0, false);
+
+    // 5: u8 vec3 not normalized, stride 4: the last elements are too close to the view end to gather
+    accessor = gltf_accessor_by_index(&gltf, 5);
+    gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_FLOAT, f);
+    fails = 0;
+    for(u32 i = 0; i < 64; ++i)
+        for(u32 c = 0; c < 3; ++c)
+            fails += f[i * 3 + c] != (float)buffer[i * 4 + c];
+    TEST_EQ("u8_strided_view_end", fails, 0, false);
+
+    // 6: float vec3, no buffer view, sparse
+    accessor = gltf_accessor_by_index(&gltf, 6);
+    gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_FLOAT, f);
+    TEST_FEQ("sparse[3].x", f[9],  1.0f, false);
+    TEST_FEQ("sparse[3].z", f[11], 3.0f, false);
+    TEST_FEQ("sparse[7].y", f[22], -5.0f, false);
+    TEST_FEQ("sparse[0].x", f[0],  0.0f, false);
+    TEST_FEQ("sparse[9].z", f[29], 0.0f, false);
+
+    // 7: u8 mat3 (padded columns) is not supported
+    accessor = gltf_accessor_by_index(&gltf, 7);
+    TEST_EQ("padded_matrix", gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_FLOAT, f), false, false);
+
+    // 4 again, as float, with the high bit set in both the vector loop (0..7) and the tail (8..12).
+    u32 big[13] = {0x80000000, 0xffffffff, 0x80000081, 0xfffffe80, 0x7fffffff, 0, 1, 0xc0000040,
+                   0x80000000, 0xffffffff, 0x800000c0, 0x8000ff00, 12345};
+    memcpy(buffer, big, sizeof(big));
+    accessor = gltf_accessor_by_index(&gltf, 4);
+    gltf_accessor_read(&gltf, accessor, buffers, ACCESSOR_READ_FORMAT_FLOAT, f);
+    TEST_FEQ("u32_high_bit_to_float", f[0], 2147483648.0f, false);
+    TEST_FEQ("u32_high_bit_to_float_tail", f[8], 2147483648.0f, false);
+    fails = 0;
+    for(u32 i = 0; i < 13; ++i)
+        fails += f[i] != (float)big[i];
+    TEST_EQ("u32_to_float", fails, 0, false);
+
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif
@@ -0,0 +1,78 @@
+#ifndef SOL_ACCESSOR_HPP_INCLUDE_GUARD_
+#define SOL_ACCESSOR_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "gltf.hpp"
+
+/*
+    Accessor Reader: Turn any gltf accessor into tightly packed data of some destination format on the cpu.
+
+    Handles every component type (u8/s8/u16/s16/u32/float), normalized or not, strided or packed, and applies
+    sparse substitution on top. Anything which wants to look at attribute data (skinning, bounds, mesh
+    optimization, cooking) should go through this rather than poking at buffer views itself.
+
+    The common paths are avx2: packed u8/u16 are widened straight from memory, strided data is pulled with
+    gathers, and float -> half is simd_float_to_half_8(..). Everything else (tails, sparse values) goes through
+    the scalar element converter, which is also the reference the tests check the kernels against.
+
+    'buffers' is indexed by Gltf_Buffer_View::buffer, so it is the loaded (or decoded) data of every gltf buffer.
+*/
+
+enum Accessor_Read_Format {
+    ACCESSOR_READ_FORMAT_FLOAT = 0, // normalized ints map to [0, 1] (unsigned) or [-1, 1] (signed)
+    ACCESSOR_READ_FORMAT_HALF  = 1, // same mapping as FLOAT
+    ACCESSOR_READ_FORMAT_U32   = 2, // ints are widened, floats are truncated
+    ACCESSOR_READ_FORMAT_U16   = 3, // ints are narrowed, it is on the caller to know that they fit
+};
+
+inline static u32 gltf_accessor_get_component_count(Gltf_Accessor_Type type) {
+    switch(type) {
+    case GLTF_ACCESSOR_TYPE_SCALAR: return 1;
+    case GLTF_ACCESSOR_TYPE_VEC2:   return 2;
+    case GLTF_ACCESSOR_TYPE_VEC3:   return 3;
+    case GLTF_ACCESSOR_TYPE_VEC4:   return 4;
+    case GLTF_ACCESSOR_TYPE_MAT2:   return 4;
+    case GLTF_ACCESSOR_TYPE_MAT3:   return 9;
+    case GLTF_ACCESSOR_TYPE_MAT4:   return 16;
+    default:
+        assert(false && "Invalid accessor type");
+        return 0;
+    }
+}
+inline static u32 gltf_accessor_get_component_size(Gltf_Accessor_Type component_type) {
+    switch(component_type) {
+    case GLTF_ACCESSOR_TYPE_BYTE:
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_BYTE:
+        return 1;
+    case GLTF_ACCESSOR_TYPE_SHORT:
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_SHORT:
+        return 2;
+    case GLTF_ACCESSOR_TYPE_UNSIGNED_INT:
+    case GLTF_ACCESSOR_TYPE_FLOAT:
+        return 4;
+    default:
+        assert(false && "Invalid accessor component type");
+        return 0;
+    }
+}
+inline static u32 accessor_read_format_get_size(Accessor_Read_Format format) {
+    return (format == ACCESSOR_READ_FORMAT_FLOAT || format == ACCESSOR_READ_FORMAT_U32) ? 4 : 2;
+}
+
+// Size in bytes of 'accessor' once read in 'format' (count * component count * format size, no padding).
+inline static u64 gltf_accessor_get_read_size(const Gltf_Accessor *accessor, Accessor_Read_Format format) {
+    return (u64)accessor->count * gltf_accessor_get_component_count(accessor->type) *
+           accessor_read_format_get_size(format);
+}
+
+// Read 'accessor' into 'dst' (which must have room for gltf_accessor_get_read_size(..) bytes). Accessors without
+// a buffer view read as zeros (plus any sparse values), as per the spec. Returns false for accessors that the
+// reader does not support (byte/short matrices, which have padded columns).
+bool gltf_accessor_read(Gltf *gltf, const Gltf_Accessor *accessor, const u8 *const *buffers,
+                        Accessor_Read_Format format, void *dst);
+
+#if TEST
+    void test_accessor();
+#endif
+
+#endif // include guard
@@ -101,6 +101,17 @@ u8 *malloc_t(u64 size, u64 alignment) {
     return ret;
 }
 
+u8 *malloc_linear(Linear_Allocator *allocator, u64 size, u64 alignment) {
+    size = align(size, alignment);
+    allocator->used = align(allocator->used, alignment);
+
+    u8 *ret = allocator->memory + allocator->used;
+    allocator->used += size;
+
+    assert(allocator->used <= allocator->capacity && "Linear Allocator Overflow");
+    return ret;
+}
+
 u8 *realloc_t(void *ptr, u64 new_size, u64 old_size, u64 alignment) {
     u8 *ret = malloc_t(new_size, alignment);
     memcpy(ret, ptr, old_size);
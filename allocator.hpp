@@ -44,6 +44,9 @@ u8 *realloc_h(void *ptr, u64 new_size);  // Reallocate a heap allocation
 u8 *malloc_t(u64 size, u64 alignment = 16); // Make a temporary allocation
 u8 *realloc_t(void *ptr, u64 new_size, u64 old_size, u64 alignment); // Reallocate temp allocation (malloc_t + memcpy)
 
+// Allocate from a linear allocator which is not the global temp allocator (e.g. an arena owned by some document).
+u8 *malloc_linear(Linear_Allocator *allocator, u64 size, u64 alignment = 16);
+
 inline void free_h(void *ptr) { // Free a heap allocation
     u64 size = tlsf_block_size(ptr);
 
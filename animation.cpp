@@ -0,0 +1,1801 @@
+#include <math.h>
+
+#include "animation.hpp"
+#include "accessor.hpp"
+#include "allocator.hpp"
+#include "math.hpp"
+#include "print.h"
+#include "simd.hpp"
+
+#if TEST
+    #include "test.hpp"
+    #include "file.hpp"
+#endif
+
+#if BENCH
+    #include "test/bench.hpp"
+    #include "file.hpp"
+#endif
+
+                                            /* Clips */
+
+static bool animation_channel_is_supported(const Gltf_Animation_Channel *channel) {
+    return channel->path == GLTF_ANIMATION_PATH_TRANSLATION || channel->path == GLTF_ANIMATION_PATH_ROTATION ||
+           channel->path == GLTF_ANIMATION_PATH_SCALE;
+}
+inline static Animation_Path animation_path_from_gltf(Gltf_Animation_Path path) {
+    return (Animation_Path)(path - GLTF_ANIMATION_PATH_TRANSLATION);
+}
+inline static u32 animation_path_get_component_count(u32 path) {
+    return path == ANIMATION_PATH_ROTATION ? 4 : 3;
+}
+
+bool animation_clip_from_gltf(Gltf *gltf, u32 animation_index, const u8 *const *buffers, Animation_Clip *clip) {
+    // Touch the sections first: on a lazy gltf they are parsed into temp, so they have to come before the mark.
+    // Accessors parse their buffer views with them.
+    Gltf_Animation *animation      = gltf_animation_by_index(gltf, animation_index);
+    u32             accessor_count = gltf_accessor_get_count(gltf);
+    u32             node_count     = gltf_node_get_count(gltf);
+
+    u64 mark = get_mark_temp();
+
+    *clip = {};
+    clip->node_count = node_count;
+
+    // Tracks which share an input accessor share its times.
+    u32 *time_offsets = (u32*)malloc_t(sizeof(u32) * accessor_count, 4);
+    memset(time_offsets, 0xff, sizeof(u32) * accessor_count);
+
+    u32 group_counts[ANIMATION_GROUP_COUNT] = {};
+
+    const Gltf_Animation_Channel *channel;
+    const Gltf_Animation_Sampler *sampler;
+    const Gltf_Accessor          *input;
+    const Gltf_Accessor          *output;
+    u32 group;
+    for(u32 i = 0; i < (u32)animation->channel_count; ++i) {
+        channel = &animation->channels[i];
+        if (!animation_channel_is_supported(channel))
+            continue;
+
+        assert(channel->sampler < animation->sampler_count && "Animation channel sampler out of range");
+        assert(channel->target_node < (int)clip->node_count && "Animation channel node out of range");
+
+        sampler = &animation->samplers[channel->sampler];
+        input   = gltf_accessor_by_index(gltf, sampler->input);
+        output  = gltf_accessor_by_index(gltf, sampler->output);
+        group   = animation_get_group(animation_path_from_gltf(channel->path), (Animation_Interp)sampler->interp);
+
+        assert(input->type == GLTF_ACCESSOR_TYPE_SCALAR && input->count > 0 && "Invalid animation sampler input");
+        assert(output->count == input->count * (sampler->interp == GLTF_ANIMATION_INTERP_CUBICSPLINE ? 3 : 1) &&
+               "Animation sampler output count does not match its input");
+        assert(gltf_accessor_get_component_count(output->type) ==
+               animation_path_get_component_count(animation_path_from_gltf(channel->path)) &&
+               "Animation sampler output type does not match its channel's path");
+
+        group_counts[group]++;
+        clip->track_count++;
+        clip->value_count += output->count;
+        if (time_offsets[sampler->input] == Max_u32) {
+            time_offsets[sampler->input]  = clip->time_count;
+            clip->time_count             += input->count;
+        }
+    }
+
+    u32 offset = 0;
+    for(u32 i = 0; i < ANIMATION_GROUP_COUNT; ++i) {
+        clip->group_offsets[i]  = offset;
+        offset                 += group_counts[i];
+    }
+    clip->group_offsets[ANIMATION_GROUP_COUNT] = offset;
+
+    if (!clip->track_count) {
+        reset_to_mark_temp(mark);
+        return true;
+    }
+
+    // One block: | tracks | times | x values | y values | z values | w values |
+    u64 size_tracks = align(sizeof(Animation_Track) * clip->track_count, 32);
+    u64 size_times  = align(sizeof(float) * clip->time_count, 32);
+    u64 size_values = align(sizeof(float) * clip->value_count, 32);
+
+    u8 *block = malloc_h(size_tracks + size_times + size_values * 4, 32);
+    clip->tracks = (Animation_Track*)block;
+    clip->times  = (float*)(block + size_tracks);
+    for(u32 c = 0; c < 4; ++c)
+        clip->values[c] = (float*)(block + size_tracks + size_times + size_values * c);
+
+    // w is only read for rotations, but it is zeroed so that nothing reads garbage.
+    memset(clip->values[3], 0, size_values);
+
+    u8  *times_read   = malloc_t(accessor_count, 1);
+    memset(times_read, 0, accessor_count);
+
+    u32 group_cursors[ANIMATION_GROUP_COUNT];
+    memcpy(group_cursors, clip->group_offsets, sizeof(group_cursors));
+
+    bool   ok           = true;
+    u32    value_cursor = 0;
+    u32    component_count;
+    u32    key_count;
+    float *scratch;
+    Animation_Track *track;
+    for(u32 i = 0; i < (u32)animation->channel_count && ok; ++i) {
+        channel = &animation->channels[i];
+        if (!animation_channel_is_supported(channel))
+            continue;
+
+        sampler = &animation->samplers[channel->sampler];
+        input   = gltf_accessor_by_index(gltf, sampler->input);
+        output  = gltf_accessor_by_index(gltf, sampler->output);
+        group   = animation_get_group(animation_path_from_gltf(channel->path), (Animation_Interp)sampler->interp);
+
+        key_count = input->count;
+        if (!times_read[sampler->input]) {
+            ok &= gltf_accessor_read(gltf, input, buffers, ACCESSOR_READ_FORMAT_FLOAT,
+                                     clip->times + time_offsets[sampler->input]);
+            times_read[sampler->input] = 1;
+        }
+
+        // Values are read interleaved, then split into the component pools.
+        component_count = gltf_accessor_get_component_count(output->type);
+        scratch = (float*)malloc_t(gltf_accessor_get_read_size(output, ACCESSOR_READ_FORMAT_FLOAT), 4);
+        ok &= gltf_accessor_read(gltf, output, buffers, ACCESSOR_READ_FORMAT_FLOAT, scratch);
+        for(u32 j = 0; j < (u32)output->count; ++j)
+            for(u32 c = 0; c < component_count; ++c)
+                clip->values[c][value_cursor + j] = scratch[j * component_count + c];
+
+        track = &clip->tracks[group_cursors[group]++];
+        track->node         = channel->target_node;
+        track->key_count    = key_count;
+        track->time_offset  = time_offsets[sampler->input];
+        track->value_offset = value_cursor;
+        value_cursor       += output->count;
+
+        if (clip->times[track->time_offset + key_count - 1] > clip->duration)
+            clip->duration = clip->times[track->time_offset + key_count - 1];
+    }
+
+    reset_to_mark_temp(mark);
+
+    if (!ok)
+        animation_clip_free(clip);
+    return ok;
+}
+
+void animation_clip_free(Animation_Clip *clip) {
+    if (clip->tracks)
+        free_h(clip->tracks);
+    *clip = {};
+}
+
+                                            /* Poses */
+
+u64 animation_pose_get_size(u32 node_count) {
+    return align(sizeof(float) * node_count, 32) * 10;
+}
+
+void animation_pose_init(Animation_Pose *pose, u32 node_count, void *memory) {
+    assert(((u64)memory & 3) == 0 && "Animation pose memory must be 4 byte aligned");
+
+    u64 stride = align(sizeof(float) * node_count, 32);
+    float *arrays[10];
+    for(u32 i = 0; i < 10; ++i)
+        arrays[i] = (float*)((u8*)memory + stride * i);
+
+    pose->node_count = node_count;
+    for(u32 c = 0; c < 3; ++c) {
+        pose->translation[c] = arrays[c];
+        pose->scale[c]       = arrays[7 + c];
+    }
+    for(u32 c = 0; c < 4; ++c)
+        pose->rotation[c] = arrays[3 + c];
+}
+
+void animation_pose_copy(Animation_Pose *dst, const Animation_Pose *src) {
+    assert(dst->node_count == src->node_count && "Animation poses are different sizes");
+    u64 size = sizeof(float) * src->node_count;
+    for(u32 c = 0; c < 3; ++c) {
+        memcpy(dst->translation[c], src->translation[c], size);
+        memcpy(dst->scale[c],       src->scale[c],       size);
+    }
+    for(u32 c = 0; c < 4; ++c)
+        memcpy(dst->rotation[c], src->rotation[c], size);
+}
+
+//
+// Gltf matrices are column major, and Mat4 is filled in file order, so 'rowN' is column N. Scale is the length of
+// each basis column (x is negated if the basis is left handed), rotation is from the normalized basis.
+//
+static void animation_decompose_matrix(const Mat4 *m, Gltf_Trs *trs) {
+    Vec3 c0 = {m->row0.x, m->row0.y, m->row0.z};
+    Vec3 c1 = {m->row1.x, m->row1.y, m->row1.z};
+    Vec3 c2 = {m->row2.x, m->row2.y, m->row2.z};
+
+    trs->translation = {m->row3.x, m->row3.y, m->row3.z};
+
+    float sx = magnitude_vec3(c0);
+    float sy = magnitude_vec3(c1);
+    float sz = magnitude_vec3(c2);
+
+    Vec3 cross = {c0.y * c1.z - c0.z * c1.y, c0.z * c1.x - c0.x * c1.z, c0.x * c1.y - c0.y * c1.x};
+    if (dot_vec3(cross, c2) < 0)
+        sx = -sx;
+    trs->scale = {sx, sy, sz};
+
+    // r_ij is row i, column j of the rotation
+    float r00 = c0.x / sx, r10 = c0.y / sx, r20 = c0.z / sx;
+    float r01 = c1.x / sy, r11 = c1.y / sy, r21 = c1.z / sy;
+    float r02 = c2.x / sz, r12 = c2.y / sz, r22 = c2.z / sz;
+
+    float s;
+    float trace = r00 + r11 + r22;
+    if (trace > 0) {
+        s = sqrtf(trace + 1.0f) * 2;
+        trs->rotation = {(r21 - r12) / s, (r02 - r20) / s, (r10 - r01) / s, 0.25f * s};
+    } else if (r00 > r11 && r00 > r22) {
+        s = sqrtf(1.0f + r00 - r11 - r22) * 2;
+        trs->rotation = {0.25f * s, (r01 + r10) / s, (r02 + r20) / s, (r21 - r12) / s};
+    } else if (r11 > r22) {
+        s = sqrtf(1.0f + r11 - r00 - r22) * 2;
+        trs->rotation = {(r01 + r10) / s, 0.25f * s, (r12 + r21) / s, (r02 - r20) / s};
+    } else {
+        s = sqrtf(1.0f + r22 - r00 - r11) * 2;
+        trs->rotation = {(r02 + r20) / s, (r12 + r21) / s, 0.25f * s, (r10 - r01) / s};
+    }
+}
+
+void animation_pose_set_rest(Animation_Pose *pose, Gltf *gltf) {
+    u32 node_count = gltf_node_get_count(gltf);
+    assert(node_count == pose->node_count && "Animation pose size does not match the gltf");
+
+    Gltf_Trs trs;
+    const Gltf_Node *node = gltf->nodes;
+    for(u32 i = 0; i < node_count; ++i) {
+        if (node->has_matrix)
+            animation_decompose_matrix(&node->matrix, &trs);
+        else
+            trs = node->trs;
+
+        pose->translation[0][i] = trs.translation.x;
+        pose->translation[1][i] = trs.translation.y;
+        pose->translation[2][i] = trs.translation.z;
+        pose->rotation[0][i]    = trs.rotation.x;
+        pose->rotation[1][i]    = trs.rotation.y;
+        pose->rotation[2][i]    = trs.rotation.z;
+        pose->rotation[3][i]    = trs.rotation.w;
+        pose->scale[0][i]       = trs.scale.x;
+        pose->scale[1][i]       = trs.scale.y;
+        pose->scale[2][i]       = trs.scale.z;
+
+        node = (const Gltf_Node*)((u8*)node + node->stride);
+    }
+}
+
+inline static float** animation_pose_get_path(Animation_Pose *pose, u32 path) {
+    switch(path) {
+    case ANIMATION_PATH_TRANSLATION: return pose->translation;
+    case ANIMATION_PATH_ROTATION:    return pose->rotation;
+    case ANIMATION_PATH_SCALE:       return pose->scale;
+    default:
+        assert(false && "Invalid animation path");
+        return NULL;
+    }
+}
+
+                                            /* Sampling */
+
+// The key at or before 't', at most key_count - 2 so that there is always a next key (so a step track must check
+// whether it has reached the next key). 't' is already clamped to the keys.
+static u32 animation_find_key(const float *keys, u32 key_count, float t) {
+    if (key_count < 2)
+        return 0;
+
+    u32 lo = 0;
+    u32 hi = key_count - 1;
+    u32 mid;
+    while(hi - lo > 1) {
+        mid = (lo + hi) >> 1;
+        if (keys[mid] <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+inline static float animation_clamp_time(const float *keys, u32 key_count, float t) {
+    t = t < keys[0]             ? keys[0]             : t;
+    t = t > keys[key_count - 1] ? keys[key_count - 1] : t;
+    return t;
+}
+
+//
+// nlerp runs ahead of slerp in the middle of the interval and behind it near the ends, by an amount which grows with
+// the angle between the quaternions. Bending the interpolant by a cubic in t, whose coefficient is fitted against
+// the cosine of the angle, takes nlerp to within ~1e-3 of slerp (the fit is from Zeux, "Approximating slerp", 2015).
+// 'd' is the absolute cosine of the angle.
+//
+static inline float animation_nlerp_correct_scalar(float t, float d) {
+    float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+    float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+    float k = a * (t - 0.5f) * (t - 0.5f) + b;
+    return t + t * (t - 0.5f) * (t - 1.0f) * k;
+}
+static inline __m256 animation_nlerp_correct(__m256 t, __m256 d) {
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 one  = _mm256_set1_ps(1.0f);
+
+    __m256 a = _mm256_sub_ps(_mm256_set1_ps(3.55645f), _mm256_mul_ps(d, _mm256_set1_ps(1.43519f)));
+    a = _mm256_add_ps(_mm256_set1_ps(-3.2452f), _mm256_mul_ps(d, a));
+    a = _mm256_add_ps(_mm256_set1_ps(1.0904f),  _mm256_mul_ps(d, a));
+
+    __m256 b = _mm256_add_ps(_mm256_set1_ps(-1.06021f), _mm256_mul_ps(d, _mm256_set1_ps(0.215638f)));
+    b = _mm256_add_ps(_mm256_set1_ps(0.848013f), _mm256_mul_ps(d, b));
+
+    __m256 th = _mm256_sub_ps(t, half);
+    __m256 k  = _mm256_add_ps(_mm256_mul_ps(a, _mm256_mul_ps(th, th)), b);
+
+    return _mm256_add_ps(t, _mm256_mul_ps(_mm256_mul_ps(t, th), _mm256_mul_ps(_mm256_sub_ps(t, one), k)));
+}
+
+static inline void animation_normalize_quat(__m256 q[4]) {
+    __m256 len = _mm256_mul_ps(q[0], q[0]);
+    len = _mm256_add_ps(len, _mm256_mul_ps(q[1], q[1]));
+    len = _mm256_add_ps(len, _mm256_mul_ps(q[2], q[2]));
+    len = _mm256_add_ps(len, _mm256_mul_ps(q[3], q[3]));
+
+    __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(len));
+    for(u32 c = 0; c < 4; ++c)
+        q[c] = _mm256_mul_ps(q[c], inv);
+}
+
+//
+// One group's tracks for every instance. Lanes are (instance, track) pairs, tracks fastest, so that a batch of eight
+// writes into one or two poses. Only the track fields are loaded per lane: clamping, the key search (a branchless
+// binary search, every lane stepping together until the longest track is done) and the interpolation are eight
+// wide. The tail batch repeats its last lane (so that the gathers stay in bounds) and only writes the real lanes.
+//
+static void animation_sample_group(const Animation_Clip *clip, u32 group, u32 instance_count, const float *times,
+                                   Animation_Pose *poses)
+{
+    u32 begin       = clip->group_offsets[group];
+    u32 track_count = clip->group_offsets[group + 1] - begin;
+    if (!track_count)
+        return;
+
+    u32  path            = group / ANIMATION_INTERP_COUNT;
+    u32  interp          = group % ANIMATION_INTERP_COUNT;
+    u32  component_count = animation_path_get_component_count(path);
+    bool cubic           = interp == ANIMATION_INTERP_CUBICSPLINE;
+
+    alignas(32) float lane_times        [8];
+    alignas(32) s32   lane_time_offsets [8];
+    alignas(32) s32   lane_key_counts   [8];
+    alignas(32) s32   lane_value_offsets[8];
+    alignas(32) float out[4][8];
+    u32 lane_nodes    [8];
+    u32 lane_instances[8];
+
+    __m256  zero   = _mm256_setzero_ps();
+    __m256  one    = _mm256_set1_ps(1.0f);
+    __m256i one_i  = _mm256_set1_epi32(1);
+    __m256i two_i  = _mm256_set1_epi32(2);
+
+    __m256  t;
+    __m256  t0;
+    __m256  t1;
+    __m256  dt;
+    __m256  s;
+    __m256  v0[4];
+    __m256  v1[4];
+    __m256i time_offset;
+    __m256i value_offset;
+    __m256i len;
+    __m256i half;
+    __m256i k;
+    __m256i k1;
+    __m256  first;
+    __m256  last;
+    __m256  span;
+    __m256  wrong;
+    __m256i last_k;
+    __m256i vi0; // The first value of the key: in tangent if cubic
+    __m256i vi1;
+
+    u64 lane_count = (u64)track_count * instance_count;
+    u32 track      = 0;
+    u32 instance   = 0;
+    u32 n;
+    const Animation_Track *tr;
+    for(u64 l = 0; l < lane_count; l += 8) {
+        n = lane_count - l < 8 ? lane_count - l : 8;
+
+        for(u32 j = 0; j < n; ++j) {
+            tr = &clip->tracks[begin + track];
+
+            lane_times        [j] = times[instance];
+            lane_time_offsets [j] = tr->time_offset;
+            lane_key_counts   [j] = tr->key_count;
+            lane_value_offsets[j] = tr->value_offset;
+            lane_nodes        [j] = tr->node;
+            lane_instances    [j] = instance;
+
+            track++;
+            if (track == track_count) {
+                track = 0;
+                instance++;
+            }
+        }
+        for(u32 j = n; j < 8; ++j) {
+            lane_times        [j] = lane_times        [n - 1];
+            lane_time_offsets [j] = lane_time_offsets [n - 1];
+            lane_key_counts   [j] = lane_key_counts   [n - 1];
+            lane_value_offsets[j] = lane_value_offsets[n - 1];
+        }
+
+        time_offset  = _mm256_load_si256((__m256i*)lane_time_offsets);
+        value_offset = _mm256_load_si256((__m256i*)lane_value_offsets);
+        len          = _mm256_sub_epi32(_mm256_load_si256((__m256i*)lane_key_counts), one_i); // Intervals
+
+        // Clamp to the first and last keys
+        t     = _mm256_load_ps(lane_times);
+        first = _mm256_i32gather_ps(clip->times, time_offset, 4);
+        last  = _mm256_i32gather_ps(clip->times, _mm256_add_epi32(time_offset, len), 4);
+        t     = _mm256_min_ps(_mm256_max_ps(t, first), last);
+
+        //
+        // The key is the last interval starting at or before 't' (see animation_find_key(..)). Exported clips are
+        // mostly sampled at a fixed rate, so guess by where 't' is between the first and last keys, and check the
+        // guess with the gathers which interpolation needs anyway. Lanes whose keys are not evenly spaced fall back to
+        // a binary search, every lane stepping together until the longest track is done.
+        //
+        last_k = _mm256_max_epi32(_mm256_sub_epi32(len, one_i), _mm256_setzero_si256());
+        span   = _mm256_sub_ps(last, first);
+        s      = _mm256_div_ps(_mm256_mul_ps(_mm256_sub_ps(t, first), _mm256_cvtepi32_ps(len)), span);
+        s      = _mm256_blendv_ps(s, zero, _mm256_cmp_ps(span, zero, _CMP_EQ_OQ));
+        k      = _mm256_min_epi32(_mm256_cvttps_epi32(s), last_k);
+        k1     = _mm256_add_epi32(k, _mm256_min_epi32(len, one_i)); // One key tracks have len 0
+
+        t0 = _mm256_i32gather_ps(clip->times, _mm256_add_epi32(time_offset, k),  4);
+        t1 = _mm256_i32gather_ps(clip->times, _mm256_add_epi32(time_offset, k1), 4);
+
+        // Wrong if the key starts after 't', or if the next key is at or before 't' (and is not the last key).
+        wrong = _mm256_or_ps(_mm256_cmp_ps(t0, t, _CMP_GT_OQ),
+                             _mm256_and_ps(_mm256_cmp_ps(t1, t, _CMP_LE_OQ),
+                                           _mm256_castsi256_ps(_mm256_cmpgt_epi32(last_k, k))));
+        if (_mm256_movemask_ps(wrong)) {
+            k = _mm256_setzero_si256();
+            while(_mm256_movemask_epi8(_mm256_cmpgt_epi32(len, one_i))) {
+                half = _mm256_srli_epi32(len, 1);
+                t0   = _mm256_i32gather_ps(clip->times, _mm256_add_epi32(time_offset, _mm256_add_epi32(k, half)), 4);
+                k    = _mm256_add_epi32(k, _mm256_and_si256(half, _mm256_castps_si256(_mm256_cmp_ps(t0, t, _CMP_LE_OQ))));
+                len  = _mm256_sub_epi32(len, half);
+            }
+            k1 = _mm256_add_epi32(k, _mm256_min_epi32(len, one_i));
+            t0 = _mm256_i32gather_ps(clip->times, _mm256_add_epi32(time_offset, k),  4);
+            t1 = _mm256_i32gather_ps(clip->times, _mm256_add_epi32(time_offset, k1), 4);
+        }
+
+        if (interp == ANIMATION_INTERP_STEP) {
+            // Take the next key once it is reached (the search never returns the last key)
+            __m256 reached = _mm256_cmp_ps(t, t1, _CMP_GE_OQ);
+            k  = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(k), _mm256_castsi256_ps(k1), reached));
+            t0 = _mm256_blendv_ps(t0, t1, reached);
+        }
+        dt = _mm256_sub_ps(t1, t0);
+
+        if (cubic) {
+            vi0 = _mm256_add_epi32(value_offset, _mm256_add_epi32(k,  _mm256_add_epi32(k,  k)));
+            vi1 = _mm256_add_epi32(value_offset, _mm256_add_epi32(k1, _mm256_add_epi32(k1, k1)));
+        } else {
+            vi0 = _mm256_add_epi32(value_offset, k);
+            vi1 = _mm256_add_epi32(value_offset, k1);
+        }
+
+        // A track with one key (or two keys at the same time) has no interval: take the first key.
+        s = _mm256_div_ps(_mm256_sub_ps(t, t0), dt);
+        s = _mm256_blendv_ps(s, zero, _mm256_cmp_ps(dt, zero, _CMP_EQ_OQ));
+
+        switch(interp) {
+        case ANIMATION_INTERP_STEP:
+        {
+            for(u32 c = 0; c < component_count; ++c)
+                _mm256_store_ps(out[c], _mm256_i32gather_ps(clip->values[c], vi0, 4));
+            break;
+        }
+        case ANIMATION_INTERP_LINEAR:
+        {
+            for(u32 c = 0; c < component_count; ++c) {
+                v0[c] = _mm256_i32gather_ps(clip->values[c], vi0, 4);
+                v1[c] = _mm256_i32gather_ps(clip->values[c], vi1, 4);
+            }
+            if (path == ANIMATION_PATH_ROTATION) {
+                // Shortest path: negate the second key if the quaternions are more than 90 degrees apart.
+                __m256 dot = _mm256_mul_ps(v0[0], v1[0]);
+                for(u32 c = 1; c < 4; ++c)
+                    dot = _mm256_add_ps(dot, _mm256_mul_ps(v0[c], v1[c]));
+
+                __m256 sign = _mm256_and_ps(dot, _mm256_set1_ps(-0.0f));
+                for(u32 c = 0; c < 4; ++c)
+                    v1[c] = _mm256_xor_ps(v1[c], sign);
+
+                s = animation_nlerp_correct(s, _mm256_xor_ps(dot, sign));
+            }
+            for(u32 c = 0; c < component_count; ++c)
+                v0[c] = _mm256_add_ps(v0[c], _mm256_mul_ps(s, _mm256_sub_ps(v1[c], v0[c])));
+
+            if (path == ANIMATION_PATH_ROTATION)
+                animation_normalize_quat(v0);
+
+            for(u32 c = 0; c < component_count; ++c)
+                _mm256_store_ps(out[c], v0[c]);
+            break;
+        }
+        case ANIMATION_INTERP_CUBICSPLINE:
+        {
+            // Hermite basis, tangents scaled by the interval
+            __m256 s2  = _mm256_mul_ps(s, s);
+            __m256 s3  = _mm256_mul_ps(s2, s);
+            __m256 h01 = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(3.0f), s2), _mm256_add_ps(s3, s3));
+            __m256 h00 = _mm256_sub_ps(one, h01);
+            __m256 h11 = _mm256_mul_ps(_mm256_sub_ps(s3, s2), dt);
+            __m256 h10 = _mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(s3, _mm256_add_ps(s2, s2)), s), dt);
+
+            __m256i value0       = _mm256_add_epi32(vi0, one_i);
+            __m256i out_tangent0 = _mm256_add_epi32(vi0, two_i);
+            __m256i value1       = _mm256_add_epi32(vi1, one_i);
+
+            __m256 p;
+            for(u32 c = 0; c < component_count; ++c) {
+                p = _mm256_mul_ps(h00, _mm256_i32gather_ps(clip->values[c], value0, 4));
+                p = _mm256_add_ps(p, _mm256_mul_ps(h10, _mm256_i32gather_ps(clip->values[c], out_tangent0, 4)));
+                p = _mm256_add_ps(p, _mm256_mul_ps(h01, _mm256_i32gather_ps(clip->values[c], value1, 4)));
+                p = _mm256_add_ps(p, _mm256_mul_ps(h11, _mm256_i32gather_ps(clip->values[c], vi1, 4)));
+                v0[c] = p;
+            }
+            if (path == ANIMATION_PATH_ROTATION)
+                animation_normalize_quat(v0);
+
+            for(u32 c = 0; c < component_count; ++c)
+                _mm256_store_ps(out[c], v0[c]);
+            break;
+        }
+        default:
+            assert(false && "Invalid animation interpolation");
+            break;
+        }
+
+        float **dst;
+        for(u32 j = 0; j < n; ++j) {
+            dst = animation_pose_get_path(&poses[lane_instances[j]], path);
+            for(u32 c = 0; c < component_count; ++c)
+                dst[c][lane_nodes[j]] = out[c][j];
+        }
+    }
+}
+
+void animation_sample(const Animation_Clip *clip, u32 instance_count, const float *times, Animation_Pose *poses) {
+    for(u32 i = 0; i < instance_count; ++i)
+        assert(poses[i].node_count == clip->node_count && "Animation pose size does not match the clip");
+
+    for(u32 g = 0; g < ANIMATION_GROUP_COUNT; ++g)
+        animation_sample_group(clip, g, instance_count, times, poses);
+}
+
+static void animation_slerp_scalar(const float q0[4], const float q1_in[4], float s, float ret[4]) {
+    float q1[4] = {q1_in[0], q1_in[1], q1_in[2], q1_in[3]};
+
+    float dot = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+    if (dot < 0) {
+        for(u32 c = 0; c < 4; ++c)
+            q1[c] = -q1[c];
+        dot = -dot;
+    }
+
+    float w0;
+    float w1;
+    if (dot > 0.9995f) { // Nearly parallel, sin(theta) is too small to divide by
+        w0 = 1.0f - s;
+        w1 = s;
+    } else {
+        float theta = acosf(dot);
+        float sin_theta = sinf(theta);
+        w0 = sinf((1.0f - s) * theta) / sin_theta;
+        w1 = sinf(s * theta) / sin_theta;
+    }
+
+    float len = 0;
+    for(u32 c = 0; c < 4; ++c) {
+        ret[c] = w0 * q0[c] + w1 * q1[c];
+        len   += ret[c] * ret[c];
+    }
+    len = sqrtf(len);
+    for(u32 c = 0; c < 4; ++c)
+        ret[c] /= len;
+}
+
+static void animation_sample_track_scalar(const Animation_Clip *clip, const Animation_Track *track, u32 path,
+                                          u32 interp, float time, float ret[4])
+{
+    u32 component_count = animation_path_get_component_count(path);
+    const float *keys = clip->times + track->time_offset;
+
+    float t  = animation_clamp_time(keys, track->key_count, time);
+    u32   k  = animation_find_key(keys, track->key_count, t);
+    u32   k1 = k + (track->key_count > 1);
+
+    float dt = keys[k1] - keys[k];
+    float s  = dt == 0 ? 0 : (t - keys[k]) / dt;
+
+    float v0[4];
+    float v1[4];
+    switch(interp) {
+    case ANIMATION_INTERP_STEP:
+        k = t >= keys[k1] ? k1 : k;
+        for(u32 c = 0; c < component_count; ++c)
+            ret[c] = clip->values[c][track->value_offset + k];
+        break;
+    case ANIMATION_INTERP_LINEAR:
+        for(u32 c = 0; c < component_count; ++c) {
+            v0[c] = clip->values[c][track->value_offset + k];
+            v1[c] = clip->values[c][track->value_offset + k1];
+        }
+        if (path == ANIMATION_PATH_ROTATION) {
+            animation_slerp_scalar(v0, v1, s, ret);
+        } else {
+            for(u32 c = 0; c < component_count; ++c)
+                ret[c] = v0[c] + s * (v1[c] - v0[c]);
+        }
+        break;
+    case ANIMATION_INTERP_CUBICSPLINE:
+    {
+        float s2 = s * s;
+        float s3 = s2 * s;
+        float h00 =  2 * s3 - 3 * s2 + 1;
+        float h10 =      s3 - 2 * s2 + s;
+        float h01 = -2 * s3 + 3 * s2;
+        float h11 =      s3 -     s2;
+
+        const float *values;
+        float len = 0;
+        for(u32 c = 0; c < component_count; ++c) {
+            values = clip->values[c] + track->value_offset;
+            ret[c] = h00 * values[k * 3 + 1] + h10 * dt * values[k * 3 + 2] +
+                     h01 * values[k1 * 3 + 1] + h11 * dt * values[k1 * 3];
+            len   += ret[c] * ret[c];
+        }
+        if (path == ANIMATION_PATH_ROTATION) {
+            len = sqrtf(len);
+            for(u32 c = 0; c < 4; ++c)
+                ret[c] /= len;
+        }
+        break;
+    }
+    default:
+        assert(false && "Invalid animation interpolation");
+        break;
+    }
+}
+
+void animation_sample_scalar(const Animation_Clip *clip, u32 instance_count, const float *times, Animation_Pose *poses) {
+    u32 path;
+    u32 interp;
+    float value[4];
+    float **dst;
+    for(u32 i = 0; i < instance_count; ++i) {
+        assert(poses[i].node_count == clip->node_count && "Animation pose size does not match the clip");
+
+        for(u32 g = 0; g < ANIMATION_GROUP_COUNT; ++g) {
+            path   = g / ANIMATION_INTERP_COUNT;
+            interp = g % ANIMATION_INTERP_COUNT;
+            dst    = animation_pose_get_path(&poses[i], path);
+
+            for(u32 j = clip->group_offsets[g]; j < clip->group_offsets[g + 1]; ++j) {
+                animation_sample_track_scalar(clip, &clip->tracks[j], path, interp, times[i], value);
+                for(u32 c = 0; c < animation_path_get_component_count(path); ++c)
+                    dst[c][clip->tracks[j].node] = value[c];
+            }
+        }
+    }
+}
+
+                                            /* Compression */
+
+static constexpr float ANIMATION_TICKS = 65535.0f;
+
+inline static bool animation_is_smallest_three(u32 path, u32 interp) {
+    return path == ANIMATION_PATH_ROTATION && interp != ANIMATION_INTERP_CUBICSPLINE;
+}
+
+// Of a track's values against the originals, in the units of Animation_Compression_Settings.
+static float animation_get_error(u32 path, const float *a, const float *b) {
+    float ret = 0;
+    float d;
+    switch(path) {
+    case ANIMATION_PATH_TRANSLATION:
+        for(u32 c = 0; c < 3; ++c)
+            ret += (a[c] - b[c]) * (a[c] - b[c]);
+        return sqrtf(ret);
+    case ANIMATION_PATH_ROTATION:
+    {
+        // The chord between unit quaternions (on the same hemisphere) is 2 * sin(angle / 4), which is not as lossy
+        // as acos of the dot product for the tiny angles that this is used for.
+        float dot  = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        float sign = dot < 0 ? -1.0f : 1.0f;
+        for(u32 c = 0; c < 4; ++c)
+            ret += (a[c] - sign * b[c]) * (a[c] - sign * b[c]);
+        ret = sqrtf(ret) * 0.5f;
+        return 4 * asinf(ret > 1 ? 1 : ret);
+    }
+    case ANIMATION_PATH_SCALE:
+        for(u32 c = 0; c < 3; ++c) {
+            d   = fabsf(a[c] - b[c]);
+            ret = d > ret ? d : ret;
+        }
+        return ret;
+    default:
+        assert(false && "Invalid animation path");
+        return 0;
+    }
+}
+
+// Linear interpolation as the sampler does it: rotations are corrected nlerp (see animation_nlerp_correct_scalar(..)).
+static void animation_interpolate_linear(u32 path, const float *v0, const float *v1, float s, float ret[4]) {
+    if (path != ANIMATION_PATH_ROTATION) {
+        for(u32 c = 0; c < 3; ++c)
+            ret[c] = v0[c] + s * (v1[c] - v0[c]);
+        return;
+    }
+
+    float dot  = v0[0] * v1[0] + v0[1] * v1[1] + v0[2] * v1[2] + v0[3] * v1[3];
+    float sign = dot < 0 ? -1.0f : 1.0f;
+    s = animation_nlerp_correct_scalar(s, fabsf(dot));
+
+    float len = 0;
+    for(u32 c = 0; c < 4; ++c) {
+        ret[c] = v0[c] + s * (sign * v1[c] - v0[c]);
+        len   += ret[c] * ret[c];
+    }
+    len = 1.0f / sqrtf(len);
+    for(u32 c = 0; c < 4; ++c)
+        ret[c] *= len;
+}
+
+//
+// Smallest three: the largest component is dropped (made positive first, q and -q are the same rotation) and
+// rebuilt from the unit length on decode. The other three are within +-1/sqrt(2), so they are mapped from that
+// range to 15 bits each. The index of the largest is the top bit of the first two.
+//
+static void animation_encode_quat(const float *q, u16 ret[3]) {
+    u32 largest = 0;
+    for(u32 c = 1; c < 4; ++c)
+        largest = fabsf(q[c]) > fabsf(q[largest]) ? c : largest;
+    float sign = q[largest] < 0 ? -1.0f : 1.0f;
+
+    u32   j = 0;
+    float v;
+    for(u32 c = 0; c < 4; ++c) {
+        if (c == largest)
+            continue;
+        v = (q[c] * sign * (float)M_SQRT2 + 1.0f) * 0.5f;
+        v = v < 0 ? 0 : v > 1 ? 1 : v;
+        ret[j++] = (u16)(v * 32767.0f + 0.5f);
+    }
+    ret[0] |= (u16)((largest >> 1) << 15);
+    ret[1] |= (u16)((largest &  1) << 15);
+}
+
+static void animation_decode_quat(const u16 q[3], float ret[4]) {
+    u32 largest = ((q[0] >> 15) << 1) | (q[1] >> 15);
+
+    u32   j   = 0;
+    float sum = 0;
+    for(u32 c = 0; c < 4; ++c) {
+        if (c == largest)
+            continue;
+        ret[c] = ((float)(q[j++] & 0x7fff) * (2.0f / 32767.0f) - 1.0f) * (float)M_SQRT1_2;
+        sum   += ret[c] * ret[c];
+    }
+    ret[largest] = sqrtf(sum < 1 ? 1 - sum : 0);
+}
+
+// 'range' is the track's min per component then extent per component.
+static void animation_encode_value(const float *v, bool smallest_three, const float *range, u32 component_count,
+                                   u16 *ret)
+{
+    if (smallest_three) {
+        animation_encode_quat(v, ret);
+        return;
+    }
+    float x;
+    for(u32 c = 0; c < component_count; ++c) {
+        x = range[component_count + c] > 0 ? (v[c] - range[c]) / range[component_count + c] : 0;
+        x = x < 0 ? 0 : x > 1 ? 1 : x;
+        ret[c] = (u16)(x * 65535.0f + 0.5f);
+    }
+}
+
+static void animation_decode_value(const u16 *q, bool smallest_three, const float *range, u32 component_count,
+                                   float ret[4])
+{
+    if (smallest_three) {
+        animation_decode_quat(q, ret);
+        return;
+    }
+    for(u32 c = 0; c < component_count; ++c)
+        ret[c] = range[c] + range[component_count + c] * ((float)q[c] * (1.0f / 65535.0f));
+}
+
+//
+// The keys of one track to keep, into 'kept'. 'key_times' are the original times, 'tick_times' those that the
+// decoder will see; 'original' the original values and 'decoded' the quantized ones. Every original key must be
+// within 'tolerance' of what the decoder gives at its time:
+//     step:   a key is dropped if the held (kept) value is close enough to it;
+//     linear: a track which is constant is one key, else from each kept key the span is grown for as long as
+//             interpolating across it reproduces the keys in between. Values between keys are linear in both the
+//             original and the reduced track (or near enough for rotations), so checking at the keys is enough.
+//     cubic:  every key is kept, the tangents belong to their keys.
+//
+static u32 animation_reduce_keys(u32 path, u32 interp, u32 key_count, const float *key_times, const float *tick_times,
+                                 const float (*original)[4], const float (*decoded)[4], float tolerance, u32 *kept)
+{
+    u32 count = 0;
+    if (interp == ANIMATION_INTERP_CUBICSPLINE) {
+        for(u32 k = 0; k < key_count; ++k)
+            kept[count++] = k;
+        return count;
+    }
+
+    kept[count++] = 0;
+    u32 a = 0;
+    if (interp == ANIMATION_INTERP_STEP) {
+        for(u32 k = 1; k < key_count; ++k)
+            if (animation_get_error(path, original[k], decoded[a]) > tolerance) {
+                kept[count++] = k;
+                a = k;
+            }
+        return count;
+    }
+
+    bool constant = true;
+    for(u32 k = 1; k < key_count && constant; ++k)
+        constant = animation_get_error(path, original[k], decoded[0]) <= tolerance;
+    if (constant)
+        return count;
+
+    float v[4];
+    float s;
+    float dt;
+    bool  ok;
+    for(u32 b = a + 2; b < key_count; ++b) {
+        ok = true;
+        dt = tick_times[b] - tick_times[a];
+        for(u32 k = a + 1; k < b && ok; ++k) {
+            s  = dt > 0 ? (key_times[k] - tick_times[a]) / dt : 0;
+            s  = s < 0 ? 0 : s > 1 ? 1 : s;
+            animation_interpolate_linear(path, decoded[a], decoded[b], s, v);
+            ok = animation_get_error(path, original[k], v) <= tolerance;
+        }
+        if (!ok) {
+            a = b - 1;
+            kept[count++] = a;
+        }
+    }
+    kept[count++] = key_count - 1;
+    return count;
+}
+
+void animation_clip_compress(const Animation_Clip *clip, const Animation_Compression_Settings *settings,
+                             Animation_Compressed_Clip *compressed)
+{
+    u64 mark = get_mark_temp();
+
+    *compressed = {};
+    compressed->duration    = clip->duration;
+    compressed->node_count  = clip->node_count;
+    compressed->track_count = clip->track_count;
+    memcpy(compressed->group_offsets, clip->group_offsets, sizeof(clip->group_offsets));
+
+    if (!clip->track_count) {
+        reset_to_mark_temp(mark);
+        return;
+    }
+
+    // Keys are compressed into temp sized as if every key were kept, then copied to the block.
+    u32 max_key_count   = 0;
+    u32 max_value_count = 0;
+    u32 max_track_keys  = 0;
+    u32 path;
+    u32 interp;
+    u32 values_per_key;
+    const Animation_Track *src;
+    for(u32 g = 0; g < ANIMATION_GROUP_COUNT; ++g) {
+        path           = g / ANIMATION_INTERP_COUNT;
+        interp         = g % ANIMATION_INTERP_COUNT;
+        values_per_key = interp == ANIMATION_INTERP_CUBICSPLINE ? 3 : 1;
+        for(u32 j = clip->group_offsets[g]; j < clip->group_offsets[g + 1]; ++j) {
+            src              = &clip->tracks[j];
+            max_key_count   += src->key_count;
+            max_value_count += src->key_count * values_per_key *
+                               animation_compressed_get_value_size((Animation_Path)path, (Animation_Interp)interp);
+            max_track_keys   = src->key_count > max_track_keys ? src->key_count : max_track_keys;
+        }
+    }
+
+    Animation_Compressed_Track *tracks = (Animation_Compressed_Track*)malloc_t(sizeof(Animation_Compressed_Track) * clip->track_count, 4);
+    float *ranges = (float*)malloc_t(sizeof(float) * clip->track_count * 8, 4);
+    u16   *times  = (u16*)  malloc_t(sizeof(u16) * max_key_count, 2);
+    u16   *values = (u16*)  malloc_t(sizeof(u16) * max_value_count, 2);
+
+    // Per track scratch
+    float (*original)[4] = (float(*)[4])malloc_t(sizeof(float) * 4 * max_track_keys * 3, 4);
+    float (*decoded)[4]  = (float(*)[4])malloc_t(sizeof(float) * 4 * max_track_keys * 3, 4);
+    u16   *quantized     = (u16*)  malloc_t(sizeof(u16) * 4 * max_track_keys * 3, 2);
+    u16   *ticks         = (u16*)  malloc_t(sizeof(u16) * max_track_keys, 2);
+    float *tick_times    = (float*)malloc_t(sizeof(float) * max_track_keys, 4);
+    u32   *kept          = (u32*)  malloc_t(sizeof(u32) * max_track_keys, 4);
+
+    float tick_scale  = clip->duration > 0 ? ANIMATION_TICKS / clip->duration : 0;
+    float tick_length = clip->duration / ANIMATION_TICKS;
+
+    u32 range_cursor = 0;
+    u32 time_cursor  = 0;
+    u32 value_cursor = 0;
+
+    u32   component_count;
+    u32   value_size;
+    u32   value_count;
+    u32   kept_count;
+    bool  smallest_three;
+    float tolerance;
+    float lo;
+    float hi;
+    float tick;
+    float *range;
+    const float *keys;
+    Animation_Compressed_Track *dst;
+    for(u32 g = 0; g < ANIMATION_GROUP_COUNT; ++g) {
+        path            = g / ANIMATION_INTERP_COUNT;
+        interp          = g % ANIMATION_INTERP_COUNT;
+        values_per_key  = interp == ANIMATION_INTERP_CUBICSPLINE ? 3 : 1;
+        component_count = animation_path_get_component_count(path);
+        value_size      = animation_compressed_get_value_size((Animation_Path)path, (Animation_Interp)interp);
+        smallest_three  = animation_is_smallest_three(path, interp);
+        tolerance       = path == ANIMATION_PATH_TRANSLATION ? settings->translation_error :
+                          path == ANIMATION_PATH_ROTATION    ? settings->rotation_error    : settings->scale_error;
+
+        for(u32 j = clip->group_offsets[g]; j < clip->group_offsets[g + 1]; ++j) {
+            src         = &clip->tracks[j];
+            dst         = &tracks[j];
+            keys        = clip->times + src->time_offset;
+            value_count = src->key_count * values_per_key;
+
+            for(u32 v = 0; v < value_count; ++v)
+                for(u32 c = 0; c < component_count; ++c)
+                    original[v][c] = clip->values[c][src->value_offset + v];
+
+            range = ranges + range_cursor;
+            dst->range_offset = range_cursor;
+            if (!smallest_three) {
+                for(u32 c = 0; c < component_count; ++c) {
+                    lo = original[0][c];
+                    hi = original[0][c];
+                    for(u32 v = 1; v < value_count; ++v) {
+                        lo = original[v][c] < lo ? original[v][c] : lo;
+                        hi = original[v][c] > hi ? original[v][c] : hi;
+                    }
+                    range[c]                   = lo;
+                    range[component_count + c] = hi - lo;
+                }
+                range_cursor += component_count * 2;
+            }
+
+            // The reduction measures against what the decoder will see.
+            for(u32 v = 0; v < value_count; ++v) {
+                animation_encode_value(original[v], smallest_three, range, component_count, quantized + v * value_size);
+                animation_decode_value(quantized + v * value_size, smallest_three, range, component_count, decoded[v]);
+            }
+            for(u32 k = 0; k < src->key_count; ++k) {
+                tick          = keys[k] * tick_scale + 0.5f;
+                ticks[k]      = (u16)(tick > ANIMATION_TICKS ? ANIMATION_TICKS : tick);
+                tick_times[k] = ticks[k] * tick_length;
+            }
+
+            kept_count = animation_reduce_keys(path, interp, src->key_count, keys, tick_times, original, decoded,
+                                               tolerance, kept);
+
+            dst->node         = src->node;
+            dst->key_count    = kept_count;
+            dst->time_offset  = time_cursor;
+            dst->value_offset = value_cursor;
+            for(u32 k = 0; k < kept_count; ++k) {
+                times[time_cursor++] = ticks[kept[k]];
+                memcpy(values + value_cursor, quantized + kept[k] * values_per_key * value_size,
+                       sizeof(u16) * values_per_key * value_size);
+                value_cursor += values_per_key * value_size;
+            }
+        }
+    }
+
+    compressed->range_count = range_cursor;
+    compressed->time_count  = time_cursor;
+    compressed->value_count = value_cursor;
+
+    // One block: | tracks | ranges | times | values |
+    u64 size_tracks = align(sizeof(Animation_Compressed_Track) * clip->track_count, 16);
+    u64 size_ranges = align(sizeof(float) * range_cursor, 16);
+    u64 size_times  = align(sizeof(u16) * time_cursor, 16);
+    u64 size_values = align(sizeof(u16) * value_cursor, 16);
+
+    u8 *block = malloc_h(size_tracks + size_ranges + size_times + size_values, 16);
+    compressed->tracks = (Animation_Compressed_Track*)block;
+    compressed->ranges = (float*)(block + size_tracks);
+    compressed->times  = (u16*)(block + size_tracks + size_ranges);
+    compressed->values = (u16*)(block + size_tracks + size_ranges + size_times);
+
+    memcpy(compressed->tracks, tracks, sizeof(Animation_Compressed_Track) * clip->track_count);
+    memcpy(compressed->ranges, ranges, sizeof(float) * range_cursor);
+    memcpy(compressed->times,  times,  sizeof(u16) * time_cursor);
+    memcpy(compressed->values, values, sizeof(u16) * value_cursor);
+
+    reset_to_mark_temp(mark);
+}
+
+void animation_compressed_clip_free(Animation_Compressed_Clip *clip) {
+    if (clip->tracks)
+        free_h(clip->tracks);
+    *clip = {};
+}
+
+u64 animation_compressed_clip_get_size(const Animation_Compressed_Clip *clip) {
+    return sizeof(Animation_Compressed_Track) * clip->track_count + sizeof(float) * clip->range_count +
+           sizeof(u16) * (clip->time_count + clip->value_count);
+}
+
+// As animation_find_key(..), over ticks.
+static u32 animation_find_tick(const u16 *ticks, u32 key_count, float t) {
+    if (key_count < 2)
+        return 0;
+
+    u32 lo = 0;
+    u32 hi = key_count - 1;
+    u32 mid;
+    while(hi - lo > 1) {
+        mid = (lo + hi) >> 1;
+        if ((float)ticks[mid] <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void animation_sample_compressed_track(const Animation_Compressed_Clip *clip,
+                                              const Animation_Compressed_Track *track, u32 path, u32 interp,
+                                              float time, float ret[4])
+{
+    u32  component_count = animation_path_get_component_count(path);
+    u32  value_size      = animation_compressed_get_value_size((Animation_Path)path, (Animation_Interp)interp);
+    bool smallest_three  = animation_is_smallest_three(path, interp);
+
+    const u16   *ticks  = clip->times  + track->time_offset;
+    const u16   *values = clip->values + track->value_offset;
+    const float *range  = clip->ranges + track->range_offset;
+
+    // Key times were rounded to ticks, so a step track rounds the time too: at a key's time it has reached the key.
+    float tick_scale = clip->duration > 0 ? ANIMATION_TICKS / clip->duration : 0;
+    float t = time * tick_scale;
+    t = interp == ANIMATION_INTERP_STEP ? floorf(t + 0.5f) : t;
+    t = t < ticks[0]                    ? ticks[0]                    : t;
+    t = t > ticks[track->key_count - 1] ? ticks[track->key_count - 1] : t;
+
+    u32   k  = animation_find_tick(ticks, track->key_count, t);
+    u32   k1 = k + (track->key_count > 1);
+    float dt = (float)(ticks[k1] - ticks[k]);
+    float s  = dt == 0 ? 0 : (t - ticks[k]) / dt;
+
+    float v0[4];
+    float v1[4];
+    switch(interp) {
+    case ANIMATION_INTERP_STEP:
+        k = t >= ticks[k1] ? k1 : k;
+        animation_decode_value(values + k * value_size, smallest_three, range, component_count, ret);
+        break;
+    case ANIMATION_INTERP_LINEAR:
+        animation_decode_value(values + k  * value_size, smallest_three, range, component_count, v0);
+        animation_decode_value(values + k1 * value_size, smallest_three, range, component_count, v1);
+        animation_interpolate_linear(path, v0, v1, s, ret);
+        break;
+    case ANIMATION_INTERP_CUBICSPLINE:
+    {
+        dt = dt == 0 ? 0 : dt / tick_scale; // Seconds, for the tangents
+
+        float s2 = s * s;
+        float s3 = s2 * s;
+        float h00 =  2 * s3 - 3 * s2 + 1;
+        float h10 =      s3 - 2 * s2 + s;
+        float h01 = -2 * s3 + 3 * s2;
+        float h11 =      s3 -     s2;
+
+        // in, value, out per key
+        float value0[4];
+        float out0[4];
+        float in1[4];
+        float value1[4];
+        animation_decode_value(values + (k  * 3 + 1) * value_size, false, range, component_count, value0);
+        animation_decode_value(values + (k  * 3 + 2) * value_size, false, range, component_count, out0);
+        animation_decode_value(values + (k1 * 3 + 0) * value_size, false, range, component_count, in1);
+        animation_decode_value(values + (k1 * 3 + 1) * value_size, false, range, component_count, value1);
+
+        float len = 0;
+        for(u32 c = 0; c < component_count; ++c) {
+            ret[c] = h00 * value0[c] + h10 * dt * out0[c] + h01 * value1[c] + h11 * dt * in1[c];
+            len   += ret[c] * ret[c];
+        }
+        if (path == ANIMATION_PATH_ROTATION) {
+            len = sqrtf(len);
+            for(u32 c = 0; c < 4; ++c)
+                ret[c] /= len;
+        }
+        break;
+    }
+    default:
+        assert(false && "Invalid animation interpolation");
+        break;
+    }
+}
+
+// Track by track (rather than instance by instance as animation_sample_scalar(..)), so that each track's keys are
+// read once for the whole crowd.
+void animation_sample_compressed(const Animation_Compressed_Clip *clip, u32 instance_count, const float *times,
+                                 Animation_Pose *poses)
+{
+    for(u32 i = 0; i < instance_count; ++i)
+        assert(poses[i].node_count == clip->node_count && "Animation pose size does not match the clip");
+
+    u32 path;
+    u32 interp;
+    u32 node;
+    float value[4];
+    float **dst;
+    const Animation_Compressed_Track *track;
+    for(u32 g = 0; g < ANIMATION_GROUP_COUNT; ++g) {
+        path   = g / ANIMATION_INTERP_COUNT;
+        interp = g % ANIMATION_INTERP_COUNT;
+
+        for(u32 j = clip->group_offsets[g]; j < clip->group_offsets[g + 1]; ++j) {
+            track = &clip->tracks[j];
+            node  = track->node;
+            for(u32 i = 0; i < instance_count; ++i) {
+                animation_sample_compressed_track(clip, track, path, interp, times[i], value);
+                dst = animation_pose_get_path(&poses[i], path);
+                for(u32 c = 0; c < animation_path_get_component_count(path); ++c)
+                    dst[c][node] = value[c];
+            }
+        }
+    }
+}
+
+                                            /* Tests */
+
+#if TEST || BENCH
+// CesiumMan's one buffer, and its gltf (in the temp allocator).
+static Gltf animation_load_cesium_man(u8 **buffer) {
+    Gltf gltf = parse_gltf("models/cesium-man/CesiumMan.gltf");
+    Gltf_Buffer *gltf_buffer = gltf_buffer_by_index(&gltf, 0);
+
+    char uri[128];
+    string_format(uri, "models/cesium-man/%s", gltf_buffer->uri);
+    *buffer = (u8*)file_read_bin_temp_large(uri, gltf_buffer->byte_length);
+    return gltf;
+}
+
+static Animation_Pose* animation_alloc_poses_temp(u32 count, u32 node_count) {
+    Animation_Pose *poses = (Animation_Pose*)malloc_t(sizeof(Animation_Pose) * count, 8);
+    for(u32 i = 0; i < count; ++i)
+        animation_pose_init(&poses[i], node_count, malloc_t(animation_pose_get_size(node_count), 4));
+    return poses;
+}
+
+// Largest error of each path between two poses (into 'ret', which holds the largest so far), in the units of
+// Animation_Compression_Settings.
+static void animation_get_pose_error(const Animation_Pose *a, const Animation_Pose *b, float ret[ANIMATION_PATH_COUNT]) {
+    float va[4];
+    float vb[4];
+    float d;
+    float **pa;
+    float **pb;
+    for(u32 p = 0; p < ANIMATION_PATH_COUNT; ++p) {
+        pa = animation_pose_get_path((Animation_Pose*)a, p);
+        pb = animation_pose_get_path((Animation_Pose*)b, p);
+        for(u32 n = 0; n < a->node_count; ++n) {
+            for(u32 c = 0; c < animation_path_get_component_count(p); ++c) {
+                va[c] = pa[c][n];
+                vb[c] = pb[c][n];
+            }
+            d      = animation_get_error(p, va, vb);
+            ret[p] = d > ret[p] ? d : ret[p];
+        }
+    }
+}
+
+// Bytes of a clip's keys as float32, as they are in the gltf.
+static u64 animation_clip_get_key_size(const Animation_Clip *clip) {
+    u64 ret = sizeof(float) * clip->time_count;
+    for(u32 g = 0; g < ANIMATION_GROUP_COUNT; ++g) {
+        u32 path = g / ANIMATION_INTERP_COUNT;
+        for(u32 j = clip->group_offsets[g]; j < clip->group_offsets[g + 1]; ++j)
+            ret += sizeof(float) * animation_path_get_component_count(path) * clip->tracks[j].key_count *
+                   (g % ANIMATION_INTERP_COUNT == ANIMATION_INTERP_CUBICSPLINE ? 3 : 1);
+    }
+    return ret;
+}
+
+// Sample 'clip' with the scalar reference and 'compressed' at 'count' times across the clip (and beyond it), and
+// the largest error of each path.
+static void animation_get_compression_error(const Animation_Clip *clip, const Animation_Compressed_Clip *compressed,
+                                            const Animation_Pose *rest, u32 count, float ret[ANIMATION_PATH_COUNT])
+{
+    u64 mark = get_mark_temp();
+
+    Animation_Pose *poses  = animation_alloc_poses_temp(count, clip->node_count);
+    Animation_Pose *scalar = animation_alloc_poses_temp(count, clip->node_count);
+    float          *times  = (float*)malloc_t(sizeof(float) * count, 4);
+    for(u32 i = 0; i < count; ++i) {
+        times[i] = -0.25f + i * (clip->duration + 0.5f) / count;
+        animation_pose_copy(&poses[i],  rest);
+        animation_pose_copy(&scalar[i], rest);
+    }
+    animation_sample_scalar(clip, count, times, scalar);
+    animation_sample_compressed(compressed, count, times, poses);
+
+    for(u32 p = 0; p < ANIMATION_PATH_COUNT; ++p)
+        ret[p] = 0;
+    for(u32 i = 0; i < count; ++i)
+        animation_get_pose_error(&poses[i], &scalar[i], ret);
+
+    reset_to_mark_temp(mark);
+}
+#endif
+
+#if TEST
+// Largest difference between two poses, over the components of one path.
+static float test_animation_pose_diff(const Animation_Pose *a, const Animation_Pose *b, u32 path) {
+    float **pa = animation_pose_get_path((Animation_Pose*)a, path);
+    float **pb = animation_pose_get_path((Animation_Pose*)b, path);
+
+    float ret = 0;
+    float d;
+    for(u32 c = 0; c < animation_path_get_component_count(path); ++c)
+        for(u32 i = 0; i < a->node_count; ++i) {
+            d   = fabsf(pa[c][i] - pb[c][i]);
+            ret = d > ret ? d : ret;
+        }
+    return ret;
+}
+
+static void test_animation_zero_poses(u32 count, Animation_Pose *poses) {
+    for(u32 i = 0; i < count; ++i)
+        memset(poses[i].translation[0], 0, animation_pose_get_size(poses[i].node_count));
+}
+
+//
+// A clip built by hand, one track per entry of 'interps' on node i, all translations except for 'rotation_count'
+// rotations at the end. Track i has i % 5 + 1 keys from time i * 0.1, every 0.5 if i is even, unevenly spaced if it
+// is odd, with values from 'seed'.
+//
+static Animation_Clip test_animation_clip(u32 track_count, u32 rotation_count, const Animation_Interp *interps,
+                                          u32 seed)
+{
+    Animation_Clip clip = {};
+    clip.node_count  = track_count;
+    clip.track_count = track_count;
+    clip.tracks      = (Animation_Track*)malloc_t(sizeof(Animation_Track) * track_count, 8);
+    clip.times       = (float*)malloc_t(sizeof(float) * track_count * 5, 4);
+    for(u32 c = 0; c < 4; ++c)
+        clip.values[c] = (float*)malloc_t(sizeof(float) * track_count * 15, 4);
+
+    // Tracks go into their groups in order, as animation_clip_from_gltf(..) does.
+    u32 group_counts[ANIMATION_GROUP_COUNT] = {};
+    u32 groups[64];
+    assert(track_count <= 64);
+    for(u32 i = 0; i < track_count; ++i) {
+        Animation_Path path = i >= track_count - rotation_count ? ANIMATION_PATH_ROTATION : ANIMATION_PATH_TRANSLATION;
+        groups[i] = animation_get_group(path, interps[i]);
+        group_counts[groups[i]]++;
+    }
+    u32 offset = 0;
+    for(u32 g = 0; g < ANIMATION_GROUP_COUNT; ++g) {
+        clip.group_offsets[g]  = offset;
+        offset                += group_counts[g];
+    }
+    clip.group_offsets[ANIMATION_GROUP_COUNT] = offset;
+
+    u32 cursors[ANIMATION_GROUP_COUNT];
+    memcpy(cursors, clip.group_offsets, sizeof(cursors));
+
+    u32 rng = seed;
+    float len;
+    Animation_Track *track;
+    for(u32 i = 0; i < track_count; ++i) {
+        track = &clip.tracks[cursors[groups[i]]++];
+        track->node         = i;
+        track->key_count    = i % 5 + 1;
+        track->time_offset  = clip.time_count;
+        track->value_offset = clip.value_count;
+
+        for(u32 k = 0; k < track->key_count; ++k)
+            clip.times[clip.time_count + k] = i * 0.1f + k * 0.5f + (k & 1) * 0.3f * (i & 1);
+        clip.time_count += track->key_count;
+
+        u32 value_count = track->key_count * (interps[i] == ANIMATION_INTERP_CUBICSPLINE ? 3 : 1);
+        for(u32 v = 0; v < value_count; ++v) {
+            len = 0;
+            for(u32 c = 0; c < 4; ++c) {
+                rng = rng * 1664525 + 1013904223;
+                clip.values[c][clip.value_count + v] = (float)(rng >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+                len += clip.values[c][clip.value_count + v] * clip.values[c][clip.value_count + v];
+            }
+            if (i >= track_count - rotation_count) {
+                len = sqrtf(len);
+                for(u32 c = 0; c < 4; ++c)
+                    clip.values[c][clip.value_count + v] /= len;
+            }
+        }
+        clip.value_count += value_count;
+
+        float last = clip.times[track->time_offset + track->key_count - 1];
+        clip.duration = last > clip.duration ? last : clip.duration;
+    }
+    return clip;
+}
+
+void test_animation() {
+    u64 mark = get_mark_temp();
+
+    BEGIN_TEST_MODULE("Animation_Hand_Checked", false, false);
+    {
+        // One translation of each interpolation, and one linear rotation, on nodes 0..3.
+        Animation_Interp interps[4] = {ANIMATION_INTERP_STEP, ANIMATION_INTERP_LINEAR, ANIMATION_INTERP_CUBICSPLINE,
+                                       ANIMATION_INTERP_LINEAR};
+        Animation_Clip clip = test_animation_clip(4, 1, interps, 1);
+
+        // Overwrite the generated keys with ones that are easy to check: two keys at 0 and 2.
+        for(u32 i = 0; i < 4; ++i) {
+            Animation_Track *track = &clip.tracks[i];
+            track->key_count    = 2;
+            track->time_offset  = i * 2;
+            track->value_offset = i * 6;
+            clip.times[track->time_offset + 0] = 0.0f;
+            clip.times[track->time_offset + 1] = 2.0f;
+
+            u32 group = 0;
+            while(clip.group_offsets[group + 1] <= i)
+                group++;
+
+            float *x = clip.values[0] + track->value_offset;
+            if (group % ANIMATION_INTERP_COUNT == ANIMATION_INTERP_CUBICSPLINE) {
+                // in, value, out per key: from 0 to 10 with zero tangents is 10 * smoothstep
+                x[0] = 0; x[1] = 0;  x[2] = 0;
+                x[3] = 0; x[4] = 10; x[5] = 0;
+            } else if (group / ANIMATION_INTERP_COUNT == ANIMATION_PATH_ROTATION) {
+                // Identity to 90 degrees about z
+                float h = sqrtf(0.5f);
+                clip.values[0][track->value_offset] = 0; clip.values[0][track->value_offset + 1] = 0;
+                clip.values[1][track->value_offset] = 0; clip.values[1][track->value_offset + 1] = 0;
+                clip.values[2][track->value_offset] = 0; clip.values[2][track->value_offset + 1] = h;
+                clip.values[3][track->value_offset] = 1; clip.values[3][track->value_offset + 1] = h;
+            } else {
+                x[0] = 0;
+                x[1] = 10;
+            }
+        }
+
+        Animation_Pose *poses  = animation_alloc_poses_temp(4, 4);
+        Animation_Pose *scalar = animation_alloc_poses_temp(4, 4);
+        float times[4] = {0.5f, 1.0f, -1.0f, 3.0f};
+        test_animation_zero_poses(4, poses);
+        test_animation_zero_poses(4, scalar);
+        animation_sample(&clip, 4, times, poses);
+        animation_sample_scalar(&clip, 4, times, scalar);
+
+        // Nodes: 0 step, 1 linear, 2 cubic, 3 rotation
+        TEST_FEQ("step_between_keys",    poses[0].translation[0][0], 0.0f,  false);
+        TEST_FEQ("step_after_last_key",  poses[3].translation[0][0], 10.0f, false);
+        TEST_FEQ("linear_quarter",       poses[0].translation[0][1], 2.5f,  false);
+        TEST_FEQ("linear_half",          poses[1].translation[0][1], 5.0f,  false);
+        TEST_FEQ("linear_before_first",  poses[2].translation[0][1], 0.0f,  false);
+        TEST_FEQ("linear_after_last",    poses[3].translation[0][1], 10.0f, false);
+        TEST_FEQ("cubic_quarter",        poses[0].translation[0][2], 1.5625f, false); // 10 * (3/16 - 2/64)
+        TEST_FEQ("cubic_half",           poses[1].translation[0][2], 5.0f,  false);
+
+        // Half way from identity to 90 degrees about z is 45 degrees
+        float z45 = sinf(3.14159265f / 8);
+        float w45 = cosf(3.14159265f / 8);
+        TEST_EQ("slerp_half_z", fabsf(scalar[1].rotation[2][3] - z45) < 1e-6f, true, false);
+        TEST_EQ("slerp_half_w", fabsf(scalar[1].rotation[3][3] - w45) < 1e-6f, true, false);
+        TEST_EQ("nlerp_half_z", fabsf(poses[1].rotation[2][3]  - z45) < 1e-3f, true, false);
+        TEST_EQ("nlerp_half_w", fabsf(poses[1].rotation[3][3]  - w45) < 1e-3f, true, false);
+
+        // A quarter of the way, where uncorrected nlerp is furthest from slerp
+        float z22 = sinf(3.14159265f / 16);
+        TEST_EQ("nlerp_quarter_z", fabsf(poses[0].rotation[2][3] - z22) < 1e-3f, true, false);
+
+        // The same rotation with the second key negated takes the short way round, so gives the same result
+        for(u32 c = 0; c < 4; ++c)
+            clip.values[c][clip.tracks[3].value_offset + 1] *= -1;
+        animation_sample(&clip, 4, times, poses);
+        TEST_EQ("nlerp_shortest_path", fabsf(poses[1].rotation[2][3] - z45) < 1e-3f, true, false);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Animation_Simd_Matches_Scalar", false, false);
+    {
+        // 37 tracks (so batches straddle instances and the tail is partial), every interpolation, 9 rotations.
+        const u32 track_count = 37;
+        Animation_Interp interps[track_count];
+        for(u32 i = 0; i < track_count; ++i)
+            interps[i] = (Animation_Interp)(i % 3);
+        Animation_Clip clip = test_animation_clip(track_count, 9, interps, 7);
+
+        const u32 instance_count = 13;
+        float times[instance_count];
+        for(u32 i = 0; i < instance_count; ++i)
+            times[i] = -0.5f + i * (clip.duration + 1.0f) / instance_count;
+
+        Animation_Pose *poses  = animation_alloc_poses_temp(instance_count, track_count);
+        Animation_Pose *scalar = animation_alloc_poses_temp(instance_count, track_count);
+        test_animation_zero_poses(instance_count, poses);
+        test_animation_zero_poses(instance_count, scalar);
+        animation_sample(&clip, instance_count, times, poses);
+        animation_sample_scalar(&clip, instance_count, times, scalar);
+
+        float diff_translation = 0;
+        float diff_rotation    = 0;
+        float d;
+        for(u32 i = 0; i < instance_count; ++i) {
+            d = test_animation_pose_diff(&poses[i], &scalar[i], ANIMATION_PATH_TRANSLATION);
+            diff_translation = d > diff_translation ? d : diff_translation;
+            d = test_animation_pose_diff(&poses[i], &scalar[i], ANIMATION_PATH_ROTATION);
+            diff_rotation = d > diff_rotation ? d : diff_rotation;
+        }
+        TEST_EQ("translation", diff_translation < 1e-5f, true, false);
+        TEST_EQ("rotation",    diff_rotation    < 2e-3f, true, false);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Animation_Cesium_Man", false, false);
+    {
+        u8 *buffer;
+        Gltf gltf = animation_load_cesium_man(&buffer);
+
+        Animation_Clip clip;
+        bool ok = animation_clip_from_gltf(&gltf, 0, &buffer, &clip);
+        TEST_EQ("clip_from_gltf", ok, true, false);
+
+        // 19 joints, each with a translation, rotation and scale channel of 48 linear keys, one input per sampler
+        TEST_EQ("node_count",  clip.node_count,  22, false);
+        TEST_EQ("track_count", clip.track_count, 57, false);
+        TEST_EQ("time_count",  clip.time_count,  19 * 48, false);
+        TEST_EQ("value_count", clip.value_count, 57 * 48, false);
+        TEST_EQ("linear_translations", clip.group_offsets[1] - clip.group_offsets[0], 19, false);
+        TEST_EQ("linear_rotations",
+                clip.group_offsets[animation_get_group(ANIMATION_PATH_ROTATION, ANIMATION_INTERP_LINEAR) + 1] -
+                clip.group_offsets[animation_get_group(ANIMATION_PATH_ROTATION, ANIMATION_INTERP_LINEAR)], 19, false);
+        TEST_FEQ("duration", clip.duration, 2.0f, false);
+
+        // Rest pose: node 3 is TRS, node 0 is a matrix (a 90 degree rotation about x)
+        Animation_Pose *rest = animation_alloc_poses_temp(1, clip.node_count);
+        animation_pose_set_rest(rest, &gltf);
+
+        Gltf_Node *node3 = gltf_node_by_index(&gltf, 3);
+        TEST_FEQ("rest_translation", rest->translation[1][3], node3->trs.translation.y, false);
+        TEST_FEQ("rest_rotation",    rest->rotation[3][3],    node3->trs.rotation.w,    false);
+        TEST_FEQ("rest_scale",       rest->scale[0][3],       node3->trs.scale.x,       false);
+        TEST_FEQ("rest_identity",    rest->rotation[3][2],    1.0f,                     false); // Node 2 has no transform
+
+        float len = 0;
+        for(u32 c = 0; c < 4; ++c)
+            len += rest->rotation[c][0] * rest->rotation[c][0];
+        TEST_EQ("rest_matrix_unit_rotation", fabsf(len - 1.0f) < 1e-5f, true, false);
+        TEST_EQ("rest_matrix_rotation_x",    fabsf(fabsf(rest->rotation[0][0]) - sqrtf(0.5f)) < 1e-5f, true, false);
+        TEST_EQ("rest_matrix_rotation_w",    fabsf(fabsf(rest->rotation[3][0]) - sqrtf(0.5f)) < 1e-5f, true, false);
+        TEST_FEQ("rest_matrix_scale",        rest->scale[1][0], 1.0f, false);
+
+        // At a key time, sampling gives the key.
+        const Animation_Track *track = &clip.tracks[0];
+        float key_time = clip.times[track->time_offset + 10];
+        Animation_Pose *poses  = animation_alloc_poses_temp(64, clip.node_count);
+        Animation_Pose *scalar = animation_alloc_poses_temp(64, clip.node_count);
+        animation_pose_copy(&poses[0], rest);
+        animation_sample(&clip, 1, &key_time, poses);
+        TEST_FEQ("key_time", poses[0].translation[0][track->node], clip.values[0][track->value_offset + 10], false);
+
+        // Untouched nodes keep the rest pose
+        TEST_FEQ("unanimated_node", poses[0].translation[0][0], rest->translation[0][0], false);
+
+        // Many instances across (and beyond) the clip against the scalar reference
+        float times[64];
+        for(u32 i = 0; i < 64; ++i) {
+            times[i] = -0.25f + i * (clip.duration + 0.5f) / 64;
+            animation_pose_copy(&poses[i],  rest);
+            animation_pose_copy(&scalar[i], rest);
+        }
+        animation_sample(&clip, 64, times, poses);
+        animation_sample_scalar(&clip, 64, times, scalar);
+
+        float diff[ANIMATION_PATH_COUNT] = {};
+        float d;
+        float max_len_error = 0;
+        for(u32 i = 0; i < 64; ++i) {
+            for(u32 p = 0; p < ANIMATION_PATH_COUNT; ++p) {
+                d = test_animation_pose_diff(&poses[i], &scalar[i], p);
+                diff[p] = d > diff[p] ? d : diff[p];
+            }
+            for(u32 n = 0; n < clip.node_count; ++n) {
+                len = 0;
+                for(u32 c = 0; c < 4; ++c)
+                    len += poses[i].rotation[c][n] * poses[i].rotation[c][n];
+                d = fabsf(sqrtf(len) - 1.0f);
+                max_len_error = d > max_len_error ? d : max_len_error;
+            }
+        }
+        TEST_EQ("translation", diff[ANIMATION_PATH_TRANSLATION] < 1e-5f, true, false);
+        TEST_EQ("rotation",    diff[ANIMATION_PATH_ROTATION]    < 1e-3f, true, false);
+        TEST_EQ("scale",       diff[ANIMATION_PATH_SCALE]       < 1e-5f, true, false);
+        TEST_EQ("unit_rotations", max_len_error < 1e-5f, true, false);
+
+        animation_clip_free(&clip);
+
+        // On a lazy gltf the clip parses the animations, accessors and nodes, which must outlive it.
+        Gltf lazy = parse_gltf_lazy("models/cesium-man/CesiumMan.gltf");
+        ok = animation_clip_from_gltf(&lazy, 0, &buffer, &clip);
+        TEST_EQ("lazy_clip_from_gltf", ok, true, false);
+        TEST_EQ("lazy_value_count", clip.value_count, 57 * 48, false);
+        memset(malloc_t(64 * 1024, 16), 0xcd, 64 * 1024);
+        TEST_EQ("lazy_animations", gltf_animation_by_index(&lazy, 0)->channel_count,
+                gltf_animation_by_index(&gltf, 0)->channel_count, false);
+        TEST_EQ("lazy_accessors",  gltf_accessor_by_index(&lazy, 0)->count, gltf_accessor_by_index(&gltf, 0)->count,
+                false);
+        TEST_EQ("lazy_nodes",      gltf_node_by_index(&lazy, 0)->child_count,
+                gltf_node_by_index(&gltf, 0)->child_count, false);
+        animation_clip_free(&clip);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Animation_Compression", false, false);
+    {
+        // Smallest three, for random rotations and ones which are all one component (either sign)
+        u32   rng       = 5;
+        float max_angle = 0;
+        float q[4];
+        float d[4];
+        u16   packed[3];
+        for(u32 i = 0; i < 1024 + 8; ++i) {
+            float len = 0;
+            for(u32 c = 0; c < 4; ++c) {
+                rng  = rng * 1664525 + 1013904223;
+                q[c] = i < 1024 ? (float)(rng >> 8) / (float)(1 << 24) * 2.0f - 1.0f :
+                                  (c == (i & 3) ? (i & 4 ? -1.0f : 1.0f) : 0.0f);
+                len += q[c] * q[c];
+            }
+            for(u32 c = 0; c < 4; ++c)
+                q[c] /= sqrtf(len);
+
+            animation_encode_quat(q, packed);
+            animation_decode_quat(packed, d);
+            float angle = animation_get_error(ANIMATION_PATH_ROTATION, q, d);
+            max_angle = angle > max_angle ? angle : max_angle;
+        }
+        TEST_EQ("smallest_three", max_angle < 1.5e-4f, true, false); // About twice the 15 bit step
+
+        // Ten linear translations, but: 3 is constant, 4 is a straight line, and 9 is a step track which repeats its
+        // keys. Tracks 4 and 9 have five keys, 3 and 8 have four.
+        const u32 track_count = 10;
+        Animation_Interp interps[track_count];
+        for(u32 i = 0; i < track_count; ++i)
+            interps[i] = i == 9 ? ANIMATION_INTERP_STEP : ANIMATION_INTERP_LINEAR;
+        Animation_Clip clip = test_animation_clip(track_count, 0, interps, 3);
+
+        const Animation_Track *tracks[track_count];
+        for(u32 i = 0; i < track_count; ++i)
+            tracks[clip.tracks[i].node] = &clip.tracks[i];
+        for(u32 k = 0; k < 5; ++k) {
+            float t = clip.times[tracks[4]->time_offset + k];
+            for(u32 c = 0; c < 3; ++c) {
+                if (k < 4)
+                    clip.values[c][tracks[3]->value_offset + k] = 0.25f * c;
+                clip.values[c][tracks[4]->value_offset + k] = 1.0f + (c + 1) * t;
+                clip.values[c][tracks[9]->value_offset + k] = k < 2 ? 0.5f : -0.5f;
+            }
+        }
+
+        Animation_Compression_Settings settings = {1e-4f, 1e-4f, 1e-4f};
+        Animation_Compressed_Clip compressed;
+        animation_clip_compress(&clip, &settings, &compressed);
+
+        u32 key_counts[track_count];
+        for(u32 i = 0; i < track_count; ++i)
+            key_counts[compressed.tracks[i].node] = compressed.tracks[i].key_count;
+        TEST_EQ("constant", key_counts[3], 1, false);
+        TEST_EQ("line",     key_counts[4], 2, false);
+        TEST_EQ("random",   key_counts[8], 4, false);
+        TEST_EQ("step",     key_counts[9], 2, false);
+
+        Animation_Pose *rest = animation_alloc_poses_temp(1, track_count);
+        test_animation_zero_poses(1, rest);
+
+        float error[ANIMATION_PATH_COUNT];
+        animation_get_compression_error(&clip, &compressed, rest, 64, error);
+        TEST_EQ("reduced_error", error[ANIMATION_PATH_TRANSLATION] < 2e-4f, true, false);
+        animation_compressed_clip_free(&compressed);
+
+        // Every interpolation and path, compressed with no room for reduction: only quantization (and corrected nlerp
+        // against slerp for the random, far apart, rotations) is left.
+        const u32 mixed_count = 37;
+        Animation_Interp mixed_interps[mixed_count];
+        for(u32 i = 0; i < mixed_count; ++i)
+            mixed_interps[i] = (Animation_Interp)(i % 3);
+        Animation_Clip mixed = test_animation_clip(mixed_count, 9, mixed_interps, 7);
+
+        settings = {0, 0, 0};
+        animation_clip_compress(&mixed, &settings, &compressed);
+        TEST_EQ("all_keys_kept", compressed.time_count, mixed.time_count, false);
+
+        rest = animation_alloc_poses_temp(1, mixed_count);
+        test_animation_zero_poses(1, rest);
+        animation_get_compression_error(&mixed, &compressed, rest, 64, error);
+        // These tracks move up to ~10 units a second, so rounding key times to ticks is most of the translation error
+        TEST_EQ("quantized_translation", error[ANIMATION_PATH_TRANSLATION] < 1e-3f, true, false);
+        TEST_EQ("quantized_rotation",    error[ANIMATION_PATH_ROTATION]    < 5e-3f, true, false);
+        animation_compressed_clip_free(&compressed);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Animation_Cesium_Man_Compression", false, false);
+    {
+        u8 *buffer;
+        Gltf gltf = animation_load_cesium_man(&buffer);
+
+        Animation_Clip clip;
+        bool ok = animation_clip_from_gltf(&gltf, 0, &buffer, &clip);
+        TEST_EQ("clip_from_gltf", ok, true, false);
+
+        Animation_Pose *rest = animation_alloc_poses_temp(1, clip.node_count);
+        animation_pose_set_rest(rest, &gltf);
+
+        // A tenth of a millimetre, a thousandth of a radian
+        Animation_Compression_Settings settings = {1e-4f, 1e-3f, 1e-4f};
+        Animation_Compressed_Clip compressed;
+        animation_clip_compress(&clip, &settings, &compressed);
+
+        float error[ANIMATION_PATH_COUNT];
+        animation_get_compression_error(&clip, &compressed, rest, 256, error);
+        TEST_EQ("translation_error", error[ANIMATION_PATH_TRANSLATION] < settings.translation_error * 1.1f, true, false);
+        TEST_EQ("rotation_error",    error[ANIMATION_PATH_ROTATION]    < settings.rotation_error    * 1.1f, true, false);
+        TEST_EQ("scale_error",       error[ANIMATION_PATH_SCALE]       < settings.scale_error       * 1.1f, true, false);
+        TEST_EQ("compressed", animation_compressed_clip_get_size(&compressed) * 4 < animation_clip_get_key_size(&clip), true, false);
+
+        animation_compressed_clip_free(&compressed);
+        animation_clip_free(&clip);
+    }
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif // TEST
+
+#if BENCH
+//
+// CesiumMan's clip sampled for a crowd of instances, each at its own time, simd against the scalar reference.
+// Reported per track sample (one track for one instance).
+//
+void bench_animation() {
+    BENCH_MODULE("Animation");
+
+    u64 mark = get_mark_temp();
+
+    u8 *buffer;
+    Gltf gltf = animation_load_cesium_man(&buffer);
+
+    Animation_Clip clip;
+    if (!animation_clip_from_gltf(&gltf, 0, &buffer, &clip)) {
+        println("    Failed to load CesiumMan's animation, skipping");
+        reset_to_mark_temp(mark);
+        return;
+    }
+
+    const u32 instance_counts[] = {1, 64, 1024};
+    for(u32 i = 0; i < sizeof(instance_counts) / sizeof(instance_counts[0]); ++i) {
+        u32 instance_count = instance_counts[i];
+        u64 inner_mark     = get_mark_temp();
+
+        Animation_Pose *poses = animation_alloc_poses_temp(instance_count, clip.node_count);
+        float *times = (float*)malloc_t(sizeof(float) * instance_count, 4);
+        for(u32 j = 0; j < instance_count; ++j)
+            times[j] = clip.duration * (float)j / (float)instance_count;
+
+        u64 iterations = 65536 / instance_count + 16;
+        u64 samples    = (u64)clip.track_count * instance_count * iterations;
+
+        Bench_Timer timer = begin_bench();
+        for(u64 j = 0; j < iterations; ++j) {
+            animation_sample(&clip, instance_count, times, poses);
+            bench_keep(poses[0].rotation[0][3]);
+        }
+        u64 ns_simd = end_bench(&timer);
+
+        timer = begin_bench();
+        for(u64 j = 0; j < iterations; ++j) {
+            animation_sample_scalar(&clip, instance_count, times, poses);
+            bench_keep(poses[0].rotation[0][3]);
+        }
+        u64 ns_scalar = end_bench(&timer);
+
+        println("    %u instances (%u tracks each): simd %f ns/sample, scalar %f ns/sample, speedup %f",
+                (u64)instance_count, (u64)clip.track_count, (double)ns_simd / samples, (double)ns_scalar / samples,
+                (double)ns_scalar / (double)ns_simd);
+
+        reset_to_mark_temp(inner_mark);
+    }
+
+    // Compression: size against the largest error (sampled densely against the scalar reference), from tolerances
+    // at which nothing is dropped to ones at which the walk visibly changes. Then decoding for a crowd.
+    Animation_Pose *rest = animation_alloc_poses_temp(1, clip.node_count);
+    animation_pose_set_rest(rest, &gltf);
+
+    u64 key_size  = animation_clip_get_key_size(&clip);
+    u64 key_count = 0;
+    for(u32 i = 0; i < clip.track_count; ++i)
+        key_count += clip.tracks[i].key_count;
+    println("    compression, %u bytes of float32 keys (%u track keys):", key_size, key_count);
+
+    const float tolerances[] = {0, 1e-5f, 1e-4f, 1e-3f, 1e-2f};
+    Animation_Compressed_Clip compressed;
+    for(u32 i = 0; i < sizeof(tolerances) / sizeof(tolerances[0]); ++i) {
+        Animation_Compression_Settings settings = {tolerances[i], tolerances[i], tolerances[i]};
+        animation_clip_compress(&clip, &settings, &compressed);
+
+        float error[ANIMATION_PATH_COUNT];
+        animation_get_compression_error(&clip, &compressed, rest, 4096, error);
+
+        u64 size = animation_compressed_clip_get_size(&compressed);
+        println("        tolerance %f: %u track keys, %u bytes, ratio %f, max error translation %f, rotation %f rad, scale %f",
+                (double)tolerances[i], (u64)compressed.time_count, size, (double)key_size / size,
+                (double)error[ANIMATION_PATH_TRANSLATION], (double)error[ANIMATION_PATH_ROTATION],
+                (double)error[ANIMATION_PATH_SCALE]);
+
+        animation_compressed_clip_free(&compressed);
+    }
+
+    Animation_Compression_Settings settings = {1e-4f, 1e-3f, 1e-4f};
+    animation_clip_compress(&clip, &settings, &compressed);
+    {
+        u32 instance_count = 1024;
+        u64 inner_mark     = get_mark_temp();
+
+        Animation_Pose *poses = animation_alloc_poses_temp(instance_count, clip.node_count);
+        float *times = (float*)malloc_t(sizeof(float) * instance_count, 4);
+        for(u32 j = 0; j < instance_count; ++j)
+            times[j] = clip.duration * (float)j / (float)instance_count;
+
+        u64 iterations = 80;
+        u64 samples    = (u64)clip.track_count * instance_count * iterations;
+
+        Bench_Timer timer = begin_bench();
+        for(u64 j = 0; j < iterations; ++j) {
+            animation_sample_compressed(&compressed, instance_count, times, poses);
+            bench_keep(poses[0].rotation[0][3]);
+        }
+        u64 ns = end_bench(&timer);
+
+        println("    compressed, %u instances: %f ns/sample", (u64)instance_count, (double)ns / samples);
+        reset_to_mark_temp(inner_mark);
+    }
+    animation_compressed_clip_free(&compressed);
+
+    animation_clip_free(&clip);
+    reset_to_mark_temp(mark);
+}
+#endif // BENCH
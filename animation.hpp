@@ -0,0 +1,163 @@
+#ifndef SOL_ANIMATION_HPP_INCLUDE_GUARD_
+#define SOL_ANIMATION_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "gltf.hpp"
+
+/*
+    Animation: gltf animations converted to keyframe tracks, and sampled into local TRS poses.
+
+    A clip is one gltf animation. Each channel becomes a track (weights channels are skipped, morph targets are not
+    animated yet), and every track's keys live in shared pools: one array of key times (tracks which share an input
+    accessor share times), and one array per component of key values (x, y, z, w). Tracks are sorted into groups by
+    path and interpolation, so that any eight tracks of a group sample the same way.
+
+    animation_sample(..) evaluates every track of a clip for many instances (each at its own time) at once: it walks
+    the (instance, track) pairs of each group eight at a time, and finds the keys, gathers and interpolates the
+    components with avx2 before writing the results into the instances' poses. Linear rotations are
+    nlerp with a correction to the interpolant which brings it within ~1e-3 of slerp (see animation.cpp), cubic
+    rotations are normalized after the spline. animation_sample_scalar(..) is the reference, with exact slerp.
+
+    A pose is the local translation, rotation (x, y, z, w) and scale of every node of the gltf, SoA. Sampling only
+    writes the nodes which the clip animates, so start from animation_pose_set_rest(..).
+
+    Times are clamped to each track's first and last key, as per the spec. Looping is the caller's (fmod the time
+    by Animation_Clip::duration).
+
+    Compression (at cook time, see animation_clip_compress(..)): every track's keys are quantized, then thinned to
+    the fewest which keep the track within an error bound at every original key time (step tracks drop keys which
+    repeat the held value, linear tracks drop keys which interpolation between their neighbours reproduces; cubic
+    tracks keep every key). Linear and step rotations are smallest-three in 48 bits: the index of the largest
+    component, and the other three in 15 bits each. Translations, scales and cubic rotations (whose tangents are not
+    unit quaternions) are 16 bits per component in the range of the track. Key times are 16 bit ticks of the clip's
+    duration. animation_sample_compressed(..) decodes and interpolates as the sampler does (rotations are corrected
+    nlerp), and the error bound is checked against that decoder.
+*/
+
+enum Animation_Path : u32 {
+    ANIMATION_PATH_TRANSLATION = 0,
+    ANIMATION_PATH_ROTATION    = 1,
+    ANIMATION_PATH_SCALE       = 2,
+    ANIMATION_PATH_COUNT       = 3,
+};
+
+// Same values as Gltf_Animation_Interp.
+enum Animation_Interp : u32 {
+    ANIMATION_INTERP_LINEAR      = 0,
+    ANIMATION_INTERP_STEP        = 1,
+    ANIMATION_INTERP_CUBICSPLINE = 2,
+    ANIMATION_INTERP_COUNT       = 3,
+};
+
+static constexpr u32 ANIMATION_GROUP_COUNT = (u32)ANIMATION_PATH_COUNT * (u32)ANIMATION_INTERP_COUNT;
+
+inline static u32 animation_get_group(Animation_Path path, Animation_Interp interp) {
+    return (u32)path * (u32)ANIMATION_INTERP_COUNT + (u32)interp;
+}
+
+struct Animation_Track {
+    u32 node;
+    u32 key_count;
+    u32 time_offset;  // Into Animation_Clip::times
+    u32 value_offset; // Into each of Animation_Clip::values. Cubic splines have three values per key: in tangent, value, out tangent
+};
+
+struct Animation_Clip {
+    float duration;   // The last key time of any track
+    u32   node_count; // Nodes in the gltf, so the size of the poses which the clip samples into
+    u32   track_count;
+    u32   time_count;
+    u32   value_count;
+
+    // Group g (see animation_get_group(..)) is tracks [group_offsets[g], group_offsets[g + 1]).
+    u32 group_offsets[ANIMATION_GROUP_COUNT + 1];
+
+    Animation_Track *tracks;
+    float           *times;
+    float           *values[4]; // x, y, z, w (w is unused by translation and scale)
+};
+
+struct Animation_Pose {
+    u32    node_count;
+    float *translation[3];
+    float *rotation[4];
+    float *scale[3];
+};
+
+// Build a clip from animation 'animation' of 'gltf'. 'buffers' is indexed by gltf buffer (see gltf_accessor_read(..)).
+// The clip is one heap allocation, free it with animation_clip_free(..). Returns false if an accessor could not be
+// read.
+bool animation_clip_from_gltf(Gltf *gltf, u32 animation, const u8 *const *buffers, Animation_Clip *clip);
+void animation_clip_free(Animation_Clip *clip);
+
+// Bytes for a pose of 'node_count' nodes, and a pose in 'memory' (at least that many bytes).
+u64  animation_pose_get_size(u32 node_count);
+void animation_pose_init(Animation_Pose *pose, u32 node_count, void *memory);
+
+// Set every node to its TRS in the gltf (nodes with a matrix are decomposed).
+void animation_pose_set_rest(Animation_Pose *pose, Gltf *gltf);
+void animation_pose_copy(Animation_Pose *dst, const Animation_Pose *src);
+
+// Sample 'clip' at times[i] into poses[i], for 'instance_count' instances.
+void animation_sample(const Animation_Clip *clip, u32 instance_count, const float *times, Animation_Pose *poses);
+void animation_sample_scalar(const Animation_Clip *clip, u32 instance_count, const float *times, Animation_Pose *poses);
+
+struct Animation_Compression_Settings {
+    float translation_error; // Distance, in the units of the gltf
+    float rotation_error;    // Angle, in radians
+    float scale_error;       // Per component
+};
+
+struct Animation_Compressed_Track {
+    u32 node;
+    u32 key_count;
+    u32 time_offset;  // Into Animation_Compressed_Clip::times
+    u32 value_offset; // Into Animation_Compressed_Clip::values, see animation_compressed_get_value_size(..)
+    u32 range_offset; // Into Animation_Compressed_Clip::ranges: min then extent per component (not for smallest-three)
+};
+
+struct Animation_Compressed_Clip {
+    float duration;
+    u32   node_count;
+    u32   track_count;
+    u32   range_count;
+    u32   time_count;
+    u32   value_count; // u16s
+
+    // As Animation_Clip::group_offsets
+    u32 group_offsets[ANIMATION_GROUP_COUNT + 1];
+
+    Animation_Compressed_Track *tracks;
+    float                      *ranges;
+    u16                        *times;  // Ticks of duration / 65535
+    u16                        *values;
+};
+
+// u16s per key value of a track in a compressed clip: smallest-three rotations are three, else one per component.
+// Cubic splines have three values per key.
+inline static u32 animation_compressed_get_value_size(Animation_Path path, Animation_Interp interp) {
+    return path == ANIMATION_PATH_ROTATION && interp == ANIMATION_INTERP_CUBICSPLINE ? 4 : 3;
+}
+
+// Compress 'clip' within the error bounds of 'settings'. The compressed clip is one heap allocation, free it with
+// animation_compressed_clip_free(..).
+void animation_clip_compress(const Animation_Clip *clip, const Animation_Compression_Settings *settings,
+                             Animation_Compressed_Clip *compressed);
+void animation_compressed_clip_free(Animation_Compressed_Clip *clip);
+
+// Bytes of a compressed clip's keys and tracks.
+u64 animation_compressed_clip_get_size(const Animation_Compressed_Clip *clip);
+
+// As animation_sample(..), for a compressed clip.
+void animation_sample_compressed(const Animation_Compressed_Clip *clip, u32 instance_count, const float *times,
+                                 Animation_Pose *poses);
+
+#if TEST
+    void test_animation();
+#endif
+
+#if BENCH
+    void bench_animation();
+#endif
+
+#endif // include guard
@@ -7,12 +7,24 @@
 #include "vulkan/vulkan_core.h"
 #include "vulkan_errors.hpp"
 #include "simd.hpp"
+#include "meshopt.hpp"
+#include "mesh.hpp"
+#include "hash_map.hpp"
+#include "camera.hpp"
+#include "job.hpp"
+
+#include <sys/stat.h>
 
 #if TEST
 #include "test/test.hpp"
 #include "image.hpp"
 #endif
 
+#if BENCH
+#include "test/bench.hpp"
+#include "test/gltf_generator.hpp"
+#endif
+
 static Assets s_Assets;
 Assets* get_assets_instance() { return &s_Assets; }
 
@@ -89,6 +101,19 @@ struct Model_Allocators_Config {
 static Model_Allocators create_model_allocators(const Model_Allocators_Config *config);
 static void             destroy_model_allocators(Model_Allocators *model_allocators);
 
+// What init_assets() builds at import for each model in model.hpp (see Model_Load_Flag_Bits). Interleaving only
+// changes the vertex input: each primitive is one binding at Pl_Primitive_Info::offsets, read by the same shaders.
+// Merging then puts what interleaving left as separate views (sparse or differently counted attributes, morph
+// targets) in one allocation per primitive, which the shaders cannot see at all. Narrowed indices only change the
+// index type of the primitive's draw, and compressed ones are decoded before the index allocator sees them.
+static const Model_Load_Flags g_model_load_flags[] = {
+    MODEL_LOAD_INTERLEAVE_VERTICES_BIT | MODEL_LOAD_MERGE_VIEWS_BIT |
+    MODEL_LOAD_NARROW_INDICES_BIT      | MODEL_LOAD_COMPRESS_INDICES_BIT, // Cube
+    MODEL_LOAD_INTERLEAVE_VERTICES_BIT | MODEL_LOAD_MERGE_VIEWS_BIT |
+    MODEL_LOAD_NARROW_INDICES_BIT      | MODEL_LOAD_COMPRESS_INDICES_BIT, // CesiumMan
+};
+static_assert(sizeof(g_model_load_flags) / sizeof(g_model_load_flags[0]) == g_model_count);
+
 void init_assets() {
     Assets *g_assets = get_assets_instance();
 
@@ -116,13 +141,14 @@ void init_assets() {
 
     u64 tmp_size;
     for(u32 i = 0; i < g_model_count; ++i) {
-        g_assets->models[i] = model_from_gltf(
+        g_assets->models[i] = load_model(
                                    allocs,
                                   &g_model_dir_names[i],
                                   &g_model_file_names[i],
                                    model_buffer_size_available,
                                    g_assets->model_buffer,
-                                  &tmp_size);
+                                  &tmp_size,
+                                   g_model_load_flags[i]);
 
         model_buffer_size_used      += tmp_size;
         model_buffer_size_available -= model_buffer_size_used;
@@ -297,15 +323,49 @@ static void destroy_model_allocators(Model_Allocators *allocs) {
     destroy_image_view_allocator(&allocs->image_view);
 }
 
+// Simplified lods per primitive with MODEL_LOAD_BUILD_LODS_BIT (see model_build_lods(..)).
+static constexpr u32 MODEL_LOD_COUNT = 4; // at most, each one with at most 3/4 of the indices of the one before
+
 struct Model_Req_Size_Info {
     u32 total;
     u32 accessors;
     u32 primitives;
     u32 weights;
+    u32 meshlets; // An upper bound, as what the builder writes depends on the vertex data
+    u32 lods;     // Same
 };
-static Model_Req_Size_Info model_get_required_size_from_gltf(Gltf *gltf) {
-    assert(gltf_buffer_get_count(gltf) == 1 && "Ugh, need to make buffers an array");
 
+// Bytes in the model buffer for a primitive's Meshlets, each array aligned to 16.
+static u64 model_get_meshlets_size(u32 meshlet_count, u32 vertex_count, u32 triangle_count) {
+    u64 size = 0;
+    size += align(sizeof(Meshlets), 16);
+    size += align(sizeof(Meshlet)        * meshlet_count, 16);
+    size += align(sizeof(Meshlet_Bounds) * meshlet_count, 16);
+    size += align(sizeof(u32)            * vertex_count,  16);
+    size += align(3                      * triangle_count, 16);
+    return size;
+}
+
+// Bytes in the model buffer for a primitive's Mesh_Lods, each array aligned to 16.
+static u64 model_get_lods_size(u32 lod_count, u32 index_count) {
+    u64 size = 0;
+    size += align(sizeof(Mesh_Lods), 16);
+    size += align(sizeof(Mesh_Lod) * lod_count,   16);
+    size += align(sizeof(u32)      * index_count, 16);
+    return size;
+}
+
+// Most lod indices that model_build_lods(..) can write for a primitive.
+static u32 model_get_lod_index_bound(u32 index_count) {
+    u32 ret = 0;
+    for(u32 i = 0; i < MODEL_LOD_COUNT; ++i) {
+        index_count = index_count / 4 * 3;
+        ret        += index_count;
+    }
+    return ret;
+}
+
+static Model_Req_Size_Info model_get_required_size_from_gltf(Gltf *gltf, Model_Load_Flags flags) {
     // @Todo Animations, Skins, Cameras
 
     u32 accessor_count    = gltf_accessor_get_count(gltf);
@@ -330,6 +390,10 @@ static Model_Req_Size_Info model_get_required_size_from_gltf(Gltf *gltf) {
     u32 target_count           = 0;
     u32 target_attribute_count = 0;
 
+    u64 req_size_meshlets = 0;
+    u64 req_size_lods     = 0;
+    u32 index_count;
+
     const Gltf_Mesh           *gltf_mesh = gltf->meshes;
     const Gltf_Mesh_Primitive *gltf_primitive;
     const Gltf_Morph_Target   *gltf_morph_target;
@@ -349,6 +413,17 @@ static Model_Req_Size_Info model_get_required_size_from_gltf(Gltf *gltf) {
 
             attribute_count += gltf_primitive->extra_attribute_count;
 
+            // A meshlet never has more vertices than indices, and every triangle is in one meshlet.
+            if (gltf_primitive->topology == GLTF_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST && gltf_primitive->position != -1) {
+                index_count = gltf_accessor_by_index(gltf, gltf_primitive->indices)->count;
+                if (flags & MODEL_LOAD_BUILD_MESHLETS_BIT)
+                    req_size_meshlets += model_get_meshlets_size(
+                                            mesh_get_meshlet_bound(index_count, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES),
+                                            index_count, index_count / 3);
+                if (flags & MODEL_LOAD_BUILD_LODS_BIT)
+                    req_size_lods += model_get_lods_size(MODEL_LOD_COUNT, model_get_lod_index_bound(index_count));
+            }
+
             target_count      += gltf_primitive->target_count;
             gltf_morph_target  = gltf_primitive->targets;
 
@@ -383,18 +458,30 @@ static Model_Req_Size_Info model_get_required_size_from_gltf(Gltf *gltf) {
     req_size_primitives     +=  target_count           * sizeof(Morph_Target);
     req_size_primitives     +=  target_attribute_count * sizeof(Mesh_Primitive_Attribute);
 
+    // Each mesh's primitives start aligned to 16 (Mesh_Primitive's alignment). Everything before them is a
+    // multiple of 8, so the padding is at most 8.
+    req_size_primitives     +=  mesh_count * 8;
+
     u32 req_size  = 0;
     req_size     += req_size_accessors;
     req_size     += req_size_weights;
     req_size     += req_size_primitives;
 
-    req_size += sizeof(Mesh) * mesh_count;
+    req_size += align(sizeof(Mesh) * mesh_count, 16);
+
+    // Meshlets and lods start aligned to 16 after the rest.
+    if (req_size_meshlets)
+        req_size = align(req_size, 16) + req_size_meshlets;
+    if (req_size_lods)
+        req_size = align(req_size, 16) + req_size_lods;
 
     Model_Req_Size_Info ret = {
         .total      = req_size,
         .accessors  = req_size_accessors,
         .primitives = req_size_primitives,
         .weights    = req_size_weights,
+        .meshlets   = (u32)req_size_meshlets,
+        .lods       = (u32)req_size_lods,
     };
 
     return ret;
@@ -583,7 +670,6 @@ static void model_load_gltf_meshes(const Load_Mesh_Info *info, u32 count, const
                                    u8 *primitives_buffer, u8 *weights_buffer)
 {
     u32 tmp;
-    u32 idx;
 
     const Gltf_Mesh           *gltf_mesh = gltf_meshes;
     const Gltf_Mesh_Primitive *gltf_primitive;
@@ -605,6 +691,7 @@ static void model_load_gltf_meshes(const Load_Mesh_Info *info, u32 count, const
         primitive_count           = gltf_mesh->primitive_count;
         meshes[i].primitive_count = primitive_count;
 
+        size_used_primitives  = align(size_used_primitives, 16);
         meshes[i].primitives  = (Mesh_Primitive*)(primitives_buffer + size_used_primitives);
         size_used_primitives  += sizeof(Mesh_Primitive) * primitive_count;
 
@@ -615,6 +702,11 @@ static void model_load_gltf_meshes(const Load_Mesh_Info *info, u32 count, const
             primitive->topology     = (VkPrimitiveTopology)gltf_primitive->topology;
             primitive->indices      = accessors[gltf_primitive->indices];
             primitive->material     = materials[gltf_primitive->material];
+            primitive->meshlets     = NULL;
+            primitive->lods         = NULL;
+
+            primitive->position_dequantize = {.scale = {1, 1, 1}};
+            primitive->position_stream_key = Max_u32;
 
             primitive->attribute_count  = gltf_primitive->extra_attribute_count;
             primitive->attribute_count += (u32)(gltf_primitive->position    != -1);
@@ -626,36 +718,31 @@ static void model_load_gltf_meshes(const Load_Mesh_Info *info, u32 count, const
             size_used_primitives   += sizeof(Mesh_Primitive_Attribute) * primitive->attribute_count;
 
             // When I set up this api in the gltf file, I had no idea how annoying it would be later...
-            // If an attribute is not set, rather than branch, we just overwrite it by not incrementing the index.
+            // @Note Only write the attributes which are set: an unset one written at 'tmp' (to be overwritten by the
+            // next) lands one past the primitive's attributes if it comes last, which for the last primitive is the
+            // start of the accessor data.
             tmp = 0;
 
-            idx = gltf_primitive->normal & max32_if_true(gltf_primitive->normal != -1);
-            primitive->attributes[tmp] = {
-                .accessor = accessors[idx],
-                .type     = MESH_PRIMITIVE_ATTRIBUTE_TYPE_NORMAL,
-            };
-            tmp += (u32)(gltf_primitive->normal != -1);
-
-            idx = gltf_primitive->position & max32_if_true(gltf_primitive->position != -1);
-            primitive->attributes[tmp] = {
-                .accessor = accessors[idx],
-                .type     = MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION,
-            };
-            tmp += (u32)(gltf_primitive->position != -1);
-
-            idx = gltf_primitive->tangent & max32_if_true(gltf_primitive->tangent != -1);
-            primitive->attributes[tmp] = {
-                .accessor = accessors[idx],
-                .type     = MESH_PRIMITIVE_ATTRIBUTE_TYPE_TANGENT,
-            };
-            tmp += (u32)(gltf_primitive->tangent != -1);
-
-            idx = gltf_primitive->tex_coord_0 & max32_if_true(gltf_primitive->tex_coord_0 != -1);
-            primitive->attributes[tmp] = {
-                .accessor = accessors[idx],
-                .type     = MESH_PRIMITIVE_ATTRIBUTE_TYPE_TEX_COORDS,
-            };
-            tmp += (u32)(gltf_primitive->tex_coord_0 != -1);
+            if (gltf_primitive->normal != -1)
+                primitive->attributes[tmp++] = {
+                    .accessor = accessors[gltf_primitive->normal],
+                    .type     = MESH_PRIMITIVE_ATTRIBUTE_TYPE_NORMAL,
+                };
+            if (gltf_primitive->position != -1)
+                primitive->attributes[tmp++] = {
+                    .accessor = accessors[gltf_primitive->position],
+                    .type     = MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION,
+                };
+            if (gltf_primitive->tangent != -1)
+                primitive->attributes[tmp++] = {
+                    .accessor = accessors[gltf_primitive->tangent],
+                    .type     = MESH_PRIMITIVE_ATTRIBUTE_TYPE_TANGENT,
+                };
+            if (gltf_primitive->tex_coord_0 != -1)
+                primitive->attributes[tmp++] = {
+                    .accessor = accessors[gltf_primitive->tex_coord_0],
+                    .type     = MESH_PRIMITIVE_ATTRIBUTE_TYPE_TEX_COORDS,
+                };
 
             for(u32 k = 0; k < gltf_primitive->extra_attribute_count; ++k) {
                 attribute = &primitive->attributes[tmp + k];
@@ -701,6 +788,108 @@ static void model_load_gltf_meshes(const Load_Mesh_Info *info, u32 count, const
     }
 }
 
+//
+// Converting a parsed gltf into a model's meshes is four jobs: accessors and textures are independent, materials
+// wait on textures, and meshes wait on accessors and materials. Nothing is allocated inside the jobs (each one
+// only writes its own array, or its own range of the model buffer), so the conversions of several models run as
+// one job list.
+//
+struct Model_Gltf_Conversion {
+    const Gltf *gltf;
+
+    u32       accessor_count;
+    u32       texture_count;
+    u32       material_count;
+    u32       mesh_count;
+    Accessor *accessors;
+    Texture  *textures;
+    Material *materials;
+    Mesh     *meshes;
+
+    u8 *accessor_data;     // Extra accessor data (sparse etc.)
+    u8 *primitives_buffer;
+    u8 *weights_buffer;
+};
+
+// Touching each section's count parses it if the gltf is lazy, which must happen on the calling thread (as must
+// the temp allocations), so this is not part of the jobs.
+static void model_begin_gltf_conversion(Gltf *gltf, u8 *model_buffer, u64 buffer_offset_primitives,
+                                        u64 buffer_offset_accessor_data, u64 buffer_offset_weights,
+                                        Model_Gltf_Conversion *conversion)
+{
+    conversion->gltf           = gltf;
+    conversion->accessor_count = gltf_accessor_get_count(gltf);
+    conversion->texture_count  = gltf_texture_get_count(gltf);
+    conversion->material_count = gltf_material_get_count(gltf);
+    conversion->mesh_count     = gltf_mesh_get_count(gltf);
+
+    conversion->accessors = (Accessor*)malloc_t(sizeof(Accessor) * conversion->accessor_count, 8);
+    conversion->textures  = (Texture*) malloc_t(sizeof(Texture)  * conversion->texture_count,  8);
+    conversion->materials = (Material*)malloc_t(sizeof(Material) * conversion->material_count, 8);
+    conversion->meshes    = (Mesh*)model_buffer;
+
+    conversion->accessor_data     = model_buffer + buffer_offset_accessor_data;
+    conversion->primitives_buffer = model_buffer + buffer_offset_primitives;
+    conversion->weights_buffer    = model_buffer + buffer_offset_weights;
+}
+
+static void model_gltf_conversion_job_accessors(void *arg) {
+    Model_Gltf_Conversion *c = (Model_Gltf_Conversion*)arg;
+    model_load_gltf_accessors(c->accessor_count, c->gltf->accessors, c->accessors, c->accessor_data);
+}
+static void model_gltf_conversion_job_textures(void *arg) {
+    Model_Gltf_Conversion *c = (Model_Gltf_Conversion*)arg;
+    model_load_gltf_textures(c->texture_count, c->gltf->textures, c->textures);
+}
+static void model_gltf_conversion_job_materials(void *arg) {
+    Model_Gltf_Conversion *c = (Model_Gltf_Conversion*)arg;
+    model_load_gltf_materials(c->material_count, c->gltf->materials, c->textures, c->materials);
+}
+static void model_gltf_conversion_job_meshes(void *arg) {
+    Model_Gltf_Conversion *c = (Model_Gltf_Conversion*)arg;
+    Load_Mesh_Info load_mesh_info = {
+        .accessors = c->accessors,
+        .materials = c->materials,
+    };
+    model_load_gltf_meshes(&load_mesh_info, c->mesh_count, c->gltf->meshes, c->meshes, c->primitives_buffer,
+                           c->weights_buffer);
+}
+
+static void model_convert_gltfs(u32 count, Model_Gltf_Conversion *conversions) {
+    u64 mark = get_mark_temp();
+
+    enum {
+        JOB_ACCESSORS = 0,
+        JOB_TEXTURES  = 1,
+        JOB_MATERIALS = 2,
+        JOB_MESHES    = 3,
+        JOB_COUNT     = 4,
+    };
+    Job *jobs       = (Job*)malloc_t(sizeof(Job) * JOB_COUNT * count, 8);
+    u32 *dependents = (u32*)malloc_t(sizeof(u32) * 3 * count, 4);
+
+    Job *job;
+    u32 *dep;
+    u32  base;
+    for(u32 i = 0; i < count; ++i) {
+        job  = jobs + JOB_COUNT * i;
+        dep  = dependents + 3 * i;
+        base = JOB_COUNT * i;
+
+        dep[0] = base + JOB_MESHES;
+        dep[1] = base + JOB_MATERIALS;
+        dep[2] = base + JOB_MESHES;
+
+        job[JOB_ACCESSORS] = {model_gltf_conversion_job_accessors, &conversions[i], 0, 1, &dep[0]};
+        job[JOB_TEXTURES]  = {model_gltf_conversion_job_textures,  &conversions[i], 0, 1, &dep[1]};
+        job[JOB_MATERIALS] = {model_gltf_conversion_job_materials, &conversions[i], 1, 1, &dep[2]};
+        job[JOB_MESHES]    = {model_gltf_conversion_job_meshes,    &conversions[i], 2, 0, NULL};
+    }
+    run_jobs(JOB_COUNT * count, jobs);
+
+    reset_to_mark_temp(mark);
+}
+
 struct Buffer_View {
     u64 offset;
     u64 size;
@@ -720,335 +909,2634 @@ inline static void add_buffer_view_index(u32 idx, u32 *count, u32 *indices, u32
     *count += !seen;
 }
 
+// Add a buffer view's data to the allocation in progress. Meshopt compressed views are decoded straight into
+// the allocator's stage rather than into temp and then copied; if one cannot be decoded, the allocation is
+// cancelled and GPU_ALLOCATOR_RESULT_INVALID_DATA returned.
+static Gpu_Allocator_Result model_continue_allocation(Gpu_Allocator *alloc, Gltf *gltf, const Gltf_Buffer_View *view,
+                                                      u8 *const *buffers)
+{
+    if (view->meshopt.mode == GLTF_MESHOPT_MODE_NONE) {
+        assert(buffers[view->buffer] && "Buffer view references a buffer with no data");
+        return continue_allocation(alloc, view->byte_length, buffers[view->buffer] + view->byte_offset);
+    }
+
+    void *stage;
+    Gpu_Allocator_Result result = continue_allocation_in_place(alloc, view->byte_length, &stage);
+    if (result != GPU_ALLOCATOR_RESULT_SUCCESS)
+        return result;
+
+    if (!meshopt_decode_buffer_view(gltf, view, buffers, stage)) {
+        cancel_allocation(alloc);
+        return GPU_ALLOCATOR_RESULT_INVALID_DATA;
+    }
+    return GPU_ALLOCATOR_RESULT_SUCCESS;
+}
+
+                                        /* Mesh Optimization */
+
 //
-// @Note This implementation looks a little weird, as lots of sections seem naively split apart (for
-// instance, the gltf struct is looped a few different times) but this is intentional, as eventually
-// I will split this thing into jobs for threading, like reading the gltf struct into the model struct,
-// and dipatching work to the allocators.
+// Import time vertex cache, overdraw and vertex fetch ordering (see mesh.hpp), run on the loaded buffers before
+// they are copied to the allocators, so that the gpu (and the model cache) only ever see the optimized data.
 //
-// @Todo Skins, Animations, Cameras.
+// Accessors are matched on the bytes which they cover in the loaded buffers. Triangle reordering is safe for
+// indices which no other accessor partly overlaps, as primitives sharing the same indices share the triangle set.
+// Welding and vertex fetch ordering move vertices, so they only run on primitives which are the sole user of every
+// accessor they touch (indices, attributes and morph targets), with no overlap, and whose vertex data is not sparse
+// or meshopt compressed (which is decoded straight into the allocator, so there is nothing to edit here). Welding
+// can shrink accessor counts; min/max are left alone, so they stay conservative.
 //
-Model model_from_gltf(Model_Allocators *model_allocators, const String *model_dir, const String *gltf_file_name, u64 size_available,
-                      u8 *model_buffer, u64 *ret_req_size)
-{
-    u64 temp_allocator_mark = get_mark_temp(); // Reset to mark at end of function
+static constexpr bool MODEL_OPTIMIZE_MESHES = true;
 
-    char uri_buf[127];
-    memcpy(uri_buf +              0, model_dir->str,      model_dir->len);
-    memcpy(uri_buf + model_dir->len, gltf_file_name->str, gltf_file_name->len + 1);
-    Gltf gltf = parse_gltf(uri_buf);
+// Bytes [begin, end) of an accessor in the loaded buffers, with the buffer index above bit 40 (so ranges in
+// different views of a buffer compare). Empty if it has none there.
+struct Model_Accessor_Range {
+    u64 begin;
+    u64 end;
+};
 
-    // Get required bytes
-    Model_Req_Size_Info req_size = model_get_required_size_from_gltf(&gltf);
+struct Model_Accessor_Ref {
+    Model_Accessor_Range range; // empty is an empty slot
+    u32  count;
+    bool overlapped;            // by another range, so editing either would corrupt the other
+};
 
-    #if MODEL_LOAD_INFO
-    println("Size required for model %s: %u, Bytes remaining in buffer: %u", gltf_file_name->str, req_size.total, size_available);
-    #endif
+struct Model_Mesh_Optimize_Info {
+    Gltf      *gltf;
+    u8 *const *buffers;
 
-    *ret_req_size = req_size.total;
-    if (req_size.total > size_available) {
+    // Open addressing table of accessor references, keyed on their ranges (rather than the gltf accessor index,
+    // which the model does not keep), so aliasing accessors count as the same data.
+    u32                 ref_table_size;
+    Model_Accessor_Ref *refs;
+};
 
-        #if !MODEL_LOAD_INFO
-        println("Size required for model %s: %u, Bytes remaining in buffer: %u", gltf_file_name->str, req_size.total, size_available);
-        #endif
+inline static u32 model_accessor_get_element_size(Accessor_Flags flags) {
+    u32 width = 4;
+    width = flags & (ACCESSOR_COMPONENT_TYPE_SCHAR_BIT | ACCESSOR_COMPONENT_TYPE_UCHAR_BIT) ? 1 : width;
+    width = flags & (ACCESSOR_COMPONENT_TYPE_S16_BIT   | ACCESSOR_COMPONENT_TYPE_U16_BIT |
+                     ACCESSOR_COMPONENT_TYPE_HALF_BIT)                                       ? 2 : width;
 
-        println("Insufficient size remaining in model buffer. Failed to load models.");
-        assert(false && "See above...");
+    u32 count = 1;
+    count = flags & ACCESSOR_TYPE_VEC2_BIT                           ?  2 : count;
+    count = flags & ACCESSOR_TYPE_VEC3_BIT                           ?  3 : count;
+    count = flags & (ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_TYPE_MAT2_BIT) ?  4 : count;
+    count = flags & ACCESSOR_TYPE_MAT3_BIT                           ?  9 : count;
+    count = flags & ACCESSOR_TYPE_MAT4_BIT                           ? 16 : count;
 
-        return {};
-    }
+    return width * count;
+}
 
-    Model ret = {};
-    ret.mesh_count = gltf_mesh_get_count(&gltf);
+// An accessor's data in the loaded buffers, or NULL if it cannot be read or edited there.
+static u8* model_get_accessor_data(Gltf *gltf, u8 *const *buffers, const Accessor *accessor) {
+    if (accessor->sparse || accessor->allocation_key == Max_u32)
+        return NULL;
 
-    // model_buffer layout: (@Todo This will change when I add skins, animations, etc.)
-    // | meshes | primitives | extra primitive data | extra accessor data | mesh weights |
+    const Gltf_Buffer_View *view = gltf_buffer_view_by_index(gltf, accessor->allocation_key);
+    if (view->meshopt.mode != GLTF_MESHOPT_MODE_NONE || !buffers[view->buffer])
+        return NULL;
 
-    u32 buffer_offset_primitives    = sizeof(Mesh) * ret.mesh_count;
-    u32 buffer_offset_accessor_data = buffer_offset_primitives    + req_size.primitives;
-    u32 buffer_offset_weights       = buffer_offset_accessor_data + req_size.accessors;
+    return buffers[view->buffer] + view->byte_offset + accessor->byte_offset;
+}
 
-    // @Multithreading accessors and textures are independent. Materials depends on textures.
+static Model_Accessor_Range model_get_accessor_range(Gltf *gltf, u8 *const *buffers, const Accessor *accessor) {
+    Model_Accessor_Range ret = {};
+    if (accessor->allocation_key == Max_u32 || !accessor->count)
+        return ret;
 
-    // Accessor
-    u32       accessor_count = gltf_accessor_get_count(&gltf);
-    Accessor *accessors      = (Accessor*)malloc_t(sizeof(Accessor) * accessor_count, 8);
-    model_load_gltf_accessors(accessor_count, gltf.accessors, accessors, model_buffer + buffer_offset_accessor_data);
+    // Sparse accessors still count: their base values are read from the view.
+    const Gltf_Buffer_View *view = gltf_buffer_view_by_index(gltf, accessor->allocation_key);
+    if (view->meshopt.mode != GLTF_MESHOPT_MODE_NONE || !buffers[view->buffer])
+        return ret;
 
-    // Texture - no extra data, so no buffer argument
-    u32      texture_count = gltf_texture_get_count(&gltf);
-    Texture *textures      = (Texture*)malloc_t(sizeof(Texture) * texture_count, 8);
-    model_load_gltf_textures(texture_count, gltf.textures, textures);
+    u32 size   = model_accessor_get_element_size(accessor->flags);
+    u32 stride = accessor->byte_stride ? accessor->byte_stride : size;
+    ret.begin  = ((u64)view->buffer << 40) + view->byte_offset + accessor->byte_offset;
+    ret.end    = ret.begin + (u64)stride * (accessor->count - 1) + size;
+    return ret;
+}
 
-    // Material - no extra data, so no buffer argument
-    u32       material_count = gltf_material_get_count(&gltf);
-    Material *materials      = (Material*)malloc_t(sizeof(Material) * material_count, 8);
-    model_load_gltf_materials(material_count, gltf.materials, textures, materials);
+// The ref of 'accessor''s range, added if 'add', else NULL if it is not in the table. NULL if the range is empty.
+static Model_Accessor_Ref* model_get_accessor_ref(Model_Mesh_Optimize_Info *info, const Accessor *accessor, bool add) {
+    Model_Accessor_Range range = model_get_accessor_range(info->gltf, info->buffers, accessor);
+    if (range.begin == range.end)
+        return NULL;
+
+    Model_Accessor_Ref *ref;
+    u32 slot = (u32)hash_bytes(&range, sizeof(range)) & (info->ref_table_size - 1);
+    while(true) {
+        ref = &info->refs[slot];
+        if (ref->range.begin == range.begin && ref->range.end == range.end)
+            return ref;
+        if (ref->range.begin == ref->range.end) {
+            if (!add)
+                return NULL;
+            ref->range = range;
+            return ref;
+        }
+        slot = (slot + 1) & (info->ref_table_size - 1);
+    }
+}
 
-    Load_Mesh_Info load_mesh_info = {
-        .accessors = accessors,
-        .materials = materials,
-    };
+// Whether the primitive which references 'accessor' can edit it in place: its indices can be reordered if no
+// other range overlaps them, and vertices can be moved if nothing else references their range at all.
+static bool model_accessor_can_reorder(Model_Mesh_Optimize_Info *info, const Accessor *accessor) {
+    Model_Accessor_Ref *ref = model_get_accessor_ref(info, accessor, false);
+    return ref && !ref->overlapped;
+}
+static bool model_accessor_can_move(Model_Mesh_Optimize_Info *info, const Accessor *accessor) {
+    Model_Accessor_Ref *ref = model_get_accessor_ref(info, accessor, false);
+    return ref && !ref->overlapped && ref->count == 1;
+}
 
-    // Mesh
-    ret.meshes = (Mesh*)(model_buffer);
-    model_load_gltf_meshes(&load_mesh_info, ret.mesh_count, gltf.meshes, ret.meshes,
-                           model_buffer + buffer_offset_primitives, model_buffer + buffer_offset_weights);
+static int model_compare_accessor_refs(const void *a, const void *b) {
+    const Model_Accessor_Range *x = &(*(const Model_Accessor_Ref**)a)->range;
+    const Model_Accessor_Range *y = &(*(const Model_Accessor_Ref**)b)->range;
+    if (x->begin != y->begin)
+        return x->begin < y->begin ? -1 : 1;
+    if (x->end != y->end)
+        return x->end < y->end ? -1 : 1;
+    return 0;
+}
 
-    // Each texture/buffer view becomes an allocation.
-    // @Note One day I will join buffer views together, so that an allocation is the data referenced by a primitive.
+// Mark every ref whose range partly overlaps another's. In order of begin, a range overlaps one before it if it
+// begins before the furthest end so far, and one after it if the next one begins before its end.
+static void model_find_overlapping_accessor_refs(Model_Mesh_Optimize_Info *info) {
+    u32 count = 0;
+    Model_Accessor_Ref **refs = (Model_Accessor_Ref**)malloc_t(sizeof(Model_Accessor_Ref*) * info->ref_table_size, 8);
+    for(u32 i = 0; i < info->ref_table_size; ++i)
+        if (info->refs[i].range.begin != info->refs[i].range.end)
+            refs[count++] = &info->refs[i];
+    qsort(refs, count, sizeof(Model_Accessor_Ref*), model_compare_accessor_refs);
+
+    u64 end = 0;
+    for(u32 i = 0; i < count; ++i) {
+        refs[i]->overlapped |= refs[i]->range.begin < end;
+        if (i + 1 < count)
+            refs[i]->overlapped |= refs[i + 1]->range.begin < refs[i]->range.end;
+        end = refs[i]->range.end > end ? refs[i]->range.end : end;
+    }
+}
 
-                                    /* Buffer View Allocations */
-    u32  buffer_view_count          = gltf_buffer_view_get_count(&gltf);
-    u32  index_buffer_view_count    = 0;
-    u32  vertex_buffer_view_count   = 0;
-    u32 *index_buffer_view_indices  = (u32*)malloc_t(sizeof(Buffer_View) * buffer_view_count, 8);
-    u32 *vertex_buffer_view_indices = (u32*)malloc_t(sizeof(Buffer_View) * buffer_view_count, 8);
+struct Model_Triangle_List {
+    u8  *index_data; // in the loaded buffers
+    u32  index_size;
+    u32  index_count;
+    u32  vertex_count;
+    u32 *indices;    // widened, in temp
+};
 
-    // Assume fewer than 8 * 64 (512) buffer views
-    u32 mask_count = 8;
-    u64 masks[mask_count];
-    memset(masks, 0, sizeof(u64) * mask_count);
-    assert(buffer_view_count < (8 * 64) && "Increase mask count");
+// Widen the indices of an indexed triangle list primitive into temp. False, with nothing allocated, if the
+// primitive is not one, or if its indices cannot be read from the loaded buffers or are out of range.
+static bool model_read_triangle_list(Gltf *gltf, u8 *const *buffers, const Mesh_Primitive *primitive,
+                                     Model_Triangle_List *ret)
+{
+    if (primitive->topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || !primitive->attribute_count)
+        return false;
 
-    // Separate buffer views into vertex and index data (add_buffer_view_index() tracks dupes, branchless)
-    Mesh_Primitive *primitive;
-    Morph_Target   *target;
-    for(u32 i = 0; i < ret.mesh_count; ++i) {
-        for(u32 j = 0; j < ret.meshes[i].primitive_count; ++j) {
-            primitive = &ret.meshes[i].primitives[j];
+    const Accessor *indices = &primitive->indices;
 
-            add_buffer_view_index(primitive->indices.allocation_key, &index_buffer_view_count,
-                                  index_buffer_view_indices, mask_count, masks);
+    ret->index_size = 0;
+    ret->index_size = indices->flags & ACCESSOR_COMPONENT_TYPE_UCHAR_BIT ? 1 : ret->index_size;
+    ret->index_size = indices->flags & ACCESSOR_COMPONENT_TYPE_U16_BIT   ? 2 : ret->index_size;
+    ret->index_size = indices->flags & ACCESSOR_COMPONENT_TYPE_U32_BIT   ? 4 : ret->index_size;
 
-            for(u32 k = 0; k < primitive->attribute_count; ++k) {
-                add_buffer_view_index(primitive->attributes[k].accessor.allocation_key, &vertex_buffer_view_count,
-                                      vertex_buffer_view_indices, mask_count, masks);
+    ret->index_data = model_get_accessor_data(gltf, buffers, indices);
+    if (!ret->index_size || !ret->index_data || !indices->count || indices->count % 3)
+        return false;
 
-                if (primitive->attributes[k].accessor.sparse) {
-                    add_buffer_view_index(primitive->attributes[k].accessor.sparse->indices_allocation_key,
-                                          &index_buffer_view_count, index_buffer_view_indices, mask_count, masks);
-                    add_buffer_view_index(primitive->attributes[k].accessor.sparse->values_allocation_key,
-                                          &vertex_buffer_view_count, vertex_buffer_view_indices, mask_count, masks);
-                }
-            }
+    ret->index_count  = indices->count;
+    ret->vertex_count = primitive->attributes[0].accessor.count;
 
-            for(u32 k = 0; k < primitive->target_count; ++k) {
-                target = &primitive->targets[k];
-                for(u32 l = 0; l < target->attribute_count; ++l) {
-                   add_buffer_view_index(target->attributes[l].accessor.allocation_key, &vertex_buffer_view_count,
-                                         vertex_buffer_view_indices, mask_count, masks);
+    u64 mark = get_mark_temp();
 
-                    if (primitive->attributes[k].accessor.sparse) {
-                        add_buffer_view_index(target->attributes[l].accessor.sparse->indices_allocation_key,
-                                              &index_buffer_view_count, index_buffer_view_indices, mask_count, masks);
-                        add_buffer_view_index(target->attributes[l].accessor.sparse->values_allocation_key,
-                                              &vertex_buffer_view_count, vertex_buffer_view_indices, mask_count, masks);
-                    }
+    ret->indices = (u32*)malloc_t(sizeof(u32) * ret->index_count, 4);
+    for(u32 i = 0; i < ret->index_count; ++i) {
+        switch(ret->index_size) {
+        case 1: ret->indices[i] = ret->index_data[i];                break;
+        case 2: ret->indices[i] = ((const u16*)ret->index_data)[i]; break;
+        case 4: ret->indices[i] = ((const u32*)ret->index_data)[i]; break;
+        }
+        if (ret->indices[i] >= ret->vertex_count) { // Malformed, leave it as authored.
+            reset_to_mark_temp(mark);
+            return false;
+        }
+    }
+    return true;
+}
 
-                }
-            }
+// Narrow 'indices' back into the triangle list's data in the loaded buffers.
+static void model_write_triangle_list(const Model_Triangle_List *list, const u32 *indices) {
+    for(u32 i = 0; i < list->index_count; ++i) {
+        switch(list->index_size) {
+        case 1: list->index_data[i]         = (u8) indices[i]; break;
+        case 2: ((u16*)list->index_data)[i] = (u16)indices[i]; break;
+        case 4: ((u32*)list->index_data)[i] =      indices[i]; break;
         }
     }
+}
 
-    // Make the access pattern in the below loop a bit more predictable. There should only
-    // be a relatively small number off indices in each array, so it should be fast.
-    sort_indices(index_buffer_view_count, index_buffer_view_indices);
-    sort_indices(vertex_buffer_view_count, vertex_buffer_view_indices);
+// A primitive's first attribute of 'type' in the loaded buffers, or NULL if it has none there which is floats of
+// 'type_bit' (ACCESSOR_TYPE_VEC3_BIT etc., they may be quantized), or if there are fewer of them than of its other
+// vertex attributes.
+static const float* model_get_float_attribute(Gltf *gltf, u8 *const *buffers, const Mesh_Primitive *primitive,
+                                              Mesh_Primitive_Attribute_Type type, Accessor_Flag_Bits type_bit,
+                                              u32 *ret_stride)
+{
+    const Accessor *accessor;
+    for(u32 i = 0; i < primitive->attribute_count; ++i) {
+        accessor = &primitive->attributes[i].accessor;
+        if (primitive->attributes[i].type == type) {
+            if (!(accessor->flags & ACCESSOR_COMPONENT_TYPE_FLOAT_BIT) || !(accessor->flags & type_bit) ||
+                accessor->count < primitive->attributes[0].accessor.count)
+                return NULL;
+
+            *ret_stride = accessor->byte_stride;
+            return (const float*)model_get_accessor_data(gltf, buffers, accessor);
+        }
+    }
+    return NULL;
+}
 
-    // Repeated assert ik, a reminder for a different section...
-    assert(gltf_buffer_get_count(&gltf) == 1 && "Have to loop buffers *rolls eyes*");
+inline static const float* model_get_float3_positions(Gltf *gltf, u8 *const *buffers, const Mesh_Primitive *primitive,
+                                                      u32 *ret_stride)
+{
+    return model_get_float_attribute(gltf, buffers, primitive, MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION,
+                                     ACCESSOR_TYPE_VEC3_BIT, ret_stride);
+}
 
-    const Gltf_Buffer *gltf_buffer = gltf.buffers;
+inline static void model_add_vertex_cache_stats(Vertex_Cache_Stats *to, const Vertex_Cache_Stats *stats) {
+    to->vertices_transformed += stats->vertices_transformed;
+    to->vertex_count         += stats->vertex_count;
+    to->triangle_count       += stats->triangle_count;
+}
 
-    u32 model_dir_len = model_dir->len;
-    strcpy(uri_buf + model_dir_len, gltf_buffer->uri); // Build the buffer uri.
+// Remap a vertex stream in the loaded buffers, through a packed copy (remaps cannot run in place).
+static void model_remap_vertex_stream(const Mesh_Vertex_Stream *stream, u32 vertex_count, u32 new_vertex_count,
+                                      const u32 *remap)
+{
+    u64 mark = get_mark_temp();
 
-    u8 *buffer = (u8*)file_read_bin_temp_large(uri_buf, gltf_buffer->byte_length);
+    u8 *data   = (u8*)stream->data;
+    u8 *packed = (u8*)malloc_t((u64)stream->size * new_vertex_count, 4);
+    mesh_remap_vertices(packed, stream->size, data, stream->stride, stream->size, vertex_count, remap);
+    for(u32 i = 0; i < new_vertex_count; ++i)
+        memcpy(data + (u64)i * stream->stride, packed + (u64)i * stream->size, stream->size);
 
-    u32 *allocation_keys = (u32*)malloc_t(sizeof(u32) * buffer_view_count);
+    reset_to_mark_temp(mark);
+}
 
-    u32 tmp;
-    const Gltf_Buffer_View     *gltf_buffer_view;
-    Gpu_Allocator_Result  allocator_result;
-    for(u32 i = 0; i < index_buffer_view_count; ++i) {
-        allocator_result = begin_allocation(&model_allocators->index);
-        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+static void model_optimize_primitive(Model_Mesh_Optimize_Info *info, Mesh_Primitive *primitive,
+                                     Vertex_Cache_Stats *before, Vertex_Cache_Stats *after)
+{
+    u64 mark = get_mark_temp();
+
+    Model_Triangle_List list;
+    if (!model_accessor_can_reorder(info, &primitive->indices) ||
+        !model_read_triangle_list(info->gltf, info->buffers, primitive, &list))
+        return;
+
+    u32  index_count  = list.index_count;
+    u32  vertex_count = list.vertex_count;
+    u32 *idx          = list.indices;
+    u32 *tmp          = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+
+    // Every vertex stream, for welding and fetch ordering, and the float3 positions for overdraw.
+    u32 stream_count = primitive->attribute_count;
+    for(u32 i = 0; i < primitive->target_count; ++i)
+        stream_count += primitive->targets[i].attribute_count;
+
+    Accessor          **stream_accessors = (Accessor**)malloc_t(sizeof(Accessor*) * stream_count, 8);
+    Mesh_Vertex_Stream *streams          = (Mesh_Vertex_Stream*)malloc_t(sizeof(Mesh_Vertex_Stream) * stream_count, 8);
+
+    u32 stream = 0;
+    for(u32 i = 0; i < primitive->attribute_count; ++i)
+        stream_accessors[stream++] = &primitive->attributes[i].accessor;
+    for(u32 i = 0; i < primitive->target_count; ++i)
+        for(u32 j = 0; j < primitive->targets[i].attribute_count; ++j)
+            stream_accessors[stream++] = &primitive->targets[i].attributes[j].accessor;
+
+    bool move_vertices = model_accessor_can_move(info, &primitive->indices);
+    for(u32 i = 0; i < stream_count; ++i) {
+        streams[i].data   = model_get_accessor_data(info->gltf, info->buffers, stream_accessors[i]);
+        streams[i].size   = model_accessor_get_element_size(stream_accessors[i]->flags);
+        streams[i].stride = stream_accessors[i]->byte_stride;
+
+        move_vertices = move_vertices && streams[i].data && stream_accessors[i]->count == vertex_count &&
+                        model_accessor_can_move(info, stream_accessors[i]);
+    }
 
-        tmp = index_buffer_view_indices[i];
-        gltf_buffer_view = gltf_buffer_view_by_index(&gltf, tmp); // Lame, I do not like what this function represents...
+    u32 position_stride;
+    const float *positions = model_get_float3_positions(info->gltf, info->buffers, primitive, &position_stride);
 
-        allocator_result = continue_allocation(&model_allocators->index, gltf_buffer_view->byte_length,
-                                               buffer + gltf_buffer_view->byte_offset);
-        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+    Vertex_Cache_Stats stats = mesh_analyze_vertex_cache(idx, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    model_add_vertex_cache_stats(before, &stats);
 
-        allocator_result = submit_allocation(&model_allocators->index, &allocation_keys[tmp]);
-        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
-    }
+    u32 *remap = move_vertices ? (u32*)malloc_t(sizeof(u32) * vertex_count, 4) : NULL;
+    u32  new_vertex_count;
 
-    for(u32 i = 0; i < vertex_buffer_view_count; ++i) {
-        allocator_result = begin_allocation(&model_allocators->vertex);
-        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+    if (move_vertices) {
+        new_vertex_count = mesh_generate_vertex_remap(remap, vertex_count, stream_count, streams);
+        if (new_vertex_count < vertex_count) {
+            mesh_remap_indices(idx, idx, index_count, remap);
+            for(u32 i = 0; i < stream_count; ++i)
+                model_remap_vertex_stream(&streams[i], vertex_count, new_vertex_count, remap);
+            vertex_count = new_vertex_count;
+        }
+    }
 
-        tmp = vertex_buffer_view_indices[i];
-        gltf_buffer_view = gltf_buffer_view_by_index(&gltf, tmp); // Lame, I do not like what this function represents...
+    mesh_optimize_vertex_cache(tmp, idx, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    if (positions) {
+        mesh_optimize_overdraw(idx, tmp, index_count, positions, position_stride, vertex_count,
+                               MESH_VERTEX_CACHE_SIZE, MESH_OVERDRAW_THRESHOLD);
+    } else {
+        u32 *swap = idx;
+        idx = tmp;
+        tmp = swap;
+    }
 
-        allocator_result = continue_allocation(&model_allocators->vertex, gltf_buffer_view->byte_length,
-                                               buffer + gltf_buffer_view->byte_offset);
-        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+    if (move_vertices) {
+        new_vertex_count = mesh_generate_vertex_fetch_remap(remap, idx, index_count, vertex_count);
+        mesh_remap_indices(idx, idx, index_count, remap);
+        for(u32 i = 0; i < stream_count; ++i)
+            model_remap_vertex_stream(&streams[i], vertex_count, new_vertex_count, remap);
+        vertex_count = new_vertex_count;
 
-        allocator_result = submit_allocation(&model_allocators->vertex, &allocation_keys[tmp]);
-        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+        for(u32 i = 0; i < stream_count; ++i)
+            stream_accessors[i]->count = vertex_count;
     }
 
-                                        /* Texture Allocations */
+    stats = mesh_analyze_vertex_cache(idx, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    model_add_vertex_cache_stats(after, &stats);
 
-    u32  image_count              = gltf_image_get_count(&gltf);
-    u32 *tex_allocation_keys  = (u32*)malloc_t(sizeof(u32) * image_count);
+    model_write_triangle_list(&list, idx);
 
-    String image_file_name;
-    const Gltf_Image *gltf_image = gltf.images;
-    for(u32 i = 0; i < image_count; ++i) {
-        // Fixing the below assert is trivial, but I do not need to right now. It will be done
-        // when it actually fires.
-        assert(gltf_image->uri && "@Todo @Unimplemented Support reading textures from buffer views");
+    reset_to_mark_temp(mark);
+}
 
-        // Idk about strlens and cstrs. It seems to compile to an avx intrinsic, so worries about speed is
-        // whatever, its just robustness (I am just debating in my head converting the gltf parser to use
-        // a real string type...)
-        strcpy(uri_buf + model_dir_len, gltf_image->uri); // Build the image uri
-        image_file_name = cstr_to_string(uri_buf);
+// Optimize every primitive of 'model' in 'buffers', and sum their vertex cache stats before and after.
+static void model_optimize_meshes(Model *model, Gltf *gltf, u8 *const *buffers, Vertex_Cache_Stats *before,
+                                  Vertex_Cache_Stats *after)
+{
+    *before = {};
+    *after  = {};
 
-        // replace indices into images array with texture allocation keys
-        allocator_result = tex_add_texture(&model_allocators->tex, &image_file_name, &tex_allocation_keys[i]);
-        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+    u64 mark = get_mark_temp();
 
-        gltf_image = (const Gltf_Image*)((u8*)gltf_image + gltf_image->stride);
+    Mesh_Primitive *primitive;
+    u32 ref_count = 0;
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive  = &model->meshes[i].primitives[j];
+            ref_count += 1 + primitive->attribute_count;
+            for(u32 k = 0; k < primitive->target_count; ++k)
+                ref_count += primitive->targets[k].attribute_count;
+        }
     }
 
-    u32  sampler_count = gltf_sampler_get_count(&gltf);
-    u32 *sampler_keys  = (u32*)malloc_t(sizeof(u32) * sampler_count);
+    Model_Mesh_Optimize_Info info = {};
+    info.gltf           = gltf;
+    info.buffers        = buffers;
+    info.ref_table_size = 16;
+    while(info.ref_table_size < ref_count * 2)
+        info.ref_table_size <<= 1;
+    info.refs = (Model_Accessor_Ref*)malloc_t(sizeof(Model_Accessor_Ref) * info.ref_table_size, 8);
+    memset(info.refs, 0, sizeof(Model_Accessor_Ref) * info.ref_table_size);
+
+    Model_Accessor_Ref *ref;
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive = &model->meshes[i].primitives[j];
+
+            if ((ref = model_get_accessor_ref(&info, &primitive->indices, true)))
+                ref->count++;
+            for(u32 k = 0; k < primitive->attribute_count; ++k)
+                if ((ref = model_get_accessor_ref(&info, &primitive->attributes[k].accessor, true)))
+                    ref->count++;
+            for(u32 k = 0; k < primitive->target_count; ++k)
+                for(u32 l = 0; l < primitive->targets[k].attribute_count; ++l)
+                    if ((ref = model_get_accessor_ref(&info, &primitive->targets[k].attributes[l].accessor, true)))
+                        ref->count++;
+        }
+    }
+    model_find_overlapping_accessor_refs(&info);
 
-    Get_Sampler_Info         get_sampler_info;
-    Sampler_Allocator_Result sampler_result;
+    for(u32 i = 0; i < model->mesh_count; ++i)
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j)
+            model_optimize_primitive(&info, &model->meshes[i].primitives[j], before, after);
 
-    const Gltf_Sampler *gltf_sampler = gltf.samplers;
-    for(u32 i = 0; i < sampler_count; ++i) {
-        get_sampler_info = {};
-        get_sampler_info.wrap_s = (VkSamplerAddressMode)gltf_sampler->wrap_u;
-        get_sampler_info.wrap_t = (VkSamplerAddressMode)gltf_sampler->wrap_v;
-        get_sampler_info.mag_filter = (VkFilter)gltf_sampler->mag_filter;
-        get_sampler_info.min_filter = (VkFilter)gltf_sampler->min_filter;
+    reset_to_mark_temp(mark);
 
-        sampler_result = add_sampler(&model_allocators->sampler, &get_sampler_info, &sampler_keys[i]);
-        assert(sampler_result == SAMPLER_ALLOCATOR_RESULT_SUCCESS);
-        CHECK_SAMPLER_ALLOCATOR_RESULT(sampler_result);
+    before->acmr = before->triangle_count ? (float)before->vertices_transformed / before->triangle_count : 0;
+    before->atvr = before->vertex_count   ? (float)before->vertices_transformed / before->vertex_count   : 0;
+    after->acmr  = after->triangle_count  ? (float)after->vertices_transformed  / after->triangle_count  : 0;
+    after->atvr  = after->vertex_count    ? (float)after->vertices_transformed  / after->vertex_count    : 0;
+}
 
-        gltf_sampler = (const Gltf_Sampler*)((u8*)gltf_sampler + gltf_sampler->stride);
-    }
+//
+// Meshlets for every indexed triangle list primitive with float3 positions, built from the optimized indices (so
+// after model_optimize_meshes(..)) and written to 'buffer', whose 'size' bytes come from the bound in
+// Model_Req_Size_Info. Returns the bytes used. Primitives which are left out keep 'meshlets' NULL.
+//
+static u64 model_build_meshlets(Model *model, Gltf *gltf, u8 *const *buffers, u8 *buffer, u64 size) {
+    u64 size_used = 0;
+
+    Mesh_Primitive      *primitive;
+    Model_Triangle_List  list;
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive = &model->meshes[i].primitives[j];
+
+            u64 mark = get_mark_temp();
+            if (!model_read_triangle_list(gltf, buffers, primitive, &list))
+                continue;
+
+            u32 position_stride;
+            const float *positions = model_get_float3_positions(gltf, buffers, primitive, &position_stride);
+            if (!positions) {
+                reset_to_mark_temp(mark);
+                continue;
+            }
 
-    // @Todo Do something with the information that a texture will always/have need a sampler, so I do not need
-    // a sampler count. Right now it is fine because I would pad the sampler count in primitive.key_counts anyway
-    // for simd, so right now it is useful for that. But it is a free 4 bytes that might be useful.
+            u32      bound     = mesh_get_meshlet_bound(list.index_count, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES);
+            Meshlet *meshlets  = (Meshlet*)malloc_t(sizeof(Meshlet) * bound, 4);
+            u32     *vertices  = (u32*)malloc_t(sizeof(u32) * list.index_count, 4);
+            u8      *triangles = (u8*)malloc_t(list.index_count, 1);
 
-    // Point model back at the allocation keys
-    Accessor *accessor;
-    for(u32 i = 0; i < ret.mesh_count; ++i) {
-        for(u32 j = 0; j < ret.meshes[i].primitive_count; ++j) {
-            primitive = &ret.meshes[i].primitives[j];
+            u32 count = mesh_build_meshlets(meshlets, vertices, triangles, list.indices, list.index_count, positions,
+                                            position_stride, list.vertex_count, MESHLET_MAX_VERTICES,
+                                            MESHLET_MAX_TRIANGLES);
 
-            // Indices
-            primitive->indices.allocation_key = allocation_keys[primitive->indices.allocation_key];
-            primitive->key_counts.index++;
+            const Meshlet *last           = &meshlets[count - 1];
+            u32            vertex_count   = last->vertex_offset   + last->vertex_count;
+            u32            triangle_count = last->triangle_offset + last->triangle_count;
 
-                                                    /* Material */
-            // Base Color
-            primitive->material.pbr.base_color_texture.texture_key = tex_allocation_keys[primitive->material.pbr.base_color_texture.texture_key];
-            primitive->material.pbr.base_color_texture.sampler_key = sampler_keys       [primitive->material.pbr.base_color_texture.sampler_key];
+            u64 req_size = model_get_meshlets_size(count, vertex_count, triangle_count);
+            assert(size_used + req_size <= size && "Meshlets outgrew the bound in Model_Req_Size_Info");
 
-            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_BASE_BIT) > 0;
-            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_BASE_BIT) > 0;
+            u8 *data   = buffer + size_used;
+            size_used += req_size;
 
-            // Metallic Roughness
-            primitive->material.pbr.metallic_roughness_texture.texture_key = tex_allocation_keys[primitive->material.pbr.metallic_roughness_texture.texture_key];
-            primitive->material.pbr.metallic_roughness_texture.sampler_key = sampler_keys       [primitive->material.pbr.metallic_roughness_texture.sampler_key];
+            Meshlets *ret  = (Meshlets*)data;
+            data          += align(sizeof(Meshlets), 16);
+            ret->meshlets  = (Meshlet*)data;
+            data          += align(sizeof(Meshlet) * count, 16);
+            ret->bounds    = (Meshlet_Bounds*)data;
+            data          += align(sizeof(Meshlet_Bounds) * count, 16);
+            ret->vertices  = (u32*)data;
+            data          += align(sizeof(u32) * vertex_count, 16);
+            ret->triangles = data;
 
-            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_PBR_BIT) > 0;
-            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_PBR_BIT) > 0;
+            ret->count          = count;
+            ret->vertex_count   = vertex_count;
+            ret->triangle_count = triangle_count;
 
-            // Normal
-            primitive->material.normal.texture.texture_key = tex_allocation_keys[primitive->material.normal.texture.texture_key];
-            primitive->material.normal.texture.sampler_key = sampler_keys       [primitive->material.normal.texture.sampler_key];
+            memcpy(ret->meshlets,  meshlets,  sizeof(Meshlet) * count);
+            memcpy(ret->vertices,  vertices,  sizeof(u32) * vertex_count);
+            memcpy(ret->triangles, triangles, 3 * triangle_count);
 
-            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_NORMAL_BIT) > 0;
-            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_NORMAL_BIT) > 0;
+            for(u32 k = 0; k < count; ++k)
+                ret->bounds[k] = mesh_compute_meshlet_bounds(&meshlets[k], vertices, triangles, positions,
+                                                             position_stride);
 
-            // Occlusion
-            primitive->material.occlusion.texture.texture_key = tex_allocation_keys[primitive->material.occlusion.texture.texture_key];
-            primitive->material.occlusion.texture.sampler_key = sampler_keys       [primitive->material.occlusion.texture.sampler_key];
+            primitive->meshlets = ret;
 
-            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_OCCLUSION_BIT) > 0;
-            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_OCCLUSION_BIT) > 0;
+            reset_to_mark_temp(mark);
+        }
+    }
+    return size_used;
+}
 
-            // Emissive
-            primitive->material.emissive.texture.texture_key  = tex_allocation_keys[primitive->material.emissive.texture.texture_key];
-            primitive->material.emissive.texture.sampler_key  = sampler_keys       [primitive->material.emissive.texture.sampler_key];
+//
+// Lods for the same primitives as the meshlets, each one simplified from the full detail indices towards half the
+// triangles of the lod before it, with normals and uvs weighted into the error. A lod is only kept if it has at
+// most 3/4 of the indices of the one before it (else the primitive is about as simple as MODEL_LOD_MAX_ERROR
+// allows), and its indices are reordered for the vertex cache like the full detail ones. Primitives of a mesh with
+// more than one keep their borders, so that the primitives stay joined.
+//
+static constexpr float MODEL_LOD_MAX_ERROR     = 0.05f; // relative to the primitive's extent, see mesh_simplify(..)
+static constexpr float MODEL_LOD_NORMAL_WEIGHT = 0.1f;
+static constexpr float MODEL_LOD_UV_WEIGHT     = 0.1f;
+
+static u64 model_build_lods(Model *model, Gltf *gltf, u8 *const *buffers, u8 *buffer, u64 size) {
+    u64 size_used = 0;
+
+    Mesh_Primitive        *primitive;
+    Model_Triangle_List    list;
+    Mesh_Attribute_Stream  streams[2];
+    Mesh_Lod               lods[MODEL_LOD_COUNT];
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        Mesh_Simplify_Flags flags = model->meshes[i].primitive_count > 1 ? MESH_SIMPLIFY_LOCK_BORDER_BIT : 0;
+
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive = &model->meshes[i].primitives[j];
+
+            u64 mark = get_mark_temp();
+            if (!model_read_triangle_list(gltf, buffers, primitive, &list))
+                continue;
+
+            u32 position_stride;
+            const float *positions = model_get_float3_positions(gltf, buffers, primitive, &position_stride);
+            if (!positions) {
+                reset_to_mark_temp(mark);
+                continue;
+            }
 
-            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_EMISSIVE_BIT) > 0;
-            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_EMISSIVE_BIT) > 0;
+            u32 stream_count = 0;
+            streams[stream_count].data   = model_get_float_attribute(gltf, buffers, primitive,
+                                                                     MESH_PRIMITIVE_ATTRIBUTE_TYPE_NORMAL,
+                                                                     ACCESSOR_TYPE_VEC3_BIT,
+                                                                     &streams[stream_count].stride);
+            streams[stream_count].count  = 3;
+            streams[stream_count].weight = MODEL_LOD_NORMAL_WEIGHT;
+            stream_count                += streams[stream_count].data != NULL;
+
+            streams[stream_count].data   = model_get_float_attribute(gltf, buffers, primitive,
+                                                                     MESH_PRIMITIVE_ATTRIBUTE_TYPE_TEX_COORDS,
+                                                                     ACCESSOR_TYPE_VEC2_BIT,
+                                                                     &streams[stream_count].stride);
+            streams[stream_count].count  = 2;
+            streams[stream_count].weight = MODEL_LOD_UV_WEIGHT;
+            stream_count                += streams[stream_count].data != NULL;
+
+            u32 *indices    = (u32*)malloc_t(sizeof(u32) * model_get_lod_index_bound(list.index_count) + 4, 4);
+            u32 *simplified = (u32*)malloc_t(sizeof(u32) * list.index_count, 4);
+
+            u32   lod_count   = 0;
+            u32   index_count = 0;
+            u32   prev_count  = list.index_count;
+            float error       = 0;
+            float lod_error;
+            u32   count;
+            while(lod_count < MODEL_LOD_COUNT) {
+                count = mesh_simplify(simplified, list.indices, list.index_count, positions, position_stride,
+                                      list.vertex_count, stream_count, streams, prev_count / 6 * 3,
+                                      MODEL_LOD_MAX_ERROR, flags, &lod_error);
+                if (!count || count > prev_count / 4 * 3)
+                    break;
+
+                mesh_optimize_vertex_cache(indices + index_count, simplified, count, list.vertex_count,
+                                           MESH_VERTEX_CACHE_SIZE);
+
+                error = lod_error > error ? lod_error : error;
+                lods[lod_count++] = {.index_offset = index_count, .index_count = count, .error = error};
+
+                index_count += count;
+                prev_count   = count;
+            }
 
-            // Attributes
-            for(u32 k = 0; k < primitive->attribute_count; ++k) {
+            if (!lod_count) {
+                reset_to_mark_temp(mark);
+                continue;
+            }
+
+            u64 req_size = model_get_lods_size(lod_count, index_count);
+            assert(size_used + req_size <= size && "Lods outgrew the bound in Model_Req_Size_Info");
+
+            u8 *data   = buffer + size_used;
+            size_used += req_size;
+
+            Mesh_Lods *ret = (Mesh_Lods*)data;
+            data          += align(sizeof(Mesh_Lods), 16);
+            ret->lods      = (Mesh_Lod*)data;
+            data          += align(sizeof(Mesh_Lod) * lod_count, 16);
+            ret->indices   = (u32*)data;
+
+            ret->count       = lod_count;
+            ret->index_count = index_count;
+            memcpy(ret->lods,    lods,    sizeof(Mesh_Lod) * lod_count);
+            memcpy(ret->indices, indices, sizeof(u32) * index_count);
+
+            primitive->lods = ret;
+
+            reset_to_mark_temp(mark);
+        }
+    }
+    return size_used;
+}
+
+                                        /* Vertex Packing */
+
+//
+// Packed vertex attributes at import (see 'Vertex Quantization' in mesh.hpp), written after everything which reads
+// the float data (optimization, meshlets and lods):
+//
+//     POSITION     float3 -> unorm16 x4, dequantized with the primitive's 'position_dequantize'
+//     NORMAL       float3 -> octahedral snorm16 x2, or snorm8 x2 with MODEL_LOAD_PACK_SNORM8_BIT
+//     TANGENT      float4 -> octahedral snorm16 x4, or snorm8 x4, with the handedness in z
+//     TEXCOORD_0   float2 -> half x2
+//
+// Every vertex buffer view is rewritten as its accessors' data back to back (other attributes and morph targets
+// are copied as they are), so only what is referenced is uploaded; a view which interleaved its attributes comes
+// out as one array per attribute. Views holding sparse or meshopt compressed data are left alone. Accessor min/max
+// stay in model space.
+//
+// Positions are quantized on a grid per mesh (its largest extent over 65534, per axis) with an offset per
+// primitive, so primitives of one mesh which meet at a border still meet after quantization.
+//
+// It is opt in (MODEL_LOAD_PACK_VERTICES_BIT), as the shaders must dequantize positions and decode normals and tangents to draw packed models.
+//
+// A vertex buffer view's data after packing, uploaded in place of the gltf view's (NULL 'data' is the gltf view),
+// or a vertex stream built by interleaving, or a view built by merging or by narrowing indices.
+struct Model_Packed_View {
+    u8  *data;
+    u64  size;
+    u32  index_size; // Of every index in the view if it was built by narrowing, else 0
+};
+
+struct Model_Pack_Ref {
+    Accessor                      *accessor;
+    Mesh_Primitive                *primitive;
+    u32                            mesh;
+    Mesh_Primitive_Attribute_Type  type; // 0 for morph target attributes, which are only copied
+};
+
+static int model_compare_pack_refs(const void *a, const void *b) {
+    const Accessor *x = ((const Model_Pack_Ref*)a)->accessor;
+    const Accessor *y = ((const Model_Pack_Ref*)b)->accessor;
+    if (x->allocation_key != y->allocation_key)
+        return x->allocation_key < y->allocation_key ? -1 : 1;
+    if (x->byte_offset != y->byte_offset)
+        return x->byte_offset < y->byte_offset ? -1 : 1;
+    return 0;
+}
+
+// The packed flags and element size for an accessor which every one of its refs uses as 'type', or its own flags
+// and size if it is not packed.
+static Accessor_Flags model_get_packed_flags(const Accessor *accessor, Mesh_Primitive_Attribute_Type type,
+                                             Model_Load_Flags flags, u32 *ret_size)
+{
+    u32  bytes = flags & MODEL_LOAD_PACK_SNORM8_BIT ? 1 : 2;
+    auto snorm = flags & MODEL_LOAD_PACK_SNORM8_BIT ? ACCESSOR_COMPONENT_TYPE_SCHAR_BIT : ACCESSOR_COMPONENT_TYPE_S16_BIT;
+
+    Accessor_Flags layout = accessor->flags & (ACCESSOR_TYPE_BITS | ACCESSOR_COMPONENT_TYPE_BITS);
+    if (layout == (ACCESSOR_COMPONENT_TYPE_FLOAT_BIT | ACCESSOR_TYPE_VEC3_BIT) &&
+        type   == MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION)
+    {
+        *ret_size = sizeof(u16) * 4;
+        return ACCESSOR_COMPONENT_TYPE_U16_BIT | ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_NORMALIZED_BIT;
+    }
+    if (layout == (ACCESSOR_COMPONENT_TYPE_FLOAT_BIT | ACCESSOR_TYPE_VEC3_BIT) &&
+        type   == MESH_PRIMITIVE_ATTRIBUTE_TYPE_NORMAL)
+    {
+        *ret_size = bytes * 2;
+        return snorm | ACCESSOR_TYPE_VEC2_BIT | ACCESSOR_NORMALIZED_BIT;
+    }
+    if (layout == (ACCESSOR_COMPONENT_TYPE_FLOAT_BIT | ACCESSOR_TYPE_VEC4_BIT) &&
+        type   == MESH_PRIMITIVE_ATTRIBUTE_TYPE_TANGENT)
+    {
+        *ret_size = bytes * 4;
+        return snorm | ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_NORMALIZED_BIT;
+    }
+    if (layout == (ACCESSOR_COMPONENT_TYPE_FLOAT_BIT | ACCESSOR_TYPE_VEC2_BIT) &&
+        type   == MESH_PRIMITIVE_ATTRIBUTE_TYPE_TEX_COORDS)
+    {
+        *ret_size = sizeof(u16) * 2;
+        return ACCESSOR_COMPONENT_TYPE_HALF_BIT | ACCESSOR_TYPE_VEC2_BIT;
+    }
+
+    *ret_size = model_accessor_get_element_size(accessor->flags);
+    return accessor->flags;
+}
+
+static void model_get_float3_bounds(const float *data, u32 stride, u64 count, float *min, float *max) {
+    const float *p;
+    for(u32 i = 0; i < 3; ++i) {
+        min[i] =  INFINITY;
+        max[i] = -INFINITY;
+    }
+    for(u64 i = 0; i < count; ++i) {
+        p = (const float*)((const u8*)data + i * stride);
+        for(u32 j = 0; j < 3; ++j) {
+            min[j] = p[j] < min[j] ? p[j] : min[j];
+            max[j] = p[j] > max[j] ? p[j] : max[j];
+        }
+    }
+}
+
+//
+// Pack the vertex attributes of every primitive of 'model' into 'packed_views' (one per gltf buffer view, from
+// temp). Returns the bytes of vertex data which the packed views replaced, and their packed size in
+// 'ret_packed_size'.
+//
+static u64 model_pack_vertices(Model *model, Gltf *gltf, u8 *const *buffers, Model_Load_Flags flags,
+                               Model_Packed_View *packed_views, u64 *ret_packed_size)
+{
+    u32 view_count = gltf_buffer_view_get_count(gltf);
+    memset(packed_views, 0, sizeof(Model_Packed_View) * view_count);
+
+    Mesh_Primitive *primitive;
+    u32 ref_count = 0;
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive  = &model->meshes[i].primitives[j];
+            ref_count += primitive->attribute_count;
+            for(u32 k = 0; k < primitive->target_count; ++k)
+                ref_count += primitive->targets[k].attribute_count;
+        }
+    }
+
+    Model_Pack_Ref *refs  = (Model_Pack_Ref*)malloc_t(sizeof(Model_Pack_Ref) * ref_count, 8);
+    float          *steps = (float*)malloc_t(sizeof(float) * 3 * model->mesh_count, 4);
+
+    // Every vertex accessor, and each mesh's position grid.
+    const float *positions;
+    u32   position_stride;
+    float min[3], max[3];
+    u32   ref = 0;
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        steps[i * 3 + 0] = 0;
+        steps[i * 3 + 1] = 0;
+        steps[i * 3 + 2] = 0;
+
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive = &model->meshes[i].primitives[j];
+
+            for(u32 k = 0; k < primitive->attribute_count; ++k)
+                refs[ref++] = {&primitive->attributes[k].accessor, primitive, i, primitive->attributes[k].type};
+            for(u32 k = 0; k < primitive->target_count; ++k)
+                for(u32 l = 0; l < primitive->targets[k].attribute_count; ++l)
+                    refs[ref++] = {&primitive->targets[k].attributes[l].accessor, primitive, i,
+                                   (Mesh_Primitive_Attribute_Type)0};
+
+            for(u32 k = 0; k < primitive->attribute_count; ++k) {
+                if (primitive->attributes[k].type != MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION)
+                    continue;
+
+                positions = model_get_float_attribute(gltf, buffers, primitive, MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION,
+                                                      ACCESSOR_TYPE_VEC3_BIT, &position_stride);
+                if (!positions)
+                    break;
+
+                model_get_float3_bounds(positions, position_stride, primitive->attributes[k].accessor.count, min, max);
+                for(u32 l = 0; l < 3; ++l)
+                    steps[i * 3 + l] = fmaxf(steps[i * 3 + l], (max[l] - min[l]) / (Max_u16 - 1));
+                break;
+            }
+        }
+    }
+    qsort(refs, ref_count, sizeof(Model_Pack_Ref), model_compare_pack_refs);
+
+    u64 size_before = 0;
+    u64 size_after  = 0;
+
+    u32 view;
+    u32 view_begin;
+    u32 view_end;
+    u32 group_end;
+    u32 element_size;
+    u64 view_size;
+    bool packable;
+    Accessor_Flags packed_flags;
+    Mesh_Primitive_Attribute_Type type;
+    const Gltf_Buffer_View *gltf_view;
+    const Accessor *accessor;
+    const u8 *src;
+    u8 *dst;
+    Vertex_Dequantize dequantize;
+    for(view_begin = 0; view_begin < ref_count; view_begin = view_end) {
+        view = refs[view_begin].accessor->allocation_key;
+        for(view_end = view_begin + 1; view_end < ref_count && refs[view_end].accessor->allocation_key == view;
+            ++view_end);
+
+        packable = view != Max_u32;
+        for(u32 i = view_begin; i < view_end && packable; ++i)
+            packable = model_get_accessor_data(gltf, buffers, refs[i].accessor) != NULL;
+        if (!packable)
+            continue;
+
+        // Two passes over the view's accessors: size it, then write it. Refs to the same data (the same offset,
+        // since they are sorted) are one accessor, which is only packed if every ref uses it as the same type.
+        u8 *data = NULL;
+        for(u32 pass = 0; pass < 2; ++pass) {
+            view_size = 0;
+            for(u32 i = view_begin; i < view_end; i = group_end) {
+                accessor = refs[i].accessor;
+                type     = refs[i].type;
+                for(group_end = i + 1; group_end < view_end &&
+                    refs[group_end].accessor->byte_offset == accessor->byte_offset; ++group_end)
+                {
+                    type = refs[group_end].type == type ? type : (Mesh_Primitive_Attribute_Type)0;
+                }
+
+                packed_flags = model_get_packed_flags(accessor, type, flags, &element_size);
+                view_size    = align(view_size, 4);
+
+                if (pass == 1) {
+                    src = model_get_accessor_data(gltf, buffers, accessor);
+                    dst = data + view_size;
+
+                    if (packed_flags == accessor->flags) {
+                        for(u64 j = 0; j < accessor->count; ++j)
+                            memcpy(dst + j * element_size, src + j * accessor->byte_stride, element_size);
+                    } else if (type == MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION) {
+                        model_get_float3_bounds((const float*)src, accessor->byte_stride, accessor->count, min, max);
+                        dequantize = mesh_get_position_dequantize(min, max, &steps[refs[i].mesh * 3]);
+                        mesh_quantize_positions((u16*)dst, (const float*)src, accessor->byte_stride, accessor->count,
+                                                &dequantize);
+                        for(u32 j = i; j < group_end; ++j)
+                            refs[j].primitive->position_dequantize = dequantize;
+                    } else if (type == MESH_PRIMITIVE_ATTRIBUTE_TYPE_NORMAL) {
+                        mesh_encode_normals_octahedral(dst, element_size * 4, (const float*)src, accessor->byte_stride,
+                                                       accessor->count);
+                    } else if (type == MESH_PRIMITIVE_ATTRIBUTE_TYPE_TANGENT) {
+                        mesh_encode_tangents_octahedral(dst, element_size * 2, (const float*)src,
+                                                        accessor->byte_stride, accessor->count);
+                    } else {
+                        mesh_encode_half((u16*)dst, (const float*)src, accessor->byte_stride, 2, accessor->count);
+                    }
+
+                    // 'accessor' is refs[i]'s, so it is updated last.
+                    for(u32 j = group_end; j-- > i;) {
+                        refs[j].accessor->flags       = packed_flags;
+                        refs[j].accessor->byte_offset = view_size;
+                        refs[j].accessor->byte_stride = element_size;
+                    }
+                }
+                view_size += element_size * accessor->count;
+            }
+            if (pass == 0)
+                data = (u8*)malloc_t(view_size ? view_size : 1, 16);
+        }
+
+        gltf_view = gltf_buffer_view_by_index(gltf, view);
+        size_before += gltf_view->byte_length;
+        size_after  += view_size;
+
+        packed_views[view].data = data;
+        packed_views[view].size = view_size;
+    }
+
+    *ret_packed_size = size_after;
+    return size_before;
+}
+
+                                    /* Vertex Interleaving */
+
+//
+// With MODEL_LOAD_INTERLEAVE_VERTICES_BIT, each primitive's attributes are copied into one vertex stream at import,
+// in attribute order with every element aligned to 4 bytes. So a primitive is one vertex allocation and one binding
+// (Pl_Primitive_Info::offsets) rather than one of each per attribute, and a vertex is fetched from one place. Its
+// positions are also copied on their own to a second stream ('position_stream_key'), as a pass which only needs
+// positions would otherwise fetch every attribute to read them.
+//
+// Streams are new views after the gltf buffer views, in 'packed_views', and are built from the packed views if the
+// vertices were packed first. Primitives with the same attributes share their streams. A primitive with a sparse,
+// meshopt compressed or otherwise unreadable attribute, or attributes of different counts, is left as it is, and
+// morph targets stay separate views.
+//
+
+// An accessor's data from its packed view if it has one, else from the loaded buffers. NULL if neither can be read.
+static const u8* model_get_vertex_accessor_data(Gltf *gltf, u8 *const *buffers, const Model_Packed_View *views,
+                                                const Accessor *accessor)
+{
+    if (!accessor->sparse && accessor->allocation_key != Max_u32 && views[accessor->allocation_key].data)
+        return views[accessor->allocation_key].data + accessor->byte_offset;
+    return model_get_accessor_data(gltf, buffers, accessor);
+}
+
+struct Model_Interleave_Ref {
+    u64             hash; // of the attributes
+    Mesh_Primitive *primitive;
+};
+
+static int model_compare_interleave_refs(const void *a, const void *b) {
+    u64 x = ((const Model_Interleave_Ref*)a)->hash;
+    u64 y = ((const Model_Interleave_Ref*)b)->hash;
+    return x < y ? -1 : x > y;
+}
+
+static bool model_attributes_equal(const Mesh_Primitive *a, const Mesh_Primitive *b) {
+    if (a->attribute_count != b->attribute_count)
+        return false;
+
+    const Accessor *x, *y;
+    for(u32 i = 0; i < a->attribute_count; ++i) {
+        x = &a->attributes[i].accessor;
+        y = &b->attributes[i].accessor;
+        if (a->attributes[i].type != b->attributes[i].type || x->flags       != y->flags       ||
+            x->allocation_key     != y->allocation_key     || x->byte_offset != y->byte_offset ||
+            x->byte_stride        != y->byte_stride        || x->count       != y->count)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Write a primitive's streams to 'views[view]' (and 'views[view + 1]' if it has positions), and point its
+// attributes at them. Returns the count of views written.
+static u32 model_interleave_primitive(Gltf *gltf, u8 *const *buffers, Model_Packed_View *views,
+                                      Mesh_Primitive *primitive, u32 view)
+{
+    u32 attribute_count = primitive->attribute_count;
+    u64 vertex_count    = primitive->attributes[0].accessor.count;
+
+    u32 *offsets = (u32*)malloc_t(sizeof(u32) * attribute_count, 4);
+    u32 *sizes   = (u32*)malloc_t(sizeof(u32) * attribute_count, 4);
+    u32  stride  = 0;
+    u32  position_attribute = Max_u32;
+    for(u32 i = 0; i < attribute_count; ++i) {
+        sizes[i]   = model_accessor_get_element_size(primitive->attributes[i].accessor.flags);
+        offsets[i] = stride;
+        stride    += align(sizes[i], 4);
+
+        if (primitive->attributes[i].type == MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION)
+            position_attribute = i;
+    }
+
+    u8 *data = (u8*)malloc_t(stride * vertex_count, 16);
+    const Accessor *accessor;
+    const u8 *src;
+    for(u32 i = 0; i < attribute_count; ++i) {
+        accessor = &primitive->attributes[i].accessor;
+        src      = model_get_vertex_accessor_data(gltf, buffers, views, accessor);
+        for(u64 j = 0; j < vertex_count; ++j)
+            memcpy(data + j * stride + offsets[i], src + j * accessor->byte_stride, sizes[i]);
+    }
+    views[view].data = data;
+    views[view].size = stride * vertex_count;
+
+    u32 ret = 1;
+    if (position_attribute != Max_u32) {
+        u32 position_size = sizes[position_attribute];
+        u8 *positions     = (u8*)malloc_t(position_size * vertex_count, 16);
+        for(u64 j = 0; j < vertex_count; ++j)
+            memcpy(positions + j * position_size, data + j * stride + offsets[position_attribute], position_size);
+
+        views[view + 1].data = positions;
+        views[view + 1].size = position_size * vertex_count;
+
+        primitive->position_stream_key = view + 1;
+        ret = 2;
+    }
+
+    for(u32 i = 0; i < attribute_count; ++i) {
+        primitive->attributes[i].accessor.allocation_key = view;
+        primitive->attributes[i].accessor.byte_offset    = offsets[i];
+        primitive->attributes[i].accessor.byte_stride    = stride;
+    }
+    return ret;
+}
+
+//
+// Interleave the vertices of every primitive of 'model' which can be (see above) into new views in 'packed_views',
+// from the gltf view count up (it needs room for two per primitive). Returns the view count after the new views,
+// and the count of primitives interleaved in 'ret_primitive_count'.
+//
+static u32 model_interleave_vertices(Model *model, Gltf *gltf, u8 *const *buffers, Model_Packed_View *packed_views,
+                                     u32 *ret_primitive_count)
+{
+    u32 view_count = gltf_buffer_view_get_count(gltf);
+
+    u32 primitive_count = 0;
+    for(u32 i = 0; i < model->mesh_count; ++i)
+        primitive_count += model->meshes[i].primitive_count;
+
+    Model_Interleave_Ref *refs = (Model_Interleave_Ref*)malloc_t(sizeof(Model_Interleave_Ref) * primitive_count, 8);
+    u32 ref_count = 0;
+
+    Mesh_Primitive *primitive;
+    const Accessor *accessor;
+    bool interleavable;
+    u64  hash;
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive = &model->meshes[i].primitives[j];
+
+            interleavable = primitive->attribute_count > 0;
+            hash          = primitive->attribute_count;
+            for(u32 k = 0; k < primitive->attribute_count && interleavable; ++k) {
+                accessor       = &primitive->attributes[k].accessor;
+                interleavable  = accessor->count == primitive->attributes[0].accessor.count;
+                interleavable &= model_get_vertex_accessor_data(gltf, buffers, packed_views, accessor) != NULL;
+
+                u64 key[3] = {accessor->allocation_key | ((u64)primitive->attributes[k].type << 32),
+                              accessor->byte_offset, accessor->count};
+                hash = hash_bytes(key, sizeof(key), hash);
+            }
+            if (interleavable)
+                refs[ref_count++] = {hash, primitive};
+        }
+    }
+    qsort(refs, ref_count, sizeof(Model_Interleave_Ref), model_compare_interleave_refs);
+
+    // Primitives with the same attributes sort next to each other, and take the first one's streams. Whether they
+    // match is decided before the first one is interleaved, as that rewrites its attributes.
+    bool *shares = (bool*)malloc_t(sizeof(bool) * ref_count, 1);
+    u32 view = view_count;
+    u32 run_end;
+    for(u32 i = 0; i < ref_count; i = run_end) {
+        for(run_end = i + 1; run_end < ref_count && refs[run_end].hash == refs[i].hash; ++run_end)
+            shares[run_end] = model_attributes_equal(refs[run_end].primitive, refs[i].primitive);
+
+        view += model_interleave_primitive(gltf, buffers, packed_views, refs[i].primitive, view);
+
+        for(u32 j = i + 1; j < run_end; ++j) {
+            primitive = refs[j].primitive;
+            if (!shares[j]) {
+                view += model_interleave_primitive(gltf, buffers, packed_views, primitive, view);
+                continue;
+            }
+            for(u32 k = 0; k < primitive->attribute_count; ++k)
+                primitive->attributes[k].accessor = refs[i].primitive->attributes[k].accessor;
+            primitive->position_stream_key = refs[i].primitive->position_stream_key;
+        }
+    }
+
+    *ret_primitive_count = ref_count;
+    return view;
+}
+
+                                    /* Buffer View Merging */
+
+//
+// With MODEL_LOAD_MERGE_VIEWS_BIT, the data which a primitive's vertex accessors (attributes, then morph targets)
+// reference is copied into one new view. Its indices are one accessor, so already one view, and go to the other
+// allocator anyway. So a primitive is one index allocation and one vertex allocation (plus its position stream if
+// it was interleaved) however the gltf spread it over buffer views, which is fewer allocations to queue, stage and
+// copy, and bytes which no accessor references are not uploaded. It runs after packing and interleaving, and copies
+// from their views.
+//
+// Only the referenced ranges of each view are copied: overlapping ranges are copied once, and each range starts on
+// the 16 byte boundary at or below it in its view so that accessors keep their alignment. Ranges are laid out in the
+// order that the accessors first use them, so an interleaved stream stays at the start of the view (where
+// Pl_Primitive_Info::offsets expect it). Primitives which reference the same ranges share the merged view.
+//
+// A primitive with a sparse or unreadable vertex accessor, or whose vertex accessors are all in one view already,
+// keeps its views.
+//
+
+// A view's data and size, from 'views' if it was built at import, else from the loaded buffers. NULL if it cannot
+// be read (meshopt compressed, or its buffer was not loaded).
+static const u8* model_get_view_data(Gltf *gltf, u8 *const *buffers, const Model_Packed_View *views, u32 view,
+                                     u64 *ret_size)
+{
+    if (views[view].data) {
+        *ret_size = views[view].size;
+        return views[view].data;
+    }
+
+    const Gltf_Buffer_View *gltf_view = gltf_buffer_view_by_index(gltf, view);
+    if (gltf_view->meshopt.mode != GLTF_MESHOPT_MODE_NONE || !buffers[gltf_view->buffer])
+        return NULL;
+
+    *ret_size = gltf_view->byte_length;
+    return buffers[gltf_view->buffer] + gltf_view->byte_offset;
+}
+
+struct Model_Merge_Span {
+    u32 view;
+    u64 begin;  // in 'view'
+    u64 end;
+    u64 offset; // in the merged view
+};
+
+struct Model_Merge_Ref {
+    u64               hash; // of the spans
+    Accessor        **accessors;
+    u32               accessor_count;
+    u32               span_count;
+    Model_Merge_Span *spans; // sorted by view then begin
+    u64               size;  // of the merged view
+};
+
+static int model_compare_merge_spans(const void *a, const void *b) {
+    const Model_Merge_Span *x = (const Model_Merge_Span*)a;
+    const Model_Merge_Span *y = (const Model_Merge_Span*)b;
+    if (x->view != y->view)
+        return x->view < y->view ? -1 : 1;
+    return x->begin < y->begin ? -1 : x->begin > y->begin;
+}
+
+static int model_compare_merge_refs(const void *a, const void *b) {
+    u64 x = ((const Model_Merge_Ref*)a)->hash;
+    u64 y = ((const Model_Merge_Ref*)b)->hash;
+    return x < y ? -1 : x > y;
+}
+
+static bool model_merge_spans_equal(const Model_Merge_Ref *a, const Model_Merge_Ref *b) {
+    if (a->span_count != b->span_count)
+        return false;
+    for(u32 i = 0; i < a->span_count; ++i)
+        if (a->spans[i].view != b->spans[i].view || a->spans[i].begin != b->spans[i].begin ||
+            a->spans[i].end  != b->spans[i].end)
+        {
+            return false;
+        }
+    return true;
+}
+
+// The span of 'spans' which holds an accessor's first byte.
+static const Model_Merge_Span* model_find_merge_span(u32 span_count, const Model_Merge_Span *spans,
+                                                     const Accessor *accessor)
+{
+    for(u32 i = 0; i < span_count; ++i)
+        if (spans[i].view == accessor->allocation_key && spans[i].begin <= accessor->byte_offset &&
+            spans[i].end >= accessor->byte_offset)
+        {
+            return &spans[i];
+        }
+    assert(false && "Accessor is outside of its merge spans");
+    return NULL;
+}
+
+// Fill in a ref's spans, hash and size from its accessors. False if they cannot be merged (see above).
+static bool model_get_merge_spans(Gltf *gltf, u8 *const *buffers, const Model_Packed_View *views,
+                                  Model_Merge_Ref *ref)
+{
+    Model_Merge_Span *spans = (Model_Merge_Span*)malloc_t(sizeof(Model_Merge_Span) * ref->accessor_count, 8);
+
+    const Accessor *accessor;
+    u64  view_size;
+    u64  element_size;
+    u64  stride;
+    bool one_view = true;
+    for(u32 i = 0; i < ref->accessor_count; ++i) {
+        accessor = ref->accessors[i];
+        if (accessor->sparse || accessor->allocation_key == Max_u32 ||
+            !model_get_view_data(gltf, buffers, views, accessor->allocation_key, &view_size))
+        {
+            return false;
+        }
+
+        element_size = model_accessor_get_element_size(accessor->flags);
+        stride       = accessor->byte_stride ? accessor->byte_stride : element_size;
+
+        spans[i].view   = accessor->allocation_key;
+        spans[i].begin  = accessor->byte_offset & ~(u64)15;
+        spans[i].end    = accessor->byte_offset + (accessor->count ? (accessor->count - 1) * stride + element_size : 0);
+        spans[i].offset = Max_u64;
+        if (spans[i].end > view_size)
+            return false;
+
+        one_view &= spans[i].view == spans[0].view;
+    }
+    if (one_view)
+        return false;
+
+    // Join ranges which overlap or touch.
+    qsort(spans, ref->accessor_count, sizeof(Model_Merge_Span), model_compare_merge_spans);
+    u32 span_count = 1;
+    for(u32 i = 1; i < ref->accessor_count; ++i) {
+        Model_Merge_Span *last = &spans[span_count - 1];
+        if (spans[i].view == last->view && spans[i].begin <= last->end)
+            last->end = spans[i].end > last->end ? spans[i].end : last->end;
+        else
+            spans[span_count++] = spans[i];
+    }
+
+    // Lay the spans out in the order of first use.
+    u64 size = 0;
+    Model_Merge_Span *span;
+    for(u32 i = 0; i < ref->accessor_count; ++i) {
+        span = (Model_Merge_Span*)model_find_merge_span(span_count, spans, ref->accessors[i]);
+        if (span->offset != Max_u64)
+            continue;
+        span->offset = size;
+        size         = align(size + (span->end - span->begin), 16);
+    }
+
+    u64 hash = span_count;
+    for(u32 i = 0; i < span_count; ++i) {
+        u64 key[2] = {spans[i].view | (spans[i].begin << 32), spans[i].end};
+        hash = hash_bytes(key, sizeof(key), hash);
+    }
+
+    ref->hash       = hash;
+    ref->span_count = span_count;
+    ref->spans      = spans;
+    ref->size       = size;
+    return true;
+}
+
+// Point a ref's accessors at the merged view 'view', whose layout is 'spans' (a ref with the same spans).
+static void model_rebase_merged_accessors(Model_Merge_Ref *ref, const Model_Merge_Span *spans, u32 view) {
+    const Model_Merge_Span *span;
+    Accessor *accessor;
+    for(u32 i = 0; i < ref->accessor_count; ++i) {
+        accessor = ref->accessors[i];
+        span     = model_find_merge_span(ref->span_count, spans, accessor);
+
+        accessor->byte_offset    = span->offset + (accessor->byte_offset - span->begin);
+        accessor->allocation_key = view;
+    }
+}
+
+//
+// Merge the vertex views of every primitive of 'model' which can be (see above) into new views in 'packed_views',
+// from 'view_count' up (it needs room for one per primitive). Returns the view count after the new views, and the
+// count of primitives merged in 'ret_primitive_count'.
+//
+static u32 model_merge_views(Model *model, Gltf *gltf, u8 *const *buffers, Model_Packed_View *packed_views,
+                             u32 view_count, u32 *ret_primitive_count)
+{
+    u32 primitive_count = 0;
+    for(u32 i = 0; i < model->mesh_count; ++i)
+        primitive_count += model->meshes[i].primitive_count;
+
+    Model_Merge_Ref *refs = (Model_Merge_Ref*)malloc_t(sizeof(Model_Merge_Ref) * primitive_count, 8);
+    u32 ref_count = 0;
+
+    // Every ref's spans are found before any accessor is rebased.
+    Mesh_Primitive  *primitive;
+    Model_Merge_Ref *ref;
+    u32 accessor_count;
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive = &model->meshes[i].primitives[j];
+
+            accessor_count = primitive->attribute_count;
+            for(u32 k = 0; k < primitive->target_count; ++k)
+                accessor_count += primitive->targets[k].attribute_count;
+            if (!accessor_count)
+                continue;
+
+            ref = &refs[ref_count];
+            ref->accessor_count = 0;
+            ref->accessors      = (Accessor**)malloc_t(sizeof(Accessor*) * accessor_count, 8);
+            for(u32 k = 0; k < primitive->attribute_count; ++k)
+                ref->accessors[ref->accessor_count++] = &primitive->attributes[k].accessor;
+            for(u32 k = 0; k < primitive->target_count; ++k)
+                for(u32 l = 0; l < primitive->targets[k].attribute_count; ++l)
+                    ref->accessors[ref->accessor_count++] = &primitive->targets[k].attributes[l].accessor;
+
+            ref_count += model_get_merge_spans(gltf, buffers, packed_views, ref);
+        }
+    }
+    qsort(refs, ref_count, sizeof(Model_Merge_Ref), model_compare_merge_refs);
+
+    // Refs with the same spans sort next to each other (or collide on the hash), and take the view of the first
+    // equal ref.
+    u8  *data;
+    u64  view_size;
+    u32  view = view_count;
+    u32  leader;
+    const u8 *src;
+    const Model_Merge_Span *span;
+    for(u32 i = 0; i < ref_count; ++i) {
+        leader = i;
+        for(u32 j = i; j-- > 0 && refs[j].hash == refs[i].hash;)
+            if (model_merge_spans_equal(&refs[j], &refs[i]))
+                leader = j;
+
+        if (leader != i) {
+            model_rebase_merged_accessors(&refs[i], refs[leader].spans, refs[leader].accessors[0]->allocation_key);
+            continue;
+        }
+
+        data = (u8*)malloc_t(refs[i].size ? refs[i].size : 1, 16);
+        memset(data, 0, refs[i].size); // Padding, so that the same model always writes the same bytes
+        for(u32 j = 0; j < refs[i].span_count; ++j) {
+            span = &refs[i].spans[j];
+            src  = model_get_view_data(gltf, buffers, packed_views, span->view, &view_size);
+            memcpy(data + span->offset, src + span->begin, span->end - span->begin);
+        }
+        packed_views[view].data = data;
+        packed_views[view].size = refs[i].size;
+
+        model_rebase_merged_accessors(&refs[i], refs[i].spans, view);
+        view++;
+    }
+
+    *ret_primitive_count = ref_count;
+    return view;
+}
+
+                                    /* Index Narrowing */
+
+//
+// With MODEL_LOAD_NARROW_INDICES_BIT, each primitive's indices are rewritten at import as u16 if its vertices fit
+// them, rather than whatever width the gltf chose (u8 indices are widened to u16 too, as vulkan only takes u8 with
+// an extension). Primitives with more vertices stay u32: splitting them into draws over windows of 65535 vertices
+// (mesh_split_index_ranges(..)) waits on a draw path which records a draw per range. In a strip or fan the source
+// width's max is primitive restart, and stays so.
+//
+// The indices from each gltf view are written to at most two new views, one of each width, so narrowing adds no
+// allocations beyond a view holding indices of both widths. Primitives which share an accessor share its narrowed
+// indices. Sparse or unreadable indices are left alone.
+//
+// With MODEL_LOAD_COMPRESS_INDICES_BIT as well, the model cache stores these views delta and varint coded (see
+// 'Index Compression' in mesh.hpp), and decodes them as they are handed to the index allocator.
+//
+
+struct Model_Narrow_Ref {
+    Accessor               *accessor; // a primitive's indices
+    Mesh_Primitive         *primitive;
+    u32                     index_size; // after narrowing
+    u32                    *indices;    // widened
+};
+
+static int model_compare_narrow_refs(const void *a, const void *b) {
+    const Accessor *x = ((const Model_Narrow_Ref*)a)->accessor;
+    const Accessor *y = ((const Model_Narrow_Ref*)b)->accessor;
+    if (x->allocation_key != y->allocation_key)
+        return x->allocation_key < y->allocation_key ? -1 : 1;
+    if (x->byte_offset != y->byte_offset)
+        return x->byte_offset < y->byte_offset ? -1 : 1;
+    if (x->count != y->count)
+        return x->count < y->count ? -1 : 1;
+    return x->flags < y->flags ? -1 : x->flags > y->flags;
+}
+
+inline static bool model_narrow_refs_share(const Model_Narrow_Ref *a, const Model_Narrow_Ref *b) {
+    return a->accessor->allocation_key == b->accessor->allocation_key &&
+           a->accessor->byte_offset    == b->accessor->byte_offset    &&
+           a->accessor->count          == b->accessor->count          &&
+           a->accessor->flags          == b->accessor->flags;
+}
+
+// Widen a ref's indices into temp and choose their width. False if the indices cannot be read.
+static bool model_narrow_ref(Gltf *gltf, u8 *const *buffers, Model_Narrow_Ref *ref) {
+    const Accessor *accessor = ref->accessor;
+    if (accessor->sparse || accessor->allocation_key == Max_u32)
+        return false;
+
+    u32 src_size = 0;
+    src_size = accessor->flags & ACCESSOR_COMPONENT_TYPE_UCHAR_BIT ? 1 : src_size;
+    src_size = accessor->flags & ACCESSOR_COMPONENT_TYPE_U16_BIT   ? 2 : src_size;
+    src_size = accessor->flags & ACCESSOR_COMPONENT_TYPE_U32_BIT   ? 4 : src_size;
+
+    const u8 *src = model_get_accessor_data(gltf, buffers, accessor);
+    if (!src_size || !src)
+        return false;
+
+    bool strip       = ref->primitive->topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST &&
+                       ref->primitive->topology != VK_PRIMITIVE_TOPOLOGY_LINE_LIST     &&
+                       ref->primitive->topology != VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    u32  src_restart = src_size == 4 ? Max_u32 : (1u << (src_size * 8)) - 1;
+
+    u32 *indices = (u32*)malloc_t(sizeof(u32) * (accessor->count ? accessor->count : 1), 4);
+    u32  max     = 0;
+    for(u32 i = 0; i < accessor->count; ++i) {
+        switch(src_size) {
+        case 1: indices[i] = src[i];                break;
+        case 2: indices[i] = ((const u16*)src)[i]; break;
+        case 4: indices[i] = ((const u32*)src)[i]; break;
+        }
+        if (strip && indices[i] == src_restart) {
+            indices[i] = Max_u32; // narrowed below
+            continue;
+        }
+        max = indices[i] > max ? indices[i] : max;
+    }
+
+    ref->indices    = indices;
+    ref->index_size = max < Max_u16 ? 2 : 4;
+    return true;
+}
+
+//
+// Narrow the indices of every primitive of 'model' which can be (see above) into new views in 'packed_views', from
+// 'view_count' up (it needs room for two per primitive). Returns the view count after the new views.
+//
+static u32 model_narrow_indices(Model *model, Gltf *gltf, u8 *const *buffers, Model_Packed_View *packed_views,
+                                u32 view_count)
+{
+    u32 primitive_count = 0;
+    for(u32 i = 0; i < model->mesh_count; ++i)
+        primitive_count += model->meshes[i].primitive_count;
+
+    Model_Narrow_Ref *refs = (Model_Narrow_Ref*)malloc_t(sizeof(Model_Narrow_Ref) * primitive_count, 8);
+    u32 ref_count = 0;
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            refs[ref_count].primitive = &model->meshes[i].primitives[j];
+            refs[ref_count].accessor  = &model->meshes[i].primitives[j].indices;
+            refs[ref_count].indices   = NULL;
+            ref_count++;
+        }
+    }
+    qsort(refs, ref_count, sizeof(Model_Narrow_Ref), model_compare_narrow_refs);
+
+    // Refs of one accessor sort next to each other; the first narrows it for the rest. A ref which cannot be read
+    // is dropped by giving it no width.
+    for(u32 i = 0, leader = 0; i < ref_count; ++i) {
+        if (i > 0 && model_narrow_refs_share(&refs[i], &refs[leader])) {
+            refs[i].index_size = refs[leader].index_size;
+            refs[i].indices    = refs[leader].indices;
+            continue;
+        }
+        leader = i;
+
+        if (!model_narrow_ref(gltf, buffers, &refs[i]))
+            refs[i].index_size = 0;
+    }
+
+    // The narrowed indices of each gltf view, u16 then u32, back to back (4 byte aligned) in a new view per width.
+    // Shared accessors are written once, and their refs take the first one's offset.
+    u32 view = view_count;
+    u32 run_end;
+    u32 gltf_view;
+    u64 view_size;
+    u64 *offsets = (u64*)malloc_t(sizeof(u64) * (ref_count ? ref_count : 1), 8);
+    for(u32 i = 0; i < ref_count; i = run_end) {
+        gltf_view = refs[i].accessor->allocation_key;
+        for(run_end = i + 1; run_end < ref_count && refs[run_end].accessor->allocation_key == gltf_view; ++run_end);
+
+        for(u32 index_size = 2; index_size <= 4; index_size += 2) {
+            view_size = 0;
+            for(u32 j = i; j < run_end; ++j) {
+                if (refs[j].index_size != index_size)
+                    continue;
+                if (j > i && refs[j].indices == refs[j - 1].indices) {
+                    offsets[j] = offsets[j - 1];
+                    continue;
+                }
+                offsets[j] = view_size;
+                view_size  = align(view_size + (u64)refs[j].accessor->count * index_size, 4);
+            }
+            if (!view_size)
+                continue;
+
+            u8 *data = (u8*)malloc_t(view_size, 16);
+            memset(data, 0, view_size); // Padding, so that the same model always writes the same bytes
+            for(u32 j = i; j < run_end; ++j) {
+                if (refs[j].index_size != index_size)
+                    continue;
+                if (j == i || refs[j].indices != refs[j - 1].indices) {
+                    for(u32 k = 0; k < refs[j].accessor->count; ++k) {
+                        if (index_size == 2)
+                            ((u16*)(data + offsets[j]))[k] = (u16)refs[j].indices[k]; // restart: Max_u32 -> Max_u16
+                        else
+                            ((u32*)(data + offsets[j]))[k] = refs[j].indices[k];
+                    }
+                }
+
+                Accessor *accessor = refs[j].accessor;
+                accessor->flags          = (accessor->flags & ~ACCESSOR_COMPONENT_TYPE_BITS) |
+                                           (index_size == 2 ? ACCESSOR_COMPONENT_TYPE_U16_BIT :
+                                                              ACCESSOR_COMPONENT_TYPE_U32_BIT);
+                accessor->allocation_key = view;
+                accessor->byte_offset    = offsets[j];
+                accessor->byte_stride    = index_size;
+            }
+            packed_views[view].data       = data;
+            packed_views[view].size       = view_size;
+            packed_views[view].index_size = index_size;
+            view++;
+        }
+    }
+
+    return view;
+}
+
+// Every attribute in one allocation at one stride, and within the first stride of it, so that the vertex input can
+// read them all through one binding at the start of the allocation.
+static bool model_primitive_is_interleaved(const Mesh_Primitive *primitive) {
+    if (primitive->attribute_count == 0)
+        return false;
+
+    const Accessor *first = &primitive->attributes[0].accessor;
+    const Accessor *accessor;
+    for(u32 i = 0; i < primitive->attribute_count; ++i) {
+        accessor = &primitive->attributes[i].accessor;
+        if (accessor->sparse || accessor->allocation_key != first->allocation_key ||
+            accessor->byte_stride != first->byte_stride || accessor->byte_offset >= first->byte_stride)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Accessors which share a gltf accessor share its sparse data, so each sparse is only given keys once ('done'
+// holds the offsets from the model of the ones which have been).
+static void model_set_sparse_allocation_keys(const Model *model, Accessor_Sparse *sparse, const u32 *allocation_keys,
+                                             Array<u32> *done)
+{
+    u32 offset = (u32)((u8*)sparse - (u8*)model->meshes);
+    for(u32 i = 0; i < done->len; ++i)
+        if (done->data[i] == offset)
+            return;
+    array_add(done, offset);
+
+    sparse->indices_allocation_key = allocation_keys[sparse->indices_allocation_key];
+    sparse->values_allocation_key  = allocation_keys[sparse->values_allocation_key];
+}
+
+// Replace the gltf buffer view, image and sampler indices in a model's accessors and materials with the keys which
+// the model allocators returned for them.
+static void model_set_allocation_keys(Model *model, const u32 *allocation_keys, const u32 *tex_allocation_keys,
+                                      const u32 *sampler_keys)
+{
+    Mesh_Primitive *primitive;
+    Accessor       *accessor;
+    u32             last_vertex_key; // An accessor in the same allocation as the one before it adds no key
+
+    Array<u32> sparse_done = new_array<u32>(16, true, true);
+    for(u32 i = 0; i < model->mesh_count; ++i) {
+        for(u32 j = 0; j < model->meshes[i].primitive_count; ++j) {
+            primitive = &model->meshes[i].primitives[j];
+
+            // Indices
+            primitive->indices.allocation_key = allocation_keys[primitive->indices.allocation_key];
+            primitive->key_counts.index++;
+
+                                                    /* Material */
+            // Base Color
+            primitive->material.pbr.base_color_texture.texture_key = tex_allocation_keys[primitive->material.pbr.base_color_texture.texture_key];
+            primitive->material.pbr.base_color_texture.sampler_key = sampler_keys       [primitive->material.pbr.base_color_texture.sampler_key];
+
+            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_BASE_BIT) > 0;
+            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_BASE_BIT) > 0;
+
+            // Metallic Roughness
+            primitive->material.pbr.metallic_roughness_texture.texture_key = tex_allocation_keys[primitive->material.pbr.metallic_roughness_texture.texture_key];
+            primitive->material.pbr.metallic_roughness_texture.sampler_key = sampler_keys       [primitive->material.pbr.metallic_roughness_texture.sampler_key];
+
+            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_PBR_BIT) > 0;
+            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_PBR_BIT) > 0;
+
+            // Normal
+            primitive->material.normal.texture.texture_key = tex_allocation_keys[primitive->material.normal.texture.texture_key];
+            primitive->material.normal.texture.sampler_key = sampler_keys       [primitive->material.normal.texture.sampler_key];
+
+            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_NORMAL_BIT) > 0;
+            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_NORMAL_BIT) > 0;
+
+            // Occlusion
+            primitive->material.occlusion.texture.texture_key = tex_allocation_keys[primitive->material.occlusion.texture.texture_key];
+            primitive->material.occlusion.texture.sampler_key = sampler_keys       [primitive->material.occlusion.texture.sampler_key];
+
+            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_OCCLUSION_BIT) > 0;
+            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_OCCLUSION_BIT) > 0;
+
+            // Emissive
+            primitive->material.emissive.texture.texture_key  = tex_allocation_keys[primitive->material.emissive.texture.texture_key];
+            primitive->material.emissive.texture.sampler_key  = sampler_keys       [primitive->material.emissive.texture.sampler_key];
+
+            primitive->key_counts.tex     += (primitive->material.flags & MATERIAL_EMISSIVE_BIT) > 0;
+            primitive->key_counts.sampler += (primitive->material.flags & MATERIAL_EMISSIVE_BIT) > 0;
+
+            // Attributes
+            last_vertex_key = Max_u32;
+            for(u32 k = 0; k < primitive->attribute_count; ++k) {
                 accessor = &primitive->attributes[k].accessor;
 
-                accessor->allocation_key = allocation_keys[accessor->allocation_key];
-                primitive->key_counts.vertex++;
+                accessor->allocation_key = allocation_keys[accessor->allocation_key];
+                primitive->key_counts.vertex += accessor->allocation_key != last_vertex_key;
+                last_vertex_key               = accessor->allocation_key;
+
+                if (accessor->sparse) {
+                    model_set_sparse_allocation_keys(model, accessor->sparse, allocation_keys, &sparse_done);
+
+                    primitive->key_counts.index++;
+                    primitive->key_counts.vertex++;
+                }
+            }
+
+            if (primitive->position_stream_key != Max_u32) {
+                primitive->position_stream_key = allocation_keys[primitive->position_stream_key];
+                primitive->key_counts.vertex++;
+            }
+
+            // Targets
+            for(u32 k = 0; k < primitive->target_count; ++k) {
+                for(u32 l = 0; l < primitive->targets[k].attribute_count; ++l) {
+                    accessor = &primitive->targets[k].attributes[l].accessor;
+
+                    accessor->allocation_key = allocation_keys[accessor->allocation_key];
+                    primitive->key_counts.vertex += accessor->allocation_key != last_vertex_key;
+                    last_vertex_key               = accessor->allocation_key;
+
+                    if (accessor->sparse) {
+                        model_set_sparse_allocation_keys(model, accessor->sparse, allocation_keys, &sparse_done);
+
+                        primitive->key_counts.index++;
+                        primitive->key_counts.vertex++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// What store_model(..) needs from model_load_gltf(..), taken before the gltf indices in the model are replaced
+// by allocation keys.
+struct Model_Cache_Store_Info {
+    u64          source_hash; // See model_get_source_hash(..)
+    const Model *model;
+    u64          model_size;  // Bytes from model->meshes which the model uses in the model buffer
+
+    Gltf        *gltf;
+    u8 *const   *buffers;     // Indexed by gltf buffer
+    const Model_Packed_View *packed_views; // Indexed by view, NULL if no vertex data was built at import
+    Model_Load_Flags         load_flags;
+    u32          view_count;  // Gltf buffer views, then any vertex streams and merged views built at import
+    u32          index_view_count;
+    const u32   *index_views; // View indices
+    u32          vertex_view_count;
+    const u32   *vertex_views;
+
+    u32                      image_count;
+    char *const             *image_file_names;
+    u32                      sampler_count;
+    const Get_Sampler_Info  *sampler_infos;
+};
+static bool store_model(const char *cache_file_name, const Model_Cache_Store_Info *info);
+
+// Hash of what a cached model is built from: the gltf text, and the size and modification time of each buffer
+// which it references by uri (reading them would cost what the cache saves). Parses the gltf's buffers.
+static u64 model_get_source_hash(Gltf *gltf, const String *model_dir) {
+    u64 hash = hash_bytes((void*)gltf->data, gltf->data_size);
+
+    char uri_buf[127];
+    memcpy(uri_buf, model_dir->str, model_dir->len);
+
+    struct stat buffer_stat;
+    u64 key[2];
+    u32 buffer_count = gltf_buffer_get_count(gltf);
+    const Gltf_Buffer *gltf_buffer = gltf->buffers;
+    for(u32 i = 0; i < buffer_count; ++i) {
+        if (gltf_buffer->uri && !gltf_buffer->base64) {
+            key[0] = Max_u64;
+            key[1] = Max_u64;
+            if (model_dir->len + strlen(gltf_buffer->uri) < sizeof(uri_buf)) {
+                strcpy(uri_buf + model_dir->len, gltf_buffer->uri);
+                if (stat(uri_buf, &buffer_stat) == 0) {
+                    key[0] = (u64)buffer_stat.st_size;
+                    key[1] = (u64)buffer_stat.st_mtime;
+                }
+            }
+            hash = hash_bytes(key, sizeof(key), hash);
+        }
+        gltf_buffer = (const Gltf_Buffer*)((u8*)gltf_buffer + gltf_buffer->stride);
+    }
+    return hash;
+}
+
+static const char *MODEL_IMAGE_CACHE_DIR = "image-cache/"; // Decoded embedded images, see the texture allocations
+
+//
+// @Note This implementation looks a little weird, as lots of sections seem naively split apart (for
+// instance, the gltf struct is looped a few different times) but this is intentional, as it is being
+// split into jobs for threading: reading the gltf struct into the model struct already is (see
+// model_convert_gltfs(..)), dispatching work to the allocators is not yet.
+//
+// @Todo Skins, Animations, Cameras.
+//
+// 'gltf' is '<model_dir><gltf_file_name>', already parsed (lazily or not, into temp or a Gltf_Document): the file
+// name only names the model in messages. Sections touched here which were not parsed yet are parsed into the gltf's
+// arena, so a lazy gltf in temp must not be touched after this returns, as its new sections are reset with the rest.
+//
+// If 'cache_file_name' is not NULL, the model is also written there for load_model(..).
+static Model model_load_parsed_gltf(Model_Allocators *model_allocators, const String *model_dir,
+                                    const String *gltf_file_name, Gltf *gltf, u64 size_available, u8 *model_buffer,
+                                    u64 *ret_req_size, const char *cache_file_name, Model_Load_Flags flags)
+{
+    u64 temp_allocator_mark = get_mark_temp(); // Reset to mark at end of function
+
+    char uri_buf[127];
+    memcpy(uri_buf, model_dir->str, model_dir->len);
+
+    // Get required bytes
+    Model_Req_Size_Info req_size = model_get_required_size_from_gltf(gltf, flags);
+
+    #if MODEL_LOAD_INFO
+    println("Size required for model %s: %u, Bytes remaining in buffer: %u", gltf_file_name->str, req_size.total, size_available);
+    #endif
+
+    *ret_req_size = req_size.total;
+    if (req_size.total > size_available) {
+
+        #if !MODEL_LOAD_INFO
+        println("Size required for model %s: %u, Bytes remaining in buffer: %u", gltf_file_name->str, req_size.total, size_available);
+        #endif
+
+        println("Insufficient size remaining in model buffer. Failed to load models.");
+        assert(false && "See above...");
+
+        return {};
+    }
+
+    Model ret = {};
+    ret.mesh_count = gltf_mesh_get_count(gltf);
+
+    // model_buffer layout: (@Todo This will change when I add skins, animations, etc.)
+    // | meshes | primitives | extra primitive data | extra accessor data | mesh weights | meshlets | lods |
+
+    u32 buffer_offset_primitives    = align(sizeof(Mesh) * ret.mesh_count, 16);
+    u32 buffer_offset_accessor_data = buffer_offset_primitives    + req_size.primitives;
+    u32 buffer_offset_weights       = buffer_offset_accessor_data + req_size.accessors;
+
+    // Accessors, textures, materials and meshes are converted as jobs (see model_convert_gltfs(..)).
+    Model_Gltf_Conversion conversion;
+    model_begin_gltf_conversion(gltf, model_buffer, buffer_offset_primitives, buffer_offset_accessor_data,
+                                buffer_offset_weights, &conversion);
+    model_convert_gltfs(1, &conversion);
+    ret.meshes = conversion.meshes;
+
+    u32 model_dir_len = model_dir->len;
+
+    // Load every buffer. Buffers which are only a meshopt fallback (EXT_meshopt_compression) may have no data
+    // at all, and nothing should reference them except through a compressed view, so they are left NULL.
+    u32 buffer_count = gltf_buffer_get_count(gltf);
+    u8 **buffers     = (u8**)malloc_t(sizeof(u8*) * buffer_count);
+
+    const Gltf_Buffer *gltf_buffer = gltf->buffers;
+    for(u32 i = 0; i < buffer_count; ++i) {
+        if (gltf_buffer->base64) {
+            // Embedded buffer: decode straight from the file text into the buffer the allocations copy from.
+            buffers[i] = (u8*)malloc_t(gltf_buffer->byte_length, 8);
+            if (!gltf_buffer_decode_base64(gltf_buffer, buffers[i])) {
+                println("Gltf %s buffer %u is not valid base64 of its byteLength. Failed to load model.",
+                        gltf_file_name->str, i);
+                assert(false && "See above...");
+
+                reset_to_mark_temp(temp_allocator_mark);
+                return {};
+            }
+        } else if (gltf_buffer->uri) {
+            strcpy(uri_buf + model_dir_len, gltf_buffer->uri); // Build the buffer uri.
+            buffers[i] = (u8*)file_read_bin_temp_large(uri_buf, gltf_buffer->byte_length);
+        } else {
+            assert(gltf_buffer->meshopt_fallback && "Gltf buffer has no data");
+            buffers[i] = NULL;
+        }
+        gltf_buffer = (const Gltf_Buffer*)((u8*)gltf_buffer + gltf_buffer->stride);
+    }
+
+    if (MODEL_OPTIMIZE_MESHES) {
+        Vertex_Cache_Stats cache_before;
+        Vertex_Cache_Stats cache_after;
+        model_optimize_meshes(&ret, gltf, buffers, &cache_before, &cache_after);
+
+        #if MODEL_LOAD_INFO
+        println("Vertex cache for model %s (%u triangles): acmr %f -> %f, atvr %f -> %f", gltf_file_name->str,
+                cache_before.triangle_count, cache_before.acmr, cache_after.acmr, cache_before.atvr, cache_after.atvr);
+        #endif
+    }
+
+    // Everything before the meshlets is a fixed size, so the model's real size is only known here.
+    ret.size = buffer_offset_weights + req_size.weights;
+    if (req_size.meshlets) {
+        u64 buffer_offset_meshlets = align(ret.size, 16);
+        ret.size = buffer_offset_meshlets + model_build_meshlets(&ret, gltf, buffers,
+                                                                 model_buffer + buffer_offset_meshlets,
+                                                                 req_size.meshlets);
+    }
+    if (req_size.lods) {
+        u64 buffer_offset_lods = align(ret.size, 16);
+        ret.size = buffer_offset_lods + model_build_lods(&ret, gltf, buffers, model_buffer + buffer_offset_lods,
+                                                         req_size.lods);
+    }
+    *ret_req_size = ret.size;
+
+    // Vertex data built at import replaces gltf buffer views (packing), or is new views after them (interleaving,
+    // merging), as are narrowed indices.
+    u32 buffer_view_count = gltf_buffer_view_get_count(gltf);
+    u32 view_count        = buffer_view_count;
+
+    Model_Packed_View *packed_views = NULL;
+    if (flags & (MODEL_LOAD_PACK_VERTICES_BIT | MODEL_LOAD_INTERLEAVE_VERTICES_BIT | MODEL_LOAD_MERGE_VIEWS_BIT |
+                 MODEL_LOAD_NARROW_INDICES_BIT))
+    {
+        u32 stream_cap = 0;
+        for(u32 i = 0; i < ret.mesh_count; ++i) {
+            stream_cap += flags & MODEL_LOAD_INTERLEAVE_VERTICES_BIT ? ret.meshes[i].primitive_count * 2 : 0;
+            stream_cap += flags & MODEL_LOAD_MERGE_VIEWS_BIT         ? ret.meshes[i].primitive_count     : 0;
+            stream_cap += flags & MODEL_LOAD_NARROW_INDICES_BIT      ? ret.meshes[i].primitive_count * 2 : 0;
+        }
+
+        packed_views = (Model_Packed_View*)malloc_t(sizeof(Model_Packed_View) * (buffer_view_count + stream_cap), 8);
+        memset(packed_views, 0, sizeof(Model_Packed_View) * (buffer_view_count + stream_cap));
+    }
+
+    if (flags & MODEL_LOAD_PACK_VERTICES_BIT) {
+        u64 packed_size;
+        u64 unpacked_size = model_pack_vertices(&ret, gltf, buffers, flags, packed_views, &packed_size);
+
+        #if MODEL_LOAD_INFO
+        println("Packed vertices for model %s: %u bytes -> %u bytes", gltf_file_name->str, unpacked_size, packed_size);
+        #endif
+    }
+
+    if (flags & MODEL_LOAD_INTERLEAVE_VERTICES_BIT) {
+        u32 interleaved_count;
+        view_count = model_interleave_vertices(&ret, gltf, buffers, packed_views, &interleaved_count);
+
+        #if MODEL_LOAD_INFO
+        println("Interleaved vertices for model %s: %u primitives, %u new vertex streams", gltf_file_name->str,
+                interleaved_count, view_count - buffer_view_count);
+        #endif
+    }
+
+    if (flags & MODEL_LOAD_MERGE_VIEWS_BIT) {
+        u32 merged_count;
+        u32 merged_view_count = model_merge_views(&ret, gltf, buffers, packed_views, view_count, &merged_count);
+
+        #if MODEL_LOAD_INFO
+        println("Merged buffer views for model %s: %u primitives, %u merged views", gltf_file_name->str,
+                merged_count, merged_view_count - view_count);
+        #endif
+
+        view_count = merged_view_count;
+    }
+
+    if (flags & MODEL_LOAD_NARROW_INDICES_BIT) {
+        u32 narrowed_view_count = model_narrow_indices(&ret, gltf, buffers, packed_views, view_count);
+
+        #if MODEL_LOAD_INFO
+        println("Narrowed indices for model %s: %u index views", gltf_file_name->str,
+                narrowed_view_count - view_count);
+        #endif
+
+        view_count = narrowed_view_count;
+    }
+
+    // Each referenced texture/buffer view (or vertex stream, or merged view) becomes an allocation.
+
+                                    /* Buffer View Allocations */
+    u32  index_buffer_view_count    = 0;
+    u32  vertex_buffer_view_count   = 0;
+    u32 *index_buffer_view_indices  = (u32*)malloc_t(sizeof(u32) * (view_count + 1), 8); // add_buffer_view_index(..) writes one past
+    u32 *vertex_buffer_view_indices = (u32*)malloc_t(sizeof(u32) * (view_count + 1), 8);
+
+    u32  mask_count = align(view_count, 64) >> 6;
+    u64 *masks      = (u64*)malloc_t(sizeof(u64) * mask_count, 8);
+    memset(masks, 0, sizeof(u64) * mask_count);
+
+    // Separate buffer views into vertex and index data (add_buffer_view_index() tracks dupes, branchless)
+    Mesh_Primitive *primitive;
+    Morph_Target   *target;
+    for(u32 i = 0; i < ret.mesh_count; ++i) {
+        for(u32 j = 0; j < ret.meshes[i].primitive_count; ++j) {
+            primitive = &ret.meshes[i].primitives[j];
+
+            add_buffer_view_index(primitive->indices.allocation_key, &index_buffer_view_count,
+                                  index_buffer_view_indices, mask_count, masks);
 
-                if (accessor->sparse) {
-                    accessor->sparse->indices_allocation_key = allocation_keys[accessor->sparse->indices_allocation_key];
-                    accessor->sparse->values_allocation_key  = allocation_keys[accessor->sparse->values_allocation_key];
+            if (primitive->position_stream_key != Max_u32)
+                add_buffer_view_index(primitive->position_stream_key, &vertex_buffer_view_count,
+                                      vertex_buffer_view_indices, mask_count, masks);
 
-                    primitive->key_counts.index++;
-                    primitive->key_counts.vertex++;
+            for(u32 k = 0; k < primitive->attribute_count; ++k) {
+                add_buffer_view_index(primitive->attributes[k].accessor.allocation_key, &vertex_buffer_view_count,
+                                      vertex_buffer_view_indices, mask_count, masks);
+
+                if (primitive->attributes[k].accessor.sparse) {
+                    add_buffer_view_index(primitive->attributes[k].accessor.sparse->indices_allocation_key,
+                                          &index_buffer_view_count, index_buffer_view_indices, mask_count, masks);
+                    add_buffer_view_index(primitive->attributes[k].accessor.sparse->values_allocation_key,
+                                          &vertex_buffer_view_count, vertex_buffer_view_indices, mask_count, masks);
                 }
             }
 
-            // Targets
             for(u32 k = 0; k < primitive->target_count; ++k) {
-                for(u32 l = 0; l < primitive->targets[k].attribute_count; ++l) {
-                    accessor = &primitive->targets[k].attributes[l].accessor;
+                target = &primitive->targets[k];
+                for(u32 l = 0; l < target->attribute_count; ++l) {
+                   add_buffer_view_index(target->attributes[l].accessor.allocation_key, &vertex_buffer_view_count,
+                                         vertex_buffer_view_indices, mask_count, masks);
 
-                    accessor->allocation_key = allocation_keys[accessor->allocation_key];
-                    primitive->key_counts.vertex++;
+                    if (target->attributes[l].accessor.sparse) {
+                        add_buffer_view_index(target->attributes[l].accessor.sparse->indices_allocation_key,
+                                              &index_buffer_view_count, index_buffer_view_indices, mask_count, masks);
+                        add_buffer_view_index(target->attributes[l].accessor.sparse->values_allocation_key,
+                                              &vertex_buffer_view_count, vertex_buffer_view_indices, mask_count, masks);
+                    }
 
-                    if (accessor->sparse) {
-                        accessor->sparse->indices_allocation_key = allocation_keys[accessor->sparse->indices_allocation_key];
-                        accessor->sparse->values_allocation_key  = allocation_keys[accessor->sparse->values_allocation_key];
+                }
+            }
+        }
+    }
 
-                        primitive->key_counts.index++;
-                        primitive->key_counts.vertex++;
-                    }
+    // Make the access pattern in the below loop a bit more predictable. There should only
+    // be a relatively small number off indices in each array, so it should be fast.
+    sort_indices(index_buffer_view_count, index_buffer_view_indices);
+    sort_indices(vertex_buffer_view_count, vertex_buffer_view_indices);
+
+    u32 *allocation_keys = (u32*)malloc_t(sizeof(u32) * view_count);
+
+    u32 tmp;
+    const Gltf_Buffer_View     *gltf_buffer_view;
+    Gpu_Allocator_Result  allocator_result;
+    for(u32 i = 0; i < index_buffer_view_count; ++i) {
+        allocator_result = begin_allocation(&model_allocators->index);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+
+        tmp = index_buffer_view_indices[i];
+
+        if (packed_views && packed_views[tmp].data) {
+            allocator_result = continue_allocation(&model_allocators->index, packed_views[tmp].size,
+                                                   packed_views[tmp].data);
+        } else {
+            gltf_buffer_view = gltf_buffer_view_by_index(gltf, tmp); // Lame, I do not like what this function represents...
+            allocator_result = model_continue_allocation(&model_allocators->index, gltf, gltf_buffer_view, buffers);
+        }
+        if (allocator_result == GPU_ALLOCATOR_RESULT_INVALID_DATA) {
+            println("Gltf %s buffer view %u could not be decoded. Failed to load model.", gltf_file_name->str, tmp);
+            assert(false && "See above...");
+
+            reset_to_mark_temp(temp_allocator_mark);
+            return {};
+        }
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+
+        allocator_result = submit_allocation(&model_allocators->index, &allocation_keys[tmp]);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+    }
+
+    for(u32 i = 0; i < vertex_buffer_view_count; ++i) {
+        allocator_result = begin_allocation(&model_allocators->vertex);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+
+        tmp = vertex_buffer_view_indices[i];
+
+        if (packed_views && packed_views[tmp].data) {
+            allocator_result = continue_allocation(&model_allocators->vertex, packed_views[tmp].size,
+                                                   packed_views[tmp].data);
+        } else {
+            gltf_buffer_view = gltf_buffer_view_by_index(gltf, tmp); // Lame, I do not like what this function represents...
+            allocator_result = model_continue_allocation(&model_allocators->vertex, gltf, gltf_buffer_view, buffers);
+        }
+        if (allocator_result == GPU_ALLOCATOR_RESULT_INVALID_DATA) {
+            println("Gltf %s buffer view %u could not be decoded. Failed to load model.", gltf_file_name->str, tmp);
+            assert(false && "See above...");
+
+            reset_to_mark_temp(temp_allocator_mark);
+            return {};
+        }
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+
+        allocator_result = submit_allocation(&model_allocators->vertex, &allocation_keys[tmp]);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+    }
+
+                                        /* Texture Allocations */
+
+    u32  image_count              = gltf_image_get_count(gltf);
+    u32 *tex_allocation_keys  = (u32*)malloc_t(sizeof(u32) * image_count);
+
+    char **image_file_names = cache_file_name ? (char**)malloc_t(sizeof(char*) * image_count) : NULL;
+
+    String image_file_name;
+    const Gltf_Image *gltf_image = gltf->images;
+    for(u32 i = 0; i < image_count; ++i) {
+        // Fixing the below assert is trivial, but I do not need to right now. It will be done
+        // when it actually fires.
+        assert((gltf_image->uri || gltf_image->base64) && "@Todo @Unimplemented Support reading textures from buffer views");
+
+        if (gltf_image->base64) {
+            // @Todo The tex allocator only knows how to (re)load images from disk, so embedded images are written
+            // to MODEL_IMAGE_CACHE_DIR, named by a hash of their base64 text. The same image (in this gltf or any
+            // other) is only decoded and written once, and a changed one gets a new file rather than a stale one.
+            // If the tex allocator ever gets a memory backed source, the decoded data can go straight to it instead.
+            Hash_128 hash = hash_bytes_128(gltf_image->base64, gltf_image->base64_len);
+            string_format(uri_buf, "%s%u_%u.%s", MODEL_IMAGE_CACHE_DIR, hash.hi, hash.lo,
+                          gltf_image->jpeg ? "jpeg" : "png");
+
+            u64 image_size = gltf_image_get_base64_decoded_size(gltf_image);
+            struct stat image_stat;
+            if (stat(uri_buf, &image_stat) != 0 || (u64)image_stat.st_size != image_size) {
+                u8 *image_data = (u8*)malloc_t(image_size ? image_size : 1, 8);
+                if (!gltf_image_decode_base64(gltf_image, image_data, &image_size)) {
+                    println("Gltf %s image %u has an invalid base64 data uri. Failed to load model.",
+                            gltf_file_name->str, i);
+                    assert(false && "See above...");
+
+                    reset_to_mark_temp(temp_allocator_mark);
+                    return {};
                 }
+                mkdir(MODEL_IMAGE_CACHE_DIR, 0755); // Fails harmlessly if it exists
+                file_write_bin(uri_buf, image_size, image_data);
             }
+        } else {
+            // Idk about strlens and cstrs. It seems to compile to an avx intrinsic, so worries about speed is
+            // whatever, its just robustness (I am just debating in my head converting the gltf parser to use
+            // a real string type...)
+            strcpy(uri_buf + model_dir_len, gltf_image->uri); // Build the image uri
+        }
+        image_file_name = cstr_to_string(uri_buf);
+
+        if (cache_file_name) {
+            image_file_names[i] = (char*)malloc_t(image_file_name.len + 1);
+            memcpy(image_file_names[i], image_file_name.str, image_file_name.len + 1);
         }
+
+        // replace indices into images array with texture allocation keys
+        allocator_result = tex_add_texture(&model_allocators->tex, &image_file_name, &tex_allocation_keys[i]);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+
+        gltf_image = (const Gltf_Image*)((u8*)gltf_image + gltf_image->stride);
+    }
+
+    u32  sampler_count = gltf_sampler_get_count(gltf);
+    u32 *sampler_keys  = (u32*)malloc_t(sizeof(u32) * sampler_count);
+
+    Get_Sampler_Info        *sampler_infos = (Get_Sampler_Info*)malloc_t(sizeof(Get_Sampler_Info) * sampler_count);
+    Get_Sampler_Info         get_sampler_info;
+    Sampler_Allocator_Result sampler_result;
+
+    const Gltf_Sampler *gltf_sampler = gltf->samplers;
+    for(u32 i = 0; i < sampler_count; ++i) {
+        get_sampler_info = {};
+        get_sampler_info.wrap_s = (VkSamplerAddressMode)gltf_sampler->wrap_u;
+        get_sampler_info.wrap_t = (VkSamplerAddressMode)gltf_sampler->wrap_v;
+        get_sampler_info.mag_filter = (VkFilter)gltf_sampler->mag_filter;
+        get_sampler_info.min_filter = (VkFilter)gltf_sampler->min_filter;
+
+        sampler_infos[i] = get_sampler_info;
+        sampler_result = add_sampler(&model_allocators->sampler, &get_sampler_info, &sampler_keys[i]);
+        assert(sampler_result == SAMPLER_ALLOCATOR_RESULT_SUCCESS);
+        CHECK_SAMPLER_ALLOCATOR_RESULT(sampler_result);
+
+        gltf_sampler = (const Gltf_Sampler*)((u8*)gltf_sampler + gltf_sampler->stride);
+    }
+
+    // @Todo Do something with the information that a texture will always/have need a sampler, so I do not need
+    // a sampler count. Right now it is fine because I would pad the sampler count in primitive.key_counts anyway
+    // for simd, so right now it is useful for that. But it is a free 4 bytes that might be useful.
+
+    // The model still holds gltf indices here, which is what the cache wants.
+    if (cache_file_name) {
+        Model_Cache_Store_Info store_info = {};
+        store_info.source_hash       = model_get_source_hash(gltf, model_dir);
+        store_info.model             = &ret;
+        store_info.model_size        = ret.size;
+        store_info.gltf              = gltf;
+        store_info.buffers           = buffers;
+        store_info.packed_views      = packed_views;
+        store_info.view_count        = view_count;
+        store_info.load_flags        = flags;
+        store_info.index_view_count  = index_buffer_view_count;
+        store_info.index_views       = index_buffer_view_indices;
+        store_info.vertex_view_count = vertex_buffer_view_count;
+        store_info.vertex_views      = vertex_buffer_view_indices;
+        store_info.image_count       = image_count;
+        store_info.image_file_names  = image_file_names;
+        store_info.sampler_count     = sampler_count;
+        store_info.sampler_infos     = sampler_infos;
+
+        bool stored = store_model(cache_file_name, &store_info);
+        if (!stored)
+            println("Failed to write model cache %s", cache_file_name);
     }
 
+    // Point model back at the allocation keys
+    model_set_allocation_keys(&ret, allocation_keys, tex_allocation_keys, sampler_keys);
+
     reset_to_mark_temp(temp_allocator_mark); // Mark at function beginning
 
     return ret;
 }
 
-// These will be implemented when I run into a bottle neck on model structures taking up too much space:
-// the plan is to write these 'Model' structs to disk, and then avoid using gltf all together. Better load times
-// not having to parse the text files, just have to reset pointers.
-Model_Storage_Info store_model(Model *model) { // @Unimplemented
-    return {};
+// model_load_parsed_gltf(..) of '<model_dir><gltf_file_name>', parsed lazily into temp: only the sections touched
+// are parsed (no animations, nodes etc.).
+static Model model_load_gltf(Model_Allocators *model_allocators, const String *model_dir, const String *gltf_file_name,
+                             u64 size_available, u8 *model_buffer, u64 *ret_req_size, const char *cache_file_name,
+                             Model_Load_Flags flags)
+{
+    u64 temp_allocator_mark = get_mark_temp(); // Reset to mark at end of function
+
+    char uri_buf[127];
+    memcpy(uri_buf +              0, model_dir->str,      model_dir->len);
+    memcpy(uri_buf + model_dir->len, gltf_file_name->str, gltf_file_name->len + 1);
+    Gltf gltf = parse_gltf_lazy(uri_buf);
+    if (!gltf.data) {
+        println("Failed to read gltf file %s. Failed to load model.", uri_buf);
+        assert(false && "See above...");
+        return {};
+    }
+
+    Model ret = model_load_parsed_gltf(model_allocators, model_dir, gltf_file_name, &gltf, size_available,
+                                       model_buffer, ret_req_size, cache_file_name, flags);
+    reset_to_mark_temp(temp_allocator_mark);
+    return ret;
+}
+
+                                        /* Lod Selection */
+
+Lod_Select_Info get_lod_select_info(const Camera *camera, float fov_y, float viewport_height, float pixel_error) {
+    Lod_Select_Info ret;
+    ret.eye[0]          = camera->pos.x;
+    ret.eye[1]          = camera->pos.y;
+    ret.eye[2]          = camera->pos.z;
+    ret.pixels_per_unit = viewport_height / (2 * tanf(fov_y * 0.5f));
+    ret.pixel_error     = pixel_error;
+    return ret;
+}
+
+u32 select_primitive_lod(const Mesh_Primitive *primitive, const Lod_Select_Info *info, const float *center,
+                         float radius, float scale, u32 current_lod)
+{
+    if (!primitive->lods)
+        return 0;
+
+    float d[3] = {center[0] - info->eye[0], center[1] - info->eye[1], center[2] - info->eye[2]};
+    float distance = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) - radius;
+    if (distance <= 0) // Inside the bounds, so the error could be right in front of the eye.
+        return 0;
+
+    float pixels_per_error = info->pixels_per_unit * scale / distance;
+
+    // Lod errors only grow, so stop at the first one which shows.
+    u32   ret = 0;
+    float limit;
+    for(u32 i = 0; i < primitive->lods->count; ++i) {
+        limit = i + 1 > current_lod ? info->pixel_error * (1 - LOD_HYSTERESIS) : info->pixel_error;
+        if (primitive->lods->lods[i].error * pixels_per_error > limit)
+            break;
+        ret = i + 1;
+    }
+    return ret;
+}
+
+                                        /* Model Cache */
+
+//
+// One file per model, '<gltf file>.model', holding everything that model_load_gltf(..) gets out of the gltf. So
+// loading a cached model is one read, a pointer fix up and the allocator submissions, with no parsing:
+//
+//     | header | model | allocations | allocation data | image file names | sampler infos |
+//
+// 'model' is the model's bytes from the model buffer, with its pointers made relative to its start (NULL stays
+// 0: nothing in a model points at its first byte, the first mesh is only referenced by Model::meshes). Allocation,
+// texture and sampler keys in the model are still gltf indices, and are replaced once the allocations are
+// submitted, the same as when loading from gltf.
+//
+// A cache is stale if the gltf text or the size or modification time of a buffer file changed (see
+// model_get_source_hash(..)), or if the load flags, the version or the stored structs changed. Images are not
+// included, as the cache only holds their file names, but a cache naming an image file which is gone (such as an
+// embedded image after MODEL_IMAGE_CACHE_DIR was cleared) is stale as well.
+//
+static const u32 MODEL_CACHE_MAGIC   = 0x434d4c53; // 'SLMC'
+static const u32 MODEL_CACHE_VERSION = 8;
+
+enum Model_Cache_Struct {
+    MODEL_CACHE_STRUCT_MESH              = 0,
+    MODEL_CACHE_STRUCT_MESH_PRIMITIVE    = 1,
+    MODEL_CACHE_STRUCT_ATTRIBUTE         = 2,
+    MODEL_CACHE_STRUCT_MORPH_TARGET      = 3,
+    MODEL_CACHE_STRUCT_ACCESSOR          = 4,
+    MODEL_CACHE_STRUCT_ACCESSOR_MAX_MIN  = 5,
+    MODEL_CACHE_STRUCT_ACCESSOR_SPARSE   = 6,
+    MODEL_CACHE_STRUCT_MATERIAL          = 7,
+    MODEL_CACHE_STRUCT_SAMPLER_INFO      = 8,
+    MODEL_CACHE_STRUCT_MESHLETS          = 9,
+    MODEL_CACHE_STRUCT_MESHLET           = 10,
+    MODEL_CACHE_STRUCT_MESHLET_BOUNDS    = 11,
+    MODEL_CACHE_STRUCT_MESH_LODS         = 12,
+    MODEL_CACHE_STRUCT_MESH_LOD          = 13,
+    MODEL_CACHE_STRUCT_COUNT             = 14,
+};
+static const u32 MODEL_CACHE_STRUCT_SIZES[MODEL_CACHE_STRUCT_COUNT] = {
+    sizeof(Mesh),
+    sizeof(Mesh_Primitive),
+    sizeof(Mesh_Primitive_Attribute),
+    sizeof(Morph_Target),
+    sizeof(Accessor),
+    sizeof(Accessor_Max_Min),
+    sizeof(Accessor_Sparse),
+    sizeof(Material),
+    sizeof(Get_Sampler_Info),
+    sizeof(Meshlets),
+    sizeof(Meshlet),
+    sizeof(Meshlet_Bounds),
+    sizeof(Mesh_Lods),
+    sizeof(Mesh_Lod),
+};
+
+struct Model_Cache_Header {
+    u32 magic;
+    u32 version;
+    u32 struct_sizes[MODEL_CACHE_STRUCT_COUNT];
+    u64 source_hash;
+    u64 file_size;
+    u32 load_flags; // Model_Load_Flags, which change what is stored
+
+    u64 model_size;
+    u32 mesh_count;
+    u32 buffer_view_count; // Gltf buffer views and vertex streams, so the length of the allocation key remap
+    u32 allocation_count;
+    u32 image_count;
+    u32 sampler_count;
+
+    // From the start of the file
+    u64 offset_model;
+    u64 offset_allocations;
+    u64 offset_images;     // u32 offsets of null terminated file names
+    u64 offset_samplers;
+};
+
+struct Model_Cache_Allocation {
+    u32 buffer_view;  // Gltf index, which the model's allocation keys hold until the allocation is submitted
+    u32 index;        // Index allocator, else vertex
+    u64 offset;       // Of the data (decoded if it was meshopt compressed), from the start of the file
+    u64 size;         // Of the data once decoded
+    u64 encoded_size; // Of indices coded by mesh_encode_indices(..) at 'offset', else 0 (the data is stored as it is)
+    u32 index_size;   // Of the encoded indices, once decoded
+    u32 pad;
+};
+
+// Make a model's pointers relative to 'to' rather than 'from'. Pointees are found in 'model' (the model's bytes,
+// wherever they are now). False if the 'count' elements pointed to are not inside the model's 'size' bytes (a
+// corrupt cache). Empty arrays may point one past the end.
+template<typename T>
+inline static bool model_cache_relocate_pointer(T **pointer, T **pointee, u64 count, u8 *model, u64 size, u64 from,
+                                                u64 to)
+{
+    *pointee = NULL;
+    if (!*pointer)
+        return count == 0;
+
+    u64 offset = (u64)*pointer - from;
+    if (offset == 0 || offset > size || count > (size - offset) / sizeof(T))
+        return false;
+
+    *pointer = (T*)(to + offset);
+    *pointee = (T*)(model + offset);
+    return true;
+}
+static bool model_cache_relocate_accessor(Accessor *accessor, u8 *model, u64 size, u64 from, u64 to) {
+    Accessor_Max_Min *max_min;
+    Accessor_Sparse  *sparse;
+    bool ok  = model_cache_relocate_pointer(&accessor->max_min, &max_min, accessor->max_min != NULL,
+                                            model, size, from, to);
+    ok      &= model_cache_relocate_pointer(&accessor->sparse,  &sparse,  accessor->sparse  != NULL,
+                                            model, size, from, to);
+    return ok;
+}
+static bool model_cache_relocate(u8 *model, u32 mesh_count, u64 size, u64 from, u64 to) {
+    if (mesh_count * sizeof(Mesh) > size)
+        return false;
+
+    Mesh                     *meshes = (Mesh*)model;
+    Mesh_Primitive           *primitives;
+    Mesh_Primitive_Attribute *attributes;
+    Morph_Target             *targets;
+    Meshlets                 *meshlets;
+    Meshlet                  *meshlet;
+    Meshlet_Bounds           *bounds;
+    u32                      *meshlet_vertices;
+    u8                       *meshlet_triangles;
+    Mesh_Lods                *lods;
+    Mesh_Lod                 *lod;
+    u32                      *lod_indices;
+    float                    *weights;
+
+    bool ok = true;
+    for(u32 i = 0; i < mesh_count && ok; ++i) {
+        ok &= model_cache_relocate_pointer(&meshes[i].primitives, &primitives, meshes[i].primitive_count,
+                                           model, size, from, to);
+        ok &= model_cache_relocate_pointer(&meshes[i].weights,    &weights,    meshes[i].weight_count,
+                                           model, size, from, to);
+
+        for(u32 j = 0; j < meshes[i].primitive_count && ok; ++j) {
+            ok &= model_cache_relocate_accessor(&primitives[j].indices, model, size, from, to);
+
+            ok &= model_cache_relocate_pointer(&primitives[j].attributes, &attributes, primitives[j].attribute_count,
+                                               model, size, from, to);
+            for(u32 k = 0; k < primitives[j].attribute_count && ok; ++k)
+                ok &= model_cache_relocate_accessor(&attributes[k].accessor, model, size, from, to);
+
+            ok &= model_cache_relocate_pointer(&primitives[j].targets, &targets, primitives[j].target_count,
+                                               model, size, from, to);
+            for(u32 k = 0; k < primitives[j].target_count && ok; ++k) {
+                ok &= model_cache_relocate_pointer(&targets[k].attributes, &attributes, targets[k].attribute_count,
+                                                   model, size, from, to);
+                for(u32 l = 0; l < targets[k].attribute_count && ok; ++l)
+                    ok &= model_cache_relocate_accessor(&attributes[l].accessor, model, size, from, to);
+            }
+
+            ok &= model_cache_relocate_pointer(&primitives[j].meshlets, &meshlets, primitives[j].meshlets != NULL,
+                                               model, size, from, to);
+            if (meshlets && ok) {
+                ok &= model_cache_relocate_pointer(&meshlets->meshlets,  &meshlet,           meshlets->count,
+                                                   model, size, from, to);
+                ok &= model_cache_relocate_pointer(&meshlets->bounds,    &bounds,            meshlets->count,
+                                                   model, size, from, to);
+                ok &= model_cache_relocate_pointer(&meshlets->vertices,  &meshlet_vertices,  meshlets->vertex_count,
+                                                   model, size, from, to);
+                ok &= model_cache_relocate_pointer(&meshlets->triangles, &meshlet_triangles,
+                                                   (u64)meshlets->triangle_count * 3, model, size, from, to);
+            }
+
+            ok &= model_cache_relocate_pointer(&primitives[j].lods, &lods, primitives[j].lods != NULL,
+                                               model, size, from, to);
+            if (lods && ok) {
+                ok &= model_cache_relocate_pointer(&lods->lods,    &lod,         lods->count,       model, size, from, to);
+                ok &= model_cache_relocate_pointer(&lods->indices, &lod_indices, lods->index_count, model, size, from, to);
+            }
+        }
+    }
+    return ok;
+}
+
+static bool store_model(const char *cache_file_name, const Model_Cache_Store_Info *info) {
+    u32 allocation_count = info->index_view_count + info->vertex_view_count;
+
+    const Gltf_Buffer_View *view;
+    u32 view_index;
+
+    u64 size               = sizeof(Model_Cache_Header);
+    u64 offset_model       = align(size, 16);
+    size                   = offset_model + info->model_size;
+    u64 offset_allocations = align(size, 8);
+    size                   = offset_allocations + sizeof(Model_Cache_Allocation) * allocation_count;
+    u64 offset_data        = align(size, 16);
+    size                   = offset_data;
+
+    // Indices which were narrowed at import are all one width, so they can be delta coded for the file, and
+    // decoded again when the cache is loaded.
+    bool  compress      = info->load_flags & MODEL_LOAD_COMPRESS_INDICES_BIT;
+    u8  **encoded       = (u8**)malloc_t(sizeof(u8*) * allocation_count, 8);
+    u64  *encoded_sizes = (u64*)malloc_t(sizeof(u64) * allocation_count, 8);
+
+    const Model_Packed_View *packed;
+    for(u32 i = 0; i < allocation_count; ++i) {
+        view_index = i < info->index_view_count ? info->index_views[i] : info->vertex_views[i - info->index_view_count];
+        packed     = info->packed_views && info->packed_views[view_index].data ? &info->packed_views[view_index] : NULL;
+        view       = packed ? NULL : gltf_buffer_view_by_index(info->gltf, view_index);
+
+        encoded_sizes[i] = 0;
+        if (compress && packed && packed->index_size) {
+            u32  index_count = packed->size / packed->index_size;
+            u32 *indices     = (u32*)malloc_t(sizeof(u32) * index_count, 16);
+            for(u32 j = 0; j < index_count; ++j)
+                indices[j] = packed->index_size == 2 ? ((const u16*)packed->data)[j] : ((const u32*)packed->data)[j];
+
+            encoded[i]       = malloc_t(mesh_get_index_encode_bound(index_count), 16);
+            encoded_sizes[i] = mesh_encode_indices(encoded[i], indices, index_count);
+        }
+        size += align(encoded_sizes[i] ? encoded_sizes[i] : packed ? packed->size : view->byte_length, 16);
+    }
+    u64 offset_images = size;
+    size             += sizeof(u32) * info->image_count;
+    for(u32 i = 0; i < info->image_count; ++i)
+        size += strlen(info->image_file_names[i]) + 1;
+    u64 offset_samplers = align(size, 8);
+    size                = offset_samplers + sizeof(Get_Sampler_Info) * info->sampler_count;
+
+    u8 *cache = malloc_t(size, 16);
+    memset(cache, 0, size); // Padding, so that the same model always writes the same bytes
+
+    Model_Cache_Header *header = (Model_Cache_Header*)cache;
+    header->magic              = MODEL_CACHE_MAGIC;
+    header->version            = MODEL_CACHE_VERSION;
+    memcpy(header->struct_sizes, MODEL_CACHE_STRUCT_SIZES, sizeof(MODEL_CACHE_STRUCT_SIZES));
+    header->source_hash        = info->source_hash;
+    header->file_size          = size;
+    header->load_flags         = info->load_flags;
+    header->model_size         = info->model_size;
+    header->mesh_count         = info->model->mesh_count;
+    header->buffer_view_count  = info->view_count;
+    header->allocation_count   = allocation_count;
+    header->image_count        = info->image_count;
+    header->sampler_count      = info->sampler_count;
+    header->offset_model       = offset_model;
+    header->offset_allocations = offset_allocations;
+    header->offset_images      = offset_images;
+    header->offset_samplers    = offset_samplers;
+
+    // Model
+    memcpy(cache + offset_model, info->model->meshes, info->model_size);
+    bool ok = model_cache_relocate(cache + offset_model, info->model->mesh_count, info->model_size,
+                                   (u64)info->model->meshes, 0);
+    assert(ok && "Model points outside of its required size");
+
+    // Allocations
+    Model_Cache_Allocation *allocations = (Model_Cache_Allocation*)(cache + offset_allocations);
+    u64 offset = offset_data;
+    for(u32 i = 0; i < allocation_count; ++i) {
+        view_index = i < info->index_view_count ? info->index_views[i] : info->vertex_views[i - info->index_view_count];
+        packed     = info->packed_views && info->packed_views[view_index].data ? &info->packed_views[view_index] : NULL;
+        view       = packed ? NULL : gltf_buffer_view_by_index(info->gltf, view_index);
+
+        allocations[i].buffer_view = view_index;
+        allocations[i].index       = i < info->index_view_count;
+        allocations[i].offset      = offset;
+        allocations[i].size        = packed ? packed->size : view->byte_length;
+
+        if (encoded_sizes[i]) {
+            allocations[i].encoded_size = encoded_sizes[i];
+            allocations[i].index_size   = packed->index_size;
+            memcpy(cache + offset, encoded[i], encoded_sizes[i]);
+            offset += align(encoded_sizes[i], 16);
+            continue;
+        }
+
+        if (packed)
+            memcpy(cache + offset, packed->data, packed->size);
+        else if (view->meshopt.mode == GLTF_MESHOPT_MODE_NONE)
+            memcpy(cache + offset, info->buffers[view->buffer] + view->byte_offset, view->byte_length);
+        else if (!meshopt_decode_buffer_view(info->gltf, view, info->buffers, cache + offset))
+            return false;
+
+        offset += align(allocations[i].size, 16);
+    }
+
+    // Images
+    u32 *image_offsets = (u32*)(cache + offset_images);
+    offset = offset_images + sizeof(u32) * info->image_count;
+    for(u32 i = 0; i < info->image_count; ++i) {
+        u64 len = strlen(info->image_file_names[i]) + 1;
+        image_offsets[i] = offset;
+        memcpy(cache + offset, info->image_file_names[i], len);
+        offset += len;
+    }
+
+    // Samplers
+    memcpy(cache + offset_samplers, info->sampler_infos, sizeof(Get_Sampler_Info) * info->sampler_count);
+
+    // Not file_write_bin(..): failing to write a cache is not an error.
+    FILE *file = fopen(cache_file_name, "wb");
+    if (!file)
+        return false;
+
+    ok  = fwrite(cache, 1, size, file) == size;
+    ok &= fclose(file) == 0;
+    return ok;
+}
+
+static bool model_cache_is_current(const Model_Cache_Header *header, u64 file_size, u64 source_hash,
+                                   Model_Load_Flags load_flags)
+{
+    if (file_size < sizeof(Model_Cache_Header))
+        return false;
+
+    bool ok = header->magic       == MODEL_CACHE_MAGIC   &&
+              header->version     == MODEL_CACHE_VERSION &&
+              header->source_hash == source_hash         &&
+              header->file_size   == file_size           &&
+              header->load_flags  == load_flags;
+
+    ok &= memcmp(header->struct_sizes, MODEL_CACHE_STRUCT_SIZES, sizeof(MODEL_CACHE_STRUCT_SIZES)) == 0;
+
+    ok &= header->offset_model       + header->model_size                                         <= file_size;
+    ok &= header->offset_allocations + header->allocation_count * sizeof(Model_Cache_Allocation) <= file_size;
+    ok &= header->offset_images      + header->image_count      * sizeof(u32)                    <= file_size;
+    ok &= header->offset_samplers    + header->sampler_count    * sizeof(Get_Sampler_Info)       <= file_size;
+    return ok;
+}
+
+// False if the cache is missing or stale. Nothing is submitted to the allocators unless the whole cache checks out.
+static bool model_load_cache(Model_Allocators *model_allocators, const char *cache_file_name, u64 source_hash,
+                             Model_Load_Flags load_flags, u64 size_available, u8 *model_buffer, Model *ret,
+                             u64 *ret_req_size)
+{
+    FILE *file = fopen(cache_file_name, "rb");
+    if (!file)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    u64 size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    u8 *cache = malloc_t(size, 16);
+    bool ok = fread(cache, 1, size, file) == size;
+    fclose(file);
+
+    const Model_Cache_Header *header = (const Model_Cache_Header*)cache;
+    if (!ok || !model_cache_is_current(header, size, source_hash, load_flags))
+        return false;
+
+    const Model_Cache_Allocation *allocations = (const Model_Cache_Allocation*)(cache + header->offset_allocations);
+    for(u32 i = 0; i < header->allocation_count; ++i) {
+        if (allocations[i].encoded_size) {
+            ok &= allocations[i].index_size == 2 || allocations[i].index_size == 4;
+            ok &= allocations[i].index_size && allocations[i].size % allocations[i].index_size == 0;
+        }
+        ok &= allocations[i].offset + (allocations[i].encoded_size ? allocations[i].encoded_size : allocations[i].size) <= size;
+        ok &= allocations[i].buffer_view < header->buffer_view_count;
+    }
+    const u32 *image_offsets = (const u32*)(cache + header->offset_images);
+    struct stat image_stat;
+    for(u32 i = 0; i < header->image_count && ok; ++i) {
+        ok &= image_offsets[i] < size && memchr(cache + image_offsets[i], 0, size - image_offsets[i]) != NULL;
+        ok  = ok && stat((const char*)cache + image_offsets[i], &image_stat) == 0;
+    }
+    if (!ok)
+        return false;
+
+    *ret_req_size = header->model_size;
+    if (header->model_size > size_available) {
+        println("Size required for model %s: %u, Bytes remaining in buffer: %u", cache_file_name, header->model_size, size_available);
+        println("Insufficient size remaining in model buffer. Failed to load models.");
+        assert(false && "See above...");
+
+        *ret = {};
+        return true;
+    }
+
+    // Compressed indices are decoded before anything is submitted, as a bad encoding is a corrupt cache.
+    u8 **allocation_data = (u8**)malloc_t(sizeof(u8*) * header->allocation_count, 8);
+    for(u32 i = 0; i < header->allocation_count; ++i) {
+        allocation_data[i] = cache + allocations[i].offset;
+        if (!allocations[i].encoded_size)
+            continue;
+
+        allocation_data[i] = malloc_t(allocations[i].size, 16);
+        if (!mesh_decode_indices(allocation_data[i], allocations[i].index_size,
+                                 allocations[i].size / allocations[i].index_size, cache + allocations[i].offset,
+                                 allocations[i].encoded_size))
+        {
+            return false;
+        }
+    }
+
+    // Model: copy it into the buffer, then point it at itself.
+    memcpy(model_buffer, cache + header->offset_model, header->model_size);
+    if (!model_cache_relocate(model_buffer, header->mesh_count, header->model_size, 0, (u64)model_buffer))
+        return false;
+
+    // Allocations
+    u32 *allocation_keys = (u32*)malloc_t(sizeof(u32) * header->buffer_view_count);
+
+    Gpu_Allocator        *allocator;
+    Gpu_Allocator_Result  allocator_result;
+    for(u32 i = 0; i < header->allocation_count; ++i) {
+        allocator = allocations[i].index ? &model_allocators->index : &model_allocators->vertex;
+
+        allocator_result = begin_allocation(allocator);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+
+        allocator_result = continue_allocation(allocator, allocations[i].size, allocation_data[i]);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+
+        allocator_result = submit_allocation(allocator, &allocation_keys[allocations[i].buffer_view]);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+    }
+
+    // Textures
+    u32   *tex_allocation_keys = (u32*)malloc_t(sizeof(u32) * header->image_count);
+    String image_file_name;
+    for(u32 i = 0; i < header->image_count; ++i) {
+        image_file_name  = cstr_to_string((const char*)cache + image_offsets[i]);
+        allocator_result = tex_add_texture(&model_allocators->tex, &image_file_name, &tex_allocation_keys[i]);
+        CHECK_GPU_ALLOCATOR_RESULT(allocator_result);
+    }
+
+    // Samplers
+    u32 *sampler_keys = (u32*)malloc_t(sizeof(u32) * header->sampler_count);
+
+    Get_Sampler_Info         *sampler_infos = (Get_Sampler_Info*)(cache + header->offset_samplers);
+    Sampler_Allocator_Result  sampler_result;
+    for(u32 i = 0; i < header->sampler_count; ++i) {
+        sampler_result = add_sampler(&model_allocators->sampler, &sampler_infos[i], &sampler_keys[i]);
+        CHECK_SAMPLER_ALLOCATOR_RESULT(sampler_result);
+    }
+
+    ret->size       = header->model_size;
+    ret->mesh_count = header->mesh_count;
+    ret->meshes     = (Mesh*)model_buffer;
+    model_set_allocation_keys(ret, allocation_keys, tex_allocation_keys, sampler_keys);
+
+    return true;
 }
-Model load_model(Model_Storage_Info *strorage_info) { // @Unimplemented
-    Model  ret;
+
+Model load_model(Model_Allocators *model_allocators, const String *model_dir, const String *gltf_file_name,
+                 u64 size_available, u8 *model_buffer, u64 *ret_req_size, Model_Load_Flags flags)
+{
+    u64 temp_allocator_mark = get_mark_temp(); // Reset to mark at end of function
+
+    char gltf_uri[127];
+    char cache_uri[127];
+    assert(model_dir->len + gltf_file_name->len + sizeof(".model") <= sizeof(cache_uri) && "Model file name too long");
+    memcpy(gltf_uri +              0, model_dir->str,      model_dir->len);
+    memcpy(gltf_uri + model_dir->len, gltf_file_name->str, gltf_file_name->len + 1);
+    string_format(cache_uri, "%s.model", gltf_uri);
+
+    // Hashing only reads the text and the buffers section, and on a miss the same gltf is loaded.
+    Gltf gltf = parse_gltf_lazy(gltf_uri);
+    if (!gltf.data) {
+        println("Failed to read gltf file %s. Failed to load model.", gltf_uri);
+        assert(false && "See above...");
+        return {};
+    }
+
+    u64 source_hash = model_get_source_hash(&gltf, model_dir);
+
+    Model ret;
+    bool  cached = model_load_cache(model_allocators, cache_uri, source_hash, flags,
+                                    size_available, model_buffer, &ret, ret_req_size);
+    if (!cached) {
+        #if MODEL_LOAD_INFO
+        println("Model cache %s is missing or stale, loading from gltf", cache_uri);
+        #endif
+
+        ret = model_load_parsed_gltf(model_allocators, model_dir, gltf_file_name, &gltf, size_available,
+                                     model_buffer, ret_req_size, cache_uri, flags);
+    }
+
+    reset_to_mark_temp(temp_allocator_mark);
     return ret;
 }
 
+Model model_from_gltf(Model_Allocators *model_allocators, const String *model_dir, const String *gltf_file_name,
+                      u64 size_available, u8 *model_buffer, u64 *ret_req_size, Model_Load_Flags flags)
+{
+    return model_load_gltf(model_allocators, model_dir, gltf_file_name, size_available, model_buffer, ret_req_size,
+                           NULL, flags);
+}
+
+Model model_from_gltf_document(Model_Allocators *model_allocators, const String *model_dir,
+                               const String *gltf_file_name, Gltf_Document *document, u64 size_available,
+                               u8 *model_buffer, u64 *ret_req_size, Model_Load_Flags flags)
+{
+    return model_load_parsed_gltf(model_allocators, model_dir, gltf_file_name, &document->gltf, size_available,
+                                  model_buffer, ret_req_size, NULL, flags);
+}
+
 inline static void add_accessor_index(Array<u32> *array_index, Array<u32> *array_vertex, const Accessor *accessor) {
     array_add(array_index, accessor->allocation_key);
 
@@ -1057,8 +3545,10 @@ inline static void add_accessor_index(Array<u32> *array_index, Array<u32> *array
         array_add(array_vertex, accessor->sparse->values_allocation_key);
     }
 }
-inline static void add_accessor_vertex(Array<u32> *array_index, Array<u32> *array_vertex, Accessor *accessor) {
-    array_add(array_vertex, accessor->allocation_key);
+inline static void add_accessor_vertex(Array<u32> *array_index, Array<u32> *array_vertex, const Accessor *accessor,
+                                       bool add_allocation = true)
+{
+    array_add_if_true(array_vertex, accessor->allocation_key, add_allocation);
 
     if (accessor->sparse) {
         array_add(array_index,  accessor->sparse->indices_allocation_key);
@@ -1069,7 +3559,16 @@ inline static void add_accessor_vertex(Array<u32> *array_index, Array<u32> *arra
 inline static VkFormat get_format_from_accessor_flags(Accessor_Flags flags) {
     u32 ret;
 
+    // Normalized 8 and 16 bit types are the unorm/snorm formats, 4 before the uint/sint ones (R8_UNORM is R8_UINT
+    // - 4, R16G16_SNORM is R16G16_SINT - 4, etc.). Halves are looked up as u16, and are the sfloat formats, 2 after
+    // the uint ones.
+    u32 normalized = (flags & ACCESSOR_NORMALIZED_BIT) &&
+                     (flags & (ACCESSOR_COMPONENT_TYPE_SCHAR_BIT | ACCESSOR_COMPONENT_TYPE_UCHAR_BIT |
+                               ACCESSOR_COMPONENT_TYPE_S16_BIT   | ACCESSOR_COMPONENT_TYPE_U16_BIT));
+    u32 half       = (flags & ACCESSOR_COMPONENT_TYPE_HALF_BIT) > 0;
+
     flags &= ACCESSOR_TYPE_BITS | ACCESSOR_COMPONENT_TYPE_BITS;
+    flags ^= (ACCESSOR_COMPONENT_TYPE_HALF_BIT | ACCESSOR_COMPONENT_TYPE_U16_BIT) & max32_if_true(half);
 
     // I dont know for sure if this is more efficient that a switch statement, but I am pretty sure it is.
     // For the switch statement you still have to do loads of compare ops, plus the fact that the branch predictor
@@ -1132,6 +3631,9 @@ inline static VkFormat get_format_from_accessor_flags(Accessor_Flags flags) {
     ret -= ret                                             & max32_if_true(flags == (ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_COMPONENT_TYPE_FLOAT_BIT));
     ret += static_cast<u32>(VK_FORMAT_R32G32B32A32_SFLOAT) & max32_if_true(flags == (ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_COMPONENT_TYPE_FLOAT_BIT));
 
+    ret -= 4 & max32_if_true(normalized);
+    ret += 2 & max32_if_true(half);
+
     return (VkFormat)ret;
 
     // ret -= ret             & max32_if_true(ACCESSOR_TYPE_MAT2_BIT | ACCESSOR_COMPONENT_TYPE_SCHAR_BIT);
@@ -1183,13 +3685,22 @@ struct Material_Ubo_Allocators {
 // occlusion strength, emissive factor (array), alpha cutoff
 static constexpr u32 MAX_RESOURCE_DESCRIPTOR_COUNT_PER_PRIMITIVE = 7;
 
+// Bytes of arena which load_primitive_info(..) takes for 'count' primitives (strides, formats and offsets).
+static u64 load_primitive_info_arena_size(u32 count, const Mesh_Primitive *primitives) {
+    u64 ret = 0;
+    for(u32 i = 0; i < count; ++i)
+        ret += (sizeof(u32) + sizeof(VkFormat) + sizeof(u32)) * primitives[i].attribute_count;
+    return ret;
+}
+
 static void load_primitive_info(
     u32                      count,
     const Mesh_Primitive    *primitives,
     Allocation_Key_Arrays   *arrays,
     Pl_Primitive_Info       *pl_infos,
     Primitive_Draw_Info     *draw_infos,
-    Material_Ubo_Allocators *material_ubo_allocators)
+    Material_Ubo_Allocators *material_ubo_allocators,
+    Linear_Allocator        *arena) // pl_infos' arrays, see load_primitive_info_arena_size(..)
 {
     Assets *g_assets = get_assets_instance();
 
@@ -1225,7 +3736,9 @@ static void load_primitive_info(
 
     u32 attribute_count;
     u32 target_count;
-    Morph_Target *target;
+    u32 last_vertex_key;
+    const Accessor *accessor;
+    const Morph_Target *target;
     for(u32 i = 0; i < count; ++i) {
         // Indices
         add_accessor_index(&array_index, &array_vertex, &primitives[i].indices);
@@ -1238,24 +3751,38 @@ static void load_primitive_info(
         attribute_count = primitives[i].attribute_count;
 
         pl_infos[i].count   = attribute_count;
-        pl_infos[i].strides =      (u32*)malloc_t(sizeof(u32)      * attribute_count); // Maybe these should be arrays, idk
-        pl_infos[i].formats = (VkFormat*)malloc_t(sizeof(VkFormat) * attribute_count);
+        pl_infos[i].strides =      (u32*)malloc_linear(arena, sizeof(u32)      * attribute_count, 4); // Maybe these should be arrays, idk
+        pl_infos[i].formats = (VkFormat*)malloc_linear(arena, sizeof(VkFormat) * attribute_count, 4);
+        pl_infos[i].offsets = model_primitive_is_interleaved(&primitives[i]) ?
+                              (u32*)malloc_linear(arena, sizeof(u32) * attribute_count, 4) : NULL;
 
+        // An accessor in the same allocation as the one before it (interleaved or merged views) adds no key
+        last_vertex_key = Max_u32;
         for(u32 j = 0; j < attribute_count; ++j) {
-            add_accessor_vertex(&array_index, &array_vertex, &primitives[i].attributes[j].accessor);
-
-            pl_infos[i].strides[j] = primitives[i].attributes[j].accessor.byte_stride;
-            pl_infos[i].formats[j] = get_format_from_accessor_flags(primitives[i].attributes[j].accessor.flags);
+            accessor = &primitives[i].attributes[j].accessor;
+            add_accessor_vertex(&array_index, &array_vertex, accessor, accessor->allocation_key != last_vertex_key);
+            last_vertex_key = accessor->allocation_key;
+
+            pl_infos[i].strides[j] = accessor->byte_stride;
+            pl_infos[i].formats[j] = get_format_from_accessor_flags(accessor->flags);
+            if (pl_infos[i].offsets)
+                pl_infos[i].offsets[j] = accessor->byte_offset;
         }
 
+        if (primitives[i].position_stream_key != Max_u32)
+            array_add(&array_vertex, primitives[i].position_stream_key);
+
         // Morph Targets
         target_count = primitives[i].target_count;
         for(u32 j = 0; j < target_count; ++j) {
             target = &primitives[i].targets[j];
 
             attribute_count = target->attribute_count;
-            for(u32 k = 0; k < attribute_count; ++k)
-                add_accessor_vertex(&array_index, &array_vertex, &target->attributes[k].accessor);
+            for(u32 k = 0; k < attribute_count; ++k) {
+                accessor = &target->attributes[k].accessor;
+                add_accessor_vertex(&array_index, &array_vertex, accessor, accessor->allocation_key != last_vertex_key);
+                last_vertex_key = accessor->allocation_key;
+            }
         }
 
                                                         /* Materials */
@@ -1402,6 +3929,21 @@ inline static bool check_upload_stage_results_against_req_count(u32 count, u32 b
     return primary_mask == count;
 }
 
+struct Load_Primitive_Info_Job {
+    u32                      count;
+    const Mesh_Primitive    *primitives;
+    Allocation_Key_Arrays   *arrays;
+    Pl_Primitive_Info       *pl_infos;
+    Primitive_Draw_Info     *draw_infos;
+    Material_Ubo_Allocators *material_ubo_allocators;
+    Linear_Allocator        *arena;
+};
+static void load_primitive_info_job(void *arg) {
+    Load_Primitive_Info_Job *job = (Load_Primitive_Info_Job*)arg;
+    load_primitive_info(job->count, job->primitives, job->arrays, job->pl_infos, job->draw_infos,
+                        job->material_ubo_allocators, job->arena);
+}
+
 /*
     As per VkSpec:
         "If image is non-sparse then it must be bound completely and contiguously to a single
@@ -1419,9 +3961,8 @@ Primitive_Draw_Prep_Result prepare_to_draw_primitives(
 {
     Assets *g_assets = get_assets_instance();
 
-    // @Multithreading Each thread will take an offset into the primitives array and some
-    // number of primitives, and offsets into each of the key arrays in g_assets where it
-    // will write primitives' corresponding keys.
+    // Each job takes an offset into the primitives array and some number of primitives, and
+    // offsets into each of the key arrays in g_assets where it will write primitives' corresponding keys.
 
     u32 primitive_job_size = count / g_thread_count;
     u32 remainder_job_size = count % g_thread_count;
@@ -1494,9 +4035,12 @@ Primitive_Draw_Prep_Result prepare_to_draw_primitives(
     assert(idx == count && "We should have visited every primitive in the 'accum_offsets' loop");
 
 
-    // @Multithreading The below loop simulates multhreading without me having to yet go through the
-    // rigmarole of setting it all up completely. This should be behave in the exact same fashion as
-    // the real threaded version, as synchronisation has no effect here, only the range which is written.
+    // Each job writes only its own range of the primitives' infos and of the key arrays, and has its own uniform,
+    // descriptor and arena allocators, so the jobs need no synchronisation until they have all returned.
+
+    Load_Primitive_Info_Job jobs_info[g_thread_count];
+    Job                     jobs     [g_thread_count];
+    Linear_Allocator        arenas   [g_thread_count];
 
     Material_Ubo_Allocators material_ubo_allocators[g_thread_count];
 
@@ -1504,15 +4048,22 @@ Primitive_Draw_Prep_Result prepare_to_draw_primitives(
         material_ubo_allocators[i].uniform    = &g_assets->model_allocators.uniform[i];
         material_ubo_allocators[i].descriptor = &g_assets->model_allocators.descriptor_resource[i];
 
-        // I do not love this formatting (the non contiguous offsets) but return locations must be last...
-        load_primitive_info(
-            primitive_job_sizes[i],
-            primitives           + primitive_job_offsets[i],
-           &primitive_job_key_arrays[i],
-            pl_primitive_infos   + primitive_job_offsets[i],
-            primitive_draw_infos + primitive_job_offsets[i],
-           &material_ubo_allocators[i]);
+        arenas[i].capacity = load_primitive_info_arena_size(primitive_job_sizes[i], primitives + primitive_job_offsets[i]);
+        arenas[i].used     = 0;
+        arenas[i].memory   = malloc_t(arenas[i].capacity, 64); // 64: jobs do not share cache lines
+
+        jobs_info[i] = {
+            .count                   = primitive_job_sizes[i],
+            .primitives              = primitives           + primitive_job_offsets[i],
+            .arrays                  = &primitive_job_key_arrays[i],
+            .pl_infos                = pl_primitive_infos   + primitive_job_offsets[i],
+            .draw_infos              = primitive_draw_infos + primitive_job_offsets[i],
+            .material_ubo_allocators = &material_ubo_allocators[i],
+            .arena                   = &arenas[i],
+        };
+        jobs[i] = {.func = load_primitive_info_job, .arg = &jobs_info[i]};
     }
+    run_jobs(g_thread_count, jobs);
 
     // I do not want to fabricate all the stuff required to make the tests successfully compile the pipelines.
     // It is better to test that with real use case stuff. I can see that it is trying to compile the pipelines
@@ -1528,8 +4079,8 @@ Primitive_Draw_Prep_Result prepare_to_draw_primitives(
     }
     #endif
 
-    // @Multithreading Wait for threads to return, and signal allocators to queue allocation keys in their
-    // respective array. Each allocator queue will be controlled by a thread.
+    // @Multithreading Signal allocators to queue allocation keys in their respective array. Each allocator
+    // queue will be controlled by a thread.
 
     const u32 result_mask_count = 17; // must be large enough to allow out of bounds indexing by one in the below loop.
 
@@ -1955,11 +4506,29 @@ void create_primitive_pipelines(
 static void test_model_from_gltf();
 static void test_load_primitive_allocations();
 static void test_get_format_from_accessor_flags();
+static void test_model_cache();
+static void test_model_pack_vertices();
+static void test_model_interleave_vertices();
+static void test_model_merge_views();
+static void test_model_narrow_indices();
+static void test_model_dedup();
+static void test_model_convert_jobs();
+static void test_select_primitive_lod();
+static void test_model_accessor_overlaps();
 
 void test_asset() {
     test_model_from_gltf();
     test_load_primitive_allocations();
     test_get_format_from_accessor_flags();
+    test_model_cache();
+    test_model_pack_vertices();
+    test_model_interleave_vertices();
+    test_model_merge_views();
+    test_model_narrow_indices();
+    test_model_dedup();
+    test_model_convert_jobs();
+    test_select_primitive_lod();
+    test_model_accessor_overlaps();
 }
 
 
@@ -1973,6 +4542,17 @@ static void test_get_format_from_accessor_flags() {
     TEST_EQ("vec3 float",   get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_FLOAT_BIT | ACCESSOR_TYPE_VEC3_BIT),   VK_FORMAT_R32G32B32_SFLOAT,    false);
     TEST_EQ("vec4 float",   get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_FLOAT_BIT | ACCESSOR_TYPE_VEC4_BIT),   VK_FORMAT_R32G32B32A32_SFLOAT, false);
 
+    // Packed vertex formats
+    TEST_EQ("vec4 unorm16", get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_U16_BIT   | ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_NORMALIZED_BIT), VK_FORMAT_R16G16B16A16_UNORM, false);
+    TEST_EQ("vec2 snorm16", get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_S16_BIT   | ACCESSOR_TYPE_VEC2_BIT | ACCESSOR_NORMALIZED_BIT), VK_FORMAT_R16G16_SNORM,       false);
+    TEST_EQ("vec4 snorm16", get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_S16_BIT   | ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_NORMALIZED_BIT), VK_FORMAT_R16G16B16A16_SNORM, false);
+    TEST_EQ("vec2 snorm8",  get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_SCHAR_BIT | ACCESSOR_TYPE_VEC2_BIT | ACCESSOR_NORMALIZED_BIT), VK_FORMAT_R8G8_SNORM,         false);
+    TEST_EQ("vec4 snorm8",  get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_SCHAR_BIT | ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_NORMALIZED_BIT), VK_FORMAT_R8G8B8A8_SNORM,     false);
+    TEST_EQ("vec4 unorm8",  get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_UCHAR_BIT | ACCESSOR_TYPE_VEC4_BIT | ACCESSOR_NORMALIZED_BIT), VK_FORMAT_R8G8B8A8_UNORM,     false);
+    TEST_EQ("vec2 half",    get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_HALF_BIT  | ACCESSOR_TYPE_VEC2_BIT),                           VK_FORMAT_R16G16_SFLOAT,      false);
+    TEST_EQ("vec4 half",    get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_HALF_BIT  | ACCESSOR_TYPE_VEC4_BIT),                           VK_FORMAT_R16G16B16A16_SFLOAT, false);
+    TEST_EQ("float normalized", get_format_from_accessor_flags(ACCESSOR_COMPONENT_TYPE_FLOAT_BIT | ACCESSOR_TYPE_VEC3_BIT | ACCESSOR_NORMALIZED_BIT), VK_FORMAT_R32G32B32_SFLOAT, false);
+
     END_TEST_MODULE();
 }
 
@@ -2008,6 +4588,10 @@ static void test_load_primitive_allocations() {
 
     u64 allocation_size = 128;
     u8 *allocation_mem  = malloc_t(allocation_size);
+    memset(allocation_mem, 0, allocation_size);
+
+    // Every allocation is tagged, as the allocators would return the same key for the same bytes.
+    u32 *allocation_tag = (u32*)allocation_mem;
 
     u32 primitive_count = 128;
     Mesh_Primitive *primitives = (Mesh_Primitive*)malloc_t(sizeof(Mesh_Primitive) * primitive_count);
@@ -2044,6 +4628,7 @@ static void test_load_primitive_allocations() {
         result = begin_allocation(&allocators->index);
         assert(result == GPU_ALLOCATOR_RESULT_SUCCESS);
 
+        (*allocation_tag)++;
         result = continue_allocation(&allocators->index, allocation_size, allocation_mem);
         assert(result == GPU_ALLOCATOR_RESULT_SUCCESS);
 
@@ -2058,6 +4643,7 @@ static void test_load_primitive_allocations() {
             result = begin_allocation(&allocators->vertex);
             assert(result == GPU_ALLOCATOR_RESULT_SUCCESS);
 
+            (*allocation_tag)++;
             result = continue_allocation(&allocators->vertex, allocation_size, allocation_mem);
             assert(result == GPU_ALLOCATOR_RESULT_SUCCESS);
 
@@ -2554,7 +5140,8 @@ static void test_model_from_gltf() {
     u64 req_size;
     String model_dir  = cstr_to_string("test/");
     String model_name = cstr_to_string("test_gltf2.gltf");
-    Model  model      = model_from_gltf(&model_allocators, &model_dir, &model_name, size, model_buffer, &req_size);
+    Model  model      = model_from_gltf(&model_allocators, &model_dir, &model_name, size, model_buffer, &req_size,
+                                         MODEL_LOAD_DEFAULT_FLAGS);
 
     u8 *buf = (u8*)file_read_bin_temp_large("test/buf.bin", 10'000);
 
@@ -2645,9 +5232,1294 @@ static void test_model_from_gltf() {
         test_accessor(vertex_allocator, buf, name_buf, &meshes[0].primitives[0].attributes[i].accessor, &attributes0[i].accessor, false);
     }
 
+    // The same gltf from a lazy document is the same model. Its allocations hold the same data, so they dedup to
+    // the same keys.
+    Gltf_Document *document = gltf_document_create("test/test_gltf2.gltf", true);
+    TEST_EQ("document.created", document != NULL, true, false);
+    if (document) {
+        u8   *document_buffer = malloc_t(size);
+        u64   document_req_size;
+        Model document_model  = model_from_gltf_document(&model_allocators, &model_dir, &model_name, document, size,
+                                                         document_buffer, &document_req_size,
+                                                         MODEL_LOAD_DEFAULT_FLAGS);
+        TEST_EQ("document.req_size",   document_req_size,         req_size,         false);
+        TEST_EQ("document.mesh_count", document_model.mesh_count, model.mesh_count, false);
+
+        bool same = document_model.mesh_count == model.mesh_count;
+        for(u32 i = 0; same && i < model.mesh_count; ++i) {
+            same &= document_model.meshes[i].primitive_count == model.meshes[i].primitive_count;
+            for(u32 j = 0; same && j < model.meshes[i].primitive_count; ++j) {
+                const Mesh_Primitive *x = &model.meshes[i].primitives[j];
+                const Mesh_Primitive *y = &document_model.meshes[i].primitives[j];
+                same &= x->indices.count == y->indices.count && x->attribute_count == y->attribute_count;
+                same &= x->indices.allocation_key == y->indices.allocation_key;
+                for(u32 k = 0; same && k < x->attribute_count; ++k)
+                    same &= x->attributes[k].accessor.allocation_key == y->attributes[k].accessor.allocation_key;
+            }
+        }
+        TEST_EQ("document.same_model", same, true, false);
+
+        gltf_document_free(document);
+    }
+
+    destroy_model_allocators(&model_allocators);
+
+    END_TEST_MODULE();
+}
+
+static void test_model_cache_accessor(const char *name, const Accessor *a, const Accessor *b, const u8 *base_a,
+                                      const u8 *base_b)
+{
+    char name_buf[127];
+
+    string_format(name_buf, "%s.flags", name);
+    TEST_EQ(name_buf, a->flags, b->flags, false);
+    string_format(name_buf, "%s.byte_stride", name);
+    TEST_EQ(name_buf, a->byte_stride, b->byte_stride, false);
+    string_format(name_buf, "%s.byte_offset", name);
+    TEST_EQ(name_buf, a->byte_offset, b->byte_offset, false);
+    string_format(name_buf, "%s.count", name);
+    TEST_EQ(name_buf, a->count, b->count, false);
+
+    // Relocated pointers land at the same offsets in their buffers.
+    string_format(name_buf, "%s.max_min", name);
+    TEST_EQ(name_buf, a->max_min ? (u8*)a->max_min - base_a : -1, b->max_min ? (u8*)b->max_min - base_b : -1, false);
+    if (a->max_min && b->max_min)
+        TEST_EQ(name_buf, memcmp(a->max_min, b->max_min, sizeof(Accessor_Max_Min)), 0, false);
+
+    string_format(name_buf, "%s.sparse", name);
+    TEST_EQ(name_buf, a->sparse ? (u8*)a->sparse - base_a : -1, b->sparse ? (u8*)b->sparse - base_b : -1, false);
+    if (a->sparse && b->sparse) {
+        TEST_EQ(name_buf, a->sparse->count,               b->sparse->count,               false);
+        TEST_EQ(name_buf, a->sparse->indices_byte_offset, b->sparse->indices_byte_offset, false);
+        TEST_EQ(name_buf, a->sparse->values_byte_offset,  b->sparse->values_byte_offset,  false);
+    }
+}
+
+static void test_model_cache() {
+    Model_Allocators_Config model_allocators_config = {};
+    Model_Allocators model_allocators = create_model_allocators(&model_allocators_config);
+
+    String      model_dir       = cstr_to_string("test/");
+    String      model_name      = cstr_to_string("test_gltf2.gltf");
+    const char *cache_file_name = "test/test_gltf2.gltf.model";
+    remove(cache_file_name);
+
+    u32 size = 1024 * 16;
+    u8 *gltf_buffer  = malloc_t(size);
+    u8 *cache_buffer = malloc_t(size);
+
+    BEGIN_TEST_MODULE("Model_Cache", false, false);
+
+    // No cache: load from gltf, and write one. Meshlets and lods are built so that their pointers are relocated too.
+    Model_Load_Flags flags = MODEL_LOAD_DEFAULT_FLAGS | MODEL_LOAD_BUILD_MESHLETS_BIT | MODEL_LOAD_BUILD_LODS_BIT;
+    u64   gltf_req_size;
+    Model gltf_model = model_load_gltf(&model_allocators, &model_dir, &model_name, size, gltf_buffer, &gltf_req_size,
+                                       cache_file_name, flags);
+
+    FILE *cache_file = fopen(cache_file_name, "rb");
+    TEST_EQ("cache_written", cache_file != NULL, true, false);
+    if (cache_file)
+        fclose(cache_file);
+
+    Gltf source      = parse_gltf_lazy("test/test_gltf2.gltf");
+    u64  source_hash = model_get_source_hash(&source, &model_dir);
+
+    // Stale: the gltf changed.
+    u64   cache_req_size;
+    Model cache_model;
+    TEST_EQ("stale_cache", model_load_cache(&model_allocators, cache_file_name, source_hash + 1,
+                                            flags, size, cache_buffer, &cache_model,
+                                            &cache_req_size), false, false);
+
+    // Stale: loaded with other flags.
+    TEST_EQ("stale_flags", model_load_cache(&model_allocators, cache_file_name, source_hash,
+                                            flags ^ MODEL_LOAD_PACK_VERTICES_BIT, size, cache_buffer,
+                                            &cache_model, &cache_req_size), false, false);
+
+    // Current: the cached model matches the gltf one, except for the keys of its (new) allocations.
+    bool cached = model_load_cache(&model_allocators, cache_file_name, source_hash, flags, size,
+                                   cache_buffer, &cache_model, &cache_req_size);
+    TEST_EQ("current_cache", cached, true, false);
+    TEST_EQ("req_size",      cache_req_size,         gltf_req_size,         false);
+    TEST_EQ("mesh_count",    cache_model.mesh_count, gltf_model.mesh_count, false);
+    TEST_EQ("meshes",        (u8*)cache_model.meshes - cache_buffer, (u8*)gltf_model.meshes - gltf_buffer, false);
+
+    char name_buf[127];
+    for(u32 i = 0; cached && i < gltf_model.mesh_count; ++i) {
+        const Mesh *a = &gltf_model.meshes[i];
+        const Mesh *b = &cache_model.meshes[i];
+
+        string_format(name_buf, "meshes[%u].primitive_count", i);
+        TEST_EQ(name_buf, b->primitive_count, a->primitive_count, false);
+        string_format(name_buf, "meshes[%u].weight_count", i);
+        TEST_EQ(name_buf, b->weight_count, a->weight_count, false);
+        string_format(name_buf, "meshes[%u].weights", i);
+        TEST_EQ(name_buf, b->weights ? (u8*)b->weights - cache_buffer : -1, a->weights ? (u8*)a->weights - gltf_buffer : -1, false);
+        if (a->weights && b->weights)
+            TEST_EQ(name_buf, memcmp(a->weights, b->weights, sizeof(float) * a->weight_count), 0, false);
+
+        for(u32 j = 0; j < a->primitive_count; ++j) {
+            const Mesh_Primitive *pa = &a->primitives[j];
+            const Mesh_Primitive *pb = &b->primitives[j];
+
+            string_format(name_buf, "meshes[%u].primitives[%u].counts", i, j);
+            TEST_EQ(name_buf, pb->attribute_count,    pa->attribute_count,    false);
+            TEST_EQ(name_buf, pb->target_count,       pa->target_count,       false);
+            TEST_EQ(name_buf, pb->topology,           pa->topology,           false);
+            TEST_EQ(name_buf, pb->key_counts.index,   pa->key_counts.index,   false);
+            TEST_EQ(name_buf, pb->key_counts.vertex,  pa->key_counts.vertex,  false);
+            TEST_EQ(name_buf, pb->key_counts.tex,     pa->key_counts.tex,     false);
+            TEST_EQ(name_buf, pb->key_counts.sampler, pa->key_counts.sampler, false);
+
+            string_format(name_buf, "meshes[%u].primitives[%u].material", i, j);
+            TEST_EQ(name_buf, pb->material.flags, pa->material.flags, false);
+            TEST_EQ(name_buf, memcmp(&pb->material.ubo, &pa->material.ubo, sizeof(Material_Ubo)), 0, false);
+
+            string_format(name_buf, "meshes[%u].primitives[%u].indices", i, j);
+            test_model_cache_accessor(name_buf, &pb->indices, &pa->indices, cache_buffer, gltf_buffer);
+
+            string_format(name_buf, "meshes[%u].primitives[%u].position_dequantize", i, j);
+            TEST_EQ(name_buf, memcmp(&pb->position_dequantize, &pa->position_dequantize, sizeof(Vertex_Dequantize)), 0,
+                    false);
+
+            string_format(name_buf, "meshes[%u].primitives[%u].attributes", i, j);
+            TEST_EQ(name_buf, (u8*)pb->attributes - cache_buffer, (u8*)pa->attributes - gltf_buffer, false);
+            for(u32 k = 0; k < pa->attribute_count; ++k) {
+                string_format(name_buf, "meshes[%u].primitives[%u].attributes[%u]", i, j, k);
+                TEST_EQ(name_buf, pb->attributes[k].n,    pa->attributes[k].n,    false);
+                TEST_EQ(name_buf, pb->attributes[k].type, pa->attributes[k].type, false);
+                test_model_cache_accessor(name_buf, &pb->attributes[k].accessor, &pa->attributes[k].accessor,
+                                          cache_buffer, gltf_buffer);
+            }
+
+            for(u32 k = 0; k < pa->target_count; ++k) {
+                string_format(name_buf, "meshes[%u].primitives[%u].targets[%u]", i, j, k);
+                TEST_EQ(name_buf, pb->targets[k].attribute_count, pa->targets[k].attribute_count, false);
+                for(u32 l = 0; l < pa->targets[k].attribute_count; ++l)
+                    test_model_cache_accessor(name_buf, &pb->targets[k].attributes[l].accessor,
+                                              &pa->targets[k].attributes[l].accessor, cache_buffer, gltf_buffer);
+            }
+
+            string_format(name_buf, "meshes[%u].primitives[%u].meshlets", i, j);
+            TEST_EQ(name_buf, pb->meshlets ? (u8*)pb->meshlets - cache_buffer : -1,
+                    pa->meshlets ? (u8*)pa->meshlets - gltf_buffer : -1, false);
+            if (pa->meshlets && pb->meshlets) {
+                const Meshlets *ma = pa->meshlets;
+                const Meshlets *mb = pb->meshlets;
+                TEST_EQ(name_buf, mb->count,          ma->count,          false);
+                TEST_EQ(name_buf, mb->vertex_count,   ma->vertex_count,   false);
+                TEST_EQ(name_buf, mb->triangle_count, ma->triangle_count, false);
+                TEST_EQ(name_buf, (u8*)mb->meshlets  - cache_buffer, (u8*)ma->meshlets  - gltf_buffer, false);
+                TEST_EQ(name_buf, (u8*)mb->bounds    - cache_buffer, (u8*)ma->bounds    - gltf_buffer, false);
+                TEST_EQ(name_buf, (u8*)mb->vertices  - cache_buffer, (u8*)ma->vertices  - gltf_buffer, false);
+                TEST_EQ(name_buf, (u8*)mb->triangles - cache_buffer, (u8*)ma->triangles - gltf_buffer, false);
+                TEST_EQ(name_buf, memcmp(mb->meshlets,  ma->meshlets,  sizeof(Meshlet)        * ma->count),        0, false);
+                TEST_EQ(name_buf, memcmp(mb->bounds,    ma->bounds,    sizeof(Meshlet_Bounds) * ma->count),        0, false);
+                TEST_EQ(name_buf, memcmp(mb->vertices,  ma->vertices,  sizeof(u32)            * ma->vertex_count), 0, false);
+                TEST_EQ(name_buf, memcmp(mb->triangles, ma->triangles, 3 * (u64)ma->triangle_count),              0, false);
+            }
+
+            string_format(name_buf, "meshes[%u].primitives[%u].lods", i, j);
+            TEST_EQ(name_buf, pb->lods ? (u8*)pb->lods - cache_buffer : -1, pa->lods ? (u8*)pa->lods - gltf_buffer : -1,
+                    false);
+            if (pa->lods && pb->lods) {
+                TEST_EQ(name_buf, pb->lods->count,       pa->lods->count,       false);
+                TEST_EQ(name_buf, pb->lods->index_count, pa->lods->index_count, false);
+                TEST_EQ(name_buf, (u8*)pb->lods->lods    - cache_buffer, (u8*)pa->lods->lods    - gltf_buffer, false);
+                TEST_EQ(name_buf, (u8*)pb->lods->indices - cache_buffer, (u8*)pa->lods->indices - gltf_buffer, false);
+                TEST_EQ(name_buf, memcmp(pb->lods->lods,    pa->lods->lods,    sizeof(Mesh_Lod) * pa->lods->count),  0, false);
+                TEST_EQ(name_buf, memcmp(pb->lods->indices, pa->lods->indices, sizeof(u32) * pa->lods->index_count), 0, false);
+            }
+        }
+    }
+
+    // Stale: a buffer file changed, but the gltf did not.
+    const char *hash_gltf = "{\"buffers\":[{\"byteLength\":4,\"uri\":\"model_source_hash.bin\"}]}";
+    u8 hash_bin[8] = {};
+    file_write_bin("test/model_source_hash.gltf", strlen(hash_gltf), (void*)hash_gltf);
+    file_write_bin("test/model_source_hash.bin", 4, hash_bin);
+    source = parse_gltf_lazy("test/model_source_hash.gltf");
+    u64 hash_a = model_get_source_hash(&source, &model_dir);
+    TEST_EQ("source_hash_same", model_get_source_hash(&source, &model_dir), hash_a, false);
+    file_write_bin("test/model_source_hash.bin", 8, hash_bin);
+    TEST_EQ("source_hash_buffer_changed", model_get_source_hash(&source, &model_dir) != hash_a, true, false);
+    remove("test/model_source_hash.gltf");
+    remove("test/model_source_hash.bin");
+
+    destroy_model_allocators(&model_allocators);
+    remove(cache_file_name);
+
+    END_TEST_MODULE();
+}
+
+// A model cache as model_load_gltf(..) wrote it: the model pointed at itself (its allocation keys are still gltf
+// buffer views), and the vertex allocations' data.
+struct Test_Model_Cache_File {
+    Model                         model;
+    const Model_Cache_Header     *header;
+    const Model_Cache_Allocation *allocations;
+    const u8                     *file;
+};
+
+static bool test_read_model_cache(const char *file_name, Test_Model_Cache_File *ret) {
+    u64 size;
+    u8 *file = (u8*)file_read_bin_temp(file_name, &size);
+
+    ret->file        = file;
+    ret->header      = (const Model_Cache_Header*)file;
+    ret->allocations = (const Model_Cache_Allocation*)(file + ret->header->offset_allocations);
+
+    ret->model.size       = ret->header->model_size;
+    ret->model.mesh_count = ret->header->mesh_count;
+    ret->model.meshes     = (Mesh*)(file + ret->header->offset_model);
+    return model_cache_relocate((u8*)ret->model.meshes, ret->model.mesh_count, ret->model.size, 0,
+                                (u64)ret->model.meshes);
+}
+
+static u64 test_model_cache_vertex_size(const Test_Model_Cache_File *cache) {
+    u64 ret = 0;
+    for(u32 i = 0; i < cache->header->allocation_count; ++i)
+        ret += cache->allocations[i].index ? 0 : cache->allocations[i].size;
+    return ret;
+}
+
+static const u8* test_model_cache_accessor_data(const Test_Model_Cache_File *cache, const Accessor *accessor) {
+    for(u32 i = 0; i < cache->header->allocation_count; ++i)
+        if (!cache->allocations[i].index && cache->allocations[i].buffer_view == accessor->allocation_key)
+            return cache->file + cache->allocations[i].offset + accessor->byte_offset;
+    return NULL;
+}
+
+static float test_model_pack_angle(const float *a, const float *b) {
+    float c[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+    return atan2f(sqrtf(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]), a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) *
+           (180 / 3.14159265f);
+}
+
+// Decode packed snorm octahedral components as the vertex input would.
+static void test_model_pack_decode_octahedral(float *ret, const u8 *data, bool snorm8) {
+    float x = snorm8 ? ((const s8*)data)[0] / 127.0f : ((const s16*)data)[0] / 32767.0f;
+    float y = snorm8 ? ((const s8*)data)[1] / 127.0f : ((const s16*)data)[1] / 32767.0f;
+    mesh_decode_octahedral(ret, fmaxf(x, -1), fmaxf(y, -1));
+}
+
+static void test_model_pack_vertices() {
+    BEGIN_TEST_MODULE("Model_Pack_Vertices", false, false);
+
+    struct {
+        const char       *dir;
+        const char       *name;
+        Model_Load_Flags  flags;
+        float             ratio; // at least, unpacked vertex bytes over packed
+    } cases[] = {
+        {"models/cube-static/", "Cube.gltf",      MODEL_LOAD_PACK_VERTICES_BIT,                           2.2f}, // 48 -> 24 bytes per vertex, 36 -> 32 vertices
+        {"models/cube-static/", "Cube.gltf",      MODEL_LOAD_PACK_VERTICES_BIT | MODEL_LOAD_PACK_SNORM8_BIT, 2.9f}, // 48 -> 18
+        {"models/cesium-man/",  "CesiumMan.gltf", MODEL_LOAD_PACK_VERTICES_BIT,                          1.35f}, // joints and weights stay
+    };
+
+    const char *float_cache_name  = "test/pack_float.model";
+    const char *packed_cache_name = "test/pack_packed.model";
+
+    u32 size = 1024 * 1024;
+    u8 *float_buffer  = malloc_t(size, 16);
+    u8 *packed_buffer = malloc_t(size, 16);
+
+    Model_Allocators_Config model_allocators_config = {};
+    Model_Allocators        model_allocators;
+
+    char name_buf[127];
+    for(u32 c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        String model_dir  = cstr_to_string(cases[c].dir);
+        String model_name = cstr_to_string(cases[c].name);
+        bool   snorm8     = cases[c].flags & MODEL_LOAD_PACK_SNORM8_BIT;
+
+        u64 req_size;
+        model_allocators = create_model_allocators(&model_allocators_config);
+        model_load_gltf(&model_allocators, &model_dir, &model_name, size, float_buffer, &req_size, float_cache_name,
+                        MODEL_LOAD_DEFAULT_FLAGS);
+        destroy_model_allocators(&model_allocators);
+
+        model_allocators = create_model_allocators(&model_allocators_config);
+        model_load_gltf(&model_allocators, &model_dir, &model_name, size, packed_buffer, &req_size, packed_cache_name,
+                        cases[c].flags);
+        destroy_model_allocators(&model_allocators);
+
+        Test_Model_Cache_File a, b;
+        string_format(name_buf, "%s%s.read_caches", cases[c].name, snorm8 ? ".snorm8" : "");
+        bool read = test_read_model_cache(float_cache_name, &a) && test_read_model_cache(packed_cache_name, &b);
+        TEST_EQ(name_buf, read, true, false);
+        if (!read)
+            continue;
+
+        u64 float_size  = test_model_cache_vertex_size(&a);
+        u64 packed_size = test_model_cache_vertex_size(&b);
+        string_format(name_buf, "%s%s.ratio", cases[c].name, snorm8 ? ".snorm8" : "");
+        TEST_EQ(name_buf, float_size >= packed_size * cases[c].ratio, true, false);
+
+        // Every attribute decodes to within its encoding's error of the float data, in the format the pipelines get.
+        float max_step_error = 0;
+        float max_angle      = 0;
+        float max_uv_error   = 0;
+        bool  formats        = true;
+        bool  handedness     = true;
+        bool  copies_equal   = true;
+        bool  identity       = true;
+
+        float decoded[3];
+        float e;
+        const u8 *pa, *pb;
+        const Accessor *xa, *xb;
+        const Vertex_Dequantize *dequantize;
+        for(u32 i = 0; i < a.model.mesh_count; ++i) {
+            for(u32 j = 0; j < a.model.meshes[i].primitive_count; ++j) {
+                const Mesh_Primitive *prim_a = &a.model.meshes[i].primitives[j];
+                const Mesh_Primitive *prim_b = &b.model.meshes[i].primitives[j];
+                dequantize = &prim_b->position_dequantize;
+
+                identity &= prim_a->position_dequantize.scale[0] == 1 && prim_a->position_dequantize.offset[0] == 0;
+
+                for(u32 k = 0; k < prim_a->attribute_count; ++k) {
+                    xa = &prim_a->attributes[k].accessor;
+                    xb = &prim_b->attributes[k].accessor;
+                    pa = test_model_cache_accessor_data(&a, xa);
+                    pb = test_model_cache_accessor_data(&b, xb);
+                    if (!pa || !pb || xa->count != xb->count) {
+                        formats = false;
+                        continue;
+                    }
+
+                    for(u64 v = 0; v < xa->count; ++v) {
+                        const float *f = (const float*)(pa + v * xa->byte_stride);
+                        const u8    *q = pb + v * xb->byte_stride;
+                        switch(prim_a->attributes[k].type) {
+                        case MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION:
+                            for(u32 l = 0; l < 3; ++l) {
+                                e = dequantize->offset[l] + ((const u16*)q)[l] * dequantize->scale[l];
+                                e = fabsf(e - f[l]) / dequantize->scale[l];
+                                max_step_error = fmaxf(max_step_error, e);
+                            }
+                            break;
+                        case MESH_PRIMITIVE_ATTRIBUTE_TYPE_NORMAL:
+                            test_model_pack_decode_octahedral(decoded, q, snorm8);
+                            max_angle = fmaxf(max_angle, test_model_pack_angle(decoded, f));
+                            break;
+                        case MESH_PRIMITIVE_ATTRIBUTE_TYPE_TANGENT:
+                            test_model_pack_decode_octahedral(decoded, q, snorm8);
+                            max_angle   = fmaxf(max_angle, test_model_pack_angle(decoded, f));
+                            handedness &= snorm8 ? (((const s8*)q)[2] < 0) == (f[3] < 0) :
+                                                   (((const s16*)q)[2] < 0) == (f[3] < 0);
+                            break;
+                        case MESH_PRIMITIVE_ATTRIBUTE_TYPE_TEX_COORDS:
+                            for(u32 l = 0; l < 2; ++l) {
+                                e = fabsf(half_to_float(((const u16*)q)[l]) - f[l]);
+                                e = fabsf(f[l]) > 1.0f / 16384 ? e / fabsf(f[l]) : 0;
+                                max_uv_error = fmaxf(max_uv_error, e);
+                            }
+                            break;
+                        default:
+                            copies_equal &= memcmp(q, f, model_accessor_get_element_size(xa->flags)) == 0;
+                            break;
+                        }
+                    }
+
+                    VkFormat format = get_format_from_accessor_flags(xb->flags);
+                    switch(prim_a->attributes[k].type) {
+                    case MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION:
+                        formats &= format == VK_FORMAT_R16G16B16A16_UNORM && xb->byte_stride == 8;
+                        break;
+                    case MESH_PRIMITIVE_ATTRIBUTE_TYPE_NORMAL:
+                        formats &= format == (snorm8 ? VK_FORMAT_R8G8_SNORM : VK_FORMAT_R16G16_SNORM);
+                        break;
+                    case MESH_PRIMITIVE_ATTRIBUTE_TYPE_TANGENT:
+                        formats &= format == (snorm8 ? VK_FORMAT_R8G8B8A8_SNORM : VK_FORMAT_R16G16B16A16_SNORM);
+                        break;
+                    case MESH_PRIMITIVE_ATTRIBUTE_TYPE_TEX_COORDS:
+                        formats &= format == VK_FORMAT_R16G16_SFLOAT && xb->byte_stride == 4;
+                        break;
+                    default:
+                        formats &= format == get_format_from_accessor_flags(xa->flags);
+                        break;
+                    }
+                }
+            }
+        }
+
+        const char *suffix = snorm8 ? ".snorm8" : "";
+        string_format(name_buf, "%s%s.formats", cases[c].name, suffix);
+        TEST_EQ(name_buf, formats, true, false);
+        string_format(name_buf, "%s%s.float_identity", cases[c].name, suffix);
+        TEST_EQ(name_buf, identity, true, false);
+        string_format(name_buf, "%s%s.position_error", cases[c].name, suffix);
+        TEST_EQ(name_buf, max_step_error <= 0.51f, true, false); // Half a step, and float rounding in the decode
+        string_format(name_buf, "%s%s.direction_error", cases[c].name, suffix);
+        TEST_EQ(name_buf, max_angle < (snorm8 ? 0.7f : 0.01f), true, false);
+        string_format(name_buf, "%s%s.handedness", cases[c].name, suffix);
+        TEST_EQ(name_buf, handedness, true, false);
+        string_format(name_buf, "%s%s.uv_error", cases[c].name, suffix);
+        TEST_EQ(name_buf, max_uv_error <= 1.0f / 2048, true, false);
+        string_format(name_buf, "%s%s.copies_equal", cases[c].name, suffix);
+        TEST_EQ(name_buf, copies_equal, true, false);
+    }
+
+    remove(float_cache_name);
+    remove(packed_cache_name);
+
+    END_TEST_MODULE();
+}
+
+static void test_model_interleave_vertices() {
+    BEGIN_TEST_MODULE("Model_Interleave_Vertices", false, false);
+
+    struct {
+        const char       *dir;
+        const char       *name;
+        Model_Load_Flags  flags; // compared against a load with the same flags, less interleaving
+        u32               view_count; // gltf vertex views before
+    } cases[] = {
+        {"models/cube-static/", "Cube.gltf",      MODEL_LOAD_INTERLEAVE_VERTICES_BIT,                                4},
+        {"models/cube-static/", "Cube.gltf",      MODEL_LOAD_INTERLEAVE_VERTICES_BIT | MODEL_LOAD_PACK_VERTICES_BIT, 4},
+        {"models/cesium-man/",  "CesiumMan.gltf", MODEL_LOAD_INTERLEAVE_VERTICES_BIT,                                3},
+    };
+
+    const char *separate_cache_name    = "test/interleave_separate.model";
+    const char *interleaved_cache_name = "test/interleave_interleaved.model";
+
+    u32 size = 1024 * 1024;
+    u8 *separate_buffer    = malloc_t(size, 16);
+    u8 *interleaved_buffer = malloc_t(size, 16);
+
+    Model_Allocators_Config model_allocators_config = {};
+    Model_Allocators        model_allocators;
+
+    char name_buf[127];
+    for(u32 c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        String model_dir  = cstr_to_string(cases[c].dir);
+        String model_name = cstr_to_string(cases[c].name);
+        const char *suffix = cases[c].flags & MODEL_LOAD_PACK_VERTICES_BIT ? ".packed" : "";
+
+        u64 req_size;
+        model_allocators = create_model_allocators(&model_allocators_config);
+        model_load_gltf(&model_allocators, &model_dir, &model_name, size, separate_buffer, &req_size,
+                        separate_cache_name, cases[c].flags & ~MODEL_LOAD_INTERLEAVE_VERTICES_BIT);
+        destroy_model_allocators(&model_allocators);
+
+        model_allocators = create_model_allocators(&model_allocators_config);
+        model_load_gltf(&model_allocators, &model_dir, &model_name, size, interleaved_buffer, &req_size,
+                        interleaved_cache_name, cases[c].flags);
+        destroy_model_allocators(&model_allocators);
+
+        Test_Model_Cache_File a, b;
+        string_format(name_buf, "%s%s.read_caches", cases[c].name, suffix);
+        bool read = test_read_model_cache(separate_cache_name, &a) && test_read_model_cache(interleaved_cache_name, &b);
+        TEST_EQ(name_buf, read, true, false);
+        if (!read)
+            continue;
+
+        // One stream and one position stream for the one primitive, in place of a view per attribute.
+        u32 vertex_allocations[2] = {};
+        for(u32 i = 0; i < a.header->allocation_count; ++i)
+            vertex_allocations[0] += !a.allocations[i].index;
+        for(u32 i = 0; i < b.header->allocation_count; ++i)
+            vertex_allocations[1] += !b.allocations[i].index;
+        string_format(name_buf, "%s%s.separate_allocations", cases[c].name, suffix);
+        TEST_EQ(name_buf, vertex_allocations[0], cases[c].view_count, false);
+        string_format(name_buf, "%s%s.interleaved_allocations", cases[c].name, suffix);
+        TEST_EQ(name_buf, vertex_allocations[1], 2, false);
+
+        // Every attribute reads back the same through the stream, and the positions through the position stream.
+        bool interleaved = true;
+        bool equal       = true;
+        bool positions   = true;
+        const u8 *pa, *pb, *ps;
+        const Accessor *xa, *xb;
+        u32 element_size;
+        for(u32 i = 0; i < a.model.mesh_count; ++i) {
+            for(u32 j = 0; j < a.model.meshes[i].primitive_count; ++j) {
+                const Mesh_Primitive *prim_a = &a.model.meshes[i].primitives[j];
+                const Mesh_Primitive *prim_b = &b.model.meshes[i].primitives[j];
+
+                interleaved &= model_primitive_is_interleaved(prim_b) && !model_primitive_is_interleaved(prim_a);
+                interleaved &= prim_a->position_stream_key == Max_u32 && prim_b->position_stream_key != Max_u32;
+
+                for(u32 k = 0; k < prim_a->attribute_count; ++k) {
+                    xa = &prim_a->attributes[k].accessor;
+                    xb = &prim_b->attributes[k].accessor;
+                    pa = test_model_cache_accessor_data(&a, xa);
+                    pb = test_model_cache_accessor_data(&b, xb);
+                    if (!pa || !pb || xa->count != xb->count || xa->flags != xb->flags) {
+                        equal = false;
+                        continue;
+                    }
+
+                    element_size = model_accessor_get_element_size(xa->flags);
+                    for(u64 v = 0; v < xa->count; ++v)
+                        equal &= memcmp(pa + v * xa->byte_stride, pb + v * xb->byte_stride, element_size) == 0;
+
+                    if (prim_a->attributes[k].type != MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION)
+                        continue;
+
+                    Accessor stream = *xb;
+                    stream.allocation_key = prim_b->position_stream_key;
+                    stream.byte_offset    = 0;
+                    ps = test_model_cache_accessor_data(&b, &stream);
+                    positions &= ps != NULL;
+                    for(u64 v = 0; ps && v < xa->count; ++v)
+                        positions &= memcmp(pa + v * xa->byte_stride, ps + v * element_size, element_size) == 0;
+                }
+            }
+        }
+        string_format(name_buf, "%s%s.interleaved", cases[c].name, suffix);
+        TEST_EQ(name_buf, interleaved, true, false);
+        string_format(name_buf, "%s%s.attributes_equal", cases[c].name, suffix);
+        TEST_EQ(name_buf, equal, true, false);
+        string_format(name_buf, "%s%s.position_stream", cases[c].name, suffix);
+        TEST_EQ(name_buf, positions, true, false);
+    }
+
+    remove(separate_cache_name);
+    remove(interleaved_cache_name);
+
+    END_TEST_MODULE();
+}
+
+static void test_model_merge_views() {
+    BEGIN_TEST_MODULE("Model_Merge_Views", false, false);
+
+    struct {
+        const char       *dir;
+        const char       *name;
+        Model_Load_Flags  flags; // compared against a load with the same flags, less merging
+        u32               view_count[2]; // vertex allocations before and after
+    } cases[] = {
+        {"models/cube-static/", "Cube.gltf",      MODEL_LOAD_MERGE_VIEWS_BIT,                                  {4, 1}},
+        {"models/cube-static/", "Cube.gltf",      MODEL_LOAD_MERGE_VIEWS_BIT | MODEL_LOAD_PACK_VERTICES_BIT,   {4, 1}},
+        // Already one stream (and a position stream), so nothing to merge.
+        {"models/cube-static/", "Cube.gltf",      MODEL_LOAD_MERGE_VIEWS_BIT | MODEL_LOAD_INTERLEAVE_VERTICES_BIT, {2, 2}},
+        {"models/cesium-man/",  "CesiumMan.gltf", MODEL_LOAD_MERGE_VIEWS_BIT,                                  {3, 1}},
+    };
+
+    const char *separate_cache_name = "test/merge_separate.model";
+    const char *merged_cache_name   = "test/merge_merged.model";
+
+    u32 size = 1024 * 1024;
+    u8 *separate_buffer = malloc_t(size, 16);
+    u8 *merged_buffer   = malloc_t(size, 16);
+
+    Model_Allocators_Config model_allocators_config = {};
+    Model_Allocators        model_allocators;
+
+    char name_buf[127];
+    for(u32 c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        String model_dir  = cstr_to_string(cases[c].dir);
+        String model_name = cstr_to_string(cases[c].name);
+        const char *suffix = cases[c].flags & MODEL_LOAD_PACK_VERTICES_BIT       ? ".packed"      :
+                             cases[c].flags & MODEL_LOAD_INTERLEAVE_VERTICES_BIT ? ".interleaved" : "";
+
+        u64 req_size;
+        model_allocators = create_model_allocators(&model_allocators_config);
+        model_load_gltf(&model_allocators, &model_dir, &model_name, size, separate_buffer, &req_size,
+                        separate_cache_name, cases[c].flags & ~MODEL_LOAD_MERGE_VIEWS_BIT);
+        destroy_model_allocators(&model_allocators);
+
+        model_allocators = create_model_allocators(&model_allocators_config);
+        model_load_gltf(&model_allocators, &model_dir, &model_name, size, merged_buffer, &req_size,
+                        merged_cache_name, cases[c].flags);
+        destroy_model_allocators(&model_allocators);
+
+        Test_Model_Cache_File a, b;
+        string_format(name_buf, "%s%s.read_caches", cases[c].name, suffix);
+        bool read = test_read_model_cache(separate_cache_name, &a) && test_read_model_cache(merged_cache_name, &b);
+        TEST_EQ(name_buf, read, true, false);
+        if (!read)
+            continue;
+
+        // The indices are already one view per primitive, so only the vertex allocations change, and they get no
+        // bigger (the merged view only holds what the accessors reference, with the same 16 byte alignment).
+        u32 index_allocations[2]  = {};
+        u32 vertex_allocations[2] = {};
+        u64 vertex_size[2]        = {};
+        for(u32 i = 0; i < a.header->allocation_count; ++i) {
+            index_allocations[0]  +=  a.allocations[i].index;
+            vertex_allocations[0] += !a.allocations[i].index;
+            vertex_size[0]        += a.allocations[i].index ? 0 : align(a.allocations[i].size, 16);
+        }
+        for(u32 i = 0; i < b.header->allocation_count; ++i) {
+            index_allocations[1]  +=  b.allocations[i].index;
+            vertex_allocations[1] += !b.allocations[i].index;
+            vertex_size[1]        += b.allocations[i].index ? 0 : align(b.allocations[i].size, 16);
+        }
+        string_format(name_buf, "%s%s.separate_allocations", cases[c].name, suffix);
+        TEST_EQ(name_buf, vertex_allocations[0], cases[c].view_count[0], false);
+        string_format(name_buf, "%s%s.merged_allocations", cases[c].name, suffix);
+        TEST_EQ(name_buf, vertex_allocations[1], cases[c].view_count[1], false);
+        string_format(name_buf, "%s%s.index_allocations", cases[c].name, suffix);
+        TEST_EQ(name_buf, index_allocations[1], index_allocations[0], false);
+        string_format(name_buf, "%s%s.merged_size", cases[c].name, suffix);
+        TEST_EQ(name_buf, vertex_size[1] <= vertex_size[0], true, false);
+
+        // Every attribute and morph target reads back the same through its rebased accessor, and a primitive's
+        // vertex accessors share one allocation.
+        bool equal  = true;
+        bool merged = true;
+        bool kept   = true; // interleaving
+        const u8 *pa, *pb;
+        const Accessor *xa, *xb;
+        u32 element_size;
+        for(u32 i = 0; i < a.model.mesh_count; ++i) {
+            for(u32 j = 0; j < a.model.meshes[i].primitive_count; ++j) {
+                const Mesh_Primitive *prim_a = &a.model.meshes[i].primitives[j];
+                const Mesh_Primitive *prim_b = &b.model.meshes[i].primitives[j];
+
+                kept &= model_primitive_is_interleaved(prim_a) == model_primitive_is_interleaved(prim_b);
+
+                u32 attribute_count = prim_a->attribute_count;
+                for(u32 k = 0; k < prim_a->target_count; ++k)
+                    attribute_count += prim_a->targets[k].attribute_count;
+
+                for(u32 k = 0; k < attribute_count; ++k) {
+                    u32 target = 0;
+                    u32 index  = k;
+                    if (k < prim_a->attribute_count) {
+                        xa = &prim_a->attributes[k].accessor;
+                        xb = &prim_b->attributes[k].accessor;
+                    } else {
+                        for(index -= prim_a->attribute_count; index >= prim_a->targets[target].attribute_count;
+                            index -= prim_a->targets[target++].attribute_count);
+                        xa = &prim_a->targets[target].attributes[index].accessor;
+                        xb = &prim_b->targets[target].attributes[index].accessor;
+                    }
+                    merged &= xb->allocation_key == prim_b->attributes[0].accessor.allocation_key;
+
+                    pa = test_model_cache_accessor_data(&a, xa);
+                    pb = test_model_cache_accessor_data(&b, xb);
+                    if (!pa || !pb || xa->count != xb->count || xa->flags != xb->flags) {
+                        equal = false;
+                        continue;
+                    }
+
+                    element_size = model_accessor_get_element_size(xa->flags);
+                    for(u64 v = 0; v < xa->count; ++v)
+                        equal &= memcmp(pa + v * xa->byte_stride, pb + v * xb->byte_stride, element_size) == 0;
+                }
+            }
+        }
+        string_format(name_buf, "%s%s.attributes_equal", cases[c].name, suffix);
+        TEST_EQ(name_buf, equal, true, false);
+        string_format(name_buf, "%s%s.one_allocation", cases[c].name, suffix);
+        TEST_EQ(name_buf, merged, true, false);
+        string_format(name_buf, "%s%s.interleaving_kept", cases[c].name, suffix);
+        TEST_EQ(name_buf, kept, true, false);
+    }
+
+    remove(separate_cache_name);
+    remove(merged_cache_name);
+
+    END_TEST_MODULE();
+}
+
+// An index accessor's indices from a cache, widened to u32 (decoded first if the allocation was compressed).
+static bool test_model_cache_indices(const Test_Model_Cache_File *cache, const Accessor *accessor, u32 *ret) {
+    const Model_Cache_Allocation *allocation = NULL;
+    for(u32 i = 0; i < cache->header->allocation_count; ++i)
+        if (cache->allocations[i].index && cache->allocations[i].buffer_view == accessor->allocation_key)
+            allocation = &cache->allocations[i];
+    if (!allocation)
+        return false;
+
+    const u8 *data = cache->file + allocation->offset;
+    if (allocation->encoded_size) {
+        u8 *decoded = malloc_t(allocation->size, 16);
+        if (!mesh_decode_indices(decoded, allocation->index_size, allocation->size / allocation->index_size, data,
+                                 allocation->encoded_size))
+        {
+            return false;
+        }
+        data = decoded;
+    }
+    data += accessor->byte_offset;
+
+    for(u32 i = 0; i < accessor->count; ++i) {
+        if (accessor->flags & ACCESSOR_COMPONENT_TYPE_UCHAR_BIT)
+            ret[i] = data[i];
+        else if (accessor->flags & ACCESSOR_COMPONENT_TYPE_U16_BIT)
+            ret[i] = ((const u16*)data)[i];
+        else
+            ret[i] = ((const u32*)data)[i];
+    }
+    return true;
+}
+
+static void test_model_narrow_indices() {
+    BEGIN_TEST_MODULE("Model_Narrow_Indices", false, false);
+
+    struct {
+        const char       *dir;
+        const char       *name;
+        Model_Load_Flags  flags; // compared against a load with the same flags, less narrowing and compression
+        u32               index_count[2]; // index allocations before and after
+    } cases[] = {
+        // A u32 and a u8 accessor in one view, the u32 one used by two primitives.
+        {"test/",               "test_index_narrowing.gltf", MODEL_LOAD_NARROW_INDICES_BIT,                                   {1, 1}},
+        {"test/",               "test_index_narrowing.gltf", MODEL_LOAD_NARROW_INDICES_BIT | MODEL_LOAD_COMPRESS_INDICES_BIT, {1, 1}},
+        {"models/cube-static/", "Cube.gltf",                 MODEL_LOAD_NARROW_INDICES_BIT,                                   {1, 1}},
+        {"models/cesium-man/",  "CesiumMan.gltf",            MODEL_LOAD_NARROW_INDICES_BIT | MODEL_LOAD_COMPRESS_INDICES_BIT, {1, 1}},
+    };
+
+    const char *wide_cache_name   = "test/narrow_wide.model";
+    const char *narrow_cache_name = "test/narrow_narrow.model";
+
+    u32 size = 1024 * 1024;
+    u8 *wide_buffer   = malloc_t(size, 16);
+    u8 *narrow_buffer = malloc_t(size, 16);
+
+    Model_Allocators_Config model_allocators_config = {};
+    Model_Allocators        model_allocators;
+
+    char name_buf[127];
+    for(u32 c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        String model_dir  = cstr_to_string(cases[c].dir);
+        String model_name = cstr_to_string(cases[c].name);
+        bool   compress   = cases[c].flags & MODEL_LOAD_COMPRESS_INDICES_BIT;
+        const char *suffix = compress ? ".compressed" : "";
+
+        u64 req_size;
+        model_allocators = create_model_allocators(&model_allocators_config);
+        model_load_gltf(&model_allocators, &model_dir, &model_name, size, wide_buffer, &req_size, wide_cache_name,
+                        cases[c].flags & ~(MODEL_LOAD_NARROW_INDICES_BIT | MODEL_LOAD_COMPRESS_INDICES_BIT));
+        destroy_model_allocators(&model_allocators);
+
+        model_allocators = create_model_allocators(&model_allocators_config);
+        model_load_gltf(&model_allocators, &model_dir, &model_name, size, narrow_buffer, &req_size, narrow_cache_name,
+                        cases[c].flags);
+        destroy_model_allocators(&model_allocators);
+
+        Test_Model_Cache_File a, b;
+        string_format(name_buf, "%s%s.read_caches", cases[c].name, suffix);
+        bool read = test_read_model_cache(wide_cache_name, &a) && test_read_model_cache(narrow_cache_name, &b);
+        TEST_EQ(name_buf, read, true, false);
+        if (!read)
+            continue;
+
+        u32 index_allocations[2] = {};
+        for(u32 i = 0; i < a.header->allocation_count; ++i)
+            index_allocations[0] += a.allocations[i].index;
+
+        u32 encoded_count = 0;
+        bool smaller      = true;
+        for(u32 i = 0; i < b.header->allocation_count; ++i) {
+            index_allocations[1] += b.allocations[i].index;
+            encoded_count        += b.allocations[i].encoded_size > 0;
+            smaller              &= b.allocations[i].encoded_size < b.allocations[i].size;
+        }
+        string_format(name_buf, "%s%s.wide_allocations", cases[c].name, suffix);
+        TEST_EQ(name_buf, index_allocations[0], cases[c].index_count[0], false);
+        string_format(name_buf, "%s%s.narrow_allocations", cases[c].name, suffix);
+        TEST_EQ(name_buf, index_allocations[1], cases[c].index_count[1], false);
+        string_format(name_buf, "%s%s.encoded", cases[c].name, suffix);
+        TEST_EQ(name_buf, encoded_count, compress ? index_allocations[1] : 0, false);
+        string_format(name_buf, "%s%s.encoded_smaller", cases[c].name, suffix);
+        TEST_EQ(name_buf, smaller, true, false);
+
+        // Every primitive draws the same indices, now u16, and accessors which were shared still are.
+        bool u16_indices = true;
+        bool equal       = true;
+        bool shared      = true;
+        u32 *wide, *narrow;
+        for(u32 i = 0; i < a.model.mesh_count; ++i) {
+            for(u32 j = 0; j < a.model.meshes[i].primitive_count; ++j) {
+                const Accessor *xa = &a.model.meshes[i].primitives[j].indices;
+                const Accessor *xb = &b.model.meshes[i].primitives[j].indices;
+
+                u16_indices &= (xb->flags & ACCESSOR_COMPONENT_TYPE_U16_BIT) && xb->byte_stride == 2;
+
+                wide   = (u32*)malloc_t(sizeof(u32) * xa->count, 16);
+                narrow = (u32*)malloc_t(sizeof(u32) * xa->count, 16);
+                if (xa->count != xb->count || !test_model_cache_indices(&a, xa, wide) ||
+                    !test_model_cache_indices(&b, xb, narrow))
+                {
+                    equal = false;
+                    continue;
+                }
+                equal &= memcmp(wide, narrow, sizeof(u32) * xa->count) == 0;
+
+                for(u32 k = 0; k < j; ++k) {
+                    const Accessor *ya = &a.model.meshes[i].primitives[k].indices;
+                    const Accessor *yb = &b.model.meshes[i].primitives[k].indices;
+                    if (ya->allocation_key == xa->allocation_key && ya->byte_offset == xa->byte_offset &&
+                        ya->count == xa->count && ya->flags == xa->flags)
+                    {
+                        shared &= yb->allocation_key == xb->allocation_key && yb->byte_offset == xb->byte_offset;
+                    }
+                }
+            }
+        }
+        string_format(name_buf, "%s%s.u16_indices", cases[c].name, suffix);
+        TEST_EQ(name_buf, u16_indices, true, false);
+        string_format(name_buf, "%s%s.indices_equal", cases[c].name, suffix);
+        TEST_EQ(name_buf, equal, true, false);
+        string_format(name_buf, "%s%s.accessors_shared", cases[c].name, suffix);
+        TEST_EQ(name_buf, shared, true, false);
+
+        // The cache loads, decoding what was compressed.
+        Model cache_model;
+        model_allocators = create_model_allocators(&model_allocators_config);
+        bool cached = model_load_cache(&model_allocators, narrow_cache_name, b.header->source_hash, cases[c].flags,
+                                       size, narrow_buffer, &cache_model, &req_size);
+        destroy_model_allocators(&model_allocators);
+        string_format(name_buf, "%s%s.cache_loads", cases[c].name, suffix);
+        TEST_EQ(name_buf, cached, true, false);
+    }
+
+    remove(wide_cache_name);
+    remove(narrow_cache_name);
+
+    END_TEST_MODULE();
+}
+
+static void test_model_dedup() {
+    BEGIN_TEST_MODULE("Model_Dedup", false, false);
+
+    Model_Allocators_Config model_allocators_config = {};
+    Model_Allocators        model_allocators = create_model_allocators(&model_allocators_config);
+
+    String cube_dir    = cstr_to_string("models/cube-static/");
+    String cube_name   = cstr_to_string("Cube.gltf");
+    String cesium_dir  = cstr_to_string("models/cesium-man/");
+    String cesium_name = cstr_to_string("CesiumMan.gltf");
+
+    u32 size = 1024 * 1024;
+    u8 *buffers[2] = {malloc_t(size, 16), malloc_t(size, 16)};
+
+    u64   req_size;
+    Model models[2];
+    models[0] = model_load_gltf(&model_allocators, &cube_dir, &cube_name, size, buffers[0], &req_size, NULL,
+                                MODEL_LOAD_DEFAULT_FLAGS);
+
+    Gpu_Allocator *allocators[] = {&model_allocators.index, &model_allocators.vertex};
+    u32 counts[2]     = {allocators[0]->allocation_count, allocators[1]->allocation_count};
+    u64 disk_sizes[2] = {allocators[0]->disk_size,        allocators[1]->disk_size};
+
+    // The same model again: every submission is a duplicate.
+    models[1] = model_load_gltf(&model_allocators, &cube_dir, &cube_name, size, buffers[1], &req_size, NULL,
+                                MODEL_LOAD_DEFAULT_FLAGS);
+
+    TEST_EQ("index.allocation_count",  allocators[0]->allocation_count, counts[0],     false);
+    TEST_EQ("vertex.allocation_count", allocators[1]->allocation_count, counts[1],     false);
+    TEST_EQ("index.disk_size",         allocators[0]->disk_size,        disk_sizes[0], false);
+    TEST_EQ("vertex.disk_size",        allocators[1]->disk_size,        disk_sizes[1], false);
+    TEST_EQ("index.dedup_count",       allocators[0]->dedup_count,      counts[0],     false);
+    TEST_EQ("vertex.dedup_count",      allocators[1]->dedup_count,      counts[1],     false);
+    TEST_EQ("index.dedup_byte_count",  allocators[0]->dedup_byte_count, disk_sizes[0], false);
+    TEST_EQ("vertex.dedup_byte_count", allocators[1]->dedup_byte_count, disk_sizes[1], false);
+
+    bool same_keys = true;
+    for(u32 i = 0; i < models[0].mesh_count; ++i) {
+        for(u32 j = 0; j < models[0].meshes[i].primitive_count; ++j) {
+            const Mesh_Primitive *a = &models[0].meshes[i].primitives[j];
+            const Mesh_Primitive *b = &models[1].meshes[i].primitives[j];
+
+            same_keys &= a->indices.allocation_key == b->indices.allocation_key;
+            for(u32 k = 0; k < a->attribute_count; ++k)
+                same_keys &= a->attributes[k].accessor.allocation_key == b->attributes[k].accessor.allocation_key;
+        }
+    }
+    TEST_EQ("same_keys", same_keys, true, false);
+
+    // Other bytes are still new allocations.
+    model_load_gltf(&model_allocators, &cesium_dir, &cesium_name, size, buffers[0], &req_size, NULL,
+                    MODEL_LOAD_DEFAULT_FLAGS);
+    TEST_LT("index.new_allocations",  counts[0], allocators[0]->allocation_count, false);
+    TEST_LT("vertex.new_allocations", counts[1], allocators[1]->allocation_count, false);
+    TEST_EQ("vertex.new_dedup_count", allocators[1]->dedup_count, counts[1], false);
+
     destroy_model_allocators(&model_allocators);
 
     END_TEST_MODULE();
 }
 
+// Converting many models as one job list gives the same model buffers as converting one with a single thread.
+static void test_model_convert_jobs() {
+    BEGIN_TEST_MODULE("Model_Convert_Jobs", false, false);
+
+    const char *files[] = {
+        "models/cesium-man/CesiumMan.gltf",
+        "models/cube-static/Cube.gltf",
+        "test/test_index_narrowing.gltf",
+    };
+    const u32 copy_count = 8;
+
+    u8 *buffers[copy_count + 1];
+    Model_Gltf_Conversion conversions[copy_count + 1];
+    for(u32 f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        u64 mark = get_mark_temp();
+
+        Gltf gltf = parse_gltf(files[f]);
+        Model_Req_Size_Info req_size = model_get_required_size_from_gltf(&gltf, MODEL_LOAD_DEFAULT_FLAGS);
+
+        u32 mesh_count                  = gltf_mesh_get_count(&gltf);
+        u64 buffer_offset_primitives    = align(sizeof(Mesh) * mesh_count, 16);
+        u64 buffer_offset_accessor_data = buffer_offset_primitives    + req_size.primitives;
+        u64 buffer_offset_weights       = buffer_offset_accessor_data + req_size.accessors;
+
+        for(u32 i = 0; i <= copy_count; ++i) {
+            buffers[i] = malloc_t(req_size.total, 16);
+            memset(buffers[i], 0, req_size.total);
+            model_begin_gltf_conversion(&gltf, buffers[i], buffer_offset_primitives, buffer_offset_accessor_data,
+                                        buffer_offset_weights, &conversions[i]);
+        }
+
+        // The last is the reference
+        set_job_thread_limit(1);
+        model_convert_gltfs(1, &conversions[copy_count]);
+        set_job_thread_limit(get_job_thread_count());
+
+        model_convert_gltfs(copy_count, conversions);
+
+        u32 relocated = 0;
+        u32 equal     = 0;
+        relocated += model_cache_relocate(buffers[copy_count], mesh_count, req_size.total, (u64)buffers[copy_count], 0);
+        for(u32 i = 0; i < copy_count; ++i) {
+            relocated += model_cache_relocate(buffers[i], mesh_count, req_size.total, (u64)buffers[i], 0);
+            equal     += memcmp(buffers[i], buffers[copy_count], req_size.total) == 0;
+        }
+        TEST_EQ(files[f], relocated, copy_count + 1, false);
+        TEST_EQ(files[f], equal,     copy_count,     false);
+
+        reset_to_mark_temp(mark);
+    }
+
+    END_TEST_MODULE();
+}
+
+static void test_model_accessor_overlaps() {
+    BEGIN_TEST_MODULE("Model_Accessor_Overlaps", false, false);
+
+    u64 mark = get_mark_temp();
+
+    // Shared, adjacent, nested, same begin, another buffer, and a chain where the first and last do not touch.
+    const u64 buffer_1 = (u64)1 << 40;
+    Model_Accessor_Range ranges[] = {
+        {  0, 100}, {100, 200}, {300, 400}, {350, 380}, {500, 600}, {500, 650},
+        {buffer_1, buffer_1 + 50}, {700, 800}, {750, 900}, {850, 1000},
+    };
+    bool expect[] = {false, false, true, true, true, true, false, true, true, true};
+
+    Model_Accessor_Ref refs[32] = {};
+    Model_Mesh_Optimize_Info info = {};
+    info.ref_table_size = 32;
+    info.refs           = refs;
+    for(u32 i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i)
+        refs[i * 3 + 1] = {.range = ranges[i], .count = 1};
+
+    model_find_overlapping_accessor_refs(&info);
+
+    char name_buf[127];
+    for(u32 i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i) {
+        string_format(name_buf, "ranges[%u].overlapped", i);
+        TEST_EQ(name_buf, refs[i * 3 + 1].overlapped, expect[i], false);
+    }
+
+    reset_to_mark_temp(mark);
+
+    END_TEST_MODULE();
+}
+
+static void test_select_primitive_lod() {
+    BEGIN_TEST_MODULE("Lod_Selection", false, false);
+
+    Mesh_Lod       lod_array[3] = {{0, 0, 0.01f}, {0, 0, 0.05f}, {0, 0, 0.2f}};
+    Mesh_Lods      lods         = {.count = 3, .lods = lod_array};
+    Mesh_Primitive primitive    = {};
+
+    // A 90 degree fov over 1000 pixels: 500 pixels per unit at a distance of 1. The camera is at z = 3, looking -z.
+    Camera          camera = create_camera();
+    Lod_Select_Info info   = get_lod_select_info(&camera, rad(90), 1000, 1);
+    TEST_EQ("pixels_per_unit", (u64)(info.pixels_per_unit + 0.5f), 500, false);
+
+    float center[3] = {0, 0, 3 - 10};
+    TEST_EQ("no_lods", select_primitive_lod(&primitive, &info, center, 0, 1, 0), 0, false);
+    primitive.lods = &lods;
+
+    // 50 pixels per unit: 0.5, 2.5 and 10 pixels.
+    TEST_EQ("near",   select_primitive_lod(&primitive, &info, center, 0, 1, 0), 1, false);
+    TEST_EQ("inside", select_primitive_lod(&primitive, &info, center, 10, 1, 3), 0, false);
+
+    // 0.5 pixels per unit, every lod is under a pixel.
+    center[2] = 3 - 1000;
+    TEST_EQ("far", select_primitive_lod(&primitive, &info, center, 0, 1, 0), 3, false);
+
+    // 90 pixels per unit: lod 1 is 0.9 pixels, so it is kept if it was already used, but not moved to.
+    center[2] = 3 - 500.0f / 90;
+    TEST_EQ("hysteresis_stay", select_primitive_lod(&primitive, &info, center, 0, 1, 1), 1, false);
+    TEST_EQ("hysteresis_hold", select_primitive_lod(&primitive, &info, center, 0, 1, 0), 0, false);
+
+    // The radius brings the instance closer, and scale makes its error bigger.
+    center[2] = 3 - 10;
+    TEST_EQ("radius", select_primitive_lod(&primitive, &info, center, 5, 1, 0), 0, false);
+    center[2] = 3 - 1000;
+    TEST_EQ("scale",  select_primitive_lod(&primitive, &info, center, 0, 8, 0), 2, false);
+
+    END_TEST_MODULE();
+}
+
 #endif // if TEST
+
+#if BENCH
+//
+// Gltf parsing and model loading at scale, over files from the generator (test/gltf_generator.cpp). The files are
+// rewritten to test/generated/ on every run, so they always match the generator. Every stage is timed warm (the
+// files are in the page cache, as when a model is reloaded) and cold (the files are dropped from the page cache
+// before each iteration, as on a first load):
+//
+//     parse_gltf_stream(..)                 - bounded memory, so it runs at every scale
+//     parse_gltf(..)                        - only while the text and its sections fit in the temp allocator
+//     model_get_required_size_from_gltf(..) - over a parsed file, so there is no cold run
+//     model_from_gltf(..)                   - parse, size and load into fresh model allocators, small scales only
+//
+// Then the gltf to model conversion of many models at once, as one job list, against the number of job threads
+// (see bench_asset_model_jobs(..)).
+//
+// Throughput is bytes of json (plus the bin for model_from_gltf(..)), entities are the elements of every top
+// level array in the file.
+//
+static const u64 BENCH_ASSET_PARSE_LIMIT = 12 * 1024 * 1024; // Json bytes
+static const u64 BENCH_ASSET_MODEL_LIMIT =  4 * 1024 * 1024; // Json and bin bytes
+
+struct Bench_Asset_Scene {
+    char   gltf_path[128];
+    char   bin_path[128];
+    char   gltf_file_name[64];
+    u64    json_size;
+    u64    bin_size;
+    u64    entity_count;
+};
+
+static void bench_asset_drop_scene(const Bench_Asset_Scene *scene, bool cold) {
+    if (!cold)
+        return;
+    bench_drop_file_cache(scene->gltf_path);
+    bench_drop_file_cache(scene->bin_path);
+}
+
+static bool bench_asset_count_element(void *user_data, Gltf_Section section, int index, const void *element) {
+    *(u64*)user_data += 1;
+    return true;
+}
+
+static void bench_asset_report(const char *stage, bool cold, u64 ns, u64 bytes, u64 entity_count, u64 iterations) {
+    char name[128];
+    string_format(name, "%s, %s", stage, cold ? "cold" : "warm");
+    bench_report_throughput(name, ns, bytes, iterations);
+    bench_report_rate(name, "entities", ns, entity_count * iterations);
+}
+
+static void bench_asset_model_jobs(const char *dir);
+
+void bench_asset() {
+    BENCH_MODULE("Asset");
+
+    const char *dir = "test/generated/";
+    mkdir("test/generated", 0755); // Fails harmlessly if it exists
+
+    const u64 entity_counts[] = {1, 100, 10'000, 100'000, 1'000'000};
+    for(u32 scale = 0; scale < sizeof(entity_counts) / sizeof(entity_counts[0]); ++scale) {
+        char name[32];
+        string_format(name, "bench_scene_%u", entity_counts[scale]);
+
+        Gltf_Generator_Config config = gltf_generator_config_from_entity_count(entity_counts[scale]);
+        Gltf_Generator_Stats  stats;
+        if (!gltf_generate(dir, name, &config, &stats)) {
+            println("    Failed to write %s%s, skipping", dir, name);
+            continue;
+        }
+
+        Bench_Asset_Scene scene;
+        string_format(scene.gltf_path,      "%s%s.gltf", dir, name);
+        string_format(scene.bin_path,       "%s%s.bin",  dir, name);
+        string_format(scene.gltf_file_name, "%s.gltf",   name);
+        scene.json_size    = stats.json_size;
+        scene.bin_size     = stats.bin_size;
+        scene.entity_count = stats.entity_count;
+
+        println("\n    %s: %u entities (%u meshes, %u accessors, %u nodes), %u bytes json, %u bytes bin",
+                name, stats.entity_count, stats.mesh_count, stats.accessor_count, stats.node_count,
+                stats.json_size, stats.bin_size);
+
+        // Aim for roughly the same total work at each scale.
+        u64 iterations = entity_counts[scale] >= 100'000 ? 3 : entity_counts[scale] >= 10'000 ? 10 : 200;
+
+        bool parse_in_memory = scene.json_size <= BENCH_ASSET_PARSE_LIMIT;
+        bool load_model      = scene.json_size + scene.bin_size <= BENCH_ASSET_MODEL_LIMIT;
+
+        u64 streamed_count = 0;
+        Gltf_Stream_Info stream_info = {};
+        stream_info.chunk_size = 1024 * 1024;
+        stream_info.callback   = bench_asset_count_element;
+        stream_info.user_data  = &streamed_count;
+
+        u64 ns;
+        Bench_Timer timer;
+        for(u32 cold = 0; cold < 2; ++cold) {
+            // Streaming parse
+            ns = 0;
+            for(u32 i = 0; i < iterations; ++i) {
+                bench_asset_drop_scene(&scene, cold);
+                timer = begin_bench();
+                Gltf_Stream_Result result = parse_gltf_stream(scene.gltf_path, &stream_info, NULL);
+                ns += end_bench(&timer);
+                assert(result == GLTF_STREAM_RESULT_SUCCESS);
+                assert(streamed_count == scene.entity_count && "Generator entity count does not match the file");
+                streamed_count = 0;
+            }
+            bench_asset_report("parse_gltf_stream", cold, ns, scene.json_size, scene.entity_count, iterations);
+
+            if (!parse_in_memory)
+                continue;
+
+            // In memory parse
+            ns = 0;
+            for(u32 i = 0; i < iterations; ++i) {
+                u64 mark = get_mark_temp();
+                bench_asset_drop_scene(&scene, cold);
+                timer = begin_bench();
+                Gltf gltf = parse_gltf(scene.gltf_path);
+                ns += end_bench(&timer);
+                bench_keep(gltf.accessors);
+                reset_to_mark_temp(mark);
+            }
+            bench_asset_report("parse_gltf", cold, ns, scene.json_size, scene.entity_count, iterations);
+        }
+
+        if (!parse_in_memory)
+            continue;
+
+        // Required size, over a parsed file
+        u64  mark = get_mark_temp();
+        Gltf gltf = parse_gltf(scene.gltf_path);
+
+        Model_Req_Size_Info req_size;
+        u64 size_iterations = iterations * 10;
+        timer = begin_bench();
+        for(u32 i = 0; i < size_iterations; ++i) {
+            req_size = model_get_required_size_from_gltf(&gltf, MODEL_LOAD_DEFAULT_FLAGS);
+            bench_keep(req_size);
+        }
+        ns = end_bench(&timer);
+        bench_asset_report("model_get_required_size_from_gltf", false, ns, scene.json_size, scene.entity_count, size_iterations);
+
+        reset_to_mark_temp(mark);
+
+        if (!load_model)
+            continue;
+
+        // Model load, into fresh allocators each time so that every iteration does the same work.
+        String model_dir       = cstr_to_string(dir);
+        String model_file_name = cstr_to_string(scene.gltf_file_name);
+
+        u8 *model_buffer = malloc_h(req_size.total, 16);
+        Model_Allocators_Config model_allocators_config = {};
+
+        u64 model_size = scene.json_size + scene.bin_size;
+        u64 req_size_total;
+        for(u32 cold = 0; cold < 2; ++cold) {
+            ns = 0;
+            for(u32 i = 0; i < iterations; ++i) {
+                Model_Allocators model_allocators = create_model_allocators(&model_allocators_config);
+                bench_asset_drop_scene(&scene, cold);
+
+                timer = begin_bench();
+                Model model = model_from_gltf(&model_allocators, &model_dir, &model_file_name, req_size.total,
+                                              model_buffer, &req_size_total, MODEL_LOAD_DEFAULT_FLAGS);
+                ns += end_bench(&timer);
+
+                bench_keep(model.meshes);
+                destroy_model_allocators(&model_allocators);
+            }
+            bench_asset_report("model_from_gltf", cold, ns, model_size, scene.entity_count, iterations);
+        }
+
+        free_h(model_buffer);
+    }
+
+    bench_asset_model_jobs(dir);
+}
+
+//
+// Converts one scene into BENCH_ASSET_JOB_MODEL_COUNT model buffers with a single model_convert_gltfs(..), at every
+// thread limit from 1 up to the job pool's size, and reports the speedup over one thread. The conversions share one
+// parsed document (they only read it), and parsing is outside the timer, so this is only the part of model loading
+// which is jobs.
+//
+static const u32 BENCH_ASSET_JOB_MODEL_COUNT  = 32;
+static const u64 BENCH_ASSET_JOB_ENTITY_COUNT = 10'000;
+
+static void bench_asset_model_jobs(const char *dir) {
+    const char *name = "bench_scene_jobs";
+
+    Gltf_Generator_Config config = gltf_generator_config_from_entity_count(BENCH_ASSET_JOB_ENTITY_COUNT);
+    Gltf_Generator_Stats  stats;
+    if (!gltf_generate(dir, name, &config, &stats)) {
+        println("    Failed to write %s%s, skipping", dir, name);
+        return;
+    }
+    char gltf_path[128];
+    string_format(gltf_path, "%s%s.gltf", dir, name);
+
+    Gltf_Document *document = gltf_document_create(gltf_path, false);
+    assert(document && "Failed to read generated scene");
+
+    Model_Req_Size_Info req_size = model_get_required_size_from_gltf(&document->gltf, MODEL_LOAD_DEFAULT_FLAGS);
+
+    u64 buffer_offset_primitives    = align(sizeof(Mesh) * gltf_mesh_get_count(&document->gltf), 16);
+    u64 buffer_offset_accessor_data = buffer_offset_primitives    + req_size.primitives;
+    u64 buffer_offset_weights       = buffer_offset_accessor_data + req_size.accessors;
+
+    const u32 count = BENCH_ASSET_JOB_MODEL_COUNT;
+
+    u8 *model_buffers[BENCH_ASSET_JOB_MODEL_COUNT];
+    for(u32 i = 0; i < count; ++i)
+        model_buffers[i] = malloc_h(buffer_offset_weights + req_size.weights, 16);
+
+    println("\n    %u models of %s: %u entities (%u meshes, %u primitives, %u accessors, %u materials) each",
+            (u64)count, name, stats.entity_count, stats.mesh_count, stats.primitive_count, stats.accessor_count,
+            stats.material_count);
+
+    const u32 iterations   = 50;
+    u32       thread_count = get_job_thread_count();
+
+    u64 ns;
+    u64 ns_one_thread = 0;
+    u64 mark;
+    Bench_Timer timer;
+    Model_Gltf_Conversion conversions[BENCH_ASSET_JOB_MODEL_COUNT];
+    for(u32 threads = 1; threads <= thread_count; ++threads) {
+        set_job_thread_limit(threads);
+
+        ns = 0;
+        for(u32 i = 0; i < iterations; ++i) {
+            mark  = get_mark_temp();
+            timer = begin_bench();
+
+            for(u32 j = 0; j < count; ++j)
+                model_begin_gltf_conversion(&document->gltf, model_buffers[j], buffer_offset_primitives,
+                                            buffer_offset_accessor_data, buffer_offset_weights, &conversions[j]);
+            model_convert_gltfs(count, conversions);
+
+            ns += end_bench(&timer);
+            bench_keep(conversions[count - 1].meshes[0].primitives);
+            reset_to_mark_temp(mark);
+        }
+        ns_one_thread = threads == 1 ? ns : ns_one_thread;
+
+        println("    model_convert_gltfs, %u threads: %f ms/iter, %f models/s, speedup %f", (u64)threads,
+                (double)ns / 1e6 / iterations, (double)count * iterations / ((double)ns / 1e9),
+                (double)ns_one_thread / (double)ns);
+    }
+    set_job_thread_limit(thread_count);
+
+    for(u32 i = 0; i < count; ++i)
+        free_h(model_buffers[i]);
+    gltf_document_free(document);
+}
+#endif // BENCH
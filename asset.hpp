@@ -4,11 +4,16 @@
 #include "gpu.hpp"
 #include "model.hpp"
 #include "array.hpp"
+#include "mesh.hpp"
 
 #if TEST
 void test_asset();
 #endif
 
+#if BENCH
+void bench_asset();
+#endif
+
 // @Todo I need to reimplement the allocators in a way that is more condusive to threading. Should be
 // trivial as all the logic is the same, just need to create them from offsets into single buffers
 // and device memory. I will do that soon. But it is fine for now. Would need to change how allocations
@@ -158,6 +163,7 @@ enum Accessor_Flag_Bits {
     ACCESSOR_TYPE_MAT2_BIT            = 0x0800,
     ACCESSOR_TYPE_MAT3_BIT            = 0x1000,
     ACCESSOR_TYPE_MAT4_BIT            = 0x2000,
+    ACCESSOR_COMPONENT_TYPE_HALF_BIT  = 0x4000, // Not a gltf type, only written by vertex packing at import
 
     ACCESSOR_TYPE_BITS = ACCESSOR_TYPE_SCALAR_BIT | ACCESSOR_TYPE_VEC2_BIT | ACCESSOR_TYPE_VEC3_BIT |
                          ACCESSOR_TYPE_VEC4_BIT   | ACCESSOR_TYPE_MAT2_BIT | ACCESSOR_TYPE_MAT3_BIT |
@@ -165,8 +171,8 @@ enum Accessor_Flag_Bits {
 
     ACCESSOR_COMPONENT_TYPE_BITS = ACCESSOR_COMPONENT_TYPE_SCHAR_BIT | ACCESSOR_COMPONENT_TYPE_UCHAR_BIT |
                                    ACCESSOR_COMPONENT_TYPE_S16_BIT   | ACCESSOR_COMPONENT_TYPE_U16_BIT   |
-                                   ACCESSOR_COMPONENT_TYPE_U32_BIT   |
-                                   ACCESSOR_COMPONENT_TYPE_FLOAT_BIT,
+                                   ACCESSOR_COMPONENT_TYPE_U32_BIT   | ACCESSOR_COMPONENT_TYPE_FLOAT_BIT |
+                                   ACCESSOR_COMPONENT_TYPE_HALF_BIT,
 };
 typedef u32 Accessor_Flags;
 
@@ -224,6 +230,35 @@ struct Allocation_Key_Counts {
     u32 sampler;
 };
 
+// A primitive's meshlets (see mesh.hpp), built at import with MODEL_LOAD_BUILD_MESHLETS_BIT and stored in the model
+// buffer after the rest of the model.
+struct Meshlets {
+    u32 count;
+    u32 vertex_count;   // entries in 'vertices', which index the primitive's vertices
+    u32 triangle_count; // 3 bytes each in 'triangles', which index a meshlet's vertices
+
+    Meshlet        *meshlets;
+    Meshlet_Bounds *bounds;
+    u32            *vertices;
+    u8             *triangles;
+};
+
+// A primitive's simplified lods (see mesh_simplify(..)), built at import with MODEL_LOAD_BUILD_LODS_BIT and stored
+// in the model buffer after the meshlets. Lod 0 is the primitive's own indices, lod i > 0 is 'lods[i - 1]', each
+// with fewer triangles than the one before. The indices are over the primitive's vertices, and are only on the host.
+struct Mesh_Lod {
+    u32   index_offset; // into Mesh_Lods::indices
+    u32   index_count;
+    float error;        // model space distance from the full detail surface, never less than a finer lod's
+};
+
+struct Mesh_Lods {
+    u32       count;
+    u32       index_count;
+    Mesh_Lod *lods;
+    u32      *indices;
+};
+
 struct Mesh_Primitive {
     Allocation_Key_Counts key_counts;
 
@@ -235,6 +270,15 @@ struct Mesh_Primitive {
     Material material;
     Mesh_Primitive_Attribute *attributes;
     Morph_Target             *targets;
+    Meshlets                 *meshlets; // NULL if the primitive is not an indexed triangle list with float3 positions
+    Mesh_Lods                *lods;     // NULL if the same, or if it would not simplify
+
+    // Model space position = offset + position * scale. The identity unless the positions were packed at import.
+    Vertex_Dequantize position_dequantize;
+
+    // The positions alone, tightly packed (POSITION's format, with its element size as the stride), for passes which
+    // only need positions (shadows, depth prepass). Max_u32 unless the vertices were interleaved at import.
+    u32 position_stream_key;
 };
 
 struct Mesh {
@@ -250,20 +294,94 @@ struct Model {
     Mesh *meshes;
 };
 
+// What model_from_gltf(..) and load_model(..) build at import, beyond converting the gltf (the sections named
+// below are in asset.cpp). Everything is opt in: each one either changes what the shaders must read, or adds to
+// the model buffer, which every model shares. The model cache is only current for the flags it was written with.
+enum Model_Load_Flag_Bits {
+    MODEL_LOAD_PACK_VERTICES_BIT = 0x01, // See 'Vertex Packing'
+    MODEL_LOAD_PACK_SNORM8_BIT   = 0x02, // 8 bit octahedral normals and tangents rather than 16
+
+    MODEL_LOAD_INTERLEAVE_VERTICES_BIT = 0x04, // See 'Vertex Interleaving'
+    MODEL_LOAD_MERGE_VIEWS_BIT         = 0x08, // See 'Buffer View Merging'
+
+    MODEL_LOAD_NARROW_INDICES_BIT   = 0x10, // See 'Index Narrowing'
+    MODEL_LOAD_COMPRESS_INDICES_BIT = 0x20, // Same
+
+    // Meshlets for cluster culling (see model_build_meshlets(..)). About 5 bytes of model buffer per index, and
+    // nothing draws them yet.
+    MODEL_LOAD_BUILD_MESHLETS_BIT = 0x40,
+
+    // Simplified lods per primitive (see model_build_lods(..)). About 8 bytes of model buffer per index, and the
+    // lod indices stay in the model buffer: nothing uploads them next to the primitive's own yet.
+    MODEL_LOAD_BUILD_LODS_BIT = 0x80,
+};
+typedef u32 Model_Load_Flags;
+
+static constexpr Model_Load_Flags MODEL_LOAD_DEFAULT_FLAGS = 0;
+
 Model model_from_gltf(
     Model_Allocators *model_allocators,
     const String     *model_dir,
     const String     *gltf_file_name,
     u64               size_available,
     u8               *model_buffer,
-    u64              *ret_req_size);
+    u64              *ret_req_size,
+    Model_Load_Flags  flags);
+
+struct Gltf_Document;
 
-struct Model_Storage_Info {
-    u64 offset;
-    u64 size;
+// Same as model_from_gltf(..), but from a gltf which the caller already read into a document (say, parsed ahead of
+// time on a loader thread) rather than reading '<model_dir><gltf_file_name>' here. 'model_dir' is still where the
+// buffer and image files are, and the file name names the model in messages. The document is not freed.
+Model model_from_gltf_document(
+    Model_Allocators *model_allocators,
+    const String     *model_dir,
+    const String     *gltf_file_name,
+    Gltf_Document    *document,
+    u64               size_available,
+    u8               *model_buffer,
+    u64              *ret_req_size,
+    Model_Load_Flags  flags);
+
+// Same as model_from_gltf(..), but through a binary cache of the model next to the gltf ('<gltf file>.model'):
+// the gltf is only read as far as its source hash needs (its text and buffers section), and a current cache is
+// loaded from there, else the model is loaded from that same gltf and the cache is (re)written for next time. See
+// 'Model Cache' in asset.cpp for the format.
+Model load_model(
+    Model_Allocators *model_allocators,
+    const String     *model_dir,
+    const String     *gltf_file_name,
+    u64               size_available,
+    u8               *model_buffer,
+    u64              *ret_req_size,
+    Model_Load_Flags  flags);
+
+                                    /* Lod Selection */
+
+struct Camera;
+
+static constexpr float LOD_PIXEL_ERROR = 1;     // default for get_lod_select_info(..)
+static constexpr float LOD_HYSTERESIS  = 0.25f; // see select_primitive_lod(..)
+
+struct Lod_Select_Info {
+    float eye[3];
+    float pixels_per_unit; // how many pixels an error of 1 covers at a distance of 1
+    float pixel_error;     // the most error which may show
 };
-Model_Storage_Info store_model(Model *model); // @Unimplemented
-Model              load_model (String *gltf_file); // @Unimplemented
+
+// 'fov_y' is the vertical field of view of the projection in radians, 'viewport_height' is in pixels.
+Lod_Select_Info get_lod_select_info(const Camera *camera, float fov_y, float viewport_height, float pixel_error);
+
+//
+// Pick the coarsest of a primitive's lods whose error, projected from the nearest point of an instance's
+// bounding sphere ('center' and 'radius' in world space, and 'scale' the largest scale in the instance
+// transform), covers at most 'pixel_error' pixels. Returns 0 for full detail, else i for 'lods[i - 1]'.
+//
+// Moving to a coarser lod than 'current_lod' (last frame's choice) needs the error to be within
+// (1 - LOD_HYSTERESIS) of the limit, so an instance sitting at the boundary between two lods does not flicker.
+//
+u32 select_primitive_lod(const Mesh_Primitive *primitive, const Lod_Select_Info *info, const float *center,
+                         float radius, float scale, u32 current_lod);
 
 struct Allocation_Key_Arrays { // 48 bytes
     u32 *index;
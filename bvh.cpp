@@ -0,0 +1,1076 @@
+#include "bvh.hpp"
+#include "allocator.hpp"
+#include "print.h"
+#include "builtin_wrappers.h"
+#include "job.hpp"
+
+#if TEST
+    #include "test.hpp"
+#endif
+
+#if BENCH
+    #include "test/bench.hpp"
+#endif
+
+static constexpr u32 BVH_BIN_COUNT  = 16;
+static constexpr u32 BVH_LEAF_SIZE  = 4;  // Most instances in a leaf, unless their centers are all the same
+static constexpr u32 BVH_STACK_SIZE = 64;
+
+// Visiting a node, in units of testing an instance. Leaves' instances are together and tested in a tight loop, so a
+// node costs more than one instance: at one, almost every leaf is a single instance, which is slower to query and
+// twice the nodes to refit.
+static constexpr float BVH_TRAVERSAL_COST = 3.0f;
+
+// Ranges at most this large are not shared out as jobs, they are not worth the overhead.
+static constexpr u32 BVH_MIN_TASK_SIZE = 1024;
+
+                                            /* Building */
+
+struct Bvh_Build_Range {
+    u32 node;
+    u32 first;
+    u32 count;
+};
+
+// Boxes as their min and negated max, so that growing one is a single min: x, y, z, 0, -x, -y, -z, 0. The fourth
+// floats of an instance's center and extent are its indices, which would be denormals, so they are cleared first.
+static inline __m128 bvh_load_xyz(const float *xyz) {
+    return _mm_blend_ps(_mm_loadu_ps(xyz), _mm_setzero_ps(), 0x8);
+}
+
+static inline __m256 bvh_instance_get_box_ps(const Bvh_Instance *instance) {
+    __m128 c = bvh_load_xyz(instance->center);
+    __m128 e = bvh_load_xyz(instance->extent);
+    return _mm256_set_m128(_mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), c), e), _mm_sub_ps(c, e));
+}
+
+static inline float bvh_get_half_area(__m256 box) {
+    alignas(32) float b[8];
+    _mm256_store_ps(b, box);
+    float x = -b[4] - b[0];
+    float y = -b[5] - b[1];
+    float z = -b[6] - b[2];
+    return x * y + y * z + z * x;
+}
+
+// The bin of the instance's center on each axis.
+static inline __m128i bvh_get_bins(const Bvh_Instance *instance, __m128 min, __m128 scale, __m128i last) {
+    __m128 bins = _mm_mul_ps(_mm_sub_ps(bvh_load_xyz(instance->center), min), scale);
+    return _mm_min_epi32(_mm_cvttps_epi32(bins), last);
+}
+
+// Write the bounds of 'node' (as a leaf of the range), then find the cheapest split and partition the range's
+// instances by it. Returns false if the node is better left a leaf, else the instances in the left child.
+static bool bvh_split(Bvh *bvh, u32 node_index, u32 first, u32 count, u32 *left_count) {
+    Bvh_Instance *instances = bvh->instances + first;
+    Bvh_Node     *node      = &bvh->nodes[node_index];
+
+    // The node's box, and the box around its instances' centers.
+    __m256 empty   = _mm256_set1_ps(INFINITY);
+    __m256 box     = empty;
+    __m256 centers = empty;
+    __m128 c;
+    for(u32 i = 0; i < count; ++i) {
+        c       = bvh_load_xyz(instances[i].center);
+        box     = _mm256_min_ps(box, bvh_instance_get_box_ps(&instances[i]));
+        centers = _mm256_min_ps(centers, _mm256_set_m128(_mm_sub_ps(_mm_setzero_ps(), c), c));
+    }
+    alignas(32) float b[8];
+    _mm256_store_ps(b, box);
+    for(u32 a = 0; a < 3; ++a) {
+        node->min[a] =  b[a];
+        node->max[a] = -b[a + 4];
+    }
+    node->index = first;
+    node->count = count;
+
+    if (count <= 1)
+        return false;
+
+    // Bin the centers on every axis along which they are spread. Small ranges need fewer bins, and most nodes are
+    // small, where setting up and sweeping the bins would cost more than the binning.
+    u32 bin_count = count < BVH_BIN_COUNT ? (count > 4 ? count : 4) : BVH_BIN_COUNT;
+
+    alignas(32) float cb[8];
+    alignas(16) float scale[4] = {};
+    _mm256_store_ps(cb, centers);
+    for(u32 a = 0; a < 3; ++a)
+        scale[a] = -cb[a + 4] > cb[a] ? bin_count * 0.99999f / (-cb[a + 4] - cb[a]) : 0;
+    __m128  scale_ps = _mm_load_ps(scale);
+    __m128  min_ps   = bvh_load_xyz(cb);
+    __m128i last     = _mm_set1_epi32(bin_count - 1);
+
+    __m256 bin_boxes [3][BVH_BIN_COUNT];
+    u32    bin_counts[3][BVH_BIN_COUNT];
+    for(u32 a = 0; a < 3; ++a)
+        for(u32 k = 0; k < bin_count; ++k) {
+            bin_boxes [a][k] = empty;
+            bin_counts[a][k] = 0;
+        }
+    alignas(16) u32 bins[4];
+    for(u32 i = 0; i < count; ++i) {
+        box = bvh_instance_get_box_ps(&instances[i]);
+        _mm_store_si128((__m128i*)bins, bvh_get_bins(&instances[i], min_ps, scale_ps, last));
+        for(u32 a = 0; a < 3; ++a) {
+            bin_boxes [a][bins[a]] = _mm256_min_ps(bin_boxes[a][bins[a]], box);
+            bin_counts[a][bins[a]]++;
+        }
+    }
+
+    // Sweep each axis from the right then the left, costing the split after every bin.
+    float best_cost = INFINITY;
+    u32   best_axis = 3;
+    u32   best_bin  = 0;
+    float right_cost[BVH_BIN_COUNT];
+    u32   n;
+    for(u32 a = 0; a < 3; ++a) {
+        if (scale[a] == 0)
+            continue;
+
+        box = empty;
+        n   = 0;
+        for(u32 k = bin_count - 1; k > 0; --k) {
+            box = _mm256_min_ps(box, bin_boxes[a][k]);
+            n  += bin_counts[a][k];
+            right_cost[k] = n ? bvh_get_half_area(box) * n : INFINITY;
+        }
+
+        box = empty;
+        n   = 0;
+        for(u32 k = 0; k < bin_count - 1; ++k) {
+            box = _mm256_min_ps(box, bin_boxes[a][k]);
+            n  += bin_counts[a][k];
+            if (!n)
+                continue;
+            float cost = bvh_get_half_area(box) * n + right_cost[k + 1];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = a;
+                best_bin  = k;
+            }
+        }
+    }
+
+    if (best_axis == 3) {
+        // Every center is the same, there is nothing to choose between: halve the range if it is too large a leaf.
+        if (count <= BVH_LEAF_SIZE)
+            return false;
+        node->count = 0;
+        *left_count = count / 2;
+        return true;
+    }
+
+    // In units of testing an instance: visiting the children, and the children's instances by their chance of
+    // being reached (area relative to this node's).
+    float area = bvh_get_half_area(_mm256_load_ps(b));
+    float split_cost = area > 0 ? BVH_TRAVERSAL_COST + best_cost / area : BVH_TRAVERSAL_COST;
+    if (count <= BVH_LEAF_SIZE && split_cost >= (float)count)
+        return false;
+
+    u32 i = 0;
+    u32 j = count;
+    Bvh_Instance tmp;
+    while(i < j) {
+        _mm_store_si128((__m128i*)bins, bvh_get_bins(&instances[i], min_ps, scale_ps, last));
+        if (bins[best_axis] <= best_bin) {
+            ++i;
+        } else {
+            --j;
+            tmp          = instances[i];
+            instances[i] = instances[j];
+            instances[j] = tmp;
+        }
+    }
+    assert(i > 0 && i < count && "Bvh split left a child empty");
+
+    node->count = 0;
+    *left_count = i;
+    return true;
+}
+
+// Build the subtree of 'root', with its nodes from 'cursor' on. If 'tasks' is not NULL, ranges of at most 'task_size'
+// instances are left to 'tasks' instead, with their nodes not yet written. Returns the cursor after the last node.
+static u32 bvh_build_subtree(Bvh *bvh, Bvh_Build_Range root, u32 cursor, u32 task_size, Bvh_Build_Range *tasks,
+                             u32 *task_count)
+{
+    Bvh_Build_Range stack[BVH_STACK_SIZE];
+    u32 stack_count = 0;
+
+    Bvh_Build_Range range = root;
+    Bvh_Build_Range left;
+    Bvh_Build_Range right;
+    u32 left_count;
+    while(true) {
+        if (tasks && range.count <= task_size) {
+            tasks[(*task_count)++] = range;
+        } else if (bvh_split(bvh, range.node, range.first, range.count, &left_count)) {
+            bvh->nodes[range.node].index = cursor;
+            bvh->parents[cursor]     = range.node;
+            bvh->parents[cursor + 1] = range.node;
+
+            left  = {cursor,     range.first,              left_count};
+            right = {cursor + 1, range.first + left_count, range.count - left_count};
+            cursor += 2;
+
+            // Go on with the smaller child, so the stack is at most log2 of the count deep.
+            assert(stack_count < BVH_STACK_SIZE && "Bvh build stack overflow");
+            if (left.count < right.count) {
+                stack[stack_count++] = right;
+                range = left;
+            } else {
+                stack[stack_count++] = left;
+                range = right;
+            }
+            continue;
+        }
+
+        if (!stack_count)
+            break;
+        range = stack[--stack_count];
+    }
+    return cursor;
+}
+
+struct Bvh_Build_Task {
+    Bvh            *bvh;
+    Bvh_Build_Range range;
+    u32             begin; // First node reserved for the subtree
+    u32             end;   // After the last node used
+};
+
+static void bvh_build_job(void *arg) {
+    Bvh_Build_Task *task = (Bvh_Build_Task*)arg;
+    task->end = bvh_build_subtree(task->bvh, task->range, task->begin, 0, NULL, NULL);
+}
+
+void bvh_build(Bvh *bvh, const Cull_Bounds *bounds) {
+    u32 count      = bounds->count;
+    u32 node_limit = count ? count * 2 - 1 : 1;
+
+    u64 size_nodes     = align(sizeof(Bvh_Node) * node_limit, 32);
+    u64 size_parents   = align(sizeof(u32) * node_limit, 32);
+    u64 size_instances = align(sizeof(Bvh_Instance) * count, 32);
+    u64 size_slots     = align(sizeof(u32) * count, 32);
+    u8 *block = malloc_h(size_nodes + size_parents + size_instances + size_slots, 32);
+
+    *bvh = {};
+    bvh->instance_count = count;
+    bvh->nodes     = (Bvh_Node*)block;
+    bvh->parents   = (u32*)(block + size_nodes);
+    bvh->instances = (Bvh_Instance*)(block + size_nodes + size_parents);
+    bvh->slots     = (u32*)(block + size_nodes + size_parents + size_instances);
+
+    if (!count)
+        return;
+
+    for(u32 i = 0; i < count; ++i) {
+        Bvh_Instance *instance = &bvh->instances[i];
+        for(u32 a = 0; a < 3; ++a) {
+            instance->center[a] = bounds->center[a][i];
+            instance->extent[a] = bounds->extent[a][i];
+        }
+        instance->index = i;
+    }
+    bvh->parents[0] = Max_u32;
+
+    // The top of the tree here, until the ranges are small enough to share out.
+    u64 mark = get_mark_temp();
+
+    u32 thread_count = get_job_thread_count();
+    u32 task_size    = count / (thread_count * 8);
+    task_size = task_size > BVH_MIN_TASK_SIZE ? task_size : BVH_MIN_TASK_SIZE;
+
+    Bvh_Build_Range *ranges = (Bvh_Build_Range*)malloc_t(sizeof(Bvh_Build_Range) * count, 4);
+    u32 range_count = 0;
+    u32 cursor;
+    if (thread_count > 1 && count > task_size)
+        cursor = bvh_build_subtree(bvh, {0, 0, count}, 1, task_size, ranges, &range_count);
+    else
+        cursor = bvh_build_subtree(bvh, {0, 0, count}, 1, 0, NULL, NULL);
+
+    // Then the subtrees as jobs, each in a part of the node array large enough for a subtree of its size.
+    Bvh_Build_Task *tasks = (Bvh_Build_Task*)malloc_t(sizeof(Bvh_Build_Task) * range_count, 8);
+    Job            *jobs  = (Job*)malloc_t(sizeof(Job) * range_count, 8);
+    u32 begin = cursor;
+    for(u32 i = 0; i < range_count; ++i) {
+        tasks[i] = {.bvh = bvh, .range = ranges[i], .begin = begin, .end = begin};
+        jobs[i]  = {.func = bvh_build_job, .arg = &tasks[i]};
+        begin   += ranges[i].count * 2 - 2;
+    }
+    assert(begin <= node_limit);
+    run_jobs(range_count, jobs);
+
+    // Close the gaps: move each part down to the end of the last, and its child and parent indices with it.
+    for(u32 i = 0; i < range_count; ++i) {
+        u32 used  = tasks[i].end - tasks[i].begin;
+        u32 delta = tasks[i].begin - cursor;
+        if (delta) {
+            memmove(bvh->nodes   + cursor, bvh->nodes   + tasks[i].begin, sizeof(Bvh_Node) * used);
+            memmove(bvh->parents + cursor, bvh->parents + tasks[i].begin, sizeof(u32) * used);
+            for(u32 n = cursor; n < cursor + used; ++n) {
+                if (!bvh->nodes[n].count)
+                    bvh->nodes[n].index -= delta;
+                if (bvh->parents[n] >= tasks[i].begin)
+                    bvh->parents[n] -= delta;
+            }
+            if (!bvh->nodes[tasks[i].range.node].count)
+                bvh->nodes[tasks[i].range.node].index -= delta;
+        }
+        cursor += used;
+    }
+    bvh->node_count = cursor;
+
+    for(u32 n = 0; n < bvh->node_count; ++n) {
+        const Bvh_Node *node = &bvh->nodes[n];
+        for(u32 i = node->index; i < node->index + node->count; ++i) {
+            bvh->instances[i].leaf = n;
+            bvh->slots[bvh->instances[i].index] = i;
+        }
+    }
+
+    reset_to_mark_temp(mark);
+}
+
+void bvh_free(Bvh *bvh) {
+    free_h(bvh->nodes);
+    *bvh = {};
+}
+
+                                            /* Refitting */
+
+// Recompute the bounds of node 'n' from its children or instances. Returns false if they did not change.
+static bool bvh_refit_node(Bvh *bvh, u32 n) {
+    Bvh_Node *node = &bvh->nodes[n];
+
+    __m128 min;
+    __m128 max;
+    if (node->count) {
+        min = _mm_set1_ps( INFINITY);
+        max = _mm_set1_ps(-INFINITY);
+        __m128 c;
+        __m128 e;
+        for(u32 i = node->index; i < node->index + node->count; ++i) {
+            c   = bvh_load_xyz(bvh->instances[i].center);
+            e   = bvh_load_xyz(bvh->instances[i].extent);
+            min = _mm_min_ps(min, _mm_sub_ps(c, e));
+            max = _mm_max_ps(max, _mm_add_ps(c, e));
+        }
+    } else {
+        const Bvh_Node *left  = &bvh->nodes[node->index];
+        const Bvh_Node *right = &bvh->nodes[node->index + 1];
+        min = _mm_min_ps(bvh_load_xyz(left->min), bvh_load_xyz(right->min));
+        max = _mm_max_ps(bvh_load_xyz(left->max), bvh_load_xyz(right->max));
+    }
+
+    // Keep the index and count, which are the fourth floats.
+    __m128 old_min = _mm_loadu_ps(node->min);
+    __m128 old_max = _mm_loadu_ps(node->max);
+    u32 changed = _mm_movemask_ps(_mm_or_ps(_mm_cmpneq_ps(min, old_min), _mm_cmpneq_ps(max, old_max))) & 0x7;
+    _mm_storeu_ps(node->min, _mm_blend_ps(min, old_min, 0x8));
+    _mm_storeu_ps(node->max, _mm_blend_ps(max, old_max, 0x8));
+    return changed;
+}
+
+void bvh_refit(Bvh *bvh, const Cull_Bounds *bounds) {
+    assert(bounds->count == bvh->instance_count);
+
+    // In the order of the bounds, which are SoA: one scattered write per instance rather than six scattered reads.
+    for(u32 i = 0; i < bvh->instance_count; ++i) {
+        Bvh_Instance *instance = &bvh->instances[bvh->slots[i]];
+        for(u32 a = 0; a < 3; ++a) {
+            instance->center[a] = bounds->center[a][i];
+            instance->extent[a] = bounds->extent[a][i];
+        }
+    }
+
+    // Children come after their parents.
+    for(u32 n = bvh->node_count; n > 0; --n)
+        bvh_refit_node(bvh, n - 1);
+}
+
+void bvh_refit_instances(Bvh *bvh, const Cull_Bounds *bounds, u32 count, const u32 *instances) {
+    assert(bounds->count == bvh->instance_count);
+
+    for(u32 i = 0; i < count; ++i) {
+        assert(instances[i] < bvh->instance_count);
+        Bvh_Instance *instance = &bvh->instances[bvh->slots[instances[i]]];
+        for(u32 a = 0; a < 3; ++a) {
+            instance->center[a] = bounds->center[a][instances[i]];
+            instance->extent[a] = bounds->extent[a][instances[i]];
+        }
+
+        u32 n = instance->leaf;
+        while(n != Max_u32 && bvh_refit_node(bvh, n))
+            n = bvh->parents[n];
+    }
+}
+
+                                            /* Queries */
+
+// As cull_aabbs(..) tests an instance, in the same order, so that the same instances are found.
+static inline bool bvh_instance_is_outside(const Bvh_Instance *instance, const Frustum *frustum, u32 planes) {
+    bool outside = false;
+    for(u32 p = 0; p < 6; ++p) {
+        if (!(planes & (1 << p)))
+            continue;
+        const float *plane = frustum->planes[p];
+        float dist   = plane[0] * instance->center[0] + plane[1] * instance->center[1];
+        dist         = dist + plane[2] * instance->center[2];
+        dist         = dist + plane[3];
+        float radius = fabsf(plane[0]) * instance->extent[0] + fabsf(plane[1]) * instance->extent[1];
+        radius       = radius + fabsf(plane[2]) * instance->extent[2];
+        outside     |= dist + radius < 0;
+    }
+    return outside;
+}
+
+u32 bvh_query_frustum(const Bvh *bvh, const Frustum *frustum, u32 *out) {
+    if (!bvh->node_count)
+        return 0;
+
+    struct Entry {
+        u32 node;
+        u32 planes; // The planes the node is not known to be in front of
+    };
+    Entry stack[BVH_STACK_SIZE];
+    u32   stack_count = 0;
+
+    Entry entry = {0, 0x3f};
+    u32 ret = 0;
+    while(true) {
+        const Bvh_Node *node = &bvh->nodes[entry.node];
+
+        // Outside if the box's corner furthest in front of a plane is behind it, and in front of the plane for the
+        // children as well if the corner furthest behind it is in front.
+        bool outside = false;
+        u32  tests   = entry.planes;
+        u32  p;
+        while(tests) {
+            p      = count_trailing_zeros_u32(tests);
+            tests &= tests - 1;
+
+            const float *plane = frustum->planes[p];
+            float front = plane[3];
+            float back  = plane[3];
+            for(u32 a = 0; a < 3; ++a) {
+                front += plane[a] * (plane[a] >= 0 ? node->max[a] : node->min[a]);
+                back  += plane[a] * (plane[a] >= 0 ? node->min[a] : node->max[a]);
+            }
+            if (front < 0) {
+                outside = true;
+                break;
+            }
+            if (back >= 0)
+                entry.planes &= ~(1 << p);
+        }
+
+        if (!outside) {
+            if (node->count) {
+                for(u32 i = node->index; i < node->index + node->count; ++i)
+                    if (!entry.planes || !bvh_instance_is_outside(&bvh->instances[i], frustum, entry.planes))
+                        out[ret++] = bvh->instances[i].index;
+            } else {
+                assert(stack_count < BVH_STACK_SIZE && "Bvh query stack overflow");
+                stack[stack_count++] = {node->index + 1, entry.planes};
+                entry.node = node->index;
+                continue;
+            }
+        }
+
+        if (!stack_count)
+            break;
+        entry = stack[--stack_count];
+    }
+    return ret;
+}
+
+static inline bool bvh_box_overlaps_sphere(const float *min, const float *max, const float *center, float radius) {
+    float dist = 0;
+    float d;
+    for(u32 a = 0; a < 3; ++a) {
+        d     = min[a] - center[a] > 0 ? min[a] - center[a] : (center[a] - max[a] > 0 ? center[a] - max[a] : 0);
+        dist += d * d;
+    }
+    return dist <= radius * radius;
+}
+
+static inline bool bvh_box_overlaps_box(const float *min, const float *max, const float *box_min,
+                                        const float *box_max)
+{
+    return min[0] <= box_max[0] && max[0] >= box_min[0] &&
+           min[1] <= box_max[1] && max[1] >= box_min[1] &&
+           min[2] <= box_max[2] && max[2] >= box_min[2];
+}
+
+static inline void bvh_instance_get_box(const Bvh_Instance *instance, float *min, float *max) {
+    for(u32 a = 0; a < 3; ++a) {
+        min[a] = instance->center[a] - instance->extent[a];
+        max[a] = instance->center[a] + instance->extent[a];
+    }
+}
+
+// The shared traversal of the overlap queries: 'Overlaps' is a test of a box (min, max).
+template<typename Overlaps>
+static u32 bvh_query_overlaps(const Bvh *bvh, Overlaps overlaps, u32 *out) {
+    if (!bvh->node_count)
+        return 0;
+
+    u32 stack[BVH_STACK_SIZE];
+    u32 stack_count = 0;
+
+    u32 n   = 0;
+    u32 ret = 0;
+    float min[3];
+    float max[3];
+    while(true) {
+        const Bvh_Node *node = &bvh->nodes[n];
+        if (overlaps(node->min, node->max)) {
+            if (node->count) {
+                for(u32 i = node->index; i < node->index + node->count; ++i) {
+                    bvh_instance_get_box(&bvh->instances[i], min, max);
+                    if (overlaps(min, max))
+                        out[ret++] = bvh->instances[i].index;
+                }
+            } else {
+                assert(stack_count < BVH_STACK_SIZE && "Bvh query stack overflow");
+                stack[stack_count++] = node->index + 1;
+                n = node->index;
+                continue;
+            }
+        }
+
+        if (!stack_count)
+            break;
+        n = stack[--stack_count];
+    }
+    return ret;
+}
+
+u32 bvh_query_sphere(const Bvh *bvh, const float *center, float radius, u32 *out) {
+    return bvh_query_overlaps(bvh, [center, radius](const float *min, const float *max) {
+        return bvh_box_overlaps_sphere(min, max, center, radius);
+    }, out);
+}
+
+u32 bvh_query_aabb(const Bvh *bvh, const float *min, const float *max, u32 *out) {
+    return bvh_query_overlaps(bvh, [min, max](const float *box_min, const float *box_max) {
+        return bvh_box_overlaps_box(box_min, box_max, min, max);
+    }, out);
+}
+
+// Where the ray enters the box (zero if it starts inside), or infinity if it misses or enters after 'max_t'. An axis
+// along which the ray does not move and which it starts on the edge of gives nans, which fminf/fmaxf pass over.
+static inline float bvh_ray_enter_box(const float *min, const float *max, const float *origin,
+                                      const float *inverse, float max_t)
+{
+    float enter = 0;
+    float leave = max_t;
+    float t0;
+    float t1;
+    for(u32 a = 0; a < 3; ++a) {
+        t0    = (min[a] - origin[a]) * inverse[a];
+        t1    = (max[a] - origin[a]) * inverse[a];
+        enter = fmaxf(enter, fminf(t0, t1));
+        leave = fminf(leave, fmaxf(t0, t1));
+    }
+    return enter <= leave ? enter : INFINITY;
+}
+
+bool bvh_query_ray(const Bvh *bvh, const float *origin, const float *direction, float max_t, Bvh_Ray_Hit *hit) {
+    if (!bvh->node_count)
+        return false;
+
+    float inverse[3];
+    for(u32 a = 0; a < 3; ++a)
+        inverse[a] = 1.0f / direction[a];
+
+    struct Entry {
+        u32   node;
+        float t; // Where the ray enters the node
+    };
+    Entry stack[BVH_STACK_SIZE];
+    u32   stack_count = 0;
+
+    float best = max_t;
+    hit->instance = Max_u32;
+    hit->t        = INFINITY;
+
+    Entry entry = {0, bvh_ray_enter_box(bvh->nodes[0].min, bvh->nodes[0].max, origin, inverse, best)};
+    if (entry.t == INFINITY)
+        return false;
+
+    float min[3];
+    float max[3];
+    float t;
+    while(true) {
+        // Only nodes the ray enters go on the stack, but they are skipped if a nearer hit was found since.
+        if (entry.t <= best) {
+            const Bvh_Node *node = &bvh->nodes[entry.node];
+            if (node->count) {
+                for(u32 i = node->index; i < node->index + node->count; ++i) {
+                    bvh_instance_get_box(&bvh->instances[i], min, max);
+                    t = bvh_ray_enter_box(min, max, origin, inverse, best);
+                    if (t < hit->t) {
+                        hit->t        = t;
+                        hit->instance = bvh->instances[i].index;
+                        best          = t;
+                    }
+                }
+            } else {
+                const Bvh_Node *left  = &bvh->nodes[node->index];
+                const Bvh_Node *right = &bvh->nodes[node->index + 1];
+                Entry near = {node->index,     bvh_ray_enter_box(left->min,  left->max,  origin, inverse, best)};
+                Entry far  = {node->index + 1, bvh_ray_enter_box(right->min, right->max, origin, inverse, best)};
+                if (far.t < near.t) {
+                    Entry tmp = near;
+                    near = far;
+                    far  = tmp;
+                }
+                if (near.t != INFINITY) {
+                    if (far.t != INFINITY) {
+                        assert(stack_count < BVH_STACK_SIZE && "Bvh query stack overflow");
+                        stack[stack_count++] = far;
+                    }
+                    entry = near;
+                    continue;
+                }
+            }
+        }
+
+        if (!stack_count)
+            break;
+        entry = stack[--stack_count];
+    }
+    return hit->instance != Max_u32;
+}
+
+                                            /* Tests */
+
+#if TEST || BENCH
+// Bounds in 32 byte aligned temp memory.
+static void bvh_bounds_init_temp(Cull_Bounds *bounds, u32 count) {
+    u8 *memory = malloc_t(cull_bounds_get_size(count) + 32, 4);
+    cull_bounds_init(bounds, count, (void*)align((u64)memory, 32));
+}
+
+// A map: 'count' boxes spread over 'size' by 'size' on x and z, up to 'height' on y, of 1 to 5 units.
+static void bvh_bounds_set_random(Cull_Bounds *bounds, float size, float height, u32 seed) {
+    u32 rng = seed;
+    float r[6];
+    for(u32 i = 0; i < bounds->count; ++i) {
+        for(u32 c = 0; c < 6; ++c) {
+            rng  = rng * 1664525 + 1013904223;
+            r[c] = (float)(rng >> 8) / (float)(1 << 24);
+        }
+        bounds->center[0][i] = (r[0] - 0.5f) * size;
+        bounds->center[1][i] = r[1] * height;
+        bounds->center[2][i] = (r[2] - 0.5f) * size;
+        bounds->extent[0][i] = 0.5f + r[3] * 2.0f;
+        bounds->extent[1][i] = 0.5f + r[4] * 2.0f;
+        bounds->extent[2][i] = 0.5f + r[5] * 2.0f;
+    }
+}
+
+// A camera standing in the map at (0, 10, 0), looking down -z with a 90 degree view as far as 'far'.
+static void bvh_get_map_frustum(Frustum *frustum, float far) {
+    Vec3 right = {1, 0,  0};
+    Vec3 up    = {0, 1,  0};
+    Vec3 front = {0, 0, -1};
+    Vec3 pos   = {0, 10, 0};
+    Mat4 view = look_at(&right, &up, &front, &pos);
+    Mat4 proj = perspective(3.14159265f * 0.5f, 1.0f, 0.1f, far);
+    Mat4 view_projection = mul_mat4(proj, view);
+    frustum_from_view_projection(frustum, &view_projection);
+}
+
+static void bvh_get_box(const Cull_Bounds *bounds, u32 i, float *min, float *max) {
+    for(u32 a = 0; a < 3; ++a) {
+        min[a] = bounds->center[a][i] - bounds->extent[a][i];
+        max[a] = bounds->center[a][i] + bounds->extent[a][i];
+    }
+}
+
+// The flat scans which the queries replace.
+static u32 bvh_scan_sphere(const Cull_Bounds *bounds, const float *center, float radius, u32 *out) {
+    float min[3];
+    float max[3];
+    u32 ret = 0;
+    for(u32 i = 0; i < bounds->count; ++i) {
+        bvh_get_box(bounds, i, min, max);
+        if (bvh_box_overlaps_sphere(min, max, center, radius))
+            out[ret++] = i;
+    }
+    return ret;
+}
+
+static u32 bvh_scan_aabb(const Cull_Bounds *bounds, const float *box_min, const float *box_max, u32 *out) {
+    float min[3];
+    float max[3];
+    u32 ret = 0;
+    for(u32 i = 0; i < bounds->count; ++i) {
+        bvh_get_box(bounds, i, min, max);
+        if (bvh_box_overlaps_box(min, max, box_min, box_max))
+            out[ret++] = i;
+    }
+    return ret;
+}
+
+static float bvh_scan_ray(const Cull_Bounds *bounds, const float *origin, const float *direction, float max_t) {
+    float inverse[3];
+    for(u32 a = 0; a < 3; ++a)
+        inverse[a] = 1.0f / direction[a];
+    float min[3];
+    float max[3];
+    float best = INFINITY;
+    float t;
+    for(u32 i = 0; i < bounds->count; ++i) {
+        bvh_get_box(bounds, i, min, max);
+        t    = bvh_ray_enter_box(min, max, origin, inverse, max_t);
+        best = t < best ? t : best;
+    }
+    return best;
+}
+#endif
+
+#if TEST
+static int test_bvh_compare_u32(const void *a, const void *b) {
+    u32 x = *(const u32*)a;
+    u32 y = *(const u32*)b;
+    return x < y ? -1 : x > y;
+}
+
+// The lists hold the same indices.
+static bool test_bvh_same_list(u32 count, u32 *a, u32 *b) {
+    qsort(a, count, sizeof(u32), test_bvh_compare_u32);
+    qsort(b, count, sizeof(u32), test_bvh_compare_u32);
+    return !memcmp(a, b, sizeof(u32) * count);
+}
+
+// Every node holds its children or instances, every instance is in one leaf, and the indices agree with each other.
+static bool test_bvh_is_valid(const Bvh *bvh) {
+    u64 mark = get_mark_temp();
+
+    u32 *seen = (u32*)malloc_t(sizeof(u32) * bvh->instance_count, 4);
+    memset(seen, 0, sizeof(u32) * bvh->instance_count);
+
+    bool ret = bvh->parents[0] == Max_u32;
+    float min[3];
+    float max[3];
+    for(u32 n = 0; n < bvh->node_count; ++n) {
+        const Bvh_Node *node = &bvh->nodes[n];
+        if (node->count) {
+            for(u32 i = node->index; i < node->index + node->count; ++i) {
+                const Bvh_Instance *instance = &bvh->instances[i];
+                bvh_instance_get_box(instance, min, max);
+                ret &= instance->leaf == n && bvh->slots[instance->index] == i;
+                for(u32 a = 0; a < 3; ++a)
+                    ret &= min[a] >= node->min[a] && max[a] <= node->max[a];
+                seen[instance->index]++;
+            }
+        } else {
+            ret &= node->index > n && node->index + 1 < bvh->node_count;
+            ret &= bvh->parents[node->index] == n && bvh->parents[node->index + 1] == n;
+            for(u32 c = 0; c < 2; ++c)
+                for(u32 a = 0; a < 3; ++a)
+                    ret &= bvh->nodes[node->index + c].min[a] >= node->min[a] &&
+                           bvh->nodes[node->index + c].max[a] <= node->max[a];
+        }
+    }
+    for(u32 i = 0; i < bvh->instance_count; ++i)
+        ret &= seen[i] == 1;
+
+    reset_to_mark_temp(mark);
+    return ret;
+}
+
+void test_bvh() {
+    u64 mark = get_mark_temp();
+
+    // Not a multiple of anything, and large enough to be shared out as jobs.
+    const u32 count = 20011;
+    Cull_Bounds bounds;
+    bvh_bounds_init_temp(&bounds, count);
+    bvh_bounds_set_random(&bounds, 1000.0f, 20.0f, 3);
+
+    u32 *a = (u32*)malloc_t(sizeof(u32) * align(count, 8), 4);
+    u32 *b = (u32*)malloc_t(sizeof(u32) * align(count, 8), 4);
+
+    BEGIN_TEST_MODULE("Bvh_Build", false, false);
+    {
+        Bvh bvh;
+        bvh_build(&bvh, &bounds);
+        TEST_EQ("valid", test_bvh_is_valid(&bvh), true, false);
+        TEST_LT("node_count", bvh.node_count, count * 2, false);
+        bvh_free(&bvh);
+
+        set_job_thread_limit(1);
+        bvh_build(&bvh, &bounds);
+        TEST_EQ("valid_one_thread", test_bvh_is_valid(&bvh), true, false);
+        bvh_free(&bvh);
+        set_job_thread_limit(get_job_thread_count());
+
+        // Every box at the same place cannot be split by the heuristic, and is halved instead.
+        Cull_Bounds same;
+        bvh_bounds_init_temp(&same, 37);
+        for(u32 i = 0; i < same.count; ++i)
+            for(u32 c = 0; c < 3; ++c)
+                same.extent[c][i] = 1;
+        bvh_build(&bvh, &same);
+        TEST_EQ("valid_same", test_bvh_is_valid(&bvh), true, false);
+        bvh_free(&bvh);
+
+        Cull_Bounds one;
+        bvh_bounds_init_temp(&one, 1);
+        bvh_build(&bvh, &one);
+        TEST_EQ("valid_one",      test_bvh_is_valid(&bvh), true, false);
+        TEST_EQ("node_count_one", bvh.node_count, 1, false);
+        bvh_free(&bvh);
+
+        Cull_Bounds none;
+        bvh_bounds_init_temp(&none, 0);
+        bvh_build(&bvh, &none);
+        TEST_EQ("node_count_none", bvh.node_count, 0, false);
+        Frustum frustum;
+        bvh_get_map_frustum(&frustum, 100.0f);
+        TEST_EQ("query_none", bvh_query_frustum(&bvh, &frustum, a), 0, false);
+        bvh_free(&bvh);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Bvh_Queries", false, false);
+    {
+        Bvh bvh;
+        bvh_build(&bvh, &bounds);
+
+        float fars[] = {50.0f, 300.0f, 2000.0f};
+        for(u32 f = 0; f < 3; ++f) {
+            Frustum frustum;
+            bvh_get_map_frustum(&frustum, fars[f]);
+            u32 flat_count = cull_aabbs(&frustum, &bounds, a);
+            u32 bvh_count  = bvh_query_frustum(&bvh, &frustum, b);
+            TEST_EQ("frustum_count", bvh_count, flat_count, false);
+            TEST_EQ("frustum_list",  test_bvh_same_list(flat_count, a, b), true, false);
+            TEST_LT("frustum_some",  0, bvh_count, false);
+        }
+
+        u32 rng = 11;
+        float r[6];
+        for(u32 q = 0; q < 64; ++q) {
+            for(u32 c = 0; c < 6; ++c) {
+                rng  = rng * 1664525 + 1013904223;
+                r[c] = (float)(rng >> 8) / (float)(1 << 24);
+            }
+            float center[] = {(r[0] - 0.5f) * 1000.0f, r[1] * 20.0f, (r[2] - 0.5f) * 1000.0f};
+            float radius   = r[3] * 30.0f;
+
+            u32 flat_count = bvh_scan_sphere(&bounds, center, radius, a);
+            u32 bvh_count  = bvh_query_sphere(&bvh, center, radius, b);
+            TEST_EQ("sphere_count", bvh_count, flat_count, false);
+            TEST_EQ("sphere_list",  test_bvh_same_list(flat_count, a, b), true, false);
+
+            float min[] = {center[0] - radius, center[1] - r[4] * 10.0f, center[2] - r[5] * 30.0f};
+            float max[] = {center[0] + radius, center[1] + r[4] * 10.0f, center[2] + r[5] * 30.0f};
+            flat_count = bvh_scan_aabb(&bounds, min, max, a);
+            bvh_count  = bvh_query_aabb(&bvh, min, max, b);
+            TEST_EQ("aabb_count", bvh_count, flat_count, false);
+            TEST_EQ("aabb_list",  test_bvh_same_list(flat_count, a, b), true, false);
+
+            // Along the ground in every direction, and one straight down.
+            float direction[] = {r[3] - 0.5f, q == 0 ? -1.0f : 0.0f, r[4] - 0.5f};
+            if (q == 0)
+                direction[0] = direction[2] = 0;
+            float max_t = q & 1 ? 100.0f : INFINITY;
+            Bvh_Ray_Hit hit;
+            float flat_t = bvh_scan_ray(&bounds, center, direction, max_t);
+            bool  found  = bvh_query_ray(&bvh, center, direction, max_t, &hit);
+            TEST_EQ("ray_found", found, flat_t != INFINITY, false);
+            if (found) {
+                TEST_EQ("ray_t", hit.t == flat_t, true, false);
+                float min[3];
+                float max[3];
+                bvh_get_box(&bounds, hit.instance, min, max);
+                float inverse[] = {1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2]};
+                TEST_EQ("ray_instance", bvh_ray_enter_box(min, max, center, inverse, max_t) == hit.t, true, false);
+            }
+        }
+
+        bvh_free(&bvh);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Bvh_Refit", false, false);
+    {
+        Bvh bvh;
+        bvh_build(&bvh, &bounds);
+
+        // Move every hundredth instance, refit only those, and compare with refitting everything.
+        u32 moved_count = 0;
+        for(u32 i = 0; i < count; i += 100) {
+            bounds.center[0][i] += 40.0f;
+            bounds.center[1][i] -= 5.0f;
+            bounds.extent[2][i] *= 2.0f;
+            a[moved_count++] = i;
+        }
+        bvh_refit_instances(&bvh, &bounds, moved_count, a);
+        TEST_EQ("valid", test_bvh_is_valid(&bvh), true, false);
+
+        Bvh_Node *incremental = (Bvh_Node*)malloc_t(sizeof(Bvh_Node) * bvh.node_count, 4);
+        memcpy(incremental, bvh.nodes, sizeof(Bvh_Node) * bvh.node_count);
+        bvh_refit(&bvh, &bounds);
+        TEST_EQ("matches_full", memcmp(incremental, bvh.nodes, sizeof(Bvh_Node) * bvh.node_count), 0, false);
+
+        Frustum frustum;
+        bvh_get_map_frustum(&frustum, 300.0f);
+        u32 flat_count = cull_aabbs(&frustum, &bounds, a);
+        u32 bvh_count  = bvh_query_frustum(&bvh, &frustum, b);
+        TEST_EQ("frustum_count", bvh_count, flat_count, false);
+        TEST_EQ("frustum_list",  test_bvh_same_list(flat_count, a, b), true, false);
+
+        bvh_free(&bvh);
+    }
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif // TEST
+
+#if BENCH
+//
+// A map of 64k boxes over two kilometres: building on one thread against the pool, refitting, and each query
+// against the flat scan it replaces (cull_aabbs(..) for the frustum, scalar loops for the others).
+//
+void bench_bvh() {
+    BENCH_MODULE("Bvh");
+
+    u64 mark = get_mark_temp();
+
+    const u32 count = 64 * 1024;
+    Cull_Bounds bounds;
+    bvh_bounds_init_temp(&bounds, count);
+    bvh_bounds_set_random(&bounds, 2000.0f, 20.0f, 5);
+
+    u32 *out = (u32*)malloc_t(sizeof(u32) * align(count, 8), 4);
+
+    Bvh bvh;
+    Bench_Timer timer;
+    u32 thread_count = get_job_thread_count();
+
+    const u32 build_iterations = 8;
+    u64 ns_build[2] = {};
+    for(u32 t = 0; t < 2; ++t) {
+        set_job_thread_limit(t ? thread_count : 1);
+        for(u32 it = 0; it < build_iterations; ++it) {
+            timer = begin_bench();
+            bvh_build(&bvh, &bounds);
+            ns_build[t] += end_bench(&timer);
+            bench_keep(bvh.nodes[0].min[0]);
+            bvh_free(&bvh);
+        }
+    }
+    set_job_thread_limit(thread_count);
+    bvh_build(&bvh, &bounds);
+
+    println("    %u boxes, %u nodes:", (u64)count, (u64)bvh.node_count);
+    println("        build: 1 thread %f ms, %u threads %f ms, speedup %f", (double)ns_build[0] / build_iterations / 1e6,
+            (u64)thread_count, (double)ns_build[1] / build_iterations / 1e6, (double)ns_build[0] / (double)ns_build[1]);
+
+    // Refitting: everything, and a hundredth of the boxes moved.
+    const u32 iterations = 64;
+    u32 moved_count = 0;
+    u32 *moved = (u32*)malloc_t(sizeof(u32) * count / 100 + 4, 4);
+    u32 rng = 17;
+    for(u32 i = 0; i < count / 100; ++i) {
+        rng = rng * 1664525 + 1013904223;
+        moved[moved_count++] = (rng >> 8) % count;
+    }
+    u64 ns_refit = 0;
+    u64 ns_refit_moved = 0;
+    for(u32 it = 0; it < iterations; ++it) {
+        for(u32 i = 0; i < moved_count; ++i)
+            bounds.center[0][moved[i]] += it & 1 ? -1.0f : 1.0f;
+
+        timer = begin_bench();
+        bvh_refit_instances(&bvh, &bounds, moved_count, moved);
+        ns_refit_moved += end_bench(&timer);
+
+        timer = begin_bench();
+        bvh_refit(&bvh, &bounds);
+        ns_refit += end_bench(&timer);
+        bench_keep(bvh.nodes[0].max[0]);
+    }
+    println("        refit: every node %f us, %u boxes moved %f us", (double)ns_refit / iterations / 1000.0,
+            (u64)moved_count, (double)ns_refit_moved / iterations / 1000.0);
+
+    // Frustums, as far as the near part of the map and as far as all of it.
+    float fars[] = {300.0f, 2000.0f};
+    for(u32 f = 0; f < 2; ++f) {
+        Frustum frustum;
+        bvh_get_map_frustum(&frustum, fars[f]);
+
+        u64 ns_bvh  = 0;
+        u64 ns_flat = 0;
+        u32 found   = 0;
+        for(u32 it = 0; it < iterations; ++it) {
+            timer = begin_bench();
+            found = bvh_query_frustum(&bvh, &frustum, out);
+            ns_bvh += end_bench(&timer);
+            bench_keep(out[0]);
+
+            timer = begin_bench();
+            found = cull_aabbs(&frustum, &bounds, out);
+            ns_flat += end_bench(&timer);
+            bench_keep(out[0]);
+        }
+        println("        frustum to %f, %u visible: bvh %f us, flat simd %f us, speedup %f", (double)fars[f],
+                (u64)found, (double)ns_bvh / iterations / 1000.0, (double)ns_flat / iterations / 1000.0,
+                (double)ns_flat / (double)ns_bvh);
+    }
+
+    // Spheres, boxes and rays from random places on the map.
+    const u32 query_count = 256;
+    u64 ns_bvh[3]  = {};
+    u64 ns_flat[3] = {};
+    u64 found[3]   = {};
+    float r[5];
+    Bvh_Ray_Hit hit;
+    for(u32 q = 0; q < query_count; ++q) {
+        for(u32 c = 0; c < 5; ++c) {
+            rng  = rng * 1664525 + 1013904223;
+            r[c] = (float)(rng >> 8) / (float)(1 << 24);
+        }
+        float center[]    = {(r[0] - 0.5f) * 2000.0f, r[1] * 20.0f, (r[2] - 0.5f) * 2000.0f};
+        float min[]       = {center[0] - 20.0f, center[1] - 5.0f, center[2] - 20.0f};
+        float max[]       = {center[0] + 20.0f, center[1] + 5.0f, center[2] + 20.0f};
+        float direction[] = {r[3] - 0.5f, 0, r[4] - 0.5f};
+
+        timer = begin_bench();
+        found[0] += bvh_query_sphere(&bvh, center, 20.0f, out);
+        ns_bvh[0] += end_bench(&timer);
+        timer = begin_bench();
+        bench_keep(bvh_scan_sphere(&bounds, center, 20.0f, out));
+        ns_flat[0] += end_bench(&timer);
+
+        timer = begin_bench();
+        found[1] += bvh_query_aabb(&bvh, min, max, out);
+        ns_bvh[1] += end_bench(&timer);
+        timer = begin_bench();
+        bench_keep(bvh_scan_aabb(&bounds, min, max, out));
+        ns_flat[1] += end_bench(&timer);
+
+        timer = begin_bench();
+        found[2] += bvh_query_ray(&bvh, center, direction, INFINITY, &hit);
+        ns_bvh[2] += end_bench(&timer);
+        timer = begin_bench();
+        bench_keep(bvh_scan_ray(&bounds, center, direction, INFINITY));
+        ns_flat[2] += end_bench(&timer);
+    }
+    const char *names[] = {"sphere (radius 20)", "aabb (40x10x40)", "ray (first hit)"};
+    for(u32 i = 0; i < 3; ++i)
+        println("        %s, %f found: bvh %f us, flat scan %f us, speedup %f", names[i],
+                (double)found[i] / query_count, (double)ns_bvh[i] / query_count / 1000.0,
+                (double)ns_flat[i] / query_count / 1000.0, (double)ns_flat[i] / (double)ns_bvh[i]);
+
+    bvh_free(&bvh);
+    reset_to_mark_temp(mark);
+}
+#endif // BENCH
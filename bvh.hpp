@@ -0,0 +1,82 @@
+#ifndef SOL_BVH_HPP_INCLUDE_GUARD_
+#define SOL_BVH_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "cull.hpp"
+
+/*
+    Bvh: a bounding volume hierarchy over instance world boxes (cull.hpp's Cull_Bounds), for culling and spatial
+    queries over maps too large for cull_aabbs(..)'s flat scan.
+
+    Nodes are binary, and split with a binned surface area heuristic (16 bins on each axis, the cheapest of the
+    three). bvh_build(..) splits the top of the tree on the calling thread until the ranges are small enough to share
+    out, then builds each range's subtree as a job (see job.hpp) in its own part of the node array, and closes the gaps
+    between the parts afterwards. Children always come after their parent.
+
+    The instance boxes are copied into the tree in leaf order, so a leaf's instances are together in memory. When
+    instances move, the tree is refit rather than rebuilt: bvh_refit(..) recomputes every node, and
+    bvh_refit_instances(..) only the leaves of the instances which moved and their ancestors, stopping where a box
+    does not change. Refitting keeps the tree's shape, so after a lot of movement the queries get slower, rebuild then.
+
+    Queries write the indices of the instances they find (in no particular order) and return how many there are.
+    The frustum query gives the same instances as cull_aabbs(..): it tests nodes against only the planes their
+    parent was not fully in front of, and leaves' instances as cull_aabbs(..) does.
+*/
+
+struct Bvh_Node {
+    float min[3];
+    u32   index; // A leaf's first instance, or an interior node's left child (the right child is index + 1)
+    float max[3];
+    u32   count; // Instances in a leaf, zero for an interior node
+};
+
+struct Bvh_Instance {
+    float center[3];
+    u32   index; // Index in the Cull_Bounds
+    float extent[3];
+    u32   leaf;
+};
+
+struct Bvh {
+    u32 instance_count;
+    u32 node_count;
+
+    Bvh_Node     *nodes;     // The root is node 0
+    u32          *parents;   // Per node, Max_u32 for the root
+    Bvh_Instance *instances; // In leaf order
+    u32          *slots;     // Position in 'instances' of each instance
+};
+
+// Build a tree over every box in 'bounds'. The tree is one heap allocation, free it with bvh_free(..). Uses the job
+// pool, so call it from the thread which started the pool.
+void bvh_build(Bvh *bvh, const Cull_Bounds *bounds);
+void bvh_free(Bvh *bvh);
+
+// Copy the instance boxes from 'bounds' again, and recompute every node.
+void bvh_refit(Bvh *bvh, const Cull_Bounds *bounds);
+
+// Copy the boxes of 'instances' from 'bounds' again, and recompute the nodes above them.
+void bvh_refit_instances(Bvh *bvh, const Cull_Bounds *bounds, u32 count, const u32 *instances);
+
+// 'out' must have room for every instance.
+u32 bvh_query_frustum(const Bvh *bvh, const Frustum *frustum, u32 *out);
+u32 bvh_query_sphere(const Bvh *bvh, const float *center, float radius, u32 *out);
+u32 bvh_query_aabb(const Bvh *bvh, const float *min, const float *max, u32 *out);
+
+struct Bvh_Ray_Hit {
+    u32   instance;
+    float t; // Distance along the ray in lengths of its direction, zero if it starts in the box
+};
+
+// The first instance box hit by the ray at most 'max_t' along it. Returns false if there is none.
+bool bvh_query_ray(const Bvh *bvh, const float *origin, const float *direction, float max_t, Bvh_Ray_Hit *hit);
+
+#if TEST
+    void test_bvh();
+#endif
+
+#if BENCH
+    void bench_bvh();
+#endif
+
+#endif // include guard
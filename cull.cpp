@@ -0,0 +1,528 @@
+#include "cull.hpp"
+#include "allocator.hpp"
+#include "print.h"
+#include "builtin_wrappers.h"
+
+#if TEST
+    #include "test.hpp"
+#endif
+
+#if BENCH
+    #include "test/bench.hpp"
+#endif
+
+#if TEST || BENCH
+    #include "camera.hpp"
+#endif
+
+                                            /* Frustums */
+
+void frustum_from_view_projection(Frustum *frustum, const Mat4 *view_projection) {
+    const float *r0 = &view_projection->row0.x;
+    const float *r1 = &view_projection->row1.x;
+    const float *r2 = &view_projection->row2.x;
+    const float *r3 = &view_projection->row3.x;
+
+    for(u32 i = 0; i < 4; ++i) {
+        frustum->planes[0][i] = r3[i] + r0[i]; // Left
+        frustum->planes[1][i] = r3[i] - r0[i]; // Right
+        frustum->planes[2][i] = r3[i] + r1[i]; // Bottom (top in vulkan's clip space, y is down)
+        frustum->planes[3][i] = r3[i] - r1[i]; // Top
+        frustum->planes[4][i] = r2[i];         // Near, z >= 0
+        frustum->planes[5][i] = r3[i] - r2[i]; // Far
+    }
+
+    float len;
+    for(u32 i = 0; i < 6; ++i) {
+        float *p = frustum->planes[i];
+        len = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        assert(len > 0 && "Degenerate view projection");
+        len = 1.0f / len;
+        p[0] *= len;
+        p[1] *= len;
+        p[2] *= len;
+        p[3] *= len;
+    }
+}
+
+                                            /* Bounds */
+
+// Bounds which are never culled: zero times this is still zero, where infinity would make a nan.
+static constexpr float CULL_INFINITE_EXTENT = 1e30f;
+
+u64 cull_bounds_get_size(u32 count) {
+    return sizeof(float) * align(count, 8) * 7;
+}
+
+void cull_bounds_init(Cull_Bounds *bounds, u32 count, void *memory) {
+    assert(((u64)memory & 31) == 0 && "Cull bounds memory must be 32 byte aligned");
+
+    u32 stride = align(count, 8);
+    float *floats = (float*)memory;
+    memset(floats, 0, cull_bounds_get_size(count));
+
+    bounds->count = count;
+    for(u32 i = 0; i < 3; ++i) {
+        bounds->center[i] = floats + stride * i;
+        bounds->extent[i] = floats + stride * (i + 3);
+    }
+    bounds->radius = floats + stride * 6;
+}
+
+void cull_bounds_set(Cull_Bounds *bounds, u32 index, const float *min, const float *max, const Mat4 *world) {
+    assert(index < bounds->count);
+
+    float c[3];
+    float e[3];
+    for(u32 i = 0; i < 3; ++i) {
+        c[i] = (max[i] + min[i]) * 0.5f;
+        e[i] = (max[i] - min[i]) * 0.5f;
+    }
+
+    // The box around the transformed box (Arvo): the center is transformed, and the extent by the absolute matrix.
+    const float *cols[] = {&world->row0.x, &world->row1.x, &world->row2.x, &world->row3.x};
+    float center;
+    float extent;
+    for(u32 r = 0; r < 3; ++r) {
+        center = cols[3][r];
+        extent = 0;
+        for(u32 k = 0; k < 3; ++k) {
+            center += cols[k][r] * c[k];
+            extent += fabsf(cols[k][r]) * e[k];
+        }
+        bounds->center[r][index] = center;
+        bounds->extent[r][index] = extent;
+    }
+
+    // The sphere around the model space box, scaled by the largest axis scale.
+    float scale = 0;
+    float len;
+    for(u32 k = 0; k < 3; ++k) {
+        len   = cols[k][0] * cols[k][0] + cols[k][1] * cols[k][1] + cols[k][2] * cols[k][2];
+        scale = len > scale ? len : scale;
+    }
+    bounds->radius[index] = sqrtf(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]) * sqrtf(scale);
+}
+
+bool cull_bounds_set_from_primitive(Cull_Bounds *bounds, u32 index, const Mesh_Primitive *primitive,
+                                    const Mat4 *world)
+{
+    const Accessor_Max_Min *max_min = NULL;
+    for(u32 i = 0; i < primitive->attribute_count; ++i)
+        if (primitive->attributes[i].type == MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION) {
+            max_min = primitive->attributes[i].accessor.max_min;
+            break;
+        }
+
+    if (max_min) {
+        cull_bounds_set(bounds, index, max_min->min, max_min->max, world);
+        return true;
+    }
+
+    for(u32 i = 0; i < 3; ++i) {
+        bounds->center[i][index] = 0;
+        bounds->extent[i][index] = CULL_INFINITE_EXTENT;
+    }
+    bounds->radius[index] = CULL_INFINITE_EXTENT;
+    return false;
+}
+
+                                            /* Culling */
+
+// The lanes set in each 8 bit mask as byte indices, lowest first, for compacting the visible lanes of a batch.
+struct Cull_Compact_Table {
+    u64 lanes[256];
+};
+static constexpr Cull_Compact_Table cull_make_compact_table() {
+    Cull_Compact_Table ret = {};
+    for(u32 m = 0; m < 256; ++m) {
+        u32 n = 0;
+        for(u32 i = 0; i < 8; ++i)
+            if (m & (1 << i))
+                ret.lanes[m] |= (u64)i << (n++ * 8);
+    }
+    return ret;
+}
+static constexpr Cull_Compact_Table CULL_COMPACT_TABLE = cull_make_compact_table();
+
+// Write the batch's visible indices (eight, the extra ones are overwritten by the next batch) and return how many.
+static inline u32 cull_compact(u32 *visible, u32 base, u32 mask) {
+    __m256i lanes = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((s64)CULL_COMPACT_TABLE.lanes[mask]));
+    _mm256_storeu_si256((__m256i*)visible, _mm256_add_epi32(lanes, _mm256_set1_epi32(base)));
+    return pop_count32(mask);
+}
+
+// Mask of the lanes of the batch at 'base' which are bounds.
+static inline u32 cull_tail_mask(u32 count, u32 base) {
+    return count - base >= 8 ? 0xff : (1 << (count - base)) - 1;
+}
+
+u32 cull_aabbs(const Frustum *frustum, const Cull_Bounds *bounds, u32 *visible) {
+    __m256 planes[6][4];
+    __m256 abs_planes[6][3];
+    for(u32 p = 0; p < 6; ++p) {
+        for(u32 i = 0; i < 4; ++i)
+            planes[p][i] = _mm256_set1_ps(frustum->planes[p][i]);
+        for(u32 i = 0; i < 3; ++i)
+            abs_planes[p][i] = _mm256_set1_ps(fabsf(frustum->planes[p][i]));
+    }
+    __m256 zero = _mm256_setzero_ps();
+
+    __m256 cx, cy, cz, ex, ey, ez;
+    __m256 dist, radius, outside;
+    u32 ret = 0;
+    for(u32 i = 0; i < bounds->count; i += 8) {
+        cx = _mm256_load_ps(bounds->center[0] + i);
+        cy = _mm256_load_ps(bounds->center[1] + i);
+        cz = _mm256_load_ps(bounds->center[2] + i);
+        ex = _mm256_load_ps(bounds->extent[0] + i);
+        ey = _mm256_load_ps(bounds->extent[1] + i);
+        ez = _mm256_load_ps(bounds->extent[2] + i);
+
+        outside = zero;
+        for(u32 p = 0; p < 6; ++p) {
+            dist = _mm256_add_ps(_mm256_mul_ps(planes[p][0], cx), _mm256_mul_ps(planes[p][1], cy));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(planes[p][2], cz));
+            dist = _mm256_add_ps(dist, planes[p][3]);
+
+            radius = _mm256_add_ps(_mm256_mul_ps(abs_planes[p][0], ex), _mm256_mul_ps(abs_planes[p][1], ey));
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(abs_planes[p][2], ez));
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_LT_OQ));
+        }
+
+        u32 mask = ~_mm256_movemask_ps(outside) & cull_tail_mask(bounds->count, i);
+        ret += cull_compact(visible + ret, i, mask);
+    }
+    return ret;
+}
+
+u32 cull_spheres(const Frustum *frustum, const Cull_Bounds *bounds, u32 *visible) {
+    __m256 planes[6][4];
+    for(u32 p = 0; p < 6; ++p)
+        for(u32 i = 0; i < 4; ++i)
+            planes[p][i] = _mm256_set1_ps(frustum->planes[p][i]);
+    __m256 zero = _mm256_setzero_ps();
+
+    __m256 cx, cy, cz, r;
+    __m256 dist, outside;
+    u32 ret = 0;
+    for(u32 i = 0; i < bounds->count; i += 8) {
+        cx = _mm256_load_ps(bounds->center[0] + i);
+        cy = _mm256_load_ps(bounds->center[1] + i);
+        cz = _mm256_load_ps(bounds->center[2] + i);
+        r  = _mm256_load_ps(bounds->radius + i);
+
+        outside = zero;
+        for(u32 p = 0; p < 6; ++p) {
+            dist = _mm256_add_ps(_mm256_mul_ps(planes[p][0], cx), _mm256_mul_ps(planes[p][1], cy));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(planes[p][2], cz));
+            dist = _mm256_add_ps(dist, planes[p][3]);
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, r), zero, _CMP_LT_OQ));
+        }
+
+        u32 mask = ~_mm256_movemask_ps(outside) & cull_tail_mask(bounds->count, i);
+        ret += cull_compact(visible + ret, i, mask);
+    }
+    return ret;
+}
+
+// The same arithmetic in the same order as the simd versions, so the lists match exactly.
+u32 cull_aabbs_scalar(const Frustum *frustum, const Cull_Bounds *bounds, u32 *visible) {
+    u32 ret = 0;
+    for(u32 i = 0; i < bounds->count; ++i) {
+        bool outside = false;
+        for(u32 p = 0; p < 6; ++p) {
+            const float *plane = frustum->planes[p];
+            float dist   = plane[0] * bounds->center[0][i] + plane[1] * bounds->center[1][i];
+            dist         = dist + plane[2] * bounds->center[2][i];
+            dist         = dist + plane[3];
+            float radius = fabsf(plane[0]) * bounds->extent[0][i] + fabsf(plane[1]) * bounds->extent[1][i];
+            radius       = radius + fabsf(plane[2]) * bounds->extent[2][i];
+            outside     |= dist + radius < 0;
+        }
+        if (!outside)
+            visible[ret++] = i;
+    }
+    return ret;
+}
+
+u32 cull_spheres_scalar(const Frustum *frustum, const Cull_Bounds *bounds, u32 *visible) {
+    u32 ret = 0;
+    for(u32 i = 0; i < bounds->count; ++i) {
+        bool outside = false;
+        for(u32 p = 0; p < 6; ++p) {
+            const float *plane = frustum->planes[p];
+            float dist = plane[0] * bounds->center[0][i] + plane[1] * bounds->center[1][i];
+            dist       = dist + plane[2] * bounds->center[2][i];
+            dist       = dist + plane[3];
+            outside   |= dist + bounds->radius[i] < 0;
+        }
+        if (!outside)
+            visible[ret++] = i;
+    }
+    return ret;
+}
+
+                                            /* Tests */
+
+#if TEST || BENCH
+// Bounds in 32 byte aligned temp memory.
+static void cull_bounds_init_temp(Cull_Bounds *bounds, u32 count) {
+    u8 *memory = malloc_t(cull_bounds_get_size(count) + 32, 4);
+    cull_bounds_init(bounds, count, (void*)align((u64)memory, 32));
+}
+
+// 'count' random boxes, centers in [-range, range) on every axis, rotated and scaled.
+static void cull_bounds_set_random(Cull_Bounds *bounds, float range, u32 seed) {
+    u32 rng = seed;
+    float r[7];
+    for(u32 i = 0; i < bounds->count; ++i) {
+        for(u32 c = 0; c < 7; ++c) {
+            rng  = rng * 1664525 + 1013904223;
+            r[c] = (float)(rng >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+        }
+        float min[] = {-0.5f - r[3] * 0.25f, -1.0f, -0.25f};
+        float max[] = { 0.5f,                 r[4] * 0.5f + 0.75f, 2.0f};
+
+        float s = sinf(r[5] * 3.14159f);
+        float c = cosf(r[5] * 3.14159f);
+        float k = 1.5f + r[6];
+        Mat4 world = {
+            { c * k, s * k, 0, 0,},
+            {-s * k, c * k, 0, 0,},
+            { 0,     0,     k, 0,},
+            { r[0] * range, r[1] * range, r[2] * range, 1,},
+        };
+        cull_bounds_set(bounds, i, min, max, &world);
+    }
+}
+
+// The frustum of camera.hpp's starting camera, 90 degrees, square, depth from 0.1 to 100.
+static void cull_get_test_frustum(Frustum *frustum) {
+    Camera camera = create_camera();
+    Mat4 view = camera_lookat(&camera);
+    Mat4 proj = perspective(3.14159265f * 0.5f, 1.0f, 0.1f, 100.0f);
+    Mat4 view_projection = mul_mat4(proj, view);
+    frustum_from_view_projection(frustum, &view_projection);
+}
+#endif
+
+#if TEST
+static float test_cull_plane_distance(const Frustum *frustum, u32 plane, float x, float y, float z) {
+    const float *p = frustum->planes[plane];
+    return p[0] * x + p[1] * y + p[2] * z + p[3];
+}
+
+void test_cull() {
+    u64 mark = get_mark_temp();
+
+    BEGIN_TEST_MODULE("Cull_Frustum", false, false);
+    {
+        // The camera is at (0, 0, 3) looking down -z.
+        Frustum frustum;
+        cull_get_test_frustum(&frustum);
+
+        TEST_EQ("near_at_near",  fabsf(test_cull_plane_distance(&frustum, 4, 0, 0, 2.9f)) < 1e-4f, true, false);
+        TEST_EQ("near_distance", fabsf(test_cull_plane_distance(&frustum, 4, 0, 0, 2.0f) - 0.9f) < 1e-4f, true, false);
+        TEST_EQ("far_distance",  fabsf(test_cull_plane_distance(&frustum, 5, 0, 0, 2.0f) - 99.0f) < 1e-2f, true, false);
+
+        // The side planes are at 45 degrees: a point on the axis 1 unit in front is 1 / sqrt(2) from each.
+        for(u32 p = 0; p < 4; ++p)
+            TEST_EQ("side_distance", fabsf(test_cull_plane_distance(&frustum, p, 0, 0, 2.0f) - 0.70710678f) < 1e-4f,
+                    true, false);
+
+        // In front, behind, far to the side, beyond the far plane, and across the near plane.
+        float centers[][3] = {{0, 0, 0}, {0, 0, 6}, {50, 0, 0}, {0, 0, -200}, {0, 0, 3}};
+        bool  expected[]   = {true, false, false, false, true};
+        const u32 count = 5;
+
+        Cull_Bounds bounds;
+        cull_bounds_init_temp(&bounds, count);
+        for(u32 i = 0; i < count; ++i) {
+            for(u32 c = 0; c < 3; ++c) {
+                bounds.center[c][i] = centers[i][c];
+                bounds.extent[c][i] = 0.5f;
+            }
+            bounds.radius[i] = 0.5f;
+        }
+
+        u32 visible[8];
+        u32 visible_count = cull_spheres(&frustum, &bounds, visible);
+        TEST_EQ("sphere_count", visible_count, 2, false);
+        for(u32 i = 0; i < visible_count; ++i)
+            TEST_EQ("sphere_visible", expected[visible[i]], true, false);
+
+        visible_count = cull_aabbs(&frustum, &bounds, visible);
+        TEST_EQ("aabb_count", visible_count, 2, false);
+        for(u32 i = 0; i < visible_count; ++i)
+            TEST_EQ("aabb_visible", expected[visible[i]], true, false);
+
+        // A box just outside the right plane, which the sphere around it crosses.
+        bounds.count = 1;
+        bounds.center[0][0] = 3.6f;
+        bounds.center[1][0] = 0;
+        bounds.center[2][0] = 0;
+        bounds.extent[0][0] = 0.1f;
+        bounds.extent[1][0] = 0.5f;
+        bounds.extent[2][0] = 0.1f;
+        bounds.radius[0]    = sqrtf(0.27f);
+        TEST_EQ("aabb_outside_edge",  cull_aabbs(&frustum, &bounds, visible), 0, false);
+        TEST_EQ("sphere_across_edge", cull_spheres(&frustum, &bounds, visible), 1, false);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Cull_Bounds", false, false);
+    {
+        Cull_Bounds bounds;
+        cull_bounds_init_temp(&bounds, 3);
+
+        // A unit box rotated 45 degrees about z and moved to (5, 0, 0), column major.
+        float h = 0.70710678f;
+        Mat4 world = {
+            { h, h, 0, 0,},
+            {-h, h, 0, 0,},
+            { 0, 0, 1, 0,},
+            { 5, 0, 0, 1,},
+        };
+        float min[] = {-0.5f, -0.5f, -0.5f};
+        float max[] = { 0.5f,  0.5f,  0.5f};
+        cull_bounds_set(&bounds, 0, min, max, &world);
+        TEST_EQ("center_x", fabsf(bounds.center[0][0] - 5.0f)  < 1e-6f, true, false);
+        TEST_EQ("center_y", fabsf(bounds.center[1][0])         < 1e-6f, true, false);
+        TEST_EQ("extent_x", fabsf(bounds.extent[0][0] - h)     < 1e-6f, true, false);
+        TEST_EQ("extent_y", fabsf(bounds.extent[1][0] - h)     < 1e-6f, true, false);
+        TEST_EQ("extent_z", fabsf(bounds.extent[2][0] - 0.5f)  < 1e-6f, true, false);
+        TEST_EQ("radius",   fabsf(bounds.radius[0] - sqrtf(0.75f)) < 1e-6f, true, false);
+
+        // Scaled by two on y only: the sphere takes the largest scale.
+        Mat4 scaled = {{1, 0, 0, 0,}, {0, 2, 0, 0,}, {0, 0, 1, 0,}, {0, 0, 0, 1,}};
+        cull_bounds_set(&bounds, 1, min, max, &scaled);
+        TEST_EQ("scaled_extent_y", fabsf(bounds.extent[1][1] - 1.0f) < 1e-6f, true, false);
+        TEST_EQ("scaled_radius",   fabsf(bounds.radius[1] - 2.0f * sqrtf(0.75f)) < 1e-6f, true, false);
+
+        // From a primitive's position accessor, and from one without a min and max, which is never culled.
+        Accessor_Max_Min max_min = {};
+        for(u32 i = 0; i < 3; ++i) {
+            max_min.min[i] = min[i];
+            max_min.max[i] = max[i];
+        }
+        Mesh_Primitive_Attribute attribute = {};
+        attribute.type = MESH_PRIMITIVE_ATTRIBUTE_TYPE_POSITION;
+        attribute.accessor.max_min = &max_min;
+        Mesh_Primitive primitive = {};
+        primitive.attribute_count = 1;
+        primitive.attributes = &attribute;
+        TEST_EQ("primitive", cull_bounds_set_from_primitive(&bounds, 2, &primitive, &world), true, false);
+        TEST_EQ("primitive_extent_x", fabsf(bounds.extent[0][2] - h) < 1e-6f, true, false);
+
+        attribute.accessor.max_min = NULL;
+        TEST_EQ("no_max_min", cull_bounds_set_from_primitive(&bounds, 2, &primitive, &world), false, false);
+
+        Frustum frustum;
+        cull_get_test_frustum(&frustum);
+        for(u32 c = 0; c < 3; ++c)
+            bounds.center[c][0] = bounds.center[c][1] = 1000.0f;
+        u32 visible[8];
+        TEST_EQ("infinite_aabb",   cull_aabbs(&frustum, &bounds, visible), 1, false);
+        TEST_EQ("infinite_aabb_2", visible[0], 2, false);
+        TEST_EQ("infinite_sphere", cull_spheres(&frustum, &bounds, visible), 1, false);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Cull_Simd_Matches_Scalar", false, false);
+    {
+        // Not a multiple of eight, for the tail.
+        const u32 count = 1003;
+        Cull_Bounds bounds;
+        cull_bounds_init_temp(&bounds, count);
+        cull_bounds_set_random(&bounds, 60.0f, 3);
+
+        Frustum frustum;
+        cull_get_test_frustum(&frustum);
+
+        u32 *simd   = (u32*)malloc_t(sizeof(u32) * align(count, 8), 4);
+        u32 *scalar = (u32*)malloc_t(sizeof(u32) * count, 4);
+
+        u32 simd_count   = cull_aabbs(&frustum, &bounds, simd);
+        u32 scalar_count = cull_aabbs_scalar(&frustum, &bounds, scalar);
+        TEST_EQ("aabb_count", simd_count, scalar_count, false);
+        TEST_EQ("aabb_list",  memcmp(simd, scalar, sizeof(u32) * scalar_count), 0, false);
+        TEST_LT("aabb_some_culled",  simd_count, count, false);
+        TEST_LT("aabb_some_visible", 0, simd_count, false);
+
+        simd_count   = cull_spheres(&frustum, &bounds, simd);
+        scalar_count = cull_spheres_scalar(&frustum, &bounds, scalar);
+        TEST_EQ("sphere_count", simd_count, scalar_count, false);
+        TEST_EQ("sphere_list",  memcmp(simd, scalar, sizeof(u32) * scalar_count), 0, false);
+        TEST_LT("sphere_some_culled", simd_count, count, false);
+        TEST_LT("sphere_some_visible", 0, simd_count, false);
+
+    }
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif // TEST
+
+#if BENCH
+//
+// 256k random bounds around a camera, so that some fraction is visible: simd against scalar, boxes and spheres.
+//
+void bench_cull() {
+    BENCH_MODULE("Cull");
+
+    u64 mark = get_mark_temp();
+
+    const u32 count = 256 * 1024;
+    Cull_Bounds bounds;
+    cull_bounds_init_temp(&bounds, count);
+    cull_bounds_set_random(&bounds, 120.0f, 7);
+
+    Frustum frustum;
+    cull_get_test_frustum(&frustum);
+
+    u32 *visible = (u32*)malloc_t(sizeof(u32) * align(count, 8), 4);
+
+    const u32 iterations = 32;
+    u64 ns[4] = {};
+    u32 visible_count[4];
+
+    Bench_Timer timer;
+    for(u32 it = 0; it < iterations; ++it) {
+        timer = begin_bench();
+        visible_count[0] = cull_aabbs(&frustum, &bounds, visible);
+        ns[0] += end_bench(&timer);
+        bench_keep(visible[0]);
+
+        timer = begin_bench();
+        visible_count[1] = cull_aabbs_scalar(&frustum, &bounds, visible);
+        ns[1] += end_bench(&timer);
+        bench_keep(visible[0]);
+
+        timer = begin_bench();
+        visible_count[2] = cull_spheres(&frustum, &bounds, visible);
+        ns[2] += end_bench(&timer);
+        bench_keep(visible[0]);
+
+        timer = begin_bench();
+        visible_count[3] = cull_spheres_scalar(&frustum, &bounds, visible);
+        ns[3] += end_bench(&timer);
+        bench_keep(visible[0]);
+    }
+
+    // Millions of primitives per second: count * iterations / (ns / 1e9) / 1e6.
+    double mprims[4];
+    for(u32 i = 0; i < 4; ++i)
+        mprims[i] = (double)count * iterations * 1000.0 / (double)ns[i];
+
+    println("    %u bounds:", (u64)count);
+    println("        aabbs:   simd %f Mprims/s, scalar %f Mprims/s, speedup %f, %u visible",
+            mprims[0], mprims[1], mprims[0] / mprims[1], (u64)visible_count[0]);
+    println("        spheres: simd %f Mprims/s, scalar %f Mprims/s, speedup %f, %u visible",
+            mprims[2], mprims[3], mprims[2] / mprims[3], (u64)visible_count[2]);
+
+    reset_to_mark_temp(mark);
+}
+#endif // BENCH
@@ -0,0 +1,68 @@
+#ifndef SOL_CULL_HPP_INCLUDE_GUARD_
+#define SOL_CULL_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "math.hpp"
+#include "asset.hpp"
+
+/*
+    Culling: a frustum from a view projection matrix, and bounds tested against it eight at a time.
+
+    Frustum planes are extracted from the rows of the view projection (Gribb and Hartmann): for a clip space
+    position (x, y, z, w), inside is -w <= x <= w, -w <= y <= w and 0 <= z <= w (vulkan's depth range), so each
+    plane is a sum or difference of two rows. The planes are normalized, and face into the frustum. The matrix is
+    math.hpp's convention, as from look_at(..) and perspective(..): rows are rows, and points are column vectors.
+
+    Bounds are world space, SoA: an axis aligned box (center and half extent) and a sphere around the same center. They
+    come from a primitive's POSITION min and max (the gltf accessor's, model space even if the positions were packed
+    at import) and a world transform. World transforms are column major as gltf's and scene.hpp's: Mat4 'rowN' is
+    column N.
+
+    cull_aabbs(..) and cull_spheres(..) test eight bounds per iteration against the six planes (a box is outside a
+    plane if its center is further behind it than the box's projected radius) and write the indices of the visible
+    ones, compacted, with a permute from a table of the 256 lane masks. Both are conservative, boxes near the frustum's
+    edges can pass when they are outside, and the _scalar versions give exactly the same lists.
+*/
+
+struct Frustum {
+    float planes[6][4]; // a, b, c, d: a point is in front of the plane if a * x + b * y + c * z + d >= 0
+};
+
+void frustum_from_view_projection(Frustum *frustum, const Mat4 *view_projection);
+
+struct Cull_Bounds {
+    u32 count;
+    float *center[3];
+    float *extent[3]; // Half size
+    float *radius;
+};
+
+// Bytes for 'count' bounds, and bounds in 'memory' (at least that many bytes, 32 byte aligned).
+u64  cull_bounds_get_size(u32 count);
+void cull_bounds_init(Cull_Bounds *bounds, u32 count, void *memory);
+
+// Bounds 'index' from a model space box and a world transform.
+void cull_bounds_set(Cull_Bounds *bounds, u32 index, const float *min, const float *max, const Mat4 *world);
+
+// Bounds 'index' from 'primitive's POSITION min and max. Without them (they are optional in gltf) the bounds are
+// infinite, so the primitive is never culled, and the return is false.
+bool cull_bounds_set_from_primitive(Cull_Bounds *bounds, u32 index, const Mesh_Primitive *primitive,
+                                    const Mat4 *world);
+
+// Write the indices of the bounds which are not outside 'frustum' to 'visible', and return how many there are.
+// 'visible' is written eight indices at a time, so it must have room for the count rounded up to eight.
+u32 cull_aabbs(const Frustum *frustum, const Cull_Bounds *bounds, u32 *visible);
+u32 cull_spheres(const Frustum *frustum, const Cull_Bounds *bounds, u32 *visible);
+
+u32 cull_aabbs_scalar(const Frustum *frustum, const Cull_Bounds *bounds, u32 *visible);
+u32 cull_spheres_scalar(const Frustum *frustum, const Cull_Bounds *bounds, u32 *visible);
+
+#if TEST
+    void test_cull();
+#endif
+
+#if BENCH
+    void bench_cull();
+#endif
+
+#endif // include guard
@@ -0,0 +1,758 @@
+#include "draw.hpp"
+#include "allocator.hpp"
+#include "print.h"
+#include "job.hpp"
+
+#if TEST
+    #include "test.hpp"
+#endif
+
+#if BENCH
+    #include "test/bench.hpp"
+#endif
+
+// Keys per chunk at least: below this the jobs cost more than they save.
+static constexpr u32 RADIX_MIN_CHUNK_SIZE = 16 * 1024;
+
+                                            /* Keys */
+
+Draw_Layer draw_get_layer(const Material *material) {
+    if (material->flags & MATERIAL_BLEND_BIT)
+        return DRAW_LAYER_BLEND;
+    if (material->flags & MATERIAL_MASK_BIT)
+        return DRAW_LAYER_MASK;
+    return DRAW_LAYER_OPAQUE;
+}
+
+static inline u32 draw_get_depth_bits(float depth) {
+    float d = depth > 0.0f ? depth : 0.0f; // Also clears NaN
+    u32 bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return bits >> 7; // The sign bit is clear, so this fits in 24
+}
+
+u64 draw_get_key(u32 pass, Draw_Layer layer, u32 pipeline, u32 material, float depth) {
+    assert(pass < DRAW_PASS_COUNT && pipeline < DRAW_PIPELINE_COUNT && material < DRAW_MATERIAL_COUNT);
+
+    u64 key = (u64)pass << 60 | (u64)layer << 58;
+    u64 d   = draw_get_depth_bits(depth);
+    if (layer == DRAW_LAYER_BLEND)
+        key |= (~d & DRAW_DEPTH_MASK) << 34 | (u64)pipeline << 22 | (u64)material << 6;
+    else
+        key |= (u64)pipeline << 46 | (u64)material << 30 | d << 6;
+    return key;
+}
+
+                                            /* Lists */
+
+// Dense index of each pipeline handle, so that they fit in the keys.
+static u32 draw_get_pipeline_index(Draw_List *list, VkPipeline *table, u32 *indices, u32 table_mask,
+                                   VkPipeline pipeline) {
+    u32 slot = (u32)(((u64)pipeline * 0x9e3779b97f4a7c15) >> 32) & table_mask;
+    while(indices[slot] != Max_u32) {
+        if (table[slot] == pipeline)
+            return indices[slot];
+        slot = (slot + 1) & table_mask;
+    }
+    assert(list->pipeline_count < DRAW_PIPELINE_COUNT && "Too many pipelines for the draw keys");
+    table[slot]   = pipeline;
+    indices[slot] = list->pipeline_count;
+    list->pipelines[list->pipeline_count] = pipeline;
+    return list->pipeline_count++;
+}
+
+void draw_list_build(Draw_List *list, const Draw_List_Info *info) {
+    const Primitive_Draw_Prep_Result *prep = info->prep;
+    u32 primitive_count = info->primitive_count;
+    assert(prep->success_masks || !primitive_count);
+
+    *list = {};
+    list->keys      = (u64*)malloc_t(sizeof(u64) * info->draw_count, 8);
+    list->draws     = (u32*)malloc_t(sizeof(u32) * info->draw_count, 4);
+    list->pipelines = (VkPipeline*)malloc_t(sizeof(VkPipeline) * (primitive_count ? primitive_count : 1), 8);
+
+    u64 mark = get_mark_temp();
+
+    // Each ready primitive's part of the key, Max_u64 for the rest.
+    u64 *bases = (u64*)malloc_t(sizeof(u64) * primitive_count, 8);
+
+    u32 table_size = 16;
+    while(table_size < primitive_count * 2)
+        table_size <<= 1;
+    VkPipeline *table   = (VkPipeline*)malloc_t(sizeof(VkPipeline) * table_size, 8);
+    u32        *indices = (u32*)malloc_t(sizeof(u32) * table_size, 4);
+    memset(indices, 0xff, sizeof(u32) * table_size);
+
+    for(u32 i = 0; i < primitive_count; ++i) {
+        if (!(prep->success_masks[i >> 6] & ((u64)1 << (i & 63)))) {
+            bases[i] = Max_u64;
+            continue;
+        }
+        VkPipeline pipeline = prep->pipelines ? prep->pipelines[i] : VK_NULL_HANDLE;
+        u32 pipeline_index  = draw_get_pipeline_index(list, table, indices, table_size - 1, pipeline);
+        u32 material        = info->materials ? info->materials[i] : i;
+
+        // Everything but the pass and depth, which are the draw's.
+        bases[i] = draw_get_key(0, draw_get_layer(&info->primitives[i].material), pipeline_index, material, 0.0f);
+    }
+
+    for(u32 i = 0; i < info->draw_count; ++i) {
+        const Draw *draw = &info->draws[i];
+        assert(draw->primitive < primitive_count && draw->pass < DRAW_PASS_COUNT);
+
+        u64 base = bases[draw->primitive];
+        if (base == Max_u64)
+            continue;
+        u64 d = draw_get_depth_bits(draw->depth);
+        if (draw_key_get_layer(base) == DRAW_LAYER_BLEND)
+            base ^= d << 34; // The base holds the inverse of zero depth
+        else
+            base |= d << 6;
+
+        list->keys[list->count]  = base | (u64)draw->pass << 60;
+        list->draws[list->count] = i;
+        list->count++;
+    }
+
+    reset_to_mark_temp(mark);
+}
+
+void draw_list_sort(Draw_List *list) {
+    u64 mark = get_mark_temp();
+    u64 *scratch_keys   = (u64*)malloc_t(sizeof(u64) * list->count, 8);
+    u32 *scratch_values = (u32*)malloc_t(sizeof(u32) * list->count, 4);
+    radix_sort(list->count, list->keys, list->draws, scratch_keys, scratch_values);
+    reset_to_mark_temp(mark);
+}
+
+                                            /* Radix Sort */
+
+struct Radix_Pass {
+    u32        shift;
+    u32        count;
+    u32        chunk_size;
+    u32        chunk_count;
+    const u64 *src_keys;
+    const u32 *src_values;
+    u64       *dst_keys;
+    u32       *dst_values;
+    u32       *offsets; // 256 per chunk: the count of each digit in the chunk, then where the chunk writes the first
+};
+
+struct Radix_Task {
+    Radix_Pass *pass;
+    u32         chunk;
+};
+
+static void radix_count(Radix_Pass *pass, u32 chunk) {
+    u32 *counts = pass->offsets + chunk * 256;
+    memset(counts, 0, sizeof(u32) * 256);
+
+    u32 begin = chunk * pass->chunk_size;
+    u32 end   = begin + pass->chunk_size < pass->count ? begin + pass->chunk_size : pass->count;
+    u32 shift = pass->shift;
+    for(u32 i = begin; i < end; ++i)
+        counts[(pass->src_keys[i] >> shift) & 0xff]++;
+}
+
+// Digits in order, and each digit's chunks in order, so equal keys keep their order.
+static void radix_prefix(Radix_Pass *pass) {
+    u32 offset = 0;
+    for(u32 d = 0; d < 256; ++d) {
+        for(u32 c = 0; c < pass->chunk_count; ++c) {
+            u32 count = pass->offsets[c * 256 + d];
+            pass->offsets[c * 256 + d] = offset;
+            offset += count;
+        }
+    }
+}
+
+static void radix_scatter(Radix_Pass *pass, u32 chunk) {
+    u32 offsets[256];
+    memcpy(offsets, pass->offsets + chunk * 256, sizeof(offsets));
+
+    u32 begin = chunk * pass->chunk_size;
+    u32 end   = begin + pass->chunk_size < pass->count ? begin + pass->chunk_size : pass->count;
+    u32 shift = pass->shift;
+    for(u32 i = begin; i < end; ++i) {
+        u64 key = pass->src_keys[i];
+        u32 to  = offsets[(key >> shift) & 0xff]++;
+        pass->dst_keys[to]   = key;
+        pass->dst_values[to] = pass->src_values[i];
+    }
+}
+
+static void radix_count_job(void *arg) {
+    Radix_Task *task = (Radix_Task*)arg;
+    radix_count(task->pass, task->chunk);
+}
+
+static void radix_prefix_job(void *arg) {
+    radix_prefix((Radix_Pass*)arg);
+}
+
+static void radix_scatter_job(void *arg) {
+    Radix_Task *task = (Radix_Task*)arg;
+    radix_scatter(task->pass, task->chunk);
+}
+
+void radix_sort(u32 count, u64 *keys, u32 *values, u64 *scratch_keys, u32 *scratch_values) {
+    if (count < 2)
+        return;
+
+    u64 mark = get_mark_temp();
+
+    u32 chunk_count = count / RADIX_MIN_CHUNK_SIZE;
+    u32 thread_count = get_job_thread_count();
+    chunk_count = chunk_count < thread_count ? chunk_count : thread_count;
+    chunk_count = chunk_count ? chunk_count : 1;
+
+    // Digits which are the same in every key do not move anything. In one chunk, every digit is counted in one read
+    // (the counts are the same each pass, only the order changes), otherwise the chunks count each pass.
+    u32 shifts[8];
+    u32 pass_count = 0;
+    u32 *offsets = (u32*)malloc_t(sizeof(u32) * 256 * (chunk_count == 1 ? 8 : chunk_count), 4);
+    if (chunk_count == 1) {
+        memset(offsets, 0, sizeof(u32) * 256 * 8);
+        for(u32 i = 0; i < count; ++i) {
+            u64 key = keys[i];
+            for(u32 d = 0; d < 8; ++d)
+                offsets[d * 256 + ((key >> (d * 8)) & 0xff)]++;
+        }
+        for(u32 d = 0; d < 8; ++d)
+            if (offsets[d * 256 + ((keys[0] >> (d * 8)) & 0xff)] != count)
+                shifts[pass_count++] = d * 8;
+    } else {
+        u64 all_and = Max_u64;
+        u64 all_or  = 0;
+        for(u32 i = 0; i < count; ++i) {
+            all_and &= keys[i];
+            all_or  |= keys[i];
+        }
+        u64 differ = all_and ^ all_or;
+        for(u32 shift = 0; shift < 64; shift += 8)
+            if ((differ >> shift) & 0xff)
+                shifts[pass_count++] = shift;
+    }
+
+    // In chunks, the passes run one after the other and share the offsets.
+    Radix_Pass *passes = (Radix_Pass*)malloc_t(sizeof(Radix_Pass) * pass_count, 8);
+    for(u32 p = 0; p < pass_count; ++p) {
+        bool from_keys = (p & 1) == 0;
+        passes[p] = {
+            .shift       = shifts[p],
+            .count       = count,
+            .chunk_size  = (count + chunk_count - 1) / chunk_count,
+            .chunk_count = chunk_count,
+            .src_keys    = from_keys ? keys : scratch_keys,
+            .src_values  = from_keys ? values : scratch_values,
+            .dst_keys    = from_keys ? scratch_keys : keys,
+            .dst_values  = from_keys ? scratch_values : values,
+            .offsets     = chunk_count == 1 ? offsets + shifts[p] * 32 : offsets,
+        };
+    }
+
+    if (chunk_count == 1) {
+        for(u32 p = 0; p < pass_count; ++p) {
+            radix_prefix(&passes[p]);
+            radix_scatter(&passes[p], 0);
+        }
+    } else {
+        // Per pass: a count job per chunk, the prefix job waiting on them, and a scatter job per chunk waiting on
+        // the prefix. The next pass's count jobs wait on every scatter job.
+        u32 stride = chunk_count * 2 + 1;
+        Job        *jobs  = (Job*)malloc_t(sizeof(Job) * stride * pass_count, 8);
+        Radix_Task *tasks = (Radix_Task*)malloc_t(sizeof(Radix_Task) * chunk_count * pass_count, 8);
+        u32        *links = (u32*)malloc_t(sizeof(u32) * stride * pass_count, 4); // Per pass: prefix, scatters, counts
+
+        for(u32 p = 0; p < pass_count; ++p) {
+            u32  first = p * stride;
+            u32 *link  = links + first;
+            link[0] = first + chunk_count;
+            for(u32 c = 0; c < chunk_count; ++c) {
+                link[1 + c]               = first + chunk_count + 1 + c;
+                link[1 + chunk_count + c] = first + c;
+            }
+        }
+        for(u32 p = 0; p < pass_count; ++p) {
+            u32  first = p * stride;
+            u32 *link  = links + first;
+            bool last  = p + 1 == pass_count;
+            for(u32 c = 0; c < chunk_count; ++c) {
+                Radix_Task *task = &tasks[p * chunk_count + c];
+                *task = {.pass = &passes[p], .chunk = c};
+                jobs[first + c] = {
+                    .func            = radix_count_job,
+                    .arg             = task,
+                    .wait_count      = p ? chunk_count : 0,
+                    .dependent_count = 1,
+                    .dependents      = link,
+                };
+                jobs[first + chunk_count + 1 + c] = {
+                    .func            = radix_scatter_job,
+                    .arg             = task,
+                    .wait_count      = 1,
+                    .dependent_count = last ? 0 : chunk_count,
+                    .dependents      = last ? NULL : link + stride + 1 + chunk_count,
+                };
+            }
+            jobs[first + chunk_count] = {
+                .func            = radix_prefix_job,
+                .arg             = &passes[p],
+                .wait_count      = chunk_count,
+                .dependent_count = chunk_count,
+                .dependents      = link + 1,
+            };
+        }
+        run_jobs(stride * pass_count, jobs);
+    }
+
+    if (pass_count & 1) {
+        memcpy(keys,   scratch_keys,   sizeof(u64) * count);
+        memcpy(values, scratch_values, sizeof(u32) * count);
+    }
+
+    reset_to_mark_temp(mark);
+}
+
+                                            /* Recording */
+
+void draw_recorder_init_temp(Draw_Recorder *recorder, u32 draw_count) {
+    *recorder = {};
+    recorder->capacity = draw_count * 4;
+    recorder->commands = (Draw_Command*)malloc_t(sizeof(Draw_Command) * recorder->capacity, 4);
+}
+
+static inline void draw_recorder_add(Draw_Recorder *recorder, Draw_Command_Type type, u32 value) {
+    assert(recorder->count < recorder->capacity && "Draw recorder is full");
+    recorder->commands[recorder->count++] = {.type = type, .value = value};
+}
+
+void draw_list_record(const Draw_List *list, Draw_Recorder *recorder) {
+    u32 pass     = Max_u32;
+    u32 pipeline = Max_u32;
+    u32 material = Max_u32;
+    for(u32 i = 0; i < list->count; ++i) {
+        u64 key = list->keys[i];
+        if (draw_key_get_pass(key) != pass) {
+            pass     = draw_key_get_pass(key);
+            pipeline = Max_u32;
+            material = Max_u32;
+            draw_recorder_add(recorder, DRAW_COMMAND_BEGIN_PASS, pass);
+            recorder->pass_count++;
+        }
+        if (draw_key_get_pipeline(key) != pipeline) {
+            pipeline = draw_key_get_pipeline(key);
+            draw_recorder_add(recorder, DRAW_COMMAND_BIND_PIPELINE, pipeline);
+            recorder->pipeline_binds++;
+        }
+        if (draw_key_get_material(key) != material) {
+            material = draw_key_get_material(key);
+            draw_recorder_add(recorder, DRAW_COMMAND_BIND_MATERIAL, material);
+            recorder->material_binds++;
+        }
+        draw_recorder_add(recorder, DRAW_COMMAND_DRAW, list->draws[i]);
+        recorder->draw_count++;
+    }
+}
+
+#if TEST || BENCH
+
+// Models of four primitives with random pipelines and materials, a tenth of them blended and a twentieth masked,
+// drawn as instances at random depths in model and primitive order. Every eighth primitive is not ready if
+// 'all_ready' is false.
+static void draw_info_init_temp(Draw_List_Info *info, u32 model_count, u32 pipeline_count, u32 material_count,
+                                u32 draw_count, u32 pass_count, bool all_ready, u32 seed)
+{
+    u32 primitive_count = model_count * 4;
+    u32 rng = seed;
+
+    // malloc_t(..) aligns the offset, not the address.
+    u8 *memory = malloc_t(sizeof(Mesh_Primitive) * primitive_count + sizeof(Primitive_Draw_Prep_Result) + 16, 16);
+    memory = (u8*)align((u64)memory, 16);
+    Primitive_Draw_Prep_Result *prep = (Primitive_Draw_Prep_Result*)memory;
+    Mesh_Primitive *primitives = (Mesh_Primitive*)(memory + align(sizeof(Primitive_Draw_Prep_Result), 16));
+    VkPipeline     *pipelines  = (VkPipeline*)malloc_t(sizeof(VkPipeline) * primitive_count, 8);
+    u32            *materials  = (u32*)malloc_t(sizeof(u32) * primitive_count, 4);
+    u64            *masks      = (u64*)malloc_t(sizeof(u64) * (primitive_count / 64 + 1), 8);
+    memset(primitives, 0, sizeof(Mesh_Primitive) * primitive_count);
+    memset(masks, 0, sizeof(u64) * (primitive_count / 64 + 1));
+
+    for(u32 i = 0; i < primitive_count; ++i) {
+        rng = rng * 1664525 + 1013904223;
+        u32 kind = (rng >> 8) % 20;
+        primitives[i].material.flags = kind < 2 ? MATERIAL_BLEND_BIT : kind < 3 ? MATERIAL_MASK_BIT :
+                                                                                  MATERIAL_OPAQUE_BIT;
+        rng = rng * 1664525 + 1013904223;
+        pipelines[i] = (VkPipeline)(u64)(0x1000 + ((rng >> 8) % pipeline_count) * 64);
+        rng = rng * 1664525 + 1013904223;
+        materials[i] = (rng >> 8) % material_count;
+        if (all_ready || i % 8 != 5)
+            masks[i >> 6] |= (u64)1 << (i & 63);
+    }
+
+    *prep = {};
+    prep->success_masks = masks;
+    prep->pipelines     = pipelines;
+
+    Draw *draws = (Draw*)malloc_t(sizeof(Draw) * draw_count, 4);
+    for(u32 i = 0; i < draw_count;) {
+        rng = rng * 1664525 + 1013904223;
+        u32 model = (rng >> 8) % model_count;
+        rng = rng * 1664525 + 1013904223;
+        float depth = (float)(rng >> 8) / (float)(1 << 24) * 500.0f - 2.0f;
+        rng = rng * 1664525 + 1013904223;
+        u32 pass = (rng >> 8) % pass_count;
+        for(u32 p = 0; p < 4 && i < draw_count; ++p, ++i)
+            draws[i] = {.primitive = model * 4 + p, .pass = pass, .depth = depth + (float)p * 0.25f};
+    }
+
+    *info = {
+        .primitive_count = primitive_count,
+        .primitives      = primitives,
+        .prep            = prep,
+        .materials       = materials,
+        .draw_count      = draw_count,
+        .draws           = draws,
+    };
+}
+
+static void draw_keys_set_random(u32 count, u64 *keys, u32 *values, u64 mask, u32 seed) {
+    u64 rng = seed;
+    for(u32 i = 0; i < count; ++i) {
+        rng = rng * 6364136223846793005 + 1442695040888963407;
+        keys[i]   = (rng ^ (rng >> 29)) & mask;
+        values[i] = i;
+    }
+}
+
+#endif // TEST || BENCH
+
+#if TEST
+struct Test_Draw_Pair {
+    u64 key;
+    u32 value;
+};
+
+static int test_draw_compare_pairs(const void *a, const void *b) {
+    const Test_Draw_Pair *x = (const Test_Draw_Pair*)a;
+    const Test_Draw_Pair *y = (const Test_Draw_Pair*)b;
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+    return x->value < y->value ? -1 : x->value > y->value;
+}
+
+// Radix sorted, the keys and values are as a sort by key then value (the values start in order, so this is stable).
+static bool test_draw_sort_matches(u32 count, u64 mask, u32 seed) {
+    u64 mark = get_mark_temp();
+
+    u64 *keys           = (u64*)malloc_t(sizeof(u64) * count, 8);
+    u32 *values         = (u32*)malloc_t(sizeof(u32) * count, 4);
+    u64 *scratch_keys   = (u64*)malloc_t(sizeof(u64) * count, 8);
+    u32 *scratch_values = (u32*)malloc_t(sizeof(u32) * count, 4);
+    Test_Draw_Pair *pairs = (Test_Draw_Pair*)malloc_t(sizeof(Test_Draw_Pair) * count, 8);
+
+    draw_keys_set_random(count, keys, values, mask, seed);
+    for(u32 i = 0; i < count; ++i)
+        pairs[i] = {.key = keys[i], .value = values[i]};
+    qsort(pairs, count, sizeof(Test_Draw_Pair), test_draw_compare_pairs);
+
+    radix_sort(count, keys, values, scratch_keys, scratch_values);
+
+    bool ret = true;
+    for(u32 i = 0; i < count; ++i)
+        ret &= keys[i] == pairs[i].key && values[i] == pairs[i].value;
+
+    reset_to_mark_temp(mark);
+    return ret;
+}
+
+// Replay the recorded commands: every ready draw is made once, with its own pass, pipeline and material bound.
+static bool test_draw_replay_is_valid(const Draw_List_Info *info, const Draw_List *list, const Draw_Recorder *rec) {
+    u64 mark = get_mark_temp();
+
+    u32 *seen = (u32*)malloc_t(sizeof(u32) * info->draw_count, 4);
+    memset(seen, 0, sizeof(u32) * info->draw_count);
+
+    bool ret = true;
+    u32 pass     = Max_u32;
+    u32 pipeline = Max_u32;
+    u32 material = Max_u32;
+    for(u32 i = 0; i < rec->count; ++i) {
+        Draw_Command command = rec->commands[i];
+        switch(command.type) {
+        case DRAW_COMMAND_BEGIN_PASS:
+            pass = command.value;
+            break;
+        case DRAW_COMMAND_BIND_PIPELINE:
+            ret &= command.value < list->pipeline_count;
+            pipeline = command.value;
+            break;
+        case DRAW_COMMAND_BIND_MATERIAL:
+            material = command.value;
+            break;
+        case DRAW_COMMAND_DRAW:
+        {
+            const Draw *draw = &info->draws[command.value];
+            ret &= pass == draw->pass && pipeline < list->pipeline_count &&
+                   list->pipelines[pipeline] == info->prep->pipelines[draw->primitive] &&
+                   material == info->materials[draw->primitive];
+            seen[command.value]++;
+            break;
+        }
+        default:
+            ret = false;
+        }
+    }
+    for(u32 i = 0; i < info->draw_count; ++i) {
+        u32 p = info->draws[i].primitive;
+        bool ready = info->prep->success_masks[p >> 6] & ((u64)1 << (p & 63));
+        ret &= seen[i] == (u32)ready;
+    }
+
+    reset_to_mark_temp(mark);
+    return ret;
+}
+
+// Passes and layers in order, opaque and masked runs of a pipeline and material front to back, blended back to front.
+static bool test_draw_order_is_valid(const Draw_List_Info *info, const Draw_List *list) {
+    bool ret = true;
+    for(u32 i = 1; i < list->count; ++i) {
+        u64 a = list->keys[i - 1];
+        u64 b = list->keys[i];
+        const Draw *x = &info->draws[list->draws[i - 1]];
+        const Draw *y = &info->draws[list->draws[i]];
+        float dx = x->depth > 0.0f ? x->depth : 0.0f;
+        float dy = y->depth > 0.0f ? y->depth : 0.0f;
+
+        ret &= a <= b && x->pass <= y->pass;
+        if (x->pass != y->pass)
+            continue;
+        ret &= draw_key_get_layer(a) <= draw_key_get_layer(b);
+        if (draw_key_get_layer(a) != draw_key_get_layer(b))
+            continue;
+        if (draw_key_get_layer(a) == DRAW_LAYER_BLEND)
+            ret &= dx >= dy;
+        else if (draw_key_get_pipeline(a) == draw_key_get_pipeline(b) &&
+                 draw_key_get_material(a) == draw_key_get_material(b))
+            ret &= dx <= dy;
+    }
+    return ret;
+}
+
+void test_draw() {
+    u64 mark = get_mark_temp();
+
+    BEGIN_TEST_MODULE("Radix_Sort", false, false);
+    {
+        TEST_EQ("none",  test_draw_sort_matches(0, Max_u64, 1), true, false);
+        TEST_EQ("one",   test_draw_sort_matches(1, Max_u64, 1), true, false);
+        TEST_EQ("small", test_draw_sort_matches(1000, Max_u64, 2), true, false);
+
+        // Many duplicates, and digits which are the same in every key: an odd number of passes is copied back.
+        TEST_EQ("duplicates", test_draw_sort_matches(5000, 0x00ff00000000ff0f, 3), true, false);
+        TEST_EQ("one_digit",  test_draw_sort_matches(5000, 0x0000ff0000000000, 4), true, false);
+        TEST_EQ("same",       test_draw_sort_matches(5000, 0, 5), true, false);
+
+        // Large enough to be split into chunks, and not a multiple of them.
+        TEST_EQ("chunks",     test_draw_sort_matches(100003, Max_u64, 6), true, false);
+        TEST_EQ("chunks_dup", test_draw_sort_matches(100003, 0xf0000000003f00ff, 7), true, false);
+
+        set_job_thread_limit(1);
+        TEST_EQ("chunks_one_thread", test_draw_sort_matches(100003, Max_u64, 6), true, false);
+        set_job_thread_limit(get_job_thread_count());
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Draw_Keys", false, false);
+    {
+        // Opaque front to back, blended back to front.
+        TEST_EQ("opaque_near_first", draw_get_key(0, DRAW_LAYER_OPAQUE, 3, 7, 1.0f) <
+                                     draw_get_key(0, DRAW_LAYER_OPAQUE, 3, 7, 2.0f), true, false);
+        TEST_EQ("blend_far_first",   draw_get_key(0, DRAW_LAYER_BLEND, 3, 7, 2.0f) <
+                                     draw_get_key(0, DRAW_LAYER_BLEND, 3, 7, 1.0f), true, false);
+
+        // Passes, then layers, then state before depth for opaque, and depth before state for blended.
+        TEST_EQ("pass_first",     draw_get_key(0, DRAW_LAYER_BLEND, 4095, 65535, 0.0f) <
+                                  draw_get_key(1, DRAW_LAYER_OPAQUE, 0, 0, 1.0f), true, false);
+        TEST_EQ("opaque_masked",  draw_get_key(0, DRAW_LAYER_OPAQUE, 4095, 65535, 1e30f) <
+                                  draw_get_key(0, DRAW_LAYER_MASK, 0, 0, 0.0f), true, false);
+        TEST_EQ("masked_blend",   draw_get_key(0, DRAW_LAYER_MASK, 4095, 65535, 1e30f) <
+                                  draw_get_key(0, DRAW_LAYER_BLEND, 0, 0, 1e30f), true, false);
+        TEST_EQ("opaque_state",   draw_get_key(0, DRAW_LAYER_OPAQUE, 1, 2, 100.0f) <
+                                  draw_get_key(0, DRAW_LAYER_OPAQUE, 1, 3, 1.0f), true, false);
+        TEST_EQ("blend_depth",    draw_get_key(0, DRAW_LAYER_BLEND, 9, 2, 100.0f) <
+                                  draw_get_key(0, DRAW_LAYER_BLEND, 1, 1, 1.0f), true, false);
+
+        // Behind the camera is zero, and the fields come back out.
+        TEST_EQ("behind", draw_get_key(2, DRAW_LAYER_OPAQUE, 5, 6, -3.0f) ==
+                          draw_get_key(2, DRAW_LAYER_OPAQUE, 5, 6, 0.0f), true, false);
+        u64 keys[] = {draw_get_key(15, DRAW_LAYER_OPAQUE, 4095, 65535, 1e30f),
+                      draw_get_key(7, DRAW_LAYER_MASK, 1234, 4321, 0.5f),
+                      draw_get_key(3, DRAW_LAYER_BLEND, 4095, 65535, 0.0f)};
+        u32 fields[][4] = {{15, DRAW_LAYER_OPAQUE, 4095, 65535}, {7, DRAW_LAYER_MASK, 1234, 4321},
+                           {3, DRAW_LAYER_BLEND, 4095, 65535}};
+        bool ret = true;
+        for(u32 i = 0; i < 3; ++i)
+            ret &= draw_key_get_pass(keys[i]) == fields[i][0] && draw_key_get_layer(keys[i]) == fields[i][1] &&
+                   draw_key_get_pipeline(keys[i]) == fields[i][2] && draw_key_get_material(keys[i]) == fields[i][3];
+        TEST_EQ("fields", ret, true, false);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Draw_List", false, false);
+    {
+        Draw_List_Info info;
+        draw_info_init_temp(&info, 64, 12, 40, 3001, 3, false, 11);
+
+        Draw_List list;
+        draw_list_build(&list, &info);
+        u32 ready_count = 0;
+        for(u32 i = 0; i < info.draw_count; ++i)
+            ready_count += info.draws[i].primitive % 8 != 5;
+        TEST_EQ("count", list.count, ready_count, false);
+        TEST_LT("pipeline_count", list.pipeline_count, 13, false);
+
+        Draw_Recorder before;
+        draw_recorder_init_temp(&before, list.count);
+        draw_list_record(&list, &before);
+        TEST_EQ("replay_before", test_draw_replay_is_valid(&info, &list, &before), true, false);
+
+        draw_list_sort(&list);
+        TEST_EQ("order", test_draw_order_is_valid(&info, &list), true, false);
+
+        Draw_Recorder after;
+        draw_recorder_init_temp(&after, list.count);
+        draw_list_record(&list, &after);
+        TEST_EQ("replay_after",   test_draw_replay_is_valid(&info, &list, &after), true, false);
+        TEST_EQ("draw_count",     after.draw_count, before.draw_count, false);
+        TEST_EQ("pass_count",     after.pass_count, 3, false);
+        TEST_LT("pipeline_binds", after.pipeline_binds, before.pipeline_binds, false);
+        TEST_LT("material_binds", after.material_binds, before.material_binds, false);
+
+        // Without blending, each pass and layer binds each of its pipelines once.
+        for(u32 i = 0; i < info.primitive_count; ++i)
+            ((Mesh_Primitive*)info.primitives)[i].material.flags &= ~MATERIAL_BLEND_BIT;
+        draw_list_build(&list, &info);
+        draw_list_sort(&list);
+        TEST_EQ("order_opaque", test_draw_order_is_valid(&info, &list), true, false);
+
+        bool seen[DRAW_PASS_COUNT][2][12] = {};
+        u32 group_count = 0;
+        for(u32 i = 0; i < list.count; ++i) {
+            u64 key = list.keys[i];
+            bool *s = &seen[draw_key_get_pass(key)][draw_key_get_layer(key)][draw_key_get_pipeline(key)];
+            group_count += !*s;
+            *s = true;
+        }
+        Draw_Recorder opaque;
+        draw_recorder_init_temp(&opaque, list.count);
+        draw_list_record(&list, &opaque);
+        TEST_EQ("replay_opaque",         test_draw_replay_is_valid(&info, &list, &opaque), true, false);
+        TEST_EQ("pipeline_binds_opaque", opaque.pipeline_binds, group_count, false);
+
+        // Without the prep result's pipelines, every draw is the one (null) pipeline.
+        Primitive_Draw_Prep_Result prep = *info.prep;
+        prep.pipelines = NULL;
+        info.prep = &prep;
+        draw_list_build(&list, &info);
+        TEST_EQ("no_pipelines_count", list.pipeline_count, 1, false);
+        TEST_EQ("no_pipelines_null",  list.pipelines[0] == VK_NULL_HANDLE, true, false);
+
+        info.draw_count = 0;
+        draw_list_build(&list, &info);
+        draw_list_sort(&list);
+        TEST_EQ("empty", list.count, 0, false);
+    }
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif // TEST
+
+#if BENCH
+//
+// A frame's draws (models of four primitives, 48 pipelines, 1024 materials) in model order: building the list,
+// sorting it on one thread against the pool and against qsort, and the binds recorded before and after.
+//
+struct Bench_Draw_Pair {
+    u64 key;
+    u32 value;
+};
+
+static int bench_draw_compare_pairs(const void *a, const void *b) {
+    u64 x = ((const Bench_Draw_Pair*)a)->key;
+    u64 y = ((const Bench_Draw_Pair*)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+void bench_draw() {
+    BENCH_MODULE("Draw");
+
+    u32 thread_count = get_job_thread_count();
+    u32 draw_counts[] = {4 * 1024, 64 * 1024, 256 * 1024};
+    for(u32 s = 0; s < sizeof(draw_counts) / sizeof(draw_counts[0]); ++s) {
+        u64 mark = get_mark_temp();
+
+        u32 count = draw_counts[s];
+        Draw_List_Info info;
+        draw_info_init_temp(&info, 2048, 48, 1024, count, 2, true, 13);
+
+        const u32 iterations = 16;
+        Bench_Timer timer;
+        Draw_List list;
+        u64 ns_build   = 0;
+        u64 ns_sort[2] = {};
+        for(u32 t = 0; t < 2; ++t) {
+            set_job_thread_limit(t ? thread_count : 1);
+            for(u32 it = 0; it < iterations; ++it) {
+                u64 it_mark = get_mark_temp();
+                timer = begin_bench();
+                draw_list_build(&list, &info);
+                ns_build += end_bench(&timer);
+                timer = begin_bench();
+                draw_list_sort(&list);
+                ns_sort[t] += end_bench(&timer);
+                bench_keep(list.keys[0]);
+                reset_to_mark_temp(it_mark);
+            }
+        }
+        set_job_thread_limit(thread_count);
+
+        // qsort of the same keys and indices.
+        u64 ns_qsort = 0;
+        for(u32 it = 0; it < iterations; ++it) {
+            u64 it_mark = get_mark_temp();
+            draw_list_build(&list, &info);
+            Bench_Draw_Pair *pairs = (Bench_Draw_Pair*)malloc_t(sizeof(Bench_Draw_Pair) * list.count, 8);
+            for(u32 i = 0; i < list.count; ++i)
+                pairs[i] = {.key = list.keys[i], .value = list.draws[i]};
+            timer = begin_bench();
+            qsort(pairs, list.count, sizeof(Bench_Draw_Pair), bench_draw_compare_pairs);
+            ns_qsort += end_bench(&timer);
+            bench_keep(pairs[0].key);
+            reset_to_mark_temp(it_mark);
+        }
+
+        draw_list_build(&list, &info);
+        Draw_Recorder before;
+        draw_recorder_init_temp(&before, list.count);
+        draw_list_record(&list, &before);
+        draw_list_sort(&list);
+        Draw_Recorder after;
+        draw_recorder_init_temp(&after, list.count);
+        draw_list_record(&list, &after);
+
+        println("    %u draws:", (u64)count);
+        println("        build %f us, sort: radix 1 thread %f us (%f Mkeys/s), %u threads %f us, qsort %f us",
+                (double)ns_build / (iterations * 2) / 1000.0, (double)ns_sort[0] / iterations / 1000.0,
+                (double)count * iterations / ((double)ns_sort[0] / 1000.0), (u64)thread_count,
+                (double)ns_sort[1] / iterations / 1000.0, (double)ns_qsort / iterations / 1000.0);
+        println("        binds per frame: pipelines %u -> %u, materials %u -> %u",
+                (u64)before.pipeline_binds, (u64)after.pipeline_binds,
+                (u64)before.material_binds, (u64)after.material_binds);
+
+        reset_to_mark_temp(mark);
+    }
+}
+#endif // BENCH
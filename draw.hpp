@@ -0,0 +1,138 @@
+#ifndef SOL_DRAW_HPP_INCLUDE_GUARD_
+#define SOL_DRAW_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "asset.hpp"
+
+/*
+    Draw lists: the draws of a frame sorted by the state they need, so that binds are made once per run of draws
+    rather than once per draw, as they are in model and primitive order.
+
+    Each draw gets a 64 bit key, most significant field first:
+
+        opaque and masked: pass (4) | layer (2) | pipeline (12) | material (16) | depth (24)    | 0 (6)
+        blended:           pass (4) | layer (2) | depth (24)    | pipeline (12) | material (16) | 0 (6)
+
+    Passes are recorded in order, and in each the layers: opaque, then masked (alpha tested, so they come after the
+    opaque depth is down), then blended (MATERIAL_BLEND_BIT). Opaque and masked draws are grouped by pipeline and then
+    material, and within a group go front to back for early depth rejection. Blended draws must go back to front to
+    blend correctly, so their depth (inverted) comes before the state, and they are only grouped where it ties.
+
+    Depth is the float's bits: a positive float orders as its bits do, so dropping the sign and the low seven
+    mantissa bits leaves 24 bits with the same relative precision at any distance, and no far plane to clamp to.
+    Depths behind the camera are zero.
+
+    The keys are sorted (with the indices of their draws) by radix_sort(..): LSD, eight bits at a time, stable, and
+    skipping the digits which are the same in every key (the bottom six bits always, and usually the pass and layer).
+    Large lists are split into a chunk per thread: each pass, every chunk counts its digits, the counts become
+    offsets (by digit, then chunk, which keeps it stable), and every chunk scatters to its offsets. The passes are
+    one job list (see job.hpp), each waiting on the one before it.
+
+    A Draw_Recorder records a sorted (or unsorted) list as the commands it would make, binding only on changes, and
+    counts them, so the state changes per frame can be seen before and after sorting.
+*/
+
+enum Draw_Layer : u32 {
+    DRAW_LAYER_OPAQUE = 0,
+    DRAW_LAYER_MASK   = 1,
+    DRAW_LAYER_BLEND  = 2,
+};
+
+static constexpr u32 DRAW_PASS_COUNT     = 16;
+static constexpr u32 DRAW_PIPELINE_COUNT = 4096;
+static constexpr u32 DRAW_MATERIAL_COUNT = 64 * 1024;
+static constexpr u32 DRAW_DEPTH_MASK     = 0xffffff;
+
+// Layer of a primitive with 'material'.
+Draw_Layer draw_get_layer(const Material *material);
+
+u64 draw_get_key(u32 pass, Draw_Layer layer, u32 pipeline, u32 material, float depth);
+
+inline static u32 draw_key_get_pass(u64 key) {
+    return (u32)(key >> 60);
+}
+inline static Draw_Layer draw_key_get_layer(u64 key) {
+    return (Draw_Layer)((key >> 58) & 0x3);
+}
+inline static u32 draw_key_get_pipeline(u64 key) {
+    return (u32)(key >> (draw_key_get_layer(key) == DRAW_LAYER_BLEND ? 22 : 46)) & (DRAW_PIPELINE_COUNT - 1);
+}
+inline static u32 draw_key_get_material(u64 key) {
+    return (u32)(key >> (draw_key_get_layer(key) == DRAW_LAYER_BLEND ? 6 : 30)) & (DRAW_MATERIAL_COUNT - 1);
+}
+
+struct Draw {
+    u32   primitive; // Index in the primitives given to prepare_to_draw_primitives(..)
+    u32   pass;      // Less than DRAW_PASS_COUNT, passes are recorded in order
+    float depth;     // Distance in front of the camera, along its view direction
+};
+
+struct Draw_List_Info {
+    u32                               primitive_count;
+    const Mesh_Primitive             *primitives;
+    const Primitive_Draw_Prep_Result *prep; // Only draws of primitives in its success masks are listed
+
+    // Per primitive, its material's descriptors: the offset of its set in the descriptor buffer over the set size.
+    // NULL if each primitive has a set of its own (as load_primitive_info(..) allocates them).
+    const u32 *materials;
+
+    u32         draw_count;
+    const Draw *draws;
+};
+
+struct Draw_List {
+    u32         count;
+    u32         pipeline_count;
+    u64        *keys;
+    u32        *draws;     // Index in the info's draws of each key
+    VkPipeline *pipelines; // Per pipeline in the keys, from the prep result's (all VK_NULL_HANDLE without them)
+};
+
+// The keys of the draws of ready primitives, in the order of 'draws'. The list is allocated in temp.
+void draw_list_build(Draw_List *list, const Draw_List_Info *info);
+
+// Sort the list by key. Uses the job pool, so call it from the thread which started the pool.
+void draw_list_sort(Draw_List *list);
+
+// Stable sort of 'count' keys, and 'values' with them. The scratch arrays need room for 'count' each.
+void radix_sort(u32 count, u64 *keys, u32 *values, u64 *scratch_keys, u32 *scratch_values);
+
+enum Draw_Command_Type : u32 {
+    DRAW_COMMAND_BEGIN_PASS    = 0,
+    DRAW_COMMAND_BIND_PIPELINE = 1,
+    DRAW_COMMAND_BIND_MATERIAL = 2,
+    DRAW_COMMAND_DRAW          = 3,
+};
+
+struct Draw_Command {
+    Draw_Command_Type type;
+    u32               value; // Pass, pipeline (index in the list's pipelines), material, or draw (index in its info)
+};
+
+struct Draw_Recorder {
+    u32           capacity;
+    u32           count;
+    Draw_Command *commands; // At most four per draw
+
+    u32 pass_count;
+    u32 pipeline_binds;
+    u32 material_binds;
+    u32 draw_count;
+};
+
+// Recorder with room for 'draw_count' draws, allocated in temp.
+void draw_recorder_init_temp(Draw_Recorder *recorder, u32 draw_count);
+
+// Record 'list' in its order: each pass is begun when it changes, each pipeline and material bound when it changes
+// (a new pass binds both again), and each draw. Appends to what the recorder already holds.
+void draw_list_record(const Draw_List *list, Draw_Recorder *recorder);
+
+#if TEST
+    void test_draw();
+#endif
+
+#if BENCH
+    void bench_draw();
+#endif
+
+#endif // include guard
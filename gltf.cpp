@@ -8,6 +8,10 @@
     #include "test.hpp"
 #endif
 
+#if BENCH
+    #include "bench.hpp"
+#endif
+
 /*  @Note:
 
     After using the gltf parser for a bit, I think I should go back and revert the parser
@@ -21,6 +25,19 @@
 
 // @Note Notes on file implementation process and old code at the bottom of the file
 
+//
+// Where the parser allocates. NULL is the temp allocator; parsing into a Gltf_Document points this at its arena
+// for the duration of the parse. Thread local so that documents can be parsed on loader threads.
+//
+static thread_local Linear_Allocator *gltf_arena = NULL;
+
+inline static u8* gltf_alloc(u64 size, u64 alignment) {
+    return gltf_arena ? malloc_linear(gltf_arena, size, alignment) : malloc_t(size, alignment);
+}
+inline static u64 gltf_get_mark() {
+    return gltf_arena ? gltf_arena->used : get_mark_temp();
+}
+
 Gltf parse_gltf(const char *filename);
 
 Gltf_Animation* gltf_parse_animations(const char *data, u64 *offset, int *animation_count);
@@ -31,7 +48,9 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
 void gltf_parse_accessor_sparse(const char *data, u64 *offset, Gltf_Accessor *accessor);
 
 Gltf_Buffer* gltf_parse_buffers(const char *data, u64 *offset, int *buffer_count);
+void gltf_parse_buffer_extensions(const char *data, u64 *offset, Gltf_Buffer *buffer);
 Gltf_Buffer_View* gltf_parse_buffer_views(const char *data, u64 *offset, int *buffer_view_count);
+void gltf_parse_buffer_view_extensions(const char *data, u64 *offset, Gltf_Buffer_View *buffer_view);
 
 Gltf_Camera* gltf_parse_cameras(const char *data, u64 *offset, int *camera_count);
 
@@ -111,7 +130,342 @@ inline u64 gltf_ascii_to_u64(const char *data, u64 *offset) {
     return accum;
 }
 
-Gltf parse_gltf(const char *filename) {
+//
+// Key dispatch: each object's key set gets a perfect hash which is built at compile time. A key hashes from its
+// length and its first and last 8 bytes (the last bytes are what separate keys like byteOffset and byteLength), the
+// slot names the only key it can be, and one 16 or 32 byte compare confirms it. Parsers switch on the key's index
+// in its set, so what used to be a chain of compares down to the matching key is now a jump table.
+//
+// The hash multiplier is searched for when the set is built. If there is no multiplier which separates the keys, or
+// a case label names a key which is not in the set, the build fails.
+//
+#define GLTF_KEY_UNKNOWN 0xffffffff
+#define GLTF_KEY_MAX_LEN 30
+
+// Not constexpr: reaching these during constant evaluation is what fails the build.
+static void gltf_key_set_no_multiplier() { assert(false && "No perfect hash for gltf key set"); }
+static void gltf_key_set_no_key()        { assert(false && "Key is not in gltf key set"); }
+
+constexpr u64 gltf_key_load(const char *key, u32 len) { // little endian, 'len' <= 8
+    u64 ret = 0;
+    for(u32 i = 0; i < len; ++i)
+        ret |= (u64)(u8)key[i] << (i * 8);
+    return ret;
+}
+constexpr u64 gltf_key_hash(u64 first, u64 last, u32 len, u64 multiplier, u32 bits) {
+    return ((first ^ ((last << 29) | (last >> 35)) ^ len) * multiplier) >> (64 - bits);
+}
+
+template<u32 N>
+struct Gltf_Key_Set {
+    static constexpr u32 BITS  = N <= 4 ? 4 : N <= 8 ? 5 : N <= 16 ? 6 : N <= 32 ? 7 : 8; // at least 4 slots per key
+    static constexpr u32 SLOTS = 1 << BITS;
+    static_assert(N < SLOTS / 2 && "Too many keys in gltf key set");
+
+    alignas(32) char keys[N][32]; // closing '"' kept, zero padded so that any key can be loaded as 32 bytes
+    u64 multiplier;
+    u8  lens[N];
+    u8  slots[SLOTS]; // key index + 1, 0 is empty
+
+    // Index of 'key', for case labels.
+    constexpr u32 id(const char *key) const {
+        for(u32 i = 0; i < N; ++i) {
+            u32 j = 0;
+            while(j < lens[i] && keys[i][j] == key[j])
+                j++;
+            if (j == lens[i] && key[j] == '\0')
+                return i;
+        }
+        gltf_key_set_no_key();
+        return GLTF_KEY_UNKNOWN;
+    }
+};
+
+template<u32 N>
+constexpr Gltf_Key_Set<N> gltf_make_key_set(const char *const (&keys)[N]) {
+    Gltf_Key_Set<N> set = {};
+    u64 first[N] = {};
+    u64 last[N]  = {};
+    for(u32 i = 0; i < N; ++i) {
+        u32 len = 0;
+        while(keys[i][len] != '\0')
+            len++;
+        if (len > GLTF_KEY_MAX_LEN)
+            gltf_key_set_no_key();
+        for(u32 j = 0; j < len; ++j)
+            set.keys[i][j] = keys[i][j];
+        set.keys[i][len] = '"';
+        set.lens[i]      = len;
+        first[i]    = gltf_key_load(keys[i], len < 8 ? len : 8);
+        last[i]     = len < 8 ? first[i] : gltf_key_load(keys[i] + len - 8, 8);
+    }
+
+    u64 seed = 0;
+    for(u32 attempt = 0; attempt < 1024; ++attempt) {
+        // splitmix64
+        seed += 0x9e3779b97f4a7c15;
+        u64 m = seed;
+        m = (m ^ (m >> 30)) * 0xbf58476d1ce4e5b9;
+        m = (m ^ (m >> 27)) * 0x94d049bb133111eb;
+        m = (m ^ (m >> 31)) | 1;
+
+        for(u32 i = 0; i < set.SLOTS; ++i)
+            set.slots[i] = 0;
+
+        u32 i;
+        for(i = 0; i < N; ++i) {
+            u64 slot = gltf_key_hash(first[i], last[i], set.lens[i], m, set.BITS);
+            if (set.slots[slot])
+                break;
+            set.slots[slot] = i + 1;
+        }
+        if (i == N) {
+            set.multiplier = m;
+            return set;
+        }
+    }
+    gltf_key_set_no_multiplier();
+    return set;
+}
+
+// Index in 'set' of the key at 'data' (which points passed the key's opening '"'), or GLTF_KEY_UNKNOWN.
+template<u32 N>
+inline static u32 gltf_match_key(const char *data, const Gltf_Key_Set<N> *set) {
+    // File data is padded, and there is at least a closing '"' and a '}' after a key, so the loads are in bounds.
+    __m128i a = _mm_loadu_si128((const __m128i*)data);
+    u32 quote = _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_set1_epi8('"')));
+    u32 len   = quote ? count_trailing_zeros_u16(quote) : simd_strlen(data, '"');
+    if (len > GLTF_KEY_MAX_LEN)
+        return GLTF_KEY_UNKNOWN;
+
+    u64 first = _mm_cvtsi128_si64(a);
+    u64 last;
+    if (len < 8) {
+        first &= ((u64)1 << (len * 8)) - 1;
+        last   = first;
+    } else {
+        memcpy(&last, data + len - 8, 8);
+    }
+
+    u32 i = set->slots[gltf_key_hash(first, last, len, set->multiplier, set->BITS)] - 1;
+    if (i == (u32)-1)
+        return GLTF_KEY_UNKNOWN;
+
+    // Set keys keep their closing '"', so comparing len + 1 bytes also rejects keys of a different length.
+    u32 mask;
+    if (len < 16) {
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_load_si128((const __m128i*)set->keys[i])));
+    } else {
+        __m256i b = _mm256_loadu_si256((const __m256i*)data);
+        mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_load_si256((const __m256i*)set->keys[i])));
+    }
+    u32 want = ((u32)2 << len) - 1;
+    return (mask & want) == want ? i : GLTF_KEY_UNKNOWN;
+}
+
+//
+// Skip passed the next 'open' char and everything up to and including its matching 'close'. Brackets inside strings
+// are ignored, but escaped quotes are not understood (same as the rest of the parser). Only chunks containing
+// brackets or quotes are looked at byte by byte, so this is much quicker than actually parsing the scope.
+//
+static void gltf_skip_scope(const char *data, u64 *offset, char open, char close) {
+    u64 inc = 0;
+    simd_skip_passed_char(data, &inc, open);
+
+    __m128i o = _mm_set1_epi8(open);
+    __m128i c = _mm_set1_epi8(close);
+    __m128i q = _mm_set1_epi8('"');
+    __m128i a;
+
+    int  depth     = 1;
+    bool in_string = false;
+    u16  mask;
+    u32  tz;
+    char ch;
+    while(true) {
+        a    = _mm_loadu_si128((__m128i*)(data + inc));
+        mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(a, o), _mm_cmpeq_epi8(a, c)),
+                                              _mm_cmpeq_epi8(a, q)));
+        while(mask) {
+            tz = count_trailing_zeros_u16(mask);
+            ch = data[inc + tz];
+            if (ch == '"') {
+                in_string = !in_string;
+            } else if (!in_string) {
+                depth += ch == open ? 1 : -1;
+                if (!depth) {
+                    *offset += inc + tz + 1;
+                    return;
+                }
+            }
+            mask &= mask - 1;
+        }
+        inc += 16;
+    }
+}
+
+// Offsets from the start of a section to each of its elements, with the element count at [-1].
+template<typename T>
+static int* gltf_get_offsets(const T *first, int count) {
+    int *offsets = (int*)gltf_alloc(sizeof(int) * (count + 1), 4);
+    offsets[0]   = count;
+    offsets++;
+
+    int total_stride = 0;
+    const T *element = first;
+    for(int i = 0; i < count; ++i) {
+        offsets[i]    = total_stride;
+        total_stride += element->stride;
+        element       = (const T*)((u8*)element + element->stride);
+    }
+    return offsets;
+}
+
+// Counts of sections which are not in the file point here.
+static int gltf_empty_section_offsets[1] = {0};
+
+// Section keys come first and in Gltf_Section order, so that a key's index is its section.
+static constexpr auto GLTF_TOP_LEVEL_KEYS = gltf_make_key_set({
+    "accessors", "animations", "buffers", "bufferViews", "cameras", "images", "materials", "meshes", "nodes",
+    "samplers", "scenes", "skins", "textures",
+    "extensionsUsed", "extensionsRequired", "extensions", "asset", "scene",
+});
+static_assert(GLTF_TOP_LEVEL_KEYS.id("textures") == GLTF_SECTION_TEXTURES);
+
+// Parse the elements of the array at 'data' (the section's key, or anywhere before the '[') and move 'offset' beyond
+// it. Returns the first element.
+static void* gltf_parse_section_elements(Gltf *gltf, Gltf_Section section, const char *data, u64 *offset,
+                                         int *count) {
+    switch(section) {
+    case GLTF_SECTION_ACCESSORS:    return gltf_parse_accessors   (data, offset, count);
+    case GLTF_SECTION_ANIMATIONS:   return gltf_parse_animations  (data, offset, count);
+    case GLTF_SECTION_BUFFERS:      return gltf_parse_buffers     (data, offset, count);
+    case GLTF_SECTION_BUFFER_VIEWS: return gltf_parse_buffer_views(data, offset, count);
+    case GLTF_SECTION_CAMERAS:      return gltf_parse_cameras     (data, offset, count);
+    case GLTF_SECTION_IMAGES:       return gltf_parse_images      (data, offset, count);
+    case GLTF_SECTION_MATERIALS:    return gltf_parse_materials   (data, offset, count);
+    case GLTF_SECTION_MESHES:       return gltf_parse_meshes      (data, offset, count, &gltf->total_primitive_count);
+    case GLTF_SECTION_NODES:        return gltf_parse_nodes       (data, offset, count);
+    case GLTF_SECTION_SAMPLERS:     return gltf_parse_samplers    (data, offset, count);
+    case GLTF_SECTION_SCENES:       return gltf_parse_scenes      (data, offset, count);
+    case GLTF_SECTION_SKINS:        return gltf_parse_skins       (data, offset, count);
+    case GLTF_SECTION_TEXTURES:     return gltf_parse_textures    (data, offset, count);
+    default:
+        assert(false && "Invalid gltf section");
+        return NULL;
+    }
+}
+
+// Point 'gltf' at a parsed section and make its offsets.
+static void gltf_set_section(Gltf *gltf, Gltf_Section section, void *first, int count) {
+    switch(section) {
+    case GLTF_SECTION_ACCESSORS:
+        gltf->accessors      = (Gltf_Accessor*)first;
+        gltf->accessor_count = gltf_get_offsets(gltf->accessors, count);
+        break;
+    case GLTF_SECTION_ANIMATIONS:
+        gltf->animations      = (Gltf_Animation*)first;
+        gltf->animation_count = gltf_get_offsets(gltf->animations, count);
+        break;
+    case GLTF_SECTION_BUFFERS:
+        gltf->buffers      = (Gltf_Buffer*)first;
+        gltf->buffer_count = gltf_get_offsets(gltf->buffers, count);
+        break;
+    case GLTF_SECTION_BUFFER_VIEWS:
+        gltf->buffer_views      = (Gltf_Buffer_View*)first;
+        gltf->buffer_view_count = gltf_get_offsets(gltf->buffer_views, count);
+        break;
+    case GLTF_SECTION_CAMERAS:
+        gltf->cameras      = (Gltf_Camera*)first;
+        gltf->camera_count = gltf_get_offsets(gltf->cameras, count);
+        break;
+    case GLTF_SECTION_IMAGES:
+        gltf->images      = (Gltf_Image*)first;
+        gltf->image_count = gltf_get_offsets(gltf->images, count);
+        break;
+    case GLTF_SECTION_MATERIALS:
+        gltf->materials      = (Gltf_Material*)first;
+        gltf->material_count = gltf_get_offsets(gltf->materials, count);
+        break;
+    case GLTF_SECTION_MESHES:
+        gltf->meshes     = (Gltf_Mesh*)first;
+        gltf->mesh_count = gltf_get_offsets(gltf->meshes, count);
+        break;
+    case GLTF_SECTION_NODES:
+        gltf->nodes      = (Gltf_Node*)first;
+        gltf->node_count = gltf_get_offsets(gltf->nodes, count);
+        break;
+    case GLTF_SECTION_SAMPLERS:
+        gltf->samplers      = (Gltf_Sampler*)first;
+        gltf->sampler_count = gltf_get_offsets(gltf->samplers, count);
+        break;
+    case GLTF_SECTION_SCENES:
+        gltf->scenes      = (Gltf_Scene*)first;
+        gltf->scene_count = gltf_get_offsets(gltf->scenes, count);
+        break;
+    case GLTF_SECTION_SKINS:
+        gltf->skins      = (Gltf_Skin*)first;
+        gltf->skin_count = gltf_get_offsets(gltf->skins, count);
+        break;
+    case GLTF_SECTION_TEXTURES:
+        gltf->textures      = (Gltf_Texture*)first;
+        gltf->texture_count = gltf_get_offsets(gltf->textures, count);
+        break;
+    default:
+        assert(false && "Invalid gltf section");
+        break;
+    }
+}
+
+// Parse the section whose key is at 'data', and move 'offset' beyond it.
+static void gltf_parse_section_at(Gltf *gltf, Gltf_Section section, const char *data, u64 *offset) {
+    int   count = 0;
+    void *first = gltf_parse_section_elements(gltf, section, data, offset, &count);
+    gltf_set_section(gltf, section, first, count);
+}
+
+//
+// @ERROR @Stride
+// @Note Idk what to do about stride here. I will wait and see if the validation
+// layers complain about stride being 0 later...
+//
+// Needs both accessors and buffer views.
+static void gltf_patch_accessor_strides(Gltf *gltf) {
+    Gltf_Accessor *accessor = gltf->accessors;
+    Gltf_Buffer_View *buffer_view;
+    for(int i = 0; i < gltf->accessor_count[-1]; ++i) {
+        if (accessor->buffer_view < 0) { // sparse only accessor, nothing to patch
+            accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
+            continue;
+        }
+        buffer_view =
+            (Gltf_Buffer_View*)((u8*)gltf->buffer_views +
+                gltf->buffer_view_count[accessor->buffer_view]);
+
+        if (gltf->buffer_view_count[-1] && buffer_view->byte_stride)
+            accessor->byte_stride = buffer_view->byte_stride;
+
+        accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
+    }
+}
+
+static void gltf_set_empty_sections(Gltf *gltf) {
+    gltf->accessor_count    = gltf_empty_section_offsets + 1;
+    gltf->animation_count   = gltf_empty_section_offsets + 1;
+    gltf->buffer_count      = gltf_empty_section_offsets + 1;
+    gltf->buffer_view_count = gltf_empty_section_offsets + 1;
+    gltf->camera_count      = gltf_empty_section_offsets + 1;
+    gltf->image_count       = gltf_empty_section_offsets + 1;
+    gltf->material_count    = gltf_empty_section_offsets + 1;
+    gltf->mesh_count        = gltf_empty_section_offsets + 1;
+    gltf->node_count        = gltf_empty_section_offsets + 1;
+    gltf->sampler_count     = gltf_empty_section_offsets + 1;
+    gltf->scene_count       = gltf_empty_section_offsets + 1;
+    gltf->skin_count        = gltf_empty_section_offsets + 1;
+    gltf->texture_count     = gltf_empty_section_offsets + 1;
+}
+
+static Gltf gltf_parse_top_level(const char *data, Linear_Allocator *arena, bool lazy) {
     //
     // Function Method:
     //     While there is a '"' before a closing brace in the file, jump to the '"' as '"' means a key;
@@ -120,258 +474,534 @@ Gltf parse_gltf(const char *filename) {
     //     Each parser function increments the file offset to point to the end of whatver it parsed,
     //     so if a closing brace is ever found before a key, there must be no keys left in the file.
     //
-    u64 size;
-    const char *data = (const char*)file_read_char_temp_padded(filename, &size, 16);
+    //     Lazy parsing only records where a section's key is, and skips over its array.
+    //
     Gltf gltf = {};
-    char buf[16];
     u64 offset = 0;
 
-    int accessor_count = 0;
-    int animation_count = 0;
-    int buffer_count = 0;
-    int buffer_view_count = 0;
-    int camera_count = 0;
-    int image_count = 0;
-    int material_count = 0;
-    int mesh_count = 0;
-    int node_count = 0;
-    int sampler_count = 0;
-    int scene_count = 0;
-    int skin_count = 0;
-    int texture_count = 0;
+    gltf.data  = data;
+    gltf.arena = arena;
+
+    Linear_Allocator *prev_arena = gltf_arena;
+    gltf_arena = arena;
 
+    gltf_set_empty_sections(&gltf);
+
+    u32 key;
     while (simd_find_char_interrupted(data + offset, '"', '}', &offset)) {
         offset++; // step into key
-        if (simd_strcmp_short(data + offset, "accessorsxxxxxxx", 7) == 0) {
-            gltf.accessors = gltf_parse_accessors(data + offset, &offset, &accessor_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "animationsxxxxxx", 6) == 0) {
-            gltf.animations = gltf_parse_animations(data + offset, &offset, &animation_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "buffersxxxxxxxxx", 9) == 0) {
-            gltf.buffers = gltf_parse_buffers(data + offset, &offset, &buffer_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "bufferViewsxxxxx", 5) == 0) {
-            gltf.buffer_views = gltf_parse_buffer_views(data + offset, &offset, &buffer_view_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "camerasxxxxxxxxx", 9) == 0) {
-            gltf.cameras = gltf_parse_cameras(data + offset, &offset, &camera_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "imagesxxxxxxxxxx", 10) == 0) {
-            gltf.images = gltf_parse_images(data + offset, &offset, &image_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "materialsxxxxxxx", 7) == 0) {
-            gltf.materials = gltf_parse_materials(data + offset, &offset, &material_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "meshesxxxxxxxxxx", 10) == 0) {
-            gltf.meshes = gltf_parse_meshes(data + offset, &offset, &mesh_count, &gltf.total_primitive_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "nodesxxxxxxxxxxx", 11) == 0) {
-            gltf.nodes = gltf_parse_nodes(data + offset, &offset, &node_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "samplersxxxxxxxx", 8) == 0) {
-            gltf.samplers = gltf_parse_samplers(data + offset, &offset, &sampler_count);
-            continue;
-        } else if (simd_strcmp_short(data + offset, "scenesxxxxxxxxxx", 10) == 0) {
-            gltf.scenes = gltf_parse_scenes(data + offset, &offset, &scene_count);
+        key = gltf_match_key(data + offset, &GLTF_TOP_LEVEL_KEYS);
+        if (key < GLTF_SECTION_COUNT) {
+            if (lazy) {
+                gltf.section_offsets[key]  = offset;
+                gltf.unparsed_sections    |= 1 << key;
+                gltf_skip_scope(data + offset, &offset, '[', ']');
+            } else {
+                gltf_parse_section_at(&gltf, (Gltf_Section)key, data + offset, &offset);
+            }
             continue;
-        } else if (simd_strcmp_short(data + offset, "skinsxxxxxxxxxxx", 11) == 0) {
-            gltf.skins = gltf_parse_skins(data + offset, &offset, &skin_count);
+        }
+        switch(key) {
+        case GLTF_TOP_LEVEL_KEYS.id("extensionsUsed"):
+        case GLTF_TOP_LEVEL_KEYS.id("extensionsRequired"):
+            simd_skip_passed_char(data + offset, &offset, ']');
             continue;
-        } else if (simd_strcmp_short(data + offset, "texturesxxxxxxxx", 8) == 0) {
-            gltf.textures = gltf_parse_textures(data + offset, &offset, &texture_count);
+        case GLTF_TOP_LEVEL_KEYS.id("extensions"):
+            gltf_skip_scope(data + offset, &offset, '{', '}');
             continue;
-        } else if (simd_strcmp_short(data + offset, "assetxxxxxxxxxxx", 11) == 0) {
+        case GLTF_TOP_LEVEL_KEYS.id("asset"):
             simd_skip_passed_char(data + offset, &offset, '}');
             continue;
-        } else if (simd_strcmp_short(data + offset, "scenexxxxxxxxxxx", 11) == 0) {
+        case GLTF_TOP_LEVEL_KEYS.id("scene"):
             gltf.scene = gltf_ascii_to_int(data + offset, &offset);
             continue;
-        } else {
+        default:
             assert(false && "This is not a top level gltf key");
+            break;
         }
     }
 
-    //
-    // OMFG!! I practically have to rewrite this thing!!! One day maybe I will idk...
-    // This is sort of hack, sort of not, depending how you look at it (COPIUS-MAXIMUS!?)
-    // My beautiful memory access patterns! Ruined! How did I not consider the fact that
-    // this whole file format is about random access!!??
-    //
-    int total_stride = 0;
+    if (!lazy)
+        gltf_patch_accessor_strides(&gltf);
 
-    gltf.accessor_count = (int*)malloc_t(sizeof(int) * accessor_count + 1, 4);
-    gltf.accessor_count[0] = accessor_count;
-    gltf.accessor_count++;
-    Gltf_Accessor *accessor = gltf.accessors;
-    for(int i = 0; i < accessor_count; ++i) {
-        gltf.accessor_count[i] = total_stride;
-        total_stride += accessor->stride;
-        accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
-    }
+    gltf_arena = prev_arena;
+    return gltf;
+}
 
-    total_stride = 0;
+Gltf parse_gltf(const char *filename) {
+    u64 size;
+    const char *data = (const char*)file_read_char_temp_padded(filename, &size, 16);
+    if (!data)
+        return {};
+    Gltf ret = gltf_parse_top_level(data, NULL, false);
+    ret.data_size = size;
+    return ret;
+}
 
-    gltf.animation_count = (int*)malloc_t(sizeof(int) * animation_count + 1, 4);
-    gltf.animation_count[0] = animation_count;
-    gltf.animation_count++;
-    Gltf_Animation *animation = gltf.animations;
-    for(int i = 0; i < animation_count; ++i) {
-        gltf.animation_count[i] = total_stride;
-        total_stride += animation->stride;
-        animation = (Gltf_Animation*)((u8*)animation + animation->stride);
-    }
+Gltf parse_gltf_lazy(const char *filename) {
+    u64 size;
+    const char *data = (const char*)file_read_char_temp_padded(filename, &size, 16);
+    if (!data)
+        return {};
+    Gltf ret = gltf_parse_top_level(data, NULL, true);
+    ret.data_size = size;
+    ret.temp_mark = get_mark_temp();
+    return ret;
+}
 
-    total_stride = 0;
+void gltf_parse_section(Gltf *gltf, Gltf_Section section) {
+    if (!(gltf->unparsed_sections & (1 << section)))
+        return;
+    assert((gltf->arena || get_mark_temp() >= gltf->temp_mark) &&
+           "Lazy gltf section touched after the temp allocator was reset below its text");
 
-    gltf.buffer_count = (int*)malloc_t(sizeof(int) * buffer_count + 1, 4);
-    gltf.buffer_count[0] = buffer_count;
-    gltf.buffer_count++;
-    Gltf_Buffer *buffer = gltf.buffers;
-    for(int i = 0; i < buffer_count; ++i) {
-        gltf.buffer_count[i] = total_stride;
-        total_stride += buffer->stride;
-        buffer = (Gltf_Buffer*)((u8*)buffer + buffer->stride);
-    }
+    // Accessor strides are patched from their buffer views, so those have to be parsed first.
+    if (section == GLTF_SECTION_ACCESSORS)
+        gltf_parse_section(gltf, GLTF_SECTION_BUFFER_VIEWS);
 
-    total_stride = 0;
+    gltf->unparsed_sections &= ~(1 << section);
 
-    gltf.buffer_view_count = (int*)malloc_t(sizeof(int) * buffer_view_count + 1, 4);
-    gltf.buffer_view_count[0] = buffer_view_count;
-    gltf.buffer_view_count++;
-    Gltf_Buffer_View *buffer_view = gltf.buffer_views;
-    for(int i = 0; i < buffer_view_count; ++i) {
-        gltf.buffer_view_count[i] = total_stride;
-        total_stride += buffer_view->stride;
-        buffer_view = (Gltf_Buffer_View*)((u8*)buffer_view + buffer_view->stride);
-    }
+    Linear_Allocator *prev_arena = gltf_arena;
+    gltf_arena = gltf->arena;
 
-    total_stride = 0;
+    u64 offset = gltf->section_offsets[section];
+    gltf_parse_section_at(gltf, section, gltf->data + offset, &offset);
 
-    gltf.camera_count = (int*)malloc_t(sizeof(int) * camera_count + 1, 4);
-    gltf.camera_count[0] = camera_count;
-    gltf.camera_count++;
-    Gltf_Camera *camera = gltf.cameras;
-    for(int i = 0; i < camera_count; ++i) {
-        gltf.camera_count[i] = total_stride;
-        total_stride += camera->stride;
-        camera = (Gltf_Camera*)((u8*)camera + camera->stride);
-    }
+    if (section == GLTF_SECTION_ACCESSORS)
+        gltf_patch_accessor_strides(gltf);
 
-    total_stride = 0;
+    gltf_arena = prev_arena;
+}
 
-    gltf.image_count = (int*)malloc_t(sizeof(int) * image_count + 1, 4);
-    gltf.image_count[0] = image_count;
-    gltf.image_count++;
-    Gltf_Image *image = gltf.images;
-    for(int i = 0; i < image_count; ++i) {
-        gltf.image_count[i] = total_stride;
-        total_stride += image->stride;
-        image = (Gltf_Image*)((u8*)image + image->stride);
+                                    /* Documents */
+
+//
+// Upper bound for everything the parser can allocate from 'data', from a count of the chars which can cause an
+// allocation: every object becomes at most one element (plus its alignment and offset array entry), every key at
+// most a mesh attribute, and every array value at most 4 bytes (plus alignment per array). Strings (uris) are
+// copied, so the text size is added on top. This overestimates a lot (about 2.5x the text size, several times what
+// is actually used) but it is one quick pass, and it can never be too small, which is what matters for an arena
+// which cannot grow. The slack is never written, so the pages which hold it are never touched.
+//
+static constexpr u64 GLTF_DOCUMENT_OBJECT_SIZE = 128 + 8 + 4;
+static constexpr u64 GLTF_DOCUMENT_KEY_SIZE    = sizeof(Gltf_Mesh_Attribute) + 4;
+static constexpr u64 GLTF_DOCUMENT_VALUE_SIZE  = 4 + 8;
+
+static_assert(sizeof(Gltf_Accessor) <= 128 && sizeof(Gltf_Node) <= 128 && sizeof(Gltf_Material) <= 128 &&
+              sizeof(Gltf_Buffer_View) <= 128 && sizeof(Gltf_Mesh_Primitive) <= 128,
+              "Update GLTF_DOCUMENT_OBJECT_SIZE");
+
+static u64 gltf_get_document_arena_size(const char *data, u64 size) {
+    __m256i obj = _mm256_set1_epi8('{');
+    __m256i key = _mm256_set1_epi8(':');
+    __m256i com = _mm256_set1_epi8(',');
+    __m256i arr = _mm256_set1_epi8('[');
+    __m256i a;
+
+    u64 objects = 0;
+    u64 keys    = 0;
+    u64 values  = 0;
+    u64 i;
+    for(i = 0; i + 32 <= size; i += 32) {
+        a = _mm256_loadu_si256((__m256i*)(data + i));
+        objects += pop_count32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, obj)));
+        keys    += pop_count32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, key)));
+        values  += pop_count32(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(a, com),
+                                                                    _mm256_cmpeq_epi8(a, arr))));
     }
+    for(; i < size; ++i) {
+        objects += data[i] == '{';
+        keys    += data[i] == ':';
+        values  += data[i] == ',' || data[i] == '[';
+    }
+
+    return size + objects * GLTF_DOCUMENT_OBJECT_SIZE + keys * GLTF_DOCUMENT_KEY_SIZE +
+           values * GLTF_DOCUMENT_VALUE_SIZE + GLTF_SECTION_COUNT * 16;
+}
 
-    total_stride = 0;
+//
+// Documents use the C allocator rather than the instance heap or temp allocator, which belong to the main thread, so
+// that they can be created, parsed and freed on any thread.
+//
+static void* gltf_document_alloc(u64 size) {
+    void *ret = malloc(size);
+    assert(((u64)ret & 15) == 0 && "Gltf documents need malloc to align to 16");
+    return ret;
+}
 
-    gltf.material_count = (int*)malloc_t(sizeof(int) * material_count + 1, 4);
-    gltf.material_count[0] = material_count;
-    gltf.material_count++;
-    Gltf_Material *material = gltf.materials;
-    for(int i = 0; i < material_count; ++i) {
-        gltf.material_count[i] = total_stride;
-        total_stride += material->stride;
-        material = (Gltf_Material*)((u8*)material + material->stride);
+Gltf_Document* gltf_document_create(const char *file_name, bool lazy) {
+    FILE *file = fopen(file_name, "rb");
+    if (!file)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    s64 file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    u64   size = file_size < 0 ? 0 : (u64)file_size;
+    char *text = (char*)(file_size < 0 ? NULL : gltf_document_alloc(size + 16)); // padded for the simd helpers
+    bool  read = text && fread(text, 1, size, file) == size;
+    fclose(file);
+    if (!read) {
+        free(text);
+        return NULL;
     }
+    memset(text + size, 0, 16);
+
+    Gltf_Document *document = (Gltf_Document*)gltf_document_alloc(sizeof(Gltf_Document));
+    u64 arena_size = gltf_get_document_arena_size(text, size);
+    u8 *arena      = document ? (u8*)gltf_document_alloc(arena_size) : NULL;
+    if (!arena) {
+        free(document);
+        free(text);
+        return NULL;
+    }
+    *document = {};
 
-    total_stride = 0;
+    document->text            = text;
+    document->text_size       = size;
+    document->arena.capacity  = arena_size;
+    document->arena.memory    = arena;
+    document->arena.used      = 0;
 
-    gltf.mesh_count = (int*)malloc_t(sizeof(int) * mesh_count + 1, 4);
-    gltf.mesh_count[0] = mesh_count;
-    gltf.mesh_count++;
-    Gltf_Mesh *mesh = gltf.meshes;
-    for(int i = 0; i < mesh_count; ++i) {
-        gltf.mesh_count[i] = total_stride;
-        total_stride += mesh->stride;
-        mesh = (Gltf_Mesh*)((u8*)mesh + mesh->stride);
-    }
+    document->gltf = gltf_parse_top_level(text, &document->arena, lazy);
+    document->gltf.data_size = size;
 
-    total_stride = 0;
+    return document;
+}
 
-    gltf.node_count = (int*)malloc_t(sizeof(int) * node_count + 1, 4);
-    gltf.node_count[0] = node_count;
-    gltf.node_count++;
-    Gltf_Node *node = gltf.nodes;
-    for(int i = 0; i < node_count; ++i) {
-        gltf.node_count[i] = total_stride;
-        total_stride += node->stride;
-        node = (Gltf_Node*)((u8*)node + node->stride);
-    }
+void gltf_document_free(Gltf_Document *document) {
+    free((void*)document->text);
+    free(document->arena.memory);
+    free(document);
+}
 
-    total_stride = 0;
+                                    /* Streaming */
 
-    gltf.sampler_count = (int*)malloc_t(sizeof(int) * sampler_count + 1, 4);
-    gltf.sampler_count[0] = sampler_count;
-    gltf.sampler_count++;
-    Gltf_Sampler *sampler = gltf.samplers;
-    for(int i = 0; i < sampler_count; ++i) {
-        gltf.sampler_count[i] = total_stride;
-        total_stride += sampler->stride;
-        sampler = (Gltf_Sampler*)((u8*)sampler + sampler->stride);
-    }
+struct Gltf_Stream {
+    FILE *file;
+    char *window;   // window[0] is kept free for the '[' which is written in front of a batch
+    u64   capacity; // chunk size
+    u64   pos;      // first unconsumed byte
+    u64   end;      // end of the bytes read
+    bool  eof;
+};
+
+// Move the unconsumed bytes to the front of the window and fill the rest from the file. False if nothing was read.
+static bool gltf_stream_refill(Gltf_Stream *stream) {
+    u64 remaining = stream->end - stream->pos;
+    memmove(stream->window + 1, stream->window + stream->pos, remaining);
+    stream->pos = 1;
+    stream->end = 1 + remaining;
+
+    u64 space = stream->capacity - remaining;
+    if (stream->eof || !space)
+        return false;
 
-    total_stride = 0;
+    u64 read = fread(stream->window + stream->end, 1, space, stream->file);
+    stream->end += read;
+    stream->eof  = read < space;
+
+    // Carry the padding along with the data, so the simd helpers can read over the end of the window.
+    memset(stream->window + stream->end, 0, 32);
+    return read;
+}
 
-    gltf.scene_count = (int*)malloc_t(sizeof(int) * scene_count + 1, 4);
-    gltf.scene_count[0] = scene_count;
-    gltf.scene_count++;
-    Gltf_Scene *scene = gltf.scenes;
-    for(int i = 0; i < scene_count; ++i) {
-        gltf.scene_count[i] = total_stride;
-        total_stride += scene->stride;
-        scene = (Gltf_Scene*)((u8*)scene + scene->stride);
+// Skip whitespace and commas. False if the file ends first.
+static bool gltf_stream_skip_separators(Gltf_Stream *stream) {
+    char c;
+    while(true) {
+        while(stream->pos < stream->end) {
+            c = stream->window[stream->pos];
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t' && c != ',')
+                return true;
+            stream->pos++;
+        }
+        if (!gltf_stream_refill(stream))
+            return false;
     }
+}
 
-    total_stride = 0;
+// Length of the scope opened at data[0], up to and including its close. 0 if it does not close within 'size'.
+static u64 gltf_get_scope_length(const char *data, u64 size, char open, char close) {
+    __m128i o = _mm_set1_epi8(open);
+    __m128i c = _mm_set1_epi8(close);
+    __m128i q = _mm_set1_epi8('"');
+    __m128i a;
+
+    int  depth     = 0;
+    bool in_string = false;
+    u32  mask;
+    u32  tz;
+    char ch;
+    for(u64 inc = 0; inc < size; inc += 16) {
+        a    = _mm_loadu_si128((__m128i*)(data + inc));
+        mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(a, o), _mm_cmpeq_epi8(a, c)),
+                                              _mm_cmpeq_epi8(a, q)));
+        if (size - inc < 16)
+            mask &= (1 << (size - inc)) - 1;
+        while(mask) {
+            tz = count_trailing_zeros_u32(mask);
+            ch = data[inc + tz];
+            if (ch == '"') {
+                in_string = !in_string;
+            } else if (!in_string) {
+                depth += ch == open ? 1 : -1;
+                if (!depth)
+                    return inc + tz + 1;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return 0;
+}
 
-    gltf.skin_count = (int*)malloc_t(sizeof(int) * skin_count + 1, 4);
-    gltf.skin_count[0] = skin_count;
-    gltf.skin_count++;
-    Gltf_Skin *skin = gltf.skins;
-    for(int i = 0; i < skin_count; ++i) {
-        gltf.skin_count[i] = total_stride;
-        total_stride += skin->stride;
-        skin = (Gltf_Skin*)((u8*)skin + skin->stride);
+// Length of the value at the stream's position: an object, an array or a number/literal. Refills until the value
+// is complete in the window.
+static Gltf_Stream_Result gltf_stream_get_value_length(Gltf_Stream *stream, u64 *length) {
+    const char *data;
+    u64 size;
+    u64 len;
+    while(true) {
+        data = stream->window + stream->pos;
+        size = stream->end - stream->pos;
+        len  = 0;
+        if (data[0] == '{' || data[0] == '[') {
+            len = gltf_get_scope_length(data, size, data[0], data[0] == '{' ? '}' : ']');
+        } else {
+            for(u64 i = 0; i < size; ++i) {
+                if (data[i] == ',' || data[i] == '}' || data[i] == ']' || data[i] == '\n') {
+                    len = i;
+                    break;
+                }
+            }
+        }
+        if (len) {
+            *length = len;
+            return GLTF_STREAM_RESULT_SUCCESS;
+        }
+        if (size >= stream->capacity)
+            return GLTF_STREAM_RESULT_ELEMENT_TOO_LARGE;
+        if (!gltf_stream_refill(stream))
+            return GLTF_STREAM_RESULT_MALFORMED;
     }
+}
+
+static const u32 gltf_section_stride_offsets[GLTF_SECTION_COUNT] = {
+    offsetof(Gltf_Accessor,    stride),
+    offsetof(Gltf_Animation,   stride),
+    offsetof(Gltf_Buffer,      stride),
+    offsetof(Gltf_Buffer_View, stride),
+    offsetof(Gltf_Camera,      stride),
+    offsetof(Gltf_Image,       stride),
+    offsetof(Gltf_Material,    stride),
+    offsetof(Gltf_Mesh,        stride),
+    offsetof(Gltf_Node,        stride),
+    offsetof(Gltf_Sampler,     stride),
+    offsetof(Gltf_Scene,       stride),
+    offsetof(Gltf_Skin,        stride),
+    offsetof(Gltf_Texture,     stride),
+};
+
+struct Gltf_Stream_Section {
+    Gltf_Section section;
+    void *first; // first kept element
+    int   count;
+    u64   batch; // window position of the first unparsed element
+};
+
+// Parse the complete elements in [section->batch, batch_end), and hand them to the callback.
+static Gltf_Stream_Result gltf_stream_parse_batch(Gltf_Stream *stream, Gltf_Stream_Section *section, u64 batch_end,
+                                                  const Gltf_Stream_Info *info, Gltf *gltf) {
+    if (batch_end == section->batch)
+        return GLTF_STREAM_RESULT_SUCCESS;
 
-    total_stride = 0;
+    // Make the batch look like a whole array to the section parser.
+    char *window = stream->window;
+    char  front  = window[section->batch - 1];
+    char  back   = window[batch_end];
+    window[section->batch - 1] = '[';
+    window[batch_end]          = ']';
 
-    gltf.texture_count = (int*)malloc_t(sizeof(int) * texture_count + 1, 4);
-    gltf.texture_count[0] = texture_count;
-    gltf.texture_count++;
-    Gltf_Texture *texture = gltf.textures;
-    for(int i = 0; i < texture_count; ++i) {
-        gltf.texture_count[i] = total_stride;
-        total_stride += texture->stride;
-        texture = (Gltf_Texture*)((u8*)texture + texture->stride);
+    u64 mark   = gltf_get_mark();
+    u64 offset = 0;
+    int count  = 0;
+    u8 *element = (u8*)gltf_parse_section_elements(gltf, section->section, window + section->batch - 1, &offset,
+                                                   &count);
+    window[section->batch - 1] = front;
+    window[batch_end]          = back;
+    section->batch             = batch_end;
+
+    if (!section->first)
+        section->first = element;
+
+    Gltf_Stream_Result result = GLTF_STREAM_RESULT_SUCCESS;
+    for(int i = 0; i < count; ++i) {
+        if (info->callback && !info->callback(info->user_data, section->section, section->count + i, element))
+            result = GLTF_STREAM_RESULT_CANCELLED;
+
+        if (section->section == GLTF_SECTION_BUFFERS)
+            ((Gltf_Buffer*)element)->base64 = NULL;
+        else if (section->section == GLTF_SECTION_IMAGES)
+            ((Gltf_Image*)element)->base64 = NULL;
+
+        element += *(int*)(element + gltf_section_stride_offsets[section->section]);
+        if (result != GLTF_STREAM_RESULT_SUCCESS)
+            break;
     }
+    section->count += count;
+
+    if (!info->output)
+        reset_to_mark_temp(mark);
+    return result;
+}
+
+// Parse the array at the stream's position, a batch of elements at a time.
+static Gltf_Stream_Result gltf_stream_parse_section(Gltf_Stream *stream, Gltf_Section section,
+                                                    const Gltf_Stream_Info *info, Gltf *gltf) {
+    if (stream->window[stream->pos] != '[')
+        return GLTF_STREAM_RESULT_MALFORMED;
+    stream->pos++;
+
+    Gltf_Stream_Section stream_section = {};
+    stream_section.section = section;
+    stream_section.batch   = stream->pos;
 
     //
-    // @ERROR @Stride
-    // @Note Idk what to do about stride here. I will wait and see if the validation
-    // layers complain about stride being 0 later...
+    // Complete elements pile up in [batch, pos) until the window runs out, then they are parsed as one batch, and
+    // the refill moves the incomplete element to the front of the window.
     //
-    accessor = gltf.accessors;
-    for(int i = 0; i < gltf.accessor_count[-1]; ++i) {
-        buffer_view =
-            (Gltf_Buffer_View*)((u8*)gltf.buffer_views +
-                gltf.buffer_view_count[accessor->buffer_view]);
+    Gltf_Stream_Result result;
+    u64  len;
+    char c;
+    while(true) {
+        while(stream->pos < stream->end) {
+            c = stream->window[stream->pos];
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t' && c != ',')
+                break;
+            stream->pos++;
+        }
 
-        if (gltf.buffer_view_count[-1] && buffer_view->byte_stride)
-            accessor->byte_stride = buffer_view->byte_stride;
+        len = 0;
+        if (stream->pos < stream->end) {
+            if (c == ']')
+                break;
+            if (c != '{')
+                return GLTF_STREAM_RESULT_MALFORMED;
+            len = gltf_get_scope_length(stream->window + stream->pos, stream->end - stream->pos, '{', '}');
+        }
+        if (len) {
+            stream->pos += len;
+            continue;
+        }
 
-        accessor = (Gltf_Accessor*)((u8*)accessor + accessor->stride);
+        result = gltf_stream_parse_batch(stream, &stream_section, stream->pos, info, gltf);
+        if (result != GLTF_STREAM_RESULT_SUCCESS)
+            return result;
+        if (stream->end - stream->pos >= stream->capacity)
+            return GLTF_STREAM_RESULT_ELEMENT_TOO_LARGE;
+        if (!gltf_stream_refill(stream))
+            return GLTF_STREAM_RESULT_MALFORMED;
+        stream_section.batch = stream->pos;
     }
 
-    return gltf;
+    result = gltf_stream_parse_batch(stream, &stream_section, stream->pos, info, gltf);
+    if (result != GLTF_STREAM_RESULT_SUCCESS)
+        return result;
+    stream->pos++; // go beyond ']'
+
+    if (info->output)
+        gltf_set_section(gltf, section, stream_section.first, stream_section.count);
+    return GLTF_STREAM_RESULT_SUCCESS;
+}
+
+static Gltf_Stream_Result gltf_stream_parse_top_level(Gltf_Stream *stream, const Gltf_Stream_Info *info,
+                                                      Gltf *gltf) {
+    if (!gltf_stream_skip_separators(stream) || stream->window[stream->pos] != '{')
+        return GLTF_STREAM_RESULT_MALFORMED;
+    stream->pos++;
+
+    Gltf_Stream_Result result;
+    const char *key;
+    const char *quote;
+    u32 match;
+    u64 len;
+    while(true) {
+        if (!gltf_stream_skip_separators(stream))
+            return GLTF_STREAM_RESULT_MALFORMED;
+        if (stream->window[stream->pos] == '}')
+            return GLTF_STREAM_RESULT_SUCCESS;
+        if (stream->window[stream->pos] != '"')
+            return GLTF_STREAM_RESULT_MALFORMED;
+
+        // Have the key, its ':' and the start of its value in the window.
+        if (stream->end - stream->pos < 64)
+            gltf_stream_refill(stream);
+        key   = stream->window + stream->pos + 1;
+        quote = (const char*)memchr(key, '"', stream->end - stream->pos - 1);
+        if (!quote)
+            return GLTF_STREAM_RESULT_MALFORMED;
+        match = gltf_match_key(key, &GLTF_TOP_LEVEL_KEYS);
+
+        stream->pos = quote + 1 - stream->window;
+        if (!gltf_stream_skip_separators(stream) || stream->window[stream->pos] != ':')
+            return GLTF_STREAM_RESULT_MALFORMED;
+        stream->pos++;
+        if (!gltf_stream_skip_separators(stream))
+            return GLTF_STREAM_RESULT_MALFORMED;
+
+        if (match < GLTF_SECTION_COUNT) {
+            result = gltf_stream_parse_section(stream, (Gltf_Section)match, info, gltf);
+            if (result != GLTF_STREAM_RESULT_SUCCESS)
+                return result;
+            continue;
+        }
+
+        result = gltf_stream_get_value_length(stream, &len);
+        if (result != GLTF_STREAM_RESULT_SUCCESS)
+            return result;
+        if (match == GLTF_TOP_LEVEL_KEYS.id("scene")) {
+            u64 offset = 0;
+            gltf->scene = gltf_ascii_to_int(stream->window + stream->pos, &offset);
+        }
+        stream->pos += len;
+    }
+}
+
+Gltf_Stream_Result parse_gltf_stream(const char *file_name, const Gltf_Stream_Info *info, Gltf *gltf) {
+    assert((info->output || info->callback) && "Gltf stream has nowhere to put elements");
+    assert((!info->output || gltf) && "Gltf stream with output needs a Gltf to fill");
+
+    Gltf_Stream stream = {};
+    stream.file = fopen(file_name, "rb");
+    if (!stream.file) {
+        println("FAILED TO READ FILE %s", file_name);
+        return GLTF_STREAM_RESULT_FILE_ERROR;
+    }
+    stream.capacity = info->chunk_size;
+    stream.window   = (char*)malloc_h(1 + stream.capacity + 32, 16);
+    stream.pos      = 1;
+    stream.end      = 1;
+
+    Gltf result_gltf = {};
+    result_gltf.arena = info->output;
+    gltf_set_empty_sections(&result_gltf);
+
+    Linear_Allocator *prev_arena = gltf_arena;
+    gltf_arena = info->output;
+
+    Gltf_Stream_Result result = gltf_stream_parse_top_level(&stream, info, &result_gltf);
+
+    if (result == GLTF_STREAM_RESULT_SUCCESS && info->output)
+        gltf_patch_accessor_strides(&result_gltf);
+    gltf_arena = prev_arena;
+
+    free_h(stream.window);
+    fclose(stream.file);
+
+    if (gltf)
+        *gltf = result_gltf;
+    return result;
 }
 
 // helper algorithms start
@@ -488,6 +1118,10 @@ inline Mat4 gltf_ascii_to_mat4(const char *data, u64 *offset) {
 
 // `Accessors
 // @Todo check that all defaults are being properly set
+static constexpr auto GLTF_ACCESSOR_KEYS = gltf_make_key_set({
+    "bufferView", "byteOffset", "count", "componentType", "type", "normalized", "sparse", "max", "min",
+});
+
 Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor_count) {
     u64 inc = 0; // track position in file
     simd_skip_passed_char(data, &inc, '[', Max_u64);
@@ -504,7 +1138,7 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
     Gltf_Accessor_Type accessor_component_type = GLTF_ACCESSOR_TYPE_NONE;
 
     // aligned pointer to return
-    Gltf_Accessor *ret = (Gltf_Accessor*)malloc_t(0, 8);
+    Gltf_Accessor *ret = (Gltf_Accessor*)gltf_alloc(0, 8);
     // pointer for allocating to in loops
     Gltf_Accessor *accessor;
 
@@ -518,7 +1152,7 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
         count++; // increment accessor count
 
         // Temp allocation made for every accessor struct. Keeps shit packed, linear allocators are fast...
-        accessor = (Gltf_Accessor*)malloc_t(sizeof(Gltf_Accessor), 8);
+        accessor = (Gltf_Accessor*)gltf_alloc(sizeof(Gltf_Accessor), 8);
         *accessor = {};
         accessor->indices_component_type = GLTF_ACCESSOR_TYPE_NONE;
         accessor->format = GLTF_ACCESSOR_FORMAT_UNKNOWN;
@@ -531,29 +1165,22 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
             inc++; // go beyond the '"' found by find_char_inter...
             //simd_skip_passed_char(data + inc, &inc, '"', Max_u64); // skip to beginning of key
 
-            //
-            // I do not like all these branch misses, but I cant see a better way. Even if I make a system
-            // to remove options if they have already been chosen, there would still be at least one branch
-            // with no improvement in predictability... (I think)
-            //
-            // ...I think this is just how parsing text goes...
-            //
-
             // match keys to parse methods
-            if (simd_strcmp_short(data + inc, "bufferViewxxxxxx",  6) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_ACCESSOR_KEYS)) {
+            case GLTF_ACCESSOR_KEYS.id("bufferView"):
                 accessor->buffer_view = gltf_ascii_to_int(data + inc, &inc);
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "byteOffsetxxxxxx",  6) == 0) {
+            case GLTF_ACCESSOR_KEYS.id("byteOffset"):
                 accessor->byte_offset = gltf_ascii_to_u64(data + inc, &inc);
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "countxxxxxxxxxxx", 11) == 0) {
+            case GLTF_ACCESSOR_KEYS.id("count"):
                 accessor->count = gltf_ascii_to_int(data + inc, &inc);
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "componentTypexxx",  3) == 0) {
+            case GLTF_ACCESSOR_KEYS.id("componentType"):
                 accessor_component_type = (Gltf_Accessor_Type)gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "typexxxxxxxxxxxx", 12) == 0) {
-
+            case GLTF_ACCESSOR_KEYS.id("type"):
+            {
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc); // jump into value string
 
                 if (simd_strcmp_short(data + inc, "SCALARxxxxxxxxxx", 10) == 0)
@@ -573,7 +1200,9 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
 
                 simd_skip_passed_char(data + inc, &inc, '"'); // skip passed the value string
                 continue;
-            } else if (simd_strcmp_short(data + inc, "normalizedxxxxxx", 6) == 0) {
+            }
+            case GLTF_ACCESSOR_KEYS.id("normalized"):
+            {
                 simd_skip_passed_char(data + inc, &inc, ':', Max_u64);
                 simd_skip_whitespace(data + inc, &inc); // go the beginning of 'true' || 'false' ascii string
                 if (simd_strcmp_short(data + inc, "truexxxxxxxxxxxx", 12) == 0) {
@@ -586,24 +1215,26 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
                 }
 
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "sparsexxxxxxxxxx", 10) == 0) {
+            }
+            case GLTF_ACCESSOR_KEYS.id("sparse"):
                 gltf_parse_accessor_sparse(data + inc, &inc, accessor);
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "maxxxxxxxxxxxxxx", 13) == 0) {
+            case GLTF_ACCESSOR_KEYS.id("max"):
                 min_max_len = gltf_parse_float_array(data + inc, &inc, max);
                 max_found = true;
                 continue; // go to next key
-            } else if (simd_strcmp_short(data + inc, "minxxxxxxxxxxxxx", 13) == 0) {
+            case GLTF_ACCESSOR_KEYS.id("min"):
                 min_max_len = gltf_parse_float_array(data + inc, &inc, min);
                 min_found = true;
                 continue; // go to next key
+            default:
+                break;
             }
-
         }
         if (min_found && max_found) {
             // @MemAlign careful here
             temp = align(sizeof(float) * min_max_len * 2, 8);
-            accessor->max = (float*)malloc_t(temp, 8);
+            accessor->max = (float*)gltf_alloc(temp, 8);
             accessor->min = accessor->max + min_max_len;
 
             memcpy(accessor->max, max, sizeof(float) * min_max_len);
@@ -955,15 +1586,19 @@ Gltf_Accessor* gltf_parse_accessors(const char *data, u64 *offset, int *accessor
     *offset += inc;
     return ret;
 }
+static constexpr auto GLTF_ACCESSOR_SPARSE_KEYS = gltf_make_key_set({
+    "count", "indices", "values",
+});
 void gltf_parse_accessor_sparse(const char *data, u64 *offset, Gltf_Accessor *accessor) {
     u64 inc = 0;
     simd_find_char_interrupted(data + inc, '{', '}', &inc); // find sparse start
     while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
         inc++; // go beyond the '"'
-        if (simd_strcmp_short(data + inc, "countxxxxxxxxxxx", 11) == 0)  {
+        switch(gltf_match_key(data + inc, &GLTF_ACCESSOR_SPARSE_KEYS)) {
+        case GLTF_ACCESSOR_SPARSE_KEYS.id("count"):
             accessor->sparse_count = gltf_ascii_to_int(data + inc, &inc);
             continue;
-        } else if (simd_strcmp_short(data + inc, "indicesxxxxxxxxx", 9) == 0) {
+        case GLTF_ACCESSOR_SPARSE_KEYS.id("indices"):
             simd_find_char_interrupted(data + inc, '{', '}', &inc); // find indices start
             while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
                 inc++; // go passed the '"'
@@ -983,7 +1618,7 @@ void gltf_parse_accessor_sparse(const char *data, u64 *offset, Gltf_Accessor *ac
             simd_find_char_interrupted(data + inc, '}', '{', &inc); // find indices end
             inc++; // go beyond
             continue;
-        } else if (simd_strcmp_short(data + inc, "valuesxxxxxxxxx", 10) == 0) {
+        case GLTF_ACCESSOR_SPARSE_KEYS.id("values"):
             simd_find_char_interrupted(data + inc, '{', '}', &inc); // find values start
             while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
                 inc++; // go passed the '"'
@@ -999,6 +1634,8 @@ void gltf_parse_accessor_sparse(const char *data, u64 *offset, Gltf_Accessor *ac
             simd_find_char_interrupted(data + inc, '}', '{', &inc); // find indices end
             inc++; // go beyond
             continue;
+        default:
+            break;
         }
     }
     *offset += inc + 1; // +1 go beyond the last curly brace in sparse object
@@ -1007,7 +1644,7 @@ void gltf_parse_accessor_sparse(const char *data, u64 *offset, Gltf_Accessor *ac
 // `Animations
 Gltf_Animation_Channel* gltf_parse_animation_channels(const char *data, u64 *offset, int *channel_count) {
     // Aligned pointer to return
-    Gltf_Animation_Channel *channels = (Gltf_Animation_Channel*)malloc_t(0, 8);
+    Gltf_Animation_Channel *channels = (Gltf_Animation_Channel*)gltf_alloc(0, 8);
     // pointer for allocating to in loops
     Gltf_Animation_Channel *channel;
 
@@ -1021,7 +1658,7 @@ Gltf_Animation_Channel* gltf_parse_animation_channels(const char *data, u64 *off
     int count = 0; // track object count
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
-        channel = (Gltf_Animation_Channel*)malloc_t(sizeof(Gltf_Animation_Channel), 8);
+        channel = (Gltf_Animation_Channel*)gltf_alloc(sizeof(Gltf_Animation_Channel), 8);
         *channel = {};
         count++;
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) { // channel loop
@@ -1067,32 +1704,36 @@ Gltf_Animation_Channel* gltf_parse_animation_channels(const char *data, u64 *off
     *offset += inc + 1; // go beyond array closing char
     return channels;
 }
+static constexpr auto GLTF_ANIMATION_SAMPLER_KEYS = gltf_make_key_set({
+    "input", "output", "interpolation",
+});
 Gltf_Animation_Sampler* gltf_parse_animation_samplers(const char *data, u64 *offset, int *sampler_count) {
     //
     // Function Method:
     //     outer loop to jump through the list of objects
     //     inner loop to jump through the keys in an object
     //
-    Gltf_Animation_Sampler *samplers = (Gltf_Animation_Sampler*)malloc_t(0, 8); // get pointer to beginning of sampler allocations
+    Gltf_Animation_Sampler *samplers = (Gltf_Animation_Sampler*)gltf_alloc(0, 8); // get pointer to beginning of sampler allocations
     Gltf_Animation_Sampler *sampler; // temp pointer to allocate to in loops
 
     u64 inc = 0;   // track file pos
     int count = 0; // track sampler count
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
-        sampler = (Gltf_Animation_Sampler*)malloc_t(sizeof(Gltf_Animation_Sampler), 8);
+        sampler = (Gltf_Animation_Sampler*)gltf_alloc(sizeof(Gltf_Animation_Sampler), 8);
         *sampler = {};
         count++;
         sampler->interp = GLTF_ANIMATION_INTERP_LINEAR;
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // go beyond opening '"' of key
-            if (simd_strcmp_short(data + inc, "inputxxxxxxxxxxx", 11) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_ANIMATION_SAMPLER_KEYS)) {
+            case GLTF_ANIMATION_SAMPLER_KEYS.id("input"):
                 sampler->input = gltf_ascii_to_int(data + inc, &inc);
-                continue; // Idk if continue and else if is destroying some branch predict algorithm, I hope not...
-            } else if (simd_strcmp_short(data + inc, "outputxxxxxxxxxx", 10) == 0) {
+                continue;
+            case GLTF_ANIMATION_SAMPLER_KEYS.id("output"):
                 sampler->output = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "interpolationxxx", 3) == 0) {
+            case GLTF_ANIMATION_SAMPLER_KEYS.id("interpolation"):
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc); // jump into value string
                 if (simd_strcmp_short(data + inc, "LINEARxxxxxxxxxx", 10) == 0) {
                     sampler->interp = GLTF_ANIMATION_INTERP_LINEAR;
@@ -1111,6 +1752,8 @@ Gltf_Animation_Sampler* gltf_parse_animation_samplers(const char *data, u64 *off
                 }
                 simd_skip_passed_char(data + inc, &inc, '"');
                 continue;
+            default:
+                break;
             }
         }
     }
@@ -1119,6 +1762,9 @@ Gltf_Animation_Sampler* gltf_parse_animation_samplers(const char *data, u64 *off
     *offset += inc + 1; // go beyond array closing char
     return samplers;
 }
+static constexpr auto GLTF_ANIMATION_KEYS = gltf_make_key_set({
+    "name", "channels", "samplers",
+});
 Gltf_Animation* gltf_parse_animations(const char *data, u64 *offset, int *animation_count) {
     //
     // Function Method:
@@ -1126,7 +1772,7 @@ Gltf_Animation* gltf_parse_animations(const char *data, u64 *offset, int *animat
     //     inner loop jumps through the keys in each object
     //
 
-    Gltf_Animation *animations = (Gltf_Animation*)malloc_t(0, 8); // get aligned pointer to return
+    Gltf_Animation *animations = (Gltf_Animation*)gltf_alloc(0, 8); // get aligned pointer to return
     Gltf_Animation *animation; // pointer for allocating to in loops
 
     u64 inc = 0;   // track pos in file
@@ -1134,20 +1780,23 @@ Gltf_Animation* gltf_parse_animations(const char *data, u64 *offset, int *animat
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) { // jump to object start
         ++count;
-        animation = (Gltf_Animation*)malloc_t(sizeof(Gltf_Animation), 8);
+        animation = (Gltf_Animation*)gltf_alloc(sizeof(Gltf_Animation), 8);
         *animation = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // enter the key
-            if (simd_strcmp_short(data + inc, "namexxxxxxxxxxxx", 12) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_ANIMATION_KEYS)) {
+            case GLTF_ANIMATION_KEYS.id("name"):
                 // skip "name" key. Have to jump 3 quotation marks: key end, value both
                 simd_skip_passed_char_count(data + inc, '"', 3, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "channelsxxxxxxxx", 8) == 0) {
+            case GLTF_ANIMATION_KEYS.id("channels"):
                 animation->channels = gltf_parse_animation_channels(data + inc, &inc, &animation->channel_count);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "samplersxxxxxxxx", 8) == 0) {
+            case GLTF_ANIMATION_KEYS.id("samplers"):
                 animation->samplers = gltf_parse_animation_samplers(data + inc, &inc, &animation->sampler_count);
                 continue;
+            default:
+                break;
             }
         }
         animation->stride =  sizeof(Gltf_Animation) +
@@ -1162,8 +1811,11 @@ Gltf_Animation* gltf_parse_animations(const char *data, u64 *offset, int *animat
 }
 
 // `Buffers
+static constexpr auto GLTF_BUFFER_KEYS = gltf_make_key_set({
+    "byteLength", "uri", "extensions",
+});
 Gltf_Buffer* gltf_parse_buffers(const char *data, u64 *offset, int *buffer_count) {
-    Gltf_Buffer *buffers = (Gltf_Buffer*)malloc_t(0, 8); // pointer to start of array to return
+    Gltf_Buffer *buffers = (Gltf_Buffer*)gltf_alloc(0, 8); // pointer to start of array to return
     Gltf_Buffer *buffer; // temp pointer to allocate to while parsing
 
     u64 inc = 0; // track file pos locally
@@ -1172,21 +1824,36 @@ Gltf_Buffer* gltf_parse_buffers(const char *data, u64 *offset, int *buffer_count
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        buffer = (Gltf_Buffer*)malloc_t(sizeof(Gltf_Buffer), 8);
+        uri_len = 0;
+        buffer = (Gltf_Buffer*)gltf_alloc(sizeof(Gltf_Buffer), 8);
         *buffer = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // go beyond opening '"'
-            if (simd_strcmp_short(data + inc, "byteLengthxxxxxx", 6) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_BUFFER_KEYS)) {
+            case GLTF_BUFFER_KEYS.id("byteLength"):
                 buffer->byte_length = gltf_ascii_to_u64(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "urixxxxxxxxxxxxx", 13) == 0) {
+            case GLTF_BUFFER_KEYS.id("uri"):
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc); // step inside value string
+                if (simd_strcmp_short(data + inc, "data:xxxxxxxxxxx", 11) == 0) {
+                    // Embedded buffer: do not copy the payload, it can be megabytes (see Gltf_Buffer).
+                    simd_skip_passed_char(data + inc, &inc, ',');
+                    buffer->base64     = data + inc;
+                    buffer->base64_len = simd_strlen(data + inc, '"');
+                    inc += buffer->base64_len + 1;
+                    continue;
+                }
                 uri_len = simd_strlen(data + inc, '"') + 1; // +1 for null termination
-                buffer->uri = (char*)malloc_t(uri_len, 1);
+                buffer->uri = (char*)gltf_alloc(uri_len, 1);
                 memcpy(buffer->uri, data + inc, uri_len);
                 buffer->uri[uri_len - 1] = '\0';
                 simd_skip_passed_char(data + inc, &inc, '"'); // step inside value string
                 continue;
+            case GLTF_BUFFER_KEYS.id("extensions"):
+                gltf_parse_buffer_extensions(data + inc, &inc, buffer);
+                continue;
+            default:
+                break;
             }
         }
         buffer->stride = align(sizeof(Gltf_Buffer) + uri_len, 8);
@@ -1198,33 +1865,42 @@ Gltf_Buffer* gltf_parse_buffers(const char *data, u64 *offset, int *buffer_count
 }
 
 // `BufferViews
+static constexpr auto GLTF_BUFFER_VIEW_KEYS = gltf_make_key_set({
+    "buffer", "byteOffset", "byteLength", "byteStride", "target", "extensions",
+});
 Gltf_Buffer_View* gltf_parse_buffer_views(const char *data, u64 *offset, int *buffer_view_count) {
-    Gltf_Buffer_View *buffer_views = (Gltf_Buffer_View*)malloc_t(0, 8);
+    Gltf_Buffer_View *buffer_views = (Gltf_Buffer_View*)gltf_alloc(0, 8);
     Gltf_Buffer_View *buffer_view;
     u64 inc = 0;
     int count = 0;
 
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        buffer_view = (Gltf_Buffer_View*)malloc_t(sizeof(Gltf_Buffer_View), 8);
+        buffer_view = (Gltf_Buffer_View*)gltf_alloc(sizeof(Gltf_Buffer_View), 8);
         *buffer_view = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step beyond key's opening '"'
-            if (simd_strcmp_short(data + inc, "bufferxxxxxxxxxx", 10) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_BUFFER_VIEW_KEYS)) {
+            case GLTF_BUFFER_VIEW_KEYS.id("buffer"):
                 buffer_view->buffer = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "byteOffsetxxxxxx",  6) == 0) {
+            case GLTF_BUFFER_VIEW_KEYS.id("byteOffset"):
                 buffer_view->byte_offset = gltf_ascii_to_u64(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "byteLengthxxxxxx",  6) == 0) {
+            case GLTF_BUFFER_VIEW_KEYS.id("byteLength"):
                 buffer_view->byte_length = gltf_ascii_to_u64(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "byteStridexxxxxx",  6) == 0) {
+            case GLTF_BUFFER_VIEW_KEYS.id("byteStride"):
                 buffer_view->byte_stride = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "targetxxxxxxxxxx", 10) == 0) {
+            case GLTF_BUFFER_VIEW_KEYS.id("target"):
                 buffer_view->buffer_type = (Gltf_Buffer_Type)gltf_ascii_to_int(data + inc, &inc);
                 continue;
+            case GLTF_BUFFER_VIEW_KEYS.id("extensions"):
+                gltf_parse_buffer_view_extensions(data + inc, &inc, buffer_view);
+                continue;
+            default:
+                break;
             }
         }
         buffer_view->stride = sizeof(Gltf_Buffer_View);
@@ -1235,15 +1911,95 @@ Gltf_Buffer_View* gltf_parse_buffer_views(const char *data, u64 *offset, int *bu
     return buffer_views;
 }
 
+void gltf_parse_buffer_extensions(const char *data, u64 *offset, Gltf_Buffer *buffer) {
+    u64 inc = 0;
+    simd_skip_passed_char(data, &inc, '{'); // step inside extensions object
+    while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
+        inc++;
+        if (simd_strcmp_long(data + inc, "EXT_meshopt_compressionxxxxxxxxx", 9) == 0) {
+            // The only key is "fallback", and it is always true if present.
+            buffer->meshopt_fallback = 1;
+        }
+        gltf_skip_scope(data + inc, &inc, '{', '}');
+    }
+    *offset += inc + 1; // go beyond the extensions object's '}'
+}
+
+static constexpr auto GLTF_MESHOPT_COMPRESSION_KEYS = gltf_make_key_set({
+    "buffer", "byteOffset", "byteLength", "byteStride", "count", "mode", "filter",
+});
+void gltf_parse_buffer_view_extensions(const char *data, u64 *offset, Gltf_Buffer_View *buffer_view) {
+    u64 inc = 0;
+    simd_skip_passed_char(data, &inc, '{'); // step inside extensions object
+    while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
+        inc++;
+        if (simd_strcmp_long(data + inc, "EXT_meshopt_compressionxxxxxxxxx", 9) != 0) {
+            gltf_skip_scope(data + inc, &inc, '{', '}');
+            continue;
+        }
+
+        Gltf_Meshopt_Compression *meshopt = &buffer_view->meshopt;
+        simd_skip_passed_char(data + inc, &inc, '{');
+        while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
+            inc++;
+            switch(gltf_match_key(data + inc, &GLTF_MESHOPT_COMPRESSION_KEYS)) {
+            case GLTF_MESHOPT_COMPRESSION_KEYS.id("buffer"):
+                meshopt->buffer = gltf_ascii_to_int(data + inc, &inc);
+                continue;
+            case GLTF_MESHOPT_COMPRESSION_KEYS.id("byteOffset"):
+                meshopt->byte_offset = gltf_ascii_to_u64(data + inc, &inc);
+                continue;
+            case GLTF_MESHOPT_COMPRESSION_KEYS.id("byteLength"):
+                meshopt->byte_length = gltf_ascii_to_u64(data + inc, &inc);
+                continue;
+            case GLTF_MESHOPT_COMPRESSION_KEYS.id("byteStride"):
+                meshopt->byte_stride = gltf_ascii_to_int(data + inc, &inc);
+                continue;
+            case GLTF_MESHOPT_COMPRESSION_KEYS.id("count"):
+                meshopt->count = gltf_ascii_to_int(data + inc, &inc);
+                continue;
+            case GLTF_MESHOPT_COMPRESSION_KEYS.id("mode"):
+                simd_skip_passed_char_count(data + inc, '"', 2, &inc); // step inside value string
+                if (simd_strcmp_short(data + inc, "ATTRIBUTESxxxxxx", 6) == 0)
+                    meshopt->mode = GLTF_MESHOPT_MODE_ATTRIBUTES;
+                else if (simd_strcmp_short(data + inc, "TRIANGLESxxxxxxx", 7) == 0)
+                    meshopt->mode = GLTF_MESHOPT_MODE_TRIANGLES;
+                else if (simd_strcmp_short(data + inc, "INDICESxxxxxxxxx", 9) == 0)
+                    meshopt->mode = GLTF_MESHOPT_MODE_INDICES;
+                else
+                    assert(false && "Invalid EXT_meshopt_compression mode");
+                simd_skip_passed_char(data + inc, &inc, '"');
+                continue;
+            case GLTF_MESHOPT_COMPRESSION_KEYS.id("filter"):
+                simd_skip_passed_char_count(data + inc, '"', 2, &inc);
+                if (simd_strcmp_short(data + inc, "OCTAHEDRALxxxxxx", 6) == 0)
+                    meshopt->filter = GLTF_MESHOPT_FILTER_OCTAHEDRAL;
+                else if (simd_strcmp_short(data + inc, "QUATERNIONxxxxxx", 6) == 0)
+                    meshopt->filter = GLTF_MESHOPT_FILTER_QUATERNION;
+                else if (simd_strcmp_short(data + inc, "EXPONENTIALxxxxx", 5) == 0)
+                    meshopt->filter = GLTF_MESHOPT_FILTER_EXPONENTIAL;
+                else
+                    meshopt->filter = GLTF_MESHOPT_FILTER_NONE;
+                simd_skip_passed_char(data + inc, &inc, '"');
+                continue;
+            default:
+                break;
+            }
+        }
+        inc++; // go beyond the extension object's '}'
+    }
+    *offset += inc + 1; // go beyond the extensions object's '}'
+}
+
 // `Cameras
 Gltf_Camera* gltf_parse_cameras(const char *data, u64 *offset, int *camera_count) {
-    Gltf_Camera *cameras = (Gltf_Camera*)malloc_t(0, 8);
+    Gltf_Camera *cameras = (Gltf_Camera*)gltf_alloc(0, 8);
     Gltf_Camera *camera;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
-        camera = (Gltf_Camera*)malloc_t(sizeof(Gltf_Camera), 8);
+        camera = (Gltf_Camera*)gltf_alloc(sizeof(Gltf_Camera), 8);
         *camera = {};
         count++;
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
@@ -1307,7 +2063,7 @@ Gltf_Camera* gltf_parse_cameras(const char *data, u64 *offset, int *camera_count
 
 // `Images
 Gltf_Image* gltf_parse_images(const char *data, u64 *offset, int *image_count) {
-    Gltf_Image *images = (Gltf_Image*)malloc_t(0, 8);
+    Gltf_Image *images = (Gltf_Image*)gltf_alloc(0, 8);
     Gltf_Image *image;
 
     u64 inc = 0;
@@ -1315,21 +2071,28 @@ Gltf_Image* gltf_parse_images(const char *data, u64 *offset, int *image_count) {
     int uri_len;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        image = (Gltf_Image*)malloc_t(sizeof(Gltf_Image), 8);
+        uri_len = 0;
+        image = (Gltf_Image*)gltf_alloc(sizeof(Gltf_Image), 8);
         *image = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++;
             if (simd_strcmp_short(data + inc, "urixxxxxxxxxxxxx", 13) == 0) {
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc);
+                if (simd_strcmp_short(data + inc, "data:xxxxxxxxxxx", 11) == 0) {
+                    image->jpeg = simd_strcmp_short(data + inc + 5, "image/jpegxxxxxx", 6) == 0;
+                    simd_skip_passed_char(data + inc, &inc, ',');
+                    image->base64     = data + inc;
+                    image->base64_len = simd_strlen(data + inc, '"');
+                    inc += image->base64_len + 1;
+                    continue;
+                }
                 uri_len = simd_strlen(data + inc, '"') + 1;
-                image->uri = (char*)malloc_t(uri_len, 1);
+                image->uri = (char*)gltf_alloc(uri_len, 1);
                 memcpy(image->uri, data + inc, uri_len);
                 image->uri[uri_len - 1] = '\0';
                 simd_skip_passed_char(data + inc, &inc, '"');
                 continue;
             } else if (simd_strcmp_short(data + inc, "mimeTypexxxxxxxx", 8) == 0) {
-                uri_len = 0;
-                image->uri = NULL;
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc);
                 if (simd_strcmp_short(data + inc, "image/jpegxxxxxx", 6) == 0) {
                     image->jpeg = 1;
@@ -1351,64 +2114,75 @@ Gltf_Image* gltf_parse_images(const char *data, u64 *offset, int *image_count) {
 }
 
 // `Materials
+static constexpr auto GLTF_MATERIAL_KEYS = gltf_make_key_set({
+    "pbrMetallicRoughness", "normalTexture", "occlusionTexture", "emissiveFactor", "emissiveTexture",
+    "alphaMode", "alphaCutoff", "doubleSided",
+});
+static constexpr auto GLTF_PBR_METALLIC_ROUGHNESS_KEYS = gltf_make_key_set({
+    "baseColorFactor", "metallicFactor", "roughnessFactor", "baseColorTexture", "metallicRoughnessTexture",
+});
 Gltf_Material* gltf_parse_materials(const char *data, u64 *offset, int *material_count) {
-    Gltf_Material *materials = (Gltf_Material*)malloc_t(0, 8);
+    Gltf_Material *materials = (Gltf_Material*)gltf_alloc(0, 8);
     Gltf_Material *material;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        material = (Gltf_Material*)malloc_t(sizeof(Gltf_Material), 8);
+        material = (Gltf_Material*)gltf_alloc(sizeof(Gltf_Material), 8);
         *material = {}; // make sure defaults are properly initialized
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++;
-            if (simd_strcmp_long(data + inc, "pbrMetallicRoughnessxxxxxxxxxxxx", 12) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_MATERIAL_KEYS)) {
+            case GLTF_MATERIAL_KEYS.id("pbrMetallicRoughness"):
                 simd_skip_passed_char(data + inc, &inc, '"');
                 while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
                     inc++;
-                    if (simd_strcmp_short(data + inc, "baseColorFactorx", 1) == 0) {
+                    switch(gltf_match_key(data + inc, &GLTF_PBR_METALLIC_ROUGHNESS_KEYS)) {
+                    case GLTF_PBR_METALLIC_ROUGHNESS_KEYS.id("baseColorFactor"):
                         gltf_parse_float_array(data + inc, &inc, &material->base_color_factor[0]);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "metallicFactorxx", 2) == 0) {
+                    case GLTF_PBR_METALLIC_ROUGHNESS_KEYS.id("metallicFactor"):
                         material->metallic_factor = gltf_ascii_to_float(data + inc, &inc);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "roughnessFactorx", 1) == 0) {
+                    case GLTF_PBR_METALLIC_ROUGHNESS_KEYS.id("roughnessFactor"):
                         material->roughness_factor = gltf_ascii_to_float(data + inc, &inc);
                         continue;
-                    } else if (simd_strcmp_short(data + inc, "baseColorTexture", 0) == 0) {
+                    case GLTF_PBR_METALLIC_ROUGHNESS_KEYS.id("baseColorTexture"):
                         simd_skip_passed_char(data + inc, &inc, '"');
                         gltf_parse_texture_info(data + inc, &inc, &material->base_color_texture_index,
                                                 &material->base_color_tex_coord, NULL, NULL);
                         continue;
-                    } else if (simd_strcmp_long(data + inc, "metallicRoughnessTexturexxxxxxxx", 8) == 0) {
+                    case GLTF_PBR_METALLIC_ROUGHNESS_KEYS.id("metallicRoughnessTexture"):
                         simd_skip_passed_char(data + inc, &inc, '"');
                         gltf_parse_texture_info(data + inc, &inc, &material->metallic_roughness_texture_index,
                                                 &material->metallic_roughness_tex_coord, NULL, NULL);
                         continue;
+                    default:
+                        break;
                     }
                 }
                 inc++; // go beyond closing curly
                 continue;
-            } else if (simd_strcmp_short(data + inc, "normalTexturexxx", 3) == 0) {
+            case GLTF_MATERIAL_KEYS.id("normalTexture"):
                 simd_skip_passed_char(data + inc, &inc, '"');
                 gltf_parse_texture_info(data + inc, &inc, &material->normal_texture_index, &material->normal_tex_coord,
                                         &material->normal_scale, NULL);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "occlusionTexture", 0) == 0) {
+            case GLTF_MATERIAL_KEYS.id("occlusionTexture"):
                 simd_skip_passed_char(data + inc, &inc, '"');
                 gltf_parse_texture_info(data + inc, &inc, &material->occlusion_texture_index, &material->occlusion_tex_coord,
                                         NULL, &material->occlusion_strength);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "emissiveFactorxx", 2) == 0) {
+            case GLTF_MATERIAL_KEYS.id("emissiveFactor"):
                 gltf_parse_float_array(data + inc, &inc, &material->emissive_factor[0]);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "emissiveTexturex", 1) == 0) {
+            case GLTF_MATERIAL_KEYS.id("emissiveTexture"):
                 simd_skip_passed_char(data + inc, &inc, '"');
                 gltf_parse_texture_info(data + inc, &inc, &material->emissive_texture_index,
                                         &material->emissive_tex_coord, NULL, NULL);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "alphaModexxxxxxx", 7) == 0) {
+            case GLTF_MATERIAL_KEYS.id("alphaMode"):
                 simd_skip_passed_char_count(data + inc, '"', 2, &inc);
                 if (simd_strcmp_short(data + inc, "OPAQUExxxxxxxxxx", 10) == 0) {
                     material->alpha_mode = GLTF_ALPHA_MODE_OPAQUE;
@@ -1419,10 +2193,10 @@ Gltf_Material* gltf_parse_materials(const char *data, u64 *offset, int *material
                 }
                 simd_skip_passed_char(data + inc, &inc, '"');
                 continue;
-            } else if (simd_strcmp_short(data + inc, "alphaCutoffxxxxx", 5) == 0) {
+            case GLTF_MATERIAL_KEYS.id("alphaCutoff"):
                 material->alpha_cutoff = gltf_ascii_to_float(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "doubleSidedxxxxx", 5) == 0) {
+            case GLTF_MATERIAL_KEYS.id("doubleSided"):
                 simd_skip_passed_char(data + inc, &inc, ':');
                 simd_skip_whitespace(data + inc, &inc);
                 if (simd_strcmp_short(data + inc, "truexxxxxxxxxxxx", 12) == 0) {
@@ -1432,6 +2206,8 @@ Gltf_Material* gltf_parse_materials(const char *data, u64 *offset, int *material
                     material->double_sided = 0;
                     continue;
                 }
+            default:
+                break;
             }
         }
         material->stride = align(sizeof(Gltf_Material), 8);
@@ -1441,22 +2217,28 @@ Gltf_Material* gltf_parse_materials(const char *data, u64 *offset, int *material
     *material_count = count;
     return materials;
 }
+static constexpr auto GLTF_TEXTURE_INFO_KEYS = gltf_make_key_set({
+    "index", "texCoord", "scale", "strength",
+});
 void gltf_parse_texture_info(const char *data, u64 *offset, int *index, int *tex_coord, float *scale, float *strength) {
     u64 inc = 0;
     while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
         inc++;
-        if (simd_strcmp_short(data + inc, "indexxxxxxxxxxxx", 11) == 0) {
+        switch(gltf_match_key(data + inc, &GLTF_TEXTURE_INFO_KEYS)) {
+        case GLTF_TEXTURE_INFO_KEYS.id("index"):
             *index = gltf_ascii_to_int(data + inc, &inc);
             continue;
-        } else if (simd_strcmp_short(data + inc, "texCoordxxxxxxxx", 8) == 0) {
+        case GLTF_TEXTURE_INFO_KEYS.id("texCoord"):
             *tex_coord = gltf_ascii_to_int(data + inc, &inc);
             continue;
-        } else if (simd_strcmp_short(data + inc, "scalexxxxxxxxxxx", 11) == 0) {
+        case GLTF_TEXTURE_INFO_KEYS.id("scale"):
             *scale = gltf_ascii_to_float(data + inc, &inc);
             continue;
-        } else if (simd_strcmp_short(data + inc, "strengthxxxxxxxx", 8) == 0) {
+        case GLTF_TEXTURE_INFO_KEYS.id("strength"):
             *strength = gltf_ascii_to_float(data + inc, &inc);
             continue;
+        default:
+            break;
         }
     }
     *offset += inc + 1; // +1 go beyond closing curly
@@ -1464,7 +2246,7 @@ void gltf_parse_texture_info(const char *data, u64 *offset, int *index, int *tex
 
 // `Meshes
 Gltf_Mesh* gltf_parse_meshes(const char *data, u64 *offset, int *mesh_count, u32 *total_primitive_count) {
-    Gltf_Mesh *meshes = (Gltf_Mesh*)malloc_t(0, 8);
+    Gltf_Mesh *meshes = (Gltf_Mesh*)gltf_alloc(0, 8);
     Gltf_Mesh *mesh;
 
     u64 inc = 0;
@@ -1472,8 +2254,8 @@ Gltf_Mesh* gltf_parse_meshes(const char *data, u64 *offset, int *mesh_count, u32
     u64 mark;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        mark = get_mark_temp();
-        mesh = (Gltf_Mesh*)malloc_t(sizeof(Gltf_Mesh), 8);
+        mark = align(gltf_get_mark(), 8); // See gltf_parse_nodes(..): weights may leave the mark unaligned
+        mesh = (Gltf_Mesh*)gltf_alloc(sizeof(Gltf_Mesh), 8);
         *mesh = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
@@ -1485,20 +2267,23 @@ Gltf_Mesh* gltf_parse_meshes(const char *data, u64 *offset, int *mesh_count, u32
                 mesh->weight_count = simd_get_ascii_array_len(data + inc);
                 // @MemAlign careful with this alignment (the 4 I mean)
                 // Aligning to 4 means I can align the entire stride later, rather than its pieces
-                mesh->weights = (float*)malloc_t(sizeof(float) * mesh->weight_count, 4);
+                mesh->weights = (float*)gltf_alloc(sizeof(float) * mesh->weight_count, 4);
                 gltf_parse_float_array(data + inc, &inc, mesh->weights);
                 continue;
             }
         }
-        mesh->stride = align(get_mark_temp() - mark, 8);
+        mesh->stride = align(gltf_get_mark() - mark, 8);
         *total_primitive_count += mesh->primitive_count;
     }
     *offset += inc;
     *mesh_count = count;
     return meshes;
 }
+static constexpr auto GLTF_MESH_PRIMITIVE_KEYS = gltf_make_key_set({
+    "indices", "material", "mode", "targets", "attributes",
+});
 Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, int *primitive_count) {
-    Gltf_Mesh_Primitive *primitives = (Gltf_Mesh_Primitive*)malloc_t(0, 8);
+    Gltf_Mesh_Primitive *primitives = (Gltf_Mesh_Primitive*)gltf_alloc(0, 8);
     Gltf_Mesh_Primitive *primitive;
     Gltf_Morph_Target *target;
 
@@ -1510,18 +2295,19 @@ Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, i
     int mode;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        mark = get_mark_temp();
-        primitive = (Gltf_Mesh_Primitive*)malloc_t(sizeof(Gltf_Mesh_Primitive), 8);
+        mark = gltf_get_mark();
+        primitive = (Gltf_Mesh_Primitive*)gltf_alloc(sizeof(Gltf_Mesh_Primitive), 8);
         *primitive = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "indicesxxxxxxxxx", 9) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_MESH_PRIMITIVE_KEYS)) {
+            case GLTF_MESH_PRIMITIVE_KEYS.id("indices"):
                 primitive->indices = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "materialxxxxxxxx", 8) == 0) {
+            case GLTF_MESH_PRIMITIVE_KEYS.id("material"):
                 primitive->material = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "modexxxxxxxxxxxx", 12) == 0) {
+            case GLTF_MESH_PRIMITIVE_KEYS.id("mode"):
                 mode = gltf_ascii_to_int(data + inc, &inc);
                 switch(mode) {
                 case 0:
@@ -1548,26 +2334,26 @@ Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, i
                     break;
                 }
                 continue;
-            } else if (simd_strcmp_short(data + inc, "targetsxxxxxxxxx", 9) == 0) {
-                primitive->targets = (Gltf_Morph_Target*)malloc_t(0, 8);
+            case GLTF_MESH_PRIMITIVE_KEYS.id("targets"):
+                primitive->targets = (Gltf_Morph_Target*)gltf_alloc(0, 8);
                 target_count = 0;
                 while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
                     target_count++;
 
-                    target_mark = get_mark_temp();
+                    target_mark = gltf_get_mark();
                     target =
-                        (Gltf_Morph_Target*)malloc_t(sizeof(Gltf_Morph_Target), 8);
+                        (Gltf_Morph_Target*)gltf_alloc(sizeof(Gltf_Morph_Target), 8);
 
                     *target = {};
 
                     target->attributes =
                         gltf_parse_mesh_attributes(data + inc, &inc, &target->attribute_count, true, NULL, NULL, NULL, NULL);
 
-                    target->stride = align(get_mark_temp() - target_mark, 8);
+                    target->stride = align(gltf_get_mark() - target_mark, 8);
                 }
                 primitive->target_count = target_count;
                 continue;
-            } else if (simd_strcmp_short(data + inc, "attributesxxxxxx", 6) == 0) {
+            case GLTF_MESH_PRIMITIVE_KEYS.id("attributes"):
                 simd_skip_passed_char(data + inc, &inc, '{');
                 primitive->extra_attributes = gltf_parse_mesh_attributes(
                         data + inc,
@@ -1579,9 +2365,11 @@ Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, i
                         &primitive->normal,
                         &primitive->tex_coord_0);
                 continue;
+            default:
+                break;
             }
         }
-        primitive->stride = align(get_mark_temp() - mark, 8);
+        primitive->stride = align(gltf_get_mark() - mark, 8);
     }
     inc++; // go beyond closing primitives square brace
     *offset += inc;
@@ -1589,7 +2377,7 @@ Gltf_Mesh_Primitive* gltf_parse_mesh_primitives(const char *data, u64 *offset, i
     return primitives;
 }
 Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, int *attribute_count, bool targets /* HACK */, int *position, int *tangent, int *normal, int *tex_coord_0) {
-    Gltf_Mesh_Attribute *attributes = (Gltf_Mesh_Attribute*)malloc_t(0, 4);
+    Gltf_Mesh_Attribute *attributes = (Gltf_Mesh_Attribute*)gltf_alloc(0, 4);
     Gltf_Mesh_Attribute *attribute;
 
     u64 inc = 0;
@@ -1600,7 +2388,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
         // aligning to 4 allows for regular indexing
         if (simd_strcmp_short(data + inc, "NORMALxxxxxxxxxx", 10) == 0) {
             if (targets) {
-                attribute = (Gltf_Mesh_Attribute*)malloc_t(sizeof(Gltf_Mesh_Attribute), 4);
+                attribute = (Gltf_Mesh_Attribute*)gltf_alloc(sizeof(Gltf_Mesh_Attribute), 4);
                 attribute->n = 0;
                 attribute->type           = GLTF_MESH_ATTRIBUTE_TYPE_NORMAL;
                 attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1612,7 +2400,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
         }
         else if (simd_strcmp_short(data + inc, "POSITIONxxxxxxxx",  8) == 0) {
             if (targets) {
-                attribute = (Gltf_Mesh_Attribute*)malloc_t(sizeof(Gltf_Mesh_Attribute), 4);
+                attribute = (Gltf_Mesh_Attribute*)gltf_alloc(sizeof(Gltf_Mesh_Attribute), 4);
                 attribute->n = 0;
                 attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_POSITION;
                 attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1624,7 +2412,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
         }
         else if (simd_strcmp_short(data + inc, "TANGENTxxxxxxxxx",  9) == 0) {
             if (targets) {
-                attribute = (Gltf_Mesh_Attribute*)malloc_t(sizeof(Gltf_Mesh_Attribute), 4);
+                attribute = (Gltf_Mesh_Attribute*)gltf_alloc(sizeof(Gltf_Mesh_Attribute), 4);
                 attribute->n = 0;
                 attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_TANGENT;
                 attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1637,7 +2425,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
         else if (simd_strcmp_short(data + inc, "TEXCOORDxxxxxxxx",  8) == 0) {
             n = gltf_ascii_to_int(data + inc, &inc);
             if (n != 0 || targets) {
-                attribute = (Gltf_Mesh_Attribute*)malloc_t(sizeof(Gltf_Mesh_Attribute), 4);
+                attribute = (Gltf_Mesh_Attribute*)gltf_alloc(sizeof(Gltf_Mesh_Attribute), 4);
                 attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_TEXCOORD;
                 attribute->n    = n;
                 attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1648,7 +2436,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
             continue;
         }
         else if (simd_strcmp_short(data + inc, "COLORxxxxxxxxxxx", 11) == 0) {
-            attribute = (Gltf_Mesh_Attribute*)malloc_t(sizeof(Gltf_Mesh_Attribute), 4);
+            attribute = (Gltf_Mesh_Attribute*)gltf_alloc(sizeof(Gltf_Mesh_Attribute), 4);
             attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_COLOR;
             attribute->n    = gltf_ascii_to_int(data + inc, &inc);
             attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1656,7 +2444,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
             continue;
         }
         else if (simd_strcmp_short(data + inc, "JOINTSxxxxxxxxxx", 10) == 0) {
-            attribute = (Gltf_Mesh_Attribute*)malloc_t(sizeof(Gltf_Mesh_Attribute), 4);
+            attribute = (Gltf_Mesh_Attribute*)gltf_alloc(sizeof(Gltf_Mesh_Attribute), 4);
             attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_JOINTS;
             attribute->n    = gltf_ascii_to_int(data + inc, &inc);
             attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1664,7 +2452,7 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
             continue;
         }
         else if (simd_strcmp_short(data + inc, "WEIGHTSxxxxxxxxx",  9) == 0) {
-            attribute = (Gltf_Mesh_Attribute*)malloc_t(sizeof(Gltf_Mesh_Attribute), 4);
+            attribute = (Gltf_Mesh_Attribute*)gltf_alloc(sizeof(Gltf_Mesh_Attribute), 4);
             attribute->type = GLTF_MESH_ATTRIBUTE_TYPE_WEIGHTS;
             attribute->n    = gltf_ascii_to_int(data + inc, &inc);
             attribute->accessor_index = gltf_ascii_to_int(data + inc, &inc);
@@ -1680,8 +2468,11 @@ Gltf_Mesh_Attribute* gltf_parse_mesh_attributes(const char *data, u64 *offset, i
 }
 
 // `Nodes
+static constexpr auto GLTF_NODE_KEYS = gltf_make_key_set({
+    "camera", "skin", "mesh", "matrix", "rotation", "scale", "translation", "children", "weights",
+});
 Gltf_Node* gltf_parse_nodes(const char *data, u64 *offset, int *node_count) {
-    Gltf_Node *nodes = (Gltf_Node*)malloc_t(0, 8);
+    Gltf_Node *nodes = (Gltf_Node*)gltf_alloc(0, 8);
     Gltf_Node *node;
 
     u64 inc = 0;
@@ -1690,57 +2481,67 @@ Gltf_Node* gltf_parse_nodes(const char *data, u64 *offset, int *node_count) {
     float temp_array[4];
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        mark = get_mark_temp();
-        node = (Gltf_Node*)malloc_t(sizeof(Gltf_Node), 8);
+        // Aligned as the node will be: the previous node's children may have left the mark on a 4 byte boundary,
+        // and counting the padding into the stride puts the next node past where it was written.
+        mark = align(gltf_get_mark(), 8);
+        node = (Gltf_Node*)gltf_alloc(sizeof(Gltf_Node), 8);
         *node = {};
+        node->trs = Gltf_Trs{}; // The union is zeroed above, but a node without a transform is the identity
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "cameraxxxxxxxxxx", 10) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_NODE_KEYS)) {
+            case GLTF_NODE_KEYS.id("camera"):
                 node->camera = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "skinxxxxxxxxxxxx", 12) == 0) {
+            case GLTF_NODE_KEYS.id("skin"):
                 node->skin = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "meshxxxxxxxxxxxx", 12) == 0) {
+            case GLTF_NODE_KEYS.id("mesh"):
                 node->mesh = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "matrixxxxxxxxxxx", 10) == 0) {
-                node->matrix = gltf_ascii_to_mat4(data + inc, &inc);
+            case GLTF_NODE_KEYS.id("matrix"):
+                node->matrix     = gltf_ascii_to_mat4(data + inc, &inc);
+                node->has_matrix = 1;
                 continue;
-            } else if (simd_strcmp_short(data + inc, "rotationxxxxxxxx", 8) == 0) {
+            case GLTF_NODE_KEYS.id("rotation"):
                 gltf_parse_float_array(data + inc, &inc, temp_array);
                 node->trs.rotation = {temp_array[0], temp_array[1], temp_array[2], temp_array[3]};
                 continue;
-            } else if (simd_strcmp_short(data + inc, "scalexxxxxxxxxxx", 11) == 0) {
+            case GLTF_NODE_KEYS.id("scale"):
                 gltf_parse_float_array(data + inc, &inc, temp_array);
                 node->trs.scale = {temp_array[0], temp_array[1], temp_array[2]};
                 continue;
-            } else if (simd_strcmp_short(data + inc, "translationxxxxx", 5) == 0) {
+            case GLTF_NODE_KEYS.id("translation"):
                 gltf_parse_float_array(data + inc, &inc, temp_array);
                 node->trs.translation = {temp_array[0], temp_array[1], temp_array[2]};
                 continue;
-            } else if (simd_strcmp_short(data + inc, "childrenxxxxxxxx", 8) == 0) {
+            case GLTF_NODE_KEYS.id("children"):
                 node->child_count = simd_get_ascii_array_len(data + inc);
-                node->children = (int*)malloc_t(sizeof(int) * node->child_count, 4);
+                node->children = (int*)gltf_alloc(sizeof(int) * node->child_count, 4);
                 gltf_parse_int_array(data + inc, &inc, node->children);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "weightsxxxxxxxxx", 9) == 0) {
+            case GLTF_NODE_KEYS.id("weights"):
                 node->weight_count = simd_get_ascii_array_len(data + inc);
-                node->weights = (float*)malloc_t(sizeof(float) * node->weight_count, 4);
+                node->weights = (float*)gltf_alloc(sizeof(float) * node->weight_count, 4);
                 gltf_parse_float_array(data + inc, &inc, node->weights);
                 continue;
+            default:
+                break;
             }
         }
-        node->stride = align(get_mark_temp() - mark, 8);
+        node->stride = align(gltf_get_mark() - mark, 8);
     }
     *offset += inc;
     *node_count = count;
     return nodes;
 }
 
+static constexpr auto GLTF_SAMPLER_KEYS = gltf_make_key_set({
+    "magFilter", "minFilter", "wrapS", "wrapT",
+});
 Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_count) {
     // @MemAlign being dangerous with a 4 align...
-    Gltf_Sampler *samplers = (Gltf_Sampler*)malloc_t(0, 4);
+    Gltf_Sampler *samplers = (Gltf_Sampler*)gltf_alloc(0, 4);
     Gltf_Sampler *sampler;
 
     u64 inc = 0;
@@ -1748,12 +2549,13 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
     int temp_int;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        sampler = (Gltf_Sampler*)malloc_t(sizeof(Gltf_Sampler), 4);
+        sampler = (Gltf_Sampler*)gltf_alloc(sizeof(Gltf_Sampler), 4);
         *sampler = {};
         sampler->stride = sizeof(Gltf_Sampler);
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_short(data + inc, "magFilterxxxxxxx", 7) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_SAMPLER_KEYS)) {
+            case GLTF_SAMPLER_KEYS.id("magFilter"):
                 temp_int = gltf_ascii_to_int(data + inc, &inc);
                 switch (temp_int) {
                 case 9728:
@@ -1765,7 +2567,8 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
                 default:
                     assert(false && "This is not a valid filter setting");
                 }
-            } else if (simd_strcmp_short(data + inc, "minFilterxxxxxxx", 7) == 0) {
+                break;
+            case GLTF_SAMPLER_KEYS.id("minFilter"):
                 temp_int = gltf_ascii_to_int(data + inc, &inc);
                 switch (temp_int) {
                 case 9728:
@@ -1789,7 +2592,8 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
                 default:
                     assert(false && "This is not a valid filter setting");
                 }
-            }  else if (simd_strcmp_short(data + inc, "wrapSxxxxxxxxxxx", 11) == 0) {
+                break;
+            case GLTF_SAMPLER_KEYS.id("wrapS"):
                 temp_int = gltf_ascii_to_int(data + inc, &inc);
                 switch (temp_int) {
                 case 10497:
@@ -1804,7 +2608,8 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
                 default:
                     assert(false && "This is not a valid wrap setting");
                 }
-            }  else if (simd_strcmp_short(data + inc, "wrapTxxxxxxxxxxx", 11) == 0) {
+                break;
+            case GLTF_SAMPLER_KEYS.id("wrapT"):
                 temp_int = gltf_ascii_to_int(data + inc, &inc);
                 switch (temp_int) {
                 case 10497:
@@ -1819,6 +2624,9 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
                 default:
                     assert(false && "This is not a valid wrap setting");
                 }
+                break;
+            default:
+                break;
             }
         }
     }
@@ -1828,14 +2636,14 @@ Gltf_Sampler* gltf_parse_samplers(const char *data, u64 *offset, int *sampler_co
 }
 
 Gltf_Scene* gltf_parse_scenes(const char *data, u64 *offset, int *scene_count) {
-    Gltf_Scene *scenes = (Gltf_Scene*)malloc_t(0, 8);
+    Gltf_Scene *scenes = (Gltf_Scene*)gltf_alloc(0, 8);
     Gltf_Scene *scene;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        scene = (Gltf_Scene*)malloc_t(sizeof(Gltf_Scene), 8);
+        scene = (Gltf_Scene*)gltf_alloc(sizeof(Gltf_Scene), 8);
         *scene = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
@@ -1848,7 +2656,7 @@ Gltf_Scene* gltf_parse_scenes(const char *data, u64 *offset, int *scene_count) {
                 // really large... (Idk how big nodes get, whether scenes are made up of lots of small
                 // nodes, or a couple big ones. Tbf these are only root nodes so maybe the list isnt that long??)
                 scene->node_count = simd_get_ascii_array_len(data + inc);
-                scene->nodes = (int*)malloc_t(sizeof(int) * scene->node_count, 4);
+                scene->nodes = (int*)gltf_alloc(sizeof(int) * scene->node_count, 4);
                 gltf_parse_int_array(data + inc, &inc, scene->nodes);
                 continue;
             }
@@ -1860,29 +2668,35 @@ Gltf_Scene* gltf_parse_scenes(const char *data, u64 *offset, int *scene_count) {
     return scenes;
 }
 
+static constexpr auto GLTF_SKIN_KEYS = gltf_make_key_set({
+    "inverseBindMatrices", "skeleton", "joints",
+});
 Gltf_Skin* gltf_parse_skins(const char *data, u64 *offset, int *skin_count) {
-    Gltf_Skin *skins = (Gltf_Skin*)malloc_t(0, 8);
+    Gltf_Skin *skins = (Gltf_Skin*)gltf_alloc(0, 8);
     Gltf_Skin *skin;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        skin = (Gltf_Skin*)malloc_t(sizeof(Gltf_Skin), 8);
+        skin = (Gltf_Skin*)gltf_alloc(sizeof(Gltf_Skin), 8);
         *skin = {};
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
             inc++; // step into key
-            if (simd_strcmp_long(data + inc, "inverseBindMatricesxxxxxxxxxxxxxxxxxxxxx", 13) == 0) {
+            switch(gltf_match_key(data + inc, &GLTF_SKIN_KEYS)) {
+            case GLTF_SKIN_KEYS.id("inverseBindMatrices"):
                 skin->inverse_bind_matrices = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "skeletonxxxxxxxx", 8) == 0) {
+            case GLTF_SKIN_KEYS.id("skeleton"):
                 skin->skeleton = gltf_ascii_to_int(data + inc, &inc);
                 continue;
-            } else if (simd_strcmp_short(data + inc, "jointsxxxxxxxxxx", 10) == 0) {
+            case GLTF_SKIN_KEYS.id("joints"):
                 skin->joint_count = simd_get_ascii_array_len(data + inc);
-                skin->joints = (int*)malloc_t(sizeof(int) * skin->joint_count, 4);
+                skin->joints = (int*)gltf_alloc(sizeof(int) * skin->joint_count, 4);
                 gltf_parse_int_array(data + inc, &inc, skin->joints);
                 continue;
+            default:
+                break;
             }
         }
         skin->stride = align(sizeof(Gltf_Skin) + skin->joint_count * sizeof(int), 8);
@@ -1893,14 +2707,14 @@ Gltf_Skin* gltf_parse_skins(const char *data, u64 *offset, int *skin_count) {
 }
 
 Gltf_Texture* gltf_parse_textures(const char *data, u64 *offset, int *texture_count) {
-    Gltf_Texture *textures = (Gltf_Texture*)malloc_t(0, 4);
+    Gltf_Texture *textures = (Gltf_Texture*)gltf_alloc(0, 4);
     Gltf_Texture *texture;
 
     u64 inc = 0;
     int count = 0;
     while(simd_find_char_interrupted(data + inc, '{', ']', &inc)) {
         count++;
-        texture = (Gltf_Texture*)malloc_t(sizeof(Gltf_Texture), 4);
+        texture = (Gltf_Texture*)gltf_alloc(sizeof(Gltf_Texture), 4);
         *texture = {};
         texture->stride = sizeof(Gltf_Texture);
         while(simd_find_char_interrupted(data + inc, '"', '}', &inc)) {
@@ -1919,83 +2733,115 @@ Gltf_Texture* gltf_parse_textures(const char *data, u64 *offset, int *texture_co
     return textures;
 }
 
+// Parse a lazy section on first touch.
+inline static void gltf_touch_section(Gltf *gltf, Gltf_Section section) {
+    if (gltf->unparsed_sections & (1 << section))
+        gltf_parse_section(gltf, section);
+}
+
 Gltf_Accessor* gltf_accessor_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_ACCESSORS);
     return (Gltf_Accessor*)((u8*)gltf->accessors + gltf->accessor_count[i]);
 }
 Gltf_Animation* gltf_animation_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_ANIMATIONS);
     return (Gltf_Animation*)((u8*)gltf->animations + gltf->animation_count[i]);
 }
 Gltf_Buffer* gltf_buffer_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_BUFFERS);
     return (Gltf_Buffer*)((u8*)gltf->buffers + gltf->buffer_count[i]);
 }
 Gltf_Buffer_View* gltf_buffer_view_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_BUFFER_VIEWS);
     return (Gltf_Buffer_View*)((u8*)gltf->buffer_views + gltf->buffer_view_count[i]);
 }
 Gltf_Camera* gltf_camera_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_CAMERAS);
     return (Gltf_Camera*)((u8*)gltf->cameras + gltf->camera_count[i]);
 }
 Gltf_Image* gltf_image_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_IMAGES);
     return (Gltf_Image*)((u8*)gltf->images + gltf->image_count[i]);
 }
 Gltf_Material* gltf_material_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_MATERIALS);
     return (Gltf_Material*)((u8*)gltf->materials + gltf->material_count[i]);
 }
 Gltf_Mesh* gltf_mesh_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_MESHES);
     return (Gltf_Mesh*)((u8*)gltf->meshes + gltf->mesh_count[i]);
 }
 Gltf_Node* gltf_node_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_NODES);
     return (Gltf_Node*)((u8*)gltf->nodes + gltf->node_count[i]);
 }
 Gltf_Sampler* gltf_sampler_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_SAMPLERS);
     return (Gltf_Sampler*)((u8*)gltf->samplers + gltf->sampler_count[i]);
 }
 Gltf_Scene* gltf_scene_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_SCENES);
     return (Gltf_Scene*)((u8*)gltf->scenes + gltf->scene_count[i]);
 }
 Gltf_Skin* gltf_skin_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_SKINS);
     return (Gltf_Skin*)((u8*)gltf->skins + gltf->skin_count[i]);
 }
 Gltf_Texture* gltf_texture_by_index(Gltf *gltf, int i) {
+    gltf_touch_section(gltf, GLTF_SECTION_TEXTURES);
     return (Gltf_Texture*)((u8*)gltf->textures + gltf->texture_count[i]);
 }
 
 int gltf_accessor_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_ACCESSORS);
     return gltf->accessor_count[-1];
 }
 int gltf_animation_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_ANIMATIONS);
     return gltf->animation_count[-1];
 }
 int gltf_buffer_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_BUFFERS);
     return gltf->buffer_count[-1];
 }
 int gltf_buffer_view_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_BUFFER_VIEWS);
     return gltf->buffer_view_count[-1];
 }
 int gltf_camera_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_CAMERAS);
     return gltf->camera_count[-1];
 }
 int gltf_image_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_IMAGES);
     return gltf->image_count[-1];
 }
 int gltf_material_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_MATERIALS);
     return gltf->material_count[-1];
 }
 int gltf_mesh_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_MESHES);
     return gltf->mesh_count[-1];
 }
 int gltf_node_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_NODES);
     return gltf->node_count[-1];
 }
 int gltf_sampler_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_SAMPLERS);
     return gltf->sampler_count[-1];
 }
 int gltf_scene_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_SCENES);
     return gltf->scene_count[-1];
 }
 int gltf_skin_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_SKINS);
     return gltf->skin_count[-1];
 }
 int gltf_texture_get_count(Gltf *gltf) {
+    gltf_touch_section(gltf, GLTF_SECTION_TEXTURES);
     return gltf->texture_count[-1];
 }
 
@@ -2013,6 +2859,11 @@ static void test_samplers(Gltf_Sampler *samplers);
 static void test_scenes(Gltf_Scene *scenes);
 static void test_skins(Gltf_Skin *skins);
 static void test_textures(Gltf_Texture *textures);
+static void test_embedded();
+static void test_lazy();
+static void test_document();
+static void test_key_sets();
+static void test_stream();
 
 void test_gltf() {
     Gltf gltf = parse_gltf("test/test_gltf.gltf");
@@ -2092,6 +2943,7 @@ void test_gltf() {
     TEST_FEQ("materials[1].emissive_factor[2]", material->emissive_factor[2] ,  0.0, false);
 
     Gltf_Node *node = gltf_node_by_index(&gltf, 0);
+    TEST_EQ("nodes[0].has_matrix",  node->has_matrix, 1, false);
     TEST_FEQ("nodes[0].matrix[0]",  node->matrix.row0.x, -0.99975   , false);
     TEST_FEQ("nodes[0].matrix[1]",  node->matrix.row0.y, -0.00679829, false);
     TEST_FEQ("nodes[0].matrix[2]",  node->matrix.row0.z, 0.0213218  , false);
@@ -2115,6 +2967,334 @@ void test_gltf() {
     TEST_FEQ("nodes[0].weights[3]", node->weights[3], 0.8, false);
 
     END_TEST_MODULE();
+
+    test_embedded();
+    test_lazy();
+    test_document();
+    test_key_sets();
+    test_stream();
+}
+
+static void test_embedded() {
+    Gltf gltf = parse_gltf("test/test_gltf_embedded.gltf");
+
+    BEGIN_TEST_MODULE("Gltf_Embedded_Data", false, false);
+
+    Gltf_Buffer *buffer = gltf_buffer_by_index(&gltf, 0);
+    TEST_PTREQ("buffers[0].uri", buffer->uri, nullptr, false);
+    TEST_EQ("buffers[0].base64_len", buffer->base64_len, (u64)200, false);
+
+    u8 *data = (u8*)malloc_t(buffer->byte_length, 8);
+    TEST_EQ("buffers[0].decode", gltf_buffer_decode_base64(buffer, data), true, false);
+    u32 mismatch = 0;
+    for(u32 i = 0; i < buffer->byte_length; ++i)
+        mismatch += data[i] != (u8)i;
+    TEST_EQ("buffers[0].data", mismatch, 0, false);
+
+    // A payload longer than byteLength must be rejected before anything is written.
+    Gltf_Buffer short_buffer = *buffer;
+    short_buffer.byte_length = buffer->byte_length / 2;
+    memset(data, 0xcd, buffer->byte_length);
+    TEST_EQ("buffers[0].too_long", gltf_buffer_decode_base64(&short_buffer, data), false, false);
+    mismatch = 0;
+    for(u32 i = 0; i < buffer->byte_length; ++i)
+        mismatch += data[i] != 0xcd;
+    TEST_EQ("buffers[0].too_long_untouched", mismatch, 0, false);
+
+    Gltf_Image *image = gltf_image_by_index(&gltf, 0);
+    TEST_PTREQ("images[0].uri", image->uri, nullptr, false);
+    TEST_EQ("images[0].jpeg", image->jpeg, 1, false);
+
+    u64 size = gltf_image_get_base64_decoded_size(image);
+    TEST_EQ("images[0].decoded_size", size, (u64)22, false);
+    TEST_EQ("images[0].decode", gltf_image_decode_base64(image, data, &size), true, false);
+    TEST_EQ("images[0].size", size, (u64)22, false);
+    TEST_EQ("images[0].data[1]", data[1], 0xd8, false);
+    TEST_EQ("images[0].data[21]", data[21], 'g', false);
+
+    image = gltf_image_by_index(&gltf, 1);
+    TEST_STREQ("images[1].uri", image->uri, "duckCM.png", false);
+    TEST_PTREQ("images[1].base64", image->base64, nullptr, false);
+
+    // Invalid chars must be rejected in both the vector loop and the tail.
+    const char *bad = "AAECAwQFBgcICQoLDA0ODxAREhMUFRYXGBkaGxwdHh8gISIj!CUmJygpKissLS4vMDEyMzQ1Njc4OTo7PD0+P0BB";
+    TEST_EQ("invalid_vector", simd_base64_decode(bad, 16, data, &size), true, false);
+    TEST_EQ("invalid_vector", simd_base64_decode(bad, strlen(bad), data, &size), false, false);
+    TEST_EQ("invalid_tail",   simd_base64_decode("QUJD!A==", 8, data, &size), false, false);
+
+    // Every length mod 4, padded and not, through the vector loop and the tail. The output is exactly the decoded
+    // size, followed by guard bytes which must be left alone.
+    const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char text[140];
+    u8   bytes[100];
+    u32  bad_size  = 0;
+    u32  bad_data  = 0;
+    u32  bad_guard = 0;
+    for(u32 n = 0; n < 100; ++n) {
+        for(u32 i = 0; i < n; ++i)
+            bytes[i] = (u8)(i * 37 + n);
+        u32 len = 0;
+        for(u32 i = 0; i < n; i += 3) {
+            u32 group = bytes[i] << 16 | (i + 1 < n ? bytes[i + 1] << 8 : 0) | (i + 2 < n ? bytes[i + 2] : 0);
+            text[len++] = alphabet[(group >> 18) & 63];
+            text[len++] = alphabet[(group >> 12) & 63];
+            text[len++] = i + 1 < n ? alphabet[(group >> 6) & 63] : '=';
+            text[len++] = i + 2 < n ? alphabet[group & 63] : '=';
+        }
+        for(u32 padded = 0; padded < 2; ++padded) {
+            u32 text_len = len;
+            while(!padded && text_len && text[text_len - 1] == '=')
+                text_len--;
+
+            u64 expect = base64_get_decoded_size(text, text_len);
+            u8 *out    = malloc_h(expect + 32, 1);
+            memset(out, 0xcd, expect + 32);
+            bool ok = simd_base64_decode(text, text_len, out, &size);
+            bad_size += !ok || size != n || expect != n;
+            bad_data += memcmp(out, bytes, n) != 0;
+            for(u32 g = 0; g < 32; ++g)
+                bad_guard += out[expect + g] != 0xcd;
+            free_h(out);
+        }
+    }
+    TEST_EQ("lengths_size",  bad_size,  0, false);
+    TEST_EQ("lengths_data",  bad_data,  0, false);
+    TEST_EQ("lengths_guard", bad_guard, 0, false);
+
+    END_TEST_MODULE();
+}
+
+static void test_lazy() {
+    Gltf eager = parse_gltf("test/test_gltf.gltf");
+    Gltf lazy  = parse_gltf_lazy("test/test_gltf.gltf");
+
+    BEGIN_TEST_MODULE("Gltf_Lazy", false, false);
+
+    TEST_EQ("unparsed_sections", lazy.unparsed_sections, (1 << GLTF_SECTION_COUNT) - 1, false);
+    TEST_EQ("eager_unparsed_sections", eager.unparsed_sections, 0, false);
+
+    // Touching a section parses only that section...
+    TEST_EQ("mesh_count", gltf_mesh_get_count(&lazy), gltf_mesh_get_count(&eager), false);
+    TEST_EQ("meshes_parsed", lazy.unparsed_sections & (1 << GLTF_SECTION_MESHES), 0, false);
+    TEST_EQ("animations_unparsed", (lazy.unparsed_sections >> GLTF_SECTION_ANIMATIONS) & 1, 1, false);
+    TEST_EQ("total_primitive_count", lazy.total_primitive_count, eager.total_primitive_count, false);
+
+    // ...except accessors, which need buffer views for their strides.
+    Gltf_Accessor *a = gltf_accessor_by_index(&lazy, 2);
+    Gltf_Accessor *b = gltf_accessor_by_index(&eager, 2);
+    TEST_EQ("buffer_views_parsed", lazy.unparsed_sections & (1 << GLTF_SECTION_BUFFER_VIEWS), 0, false);
+    TEST_EQ("accessors[2].byte_stride", a->byte_stride, b->byte_stride, false);
+    TEST_EQ("accessors[2].count", a->count, b->count, false);
+    TEST_EQ("accessors[2].buffer_view", a->buffer_view, b->buffer_view, false);
+
+    // Every section must come out the same as the eager parse, wherever it is in the file.
+    TEST_EQ("animation_count", gltf_animation_get_count(&lazy), gltf_animation_get_count(&eager), false);
+    TEST_EQ("buffer_count",    gltf_buffer_get_count(&lazy),    gltf_buffer_get_count(&eager),    false);
+    TEST_EQ("camera_count",    gltf_camera_get_count(&lazy),    gltf_camera_get_count(&eager),    false);
+    TEST_EQ("image_count",     gltf_image_get_count(&lazy),     gltf_image_get_count(&eager),     false);
+    TEST_EQ("material_count",  gltf_material_get_count(&lazy),  gltf_material_get_count(&eager),  false);
+    TEST_EQ("node_count",      gltf_node_get_count(&lazy),      gltf_node_get_count(&eager),      false);
+    TEST_EQ("sampler_count",   gltf_sampler_get_count(&lazy),   gltf_sampler_get_count(&eager),   false);
+    TEST_EQ("scene_count",     gltf_scene_get_count(&lazy),     gltf_scene_get_count(&eager),     false);
+    TEST_EQ("skin_count",      gltf_skin_get_count(&lazy),      gltf_skin_get_count(&eager),      false);
+    TEST_EQ("texture_count",   gltf_texture_get_count(&lazy),   gltf_texture_get_count(&eager),   false);
+    TEST_EQ("all_parsed",      lazy.unparsed_sections, 0, false);
+
+    TEST_EQ("skins[3].joint_count", gltf_skin_by_index(&lazy, 3)->joint_count,
+            gltf_skin_by_index(&eager, 3)->joint_count, false);
+    TEST_EQ("nodes[6].mesh", gltf_node_by_index(&lazy, 6)->mesh, gltf_node_by_index(&eager, 6)->mesh, false);
+    TEST_STREQ("images[2].uri", gltf_image_by_index(&lazy, 2)->uri, gltf_image_by_index(&eager, 2)->uri, false);
+    TEST_EQ("scene", lazy.scene, eager.scene, false);
+
+    END_TEST_MODULE();
+}
+
+static void test_document() {
+    u64 heap_used = get_instance_heap()->used;
+    u64 mark      = get_mark_temp();
+
+    Gltf_Document *eager = gltf_document_create("test/test_gltf.gltf", false);
+    Gltf_Document *lazy  = gltf_document_create("test/test_gltf.gltf", true);
+
+    BEGIN_TEST_MODULE("Gltf_Document", false, false);
+
+    TEST_EQ("temp_untouched", get_mark_temp(), mark, false);
+    TEST_EQ("eager_fits", eager->arena.used <= eager->arena.capacity, true, false);
+    TEST_EQ("lazy_nothing_parsed", lazy->arena.used, 0, false);
+
+    // Stomp the temp allocator to make sure that nothing still points into it.
+    Gltf temp = parse_gltf("test/test_gltf.gltf");
+    int  node_count      = gltf_node_get_count(&temp);
+    int  accessor_stride = gltf_accessor_by_index(&temp, 1)->byte_stride;
+    u32  primitive_count = temp.total_primitive_count;
+    memset(get_instance_temp()->memory + mark, 0xcd, get_mark_temp() - mark);
+    reset_to_mark_temp(mark);
+
+    TEST_EQ("eager.node_count", gltf_node_get_count(&eager->gltf), node_count, false);
+    TEST_EQ("eager.accessors[1].byte_stride", gltf_accessor_by_index(&eager->gltf, 1)->byte_stride,
+            accessor_stride, false);
+    TEST_EQ("eager.total_primitive_count", eager->gltf.total_primitive_count, primitive_count, false);
+    TEST_STREQ("eager.buffers[0].uri", gltf_buffer_by_index(&eager->gltf, 0)->uri, "duck1.bin", false);
+
+    TEST_EQ("lazy.node_count", gltf_node_get_count(&lazy->gltf), node_count, false);
+    TEST_EQ("lazy.accessors[1].byte_stride", gltf_accessor_by_index(&lazy->gltf, 1)->byte_stride,
+            accessor_stride, false);
+    TEST_EQ("lazy.total_primitive_count",
+            (gltf_mesh_get_count(&lazy->gltf), lazy->gltf.total_primitive_count), primitive_count, false);
+    TEST_EQ("lazy_temp_untouched", get_mark_temp(), mark, false);
+    TEST_EQ("lazy_fits", lazy->arena.used <= lazy->arena.capacity, true, false);
+
+    gltf_document_free(eager);
+    gltf_document_free(lazy);
+    TEST_EQ("heap_untouched", get_instance_heap()->used, heap_used, false);
+    TEST_EQ("missing_file", gltf_document_create("test/missing.gltf", false) == NULL, true, false);
+
+    END_TEST_MODULE();
+}
+
+struct Test_Stream_Counts {
+    int  counts[GLTF_SECTION_COUNT];
+    bool in_order;
+    bool embedded;
+};
+static bool test_stream_callback(void *user_data, Gltf_Section section, int index, const void *element) {
+    Test_Stream_Counts *counts = (Test_Stream_Counts*)user_data;
+    counts->in_order &= index == counts->counts[section];
+    counts->counts[section]++;
+    if (section == GLTF_SECTION_BUFFERS)
+        counts->embedded |= ((const Gltf_Buffer*)element)->base64 != NULL;
+    return true;
+}
+
+static void test_stream() {
+    u64 heap_used = get_instance_heap()->used;
+    u64 mark      = get_mark_temp();
+    Gltf eager    = parse_gltf("test/test_gltf.gltf");
+
+    BEGIN_TEST_MODULE("Gltf_Stream", false, false);
+
+    Linear_Allocator output = {};
+    output.capacity = 64 * 1024;
+    output.memory   = malloc_h(output.capacity, 16);
+
+    // Small chunks, so that sections span many refills (the largest element in the test file is ~1.5KB).
+    Gltf_Stream_Info info = {};
+    info.chunk_size = 2048;
+    info.output     = &output;
+
+    Gltf stream;
+    TEST_EQ("result", parse_gltf_stream("test/test_gltf.gltf", &info, &stream), GLTF_STREAM_RESULT_SUCCESS, false);
+
+    TEST_EQ("accessor_count",  gltf_accessor_get_count(&stream),  gltf_accessor_get_count(&eager),  false);
+    TEST_EQ("animation_count", gltf_animation_get_count(&stream), gltf_animation_get_count(&eager), false);
+    TEST_EQ("buffer_view_count", gltf_buffer_view_get_count(&stream), gltf_buffer_view_get_count(&eager), false);
+    TEST_EQ("camera_count",    gltf_camera_get_count(&stream),    gltf_camera_get_count(&eager),    false);
+    TEST_EQ("image_count",     gltf_image_get_count(&stream),     gltf_image_get_count(&eager),     false);
+    TEST_EQ("material_count",  gltf_material_get_count(&stream),  gltf_material_get_count(&eager),  false);
+    TEST_EQ("mesh_count",      gltf_mesh_get_count(&stream),      gltf_mesh_get_count(&eager),      false);
+    TEST_EQ("node_count",      gltf_node_get_count(&stream),      gltf_node_get_count(&eager),      false);
+    TEST_EQ("sampler_count",   gltf_sampler_get_count(&stream),   gltf_sampler_get_count(&eager),   false);
+    TEST_EQ("scene_count",     gltf_scene_get_count(&stream),     gltf_scene_get_count(&eager),     false);
+    TEST_EQ("skin_count",      gltf_skin_get_count(&stream),      gltf_skin_get_count(&eager),      false);
+    TEST_EQ("texture_count",   gltf_texture_get_count(&stream),   gltf_texture_get_count(&eager),   false);
+    TEST_EQ("total_primitive_count", stream.total_primitive_count, eager.total_primitive_count, false);
+    TEST_EQ("scene", stream.scene, eager.scene, false);
+
+    TEST_EQ("accessors[1].byte_stride", gltf_accessor_by_index(&stream, 1)->byte_stride,
+            gltf_accessor_by_index(&eager, 1)->byte_stride, false);
+    TEST_EQ("accessors[2].count", gltf_accessor_by_index(&stream, 2)->count,
+            gltf_accessor_by_index(&eager, 2)->count, false);
+    TEST_EQ("skins[3].joint_count", gltf_skin_by_index(&stream, 3)->joint_count,
+            gltf_skin_by_index(&eager, 3)->joint_count, false);
+    TEST_EQ("nodes[6].mesh", gltf_node_by_index(&stream, 6)->mesh, gltf_node_by_index(&eager, 6)->mesh, false);
+    TEST_EQ("meshes[1].primitive_count", gltf_mesh_by_index(&stream, 1)->primitive_count,
+            gltf_mesh_by_index(&eager, 1)->primitive_count, false);
+    TEST_STREQ("images[2].uri", gltf_image_by_index(&stream, 2)->uri, gltf_image_by_index(&eager, 2)->uri, false);
+    TEST_STREQ("buffers[0].uri", gltf_buffer_by_index(&stream, 0)->uri, "duck1.bin", false);
+
+    // Callbacks only: nothing is kept, and temp is given back after every batch.
+    Test_Stream_Counts counts = {};
+    counts.in_order = true;
+    info.output     = NULL;
+    info.callback   = test_stream_callback;
+    info.user_data  = &counts;
+    u64 stream_mark = get_mark_temp();
+    TEST_EQ("callback_result", parse_gltf_stream("test/test_gltf.gltf", &info, NULL), GLTF_STREAM_RESULT_SUCCESS,
+            false);
+    TEST_EQ("callback_temp_reset", get_mark_temp(), stream_mark, false);
+    TEST_EQ("callback_in_order", counts.in_order, true, false);
+    TEST_EQ("callback_accessors", counts.counts[GLTF_SECTION_ACCESSORS], gltf_accessor_get_count(&eager), false);
+    TEST_EQ("callback_meshes",    counts.counts[GLTF_SECTION_MESHES],    gltf_mesh_get_count(&eager),     false);
+    TEST_EQ("callback_nodes",     counts.counts[GLTF_SECTION_NODES],     gltf_node_get_count(&eager),     false);
+    TEST_EQ("callback_textures",  counts.counts[GLTF_SECTION_TEXTURES],  gltf_texture_get_count(&eager),  false);
+
+    counts = {};
+    TEST_EQ("embedded_result", parse_gltf_stream("test/test_gltf_embedded.gltf", &info, NULL),
+            GLTF_STREAM_RESULT_SUCCESS, false);
+    TEST_EQ("embedded_in_callback", counts.embedded, true, false);
+
+    info.chunk_size = 64;
+    TEST_EQ("too_large", parse_gltf_stream("test/test_gltf.gltf", &info, NULL),
+            GLTF_STREAM_RESULT_ELEMENT_TOO_LARGE, false);
+    TEST_EQ("missing_file", parse_gltf_stream("test/no_such_file.gltf", &info, NULL),
+            GLTF_STREAM_RESULT_FILE_ERROR, false);
+
+    free_h(output.memory);
+    reset_to_mark_temp(mark);
+    TEST_EQ("heap_freed", get_instance_heap()->used, heap_used, false);
+
+    END_TEST_MODULE();
+}
+
+// Lay 'key' out as it would be in a file (closing quote, then more json) and match it.
+template<u32 N>
+static u32 test_match_key(const char *key, const Gltf_Key_Set<N> *set) {
+    char buf[64];
+    memset(buf, ' ', sizeof(buf));
+    u32 len = strlen(key);
+    memcpy(buf, key, len);
+    buf[len]     = '"';
+    buf[len + 1] = ':';
+    return gltf_match_key(buf, set);
+}
+
+static void test_key_sets() {
+    BEGIN_TEST_MODULE("Gltf_Key_Set", false, false);
+
+    const char *accessor_keys[] = {
+        "bufferView", "byteOffset", "count", "componentType", "type", "normalized", "sparse", "max", "min",
+    };
+    for(u32 i = 0; i < 9; ++i) {
+        TEST_EQ(accessor_keys[i], test_match_key(accessor_keys[i], &GLTF_ACCESSOR_KEYS), i, false);
+        TEST_EQ(accessor_keys[i], GLTF_ACCESSOR_KEYS.id(accessor_keys[i]), i, false);
+    }
+
+    // Prefixes, extensions and near misses of keys in the set must not match.
+    TEST_EQ("bufferViews", test_match_key("bufferViews", &GLTF_ACCESSOR_KEYS), GLTF_KEY_UNKNOWN, false);
+    TEST_EQ("bufferVie",   test_match_key("bufferVie",   &GLTF_ACCESSOR_KEYS), GLTF_KEY_UNKNOWN, false);
+    TEST_EQ("byteOffsex",  test_match_key("byteOffsex",  &GLTF_ACCESSOR_KEYS), GLTF_KEY_UNKNOWN, false);
+    TEST_EQ("mix",         test_match_key("mix",         &GLTF_ACCESSOR_KEYS), GLTF_KEY_UNKNOWN, false);
+    TEST_EQ("name",        test_match_key("name",        &GLTF_ACCESSOR_KEYS), GLTF_KEY_UNKNOWN, false);
+    TEST_EQ("empty",       test_match_key("",            &GLTF_ACCESSOR_KEYS), GLTF_KEY_UNKNOWN, false);
+    TEST_EQ("too_long", test_match_key("bufferViewbufferViewbufferViewbufferView", &GLTF_ACCESSOR_KEYS),
+            GLTF_KEY_UNKNOWN, false);
+
+    // Keys which only differ in their last bytes, and keys longer than 16 bytes.
+    TEST_EQ("byteLength", test_match_key("byteLength", &GLTF_BUFFER_VIEW_KEYS),
+            GLTF_BUFFER_VIEW_KEYS.id("byteLength"), false);
+    TEST_EQ("byteStride", test_match_key("byteStride", &GLTF_BUFFER_VIEW_KEYS),
+            GLTF_BUFFER_VIEW_KEYS.id("byteStride"), false);
+    TEST_EQ("metallicRoughnessTexture", test_match_key("metallicRoughnessTexture", &GLTF_PBR_METALLIC_ROUGHNESS_KEYS),
+            GLTF_PBR_METALLIC_ROUGHNESS_KEYS.id("metallicRoughnessTexture"), false);
+    TEST_EQ("metallicRoughnessTexturf", test_match_key("metallicRoughnessTexturf", &GLTF_PBR_METALLIC_ROUGHNESS_KEYS),
+            GLTF_KEY_UNKNOWN, false);
+    TEST_EQ("extensionsRequired", test_match_key("extensionsRequired", &GLTF_TOP_LEVEL_KEYS),
+            GLTF_TOP_LEVEL_KEYS.id("extensionsRequired"), false);
+
+    TEST_EQ("scenes", test_match_key("scenes", &GLTF_TOP_LEVEL_KEYS), GLTF_SECTION_SCENES, false);
+    TEST_EQ("scene",  test_match_key("scene",  &GLTF_TOP_LEVEL_KEYS), GLTF_TOP_LEVEL_KEYS.id("scene"), false);
+
+    END_TEST_MODULE();
 }
 
 static void test_accessors(Gltf_Accessor *accessor) {
@@ -2554,6 +3734,7 @@ void test_nodes(Gltf_Node *nodes) {
 
     Gltf_Node *node = nodes;
     TEST_EQ("nodes[0].camera", node->camera, 1, false);
+    TEST_EQ("nodes[0].has_matrix", node->has_matrix, 1, false);
 
     float inaccuracy =      0.0000001;
     TEST_FEQ("nodes[0].matrix[0]",  node->matrix.row0.x, -0.99975   , false);
@@ -2579,6 +3760,7 @@ void test_nodes(Gltf_Node *nodes) {
     TEST_FEQ("nodes[0].weights[3]", node->weights[3], 0.8, false);
 
     node = (Gltf_Node*)((u8*)node + node->stride);
+    TEST_EQ("nodes[1].has_matrix", node->has_matrix, 0, false);
     TEST_FEQ("nodes[1].rotation.x", node->trs.rotation.x, 0, false);
     TEST_FEQ("nodes[1].rotation.y", node->trs.rotation.y, 0, false);
     TEST_FEQ("nodes[1].rotation.z", node->trs.rotation.z, 0, false);
@@ -2597,6 +3779,8 @@ void test_nodes(Gltf_Node *nodes) {
     TEST_EQ("nodes[2].children[1]", node->children[1], 2, false);
     TEST_EQ("nodes[2].children[2]", node->children[2], 3, false);
     TEST_EQ("nodes[2].children[3]", node->children[3], 4, false);
+    TEST_FEQ("nodes[2].rotation.w", node->trs.rotation.w, 1, false);
+    TEST_FEQ("nodes[2].scale.x",    node->trs.scale.x,    1, false);
 
 
     END_TEST_MODULE();
@@ -2706,6 +3890,123 @@ void test_textures(Gltf_Texture *textures) {
 }
 #endif
 
+#if BENCH
+// The accessor key chain as it was before key sets, to benchmark against.
+static u32 bench_match_accessor_key_chain(const char *data) {
+    if (simd_strcmp_short(data, "bufferViewxxxxxx",  6) == 0)
+        return 0;
+    else if (simd_strcmp_short(data, "byteOffsetxxxxxx",  6) == 0)
+        return 1;
+    else if (simd_strcmp_short(data, "countxxxxxxxxxxx", 11) == 0)
+        return 2;
+    else if (simd_strcmp_short(data, "componentTypexxx",  3) == 0)
+        return 3;
+    else if (simd_strcmp_short(data, "typexxxxxxxxxxxx", 12) == 0)
+        return 4;
+    else if (simd_strcmp_short(data, "normalizedxxxxxx", 6) == 0)
+        return 5;
+    else if (simd_strcmp_short(data, "sparsexxxxxxxxxx", 10) == 0)
+        return 6;
+    else if (simd_strcmp_short(data, "maxxxxxxxxxxxxxx", 13) == 0)
+        return 7;
+    else if (simd_strcmp_short(data, "minxxxxxxxxxxxxx", 13) == 0)
+        return 8;
+    return GLTF_KEY_UNKNOWN;
+}
+
+// Accessor heavy gltf text: 'count' accessors with the keys exporters usually write, in their usual order.
+static char* bench_make_accessor_gltf(u32 count, u64 *size) {
+    const u64 max_accessor_size = 256;
+    char *data = (char*)malloc_h(64 + count * max_accessor_size + 16, 16);
+
+    u64 pos = stbsp_sprintf(data, "{\n\"asset\":{\"version\":\"2.0\"},\n\"accessors\":[\n");
+    for(u32 i = 0; i < count; ++i) {
+        pos += stbsp_sprintf(data + pos,
+            "{\"bufferView\":%u,\"byteOffset\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\","
+            "\"normalized\":false,\"max\":[1.0,%u.5,1.0],\"min\":[-1.0,-%u.5,-1.0]}%s\n",
+            i & 63, i * 12, 3 + (i & 1023), i & 7, i & 7, i + 1 == count ? "" : ",");
+    }
+    pos += stbsp_sprintf(data + pos, "]\n}\n");
+    memset(data + pos, 0, 16);
+    *size = pos;
+    return data;
+}
+
+void bench_gltf() {
+    BENCH_MODULE("Gltf");
+
+    const u32 accessor_count = 20000;
+    u64 size;
+    char *data = bench_make_accessor_gltf(accessor_count, &size);
+
+    // Every key in the file, as the parser would see them.
+    u32 key_count = 0;
+    const char **keys = (const char**)malloc_h(sizeof(const char*) * (accessor_count * 8 + 8), 8);
+    for(u64 i = 2; i < size; ++i)
+        if (data[i - 1] == '"' && (data[i - 2] == '{' || data[i - 2] == ','))
+            keys[key_count++] = data + i;
+
+    const u32 iterations = 50;
+    u64 ns;
+    u64 accum;
+    Bench_Timer timer;
+
+    // In file order the chain's branches are as predictable as exporters are consistent, shuffled they are not.
+    const char *names[][2] = {
+        {"accessor keys in file order, if chain", "accessor keys in file order, perfect hash"},
+        {"accessor keys shuffled, if chain",      "accessor keys shuffled, perfect hash"},
+    };
+    for(u32 order = 0; order < 2; ++order) {
+        if (order == 1) {
+            u64 rand = 0x2545f4914f6cdd1d;
+            for(u32 i = key_count - 1; i > 0; --i) { // xorshift, fisher yates
+                rand ^= rand << 13;
+                rand ^= rand >> 7;
+                rand ^= rand << 17;
+                u32 j = rand % (i + 1);
+                const char *tmp = keys[i];
+                keys[i] = keys[j];
+                keys[j] = tmp;
+            }
+        }
+
+        accum = 0;
+        timer = begin_bench();
+        for(u32 j = 0; j < iterations; ++j)
+            for(u32 i = 0; i < key_count; ++i)
+                accum += bench_match_accessor_key_chain(keys[i]);
+        ns = end_bench(&timer);
+        bench_keep(accum);
+        bench_report(names[order][0], ns, (u64)key_count * iterations);
+
+        accum = 0;
+        timer = begin_bench();
+        for(u32 j = 0; j < iterations; ++j)
+            for(u32 i = 0; i < key_count; ++i)
+                accum += gltf_match_key(keys[i], &GLTF_ACCESSOR_KEYS);
+        ns = end_bench(&timer);
+        bench_keep(accum);
+        bench_report(names[order][1], ns, (u64)key_count * iterations);
+    }
+
+    // Whole file.
+    u64 mark = get_mark_temp();
+    Gltf gltf;
+    timer = begin_bench();
+    for(u32 j = 0; j < iterations; ++j) {
+        gltf = gltf_parse_top_level(data, NULL, false);
+        bench_keep(gltf.accessors);
+        reset_to_mark_temp(mark);
+    }
+    ns = end_bench(&timer);
+    bench_report_throughput("parse accessor heavy gltf", ns, size, iterations);
+    bench_report_rate("parse accessor heavy gltf", "accessors", ns, (u64)accessor_count * iterations);
+
+    free_h(keys);
+    free_h(data);
+}
+#endif // BENCH
+
 // This file is gltf file parser. It reads a gltf file and turns the information into usable C++.
 // It does so in a potentially unorthodox way, in the interest of consistency, simplicity, speed and code size.
 // There are not more general helper functions such as "find_key(..)". The reason for this is that for functions
@@ -4,6 +4,7 @@
 #include "basic.h"
 #include "string.hpp"
 #include "math.hpp"
+#include "simd.hpp"
 
 /*
     After using the gltf parser for a bit, I think I should go back and revert the parser
@@ -179,16 +180,48 @@ struct Gltf_Animation {
     Gltf_Animation_Sampler *samplers;
 };
 
+// Embedded data ('data:<mime>;base64,<payload>' uris) is not copied by the parser: 'base64' points straight at the
+// payload in the file text and 'uri' is null. The file text lives in the temp allocator alongside the rest of the
+// Gltf struct, so the pointer is valid for exactly as long as the struct is.
 struct Gltf_Buffer {
     int stride; // accounts for the length of the uri string
+    int meshopt_fallback; // @BoolsInStructs EXT_meshopt_compression fallback buffer, has no data, do not load it
     u64 byte_length;
     char *uri;
+    const char *base64;
+    u64 base64_len;
 };
 
 enum Gltf_Buffer_Type {
     GLTF_BUFFER_TYPE_ARRAY_BUFFER         = 34962,
     GLTF_BUFFER_TYPE_ELEMENT_ARRAY_BUFFER = 34963,
 };
+
+// EXT_meshopt_compression
+enum Gltf_Meshopt_Mode {
+    GLTF_MESHOPT_MODE_NONE       = 0, // buffer view is not compressed
+    GLTF_MESHOPT_MODE_ATTRIBUTES = 1,
+    GLTF_MESHOPT_MODE_TRIANGLES  = 2,
+    GLTF_MESHOPT_MODE_INDICES    = 3,
+};
+enum Gltf_Meshopt_Filter {
+    GLTF_MESHOPT_FILTER_NONE        = 0,
+    GLTF_MESHOPT_FILTER_OCTAHEDRAL  = 1,
+    GLTF_MESHOPT_FILTER_QUATERNION  = 2,
+    GLTF_MESHOPT_FILTER_EXPONENTIAL = 3,
+};
+// The compressed data lives in 'buffer' at 'byte_offset'. The view's own buffer/byte_offset/byte_length describe
+// where the decoded data goes, and that buffer is normally a fallback buffer with no uri (see Gltf_Buffer).
+struct Gltf_Meshopt_Compression {
+    Gltf_Meshopt_Mode   mode;
+    Gltf_Meshopt_Filter filter;
+    int buffer;
+    int byte_stride;
+    u32 count;
+    u64 byte_offset;
+    u64 byte_length;
+};
+
 struct Gltf_Buffer_View {
     int stride;
 
@@ -197,6 +230,8 @@ struct Gltf_Buffer_View {
     Gltf_Buffer_Type buffer_type; // I think I dont need this for vulkan, it seems OpenGL specific...
     u64 byte_offset;
     u64 byte_length;
+
+    Gltf_Meshopt_Compression meshopt;
 };
 
 struct Gltf_Camera {
@@ -213,6 +248,8 @@ struct Gltf_Image {
     int jpeg; // @BoolsInStructs int for bool, alignment
     int buffer_view;
     char *uri;
+    const char *base64; // See Gltf_Buffer
+    u64 base64_len;
 };
 
 enum Gltf_Alpha_Mode {
@@ -322,6 +359,7 @@ struct Gltf_Node {
     int mesh;
     int child_count;
     int weight_count;
+    int has_matrix; // @BoolsInStructs 'matrix' is set rather than 'trs'
 
     union {
         Gltf_Trs trs;
@@ -361,8 +399,8 @@ struct Gltf_Scene {
 
 struct Gltf_Skin {
     int stride;
-    int inverse_bind_matrices;
-    int skeleton;
+    int inverse_bind_matrices = -1; // -1 if absent (identity matrices)
+    int skeleton = -1;
     int joint_count;
     int *joints;
 };
@@ -373,6 +411,24 @@ struct Gltf_Texture {
     int source_image;
 };
 
+// Top level arrays, in the order of the fields in Gltf.
+enum Gltf_Section {
+    GLTF_SECTION_ACCESSORS    = 0,
+    GLTF_SECTION_ANIMATIONS   = 1,
+    GLTF_SECTION_BUFFERS      = 2,
+    GLTF_SECTION_BUFFER_VIEWS = 3,
+    GLTF_SECTION_CAMERAS      = 4,
+    GLTF_SECTION_IMAGES       = 5,
+    GLTF_SECTION_MATERIALS    = 6,
+    GLTF_SECTION_MESHES       = 7,
+    GLTF_SECTION_NODES        = 8,
+    GLTF_SECTION_SAMPLERS     = 9,
+    GLTF_SECTION_SCENES       = 10,
+    GLTF_SECTION_SKINS        = 11,
+    GLTF_SECTION_TEXTURES     = 12,
+    GLTF_SECTION_COUNT        = 13,
+};
+
 struct Gltf {
     // Each arrayed field has a 'stride' member, which is the byte count required to reach
     // the next array member;
@@ -380,7 +436,17 @@ struct Gltf {
     // All strides can be calculated from the other info in the struct, but some of these algorithms
     // are weird and incur unclear overhead. So for consistency's sake they will just be included,
     // regardless of the ease with which the strides can be calculated.
-    u32 total_primitive_count;
+    u32 total_primitive_count; // Lazy: only valid once the meshes section has been parsed.
+
+    // Lazy parsing: the file text, where each top level array's key is in it, and a bit per Gltf_Section
+    // which has been found but not yet parsed. Streamed gltfs have no text.
+    const char *data;
+    u64 data_size;
+    u32 unparsed_sections;
+    u64 section_offsets[GLTF_SECTION_COUNT];
+
+    Linear_Allocator *arena; // What the sections were parsed into: NULL is the temp allocator, else see Gltf_Document
+    u64 temp_mark;           // With no arena, the temp mark after parse_gltf_lazy(..) read the text, see below
 
     int scene;
     int *accessor_count;
@@ -410,7 +476,73 @@ struct Gltf {
     Gltf_Skin *skins;
     Gltf_Texture *textures;
 };
-Gltf parse_gltf(const char *file_name);
+Gltf parse_gltf(const char *file_name); // 'data' is NULL if the file could not be read
+
+//
+// Lazy parse: one quick pass over the file which only records where each top level array is. A section is
+// parsed the first time that a gltf_*_by_index(..)/gltf_*_get_count(..) function for it is called, so only
+// what the caller touches is paid for (a static mesh never parses its animations, skins, nodes etc.).
+//
+// @Note The arrays in Gltf (gltf.meshes etc.) are only valid once their section has been touched, so call the
+// section's get_count(..) before walking an array directly. Sections are parsed into the temp allocator, same
+// as parse_gltf(..), so a touch after the temp allocator is reset is a use after free. gltf_parse_section(..)
+// asserts that the temp allocator has not been reset to below where it was after the text was read.
+//
+Gltf parse_gltf_lazy(const char *file_name); // 'data' is NULL if the file could not be read
+void gltf_parse_section(Gltf *gltf, Gltf_Section section); // force a lazy section to be parsed now
+
+//
+// A Gltf which owns its memory, rather than living in the temp allocator: the file text, and the parsed sections in
+// an arena sized up front from a quick count over the text (see the .cpp). Both come from malloc, not the instance
+// heap, so a document can be created and freed on any thread (e.g. parsed ahead of time on a loader thread) and is
+// valid until gltf_document_free(..).
+//
+// Lazy documents parse touched sections into the same arena. The document is heap allocated so that the
+// Gltf's arena pointer stays valid; do not copy 'gltf' out if it is lazy.
+//
+struct Gltf_Document {
+    Gltf gltf;
+    Linear_Allocator arena;
+    const char *text;
+    u64 text_size;
+};
+Gltf_Document* gltf_document_create(const char *file_name, bool lazy); // NULL if the file could not be read or allocated
+void gltf_document_free(Gltf_Document *document);
+
+//
+// Streaming parse, for files which are too big to read in one go: the file is read 'chunk_size' bytes at a time
+// into one window (plus the 16 bytes of padding which the simd helpers read over), and the elements of each top
+// level array are parsed as soon as they are complete in the window. The unparsed tail is moved to the front of
+// the window before the next read, so peak memory is the chunk plus the output.
+//
+// Elements are given to 'callback' in file order. With 'output' set they are also kept there, and the Gltf is
+// filled in as by parse_gltf(..). Without it they are parsed into the temp allocator, which is reset to where it
+// was after every batch of callbacks, so the callback must copy out anything it wants to keep.
+//
+// @Note Every element (and every top level value which is not an array) must fit in a chunk. Embedded (base64)
+// buffers and images point into the window, so they are only valid inside the callback; kept elements have them
+// set to NULL. Without 'output', accessors are not patched with their buffer view's byte stride.
+//
+enum Gltf_Stream_Result {
+    GLTF_STREAM_RESULT_SUCCESS           = 0,
+    GLTF_STREAM_RESULT_FILE_ERROR        = 1,
+    GLTF_STREAM_RESULT_MALFORMED         = 2,
+    GLTF_STREAM_RESULT_ELEMENT_TOO_LARGE = 3,
+    GLTF_STREAM_RESULT_CANCELLED         = 4, // callback returned false
+};
+
+// 'element' is the section's type (Gltf_Accessor, Gltf_Node etc.), and 'index' is its index in the section.
+// Return false to stop parsing.
+typedef bool (*Gltf_Stream_Callback)(void *user_data, Gltf_Section section, int index, const void *element);
+
+struct Gltf_Stream_Info {
+    u64 chunk_size;
+    Gltf_Stream_Callback callback; // optional with 'output'
+    void *user_data;
+    Linear_Allocator *output;      // optional
+};
+// 'gltf' can be NULL without 'output'.
+Gltf_Stream_Result parse_gltf_stream(const char *file_name, const Gltf_Stream_Info *info, Gltf *gltf);
 
 Gltf_Accessor* gltf_accessor_by_index(Gltf *gltf, int i);
 Gltf_Animation* gltf_animation_by_index(Gltf *gltf, int i);
@@ -440,8 +572,27 @@ int gltf_scene_get_count(Gltf *gltf);
 int gltf_skin_get_count(Gltf *gltf);
 int gltf_texture_get_count(Gltf *gltf);
 
+// Decode an embedded buffer into 'dst', which must have room for 'byte_length' bytes. Returns false, with nothing
+// written, if the payload does not decode to 'byte_length' bytes, or false if it is not valid base64.
+inline static bool gltf_buffer_decode_base64(const Gltf_Buffer *buffer, u8 *dst) {
+    if (base64_get_decoded_size(buffer->base64, buffer->base64_len) != buffer->byte_length)
+        return false;
+    u64 size;
+    return simd_base64_decode(buffer->base64, buffer->base64_len, dst, &size);
+}
+inline static u64 gltf_image_get_base64_decoded_size(const Gltf_Image *image) {
+    return base64_get_decoded_size(image->base64, image->base64_len);
+}
+inline static bool gltf_image_decode_base64(const Gltf_Image *image, u8 *dst, u64 *size) {
+    return simd_base64_decode(image->base64, image->base64_len, dst, size);
+}
+
 #if TEST
     void test_gltf();
 #endif
 
+#if BENCH
+    void bench_gltf();
+#endif
+
 #endif // include guard
@@ -2418,6 +2418,17 @@ Gpu_Allocator_Result create_allocator(Gpu_Allocator_Config *config, Gpu_Allocato
     memset(ret.allocation_states,   0, sizeof(u8) * allocation_cap);
     memset(ret.allocation_weights,  0, sizeof(u8) * allocation_cap);
 
+    // At most half full, so probes stay short.
+    u32 hash_table_size = 16;
+    while(hash_table_size < allocation_cap * 2)
+        hash_table_size <<= 1;
+
+    ret.allocation_hashes = (Hash_128*) malloc_h(sizeof(Hash_128) * allocation_cap,  16);
+    ret.hash_table        =      (u32*) malloc_h(sizeof(u32)      * hash_table_size, 16);
+    ret.hash_table_mask   = hash_table_size - 1;
+
+    memset(ret.hash_table, 0, sizeof(u32) * hash_table_size);
+
     ret.stage_mask_count  = config->stage_cap  / (64 * ret.stage_bit_granularity);
     ret.upload_mask_count = config->upload_cap / (64 * ret.upload_bit_granularity);
 
@@ -2462,6 +2473,9 @@ Gpu_Allocator_Result create_allocator(Gpu_Allocator_Config *config, Gpu_Allocato
     total_memory_footprint += align(sizeof(Allocation_State_Flags) * ret.allocation_cap,    16);
     total_memory_footprint += align(sizeof(u32)                    * ret.allocation_cap,    16);
     total_memory_footprint += align(sizeof(u32)                    * ret.allocation_cap,    16);
+    total_memory_footprint += align(sizeof(Hash_128)               * ret.allocation_cap,    16);
+    total_memory_footprint += align(sizeof(u32)                    * ret.allocation_cap,    16);
+    total_memory_footprint += align(sizeof(u32)                    * hash_table_size,       16);
 
     println("Allocator Memory Footprint (file name: %s):", ret.disk_storage.str);
     println("        %u stage_masks: %u",ret.stage_mask_count , align(sizeof(u64)                    * ret.stage_mask_count,  16));
@@ -2470,6 +2484,9 @@ Gpu_Allocator_Result create_allocator(Gpu_Allocator_Config *config, Gpu_Allocato
     println("  %u allocation_states: %u",ret.allocation_cap   , align(sizeof(Allocation_State_Flags) * ret.allocation_cap,    16));
     println(" %u allocation_indices: %u",ret.allocation_cap   , align(sizeof(u32)                    * ret.allocation_cap,    16));
     println(" %u allocation_weights: %u",ret.allocation_cap   , align(sizeof(u8)                     * ret.allocation_cap,    16));
+    println("  %u allocation_hashes: %u",ret.allocation_cap   , align(sizeof(Hash_128)               * ret.allocation_cap,    16));
+    println("   %u allocation_refs: %u",ret.allocation_cap   , align(sizeof(u32)                    * ret.allocation_cap,    16));
+    println("         %u hash_table: %u",hash_table_size      , align(sizeof(u32)                    * hash_table_size,       16));
     println(" total footprint = %u", total_memory_footprint);
     #endif
 
@@ -2488,6 +2505,8 @@ void destroy_allocator(Gpu_Allocator *alloc) {
     free_h(alloc->allocation_states);
     free_h(alloc->allocation_indices);
     free_h(alloc->allocation_weights);
+    free_h(alloc->allocation_hashes);
+    free_h(alloc->hash_table);
     free_h(alloc->stage_masks);
     free_h(alloc->upload_masks);
 
@@ -2701,7 +2720,7 @@ Gpu_Allocator_Result begin_allocation(Gpu_Allocator *alloc) {
     return GPU_ALLOCATOR_RESULT_SUCCESS;
 }
 
-Gpu_Allocator_Result continue_allocation(Gpu_Allocator *alloc, u64 size, void *ptr) {
+Gpu_Allocator_Result continue_allocation_in_place(Gpu_Allocator *alloc, u64 size, void **ptr) {
 
     alloc->allocations[alloc->allocation_count].size += size;
 
@@ -2715,17 +2734,57 @@ Gpu_Allocator_Result continue_allocation(Gpu_Allocator *alloc, u64 size, void *p
     }
 
     // Use the staging queue as temp storage while adding allocations to the allocator
-    memcpy((u8*)alloc->stage_ptr + alloc->staging_queue_byte_count, ptr, size);
+    *ptr = (u8*)alloc->stage_ptr + alloc->staging_queue_byte_count;
     alloc->staging_queue_byte_count += size;
 
     return GPU_ALLOCATOR_RESULT_SUCCESS;
 }
 
+Gpu_Allocator_Result continue_allocation(Gpu_Allocator *alloc, u64 size, void *ptr) {
+    void *stage;
+    Gpu_Allocator_Result result = continue_allocation_in_place(alloc, size, &stage);
+    if (result != GPU_ALLOCATOR_RESULT_SUCCESS)
+        return result;
+
+    memcpy(stage, ptr, size);
+    return GPU_ALLOCATOR_RESULT_SUCCESS;
+}
+
+// The slot holding the key of the allocation with this hash and size, else the empty slot where it would go.
+static u32 find_allocation_hash_slot(Gpu_Allocator *alloc, Hash_128 hash, u64 size) {
+    u32 slot = (u32)hash.lo & alloc->hash_table_mask;
+    u32 key;
+    while(alloc->hash_table[slot]) {
+        key = alloc->hash_table[slot] - 1;
+        if (alloc->allocation_hashes[key] == hash && alloc->allocations[alloc->allocation_indices[key]].size == size)
+            break;
+        slot = (slot + 1) & alloc->hash_table_mask;
+    }
+    return slot;
+}
+
 Gpu_Allocator_Result submit_allocation(Gpu_Allocator *alloc, u32 *key) {
     u32  allocation_count              = alloc->allocation_count;
     Gpu_Allocation *allocations        = alloc->allocations;
     Gpu_Allocation_State_Flags *states = alloc->allocation_states;
 
+    // The allocation is still whole in the stage. If the same bytes were submitted before (the same model loaded
+    // twice, or models sharing geometry) hand back that allocation, and drop this one: it is never written to disk
+    // or counted, so begin_allocation(..) reuses its slot.
+    Hash_128 hash = hash_bytes_128(alloc->stage_ptr, allocations[allocation_count].size);
+    u32      slot = find_allocation_hash_slot(alloc, hash, allocations[allocation_count].size);
+    if (alloc->hash_table[slot]) {
+        *key = alloc->hash_table[slot] - 1;
+        alloc->dedup_count++;
+        alloc->dedup_byte_count += allocations[allocation_count].size;
+
+        alloc->staging_queue_byte_count = Max_u64;
+        alloc->to_stage_count           = Max_u32;
+        return GPU_ALLOCATOR_RESULT_SUCCESS;
+    }
+    alloc->hash_table[slot]                        = allocation_count + 1;
+    alloc->allocation_hashes[allocation_count] = hash;
+
     // Write total allocation to disk for faster reloading.
     fwrite(alloc->stage_ptr, 1, allocations[allocation_count].size, alloc->disk);
 
@@ -2749,6 +2808,13 @@ Gpu_Allocator_Result submit_allocation(Gpu_Allocator *alloc, u32 *key) {
     return GPU_ALLOCATOR_RESULT_SUCCESS;
 }
 
+// Nothing of the allocation in progress has been written to disk or counted, so its slot is just reused by the next
+// begin_allocation(..), the same as a deduplicated submit.
+void cancel_allocation(Gpu_Allocator *alloc) {
+    alloc->staging_queue_byte_count = Max_u64;
+    alloc->to_stage_count           = Max_u32;
+}
+
 Gpu_Allocator_Result staging_queue_begin(Gpu_Allocator *alloc) {
     if (alloc->disk) { // Close the file: using the queue indicates allocation adding phase is complete.
         fclose(alloc->disk);
@@ -4616,20 +4682,23 @@ static void pl_get_vertex_input_and_assembly(
     VkVertexInputAttributeDescription *attributes =
         (VkVertexInputAttributeDescription*)malloc_t(sizeof(VkVertexInputAttributeDescription) * info->count, 8);
 
-    // @Note Offsets are set at bind time, as the allocation may not be uploaded yet.
+    // @Note Buffer offsets are set at bind time, as the allocation may not be uploaded yet.
     // Idk if this is less efficient than enforcing pipeline creation after allocation upload,
     // But that seems much worse, as then the upload cannot be part of the draw command.
-    for(u32 i = 0; i < info->count; ++i) {
+    u32 binding_count = info->offsets ? 1 : info->count;
+    for(u32 i = 0; i < binding_count; ++i) {
         bindings[i].binding = i;
         bindings[i].stride  = info->strides[i];
-
+    }
+    for(u32 i = 0; i < info->count; ++i) {
         attributes[i].format   = info->formats[i];
         attributes[i].location = i;
-        attributes[i].binding  = i;
+        attributes[i].binding  = info->offsets ? 0 : i;
+        attributes[i].offset   = info->offsets ? info->offsets[i] : 0;
     }
 
    *ret_input_info = {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-    ret_input_info->vertexBindingDescriptionCount   = info->count;
+    ret_input_info->vertexBindingDescriptionCount   = binding_count;
     ret_input_info->pVertexBindingDescriptions      = bindings;
     ret_input_info->vertexAttributeDescriptionCount = info->count;
     ret_input_info->pVertexAttributeDescriptions    = attributes;
@@ -259,10 +259,18 @@ void pl_store_cache();
         - Copies data from ptr into its internal storage.
         - Returns STAGE_FULL if the allocation is larger than the internal stage cap.
         - Returns UPLOAD_FULL if the allocation is larger than the internal upload cap.
+    continue_allocation_in_place(u64 size, void **ptr) same as continue_allocation, but no copy:
+        - Writes to 'ptr' the 'size' bytes of internal storage reserved for the caller to fill, so data
+          which has to be decoded (e.g. meshopt compressed buffer views) is decoded straight into the stage.
+        - The storage is only valid until submit_allocation is called.
     submit_allocation(u8 weight, u32 *key) complete an allocation:
         - Writes to 'key' the identifier for the allocation.
         - Weight is used to set a priority for the allocation. This effects how likely the allocation
           is to be in memory at any given time.
+        - If the allocation's bytes match an earlier allocation's (same size and 128 bit content hash),
+          writes that allocation's key instead: the duplicate takes no disk, stage or upload space. Nothing
+          counts the keys handed out, as allocations are never freed (the disk storage only grows), so a
+          shared allocation lives as long as the allocator, the same as any other.
 
     ********************************************************************************************************
     * THE ABOVE FUNCTIONS MUST NOT BE CALLED AFTER ANY OF THE BELOW FUNCTIONS. ADDING ALLOCATIONS/TEXTURES *
@@ -323,6 +331,7 @@ enum Gpu_Allocator_Result {
     GPU_ALLOCATOR_RESULT_BIND_IMAGE_FAIL            = 6,
     GPU_ALLOCATOR_RESULT_MISALIGNED_BIT_GRANULARITY = 7,
     GPU_ALLOCATOR_RESULT_ALLOCATION_TOO_LARGE       = 8,
+    GPU_ALLOCATOR_RESULT_INVALID_DATA               = 9, // The data to allocate could not be decoded
 };
 
 // @Todo This should be debug only.
@@ -351,6 +360,9 @@ inline static void CHECK_GPU_ALLOCATOR_RESULT(Gpu_Allocator_Result res) {
     case GPU_ALLOCATOR_RESULT_ALLOCATION_TOO_LARGE:
         assert(false && "GPU_ALLOCATOR_RESULT_ALLOCATION_TOO_LARGE");
         break;
+    case GPU_ALLOCATOR_RESULT_INVALID_DATA:
+        assert(false && "GPU_ALLOCATOR_RESULT_INVALID_DATA");
+        break;
     default:
         break;
     }
@@ -380,6 +392,14 @@ struct Gpu_Allocator {
     Gpu_Allocation             *allocations;
     Gpu_Allocation_State_Flags *allocation_states;
 
+    // Content dedup for submit_allocation(..). Hashes are indexed by key. The table is open addressed (linear
+    // probing) on the hash's low bits, and holds key + 1 (0 is empty).
+    Hash_128 *allocation_hashes;
+    u32      *hash_table;
+    u32       hash_table_mask;
+    u32       dedup_count;      // Submissions which were duplicates
+    u64       dedup_byte_count; // Bytes those submissions did not add
+
     u32  stage_bit_granularity;
     u32  upload_bit_granularity;
     u32  stage_mask_count;
@@ -435,7 +455,9 @@ void                 destroy_allocator(Gpu_Allocator *alloc);
 
 Gpu_Allocator_Result begin_allocation    (Gpu_Allocator *alloc);
 Gpu_Allocator_Result continue_allocation (Gpu_Allocator *alloc, u64 size, void *ptr);
+Gpu_Allocator_Result continue_allocation_in_place(Gpu_Allocator *alloc, u64 size, void **ptr);
 Gpu_Allocator_Result submit_allocation   (Gpu_Allocator *alloc, u32 *key);
+void                 cancel_allocation   (Gpu_Allocator *alloc); // Drop the allocation in progress
 
 Gpu_Allocator_Result staging_queue_begin (Gpu_Allocator *alloc);
 Gpu_Allocator_Result staging_queue_add   (Gpu_Allocator *alloc, u32 key, bool adjust_weights);
@@ -1009,9 +1031,10 @@ enum Pl_Config_Flag_Bits {
 };
 typedef u32 Pl_Config_Flags;
 
-struct Pl_Primitive_Info { // 4 + 4 + 8 + 8 = 24 bytes
+struct Pl_Primitive_Info { // 8 + 8 + 8 + 4 + 4 = 32 bytes
     u32                 *strides;
     VkFormat            *formats;
+    u32                 *offsets; // NULL: each attribute is its own binding. Else every attribute is in binding 0 (stride strides[0]) at offsets[i].
     VkPrimitiveTopology  topology;
     u32                  count;
 };
@@ -43,6 +43,18 @@ inline uint64_t hash_bytes(void *data, size_t len, size_t seed = 0) {
     return wyhash(data, len, seed, _wyp);
 }
 
+// For identifying data by its contents, where a 64 bit collision would be a bug rather than a probe: two wyhash
+// lanes with unrelated seeds. The second pass reads data the first just brought into cache.
+struct Hash_128 {
+    u64 lo;
+    u64 hi;
+};
+inline bool operator==(const Hash_128 &a, const Hash_128 &b) { return a.lo == b.lo && a.hi == b.hi; }
+
+inline Hash_128 hash_bytes_128(const void *data, size_t len) {
+    return {.lo = wyhash(data, len, 0, _wyp), .hi = wyhash(data, len, 0x9e3779b97f4a7c15ull ^ len, _wyp)};
+}
+
 inline void checked_mul(size_t &res, size_t mul) {
     assert(UINT64_MAX / res > mul && "u64 checked mul overflow");
     res = res * mul;
@@ -0,0 +1,289 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "job.hpp"
+#include "allocator.hpp"
+#include "assert.h"
+
+#if TEST
+    #include "test.hpp"
+#endif
+
+static constexpr u32 JOB_MAX_THREAD_COUNT = 32;
+
+//
+// One mutex guards all of the scheduling state: jobs are expected to be coarse (a model, a range of primitives,
+// a subtree) so a list is tens to hundreds of jobs, and the lock is only held to pop a job or to mark one finished.
+// Workers sleep on 'wake' until there is a ready job they are allowed to take; the calling thread sleeps on 'done'
+// until a job finishes or becomes ready.
+//
+struct Job_Pool {
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::thread             workers[JOB_MAX_THREAD_COUNT];
+
+    u32  worker_count;
+    u32  thread_limit; // Workers with an index >= thread_limit - 1 take no jobs
+    bool quit;
+
+    // The list being run
+    const Job *jobs;
+    u32       *wait_counts; // Counted down as dependencies finish
+    u32       *ready;       // Stack of job indices whose wait count is zero
+    u32        ready_count;
+    u32        running_count;
+    u32        finished_count;
+};
+static Job_Pool s_job_pool;
+
+// Mutex held. Returns the number of jobs made ready.
+static u32 job_pool_finish(Job_Pool *pool, u32 idx) {
+    const Job *job = &pool->jobs[idx];
+
+    u32 dependent;
+    u32 ready_count = 0;
+    for(u32 i = 0; i < job->dependent_count; ++i) {
+        dependent = job->dependents[i];
+        assert(pool->wait_counts[dependent] && "Job has more dependencies than its wait count");
+
+        pool->wait_counts[dependent]--;
+        if (pool->wait_counts[dependent] == 0) {
+            pool->ready[pool->ready_count++] = dependent;
+            ready_count++;
+        }
+    }
+    pool->running_count--;
+    pool->finished_count++;
+
+    return ready_count;
+}
+
+// Mutex held.
+static void job_pool_wake(Job_Pool *pool, u32 ready_count) {
+    if (ready_count > 1 || (ready_count && pool->worker_count))
+        pool->wake.notify_all();
+    pool->done.notify_one();
+}
+
+static void job_worker(u32 worker_index) {
+    Job_Pool *pool = &s_job_pool;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    u32 idx;
+    Job job;
+    while(true) {
+        while(!pool->quit && !(pool->ready_count && worker_index + 1 < pool->thread_limit))
+            pool->wake.wait(lock);
+        if (pool->quit)
+            return;
+
+        idx = pool->ready[--pool->ready_count];
+        job = pool->jobs[idx];
+        pool->running_count++;
+
+        lock.unlock();
+        job.func(job.arg);
+        lock.lock();
+
+        job_pool_wake(pool, job_pool_finish(pool, idx));
+    }
+}
+
+void init_jobs(u32 thread_count) {
+    Job_Pool *pool = &s_job_pool;
+    assert(pool->worker_count == 0 && "Job pool already initialized");
+    assert(thread_count && thread_count <= JOB_MAX_THREAD_COUNT && "Unsupported job thread count");
+
+    pool->quit         = false;
+    pool->worker_count = thread_count - 1;
+    pool->thread_limit = thread_count;
+    for(u32 i = 0; i < pool->worker_count; ++i)
+        pool->workers[i] = std::thread(job_worker, i);
+}
+
+void kill_jobs() {
+    Job_Pool *pool = &s_job_pool;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->quit = true;
+    }
+    pool->wake.notify_all();
+
+    for(u32 i = 0; i < pool->worker_count; ++i)
+        pool->workers[i].join();
+
+    pool->worker_count = 0;
+    pool->thread_limit = 0;
+    pool->quit         = false;
+}
+
+void set_job_thread_limit(u32 thread_count) {
+    Job_Pool *pool = &s_job_pool;
+    std::lock_guard<std::mutex> lock(pool->mutex);
+
+    thread_count       = thread_count ? thread_count : 1;
+    pool->thread_limit = thread_count > pool->worker_count + 1 ? pool->worker_count + 1 : thread_count;
+}
+
+u32 get_job_thread_count() {
+    return s_job_pool.worker_count + 1;
+}
+
+void run_jobs(u32 count, const Job *jobs) {
+    if (!count)
+        return;
+
+    Job_Pool *pool = &s_job_pool;
+    u64 mark = get_mark_temp();
+
+    u32 *wait_counts = (u32*)malloc_t(sizeof(u32) * count, 4);
+    u32 *ready       = (u32*)malloc_t(sizeof(u32) * count, 4);
+    u32  ready_count = 0;
+
+    // Pushed back to front, so that independent jobs are popped (started) in list order
+    for(u32 i = count - 1; i != Max_u32; --i) {
+        wait_counts[i] = jobs[i].wait_count;
+        if (!wait_counts[i])
+            ready[ready_count++] = i;
+    }
+    assert(ready_count && "No job can start, every job waits on another");
+
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    pool->jobs           = jobs;
+    pool->wait_counts    = wait_counts;
+    pool->ready          = ready;
+    pool->ready_count    = ready_count;
+    pool->running_count  = 0;
+    pool->finished_count = 0;
+
+    if (ready_count > 1 && pool->worker_count)
+        pool->wake.notify_all();
+
+    u32 idx;
+    while(pool->finished_count < count) {
+        if (!pool->ready_count) {
+            assert(pool->running_count && "Jobs wait on each other (dependency cycle)");
+            pool->done.wait(lock);
+            continue;
+        }
+        idx = pool->ready[--pool->ready_count];
+        pool->running_count++;
+
+        lock.unlock();
+        jobs[idx].func(jobs[idx].arg);
+        lock.lock();
+
+        job_pool_wake(pool, job_pool_finish(pool, idx));
+    }
+
+    pool->jobs        = NULL;
+    pool->wait_counts = NULL;
+    pool->ready       = NULL;
+
+    lock.unlock();
+    reset_to_mark_temp(mark);
+}
+
+#if TEST
+struct Test_Job_Arg {
+    u32 *stamps;
+    u32 *clock;
+    u32 idx;
+    u32 work; // Busy work, so that workers overlap
+};
+
+static void test_job_stamp(void *arg) {
+    Test_Job_Arg *a = (Test_Job_Arg*)arg;
+
+    volatile u32 sink = 0;
+    for(u32 i = 0; i < a->work; ++i)
+        sink = sink + i;
+
+    a->stamps[a->idx] = __atomic_fetch_add(a->clock, 1, __ATOMIC_SEQ_CST);
+}
+
+// Per group of four: 0 and 1 are independent, 2 waits on 1, 3 waits on 0 and 2 (the shape of model_from_gltf(..)).
+static bool test_job_groups(u32 group_count, u32 thread_limit) {
+    u32 count = group_count * 4;
+
+    Job          *jobs       = (Job*)malloc_t(sizeof(Job) * count, 8);
+    Test_Job_Arg *args       = (Test_Job_Arg*)malloc_t(sizeof(Test_Job_Arg) * count, 8);
+    u32          *stamps     = (u32*)malloc_t(sizeof(u32) * count, 4);
+    u32          *dependents = (u32*)malloc_t(sizeof(u32) * count, 4);
+    u32           clock      = 0;
+
+    memset(jobs, 0, sizeof(Job) * count);
+    memset(stamps, 0xff, sizeof(u32) * count);
+
+    u32 base;
+    for(u32 i = 0; i < group_count; ++i) {
+        base = i * 4;
+        for(u32 j = 0; j < 4; ++j) {
+            args[base + j] = {.stamps = stamps, .clock = &clock, .idx = base + j, .work = 1000 * (j + 1)};
+            jobs[base + j].func = test_job_stamp;
+            jobs[base + j].arg  = &args[base + j];
+        }
+        dependents[base + 0] = base + 3;
+        dependents[base + 1] = base + 2;
+        dependents[base + 2] = base + 3;
+        for(u32 j = 0; j < 3; ++j) {
+            jobs[base + j].dependent_count = 1;
+            jobs[base + j].dependents      = &dependents[base + j];
+        }
+        jobs[base + 2].wait_count = 1;
+        jobs[base + 3].wait_count = 2;
+    }
+
+    set_job_thread_limit(thread_limit);
+    run_jobs(count, jobs);
+    set_job_thread_limit(get_job_thread_count());
+
+    bool ok = clock == count;
+    for(u32 i = 0; i < group_count; ++i) {
+        base = i * 4;
+        ok = ok && stamps[base + 0] < count && stamps[base + 1] < count;
+        ok = ok && stamps[base + 2] > stamps[base + 1];
+        ok = ok && stamps[base + 3] > stamps[base + 0] && stamps[base + 3] > stamps[base + 2];
+    }
+    return ok;
+}
+
+static void test_job_square(void *arg) {
+    u32 *x = (u32*)arg;
+    *x = *x * *x;
+}
+
+void test_job() {
+    u64 mark = get_mark_temp();
+
+    BEGIN_TEST_MODULE("Job", false, false);
+
+    const u32 n = 256;
+    u32 *xs   = (u32*)malloc_t(sizeof(u32) * n, 4);
+    Job *jobs = (Job*)malloc_t(sizeof(Job) * n, 8);
+    for(u32 i = 0; i < n; ++i) {
+        xs[i]   = i;
+        jobs[i] = {.func = test_job_square, .arg = &xs[i]};
+    }
+    run_jobs(n, jobs);
+
+    u32 wrong = 0;
+    for(u32 i = 0; i < n; ++i)
+        wrong += xs[i] != i * i;
+    TEST_EQ("parallel_for", wrong, 0, false);
+
+    TEST_EQ("dependencies_one_group",    test_job_groups( 1, get_job_thread_count()), true, false);
+    TEST_EQ("dependencies_many_groups",  test_job_groups(64, get_job_thread_count()), true, false);
+    TEST_EQ("dependencies_single_thread", test_job_groups(64, 1), true, false);
+
+    // The list runs again after a run, with no state left over
+    TEST_EQ("dependencies_rerun", test_job_groups(64, get_job_thread_count()), true, false);
+
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif
@@ -0,0 +1,46 @@
+#ifndef SOL_JOB_HPP_INCLUDE_GUARD_
+#define SOL_JOB_HPP_INCLUDE_GUARD_
+
+#include "typedef.h"
+
+/*
+    Jobs: a fixed pool of worker threads which run lists of jobs for the main thread.
+
+    run_jobs(..) takes a list of jobs and returns once every one of them has finished. The calling thread runs jobs
+    as well, so a pool made for 'thread_count' threads has thread_count - 1 workers. A job may wait on other jobs in
+    the same list: 'wait_count' is how many jobs must finish before it can start, and 'dependents' are the indices
+    of the jobs waiting on it. A job with no dependents and a wait count of zero is just a parallel for.
+
+    @Note Neither global allocator is thread safe (nor are the gpu allocators), so jobs must not call malloc_t(..)
+    or malloc_h(..). Allocate up front on the calling thread, and hand each job its own range or arena.
+
+    Without init_jobs(..) (or with the thread limit at 1) run_jobs(..) runs the list on the calling thread, in
+    dependency order, so code using jobs does not need a second path for the tests and tools.
+*/
+
+typedef void (*Job_Func)(void *arg);
+
+struct Job {
+    Job_Func   func;
+    void      *arg;
+    u32        wait_count;      // Jobs in the same list which must finish before this one starts
+    u32        dependent_count;
+    const u32 *dependents;      // Indices into the same list of the jobs waiting on this one
+};
+
+void init_jobs(u32 thread_count);
+void kill_jobs();
+
+// Blocks until every job in 'jobs' has finished. Only call from the thread which called init_jobs(..).
+void run_jobs(u32 count, const Job *jobs);
+
+// Use at most 'thread_count' threads (including the calling thread) in later calls to run_jobs(..); clamped to
+// [1, pool size]. For comparing thread counts in the benchmarks.
+void set_job_thread_limit(u32 thread_count);
+u32  get_job_thread_count(); // The pool size, 1 if init_jobs(..) has not been called
+
+#if TEST
+void test_job();
+#endif
+
+#endif // include guard
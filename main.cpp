@@ -4,8 +4,18 @@
 #include "gpu.hpp"
 #include "asset.hpp"
 #include "gltf.hpp"
+#include "accessor.hpp"
+#include "meshopt.hpp"
+#include "mesh.hpp"
 #include "glfw.hpp"
 #include "hash_map.hpp"
+#include "job.hpp"
+#include "animation.hpp"
+#include "skin.hpp"
+#include "scene.hpp"
+#include "cull.hpp"
+#include "bvh.hpp"
+#include "draw.hpp"
 #include "assert.h"
 
 #if TEST
@@ -13,8 +23,14 @@
    void run_tests();
 #endif
 
+#if BENCH
+   #include "bench.hpp"
+   void run_benchmarks();
+#endif
+
 int main() {
     init_allocators();
+    init_jobs(g_thread_count);
 
     init_glfw();
     Glfw *glfw = get_glfw_instance();
@@ -33,6 +49,10 @@ int main() {
     run_tests();
 #endif
 
+#if BENCH
+    run_benchmarks();
+#endif
+
     zero_temp();
 
     VkFence     acquire_image_fence     = create_fence(false);
@@ -70,6 +90,7 @@ int main() {
     kill_gpu(gpu);
     kill_glfw();
 
+    kill_jobs();
     kill_allocators();
     return 0;
 }
@@ -81,7 +102,35 @@ void run_tests() {
     test_asset();
     test_spirv();
     test_gltf();
+    test_accessor();
+    test_meshopt();
+    test_mesh();
+    test_job();
+    test_animation();
+    test_skin();
+    test_scene();
+    test_cull();
+    test_bvh();
+    test_draw();
 
     end_tests();
 }
 #endif
+
+#if BENCH
+void run_benchmarks() {
+    println("\nBeginning Benchmarks...");
+
+    bench_gltf();
+    bench_asset();
+    bench_mesh();
+    bench_animation();
+    bench_skin();
+    bench_scene();
+    bench_cull();
+    bench_bvh();
+    bench_draw();
+
+    println("\nEnd Benchmarks");
+}
+#endif
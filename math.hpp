@@ -2,6 +2,7 @@
 #define SOL_MATH_HPP_INCLUDE_GUARD_
 
 #include <math.h>
+#include <string.h>
 #include <xmmintrin.h>
 
 #include "builtin_wrappers.h"
@@ -80,17 +81,17 @@ inline static float sum_vec3(Vec3 vec3) {
      return vec3.x + vec3.y + vec3.z;
 }
 inline static Vec3 add_vec3(Vec3 a, Vec3 b) {
-    return {a.x + b.x, a.y + b.y, a.x + b.y};
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
 }
 inline static Vec3 sub_vec3(Vec3 a, Vec3 b) {
-    return {a.x - b.x, a.y - b.y, a.x - b.y};
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
 }
 inline static float dot_vec3(Vec3 a, Vec3 b) {
     return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
 }
 inline static Vec3 cross_vec3(Vec3 *a, Vec3 *b) {
     return {
-        (a->y * b->z) - (a->z - b->y),
+        (a->y * b->z) - (a->z * b->y),
         (a->z * b->x) - (a->x * b->z),
         (a->x * b->y) - (a->y * b->x),
     };
@@ -118,275 +119,26 @@ inline static Vec4 mul_mat4_vec4(Mat4 mat, Vec4 vec) {
     ret.w = vec.x * mat.row3.x + vec.y * mat.row3.y + vec.z * mat.row3.z + vec.w * mat.row3.w;
     return ret;
 }
+// Row i of the result is the rows of 'b' weighted by the elements of row i of 'a'.
 inline static Mat4 mul_mat4(Mat4 a, Mat4 b)
 {
-    alignas(16) float c[4];
-    alignas(16) float d[4];
-    float *tmp;
-    Mat4 ret;
-    __m128 f;
-    __m128 e;
-
-    // Row 0
-    c[0] = a.row0.x;
-    c[1] = a.row0.y;
-    c[2] = a.row0.z;
-    c[3] = a.row0.w;
-
-    d[0] = b.row0.x;
-    d[1] = b.row1.x;
-    d[2] = b.row2.x;
-    d[3] = b.row3.x;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row0.x = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row0.x;
-    c[1] = a.row0.y;
-    c[2] = a.row0.z;
-    c[3] = a.row0.w;
-
-    d[0] = b.row0.y;
-    d[1] = b.row1.y;
-    d[2] = b.row2.y;
-    d[3] = b.row3.y;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row0.y = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row0.x;
-    c[1] = a.row0.y;
-    c[2] = a.row0.z;
-    c[3] = a.row0.w;
-
-    d[0] = b.row0.z;
-    d[1] = b.row1.z;
-    d[2] = b.row2.z;
-    d[3] = b.row3.z;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row0.z = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row0.x;
-    c[1] = a.row0.y;
-    c[2] = a.row0.z;
-    c[3] = a.row0.w;
-
-    d[0] = b.row0.w;
-    d[1] = b.row1.w;
-    d[2] = b.row2.w;
-    d[3] = b.row3.w;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row0.w = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    // Row 1
-    c[0] = a.row1.x;
-    c[1] = a.row1.y;
-    c[2] = a.row1.z;
-    c[3] = a.row1.w;
-
-    d[0] = b.row0.x;
-    d[1] = b.row1.x;
-    d[2] = b.row2.x;
-    d[3] = b.row3.x;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row1.x = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row1.x;
-    c[1] = a.row1.y;
-    c[2] = a.row1.z;
-    c[3] = a.row1.w;
-
-    d[0] = b.row0.y;
-    d[1] = b.row1.y;
-    d[2] = b.row2.y;
-    d[3] = b.row3.y;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row1.y = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row1.x;
-    c[1] = a.row1.y;
-    c[2] = a.row1.z;
-    c[3] = a.row1.w;
-
-    d[0] = b.row0.z;
-    d[1] = b.row1.z;
-    d[2] = b.row2.z;
-    d[3] = b.row3.z;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row1.z = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row1.x;
-    c[1] = a.row1.y;
-    c[2] = a.row1.z;
-    c[3] = a.row1.w;
-
-    d[0] = b.row0.w;
-    d[1] = b.row1.w;
-    d[2] = b.row2.w;
-    d[3] = b.row3.w;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row1.w = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    // Row 2
-    c[0] = a.row2.x;
-    c[1] = a.row2.y;
-    c[2] = a.row2.z;
-    c[3] = a.row2.w;
-
-    d[0] = b.row0.x;
-    d[1] = b.row1.x;
-    d[2] = b.row2.x;
-    d[3] = b.row3.x;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row2.x = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row2.x;
-    c[1] = a.row2.y;
-    c[2] = a.row2.z;
-    c[3] = a.row2.w;
-
-    d[0] = b.row0.y;
-    d[1] = b.row1.y;
-    d[2] = b.row2.y;
-    d[3] = b.row3.y;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row2.y = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row2.x;
-    c[1] = a.row2.y;
-    c[2] = a.row2.z;
-    c[3] = a.row2.w;
-
-    d[0] = b.row0.z;
-    d[1] = b.row1.z;
-    d[2] = b.row2.z;
-    d[3] = b.row3.z;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row2.z = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row2.x;
-    c[1] = a.row2.y;
-    c[2] = a.row2.z;
-    c[3] = a.row2.w;
-
-    d[0] = b.row0.w;
-    d[1] = b.row1.w;
-    d[2] = b.row2.w;
-    d[3] = b.row3.w;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row2.w = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    // Row 3
-    c[0] = a.row3.x;
-    c[1] = a.row3.y;
-    c[2] = a.row3.z;
-    c[3] = a.row3.w;
-
-    d[0] = b.row0.x;
-    d[1] = b.row1.x;
-    d[2] = b.row2.x;
-    d[3] = b.row3.x;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row3.x = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row3.x;
-    c[1] = a.row3.y;
-    c[2] = a.row3.z;
-    c[3] = a.row3.w;
-
-    d[0] = b.row0.y;
-    d[1] = b.row1.y;
-    d[2] = b.row2.y;
-    d[3] = b.row3.y;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row3.y = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row3.x;
-    c[1] = a.row3.y;
-    c[2] = a.row3.z;
-    c[3] = a.row3.w;
-
-    d[0] = b.row0.z;
-    d[1] = b.row1.z;
-    d[2] = b.row2.z;
-    d[3] = b.row3.z;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row3.z = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-    c[0] = a.row3.x;
-    c[1] = a.row3.y;
-    c[2] = a.row3.z;
-    c[3] = a.row3.w;
-
-    d[0] = b.row0.w;
-    d[1] = b.row1.w;
-    d[2] = b.row2.w;
-    d[3] = b.row3.w;
-
-    e = _mm_load_ps(c);
-    f = _mm_load_ps(d);
-    e = _mm_mul_ps(e, f);
-    tmp = (float*)&e;
-    ret.row3.w = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+    __m128 b0 = _mm_loadu_ps(&b.row0.x);
+    __m128 b1 = _mm_loadu_ps(&b.row1.x);
+    __m128 b2 = _mm_loadu_ps(&b.row2.x);
+    __m128 b3 = _mm_loadu_ps(&b.row3.x);
 
+    Mat4 ret;
+    const Vec4 *src[] = {&a.row0,   &a.row1,   &a.row2,   &a.row3};
+    Vec4       *dst[] = {&ret.row0, &ret.row1, &ret.row2, &ret.row3};
+
+    __m128 r;
+    for(u32 i = 0; i < 4; ++i) {
+        r = _mm_mul_ps(_mm_set1_ps(src[i]->x), b0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(src[i]->y), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(src[i]->z), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(src[i]->w), b3));
+        _mm_storeu_ps(&dst[i]->x, r);
+    }
     return ret;
 }
 inline static Mat4 look_at(Vec3 *right, Vec3 *up, Vec3 *dir, Vec3 *pos) {
@@ -397,13 +149,67 @@ inline static Mat4 look_at(Vec3 *right, Vec3 *up, Vec3 *dir, Vec3 *pos) {
         {0       , 0       , 0       , 1,},
     };
     Mat4 trans = {
-        {0, 0, 0, -pos->x,},
-        {0, 0, 0, -pos->y,},
-        {0, 0, 0, -pos->z,},
+        {1, 0, 0, -pos->x,},
+        {0, 1, 0, -pos->y,},
+        {0, 0, 1, -pos->z,},
         {0, 0, 0, 1,},
     };
 
     return mul_mat4(mat, trans);
 }
 
+// For look_at(..)'s view space (+z is 'dir', in front of the camera): depth is 0 at 'near' and 1 at 'far', and y is
+// flipped for vulkan's clip space, where it points down. 'fov_y' is in radians.
+inline static Mat4 perspective(float fov_y, float aspect, float near, float far) {
+    float f = 1.0f / tanf(fov_y * 0.5f);
+    return {
+        {f / aspect, 0,  0,                   0,},
+        {0,         -f,  0,                   0,},
+        {0,          0,  far / (far - near), -far * near / (far - near),},
+        {0,          0,  1,                   0,},
+    };
+}
+
+// Round to nearest even, overflow goes to inf, nans stay (quiet) nans.
+inline static u16 float_to_half(float f) {
+    u32 x;
+    memcpy(&x, &f, 4);
+    u32 sign = (x >> 16) & 0x8000;
+    x &= 0x7fffffff;
+
+    u32 h;
+    if (x >= 0x47800000) { // >= 65536: inf/nan
+        h = x > 0x7f800000 ? 0x7e00 : 0x7c00;
+    } else if (x < 0x38800000) { // < 2^-14: subnormal, let the fpu do the rounding
+        float t;
+        memcpy(&t, &x, 4);
+        t += 0.5f;
+        memcpy(&h, &t, 4);
+        h -= 0x3f000000;
+    } else {
+        // Rebias the exponent (-112 << 23) and round, a mantissa carry correctly bumps the exponent (even to inf).
+        h = (x + 0xc8000fff + ((x >> 13) & 1)) >> 13;
+    }
+    return (u16)(h | sign);
+}
+inline static float half_to_float(u16 h) {
+    u32 sign     = (u32)(h & 0x8000) << 16;
+    u32 exp_mant = h & 0x7fff;
+
+    u32 x;
+    if (exp_mant >= 0x7c00) {
+        x = 0x7f800000 | ((exp_mant & 0x3ff) << 13);
+    } else if (exp_mant >= 0x400) {
+        x = (exp_mant << 13) + 0x38000000;
+    } else {
+        float f = (float)exp_mant * (1.0f / 16777216.0f); // subnormal: mantissa * 2^-24
+        memcpy(&x, &f, 4);
+    }
+    x |= sign;
+
+    float ret;
+    memcpy(&ret, &x, 4);
+    return ret;
+}
+
 #endif // include guard
@@ -0,0 +1,2406 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "mesh.hpp"
+#include "math.hpp"
+#include "string.hpp"
+#include "hash_map.hpp"
+#include "simd.hpp"
+
+#if TEST
+    #include "test.hpp"
+#endif
+
+#if BENCH
+    #include "test/bench.hpp"
+#endif
+
+                                        /* Vertex Cache Analysis */
+
+//
+// Fifo by timestamps: a miss stamps the vertex with the current time and advances it, so a vertex is still in
+// the cache while fewer than 'cache_size' misses have happened since it was stamped. Stamps start at 0 and time
+// at cache_size + 1, so every vertex begins outside the cache. Adding cache_size + 1 to time flushes it.
+//
+
+Vertex_Cache_Stats mesh_analyze_vertex_cache(const u32 *indices, u32 index_count, u32 vertex_count, u32 cache_size) {
+    assert(index_count % 3 == 0 && "Indices are not a triangle list");
+
+    u64 mark = get_mark_temp();
+    u32 *timestamps = (u32*)malloc_t(sizeof(u32) * vertex_count, 4);
+    memset(timestamps, 0, sizeof(u32) * vertex_count);
+
+    Vertex_Cache_Stats ret = {};
+
+    u32 v;
+    u32 time = cache_size + 1;
+    for(u32 i = 0; i < index_count; ++i) {
+        v = indices[i];
+        assert(v < vertex_count && "Index out of range");
+
+        ret.vertex_count += timestamps[v] == 0;
+        if (time - timestamps[v] > cache_size) {
+            timestamps[v] = time++;
+            ret.vertices_transformed++;
+        }
+    }
+    ret.triangle_count = index_count / 3;
+
+    ret.acmr = ret.triangle_count ? (float)ret.vertices_transformed / ret.triangle_count : 0;
+    ret.atvr = ret.vertex_count   ? (float)ret.vertices_transformed / ret.vertex_count   : 0;
+
+    reset_to_mark_temp(mark);
+    return ret;
+}
+
+                                        /* Vertex Remaps */
+
+inline static u64 mesh_hash_vertex(u32 vertex, u32 stream_count, const Mesh_Vertex_Stream *streams) {
+    u64 hash = 0;
+    for(u32 i = 0; i < stream_count; ++i)
+        hash = hash_bytes((u8*)streams[i].data + (u64)vertex * streams[i].stride, streams[i].size, hash);
+    return hash;
+}
+
+inline static bool mesh_vertex_equal(u32 a, u32 b, u32 stream_count, const Mesh_Vertex_Stream *streams) {
+    const u8 *data;
+    for(u32 i = 0; i < stream_count; ++i) {
+        data = (const u8*)streams[i].data;
+        if (memcmp(data + (u64)a * streams[i].stride, data + (u64)b * streams[i].stride, streams[i].size))
+            return false;
+    }
+    return true;
+}
+
+u32 mesh_generate_vertex_remap(u32 *remap, u32 vertex_count, u32 stream_count, const Mesh_Vertex_Stream *streams) {
+    u64 mark = get_mark_temp();
+
+    // Linear probing table of vertex indices, at most half full.
+    u32 table_size = 16;
+    while(table_size < vertex_count * 2)
+        table_size <<= 1;
+    u32 *table = (u32*)malloc_t(sizeof(u32) * table_size, 4);
+    memset(table, 0xff, sizeof(u32) * table_size);
+
+    u32 unique = 0;
+    u32 slot;
+    for(u32 i = 0; i < vertex_count; ++i) {
+        slot = (u32)mesh_hash_vertex(i, stream_count, streams) & (table_size - 1);
+        while(table[slot] != Max_u32 && !mesh_vertex_equal(table[slot], i, stream_count, streams))
+            slot = (slot + 1) & (table_size - 1);
+
+        if (table[slot] == Max_u32) {
+            table[slot] = i;
+            remap[i]    = unique++;
+        } else {
+            remap[i] = remap[table[slot]];
+        }
+    }
+
+    reset_to_mark_temp(mark);
+    return unique;
+}
+
+u32 mesh_generate_vertex_fetch_remap(u32 *remap, const u32 *indices, u32 index_count, u32 vertex_count) {
+    memset(remap, 0xff, sizeof(u32) * vertex_count);
+
+    u32 next = 0;
+    u32 v;
+    for(u32 i = 0; i < index_count; ++i) {
+        v = indices[i];
+        assert(v < vertex_count && "Index out of range");
+        if (remap[v] == Max_u32)
+            remap[v] = next++;
+    }
+    return next;
+}
+
+void mesh_remap_indices(u32 *dst, const u32 *indices, u32 index_count, const u32 *remap) {
+    for(u32 i = 0; i < index_count; ++i) {
+        assert(remap[indices[i]] != Max_u32 && "Index references a dropped vertex");
+        dst[i] = remap[indices[i]];
+    }
+}
+
+void mesh_remap_vertices(void *dst, u32 dst_stride, const void *vertices, u32 src_stride, u32 size, u32 vertex_count,
+                         const u32 *remap)
+{
+    u8       *to   = (u8*)dst;
+    const u8 *from = (const u8*)vertices;
+    for(u32 i = 0; i < vertex_count; ++i) {
+        if (remap[i] != Max_u32)
+            memcpy(to + (u64)remap[i] * dst_stride, from + (u64)i * src_stride, size);
+    }
+}
+
+                                        /* Adjacency */
+
+struct Mesh_Adjacency {
+    u32 *counts;    // triangles per vertex
+    u32 *offsets;   // into 'triangles', vertex_count + 1 entries
+    u32 *triangles; // the triangles around each vertex
+};
+
+// Allocated in temp.
+static Mesh_Adjacency mesh_build_adjacency(const u32 *indices, u32 index_count, u32 vertex_count) {
+    Mesh_Adjacency ret;
+    ret.counts    = (u32*)malloc_t(sizeof(u32) * vertex_count,       4);
+    ret.offsets   = (u32*)malloc_t(sizeof(u32) * (vertex_count + 1), 4);
+    ret.triangles = (u32*)malloc_t(sizeof(u32) * index_count,        4);
+    memset(ret.counts, 0, sizeof(u32) * vertex_count);
+
+    for(u32 i = 0; i < index_count; ++i) {
+        assert(indices[i] < vertex_count && "Index out of range");
+        ret.counts[indices[i]]++;
+    }
+
+    // Filling bumps each vertex's offset to the start of the next vertex's triangles, so shift them back after.
+    ret.offsets[0] = 0;
+    for(u32 i = 0; i < vertex_count; ++i)
+        ret.offsets[i + 1] = ret.offsets[i] + ret.counts[i];
+    for(u32 i = 0; i < index_count; ++i)
+        ret.triangles[ret.offsets[indices[i]]++] = i / 3;
+    for(u32 i = vertex_count; i > 0; --i)
+        ret.offsets[i] = ret.offsets[i - 1];
+    ret.offsets[0] = 0;
+
+    return ret;
+}
+
+                                        /* Tipsify */
+
+//
+// Fan out from vertex 'f', emitting every triangle around it, then pick the next fanning vertex from the ones
+// just emitted: the oldest one which will still be in the cache after its own remaining triangles are emitted
+// (each adds at most two vertices). If there is none, take the most recently emitted vertex that still has
+// triangles (the dead end stack), and failing that the next vertex in index order with any.
+//
+struct Tipsify_State {
+    const u32 *indices;
+    const u32 *offsets;   // into 'adjacency', vertex_count + 1 entries
+    const u32 *adjacency; // triangles around each vertex
+    u32       *live;      // triangles not yet emitted, per vertex
+    u32       *timestamps;
+    u8        *emitted;
+    u32       *dead_end;
+    u32       *candidates;
+
+    u32 vertex_count;
+    u32 cache_size;
+    u32 time;
+    u32 dead_end_top;
+    u32 candidate_count;
+    u32 cursor;
+};
+
+static u32 tipsify_next_vertex(Tipsify_State *state) {
+    u32 best          = Max_u32;
+    int best_priority = -1;
+
+    u32 v;
+    int priority;
+    for(u32 i = 0; i < state->candidate_count; ++i) {
+        v = state->candidates[i];
+        if (!state->live[v])
+            continue;
+
+        priority = 0;
+        if (state->time - state->timestamps[v] + 2 * state->live[v] <= state->cache_size)
+            priority = state->time - state->timestamps[v];
+
+        if (priority > best_priority) {
+            best          = v;
+            best_priority = priority;
+        }
+    }
+    if (best != Max_u32)
+        return best;
+
+    while(state->dead_end_top) {
+        v = state->dead_end[--state->dead_end_top];
+        if (state->live[v])
+            return v;
+    }
+
+    while(state->cursor < state->vertex_count) {
+        if (state->live[state->cursor])
+            return state->cursor;
+        state->cursor++;
+    }
+    return Max_u32;
+}
+
+void mesh_optimize_vertex_cache(u32 *dst, const u32 *indices, u32 index_count, u32 vertex_count, u32 cache_size) {
+    assert(index_count % 3 == 0 && "Indices are not a triangle list");
+    assert(dst != indices && "Tipsify cannot run in place");
+
+    u64 mark = get_mark_temp();
+
+    u32 triangle_count = index_count / 3;
+
+    Mesh_Adjacency adj = mesh_build_adjacency(indices, index_count, vertex_count);
+    u32 *live      = adj.counts;
+    u32 *offsets   = adj.offsets;
+    u32 *adjacency = adj.triangles;
+
+    Tipsify_State state = {};
+    state.indices      = indices;
+    state.offsets      = offsets;
+    state.adjacency    = adjacency;
+    state.live         = live;
+    state.timestamps   = (u32*)malloc_t(sizeof(u32) * vertex_count, 4);
+    state.emitted      = (u8*) malloc_t(triangle_count, 4);
+    state.dead_end     = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    state.candidates   = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    state.vertex_count = vertex_count;
+    state.cache_size   = cache_size;
+    state.time         = cache_size + 1;
+    memset(state.timestamps, 0, sizeof(u32) * vertex_count);
+    memset(state.emitted,    0, triangle_count);
+
+    u32 out = 0;
+    u32 tri;
+    u32 v;
+    u32 f = tipsify_next_vertex(&state);
+    while(f != Max_u32) {
+        state.candidate_count = 0;
+
+        for(u32 i = offsets[f]; i < offsets[f + 1]; ++i) {
+            tri = adjacency[i];
+            if (state.emitted[tri])
+                continue;
+            state.emitted[tri] = 1;
+
+            for(u32 k = 0; k < 3; ++k) {
+                v = indices[tri * 3 + k];
+                dst[out++] = v;
+
+                state.dead_end[state.dead_end_top++]      = v;
+                state.candidates[state.candidate_count++] = v;
+                live[v]--;
+
+                if (state.time - state.timestamps[v] > cache_size)
+                    state.timestamps[v] = state.time++;
+            }
+        }
+
+        f = tipsify_next_vertex(&state);
+    }
+    assert(out == index_count && "Tipsify did not emit every triangle");
+
+    reset_to_mark_temp(mark);
+}
+
+                                        /* Overdraw */
+
+struct Mesh_Cluster_Sort_Key {
+    float key;
+    u32   cluster;
+};
+
+static int mesh_compare_cluster_keys(const void *a, const void *b) {
+    const Mesh_Cluster_Sort_Key *x = (const Mesh_Cluster_Sort_Key*)a;
+    const Mesh_Cluster_Sort_Key *y = (const Mesh_Cluster_Sort_Key*)b;
+    if (x->key != y->key)
+        return x->key > y->key ? -1 : 1; // descending
+    return x->cluster < y->cluster ? -1 : 1;
+}
+
+inline static u32 mesh_simulate_triangle(const u32 *tri, u32 *timestamps, u32 *time, u32 cache_size) {
+    u32 misses = 0;
+    for(u32 k = 0; k < 3; ++k) {
+        if (*time - timestamps[tri[k]] > cache_size) {
+            timestamps[tri[k]] = (*time)++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+inline static const float* mesh_position(const float *positions, u32 stride, u32 vertex) {
+    return (const float*)((const u8*)positions + (u64)vertex * stride);
+}
+
+// Twice the triangle's area as the length of 'normal', and its area weighted centroid added to 'centroid'.
+inline static float mesh_accumulate_triangle(const float *p0, const float *p1, const float *p2, float *centroid,
+                                             float *normal)
+{
+    float e0[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    float n[3]  = {
+        e0[1] * e1[2] - e0[2] * e1[1],
+        e0[2] * e1[0] - e0[0] * e1[2],
+        e0[0] * e1[1] - e0[1] * e1[0],
+    };
+    float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5f;
+    for(u32 k = 0; k < 3; ++k) {
+        centroid[k] += (p0[k] + p1[k] + p2[k]) * (1.0f / 3.0f) * area;
+        normal[k]   += n[k];
+    }
+    return area;
+}
+
+void mesh_optimize_overdraw(u32 *dst, const u32 *indices, u32 index_count, const float *positions,
+                            u32 position_stride, u32 vertex_count, u32 cache_size, float threshold)
+{
+    assert(index_count % 3 == 0 && "Indices are not a triangle list");
+    assert(dst != indices && "Overdraw optimization cannot run in place");
+
+    u64 mark = get_mark_temp();
+
+    u32 triangle_count = index_count / 3;
+
+    u32 *timestamps = (u32*)malloc_t(sizeof(u32) * vertex_count, 4);
+    memset(timestamps, 0, sizeof(u32) * vertex_count);
+    u32 time = cache_size + 1;
+
+    // Hard boundaries: a triangle which misses on all three vertices follows a Tipsify cache flush, so nothing
+    // before it relies on the cache state that it leaves.
+    u32 *hard = (u32*)malloc_t(sizeof(u32) * (triangle_count + 1), 4);
+    u32  hard_count = 0;
+    for(u32 i = 0; i < triangle_count; ++i) {
+        if (mesh_simulate_triangle(indices + i * 3, timestamps, &time, cache_size) == 3)
+            hard[hard_count++] = i;
+    }
+    hard[hard_count] = triangle_count;
+
+    // Soft boundaries: split a hard cluster as soon as the part of it seen so far is within 'threshold' of the
+    // whole cluster's acmr, so splitting costs little more than the cluster already does.
+    u32 *clusters = (u32*)malloc_t(sizeof(u32) * (triangle_count + 1), 4);
+    u32  cluster_count = 0;
+
+    u32   misses;
+    u32   start;
+    float limit;
+    for(u32 i = 0; i < hard_count; ++i) {
+        time += cache_size + 1;
+        misses = 0;
+        for(u32 j = hard[i]; j < hard[i + 1]; ++j)
+            misses += mesh_simulate_triangle(indices + j * 3, timestamps, &time, cache_size);
+        limit = threshold * (float)misses / (hard[i + 1] - hard[i]);
+
+        time  += cache_size + 1;
+        misses = 0;
+        start  = hard[i];
+        clusters[cluster_count++] = start;
+        for(u32 j = hard[i]; j < hard[i + 1] - 1; ++j) {
+            misses += mesh_simulate_triangle(indices + j * 3, timestamps, &time, cache_size);
+            if ((float)misses <= limit * (j + 1 - start)) {
+                time  += cache_size + 1;
+                misses = 0;
+                start  = j + 1;
+                clusters[cluster_count++] = start;
+            }
+        }
+    }
+    clusters[cluster_count] = triangle_count;
+
+    // Sort clusters by how far their area weighted centroid lies out along their average normal from the mesh
+    // centroid: the outer shell of a convex ish mesh occludes what is inside and behind it.
+    float *cluster_centroids = (float*)malloc_t(sizeof(float) * 3 * cluster_count, 4);
+    float *cluster_normals   = (float*)malloc_t(sizeof(float) * 3 * cluster_count, 4);
+    memset(cluster_centroids, 0, sizeof(float) * 3 * cluster_count);
+    memset(cluster_normals,   0, sizeof(float) * 3 * cluster_count);
+
+    float mesh_centroid[3] = {};
+    float mesh_area = 0;
+
+    const u32 *tri;
+    float     *centroid;
+    float      area;
+    float      cluster_area;
+    for(u32 i = 0; i < cluster_count; ++i) {
+        centroid     = cluster_centroids + i * 3;
+        cluster_area = 0;
+        for(u32 j = clusters[i]; j < clusters[i + 1]; ++j) {
+            tri = indices + j * 3;
+            area = mesh_accumulate_triangle(mesh_position(positions, position_stride, tri[0]),
+                                            mesh_position(positions, position_stride, tri[1]),
+                                            mesh_position(positions, position_stride, tri[2]),
+                                            centroid, cluster_normals + i * 3);
+            cluster_area += area;
+        }
+        for(u32 k = 0; k < 3; ++k)
+            mesh_centroid[k] += centroid[k];
+        mesh_area += cluster_area;
+
+        if (cluster_area > 0)
+            for(u32 k = 0; k < 3; ++k)
+                centroid[k] /= cluster_area;
+    }
+    if (mesh_area > 0)
+        for(u32 k = 0; k < 3; ++k)
+            mesh_centroid[k] /= mesh_area;
+
+    Mesh_Cluster_Sort_Key *keys = (Mesh_Cluster_Sort_Key*)malloc_t(sizeof(Mesh_Cluster_Sort_Key) * cluster_count, 4);
+    const float *normal;
+    float        length;
+    for(u32 i = 0; i < cluster_count; ++i) {
+        centroid = cluster_centroids + i * 3;
+        normal   = cluster_normals   + i * 3;
+        length   = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+        keys[i].cluster = i;
+        keys[i].key     = 0;
+        if (length > 0)
+            keys[i].key = ((centroid[0] - mesh_centroid[0]) * normal[0] +
+                           (centroid[1] - mesh_centroid[1]) * normal[1] +
+                           (centroid[2] - mesh_centroid[2]) * normal[2]) / length;
+    }
+    qsort(keys, cluster_count, sizeof(*keys), mesh_compare_cluster_keys);
+
+    u32 out = 0;
+    u32 size;
+    for(u32 i = 0; i < cluster_count; ++i) {
+        start = clusters[keys[i].cluster];
+        size  = (clusters[keys[i].cluster + 1] - start) * 3;
+        memcpy(dst + out, indices + start * 3, sizeof(u32) * size);
+        out += size;
+    }
+    assert(out == index_count);
+
+    reset_to_mark_temp(mark);
+}
+
+                                        /* Meshlets */
+
+u32 mesh_get_meshlet_bound(u32 index_count, u32 max_vertices, u32 max_triangles) {
+    assert(max_vertices >= 3 && max_triangles >= 1);
+    return index_count / (max_vertices - 2) + index_count / 3 / max_triangles + 1;
+}
+
+struct Meshlet_Builder {
+    Meshlet  current;
+    Meshlet *meshlets;
+    u32     *vertices;
+    u8      *triangles;
+    u8      *local; // per primitive vertex, its index in the current meshlet or 0xff
+    u32      count;
+    float    centroid[3]; // sum of the current meshlet's vertex positions
+};
+
+static void meshlet_builder_flush(Meshlet_Builder *builder) {
+    Meshlet *current = &builder->current;
+    if (!current->triangle_count)
+        return;
+
+    for(u32 i = 0; i < current->vertex_count; ++i)
+        builder->local[builder->vertices[current->vertex_offset + i]] = 0xff;
+
+    builder->meshlets[builder->count++] = *current;
+
+    current->vertex_offset   += current->vertex_count;
+    current->triangle_offset += current->triangle_count;
+    current->vertex_count     = 0;
+    current->triangle_count   = 0;
+    memset(builder->centroid, 0, sizeof(builder->centroid));
+}
+
+inline static u32 meshlet_builder_new_vertex_count(const Meshlet_Builder *builder, const u32 *tri) {
+    return (builder->local[tri[0]] == 0xff) + (builder->local[tri[1]] == 0xff) + (builder->local[tri[2]] == 0xff);
+}
+
+// Best neighbour of the meshlet's vertices in [begin, end) which fits: fewest new vertices, then closest.
+// 'any_neighbour' is set if there was any neighbour at all.
+static u32 meshlet_builder_find_neighbour(const Meshlet_Builder *builder, const Mesh_Adjacency *adj,
+                                          const u32 *indices, const u8 *emitted, const float *positions,
+                                          u32 position_stride, u32 max_vertices, const u32 *begin,
+                                          const u32 *end, bool *any_neighbour)
+{
+    u32   best          = Max_u32;
+    u32   best_new      = 4;
+    float best_distance = 0;
+
+    float center[3];
+    if (positions) {
+        for(u32 k = 0; k < 3; ++k)
+            center[k] = builder->centroid[k] / builder->current.vertex_count;
+    }
+
+    const u32 *tri;
+    u32   new_count;
+    float distance;
+    float d[3];
+    for(const u32 *v = begin; v < end; ++v) {
+        for(u32 i = adj->offsets[*v]; i < adj->offsets[*v + 1]; ++i) {
+            if (emitted[adj->triangles[i]])
+                continue;
+            *any_neighbour = true;
+
+            tri       = indices + adj->triangles[i] * 3;
+            new_count = meshlet_builder_new_vertex_count(builder, tri);
+            if (builder->current.vertex_count + new_count > max_vertices || new_count > best_new)
+                continue;
+
+            distance = 0;
+            if (positions) {
+                for(u32 k = 0; k < 3; ++k)
+                    d[k] = (mesh_position(positions, position_stride, tri[0])[k] +
+                            mesh_position(positions, position_stride, tri[1])[k] +
+                            mesh_position(positions, position_stride, tri[2])[k]) * (1.0f / 3.0f) - center[k];
+                distance = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+            }
+
+            if (new_count < best_new || distance < best_distance) {
+                best          = adj->triangles[i];
+                best_new      = new_count;
+                best_distance = distance;
+            }
+        }
+    }
+    return best;
+}
+
+u32 mesh_build_meshlets(Meshlet *meshlets, u32 *meshlet_vertices, u8 *meshlet_triangles, const u32 *indices,
+                        u32 index_count, const float *positions, u32 position_stride, u32 vertex_count,
+                        u32 max_vertices, u32 max_triangles)
+{
+    assert(index_count % 3 == 0 && "Indices are not a triangle list");
+    assert(max_vertices >= 3 && max_vertices < 256 && "Meshlet vertices are u8, with 0xff as not present");
+    assert(max_triangles >= 1);
+
+    u64 mark = get_mark_temp();
+
+    u32 triangle_count = index_count / 3;
+
+    Mesh_Adjacency adj = mesh_build_adjacency(indices, index_count, vertex_count);
+
+    u8 *emitted = (u8*)malloc_t(triangle_count, 4);
+    memset(emitted, 0, triangle_count);
+
+    Meshlet_Builder builder = {};
+    builder.meshlets  = meshlets;
+    builder.vertices  = meshlet_vertices;
+    builder.triangles = meshlet_triangles;
+    builder.local     = (u8*)malloc_t(vertex_count, 4);
+    memset(builder.local, 0xff, vertex_count);
+
+    Meshlet *current = &builder.current;
+
+    u32 cursor = 0;       // first triangle which might not be emitted
+    u32 last   = Max_u32; // last triangle added to the current meshlet
+    u32 tri;
+    u32 v;
+    bool any_neighbour;
+    const float *p;
+    while(true) {
+        // Neighbours of the last triangle, else of the whole meshlet, else the next triangle in order.
+        tri           = Max_u32;
+        any_neighbour = false;
+        if (last != Max_u32)
+            tri = meshlet_builder_find_neighbour(&builder, &adj, indices, emitted, positions, position_stride,
+                                                 max_vertices, indices + last * 3, indices + last * 3 + 3,
+                                                 &any_neighbour);
+        if (!any_neighbour && current->vertex_count)
+            tri = meshlet_builder_find_neighbour(&builder, &adj, indices, emitted, positions, position_stride,
+                                                 max_vertices, meshlet_vertices + current->vertex_offset,
+                                                 meshlet_vertices + current->vertex_offset + current->vertex_count,
+                                                 &any_neighbour);
+        if (any_neighbour && tri == Max_u32) {
+            meshlet_builder_flush(&builder);
+            last = Max_u32;
+            continue;
+        }
+        if (tri == Max_u32) {
+            while(cursor < triangle_count && emitted[cursor])
+                cursor++;
+            if (cursor == triangle_count)
+                break;
+
+            tri = cursor;
+            if (current->vertex_count + meshlet_builder_new_vertex_count(&builder, indices + tri * 3) > max_vertices)
+                meshlet_builder_flush(&builder);
+        }
+
+        emitted[tri] = 1;
+        for(u32 k = 0; k < 3; ++k) {
+            v = indices[tri * 3 + k];
+            if (builder.local[v] == 0xff) {
+                builder.local[v] = current->vertex_count;
+                meshlet_vertices[current->vertex_offset + current->vertex_count++] = v;
+                if (positions) {
+                    p = mesh_position(positions, position_stride, v);
+                    for(u32 l = 0; l < 3; ++l)
+                        builder.centroid[l] += p[l];
+                }
+            }
+            meshlet_triangles[(current->triangle_offset + current->triangle_count) * 3 + k] = builder.local[v];
+        }
+        current->triangle_count++;
+        last = tri;
+
+        if (current->triangle_count == max_triangles) {
+            meshlet_builder_flush(&builder);
+            last = Max_u32;
+        }
+    }
+    meshlet_builder_flush(&builder);
+
+    assert(builder.count <= mesh_get_meshlet_bound(index_count, max_vertices, max_triangles));
+
+    reset_to_mark_temp(mark);
+    return builder.count;
+}
+
+inline static float mesh_distance(const float *a, const float *b) {
+    float d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+    return sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+}
+
+Meshlet_Bounds mesh_compute_meshlet_bounds(const Meshlet *meshlet, const u32 *meshlet_vertices,
+                                           const u8 *meshlet_triangles, const float *positions, u32 position_stride)
+{
+    Meshlet_Bounds ret = {};
+    if (!meshlet->vertex_count)
+        return ret;
+
+    const u32 *vertices = meshlet_vertices + meshlet->vertex_offset;
+    const u8  *tris     = meshlet_triangles + meshlet->triangle_offset * 3;
+
+    // Ritter's sphere: the farthest pair from an arbitrary start, then grow to take in any point still outside.
+    const float *a = mesh_position(positions, position_stride, vertices[0]);
+    const float *b = a;
+    const float *p;
+    float d;
+    float max_d = 0;
+    for(u32 i = 0; i < meshlet->vertex_count; ++i) {
+        p = mesh_position(positions, position_stride, vertices[i]);
+        d = mesh_distance(p, a);
+        if (d > max_d) { max_d = d; b = p; }
+    }
+    a = b;
+    max_d = 0;
+    for(u32 i = 0; i < meshlet->vertex_count; ++i) {
+        p = mesh_position(positions, position_stride, vertices[i]);
+        d = mesh_distance(p, a);
+        if (d > max_d) { max_d = d; b = p; }
+    }
+    for(u32 k = 0; k < 3; ++k)
+        ret.center[k] = (a[k] + b[k]) * 0.5f;
+    ret.radius = max_d * 0.5f;
+
+    float grow;
+    for(u32 i = 0; i < meshlet->vertex_count; ++i) {
+        p = mesh_position(positions, position_stride, vertices[i]);
+        d = mesh_distance(p, ret.center);
+        if (d > ret.radius) {
+            grow = (d - ret.radius) * 0.5f;
+            for(u32 k = 0; k < 3; ++k)
+                ret.center[k] += (p[k] - ret.center[k]) * (grow / d);
+            ret.radius += grow;
+        }
+    }
+
+    // Normal cone: the axis is the average unit normal, the half angle is the widest normal from it.
+    u64 mark = get_mark_temp();
+    float *normals = (float*)malloc_t(sizeof(float) * 3 * meshlet->triangle_count, 4);
+    u8    *valid   = (u8*)malloc_t(meshlet->triangle_count, 4);
+
+    const float *p0;
+    const float *p1;
+    const float *p2;
+    float  e0[3];
+    float  e1[3];
+    float *n;
+    float  length;
+    float  axis[3] = {};
+    for(u32 i = 0; i < meshlet->triangle_count; ++i) {
+        p0 = mesh_position(positions, position_stride, vertices[tris[i * 3 + 0]]);
+        p1 = mesh_position(positions, position_stride, vertices[tris[i * 3 + 1]]);
+        p2 = mesh_position(positions, position_stride, vertices[tris[i * 3 + 2]]);
+        for(u32 k = 0; k < 3; ++k) {
+            e0[k] = p1[k] - p0[k];
+            e1[k] = p2[k] - p0[k];
+        }
+        n = normals + i * 3;
+        n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+        n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+        n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+
+        length   = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        valid[i] = length > 0;
+        if (!valid[i]) // Degenerate triangles are never visible, so they do not widen the cone.
+            continue;
+        for(u32 k = 0; k < 3; ++k) {
+            n[k]    /= length;
+            axis[k] += n[k];
+        }
+    }
+
+    memcpy(ret.cone_apex, ret.center, sizeof(ret.center));
+    ret.cone_cutoff = 2;
+
+    length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (length > 0) {
+        for(u32 k = 0; k < 3; ++k)
+            ret.cone_axis[k] = axis[k] / length;
+
+        float min_dot = 1;
+        float dot;
+        for(u32 i = 0; i < meshlet->triangle_count; ++i) {
+            if (!valid[i])
+                continue;
+            n   = normals + i * 3;
+            dot = n[0] * ret.cone_axis[0] + n[1] * ret.cone_axis[1] + n[2] * ret.cone_axis[2];
+            min_dot = dot < min_dot ? dot : min_dot;
+        }
+
+        // Past ~84 degrees the cone would almost never cull, and the apex runs off to infinity.
+        if (min_dot > 0.1f) {
+            // Slide the apex back along the axis from the center until it is behind every triangle's plane.
+            float t;
+            float max_t = 0;
+            for(u32 i = 0; i < meshlet->triangle_count; ++i) {
+                if (!valid[i])
+                    continue;
+                n  = normals + i * 3;
+                p0 = mesh_position(positions, position_stride, vertices[tris[i * 3]]);
+                t  = ((ret.center[0] - p0[0]) * n[0] + (ret.center[1] - p0[1]) * n[1] +
+                      (ret.center[2] - p0[2]) * n[2]) /
+                     (ret.cone_axis[0] * n[0] + ret.cone_axis[1] * n[1] + ret.cone_axis[2] * n[2]);
+                max_t = t > max_t ? t : max_t;
+            }
+            for(u32 k = 0; k < 3; ++k)
+                ret.cone_apex[k] = ret.center[k] - ret.cone_axis[k] * max_t;
+            ret.cone_cutoff = sqrtf(1 - min_dot * min_dot);
+        }
+    }
+
+    reset_to_mark_temp(mark);
+    return ret;
+}
+
+u32 mesh_cull_meshlets(u32 *visible, u32 count, const Meshlet_Bounds *bounds, const Meshlet_Cull_Info *info) {
+    u32 ret = 0;
+
+    const Meshlet_Bounds *b;
+    const float          *plane;
+    bool  inside;
+    float d[3];
+    float length;
+    for(u32 i = 0; i < count; ++i) {
+        b = &bounds[i];
+
+        inside = true;
+        for(u32 j = 0; j < 6; ++j) {
+            plane   = info->planes[j];
+            inside &= plane[0] * b->center[0] + plane[1] * b->center[1] + plane[2] * b->center[2] + plane[3] >=
+                      -b->radius;
+        }
+
+        if (inside && b->cone_cutoff <= 1) {
+            for(u32 k = 0; k < 3; ++k)
+                d[k] = b->cone_apex[k] - info->eye[k];
+            length  = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            inside &= d[0] * b->cone_axis[0] + d[1] * b->cone_axis[1] + d[2] * b->cone_axis[2] <
+                      b->cone_cutoff * length;
+        }
+
+        visible[ret] = i;
+        ret += inside;
+    }
+    return ret;
+}
+
+                                        /* Simplification */
+
+//
+// Each vertex's error is a quadric: a sum of squared distances to planes, weighted by the area of the triangles
+// which they came from. A triangle adds its own plane to its corners' positions, and for each attribute channel a
+// plane in (position, value) space through its corners' values, so that moving a vertex costs the difference
+// between the value which the old surface had at its new position and the value which it now carries.
+//
+// The attribute quadrics split into a part in the position alone, which is kept per position group (every vertex
+// at one position, which always collapse together), and per channel terms which depend on the value, kept per
+// vertex:
+//
+//     area * (g.p + d - a)^2 = area * (g.p + d)^2 - 2 * a * area * (g.p + d) + a^2 * area
+//                                 ^ position part      ^ G = area * g, D = area * d    ^ W = area
+//
+// Every pass collapses the cheapest valid edges first, skipping any with an end whose triangles an earlier collapse
+// in the same pass changed (or which was one). So every check made at the start of a pass still holds when it is
+// applied.
+//
+struct Mesh_Quadric {
+    float a00, a11, a22, a01, a02, a12;
+    float b0, b1, b2;
+    float c;
+    float w; // area
+};
+
+static constexpr u32 MESH_SIMPLIFY_ATTRIBUTE_TERMS = 5; // G xyz, D, W per channel
+static constexpr u32 MESH_SIMPLIFY_MAX_WEDGES      = 16; // vertices at one position which a collapse may move
+
+// How far past the cost of the collapse that would meet a pass's goal the pass keeps going.
+static constexpr float MESH_SIMPLIFY_PASS_COST_BOUND = 1.5f;
+
+// Walls along open borders keep them from moving inwards (only matters when they are not locked).
+static constexpr float MESH_SIMPLIFY_BORDER_WEIGHT = 10;
+
+enum Mesh_Simplify_Group_Bits {
+    MESH_SIMPLIFY_GROUP_BORDER_BIT  = 0x01,
+    MESH_SIMPLIFY_GROUP_LOCKED_BIT  = 0x02,
+    MESH_SIMPLIFY_GROUP_REMOVED_BIT = 0x04, // collapsed onto another group
+    MESH_SIMPLIFY_GROUP_DIRTY_BIT   = 0x08, // triangles changed by a collapse in this pass
+};
+
+struct Mesh_Simplify_State {
+    u32 vertex_count;
+    u32 group_count;
+    u32 channel_count;
+
+    u32 *groups;      // vertex -> position group
+    u32 *wedge_first; // group -> first vertex in it
+    u32 *wedge_next;  // vertex -> next vertex in its group, ~0 ends
+    u8  *group_flags;
+    u32 *stamps;      // group -> scratch for the link condition
+    u32  stamp;
+
+    float        *positions;  // per group, scaled to the extent
+    float        *attributes; // per vertex, multiplied by their weights
+    Mesh_Quadric *geometry;   // per group
+    Mesh_Quadric *attribute;  // per group, the position part of the attribute quadrics
+    float        *terms;      // per vertex, MESH_SIMPLIFY_ATTRIBUTE_TERMS per channel
+
+    u32            *indices;
+    u32            *group_indices;
+    u32             index_count;
+    Mesh_Adjacency  adjacency; // over group indices
+};
+
+struct Mesh_Simplify_Collapse {
+    u32   from;
+    u32   to;
+    float cost;
+};
+
+struct Mesh_Simplify_Wedges {
+    u32 count;
+    u32 from[MESH_SIMPLIFY_MAX_WEDGES];
+    u32 to[MESH_SIMPLIFY_MAX_WEDGES];
+};
+
+inline static void mesh_quadric_add(Mesh_Quadric *q, const Mesh_Quadric *r) {
+    q->a00 += r->a00; q->a11 += r->a11; q->a22 += r->a22;
+    q->a01 += r->a01; q->a02 += r->a02; q->a12 += r->a12;
+    q->b0  += r->b0;  q->b1  += r->b1;  q->b2  += r->b2;
+    q->c   += r->c;
+    q->w   += r->w;
+}
+
+// Add s * (g.p + d)^2. Leaves the area alone, as not every plane comes from a triangle.
+inline static void mesh_quadric_add_plane(Mesh_Quadric *q, const float *g, float d, float s) {
+    q->a00 += s * g[0] * g[0]; q->a11 += s * g[1] * g[1]; q->a22 += s * g[2] * g[2];
+    q->a01 += s * g[0] * g[1]; q->a02 += s * g[0] * g[2]; q->a12 += s * g[1] * g[2];
+    q->b0  += s * d * g[0];    q->b1  += s * d * g[1];    q->b2  += s * d * g[2];
+    q->c   += s * d * d;
+}
+
+inline static float mesh_quadric_eval(const Mesh_Quadric *q, const float *p) {
+    float x = p[0], y = p[1], z = p[2];
+    return q->a00 * x * x + q->a11 * y * y + q->a22 * z * z +
+           2 * (q->a01 * x * y + q->a02 * x * z + q->a12 * y * z) +
+           2 * (q->b0 * x + q->b1 * y + q->b2 * z) + q->c;
+}
+
+inline static void mesh_cross(float *ret, const float *a, const float *b) {
+    ret[0] = a[1] * b[2] - a[2] * b[1];
+    ret[1] = a[2] * b[0] - a[0] * b[2];
+    ret[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+inline static float mesh_dot(const float *a, const float *b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// The value dependent part of a vertex's attribute quadric, for the values 'a' (one per channel) at 'p'.
+inline static float mesh_simplify_eval_terms(const Mesh_Simplify_State *state, u32 vertex, const float *a,
+                                             const float *p)
+{
+    const float *t = state->terms + (u64)vertex * state->channel_count * MESH_SIMPLIFY_ATTRIBUTE_TERMS;
+    float ret = 0;
+    for(u32 i = 0; i < state->channel_count; ++i, t += MESH_SIMPLIFY_ATTRIBUTE_TERMS)
+        ret += -2 * a[i] * (mesh_dot(t, p) + t[3]) + a[i] * a[i] * t[4];
+    return ret;
+}
+
+inline static const float* mesh_simplify_attributes(const Mesh_Simplify_State *state, u32 vertex) {
+    return state->attributes + (u64)vertex * state->channel_count;
+}
+
+// Accumulate a triangle's plane (and its attribute planes) into its corners' quadrics.
+static void mesh_simplify_add_triangle(Mesh_Simplify_State *state, const u32 *tri) {
+    const u32   *g  = state->groups;
+    const float *p0 = state->positions + g[tri[0]] * 3;
+    const float *p1 = state->positions + g[tri[1]] * 3;
+    const float *p2 = state->positions + g[tri[2]] * 3;
+
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    float n[3];
+    mesh_cross(n, e1, e2);
+
+    float length = sqrtf(mesh_dot(n, n));
+    if (length == 0)
+        return;
+
+    float area = length * 0.5f;
+    for(u32 k = 0; k < 3; ++k)
+        n[k] /= length;
+
+    Mesh_Quadric plane = {};
+    mesh_quadric_add_plane(&plane, n, -mesh_dot(n, p0), area);
+    plane.w = area;
+    for(u32 k = 0; k < 3; ++k)
+        mesh_quadric_add(&state->geometry[g[tri[k]]], &plane);
+
+    if (!state->channel_count)
+        return;
+
+    // The gradient in the triangle's plane: g = x * e1 + y * e2, with g.e1 = a1 - a0 and g.e2 = a2 - a0.
+    float d11 = mesh_dot(e1, e1);
+    float d12 = mesh_dot(e1, e2);
+    float d22 = mesh_dot(e2, e2);
+    float det = d11 * d22 - d12 * d12;
+    if (det <= 0)
+        return;
+    det = 1 / det;
+
+    const float *a0 = mesh_simplify_attributes(state, tri[0]);
+    const float *a1 = mesh_simplify_attributes(state, tri[1]);
+    const float *a2 = mesh_simplify_attributes(state, tri[2]);
+
+    Mesh_Quadric attribute = {};
+    float grad[3];
+    float x, y, d;
+    float *t;
+    for(u32 i = 0; i < state->channel_count; ++i) {
+        x = (d22 * (a1[i] - a0[i]) - d12 * (a2[i] - a0[i])) * det;
+        y = (d11 * (a2[i] - a0[i]) - d12 * (a1[i] - a0[i])) * det;
+        for(u32 k = 0; k < 3; ++k)
+            grad[k] = x * e1[k] + y * e2[k];
+        d = a0[i] - mesh_dot(grad, p0);
+
+        mesh_quadric_add_plane(&attribute, grad, d, area);
+        for(u32 k = 0; k < 3; ++k) {
+            t = state->terms + ((u64)tri[k] * state->channel_count + i) * MESH_SIMPLIFY_ATTRIBUTE_TERMS;
+            t[0] += area * grad[0];
+            t[1] += area * grad[1];
+            t[2] += area * grad[2];
+            t[3] += area * d;
+            t[4] += area;
+        }
+    }
+    for(u32 k = 0; k < 3; ++k)
+        mesh_quadric_add(&state->attribute[g[tri[k]]], &attribute);
+}
+
+// A wall through the border edge from corner 'k' of a triangle, perpendicular to the triangle.
+static void mesh_simplify_add_border(Mesh_Simplify_State *state, const u32 *group_tri, u32 k) {
+    const float *p0 = state->positions + group_tri[0] * 3;
+    const float *p1 = state->positions + group_tri[1] * 3;
+    const float *p2 = state->positions + group_tri[2] * 3;
+    const float *a  = state->positions + group_tri[k] * 3;
+    const float *b  = state->positions + group_tri[(k + 1) % 3] * 3;
+
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    float edge[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float n[3];
+    float wall[3];
+    mesh_cross(n, e1, e2);
+    mesh_cross(wall, edge, n);
+
+    float length = sqrtf(mesh_dot(wall, wall));
+    if (length == 0)
+        return;
+    for(u32 i = 0; i < 3; ++i)
+        wall[i] /= length;
+
+    float s = mesh_dot(edge, edge) * MESH_SIMPLIFY_BORDER_WEIGHT;
+    mesh_quadric_add_plane(&state->geometry[group_tri[k]],           wall, -mesh_dot(wall, a), s);
+    mesh_quadric_add_plane(&state->geometry[group_tri[(k + 1) % 3]], wall, -mesh_dot(wall, a), s);
+}
+
+inline static u32 mesh_simplify_corner(const u32 *group_tri, u32 group) {
+    return group_tri[0] == group ? 0 : group_tri[1] == group ? 1 : group_tri[2] == group ? 2 : 3;
+}
+
+// The triangles around 'g0' which also have 'g1'.
+static u32 mesh_simplify_edge_triangle_count(const Mesh_Simplify_State *state, u32 g0, u32 g1) {
+    const Mesh_Adjacency *adj = &state->adjacency;
+    u32 ret = 0;
+    for(u32 i = adj->offsets[g0]; i < adj->offsets[g0 + 1]; ++i)
+        ret += mesh_simplify_corner(state->group_indices + adj->triangles[i] * 3, g1) != 3;
+    return ret;
+}
+
+//
+// Can 'g0' collapse onto 'g1'? They must share an edge: an interior edge (two triangles) if 'g0' is interior, a
+// border edge (one) if 'g0' is on a border, and then only if it is not locked. Every vertex of 'g0' that a
+// triangle uses must have exactly one vertex of 'g1' across the edge on its side of any seam, no triangle may
+// flip, and the edge must pass the link condition (the groups around both ends are only shared by the edge's own
+// triangles), else the collapse would pinch the surface.
+//
+static bool mesh_simplify_check_collapse(Mesh_Simplify_State *state, u32 g0, u32 g1, Mesh_Simplify_Wedges *wedges,
+                                         u32 *ret_removed)
+{
+    if (state->group_flags[g0] & MESH_SIMPLIFY_GROUP_LOCKED_BIT)
+        return false;
+
+    const Mesh_Adjacency *adj = &state->adjacency;
+    const float          *p0  = state->positions + g0 * 3;
+    const float          *p1  = state->positions + g1 * 3;
+
+    state->stamp += 2;
+    u32 stamp = state->stamp;
+
+    wedges->count = 0;
+
+    const u32 *group_tri;
+    const u32 *tri;
+    const float *a, *b;
+    float ea[3], eb[3], n0[3], n1[3];
+    u32 c0, c1, w, j;
+    u32 shared = 0;
+    for(u32 i = adj->offsets[g0]; i < adj->offsets[g0 + 1]; ++i) {
+        group_tri = state->group_indices + adj->triangles[i] * 3;
+        tri       = state->indices       + adj->triangles[i] * 3;
+        c0        = mesh_simplify_corner(group_tri, g0);
+        c1        = mesh_simplify_corner(group_tri, g1);
+
+        state->stamps[group_tri[(c0 + 1) % 3]] = stamp;
+        state->stamps[group_tri[(c0 + 2) % 3]] = stamp;
+
+        w = tri[c0];
+        for(j = 0; j < wedges->count && wedges->from[j] != w; ++j)
+            ;
+        if (j == wedges->count) {
+            if (j == MESH_SIMPLIFY_MAX_WEDGES)
+                return false;
+            wedges->from[j] = w;
+            wedges->to[j]   = Max_u32;
+            wedges->count++;
+        }
+
+        if (c1 != 3) {
+            shared++;
+            if (wedges->to[j] != Max_u32 && wedges->to[j] != tri[c1])
+                return false;
+            wedges->to[j] = tri[c1];
+            continue;
+        }
+
+        a = state->positions + group_tri[(c0 + 1) % 3] * 3;
+        b = state->positions + group_tri[(c0 + 2) % 3] * 3;
+        for(u32 k = 0; k < 3; ++k) {
+            ea[k] = a[k] - p0[k];
+            eb[k] = b[k] - p0[k];
+        }
+        mesh_cross(n0, ea, eb);
+        for(u32 k = 0; k < 3; ++k) {
+            ea[k] = a[k] - p1[k];
+            eb[k] = b[k] - p1[k];
+        }
+        mesh_cross(n1, ea, eb);
+        if (mesh_dot(n0, n1) <= 1e-2f * sqrtf(mesh_dot(n0, n0) * mesh_dot(n1, n1)))
+            return false;
+    }
+
+    for(j = 0; j < wedges->count; ++j)
+        if (wedges->to[j] == Max_u32)
+            return false;
+
+    if (state->group_flags[g0] & MESH_SIMPLIFY_GROUP_BORDER_BIT) {
+        if (shared != 1 || !(state->group_flags[g1] & MESH_SIMPLIFY_GROUP_BORDER_BIT))
+            return false;
+    } else if (shared != 2) {
+        return false;
+    }
+
+    // Link condition: count the groups around 'g1' which are also around 'g0', each once.
+    u32 common = 0;
+    u32 x;
+    for(u32 i = adj->offsets[g1]; i < adj->offsets[g1 + 1]; ++i) {
+        group_tri = state->group_indices + adj->triangles[i] * 3;
+        for(u32 k = 0; k < 3; ++k) {
+            x = group_tri[k];
+            if (x != g0 && x != g1 && state->stamps[x] == stamp) {
+                state->stamps[x] = stamp + 1;
+                common++;
+            }
+        }
+    }
+    if (common != shared)
+        return false;
+
+    *ret_removed = shared;
+    return true;
+}
+
+// Combined geometric and attribute error of collapsing 'g0' onto 'g1', and the geometric part in 'ret_geometry'.
+static float mesh_simplify_collapse_cost(const Mesh_Simplify_State *state, u32 g0, u32 g1,
+                                         const Mesh_Simplify_Wedges *wedges, float *ret_geometry)
+{
+    const float *p = state->positions + g1 * 3;
+
+    Mesh_Quadric q = state->geometry[g0];
+    mesh_quadric_add(&q, &state->geometry[g1]);
+
+    float scale = q.w > 0 ? 1 / q.w : 0;
+    float geometry = mesh_quadric_eval(&q, p);
+    geometry = geometry > 0 ? geometry * scale : 0;
+    *ret_geometry = geometry;
+
+    if (!state->channel_count)
+        return geometry;
+
+    q = state->attribute[g0];
+    mesh_quadric_add(&q, &state->attribute[g1]);
+
+    float attribute = mesh_quadric_eval(&q, p);
+    for(u32 v = state->wedge_first[g1]; v != Max_u32; v = state->wedge_next[v])
+        attribute += mesh_simplify_eval_terms(state, v, mesh_simplify_attributes(state, v), p);
+    for(u32 i = 0; i < wedges->count; ++i)
+        attribute += mesh_simplify_eval_terms(state, wedges->from[i], mesh_simplify_attributes(state, wedges->to[i]),
+                                              p);
+
+    return geometry + (attribute > 0 ? attribute * scale : 0);
+}
+
+static int mesh_compare_collapses(const void *a, const void *b) {
+    const Mesh_Simplify_Collapse *x = (const Mesh_Simplify_Collapse*)a;
+    const Mesh_Simplify_Collapse *y = (const Mesh_Simplify_Collapse*)b;
+    return x->cost < y->cost ? -1 : x->cost > y->cost;
+}
+
+// Drop triangles with two corners in one group, and refresh the group indices.
+static void mesh_simplify_compact(Mesh_Simplify_State *state) {
+    u32 *tri;
+    u32  g[3];
+    u32  count = 0;
+    for(u32 i = 0; i < state->index_count; i += 3) {
+        tri  = state->indices + i;
+        g[0] = state->groups[tri[0]];
+        g[1] = state->groups[tri[1]];
+        g[2] = state->groups[tri[2]];
+        if (g[0] == g[1] || g[1] == g[2] || g[0] == g[2])
+            continue;
+
+        memmove(state->indices + count, tri, sizeof(u32) * 3);
+        memcpy(state->group_indices + count, g, sizeof(u32) * 3);
+        count += 3;
+    }
+    state->index_count = count;
+}
+
+u32 mesh_simplify(u32 *dst, const u32 *indices, u32 index_count, const float *positions, u32 position_stride,
+                  u32 vertex_count, u32 attribute_stream_count, const Mesh_Attribute_Stream *attribute_streams,
+                  u32 target_index_count, float target_error, Mesh_Simplify_Flags flags, float *ret_error)
+{
+    assert(index_count % 3 == 0 && "Not a triangle list");
+    *ret_error = 0;
+
+    if (dst != indices)
+        memcpy(dst, indices, sizeof(u32) * index_count);
+    if (!index_count)
+        return 0;
+
+    u64 mark = get_mark_temp();
+
+    Mesh_Simplify_State state = {};
+    state.vertex_count = vertex_count;
+    state.indices      = dst;
+    state.index_count  = index_count;
+
+    for(u32 i = 0; i < attribute_stream_count; ++i)
+        state.channel_count += attribute_streams[i].count;
+    assert(state.channel_count <= MESH_SIMPLIFY_MAX_ATTRIBUTES && "Too many attribute channels");
+
+    // Position groups
+    Mesh_Vertex_Stream position_stream = {positions, sizeof(float) * 3, position_stride};
+    state.groups      = (u32*)malloc_t(sizeof(u32) * vertex_count, 4);
+    state.group_count = mesh_generate_vertex_remap(state.groups, vertex_count, 1, &position_stream);
+
+    state.wedge_first = (u32*)malloc_t(sizeof(u32) * state.group_count, 4);
+    state.wedge_next  = (u32*)malloc_t(sizeof(u32) * vertex_count,      4);
+    memset(state.wedge_first, 0xff, sizeof(u32) * state.group_count);
+    for(u32 i = vertex_count; i > 0; --i) {
+        state.wedge_next[i - 1]                     = state.wedge_first[state.groups[i - 1]];
+        state.wedge_first[state.groups[i - 1]]      = i - 1;
+    }
+
+    state.group_flags = (u8*)malloc_t(state.group_count, 1);
+    state.stamps      = (u32*)malloc_t(sizeof(u32) * state.group_count, 4);
+    memset(state.group_flags, 0, state.group_count);
+    memset(state.stamps,      0, sizeof(u32) * state.group_count);
+
+    // Positions, scaled to the extent so that errors and weights do not depend on the model's units.
+    float min[3] = { 3.4e38f,  3.4e38f,  3.4e38f};
+    float max[3] = {-3.4e38f, -3.4e38f, -3.4e38f};
+    const float *p;
+    for(u32 i = 0; i < vertex_count; ++i) {
+        p = mesh_position(positions, position_stride, i);
+        for(u32 k = 0; k < 3; ++k) {
+            min[k] = p[k] < min[k] ? p[k] : min[k];
+            max[k] = p[k] > max[k] ? p[k] : max[k];
+        }
+    }
+    float extent = max[0] - min[0];
+    extent = max[1] - min[1] > extent ? max[1] - min[1] : extent;
+    extent = max[2] - min[2] > extent ? max[2] - min[2] : extent;
+    float scale = extent > 0 ? 1 / extent : 1;
+
+    state.positions = (float*)malloc_t(sizeof(float) * 3 * state.group_count, 4);
+    for(u32 i = 0; i < vertex_count; ++i) {
+        p = mesh_position(positions, position_stride, i);
+        for(u32 k = 0; k < 3; ++k)
+            state.positions[state.groups[i] * 3 + k] = (p[k] - min[k]) * scale;
+    }
+
+    u32 terms_size = state.channel_count * MESH_SIMPLIFY_ATTRIBUTE_TERMS;
+    state.attributes = (float*)malloc_t(sizeof(float) * state.channel_count * vertex_count + 4, 4);
+    state.terms      = (float*)malloc_t(sizeof(float) * terms_size * vertex_count + 4, 4);
+    memset(state.terms, 0, sizeof(float) * terms_size * vertex_count);
+
+    u32 channel = 0;
+    const float *a;
+    for(u32 i = 0; i < attribute_stream_count; ++i) {
+        for(u32 v = 0; v < vertex_count; ++v) {
+            a = mesh_position(attribute_streams[i].data, attribute_streams[i].stride, v);
+            for(u32 k = 0; k < attribute_streams[i].count; ++k)
+                state.attributes[v * state.channel_count + channel + k] = a[k] * attribute_streams[i].weight;
+        }
+        channel += attribute_streams[i].count;
+    }
+
+    state.geometry  = (Mesh_Quadric*)malloc_t(sizeof(Mesh_Quadric) * state.group_count, 4);
+    state.attribute = (Mesh_Quadric*)malloc_t(sizeof(Mesh_Quadric) * state.group_count, 4);
+    memset(state.geometry,  0, sizeof(Mesh_Quadric) * state.group_count);
+    memset(state.attribute, 0, sizeof(Mesh_Quadric) * state.group_count);
+
+    state.group_indices = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    mesh_simplify_compact(&state);
+
+    for(u32 i = 0; i < state.index_count; i += 3)
+        mesh_simplify_add_triangle(&state, state.indices + i);
+
+    // Borders: edges with one triangle.
+    state.adjacency = mesh_build_adjacency(state.group_indices, state.index_count, state.group_count);
+
+    const u32 *group_tri;
+    for(u32 i = 0; i < state.index_count; i += 3) {
+        group_tri = state.group_indices + i;
+        for(u32 k = 0; k < 3; ++k) {
+            if (mesh_simplify_edge_triangle_count(&state, group_tri[k], group_tri[(k + 1) % 3]) != 1)
+                continue;
+
+            state.group_flags[group_tri[k]]           |= MESH_SIMPLIFY_GROUP_BORDER_BIT;
+            state.group_flags[group_tri[(k + 1) % 3]] |= MESH_SIMPLIFY_GROUP_BORDER_BIT;
+            mesh_simplify_add_border(&state, group_tri, k);
+        }
+    }
+    if (flags & MESH_SIMPLIFY_LOCK_BORDER_BIT) {
+        for(u32 i = 0; i < state.group_count; ++i)
+            if (state.group_flags[i] & MESH_SIMPLIFY_GROUP_BORDER_BIT)
+                state.group_flags[i] |= MESH_SIMPLIFY_GROUP_LOCKED_BIT;
+    }
+
+    // Passes
+    Mesh_Simplify_Collapse *collapses = (Mesh_Simplify_Collapse*)malloc_t(sizeof(Mesh_Simplify_Collapse) * index_count, 4);
+    u32                    *remap     = (u32*)malloc_t(sizeof(u32) * vertex_count, 4);
+
+    float error_limit    = target_error * target_error;
+    float result_error   = 0;
+    u64   adjacency_mark = get_mark_temp();
+
+    Mesh_Simplify_Wedges wedges;
+    float cost, reverse_cost, geometry;
+    float pass_limit;
+    u32   collapse_count, applied, removed, removed_goal, goal, g0, g1;
+    while(state.index_count > target_index_count) {
+        reset_to_mark_temp(adjacency_mark);
+        state.adjacency = mesh_build_adjacency(state.group_indices, state.index_count, state.group_count);
+
+        // Every edge, in its cheaper direction.
+        collapse_count = 0;
+        for(u32 i = 0; i < state.index_count; i += 3) {
+            group_tri = state.group_indices + i;
+            for(u32 k = 0; k < 3; ++k) {
+                g0 = group_tri[k];
+                g1 = group_tri[(k + 1) % 3];
+
+                cost         = 3.4e38f;
+                reverse_cost = 3.4e38f;
+                if (mesh_simplify_check_collapse(&state, g0, g1, &wedges, &removed))
+                    cost = mesh_simplify_collapse_cost(&state, g0, g1, &wedges, &geometry);
+                if (mesh_simplify_check_collapse(&state, g1, g0, &wedges, &removed))
+                    reverse_cost = mesh_simplify_collapse_cost(&state, g1, g0, &wedges, &geometry);
+
+                if (cost > error_limit && reverse_cost > error_limit)
+                    continue;
+
+                collapses[collapse_count].from = cost <= reverse_cost ? g0 : g1;
+                collapses[collapse_count].to   = cost <= reverse_cost ? g1 : g0;
+                collapses[collapse_count].cost = cost <= reverse_cost ? cost : reverse_cost;
+                collapse_count++;
+            }
+        }
+        qsort(collapses, collapse_count, sizeof(Mesh_Simplify_Collapse), mesh_compare_collapses);
+
+        for(u32 i = 0; i < vertex_count; ++i)
+            remap[i] = i;
+        for(u32 i = 0; i < state.group_count; ++i)
+            state.group_flags[i] &= ~MESH_SIMPLIFY_GROUP_DIRTY_BIT;
+
+        // Most collapses remove two triangles, and the ones which a pass skips are the neighbours of cheaper ones,
+        // so allow a little over the cost of the collapse which would reach the goal, but no more: anything past
+        // that is better left to a later pass, once the cheap collapses have all been taken.
+        applied      = 0;
+        removed_goal = (state.index_count - target_index_count + 2) / 3;
+        goal         = removed_goal / 2 < collapse_count ? removed_goal / 2 : collapse_count - 1;
+        pass_limit   = collapse_count ? collapses[goal].cost * MESH_SIMPLIFY_PASS_COST_BOUND : 0;
+        for(u32 i = 0; i < collapse_count && removed_goal > 0 && collapses[i].cost <= pass_limit; ++i) {
+            g0 = collapses[i].from;
+            g1 = collapses[i].to;
+            if ((state.group_flags[g0] | state.group_flags[g1]) &
+                (MESH_SIMPLIFY_GROUP_REMOVED_BIT | MESH_SIMPLIFY_GROUP_DIRTY_BIT))
+                continue;
+
+            // Both ends are untouched since the candidates were checked, so this only fetches the wedges again.
+            bool ok = mesh_simplify_check_collapse(&state, g0, g1, &wedges, &removed);
+            assert(ok && "Collapse went stale during its pass");
+            if (!ok)
+                continue;
+
+            mesh_simplify_collapse_cost(&state, g0, g1, &wedges, &geometry);
+            result_error = geometry > result_error ? geometry : result_error;
+
+            float *from_terms, *to_terms;
+            for(u32 j = 0; j < wedges.count; ++j) {
+                remap[wedges.from[j]] = wedges.to[j];
+
+                from_terms = state.terms + (u64)wedges.from[j] * terms_size;
+                to_terms   = state.terms + (u64)wedges.to[j]   * terms_size;
+                for(u32 k = 0; k < terms_size; ++k)
+                    to_terms[k] += from_terms[k];
+            }
+            mesh_quadric_add(&state.geometry[g1],  &state.geometry[g0]);
+            mesh_quadric_add(&state.attribute[g1], &state.attribute[g0]);
+
+            state.group_flags[g0] |= MESH_SIMPLIFY_GROUP_REMOVED_BIT;
+            for(u32 j = state.adjacency.offsets[g0]; j < state.adjacency.offsets[g0 + 1]; ++j) {
+                group_tri = state.group_indices + state.adjacency.triangles[j] * 3;
+                for(u32 k = 0; k < 3; ++k)
+                    state.group_flags[group_tri[k]] |= MESH_SIMPLIFY_GROUP_DIRTY_BIT;
+            }
+
+            removed_goal = removed < removed_goal ? removed_goal - removed : 0;
+            applied++;
+        }
+        if (!applied)
+            break;
+
+        for(u32 i = 0; i < state.index_count; ++i)
+            state.indices[i] = remap[state.indices[i]];
+        mesh_simplify_compact(&state);
+    }
+
+    reset_to_mark_temp(mark);
+
+    *ret_error = sqrtf(result_error) * extent;
+    return state.index_count;
+}
+
+                                    /* Vertex Quantization */
+
+Vertex_Dequantize mesh_get_position_dequantize(const float *min, const float *max, const float *step) {
+    Vertex_Dequantize ret;
+    for(u32 i = 0; i < 3; ++i) {
+        ret.scale[i]  = step ? step[i] : (max[i] - min[i]) / Max_u16;
+        ret.scale[i]  = ret.scale[i] > 0 ? ret.scale[i] : 1; // Flat, every position quantizes to 0.
+        ret.offset[i] = step ? floorf(min[i] / ret.scale[i]) * ret.scale[i] : min[i];
+    }
+    return ret;
+}
+
+void mesh_quantize_positions(u16 *dst, const float *positions, u32 position_stride, u32 vertex_count,
+                             const Vertex_Dequantize *dequantize)
+{
+    const float *p;
+    float q;
+    for(u32 i = 0; i < vertex_count; ++i) {
+        p = (const float*)((const u8*)positions + (u64)i * position_stride);
+        for(u32 j = 0; j < 3; ++j) {
+            q = (p[j] - dequantize->offset[j]) / dequantize->scale[j] + 0.5f;
+            q = q < 0 ? 0 : q;
+            q = q > Max_u16 ? Max_u16 : q;
+            dst[i * 4 + j] = (u16)q;
+        }
+        dst[i * 4 + 3] = 0;
+    }
+}
+
+void mesh_decode_octahedral(float *ret_n, float x, float y) {
+    float z = 1 - fabsf(x) - fabsf(y);
+    float t = z < 0 ? -z : 0; // Unfold the lower hemisphere.
+    x += x >= 0 ? -t : t;
+    y += y >= 0 ? -t : t;
+
+    float l = sqrtf(x * x + y * y + z * z);
+    ret_n[0] = x / l;
+    ret_n[1] = y / l;
+    ret_n[2] = z / l;
+}
+
+// Octahedral snorm of 'max' (127 or 32767) for 'n', trying every rounding of the two components and keeping the
+// closest, which takes about a third off the worst case over rounding to nearest.
+static void mesh_encode_octahedral(s32 *ret, const float *n, s32 max) {
+    float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    if (l1 == 0) {
+        ret[0] = 0;
+        ret[1] = 0;
+        return;
+    }
+
+    float x = n[0] / l1;
+    float y = n[1] / l1;
+    if (n[2] < 0) {
+        float fold_x = (1 - fabsf(y)) * (x >= 0 ? 1 : -1);
+        float fold_y = (1 - fabsf(x)) * (y >= 0 ? 1 : -1);
+        x = fold_x;
+        y = fold_y;
+    }
+
+    float l = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    float u[3] = {n[0] / l, n[1] / l, n[2] / l};
+
+    s32   qx = (s32)floorf(x * max);
+    s32   qy = (s32)floorf(y * max);
+    s32   cx, cy;
+    float d[3];
+    float best = -2;
+    float dot;
+    for(u32 i = 0; i < 4; ++i) {
+        cx = qx + (s32)(i & 1);
+        cy = qy + (s32)(i >> 1);
+        cx = cx > max ? max : (cx < -max ? -max : cx);
+        cy = cy > max ? max : (cy < -max ? -max : cy);
+
+        mesh_decode_octahedral(d, (float)cx / max, (float)cy / max);
+        dot = d[0] * u[0] + d[1] * u[1] + d[2] * u[2];
+        if (dot > best) {
+            best   = dot;
+            ret[0] = cx;
+            ret[1] = cy;
+        }
+    }
+}
+
+// Store 'count' snorm components to vertex 'i' of 'dst'.
+inline static void mesh_store_snorm(void *dst, u32 bits, u32 i, u32 count, const s32 *values) {
+    for(u32 j = 0; j < count; ++j) {
+        if (bits == 8)
+            ((s8*) dst)[i * count + j] = (s8) values[j];
+        else
+            ((s16*)dst)[i * count + j] = (s16)values[j];
+    }
+}
+
+void mesh_encode_normals_octahedral(void *dst, u32 bits, const float *normals, u32 normal_stride, u32 vertex_count) {
+    assert((bits == 8 || bits == 16) && "Octahedral normals are snorm8 or snorm16");
+    s32 max = bits == 8 ? Max_s8 : Max_s16;
+
+    s32 q[2];
+    for(u32 i = 0; i < vertex_count; ++i) {
+        mesh_encode_octahedral(q, (const float*)((const u8*)normals + (u64)i * normal_stride), max);
+        mesh_store_snorm(dst, bits, i, 2, q);
+    }
+}
+
+void mesh_encode_tangents_octahedral(void *dst, u32 bits, const float *tangents, u32 tangent_stride,
+                                     u32 vertex_count)
+{
+    assert((bits == 8 || bits == 16) && "Octahedral tangents are snorm8 or snorm16");
+    s32 max = bits == 8 ? Max_s8 : Max_s16;
+
+    const float *t;
+    s32 q[4];
+    for(u32 i = 0; i < vertex_count; ++i) {
+        t = (const float*)((const u8*)tangents + (u64)i * tangent_stride);
+        mesh_encode_octahedral(q, t, max);
+        q[2] = t[3] < 0 ? -max : max;
+        q[3] = 0;
+        mesh_store_snorm(dst, bits, i, 4, q);
+    }
+}
+
+void mesh_encode_half(u16 *dst, const float *src, u32 src_stride, u32 component_count, u32 vertex_count) {
+    const float *v;
+    for(u32 i = 0; i < vertex_count; ++i) {
+        v = (const float*)((const u8*)src + (u64)i * src_stride);
+        for(u32 j = 0; j < component_count; ++j)
+            dst[i * component_count + j] = float_to_half(v[j]);
+    }
+}
+
+                                        /* Index Narrowing */
+
+u32 mesh_split_index_ranges(Mesh_Index_Range *ranges, u32 max_range_count, const u32 *indices, u32 index_count,
+                            u32 max_vertex_span)
+{
+    assert(index_count % 3 == 0 && "Indices are not a triangle list");
+
+    u32 count = 0;
+    u32 range_min, range_max;
+    u32 tri_min, tri_max;
+    for(u32 i = 0; i < index_count; i += 3) {
+        tri_min = indices[i];
+        tri_max = indices[i];
+        for(u32 j = 1; j < 3; ++j) {
+            tri_min = indices[i + j] < tri_min ? indices[i + j] : tri_min;
+            tri_max = indices[i + j] > tri_max ? indices[i + j] : tri_max;
+        }
+        if (tri_max - tri_min > max_vertex_span)
+            return Max_u32;
+
+        if (count) {
+            u32 lo = tri_min < range_min ? tri_min : range_min;
+            u32 hi = tri_max > range_max ? tri_max : range_max;
+            if (hi - lo <= max_vertex_span) {
+                range_min = lo;
+                range_max = hi;
+                ranges[count - 1].index_count  += 3;
+                ranges[count - 1].vertex_offset = lo;
+                continue;
+            }
+        }
+
+        if (count == max_range_count)
+            return Max_u32;
+
+        range_min = tri_min;
+        range_max = tri_max;
+        ranges[count++] = {.first_index = i, .index_count = 3, .vertex_offset = tri_min};
+    }
+    return count;
+}
+
+                                        /* Index Compression */
+
+u64 mesh_encode_indices(u8 *dst, const u32 *indices, u32 index_count) {
+    u8 *p = dst;
+    u32 last = 0;
+    u32 v;
+    for(u32 i = 0; i < index_count; ++i) {
+        v    = indices[i] - last;
+        v    = (v << 1) ^ (u32)((s32)v >> 31); // zigzag
+        last = indices[i];
+
+        while(v >= 0x80) {
+            *p++ = (u8)(v | 0x80);
+            v  >>= 7;
+        }
+        *p++ = (u8)v;
+    }
+    return p - dst;
+}
+
+inline static void mesh_store_index(void *dst, u32 index_size, u32 i, u32 index) {
+    if (index_size == 2)
+        ((u16*)dst)[i] = (u16)index;
+    else
+        ((u32*)dst)[i] = index;
+}
+
+// Decode one varint at 'p', advancing it. False if it runs past 'end' or is longer than 5 bytes.
+inline static bool mesh_decode_varint(const u8 **p, const u8 *end, u32 *ret) {
+    u32 v = 0;
+    u8  b;
+    for(u32 shift = 0; shift < 35; shift += 7) {
+        if (*p == end)
+            return false;
+        b  = *(*p)++;
+        v |= (u32)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *ret = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool mesh_decode_indices_scalar(void *dst, u32 index_size, u32 index_count, const u8 *src, u64 src_size) {
+    assert((index_size == 2 || index_size == 4) && "Indices are decoded to u16 or u32");
+
+    const u8 *p   = src;
+    const u8 *end = src + src_size;
+    u32 last = 0;
+    u32 v;
+    for(u32 i = 0; i < index_count; ++i) {
+        if (!mesh_decode_varint(&p, end, &v))
+            return false;
+        last += (v >> 1) ^ (0 - (v & 1));
+        mesh_store_index(dst, index_size, i, last);
+    }
+    return true;
+}
+
+bool mesh_decode_indices(void *dst, u32 index_size, u32 index_count, const u8 *src, u64 src_size) {
+    assert((index_size == 2 || index_size == 4) && "Indices are decoded to u16 or u32");
+
+    const u8 *p   = src;
+    const u8 *end = src + src_size;
+
+    const __m256i one    = _mm256_set1_epi32(1);
+    const __m256i zero   = _mm256_setzero_si256();
+    const __m256i lane_3 = _mm256_set1_epi32(3);
+
+    __m256i d;
+    u32 last = 0;
+    u32 v;
+    u32 i = 0;
+    while(i < index_count) {
+        // Eight one byte varints: the 8 bytes at 'p' (16 are loaded for the mask) have no continuation bits.
+        if (index_count - i >= 8 && end - p >= 16 &&
+            (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p)) & 0xff) == 0)
+        {
+            d = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p));
+            d = _mm256_xor_si256(_mm256_srli_epi32(d, 1), _mm256_sub_epi32(zero, _mm256_and_si256(d, one)));
+
+            // Inclusive prefix sum: within each 128 bit lane, then the low lane's total into the high lane.
+            d = _mm256_add_epi32(d, _mm256_slli_si256(d, 4));
+            d = _mm256_add_epi32(d, _mm256_slli_si256(d, 8));
+            d = _mm256_add_epi32(d, _mm256_blend_epi32(zero, _mm256_permutevar8x32_epi32(d, lane_3), 0xf0));
+            d = _mm256_add_epi32(d, _mm256_set1_epi32((s32)last));
+
+            if (index_size == 4) {
+                _mm256_storeu_si256((__m256i*)((u32*)dst + i), d);
+            } else {
+                // Indices fit 16 bits here, so saturating is truncating. packus interleaves the 128 bit lanes.
+                __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(d, d), 0x08);
+                _mm_storeu_si128((__m128i*)((u16*)dst + i), _mm256_castsi256_si128(packed));
+            }
+
+            last = (u32)_mm256_extract_epi32(d, 7);
+            p += 8;
+            i += 8;
+            continue;
+        }
+
+        if (!mesh_decode_varint(&p, end, &v))
+            return false;
+        last += (v >> 1) ^ (0 - (v & 1));
+        mesh_store_index(dst, index_size, i, last);
+        i++;
+    }
+    return true;
+}
+
+#if TEST
+static void test_mesh_grid(u32 n, u32 *indices, float *positions) {
+    u32 out = 0;
+    for(u32 y = 0; y < n - 1; ++y)
+        for(u32 x = 0; x < n - 1; ++x) {
+            u32 v = y * n + x;
+            indices[out++] = v;
+            indices[out++] = v + 1;
+            indices[out++] = v + n;
+            indices[out++] = v + n;
+            indices[out++] = v + 1;
+            indices[out++] = v + n + 1;
+        }
+    if (positions)
+        for(u32 i = 0; i < n * n; ++i) {
+            positions[i * 3 + 0] = (float)(i % n);
+            positions[i * 3 + 1] = (float)(i / n);
+            positions[i * 3 + 2] = 0;
+        }
+}
+
+static void test_mesh_shuffle_triangles(u32 *indices, u32 triangle_count, u32 seed) {
+    u32 tmp[3];
+    u32 j;
+    for(u32 i = triangle_count - 1; i > 0; --i) {
+        seed = seed * 1664525 + 1013904223;
+        j = (seed >> 8) % (i + 1);
+        memcpy(tmp,              indices + i * 3, sizeof(tmp));
+        memcpy(indices + i * 3,  indices + j * 3, sizeof(tmp));
+        memcpy(indices + j * 3,  tmp,             sizeof(tmp));
+    }
+}
+
+static int test_mesh_compare_u64(const void *a, const void *b) {
+    u64 x = *(const u64*)a;
+    u64 y = *(const u64*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Triangles as rotation invariant (winding preserving) keys, sorted, so two lists can be compared as sets.
+static u64* test_mesh_triangle_keys(const u32 *indices, u32 triangle_count) {
+    u64 *keys = (u64*)malloc_t(sizeof(u64) * triangle_count, 8);
+    const u32 *t;
+    u32 r;
+    for(u32 i = 0; i < triangle_count; ++i) {
+        t = indices + i * 3;
+        r = t[0] < t[1] ? (t[0] < t[2] ? 0 : 2) : (t[1] < t[2] ? 1 : 2);
+        keys[i] = ((u64)t[r] << 42) | ((u64)t[(r + 1) % 3] << 21) | t[(r + 2) % 3];
+    }
+    qsort(keys, triangle_count, sizeof(u64), test_mesh_compare_u64);
+    return keys;
+}
+
+// Total area of a triangle list, or with 'signed_z' the area facing +z less the area facing -z.
+static float test_mesh_area(const u32 *indices, u32 index_count, const float *positions, bool signed_z = false)
+{
+    float ret = 0;
+    float e0[3], e1[3], n[3];
+    const float *p0, *p1, *p2;
+    for(u32 i = 0; i < index_count; i += 3) {
+        p0 = positions + indices[i + 0] * 3;
+        p1 = positions + indices[i + 1] * 3;
+        p2 = positions + indices[i + 2] * 3;
+        for(u32 k = 0; k < 3; ++k) {
+            e0[k] = p1[k] - p0[k];
+            e1[k] = p2[k] - p0[k];
+        }
+        mesh_cross(n, e0, e1);
+        ret += signed_z ? n[2] * 0.5f : sqrtf(mesh_dot(n, n)) * 0.5f;
+    }
+    return ret;
+}
+
+void test_mesh() {
+    u64 mark = get_mark_temp();
+
+    BEGIN_TEST_MODULE("Mesh_Vertex_Cache", false, false);
+
+    // Hand counted: the second triangle shares an edge, so misses once.
+    u32 quad[6] = {0, 1, 2, 2, 1, 3};
+    Vertex_Cache_Stats quad_stats = mesh_analyze_vertex_cache(quad, 6, 4, MESH_VERTEX_CACHE_SIZE);
+    TEST_EQ("quad_transformed", quad_stats.vertices_transformed, 4, false);
+    TEST_EQ("quad_vertices",    quad_stats.vertex_count,         4, false);
+    TEST_FEQ("quad_acmr",       quad_stats.acmr,              2.0f, false);
+    TEST_FEQ("quad_atvr",       quad_stats.atvr,              1.0f, false);
+
+    // Cache of 3: 0 1 2 | 3 evicts 0 | 0 misses again.
+    u32 evict[9] = {0, 1, 2, 1, 2, 3, 3, 2, 0};
+    TEST_EQ("fifo_eviction", mesh_analyze_vertex_cache(evict, 9, 4, 3).vertices_transformed, 5, false);
+
+    const u32 n              = 64;
+    const u32 vertex_count   = n * n;
+    const u32 triangle_count = (n - 1) * (n - 1) * 2;
+    const u32 index_count    = triangle_count * 3;
+
+    u32 *grid = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    u32 *opt  = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    float *positions = (float*)malloc_t(sizeof(float) * 3 * vertex_count, 4);
+    test_mesh_grid(n, grid, positions);
+    test_mesh_shuffle_triangles(grid, triangle_count, 777);
+
+    Vertex_Cache_Stats before = mesh_analyze_vertex_cache(grid, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    mesh_optimize_vertex_cache(opt, grid, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    Vertex_Cache_Stats after = mesh_analyze_vertex_cache(opt, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+
+    // The test macros compare integers, so acmr and atvr are checked through the miss counts.
+    TEST_LT("shuffled_acmr_over_2", triangle_count * 2,         before.vertices_transformed, false);
+    TEST_LT("tipsify_acmr_under_08", after.vertices_transformed, triangle_count * 4 / 5,     false);
+    TEST_LT("tipsify_atvr_under_15", after.vertices_transformed, vertex_count * 3 / 2,       false);
+    TEST_EQ("same_vertex_count", after.vertex_count, vertex_count, false);
+
+    u64 *keys_before = test_mesh_triangle_keys(grid, triangle_count);
+    u64 *keys_after  = test_mesh_triangle_keys(opt,  triangle_count);
+    TEST_EQ("same_triangles", memcmp(keys_before, keys_after, sizeof(u64) * triangle_count), 0, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Mesh_Overdraw", false, false);
+
+    // A floor grid at z = 0 and a roof grid at z = 1, both facing +z, floor first. The roof lies out along its
+    // normal from the center, so it should now draw first (from above, it hides the floor).
+    const u32 m        = 16;
+    const u32 m_tris   = (m - 1) * (m - 1) * 2;
+    const u32 m_verts  = m * m;
+    u32   *layers      = (u32*)  malloc_t(sizeof(u32)   * m_tris * 3 * 2, 4);
+    u32   *layers_opt  = (u32*)  malloc_t(sizeof(u32)   * m_tris * 3 * 2, 4);
+    u32   *layers_out  = (u32*)  malloc_t(sizeof(u32)   * m_tris * 3 * 2, 4);
+    float *layer_pos   = (float*)malloc_t(sizeof(float) * m_verts * 3 * 2, 4);
+    test_mesh_grid(m, layers, layer_pos);
+    test_mesh_grid(m, layers + m_tris * 3, layer_pos + m_verts * 3);
+    for(u32 i = 0; i < m_tris * 3; ++i)
+        layers[m_tris * 3 + i] += m_verts;
+    for(u32 i = 0; i < m_verts; ++i)
+        layer_pos[(m_verts + i) * 3 + 2] = 1;
+
+    mesh_optimize_vertex_cache(layers_opt, layers, m_tris * 6, m_verts * 2, MESH_VERTEX_CACHE_SIZE);
+    TEST_LT("floor_first_in", layers_opt[0], m_verts, false);
+
+    mesh_optimize_overdraw(layers_out, layers_opt, m_tris * 6, layer_pos, sizeof(float) * 3, m_verts * 2,
+                           MESH_VERTEX_CACHE_SIZE, MESH_OVERDRAW_THRESHOLD);
+    TEST_LT("roof_first_out", m_verts - 1, layers_out[0], false);
+    TEST_LT("floor_last_out", layers_out[m_tris * 6 - 1], m_verts, false);
+
+    Vertex_Cache_Stats tipsify  = mesh_analyze_vertex_cache(layers_opt, m_tris * 6, m_verts * 2, MESH_VERTEX_CACHE_SIZE);
+    Vertex_Cache_Stats overdraw = mesh_analyze_vertex_cache(layers_out, m_tris * 6, m_verts * 2, MESH_VERTEX_CACHE_SIZE);
+    TEST_LT("acmr_near_tipsify", overdraw.vertices_transformed, tipsify.vertices_transformed * 5 / 4, false);
+
+    keys_before = test_mesh_triangle_keys(layers_opt, m_tris * 2);
+    keys_after  = test_mesh_triangle_keys(layers_out, m_tris * 2);
+    TEST_EQ("same_triangles", memcmp(keys_before, keys_after, sizeof(u64) * m_tris * 2), 0, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Mesh_Vertex_Remap", false, false);
+
+    // Unindexed grid: three vertices per triangle, welded back to the grid's vertices.
+    u32   *soup_indices = (u32*)  malloc_t(sizeof(u32)   * index_count, 4);
+    float *soup_pos     = (float*)malloc_t(sizeof(float) * 3 * index_count, 4);
+    u16   *soup_ids     = (u16*)  malloc_t(sizeof(u16)   * index_count, 4);
+    test_mesh_grid(n, grid, NULL);
+    for(u32 i = 0; i < index_count; ++i) {
+        soup_indices[i] = i;
+        memcpy(soup_pos + i * 3, positions + grid[i] * 3, sizeof(float) * 3);
+        soup_ids[i] = (u16)grid[i]; // second stream, so both streams have to match
+    }
+
+    Mesh_Vertex_Stream streams[] = {
+        {.data = soup_pos, .size = sizeof(float) * 3, .stride = sizeof(float) * 3},
+        {.data = soup_ids, .size = sizeof(u16),       .stride = sizeof(u16)},
+    };
+    u32 *remap  = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    u32  unique = mesh_generate_vertex_remap(remap, index_count, 2, streams);
+    TEST_EQ("weld_count", unique, vertex_count, false);
+
+    mesh_remap_indices(soup_indices, soup_indices, index_count, remap);
+    float *welded = (float*)malloc_t(sizeof(float) * 3 * unique, 4);
+    mesh_remap_vertices(welded, sizeof(float) * 3, soup_pos, sizeof(float) * 3, sizeof(float) * 3, index_count, remap);
+
+    bool same = true;
+    for(u32 i = 0; i < index_count; ++i)
+        same &= memcmp(welded + soup_indices[i] * 3, positions + grid[i] * 3, sizeof(float) * 3) == 0;
+    TEST_EQ("weld_positions", same, true, false);
+
+    // A vertex differing in one stream only is not welded.
+    soup_ids[5] ^= 0x8000;
+    TEST_EQ("weld_streams", mesh_generate_vertex_remap(remap, index_count, 2, streams), vertex_count + 1, false);
+
+    // Fetch order: 3 is never referenced, the rest are renumbered by first use.
+    u32 fetch_indices[6] = {4, 2, 0, 0, 2, 1};
+    u32 fetch_remap[5];
+    TEST_EQ("fetch_count", mesh_generate_vertex_fetch_remap(fetch_remap, fetch_indices, 6, 5), 4, false);
+    TEST_EQ("fetch_dropped", fetch_remap[3], Max_u32, false);
+    mesh_remap_indices(fetch_indices, fetch_indices, 6, fetch_remap);
+    u32 fetch_expected[6] = {0, 1, 2, 2, 1, 3};
+    TEST_EQ("fetch_indices", memcmp(fetch_indices, fetch_expected, sizeof(fetch_expected)), 0, false);
+
+    float fetch_vertices[5] = {10, 11, 12, 13, 14};
+    float fetch_out[4];
+    mesh_remap_vertices(fetch_out, sizeof(float), fetch_vertices, sizeof(float), sizeof(float), 5, fetch_remap);
+    float fetch_vertices_expected[4] = {14, 12, 10, 11};
+    TEST_EQ("fetch_vertices", memcmp(fetch_out, fetch_vertices_expected, sizeof(fetch_out)), 0, false);
+
+    // The whole pipeline on the shuffled grid: welded soup -> tipsify -> fetch order.
+    test_mesh_shuffle_triangles(soup_indices, triangle_count, 31337);
+    before = mesh_analyze_vertex_cache(soup_indices, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    mesh_optimize_vertex_cache(opt, soup_indices, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    TEST_EQ("pipeline_fetch_count", mesh_generate_vertex_fetch_remap(remap, opt, index_count, vertex_count),
+            vertex_count, false);
+    mesh_remap_indices(opt, opt, index_count, remap);
+    after = mesh_analyze_vertex_cache(opt, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    TEST_LT("pipeline_acmr", after.vertices_transformed, before.vertices_transformed / 2, false);
+
+    u32  next    = 0;
+    bool ordered = true;
+    for(u32 i = 0; i < index_count; ++i) {
+        ordered &= opt[i] <= next;
+        next    += opt[i] == next;
+    }
+    TEST_EQ("pipeline_fetch_ordered", ordered, true, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Mesh_Meshlets", false, false);
+
+    test_mesh_grid(n, grid, positions);
+    test_mesh_shuffle_triangles(grid, triangle_count, 4242);
+    mesh_optimize_vertex_cache(opt, grid, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+
+    u32      meshlet_bound     = mesh_get_meshlet_bound(index_count, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES);
+    Meshlet *meshlets          = (Meshlet*)malloc_t(sizeof(Meshlet) * meshlet_bound, 4);
+    u32     *meshlet_vertices  = (u32*)    malloc_t(sizeof(u32) * index_count, 4);
+    u8      *meshlet_triangles = (u8*)     malloc_t(index_count, 4);
+    u32 meshlet_count = mesh_build_meshlets(meshlets, meshlet_vertices, meshlet_triangles, opt, index_count,
+                                            positions, sizeof(float) * 3, vertex_count, MESHLET_MAX_VERTICES,
+                                            MESHLET_MAX_TRIANGLES);
+    TEST_LT("within_bound", meshlet_count, meshlet_bound + 1, false);
+
+    // Coverage: expanding every meshlet gives back exactly the input triangles.
+    u32 *expanded     = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    u32  out          = 0;
+    u32  total_verts  = 0;
+    bool within_limit = true;
+    bool contiguous   = true;
+    for(u32 i = 0; i < meshlet_count; ++i) {
+        within_limit &= meshlets[i].vertex_count   <= MESHLET_MAX_VERTICES;
+        within_limit &= meshlets[i].triangle_count <= MESHLET_MAX_TRIANGLES;
+        contiguous   &= meshlets[i].vertex_offset   == total_verts;
+        contiguous   &= meshlets[i].triangle_offset == out / 3;
+        for(u32 j = 0; j < meshlets[i].triangle_count * 3; ++j) {
+            u8 local = meshlet_triangles[meshlets[i].triangle_offset * 3 + j];
+            within_limit &= local < meshlets[i].vertex_count;
+            expanded[out++] = meshlet_vertices[meshlets[i].vertex_offset + local];
+        }
+        total_verts += meshlets[i].vertex_count;
+    }
+    TEST_EQ("within_limits",  within_limit, true, false);
+    TEST_EQ("contiguous",     contiguous,   true, false);
+    TEST_EQ("triangle_count", out,          index_count, false);
+
+    keys_before = test_mesh_triangle_keys(opt,      triangle_count);
+    keys_after  = test_mesh_triangle_keys(expanded, triangle_count);
+    TEST_EQ("exact_cover", memcmp(keys_before, keys_after, sizeof(u64) * triangle_count), 0, false);
+
+    // Quality: a 64 vertex patch of a grid holds ~98 triangles (8x8), and vertices shared between meshlets are
+    // loaded once per meshlet.
+    TEST_LT("fill_over_80_triangles", meshlet_count * 80, triangle_count, false);
+    TEST_LT("vertex_reuse_under_14",  total_verts * 10, vertex_count * 14, false);
+
+    // Bounds: every vertex in its sphere, and a flat +z grid has a zero width cone along +z.
+    Meshlet_Bounds *bounds = (Meshlet_Bounds*)malloc_t(sizeof(Meshlet_Bounds) * meshlet_count, 4);
+    bool in_sphere = true;
+    bool flat_cone = true;
+    for(u32 i = 0; i < meshlet_count; ++i) {
+        bounds[i] = mesh_compute_meshlet_bounds(&meshlets[i], meshlet_vertices, meshlet_triangles, positions,
+                                                sizeof(float) * 3);
+        for(u32 j = 0; j < meshlets[i].vertex_count; ++j)
+            in_sphere &= mesh_distance(positions + meshlet_vertices[meshlets[i].vertex_offset + j] * 3,
+                                       bounds[i].center) <= bounds[i].radius * 1.0001f;
+        flat_cone &= bounds[i].cone_cutoff < 0.001f && bounds[i].cone_axis[2] > 0.999f;
+    }
+    TEST_EQ("vertices_in_sphere", in_sphere, true, false);
+    TEST_EQ("flat_cone",          flat_cone, true, false);
+
+    Meshlet_Cull_Info cull = {};
+    u32 *visible = (u32*)malloc_t(sizeof(u32) * meshlet_count, 4);
+
+    cull.eye[0] = 32; cull.eye[1] = 32; cull.eye[2] = 10;
+    TEST_EQ("front_visible", mesh_cull_meshlets(visible, meshlet_count, bounds, &cull), meshlet_count, false);
+    TEST_EQ("front_compacted", visible[meshlet_count - 1], meshlet_count - 1, false);
+
+    cull.eye[2] = -10;
+    TEST_EQ("back_culled", mesh_cull_meshlets(visible, meshlet_count, bounds, &cull), 0, false);
+
+    // x <= 16 (which some meshlets straddle) from the front.
+    cull.eye[2] = 10;
+    cull.planes[0][0] = -1;
+    cull.planes[0][3] = 16;
+    u32 half = mesh_cull_meshlets(visible, meshlet_count, bounds, &cull);
+    bool half_correct = true;
+    for(u32 i = 0; i < half; ++i)
+        half_correct &= bounds[visible[i]].center[0] - bounds[visible[i]].radius <= 16;
+    TEST_LT("plane_culls", half, meshlet_count, false);
+    TEST_LT("plane_keeps", 0, half, false);
+    TEST_EQ("plane_conservative", half_correct, true, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Mesh_Simplify", false, false);
+
+    u32   *simple = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    float  simple_error;
+    u32    simple_count;
+
+    // A flat grid only needs its border: nothing moves off the plane, the area stays and no triangle flips.
+    test_mesh_grid(n, grid, positions);
+    simple_count = mesh_simplify(simple, grid, index_count, positions, sizeof(float) * 3, vertex_count, 0, NULL, 0,
+                                 1e-3f, MESH_SIMPLIFY_LOCK_BORDER_BIT, &simple_error);
+    TEST_LT("flat_reduced",  simple_count * 10, index_count, false);
+    TEST_FEQ("flat_error",   simple_error, 0, false);
+    TEST_EQ("flat_area",     (u64)(test_mesh_area(simple, simple_count, positions) + 0.5f), (n - 1) * (n - 1), false);
+    TEST_EQ("flat_no_flips", test_mesh_area(simple, simple_count, positions) ==
+                             test_mesh_area(simple, simple_count, positions, true), true, false);
+
+    bool *referenced = (bool*)malloc_t(vertex_count, 1);
+    memset(referenced, 0, vertex_count);
+    for(u32 i = 0; i < simple_count; ++i)
+        referenced[simple[i]] = true;
+    bool border_kept = true;
+    for(u32 i = 0; i < vertex_count; ++i)
+        if (i % n == 0 || i % n == n - 1 || i / n == 0 || i / n == n - 1)
+            border_kept &= referenced[i];
+    TEST_EQ("locked_border_kept", border_kept, true, false);
+
+    // Unlocked, the border may collapse along itself, but its walls keep the outline.
+    simple_count = mesh_simplify(simple, grid, index_count, positions, sizeof(float) * 3, vertex_count, 0, NULL, 0,
+                                 1e-3f, 0, &simple_error);
+    TEST_LT("unlocked_reduced", simple_count * 100, index_count, false);
+    TEST_EQ("unlocked_area", (u64)(test_mesh_area(simple, simple_count, positions) + 0.5f), (n - 1) * (n - 1), false);
+
+    // A bumpy grid stops at the error limit, and reports an error within it (in model units, the extent is 63).
+    float *bumpy = (float*)malloc_t(sizeof(float) * 3 * vertex_count, 4);
+    memcpy(bumpy, positions, sizeof(float) * 3 * vertex_count);
+    for(u32 i = 0; i < vertex_count; ++i)
+        bumpy[i * 3 + 2] = sinf(bumpy[i * 3 + 0] * 0.2f) * cosf(bumpy[i * 3 + 1] * 0.15f) * 4;
+
+    float bumpy_error_loose;
+    u32   bumpy_count_loose = mesh_simplify(simple, grid, index_count, bumpy, sizeof(float) * 3, vertex_count, 0,
+                                            NULL, 0, 1e-2f, 0, &bumpy_error_loose);
+    simple_count = mesh_simplify(simple, grid, index_count, bumpy, sizeof(float) * 3, vertex_count, 0, NULL, 0,
+                                 1e-3f, 0, &simple_error);
+    TEST_LT("bumpy_reduced",       simple_count, index_count, false);
+    TEST_LT("bumpy_limit_stops",   bumpy_count_loose, simple_count, false);
+    TEST_EQ("bumpy_error_within",  simple_error      <= 1e-3f * 63, true, false);
+    TEST_EQ("loose_error_within",  bumpy_error_loose <= 1e-2f * 63, true, false);
+    TEST_EQ("loose_error_larger",  bumpy_error_loose > simple_error, true, false);
+
+    // Target count: stops once there, without needing the error limit.
+    simple_count = mesh_simplify(simple, grid, index_count, bumpy, sizeof(float) * 3, vertex_count, 0, NULL,
+                                 index_count / 2, 1, 0, &simple_error);
+    TEST_LT("target_reached",   simple_count, index_count / 2 + 1, false);
+    TEST_LT("target_not_passed", index_count / 4, simple_count, false);
+
+    // A uv seam down the middle: left triangles use copies of the x = n / 2 column with other uvs. The seam must
+    // stay closed, and no triangle may take vertices from both sides.
+    u32    seam_vertex_count = vertex_count + n;
+    float *seam_positions    = (float*)malloc_t(sizeof(float) * 3 * seam_vertex_count, 4);
+    float *seam_uvs          = (float*)malloc_t(sizeof(float) * 2 * seam_vertex_count, 4);
+    u32   *seam_grid         = (u32*)  malloc_t(sizeof(u32) * index_count, 4);
+    memcpy(seam_positions, positions, sizeof(float) * 3 * vertex_count);
+    for(u32 i = 0; i < vertex_count; ++i) {
+        seam_uvs[i * 2 + 0] = (float)(i % n) / n + (i % n >= n / 2 ? 10 : 0);
+        seam_uvs[i * 2 + 1] = (float)(i / n) / n;
+    }
+    for(u32 y = 0; y < n; ++y) {
+        memcpy(seam_positions + (vertex_count + y) * 3, positions + (y * n + n / 2) * 3, sizeof(float) * 3);
+        seam_uvs[(vertex_count + y) * 2 + 0] = 0.5f;
+        seam_uvs[(vertex_count + y) * 2 + 1] = (float)y / n;
+    }
+    for(u32 i = 0; i < index_count; i += 3) {
+        bool left = grid[i] % n + grid[i + 1] % n + grid[i + 2] % n < 3 * (n / 2);
+        for(u32 k = 0; k < 3; ++k)
+            seam_grid[i + k] = left && grid[i + k] % n == n / 2 ? vertex_count + grid[i + k] / n : grid[i + k];
+    }
+
+    Mesh_Attribute_Stream uv_stream = {seam_uvs, sizeof(float) * 2, 2, 1};
+    simple_count = mesh_simplify(simple, seam_grid, index_count, seam_positions, sizeof(float) * 3, seam_vertex_count,
+                                 1, &uv_stream, 0, 1e-3f, 0, &simple_error);
+
+    bool one_side = true;
+    bool is_left[3];
+    for(u32 i = 0; i < simple_count; i += 3) {
+        for(u32 k = 0; k < 3; ++k)
+            is_left[k] = simple[i + k] >= vertex_count || simple[i + k] % n < n / 2;
+        one_side &= is_left[0] == is_left[1] && is_left[1] == is_left[2];
+    }
+    TEST_LT("seam_reduced", simple_count * 10, index_count, false);
+    TEST_EQ("seam_one_side", one_side, true, false);
+    TEST_EQ("seam_closed", (u64)(test_mesh_area(simple, simple_count, seam_positions) + 0.5f), (n - 1) * (n - 1), false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Mesh_Quantize", false, false);
+
+    // Random positions in a box, and a second box sharing its step: every position comes back within half a step,
+    // and a position in both boxes comes back the same from each.
+    const u32 quantize_count = 4096;
+    float *quantize_src = (float*)malloc_t(sizeof(float) * 4 * quantize_count, 4);
+    u16   *quantized    = (u16*)  malloc_t(sizeof(u16)   * 4 * quantize_count, 2);
+
+    u32 seed = 7;
+    auto random_float = [&seed]() {
+        seed = seed * 1664525 + 1013904223;
+        return (float)(seed >> 8) / (1 << 24) * 2 - 1; // [-1, 1)
+    };
+
+    float box_min[3] = {-3,  0.5f, 10};
+    float box_max[3] = { 5,  0.75f, 10}; // flat in z
+    for(u32 i = 0; i < quantize_count; ++i)
+        for(u32 j = 0; j < 3; ++j)
+            quantize_src[i * 3 + j] = box_min[j] + (random_float() * 0.5f + 0.5f) * (box_max[j] - box_min[j]);
+
+    Vertex_Dequantize dequantize = mesh_get_position_dequantize(box_min, box_max, NULL);
+    mesh_quantize_positions(quantized, quantize_src, sizeof(float) * 3, quantize_count, &dequantize);
+
+    float max_step_error = 0;
+    float e;
+    for(u32 i = 0; i < quantize_count; ++i)
+        for(u32 j = 0; j < 3; ++j) {
+            e = fabsf(dequantize.offset[j] + quantized[i * 4 + j] * dequantize.scale[j] - quantize_src[i * 3 + j]);
+            e = e / dequantize.scale[j];
+            max_step_error = e > max_step_error ? e : max_step_error;
+        }
+    TEST_EQ("position_within_half_step", max_step_error <= 0.501f, true, false);
+    TEST_EQ("position_w_zero", quantized[3], 0, false);
+
+    float step[3] = {(box_max[0] - box_min[0]) / 65534, (box_max[1] - box_min[1]) / 65534, 1};
+    float other_min[3] = {1.3f, 0.6f, 10};
+    float other_max[3] = {2.1f, 0.7f, 10};
+    Vertex_Dequantize dequantize_a = mesh_get_position_dequantize(box_min,   box_max,   step);
+    Vertex_Dequantize dequantize_b = mesh_get_position_dequantize(other_min, other_max, step);
+
+    float shared[3] = {1.71234f, 0.6543f, 10};
+    u16   shared_a[4], shared_b[4];
+    mesh_quantize_positions(shared_a, shared, 0, 1, &dequantize_a);
+    mesh_quantize_positions(shared_b, shared, 0, 1, &dequantize_b);
+    bool shared_equal = true;
+    for(u32 j = 0; j < 3; ++j)
+        shared_equal &= fabsf((dequantize_a.offset[j] + shared_a[j] * dequantize_a.scale[j]) -
+                              (dequantize_b.offset[j] + shared_b[j] * dequantize_b.scale[j])) < dequantize_a.scale[j] * 1e-2f;
+    TEST_EQ("shared_step_same_point", shared_equal, true, false);
+
+    mesh_quantize_positions(quantized, quantize_src, sizeof(float) * 3, quantize_count, &dequantize_a);
+    max_step_error = 0;
+    for(u32 i = 0; i < quantize_count; ++i)
+        for(u32 j = 0; j < 2; ++j) {
+            e = fabsf(dequantize_a.offset[j] + quantized[i * 4 + j] * dequantize_a.scale[j] - quantize_src[i * 3 + j]);
+            max_step_error = e / dequantize_a.scale[j] > max_step_error ? e / dequantize_a.scale[j] : max_step_error;
+        }
+    TEST_EQ("snapped_within_half_step", max_step_error <= 0.501f, true, false);
+
+    // Random directions (and the axes, and the fold's edges), decoded as the vertex input would read the snorms.
+    float *directions = quantize_src;
+    float axes[8][4] = {{1, 0, 0, 1}, {-1, 0, 0, -1}, {0, 1, 0, 1}, {0, -1, 0, 1}, {0, 0, 1, -1}, {0, 0, -1, 1},
+                        {0.7071f, 0, -0.7071f, 1}, {0, -0.7071f, -0.7071f, -1}};
+    float l;
+    for(u32 i = 0; i < quantize_count; ++i) {
+        if (i < 8) {
+            memcpy(directions + i * 4, axes[i], sizeof(float) * 4);
+            continue;
+        }
+        do {
+            for(u32 j = 0; j < 3; ++j)
+                directions[i * 4 + j] = random_float();
+            l = sqrtf(mesh_dot(directions + i * 4, directions + i * 4));
+        } while(l > 1 || l < 1e-3f);
+        for(u32 j = 0; j < 3; ++j)
+            directions[i * 4 + j] /= l;
+        directions[i * 4 + 3] = random_float() < 0 ? -1 : 1;
+    }
+
+    s8  *oct8  = (s8*) malloc_t(4 * quantize_count, 1);
+    s16 *oct16 = (s16*)malloc_t(sizeof(s16) * 4 * quantize_count, 2);
+
+    float max_angle[4] = {}; // normals 8, 16, tangents 8, 16 (degrees)
+    bool  handedness   = true;
+    float decoded[3];
+    float cross[3];
+    float x, y, c;
+    for(u32 k = 0; k < 4; ++k) {
+        if (k < 2)
+            mesh_encode_normals_octahedral(k ? (void*)oct16 : (void*)oct8, k ? 16 : 8, directions,
+                                           sizeof(float) * 4, quantize_count);
+        else
+            mesh_encode_tangents_octahedral(k & 1 ? (void*)oct16 : (void*)oct8, k & 1 ? 16 : 8, directions,
+                                            sizeof(float) * 4, quantize_count);
+
+        u32 components = k < 2 ? 2 : 4;
+        for(u32 i = 0; i < quantize_count; ++i) {
+            if (k & 1) {
+                x = fmaxf(oct16[i * components + 0] / 32767.0f, -1);
+                y = fmaxf(oct16[i * components + 1] / 32767.0f, -1);
+            } else {
+                x = fmaxf(oct8[i * components + 0] / 127.0f, -1);
+                y = fmaxf(oct8[i * components + 1] / 127.0f, -1);
+            }
+            mesh_decode_octahedral(decoded, x, y);
+
+            // atan2 rather than acos, which has no precision left this close to 1.
+            mesh_cross(cross, decoded, directions + i * 4);
+            c = atan2f(sqrtf(mesh_dot(cross, cross)), mesh_dot(decoded, directions + i * 4));
+            max_angle[k] = fmaxf(max_angle[k], c * (180 / 3.14159265f));
+
+            if (k == 2)
+                handedness &= (oct8[i * 4 + 2] < 0) == (directions[i * 4 + 3] < 0) && oct8[i * 4 + 3] == 0;
+            if (k == 3)
+                handedness &= (oct16[i * 4 + 2] < 0) == (directions[i * 4 + 3] < 0) && oct16[i * 4 + 3] == 0;
+        }
+    }
+    TEST_EQ("normal_snorm8_error",   max_angle[0] < 0.7f,  true, false);
+    TEST_EQ("normal_snorm16_error",  max_angle[1] < 0.01f, true, false);
+    TEST_EQ("tangent_snorm8_error",  max_angle[2] < 0.7f,  true, false);
+    TEST_EQ("tangent_snorm16_error", max_angle[3] < 0.01f, true, false);
+    TEST_EQ("tangent_handedness",    handedness, true, false);
+
+    // Halves: exact values, ties to even, range and denormals.
+    TEST_EQ("half_one",       float_to_half(1.0f),      0x3c00, false);
+    TEST_EQ("half_neg_two",   float_to_half(-2.0f),     0xc000, false);
+    TEST_EQ("half_zero",      float_to_half(0.0f),      0x0000, false);
+    TEST_EQ("half_max",       float_to_half(65504.0f),  0x7bff, false);
+    TEST_EQ("half_overflow",  float_to_half(65520.0f),  0x7c00, false);
+    TEST_EQ("half_below_max", float_to_half(65519.0f),  0x7bff, false);
+    TEST_EQ("half_tie_even",  float_to_half(1.0f + 1.0f / 2048),     0x3c00, false);
+    TEST_EQ("half_tie_odd",   float_to_half(1.0f + 3.0f / 2048),     0x3c02, false);
+    TEST_EQ("half_denormal",  float_to_half(1.0f / 16777216),        0x0001, false);
+    TEST_EQ("half_underflow", float_to_half(1.0f / 16777216 / 2),    0x0000, false);
+    TEST_EQ("half_min_normal", float_to_half(1.0f / 16384),          0x0400, false);
+    TEST_FEQ("half_round_trip_denormal", half_to_float(0x0003), 3.0f / 16777216, false);
+    TEST_FEQ("half_round_trip",          half_to_float(0xc000), -2.0f,           false);
+
+    // Uvs, some tiled past 1: relative error within half a half's ulp (2^-11).
+    for(u32 i = 0; i < quantize_count * 2; ++i)
+        quantize_src[i] = random_float() * (i & 1 ? 1 : 8);
+    mesh_encode_half(quantized, quantize_src, sizeof(float) * 2, 2, quantize_count);
+    float max_relative = 0;
+    for(u32 i = 0; i < quantize_count * 2; ++i) {
+        e = fabsf(half_to_float(quantized[i]) - quantize_src[i]);
+        e = fabsf(quantize_src[i]) > 1.0f / 16384 ? e / fabsf(quantize_src[i]) : 0;
+        max_relative = e > max_relative ? e : max_relative;
+    }
+    TEST_EQ("half_uv_error", max_relative <= 1.0f / 2048, true, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Mesh_Index_Ranges", false, false);
+
+    // A strip of triangles (k, k + 1, k + 2) over 200000 vertices: 65535 vertices per range after the first
+    // triangle, so 4 ranges, each within its span relative to its vertex offset, covering every index in order.
+    const u32 strip_vertices = 200000;
+    const u32 strip_indices  = (strip_vertices - 2) * 3;
+    u32 *strip = (u32*)malloc_t(sizeof(u32) * strip_indices, 4);
+    for(u32 k = 0; k < strip_vertices - 2; ++k) {
+        strip[k * 3 + 0] = k;
+        strip[k * 3 + 1] = k + 1;
+        strip[k * 3 + 2] = k + 2;
+    }
+
+    Mesh_Index_Range ranges[8];
+    u32 range_count = mesh_split_index_ranges(ranges, 8, strip, strip_indices, Max_u16 - 1);
+    TEST_EQ("strip_range_count", range_count, 4, false);
+
+    bool covered = range_count != Max_u32;
+    bool fits    = true;
+    u32  range_end    = 0;
+    for(u32 r = 0; r < range_count && covered; ++r) {
+        covered &= ranges[r].first_index == range_end;
+        range_end     = ranges[r].first_index + ranges[r].index_count;
+        for(u32 i = ranges[r].first_index; i < range_end; ++i)
+            fits &= strip[i] >= ranges[r].vertex_offset && strip[i] - ranges[r].vertex_offset < Max_u16;
+    }
+    covered &= range_end == strip_indices;
+    TEST_EQ("strip_ranges_cover", covered, true, false);
+    TEST_EQ("strip_ranges_fit",   fits,    true, false);
+
+    TEST_EQ("too_many_ranges", mesh_split_index_ranges(ranges, 3, strip, strip_indices, Max_u16 - 1), Max_u32, false);
+
+    u32 wide[3] = {0, 1, 70000};
+    TEST_EQ("wide_triangle", mesh_split_index_ranges(ranges, 8, wide, 3, Max_u16 - 1), Max_u32, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Mesh_Index_Compression", false, false);
+
+    // The optimized grid, in fetch order as at import: mostly one byte per index, and both decoders agree with the
+    // source at both widths.
+    u32 *index_fetch_remap = (u32*)malloc_t(sizeof(u32) * vertex_count, 4);
+    u32 *fetched     = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    mesh_generate_vertex_fetch_remap(index_fetch_remap, opt, index_count, vertex_count);
+    mesh_remap_indices(fetched, opt, index_count, index_fetch_remap);
+
+    u8  *encoded       = (u8*) malloc_t(mesh_get_index_encode_bound(strip_indices), 1);
+    u32 *decoded32       = (u32*)malloc_t(sizeof(u32) * strip_indices, 4);
+    u16 *decoded16     = (u16*)malloc_t(sizeof(u16) * strip_indices, 2);
+    u64  encoded_size  = mesh_encode_indices(encoded, fetched, index_count);
+    TEST_LT("grid_under_1_5_bytes", encoded_size * 2, (u64)index_count * 3, false);
+
+    bool equal = true;
+    for(u32 k = 0; k < 2; ++k) {
+        bool (*decode)(void*, u32, u32, const u8*, u64) = k ? mesh_decode_indices_scalar : mesh_decode_indices;
+
+        memset(decoded32, 0, sizeof(u32) * index_count);
+        equal &= decode(decoded32, 4, index_count, encoded, encoded_size);
+        equal &= memcmp(decoded32, fetched, sizeof(u32) * index_count) == 0;
+
+        equal &= decode(decoded16, 2, index_count, encoded, encoded_size);
+        for(u32 i = 0; i < index_count; ++i)
+            equal &= decoded16[i] == fetched[i];
+    }
+    TEST_EQ("grid_round_trip", equal, true, false);
+
+    // Long jumps (every varint length, and differences which wrap) mixed with runs of small steps, so the decoder
+    // switches between its paths at every offset.
+    u32 *jumpy = strip;
+    u32  index = 0;
+    for(u32 i = 0; i < 10000; ++i) {
+        seed  = seed * 1664525 + 1013904223;
+        index = (seed >> 28) < 3 ? seed : index + (seed >> 29) - 3;
+        jumpy[i] = index;
+    }
+    encoded_size = mesh_encode_indices(encoded, jumpy, 10000);
+
+    equal = mesh_decode_indices(decoded32, 4, 10000, encoded, encoded_size);
+    equal = equal && memcmp(decoded32, jumpy, sizeof(u32) * 10000) == 0;
+    TEST_EQ("jumpy_round_trip", equal, true, false);
+
+    equal = mesh_decode_indices_scalar(decoded32, 4, 10000, encoded, encoded_size);
+    equal = equal && memcmp(decoded32, jumpy, sizeof(u32) * 10000) == 0;
+    TEST_EQ("jumpy_round_trip_scalar", equal, true, false);
+
+    TEST_EQ("truncated",        mesh_decode_indices(decoded32, 4, 10000, encoded, encoded_size - 1), false, false);
+    u8 overlong[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    TEST_EQ("overlong_varint",  mesh_decode_indices(decoded32, 4, 1, overlong, sizeof(overlong)), false, false);
+
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif
+
+#if BENCH
+//
+// Index decoding over a 256 x 256 grid after vertex cache and fetch optimization (as at import), at both widths,
+// against the scalar decoder. Throughput is of the decoded indices.
+//
+void bench_mesh() {
+    BENCH_MODULE("Mesh");
+
+    u64 mark = get_mark_temp();
+
+    const u32 n              = 256;
+    const u32 vertex_count   = n * n;
+    const u32 index_count    = (n - 1) * (n - 1) * 6;
+
+    u32 *indices = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    u32 *tmp     = (u32*)malloc_t(sizeof(u32) * index_count, 4);
+    u32 *remap   = (u32*)malloc_t(sizeof(u32) * vertex_count, 4);
+    u32  out     = 0;
+    for(u32 y = 0; y < n - 1; ++y) {
+        for(u32 x = 0; x < n - 1; ++x) {
+            u32 v = y * n + x;
+            u32 quad[6] = {v, v + n, v + 1, v + 1, v + n, v + n + 1};
+            memcpy(indices + out, quad, sizeof(quad));
+            out += 6;
+        }
+    }
+    mesh_optimize_vertex_cache(tmp, indices, index_count, vertex_count, MESH_VERTEX_CACHE_SIZE);
+    mesh_generate_vertex_fetch_remap(remap, tmp, index_count, vertex_count);
+    mesh_remap_indices(indices, tmp, index_count, remap);
+
+    u8  *encoded      = (u8*)malloc_t(mesh_get_index_encode_bound(index_count), 1);
+    u64  encoded_size = mesh_encode_indices(encoded, indices, index_count);
+    println("    %u indices: %u bytes encoded (%f bytes per index)", index_count, encoded_size,
+            (double)encoded_size / index_count);
+
+    const u32 iterations = 50;
+    char name[64];
+    u64  ns;
+    bool ok;
+    Bench_Timer timer;
+    for(u32 index_size = 2; index_size <= 4; index_size += 2) {
+        for(u32 scalar = 0; scalar < 2; ++scalar) {
+            ns = 0;
+            for(u32 i = 0; i < iterations; ++i) {
+                timer = begin_bench();
+                ok = scalar ? mesh_decode_indices_scalar(tmp, index_size, index_count, encoded, encoded_size) :
+                              mesh_decode_indices       (tmp, index_size, index_count, encoded, encoded_size);
+                ns += end_bench(&timer);
+                bench_keep(ok);
+                bench_keep(tmp[0]);
+            }
+            string_format(name, "mesh_decode_indices%s, u%u", scalar ? "_scalar" : "", index_size * 8);
+            bench_report_throughput(name, ns, (u64)index_count * index_size, iterations);
+        }
+    }
+
+    reset_to_mark_temp(mark);
+}
+#endif
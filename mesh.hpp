@@ -0,0 +1,274 @@
+#ifndef SOL_MESH_HPP_INCLUDE_GUARD_
+#define SOL_MESH_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+
+/*
+    Mesh Optimization: cpu passes over triangle list index data (and the vertex data it references), run at import
+    before anything is handed to the gpu allocators.
+
+    The usual order is:
+        1. mesh_generate_vertex_remap(..)       weld bitwise equal vertices
+        2. mesh_optimize_vertex_cache(..)       Tipsify (Sander et al. 2007) for the post transform cache
+        3. mesh_optimize_overdraw(..)           reorder Tipsify's clusters so outward facing ones draw first
+        4. mesh_generate_vertex_fetch_remap(..) put vertices in the order that the indices first touch them
+
+    1 and 4 produce a remap table which is applied to the indices with mesh_remap_indices(..) and to every vertex
+    stream with mesh_remap_vertices(..). 2 and 3 only permute triangles (winding is kept), so they are safe on
+    indices whose vertices are shared with other primitives.
+
+    Indices are u32 here whatever they are on disk: callers widen and narrow around these.
+
+    mesh_analyze_vertex_cache(..) is a software fifo post transform cache, which is how both the before and after
+    numbers get reported, and how the tests check the passes without a gpu.
+*/
+
+// Vertex count in the simulated fifo, and the cache which Tipsify targets. Real hardware does not have a simple
+// fifo (and batches vertices into waves), but optimizing for ~16 holds up well across vendors.
+static constexpr u32 MESH_VERTEX_CACHE_SIZE = 16;
+
+// Overdraw is allowed to make the vertex cache this much worse (acmr) when splitting clusters.
+static constexpr float MESH_OVERDRAW_THRESHOLD = 1.05f;
+
+struct Mesh_Vertex_Stream {
+    const void *data;
+    u32 size;   // bytes compared per vertex
+    u32 stride; // bytes between vertices
+};
+
+struct Vertex_Cache_Stats {
+    u32   vertices_transformed; // cache misses
+    u32   vertex_count;         // distinct vertices referenced by the indices
+    u32   triangle_count;
+    float acmr; // misses per triangle: 3 is no reuse, ~0.5 is the limit for a large regular grid
+    float atvr; // misses per referenced vertex: 1 is every vertex transformed exactly once
+};
+
+// Simulate a fifo cache of 'cache_size' vertices over a triangle list.
+Vertex_Cache_Stats mesh_analyze_vertex_cache(const u32 *indices, u32 index_count, u32 vertex_count, u32 cache_size);
+
+// Write a table to 'remap' (vertex_count entries) mapping each vertex to its index in a welded vertex list, in
+// which vertices that are bitwise equal in every stream are one vertex. Unique vertices keep the order of their
+// first occurrence. Returns the welded vertex count.
+u32 mesh_generate_vertex_remap(u32 *remap, u32 vertex_count, u32 stream_count, const Mesh_Vertex_Stream *streams);
+
+// Write a table to 'remap' (vertex_count entries) which orders vertices by their first use in 'indices'. Vertices
+// which are never referenced map to ~0 and are dropped by mesh_remap_vertices(..). Returns the referenced count.
+u32 mesh_generate_vertex_fetch_remap(u32 *remap, const u32 *indices, u32 index_count, u32 vertex_count);
+
+// 'dst' may be 'indices'.
+void mesh_remap_indices(u32 *dst, const u32 *indices, u32 index_count, const u32 *remap);
+
+// Copy 'size' bytes of each vertex 'i' of 'vertices' to vertex 'remap[i]' of 'dst' (skipping ~0). 'dst' must not
+// overlap 'vertices'.
+void mesh_remap_vertices(void *dst, u32 dst_stride, const void *vertices, u32 src_stride, u32 size, u32 vertex_count,
+                         const u32 *remap);
+
+// Tipsify: reorder triangles for a post transform cache of 'cache_size'. 'dst' must not be 'indices'.
+void mesh_optimize_vertex_cache(u32 *dst, const u32 *indices, u32 index_count, u32 vertex_count, u32 cache_size);
+
+// Split vertex cache optimized 'indices' into clusters (at Tipsify's cache flushes, then wherever a cluster's acmr
+// is already within 'threshold' of its total) and sort the clusters so that the ones facing away from the center
+// of the mesh draw first, as they are the most likely to occlude the rest. 'positions' are float3 at
+// 'position_stride' bytes. 'dst' must not be 'indices'.
+void mesh_optimize_overdraw(u32 *dst, const u32 *indices, u32 index_count, const float *positions,
+                            u32 position_stride, u32 vertex_count, u32 cache_size, float threshold);
+
+                                        /* Meshlets */
+
+//
+// Meshlets are small clusters of a primitive's triangles, for culling below the draw (and for mesh shaders, which
+// is where the limits come from: 64 vertices, and 124 triangles so that 3 byte triangles fill 372 of 384 bytes).
+// Each meshlet indexes its own vertex list, which holds indices into the primitive's vertices, so the vertex data
+// is not duplicated.
+//
+// The builder is greedy: it keeps adding the neighbouring triangle which adds the fewest new vertices (then the one
+// closest to the meshlet's centroid) until a neighbour no longer fits, and restarts from the next triangle in index
+// order when there are no neighbours left. So run it after mesh_optimize_vertex_cache(..), whose order is already
+// local.
+//
+static constexpr u32 MESHLET_MAX_VERTICES  = 64;
+static constexpr u32 MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet {
+    u32 vertex_offset;   // into the meshlet vertex list
+    u32 triangle_offset; // into the meshlet triangle list, in triangles (3 bytes each)
+    u32 vertex_count;
+    u32 triangle_count;
+};
+
+//
+// A bounding sphere and a normal cone. The cone holds every triangle's normal within its half angle of 'cone_axis',
+// and 'cone_apex' is behind every triangle's plane, so every triangle in the meshlet faces away from any eye for
+// which
+//
+//     dot(normalize(cone_apex - eye), cone_axis) >= cone_cutoff
+//
+// 'cone_cutoff' is the sine of the half angle, or 2 if the normals spread too far for the cone to ever cull.
+//
+struct Meshlet_Bounds {
+    float center[3];
+    float radius;
+    float cone_apex[3];
+    float cone_cutoff;
+    float cone_axis[3];
+};
+
+struct Meshlet_Cull_Info {
+    float eye[3];       // in the same space as the meshlet bounds (so usually model space)
+    float planes[6][4]; // xyz . p + w >= 0 is inside; any count of planes may be disabled by zeroing them
+};
+
+// Most meshlets that mesh_build_meshlets(..) can write for a triangle list: every meshlet but the last is either
+// full of triangles, or within two vertices of full (a neighbour which does not fit shares at least one vertex).
+u32 mesh_get_meshlet_bound(u32 index_count, u32 max_vertices, u32 max_triangles);
+
+// Write meshlets for a triangle list, returning the count. 'meshlet_vertices' needs room for index_count entries
+// and 'meshlet_triangles' for index_count bytes at most; the last meshlet's offsets and counts give how much was
+// used. 'positions' (float3 at 'position_stride' bytes) may be NULL, then only shared vertices guide the choice.
+u32 mesh_build_meshlets(Meshlet *meshlets, u32 *meshlet_vertices, u8 *meshlet_triangles, const u32 *indices,
+                        u32 index_count, const float *positions, u32 position_stride, u32 vertex_count,
+                        u32 max_vertices, u32 max_triangles);
+
+Meshlet_Bounds mesh_compute_meshlet_bounds(const Meshlet *meshlet, const u32 *meshlet_vertices,
+                                           const u8 *meshlet_triangles, const float *positions, u32 position_stride);
+
+// Reference culler: write the indices of the meshlets which are neither outside a plane nor backfacing to
+// 'visible', returning the count.
+u32 mesh_cull_meshlets(u32 *visible, u32 count, const Meshlet_Bounds *bounds, const Meshlet_Cull_Info *info);
+
+                                    /* Simplification */
+
+//
+// Quadric error metric edge collapse (Garland and Heckbert 1997), with attributes in the quadrics as gradients over
+// each triangle (Hoppe 1999). Vertices only ever collapse onto other vertices, so the result is a new index list
+// over the same vertex data, which is what lod chains want.
+//
+// Vertices at the same position (seams, where uvs or normals split) collapse together, each onto the vertex across
+// the edge on its own side of the seam, so seams stay closed. A vertex on an open border only collapses along the
+// border, or not at all with MESH_SIMPLIFY_LOCK_BORDER_BIT (so primitives which meet at their borders stay
+// watertight).
+//
+// Positions are scaled to the mesh's extent, so 'target_error' is relative to it (0.01 is 1% of the largest
+// side of the bounding box), and so are attribute weights: a difference of 1 / weight in an attribute costs as
+// much as moving the surface by the extent. The error written to 'ret_error' is the geometric part only, as a
+// distance in model space.
+//
+static constexpr u32 MESH_SIMPLIFY_MAX_ATTRIBUTES = 8; // floats per vertex, summed over the attribute streams
+
+enum Mesh_Simplify_Flag_Bits {
+    MESH_SIMPLIFY_LOCK_BORDER_BIT = 0x01,
+};
+typedef u32 Mesh_Simplify_Flags;
+
+struct Mesh_Attribute_Stream {
+    const float *data;
+    u32   stride; // bytes between vertices
+    u32   count;  // floats per vertex
+    float weight;
+};
+
+// Simplify a triangle list towards 'target_index_count' indices, stopping early rather than making an error
+// larger than 'target_error'. 'dst' needs room for index_count entries and may be 'indices'. 'positions' are
+// float3 at 'position_stride' bytes. Returns the index count, always a multiple of 3. Triangles which were
+// already degenerate (two corners at one position) are dropped.
+u32 mesh_simplify(u32 *dst, const u32 *indices, u32 index_count, const float *positions, u32 position_stride,
+                  u32 vertex_count, u32 attribute_stream_count, const Mesh_Attribute_Stream *attribute_streams,
+                  u32 target_index_count, float target_error, Mesh_Simplify_Flags flags, float *ret_error);
+
+                                    /* Vertex Quantization */
+
+//
+// Packed encodings for float vertex attributes, which the vertex input unpacks for free (unorm, snorm and half
+// formats read as floats in the shader):
+//
+//     position   unorm16 x4 (w = 0)   (position - offset) / scale, so the shader does offset + position * scale
+//     normal     snorm16 x2 or x8 x2  octahedral, decode with mesh_decode_octahedral(..) (or its glsl equivalent)
+//     tangent    snorm16 x4 or x8 x4  octahedral in xy, handedness (+-1) in z, w = 0
+//     uv         half x2
+//
+// Octahedral encoding folds the unit sphere onto the [-1, 1] square (Meyer et al. 2010), which spends the bits
+// far more evenly than quantizing xyz. The worst case angle is under 0.01 degrees for 16 bits, and 0.7 for 8.
+//
+struct Vertex_Dequantize {
+    float scale[3];
+    float offset[3];
+};
+
+// A dequantization for positions in [min, max]. With 'step' (per axis), the offset is snapped down to a multiple of
+// it, so primitives which share a step share the grid, and vertices at the same position in each quantize to the
+// same point; it must then be at least (max - min) / 65534 for every axis (the snap can cost a step). Without it
+// (NULL), the range fits exactly.
+Vertex_Dequantize mesh_get_position_dequantize(const float *min, const float *max, const float *step);
+
+// 'dst' is 4 u16 per vertex. Positions outside the dequantization's range are clamped.
+void mesh_quantize_positions(u16 *dst, const float *positions, u32 position_stride, u32 vertex_count,
+                             const Vertex_Dequantize *dequantize);
+
+// 'dst' is 2 snorm of 'bits' (8 or 16) per vertex, from float3 normals (which need not be normalized).
+void mesh_encode_normals_octahedral(void *dst, u32 bits, const float *normals, u32 normal_stride, u32 vertex_count);
+
+// 'dst' is 4 snorm of 'bits' (8 or 16) per vertex, from float4 tangents.
+void mesh_encode_tangents_octahedral(void *dst, u32 bits, const float *tangents, u32 tangent_stride,
+                                     u32 vertex_count);
+
+// 'dst' is 'component_count' halves per vertex (float_to_half(..) in math.hpp).
+void mesh_encode_half(u16 *dst, const float *src, u32 src_stride, u32 component_count, u32 vertex_count);
+
+// Decode octahedral x and y (in [-1, 1], as the vertex input reads snorm) to a unit vector.
+void mesh_decode_octahedral(float *ret_n, float x, float y);
+
+                                    /* Index Narrowing */
+
+//
+// A triangle list whose vertices do not fit 16 bit indices can still be drawn with them, as a few draws each over
+// a window of 65535 vertices, passing the window's start as the draw's vertex offset. After
+// mesh_generate_vertex_fetch_remap(..) triangles only reference vertices near the ones before them, so the windows
+// are few.
+//
+struct Mesh_Index_Range {
+    u32 first_index;
+    u32 index_count;
+    u32 vertex_offset; // subtracted from the range's indices
+};
+
+// Split a triangle list into runs of whole triangles, in order, which each reference vertices within
+// 'max_vertex_span' of the run's lowest one. Returns the count written to 'ranges', or Max_u32 if it would take
+// more than 'max_range_count' (or a single triangle spans too far).
+u32 mesh_split_index_ranges(Mesh_Index_Range *ranges, u32 max_range_count, const u32 *indices, u32 index_count,
+                            u32 max_vertex_span);
+
+                                    /* Index Compression */
+
+//
+// Indices stored as the difference from the index before them (the first from 0), zigzag encoded so that small
+// negative differences are small, as little endian base 128 varints: 7 bits a byte, the top bit set on every byte
+// of a value but its last. After vertex cache and fetch optimization most differences are within +-63, so most
+// indices are one byte against 2 or 4 uncompressed.
+//
+// mesh_decode_indices(..) decodes each run of 8 one byte varints at once (widen, unzigzag and a prefix sum in an
+// avx2 register), and anything longer one varint at a time, which is all that mesh_decode_indices_scalar(..) does.
+//
+
+// Most bytes that mesh_encode_indices(..) writes for 'index_count' indices.
+inline static u64 mesh_get_index_encode_bound(u32 index_count) {
+    return (u64)index_count * 5;
+}
+
+// Returns the bytes written to 'dst'.
+u64 mesh_encode_indices(u8 *dst, const u32 *indices, u32 index_count);
+
+// Decode 'index_count' indices to 'dst' as 'index_size' (2 or 4) byte integers, which they must fit. False if 'src'
+// ends early or holds a varint longer than 5 bytes.
+bool mesh_decode_indices(void *dst, u32 index_size, u32 index_count, const u8 *src, u64 src_size);
+bool mesh_decode_indices_scalar(void *dst, u32 index_size, u32 index_count, const u8 *src, u64 src_size);
+
+#if TEST
+    void test_mesh();
+#endif
+
+#if BENCH
+    void bench_mesh();
+#endif
+
+#endif // include guard
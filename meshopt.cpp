@@ -0,0 +1,948 @@
+#include "meshopt.hpp"
+#include "simd.hpp"
+
+#if TEST
+    #include "test.hpp"
+#endif
+
+static constexpr u8  MESHOPT_VERTEX_HEADER     = 0xa0;
+static constexpr u8  MESHOPT_INDEX_HEADER      = 0xe0;
+static constexpr u8  MESHOPT_SEQUENCE_HEADER   = 0xd0;
+static constexpr u32 MESHOPT_BYTE_GROUP_SIZE   = 16;
+static constexpr u32 MESHOPT_BYTE_GROUP_LIMIT  = 24; // max bytes a group decode may touch (16 byte loads)
+static constexpr u32 MESHOPT_BLOCK_MAX_SIZE    = 256;
+static constexpr u32 MESHOPT_BLOCK_SIZE_BYTES  = 8192;
+static constexpr u32 MESHOPT_TAIL_MIN_SIZE     = 32;
+
+                                        /* Vertex Codec */
+
+//
+// For every 8 bit escape mask: the pshufb control which moves the next escaped byte from the data stream into
+// each escaped slot (0x80 zeroes the non escaped slots), and how many bytes were consumed.
+//
+struct Meshopt_Group_Tables {
+    u8 shuffle[256][8];
+    u8 count[256];
+};
+static constexpr Meshopt_Group_Tables meshopt_build_group_tables() {
+    Meshopt_Group_Tables ret = {};
+    for(u32 mask = 0; mask < 256; ++mask) {
+        u8 count = 0;
+        for(u32 i = 0; i < 8; ++i) {
+            u32 bit = (mask >> i) & 1;
+            ret.shuffle[mask][i] = bit ? count : 0x80;
+            count += bit;
+        }
+        ret.count[mask] = count;
+    }
+    return ret;
+}
+static constexpr Meshopt_Group_Tables MESHOPT_GROUP_TABLES = meshopt_build_group_tables();
+
+inline static __m128i meshopt_group_shuffle(u32 mask0, u32 mask1) {
+    __m128i sm0 = _mm_loadl_epi64((const __m128i*)MESHOPT_GROUP_TABLES.shuffle[mask0]);
+    __m128i sm1 = _mm_loadl_epi64((const __m128i*)MESHOPT_GROUP_TABLES.shuffle[mask1]);
+    // Second half continues from wherever the first half stopped reading (0x80 + n still zeroes).
+    sm1 = _mm_add_epi8(sm1, _mm_set1_epi8(MESHOPT_GROUP_TABLES.count[mask0]));
+    return _mm_unpacklo_epi64(sm0, sm1);
+}
+
+// Decode one group of 16 bytes. 'bits_log2' picks 0, 2, 4 or 8 bits per value; values of all ones are escapes
+// whose real value follows the packed bits. Values are packed msb first.
+inline static const u8* meshopt_decode_group(const u8 *data, u8 *out, u32 bits_log2) {
+    __m128i sel, rest, mask, ret;
+    u32 mask16;
+    switch(bits_log2) {
+    case 0:
+        _mm_storeu_si128((__m128i*)out, _mm_setzero_si128());
+        return data;
+    case 1:
+    {
+        // Spread 4 bytes of 2 bit values out to one value per byte. Groups are not aligned, hence memcpy.
+        int packed;
+        memcpy(&packed, data, 4);
+        sel  = _mm_cvtsi32_si128(packed);
+        rest = _mm_loadu_si128((const __m128i*)(data + 4));
+
+        sel = _mm_unpacklo_epi8(_mm_srli_epi16(sel, 4), sel);
+        sel = _mm_unpacklo_epi8(_mm_srli_epi16(sel, 2), sel);
+        sel = _mm_and_si128(sel, _mm_set1_epi8(3));
+
+        mask   = _mm_cmpeq_epi8(sel, _mm_set1_epi8(3));
+        mask16 = _mm_movemask_epi8(mask);
+
+        ret = _mm_shuffle_epi8(rest, meshopt_group_shuffle(mask16 & 0xff, mask16 >> 8));
+        ret = _mm_or_si128(ret, _mm_andnot_si128(mask, sel));
+        _mm_storeu_si128((__m128i*)out, ret);
+
+        return data + 4 + MESHOPT_GROUP_TABLES.count[mask16 & 0xff] + MESHOPT_GROUP_TABLES.count[mask16 >> 8];
+    }
+    case 2:
+    {
+        sel  = _mm_loadl_epi64((const __m128i*)data);
+        rest = _mm_loadu_si128((const __m128i*)(data + 8));
+
+        sel = _mm_unpacklo_epi8(_mm_srli_epi16(sel, 4), sel);
+        sel = _mm_and_si128(sel, _mm_set1_epi8(15));
+
+        mask   = _mm_cmpeq_epi8(sel, _mm_set1_epi8(15));
+        mask16 = _mm_movemask_epi8(mask);
+
+        ret = _mm_shuffle_epi8(rest, meshopt_group_shuffle(mask16 & 0xff, mask16 >> 8));
+        ret = _mm_or_si128(ret, _mm_andnot_si128(mask, sel));
+        _mm_storeu_si128((__m128i*)out, ret);
+
+        return data + 8 + MESHOPT_GROUP_TABLES.count[mask16 & 0xff] + MESHOPT_GROUP_TABLES.count[mask16 >> 8];
+    }
+    default:
+        _mm_storeu_si128((__m128i*)out, _mm_loadu_si128((const __m128i*)data));
+        return data + 16;
+    }
+}
+
+// 'size' must be a multiple of the group size. Returns NULL if the data runs out.
+static const u8* meshopt_decode_bytes(const u8 *data, const u8 *data_end, u8 *out, u32 size) {
+    const u8 *header      = data;
+    u32       header_size = (size / MESHOPT_BYTE_GROUP_SIZE + 3) / 4; // 2 bits per group
+
+    if ((u64)(data_end - data) < header_size)
+        return NULL;
+    data += header_size;
+
+    u32 group;
+    for(u32 i = 0; i < size; i += MESHOPT_BYTE_GROUP_SIZE) {
+        if ((u64)(data_end - data) < MESHOPT_BYTE_GROUP_LIMIT)
+            return NULL;
+        group = i / MESHOPT_BYTE_GROUP_SIZE;
+        data  = meshopt_decode_group(data, out + i, (header[group / 4] >> ((group % 4) * 2)) & 3);
+    }
+    return data;
+}
+
+static void meshopt_apply_filter(u8 *data, u32 count, u32 stride, Gltf_Meshopt_Filter filter) {
+    switch(filter) {
+    case GLTF_MESHOPT_FILTER_OCTAHEDRAL:
+        meshopt_filter_octahedral(data, count, stride);
+        break;
+    case GLTF_MESHOPT_FILTER_QUATERNION:
+        meshopt_filter_quaternion(data, count, stride);
+        break;
+    case GLTF_MESHOPT_FILTER_EXPONENTIAL:
+        meshopt_filter_exponential(data, count, stride);
+        break;
+    default:
+        break;
+    }
+}
+
+bool meshopt_decode_vertex_buffer(void *dst, u32 count, u32 stride, const u8 *src, u64 src_size,
+                                  Gltf_Meshopt_Filter filter)
+{
+    if (stride == 0 || stride > 256 || (stride & 3))
+        return false;
+    if (src_size < 1 + stride)
+        return false;
+    if ((src[0] & 0xf0) != MESHOPT_VERTEX_HEADER || (src[0] & 0x0f) != 0)
+        return false;
+
+    const u8 *data     = src + 1;
+    const u8 *data_end = src + src_size;
+
+    // The encoder stores the first vertex as the tail, it is the prediction for the first block.
+    u8 last_vertex[256];
+    memcpy(last_vertex, data_end - stride, stride);
+
+    u32 block_size = (MESHOPT_BLOCK_SIZE_BYTES / stride) & ~(MESHOPT_BYTE_GROUP_SIZE - 1);
+    block_size     = block_size < MESHOPT_BLOCK_MAX_SIZE ? block_size : MESHOPT_BLOCK_MAX_SIZE;
+
+    alignas(16) u8 deltas[MESHOPT_BLOCK_MAX_SIZE];
+    alignas(16) u8 transposed[MESHOPT_BLOCK_SIZE_BYTES];
+
+    const __m128i one  = _mm_set1_epi8(1);
+    const __m128i low7 = _mm_set1_epi8(0x7f);
+    __m128i v, p;
+
+    u8 *out = (u8*)dst;
+    u32 block_count, aligned_count;
+    for(u32 offset = 0; offset < count; offset += block_count) {
+        block_count   = count - offset < block_size ? count - offset : block_size;
+        aligned_count = (block_count + MESHOPT_BYTE_GROUP_SIZE - 1) & ~(MESHOPT_BYTE_GROUP_SIZE - 1);
+
+        // Each byte of the vertex is its own stream of deltas across the block.
+        for(u32 k = 0; k < stride; ++k) {
+            data = meshopt_decode_bytes(data, data_end, deltas, aligned_count);
+            if (!data)
+                return false;
+
+            p = _mm_set1_epi8(last_vertex[k]);
+            for(u32 i = 0; i < aligned_count; i += 16) {
+                v = _mm_load_si128((__m128i*)(deltas + i));
+
+                // unzigzag: (v >> 1) ^ -(v & 1)
+                v = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(v, 1), low7),
+                                  _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(v, one)));
+
+                // prefix sum the deltas and add the previous value
+                v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+                v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+                v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+                v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+                v = _mm_add_epi8(v, p);
+
+                _mm_store_si128((__m128i*)(deltas + i), v);
+                p = _mm_shuffle_epi8(v, _mm_set1_epi8(15));
+            }
+
+            for(u32 i = 0; i < block_count; ++i)
+                transposed[i * stride + k] = deltas[i];
+        }
+
+        memcpy(last_vertex, transposed + (block_count - 1) * stride, stride);
+
+        meshopt_apply_filter(transposed, block_count, stride, filter);
+        memcpy(out + (u64)offset * stride, transposed, (u64)block_count * stride);
+    }
+
+    u64 tail_size = stride < MESHOPT_TAIL_MIN_SIZE ? MESHOPT_TAIL_MIN_SIZE : stride;
+    return (u64)(data_end - data) == tail_size;
+}
+
+                                        /* Index Codecs */
+
+inline static u32 meshopt_decode_vbyte(const u8 **data) {
+    const u8 *p = *data;
+    u8 lead = *p++;
+    if (lead < 128) {
+        *data = p;
+        return lead;
+    }
+
+    u32 ret   = lead & 127;
+    u32 shift = 7;
+    u8  group;
+    for(u32 i = 0; i < 4; ++i) {
+        group  = *p++;
+        ret   |= (u32)(group & 127) << shift;
+        shift += 7;
+        if (group < 128)
+            break;
+    }
+    *data = p;
+    return ret;
+}
+
+inline static u32 meshopt_decode_index(const u8 **data, u32 last) {
+    u32 v = meshopt_decode_vbyte(data);
+    return last + ((v >> 1) ^ (u32)-(s32)(v & 1));
+}
+
+inline static void meshopt_write_triangle(void *dst, u32 offset, u32 index_size, u32 a, u32 b, u32 c) {
+    if (index_size == 2) {
+        ((u16*)dst)[offset + 0] = (u16)a;
+        ((u16*)dst)[offset + 1] = (u16)b;
+        ((u16*)dst)[offset + 2] = (u16)c;
+    } else {
+        ((u32*)dst)[offset + 0] = a;
+        ((u32*)dst)[offset + 1] = b;
+        ((u32*)dst)[offset + 2] = c;
+    }
+}
+
+struct Meshopt_Index_State {
+    u32 edges[16][2];
+    u32 vertices[16];
+    u32 edge_offset;
+    u32 vertex_offset;
+};
+inline static void meshopt_push_edge(Meshopt_Index_State *state, u32 a, u32 b) {
+    state->edges[state->edge_offset][0] = a;
+    state->edges[state->edge_offset][1] = b;
+    state->edge_offset = (state->edge_offset + 1) & 15;
+}
+inline static void meshopt_push_vertex(Meshopt_Index_State *state, u32 v, u32 cond) {
+    state->vertices[state->vertex_offset] = v;
+    state->vertex_offset = (state->vertex_offset + cond) & 15;
+}
+
+//
+// Triangles are coded against a 16 entry fifo of recent edges and a 16 entry fifo of recent vertices. 'next' is
+// the next never seen vertex (meshes are expected to be vertex fetch optimized), and anything else is a zigzag
+// vbyte delta from the last such "free" index. This has to mirror the encoder's fifo pushes exactly.
+//
+bool meshopt_decode_index_buffer(void *dst, u32 count, u32 index_size, const u8 *src, u64 src_size) {
+    if ((count % 3) || (index_size != 2 && index_size != 4))
+        return false;
+    if (src_size < 1 + count / 3 + 16) // header, a code byte per triangle, codeaux table
+        return false;
+    if ((src[0] & 0xf0) != MESHOPT_INDEX_HEADER)
+        return false;
+
+    u32 version = src[0] & 0x0f;
+    if (version > 1)
+        return false;
+
+    Meshopt_Index_State state;
+    memset(&state, 0xff, sizeof(state.edges) + sizeof(state.vertices));
+    state.edge_offset   = 0;
+    state.vertex_offset = 0;
+
+    u32 next = 0;
+    u32 last = 0;
+    u32 fec_max = version >= 1 ? 13 : 15;
+
+    const u8 *code          = src + 1;
+    const u8 *data          = code + count / 3;
+    const u8 *data_safe_end = src + src_size - 16;
+    const u8 *codeaux_table = data_safe_end;
+
+    u8  code_tri, code_aux;
+    u32 a, b, c, fe, fea, feb, fec, feb0, fec0;
+    for(u32 i = 0; i < count; i += 3) {
+        // A triangle reads at most 16 bytes (codeaux + 3 vbytes), the codeaux table makes the rest of this safe.
+        if (data > data_safe_end)
+            return false;
+
+        code_tri = *code++;
+
+        if (code_tri < 0xf0) {
+            // Edge from the fifo, third vertex is 'next', from the vertex fifo, or free.
+            fe = code_tri >> 4;
+            a  = state.edges[(state.edge_offset - 1 - fe) & 15][0];
+            b  = state.edges[(state.edge_offset - 1 - fe) & 15][1];
+
+            fec = code_tri & 15;
+            if (fec < fec_max) {
+                c     = fec == 0 ? next : state.vertices[(state.vertex_offset - 1 - fec) & 15];
+                fec0  = fec == 0;
+                next += fec0;
+
+                meshopt_write_triangle(dst, i, index_size, a, b, c);
+                meshopt_push_vertex(&state, c, fec0);
+            } else {
+                // 13 and 14 are +-1 from the last free index (version 1), 15 is a coded delta.
+                last = c = fec != 15 ? last + (fec - (fec ^ 3)) : meshopt_decode_index(&data, last);
+
+                meshopt_write_triangle(dst, i, index_size, a, b, c);
+                meshopt_push_vertex(&state, c, 1);
+            }
+            meshopt_push_edge(&state, c, b);
+            meshopt_push_edge(&state, a, c);
+        } else {
+            // No shared edge: the first vertex is 'next' (or free), the others are described by codeaux.
+            if (code_tri < 0xfe) {
+                code_aux = codeaux_table[code_tri & 15];
+                feb = code_aux >> 4;
+                fec = code_aux & 15;
+
+                a = next++;
+
+                b     = feb == 0 ? next : state.vertices[(state.vertex_offset - feb) & 15];
+                feb0  = feb == 0;
+                next += feb0;
+
+                c     = fec == 0 ? next : state.vertices[(state.vertex_offset - fec) & 15];
+                fec0  = fec == 0;
+                next += fec0;
+
+                meshopt_write_triangle(dst, i, index_size, a, b, c);
+
+                meshopt_push_vertex(&state, a, 1);
+                meshopt_push_vertex(&state, b, feb0);
+                meshopt_push_vertex(&state, c, fec0);
+            } else {
+                code_aux = *data++;
+                fea = code_tri == 0xfe ? 0 : 15;
+                feb = code_aux >> 4;
+                fec = code_aux & 15;
+
+                if (code_aux == 0) // reset
+                    next = 0;
+
+                a = fea == 0 ? next++ : 0;
+                b = feb == 0 ? next++ : state.vertices[(state.vertex_offset - feb) & 15];
+                c = fec == 0 ? next++ : state.vertices[(state.vertex_offset - fec) & 15];
+
+                if (fea == 15)
+                    last = a = meshopt_decode_index(&data, last);
+                if (feb == 15)
+                    last = b = meshopt_decode_index(&data, last);
+                if (fec == 15)
+                    last = c = meshopt_decode_index(&data, last);
+
+                meshopt_write_triangle(dst, i, index_size, a, b, c);
+
+                meshopt_push_vertex(&state, a, 1);
+                meshopt_push_vertex(&state, b, (feb == 0) | (feb == 15));
+                meshopt_push_vertex(&state, c, (fec == 0) | (fec == 15));
+            }
+            meshopt_push_edge(&state, b, a);
+            meshopt_push_edge(&state, c, b);
+            meshopt_push_edge(&state, a, c);
+        }
+    }
+
+    // Should have stopped exactly on the codeaux table.
+    return data == data_safe_end;
+}
+
+// Non triangle index lists: every index is a zigzag vbyte delta from one of two baselines (the low bit picks which).
+bool meshopt_decode_index_sequence(void *dst, u32 count, u32 index_size, const u8 *src, u64 src_size) {
+    if (index_size != 2 && index_size != 4)
+        return false;
+    if (src_size < 1 + (u64)count + 4) // header, a byte per index, 4 byte tail
+        return false;
+    if ((src[0] & 0xf0) != MESHOPT_SEQUENCE_HEADER || (src[0] & 0x0f) > 1)
+        return false;
+
+    const u8 *data          = src + 1;
+    const u8 *data_safe_end = src + src_size - 4;
+
+    u32 last[2] = {};
+    u32 v, current, index;
+    for(u32 i = 0; i < count; ++i) {
+        if (data >= data_safe_end)
+            return false;
+
+        v       = meshopt_decode_vbyte(&data);
+        current = v & 1;
+        v     >>= 1;
+        index   = last[current] + ((v >> 1) ^ (u32)-(s32)(v & 1));
+        last[current] = index;
+
+        if (index_size == 2)
+            ((u16*)dst)[i] = (u16)index;
+        else
+            ((u32*)dst)[i] = index;
+    }
+    return data == data_safe_end;
+}
+
+                                        /* Filters */
+
+// Rounded float -> int, matching (int)(x + (x >= 0 ? 0.5 : -0.5)).
+inline static __m256i meshopt_round_8(__m256 x) {
+    __m256 half = _mm256_or_ps(_mm256_set1_ps(0.5f), _mm256_and_ps(x, _mm256_set1_ps(-0.0f)));
+    return _mm256_cvttps_epi32(_mm256_add_ps(x, half));
+}
+inline static int meshopt_round(float x) {
+    return (int)(x + (x >= 0.0f ? 0.5f : -0.5f));
+}
+
+// 'x', 'y', 'z' are the raw (sign extended) components; writes the renormalized components back into them.
+inline static void meshopt_octahedral_8(__m256i *x, __m256i *y, __m256i *z, float max) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 sign     = _mm256_set1_ps(-0.0f);
+
+    __m256 fx = _mm256_cvtepi32_ps(*x);
+    __m256 fy = _mm256_cvtepi32_ps(*y);
+    __m256 fz = _mm256_cvtepi32_ps(*z);
+    fz = _mm256_sub_ps(_mm256_sub_ps(fz, _mm256_and_ps(fx, abs_mask)), _mm256_and_ps(fy, abs_mask));
+
+    // Fold z < 0: x += (x >= 0 ? t : -t), with t = min(z, 0)
+    __m256 t = _mm256_min_ps(fz, _mm256_setzero_ps());
+    fx = _mm256_add_ps(fx, _mm256_xor_ps(t, _mm256_and_ps(fx, sign)));
+    fy = _mm256_add_ps(fy, _mm256_xor_ps(t, _mm256_and_ps(fy, sign)));
+
+    __m256 l = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fx, fx), _mm256_mul_ps(fy, fy)),
+                                            _mm256_mul_ps(fz, fz)));
+    __m256 s = _mm256_div_ps(_mm256_set1_ps(max), l);
+
+    *x = meshopt_round_8(_mm256_mul_ps(fx, s));
+    *y = meshopt_round_8(_mm256_mul_ps(fy, s));
+    *z = meshopt_round_8(_mm256_mul_ps(fz, s));
+}
+inline static void meshopt_octahedral(int *x, int *y, int *z, float max) {
+    float fx = (float)*x;
+    float fy = (float)*y;
+    float fz = (float)*z - fabsf(fx) - fabsf(fy);
+
+    float t = fz >= 0.0f ? 0.0f : fz;
+    fx += fx >= 0.0f ? t : -t;
+    fy += fy >= 0.0f ? t : -t;
+
+    float l = sqrtf(fx * fx + fy * fy + fz * fz);
+    float s = max / l;
+
+    *x = meshopt_round(fx * s);
+    *y = meshopt_round(fy * s);
+    *z = meshopt_round(fz * s);
+}
+
+void meshopt_filter_octahedral(void *data, u32 count, u32 stride) {
+    u32 i = 0;
+    __m256i x, y, z, w, xy, zw;
+    if (stride == 4) {
+        s8 *d = (s8*)data;
+        for(; i + 8 <= count; i += 8) {
+            w = _mm256_loadu_si256((__m256i*)(d + i * 4));
+            x = _mm256_srai_epi32(_mm256_slli_epi32(w, 24), 24);
+            y = _mm256_srai_epi32(_mm256_slli_epi32(w, 16), 24);
+            z = _mm256_srai_epi32(_mm256_slli_epi32(w,  8), 24);
+
+            meshopt_octahedral_8(&x, &y, &z, 127.0f);
+
+            w = _mm256_and_si256(w, _mm256_set1_epi32(0xff000000));
+            w = _mm256_or_si256(w, _mm256_and_si256(x, _mm256_set1_epi32(0xff)));
+            w = _mm256_or_si256(w, _mm256_slli_epi32(_mm256_and_si256(y, _mm256_set1_epi32(0xff)), 8));
+            w = _mm256_or_si256(w, _mm256_slli_epi32(_mm256_and_si256(z, _mm256_set1_epi32(0xff)), 16));
+            _mm256_storeu_si256((__m256i*)(d + i * 4), w);
+        }
+        int sx, sy, sz;
+        for(; i < count; ++i) {
+            sx = d[i * 4 + 0];
+            sy = d[i * 4 + 1];
+            sz = d[i * 4 + 2];
+            meshopt_octahedral(&sx, &sy, &sz, 127.0f);
+            d[i * 4 + 0] = (s8)sx;
+            d[i * 4 + 1] = (s8)sy;
+            d[i * 4 + 2] = (s8)sz;
+        }
+    } else {
+        assert(stride == 8 && "Octahedral filter stride must be 4 or 8");
+        s16 *d = (s16*)data;
+        __m256 r0, r1;
+        for(; i + 8 <= count; i += 8) {
+            // Split 8 elements into their xy and zw dwords (lane order is shuffled, undone by the unpacks below).
+            r0 = _mm256_loadu_ps((float*)(d + i * 4));
+            r1 = _mm256_loadu_ps((float*)(d + i * 4 + 16));
+            xy = _mm256_castps_si256(_mm256_shuffle_ps(r0, r1, 0x88));
+            zw = _mm256_castps_si256(_mm256_shuffle_ps(r0, r1, 0xdd));
+
+            x = _mm256_srai_epi32(_mm256_slli_epi32(xy, 16), 16);
+            y = _mm256_srai_epi32(xy, 16);
+            z = _mm256_srai_epi32(_mm256_slli_epi32(zw, 16), 16);
+
+            meshopt_octahedral_8(&x, &y, &z, 32767.0f);
+
+            xy = _mm256_or_si256(_mm256_and_si256(x, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(y, 16));
+            zw = _mm256_or_si256(_mm256_and_si256(z, _mm256_set1_epi32(0xffff)),
+                                 _mm256_and_si256(zw, _mm256_set1_epi32(0xffff0000)));
+
+            _mm256_storeu_si256((__m256i*)(d + i * 4),      _mm256_unpacklo_epi32(xy, zw));
+            _mm256_storeu_si256((__m256i*)(d + i * 4 + 16), _mm256_unpackhi_epi32(xy, zw));
+        }
+        int sx, sy, sz;
+        for(; i < count; ++i) {
+            sx = d[i * 4 + 0];
+            sy = d[i * 4 + 1];
+            sz = d[i * 4 + 2];
+            meshopt_octahedral(&sx, &sy, &sz, 32767.0f);
+            d[i * 4 + 0] = (s16)sx;
+            d[i * 4 + 1] = (s16)sy;
+            d[i * 4 + 2] = (s16)sz;
+        }
+    }
+}
+
+//
+// Smallest three: three components scaled by 1/sqrt(2) and the scale bits of the 4th short, whose low 2 bits are
+// the index of the dropped (largest) component. Output is rotated so the reconstructed w lands in that slot.
+//
+void meshopt_filter_quaternion(void *data, u32 count, u32 stride) {
+    assert(stride == 8 && "Quaternion filter stride must be 8");
+    const float scale = 1.0f / sqrtf(2.0f);
+
+    s16 *d = (s16*)data;
+    u32  i = 0;
+
+    __m256  r0, r1, fx, fy, fz, fw, ss;
+    __m256i xy, zs, x, y, z, w, qc, s0, s1, s2, s3, is1, is2, is3;
+    for(; i + 8 <= count; i += 8) {
+        r0 = _mm256_loadu_ps((float*)(d + i * 4));
+        r1 = _mm256_loadu_ps((float*)(d + i * 4 + 16));
+        xy = _mm256_castps_si256(_mm256_shuffle_ps(r0, r1, 0x88));
+        zs = _mm256_castps_si256(_mm256_shuffle_ps(r0, r1, 0xdd));
+
+        x  = _mm256_srai_epi32(_mm256_slli_epi32(xy, 16), 16);
+        y  = _mm256_srai_epi32(xy, 16);
+        z  = _mm256_srai_epi32(_mm256_slli_epi32(zs, 16), 16);
+        w  = _mm256_srai_epi32(zs, 16); // scale bits | qc
+        qc = _mm256_and_si256(w, _mm256_set1_epi32(3));
+
+        ss = _mm256_div_ps(_mm256_set1_ps(scale), _mm256_cvtepi32_ps(_mm256_or_si256(w, _mm256_set1_epi32(3))));
+        fx = _mm256_mul_ps(_mm256_cvtepi32_ps(x), ss);
+        fy = _mm256_mul_ps(_mm256_cvtepi32_ps(y), ss);
+        fz = _mm256_mul_ps(_mm256_cvtepi32_ps(z), ss);
+
+        fw = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(fx, fx));
+        fw = _mm256_sub_ps(fw, _mm256_mul_ps(fy, fy));
+        fw = _mm256_sub_ps(fw, _mm256_mul_ps(fz, fz));
+        fw = _mm256_sqrt_ps(_mm256_max_ps(fw, _mm256_setzero_ps()));
+
+        x = meshopt_round_8(_mm256_mul_ps(fx, _mm256_set1_ps(32767.0f)));
+        y = meshopt_round_8(_mm256_mul_ps(fy, _mm256_set1_ps(32767.0f)));
+        z = meshopt_round_8(_mm256_mul_ps(fz, _mm256_set1_ps(32767.0f)));
+        w = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(fw, _mm256_set1_ps(32767.0f)), _mm256_set1_ps(0.5f)));
+
+        // slot k = [w, x, y, z][(k - qc) & 3]
+        is1 = _mm256_cmpeq_epi32(qc, _mm256_set1_epi32(1));
+        is2 = _mm256_cmpeq_epi32(qc, _mm256_set1_epi32(2));
+        is3 = _mm256_cmpeq_epi32(qc, _mm256_set1_epi32(3));
+
+        s0 = _mm256_blendv_epi8(_mm256_blendv_epi8(_mm256_blendv_epi8(w, z, is1), y, is2), x, is3);
+        s1 = _mm256_blendv_epi8(_mm256_blendv_epi8(_mm256_blendv_epi8(x, w, is1), z, is2), y, is3);
+        s2 = _mm256_blendv_epi8(_mm256_blendv_epi8(_mm256_blendv_epi8(y, x, is1), w, is2), z, is3);
+        s3 = _mm256_blendv_epi8(_mm256_blendv_epi8(_mm256_blendv_epi8(z, y, is1), x, is2), w, is3);
+
+        xy = _mm256_or_si256(_mm256_and_si256(s0, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(s1, 16));
+        zs = _mm256_or_si256(_mm256_and_si256(s2, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(s3, 16));
+
+        _mm256_storeu_si256((__m256i*)(d + i * 4),      _mm256_unpacklo_epi32(xy, zs));
+        _mm256_storeu_si256((__m256i*)(d + i * 4 + 16), _mm256_unpackhi_epi32(xy, zs));
+    }
+
+    float sx, sy, sz, sw, sss, ww;
+    int sf, q;
+    for(; i < count; ++i) {
+        sf  = d[i * 4 + 3] | 3;
+        sss = scale / (float)sf;
+
+        sx = (float)d[i * 4 + 0] * sss;
+        sy = (float)d[i * 4 + 1] * sss;
+        sz = (float)d[i * 4 + 2] * sss;
+
+        ww = 1.0f - sx * sx - sy * sy - sz * sz;
+        sw = sqrtf(ww >= 0.0f ? ww : 0.0f);
+
+        q = d[i * 4 + 3] & 3;
+        d[i * 4 + ((q + 1) & 3)] = (s16)meshopt_round(sx * 32767.0f);
+        d[i * 4 + ((q + 2) & 3)] = (s16)meshopt_round(sy * 32767.0f);
+        d[i * 4 + ((q + 3) & 3)] = (s16)meshopt_round(sz * 32767.0f);
+        d[i * 4 + ((q + 0) & 3)] = (s16)(int)(sw * 32767.0f + 0.5f);
+    }
+}
+
+// Each u32 is a 24 bit signed mantissa and an 8 bit signed exponent: m * 2^e.
+void meshopt_filter_exponential(void *data, u32 count, u32 stride) {
+    assert((stride & 3) == 0 && "Exponential filter stride must be a multiple of 4");
+
+    u32 *d     = (u32*)data;
+    u64  total = (u64)count * (stride / 4);
+    u64  i     = 0;
+
+    __m256i v, m, e;
+    __m256  f;
+    for(; i + 8 <= total; i += 8) {
+        v = _mm256_loadu_si256((__m256i*)(d + i));
+        m = _mm256_srai_epi32(_mm256_slli_epi32(v, 8), 8);
+        e = _mm256_srai_epi32(v, 24);
+
+        // 2^e built directly as float bits, then scaled by the mantissa (ldexp without the edge cases)
+        f = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(e, _mm256_set1_epi32(127)), 23));
+        f = _mm256_mul_ps(f, _mm256_cvtepi32_ps(m));
+        _mm256_storeu_ps((float*)(d + i), f);
+    }
+
+    int   sm, se;
+    u32   bits;
+    float sf;
+    for(; i < total; ++i) {
+        sm   = (int)(d[i] << 8) >> 8;
+        se   = (int)d[i] >> 24;
+        bits = (u32)(se + 127) << 23;
+        memcpy(&sf, &bits, 4);
+        sf  *= (float)sm;
+        memcpy(d + i, &sf, 4);
+    }
+}
+
+bool meshopt_decode_buffer_view(Gltf *gltf, const Gltf_Buffer_View *view, const u8 *const *buffers, void *dst) {
+    const Gltf_Meshopt_Compression *meshopt = &view->meshopt;
+
+    if ((u64)meshopt->count * meshopt->byte_stride > view->byte_length)
+        return false;
+    if ((u32)meshopt->buffer >= (u32)gltf_buffer_get_count(gltf) || !buffers[meshopt->buffer])
+        return false;
+    u64 buffer_size = gltf_buffer_by_index(gltf, meshopt->buffer)->byte_length;
+    if (meshopt->byte_offset > buffer_size || meshopt->byte_length > buffer_size - meshopt->byte_offset)
+        return false;
+
+    const u8 *src = buffers[meshopt->buffer] + meshopt->byte_offset;
+
+    switch(meshopt->mode) {
+    case GLTF_MESHOPT_MODE_ATTRIBUTES:
+        return meshopt_decode_vertex_buffer(dst, meshopt->count, meshopt->byte_stride, src, meshopt->byte_length,
+                                            meshopt->filter);
+    case GLTF_MESHOPT_MODE_TRIANGLES:
+        return meshopt_decode_index_buffer(dst, meshopt->count, meshopt->byte_stride, src, meshopt->byte_length);
+    case GLTF_MESHOPT_MODE_INDICES:
+        return meshopt_decode_index_sequence(dst, meshopt->count, meshopt->byte_stride, src, meshopt->byte_length);
+    default:
+        assert(false && "Buffer view is not compressed");
+        return false;
+    }
+}
+
+#if TEST
+//
+// Minimal vertex encoder for the tests: same format, picks the smallest bit width per group. It does not try to
+// be good at it (no delta reordering etc.), the point is round tripping through every group width.
+//
+static u8* test_meshopt_encode_group(u8 *out, const u8 *group, u32 bits) {
+    if (bits == 0)
+        return out;
+    if (bits == 8) {
+        memcpy(out, group, 16);
+        return out + 16;
+    }
+    u32 per_byte = 8 / bits;
+    u32 sentinel = (1 << bits) - 1;
+    for(u32 i = 0; i < 16; i += per_byte) {
+        u8 byte = 0;
+        for(u32 k = 0; k < per_byte; ++k)
+            byte = (byte << bits) | (group[i + k] >= sentinel ? sentinel : group[i + k]);
+        *out++ = byte;
+    }
+    for(u32 i = 0; i < 16; ++i)
+        if (group[i] >= sentinel)
+            *out++ = group[i];
+    return out;
+}
+static u32 test_meshopt_encoded_group_size(const u8 *group, u32 bits) {
+    if (bits == 0) {
+        for(u32 i = 0; i < 16; ++i)
+            if (group[i])
+                return 0xffffffff;
+        return 0;
+    }
+    if (bits == 8)
+        return 16;
+    u32 ret = 16 * bits / 8;
+    for(u32 i = 0; i < 16; ++i)
+        ret += group[i] >= (1u << bits) - 1;
+    return ret;
+}
+static u64 test_meshopt_encode_vertices(u8 *out, const u8 *vertices, u32 count, u32 stride) {
+    u8 *start = out;
+    *out++ = MESHOPT_VERTEX_HEADER;
+
+    u8 last[256];
+    memcpy(last, vertices, stride);
+
+    u32 block_size = (MESHOPT_BLOCK_SIZE_BYTES / stride) & ~(MESHOPT_BYTE_GROUP_SIZE - 1);
+    block_size     = block_size < MESHOPT_BLOCK_MAX_SIZE ? block_size : MESHOPT_BLOCK_MAX_SIZE;
+
+    u8 deltas[MESHOPT_BLOCK_MAX_SIZE];
+    const u32 widths[4] = {0, 2, 4, 8};
+    for(u32 offset = 0; offset < count; offset += block_size) {
+        u32 block_count   = count - offset < block_size ? count - offset : block_size;
+        u32 aligned_count = (block_count + 15) & ~15;
+        for(u32 k = 0; k < stride; ++k) {
+            memset(deltas, 0, sizeof(deltas));
+            u8 p = last[k];
+            for(u32 i = 0; i < block_count; ++i) {
+                u8 v = vertices[(offset + i) * stride + k];
+                u8 d = v - p;
+                deltas[i] = (u8)((d << 1) ^ (u8)((s8)d >> 7));
+                p = v;
+            }
+            u8 *header = out;
+            u32 header_size = (aligned_count / 16 + 3) / 4;
+            memset(header, 0, header_size);
+            out += header_size;
+            for(u32 g = 0; g < aligned_count / 16; ++g) {
+                u32 best = 3;
+                for(u32 b = 0; b < 3; ++b)
+                    if (test_meshopt_encoded_group_size(deltas + g * 16, widths[b]) <
+                        test_meshopt_encoded_group_size(deltas + g * 16, widths[best]))
+                    {
+                        best = b;
+                    }
+                header[g / 4] |= best << ((g % 4) * 2);
+                out = test_meshopt_encode_group(out, deltas + g * 16, widths[best]);
+            }
+        }
+        memcpy(last, vertices + (offset + block_count - 1) * stride, stride);
+    }
+
+    u32 tail_size = stride < MESHOPT_TAIL_MIN_SIZE ? MESHOPT_TAIL_MIN_SIZE : stride;
+    memset(out, 0, tail_size - stride);
+    memcpy(out + tail_size - stride, vertices, stride);
+    out += tail_size;
+    return out - start;
+}
+
+void test_meshopt() {
+    u64 mark = get_mark_temp();
+
+    BEGIN_TEST_MODULE("Meshopt_Vertex_Codec", false, false);
+
+    // Smooth data (small deltas: 2 and 4 bit groups with escapes) then noise (8 bit groups), over several blocks.
+    const u32 count  = 700;
+    const u32 stride = 16;
+    u8 *vertices = (u8*)malloc_t(count * stride, 16);
+    u32 seed = 12345;
+    for(u32 i = 0; i < count; ++i)
+        for(u32 k = 0; k < stride; ++k) {
+            seed = seed * 1664525 + 1013904223;
+            vertices[i * stride + k] = i < 400 ? (u8)(i * (k + 1) / 8 + ((seed >> 24) & 1) * (k == 3) * 40)
+                                               : (u8)(seed >> 24);
+        }
+    u8 *encoded = (u8*)malloc_t(count * stride * 2 + 64, 16);
+    u64 encoded_size = test_meshopt_encode_vertices(encoded, vertices, count, stride);
+
+    u8 *decoded = (u8*)malloc_t(count * stride, 16);
+    TEST_EQ("decode", meshopt_decode_vertex_buffer(decoded, count, stride, encoded, encoded_size,
+                                                   GLTF_MESHOPT_FILTER_NONE), true, false);
+    TEST_EQ("round_trip", memcmp(decoded, vertices, count * stride), 0, false);
+    TEST_LT("compresses", encoded_size, (u64)count * stride, false);
+
+    TEST_EQ("bad_header", meshopt_decode_vertex_buffer(decoded, count, stride, vertices, encoded_size,
+                                                       GLTF_MESHOPT_FILTER_NONE), false, false);
+    TEST_EQ("truncated", meshopt_decode_vertex_buffer(decoded, count, stride, encoded, encoded_size - 40,
+                                                      GLTF_MESHOPT_FILTER_NONE), false, false);
+
+    // Hand built: one 4 byte vertex, one all zero group per byte, the tail holds the vertex itself.
+    u8 single[1 + 4 + 32] = {MESHOPT_VERTEX_HEADER};
+    single[33] = 1; single[34] = 2; single[35] = 3; single[36] = 4;
+    u32 single_out = 0;
+    TEST_EQ("single_decode", meshopt_decode_vertex_buffer(&single_out, 1, 4, single, sizeof(single),
+                                                          GLTF_MESHOPT_FILTER_NONE), true, false);
+    TEST_EQ("single_vertex", single_out, 0x04030201, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Meshopt_Index_Codecs", false, false);
+
+    // Triangles (0 1 2) (2 1 3): the first is all 'next' (codeaux table entry 0), the second takes edge 1 (2 1)
+    // from the edge fifo and 'next' for its third vertex.
+    u8 tris[1 + 2 + 16] = {MESHOPT_INDEX_HEADER | 1, 0xf0, 0x10,
+                           0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xa9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0, 0};
+    u16 indices[6];
+    TEST_EQ("triangles_decode", meshopt_decode_index_buffer(indices, 6, 2, tris, sizeof(tris)), true, false);
+    TEST_EQ("triangles[0]", indices[0], 0, false);
+    TEST_EQ("triangles[2]", indices[2], 2, false);
+    TEST_EQ("triangles[3]", indices[3], 2, false);
+    TEST_EQ("triangles[4]", indices[4], 1, false);
+    TEST_EQ("triangles[5]", indices[5], 3, false);
+
+    // Free vertex: 0xff with codeaux 0xff codes all three as deltas from 'last': +5, -2 (3), +300 (303)
+    u8 tri_free[1 + 1 + 1 + 1 + 1 + 2 + 16] = {MESHOPT_INDEX_HEADER | 1, 0xff, 0xff, 10, 3, 0xd8, 0x04};
+    u32 free_indices[3];
+    TEST_EQ("free_decode", meshopt_decode_index_buffer(free_indices, 3, 4, tri_free, sizeof(tri_free)), true, false);
+    TEST_EQ("free[0]", free_indices[0], 5, false);
+    TEST_EQ("free[1]", free_indices[1], 3, false);
+    TEST_EQ("free[2]", free_indices[2], 303, false);
+
+    // Sequence: 7 (baseline 0), 9 (baseline 0), 100 (baseline 1), 8 (baseline 0)
+    u8 seq[1 + 5 + 4] = {MESHOPT_SEQUENCE_HEADER | 1, 7 << 2, 2 << 2, (u8)(0x80 | ((200 << 1 | 1) & 127)), 3,
+                         1 << 1};
+    u32 seq_out[4];
+    TEST_EQ("sequence_decode", meshopt_decode_index_sequence(seq_out, 4, 4, seq, sizeof(seq)), true, false);
+    TEST_EQ("sequence[0]", seq_out[0], 7, false);
+    TEST_EQ("sequence[1]", seq_out[1], 9, false);
+    TEST_EQ("sequence[2]", seq_out[2], 100, false);
+    TEST_EQ("sequence[3]", seq_out[3], 8, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Meshopt_Filters", false, false);
+
+    // Every filter run over 19 elements (two simd iterations and a scalar tail) must match running it on each
+    // element alone (scalar only).
+    s16 *a = (s16*)malloc_t(19 * 8, 16);
+    s16 *b = (s16*)malloc_t(19 * 8, 16);
+    for(u32 i = 0; i < 19 * 4; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        a[i] = (s16)(seed >> 16);
+    }
+    u32 fails;
+    memcpy(b, a, 19 * 8);
+    meshopt_filter_octahedral(a, 19, 8);
+    for(u32 i = 0; i < 19; ++i)
+        meshopt_filter_octahedral(b + i * 4, 1, 8);
+    TEST_EQ("octahedral_16", memcmp(a, b, 19 * 8), 0, false);
+
+    memcpy(b, a, 19 * 8);
+    meshopt_filter_octahedral(a, 38, 4);
+    for(u32 i = 0; i < 38; ++i)
+        meshopt_filter_octahedral((u8*)b + i * 4, 1, 4);
+    TEST_EQ("octahedral_8", memcmp(a, b, 19 * 8), 0, false);
+
+    memcpy(b, a, 19 * 8);
+    meshopt_filter_quaternion(a, 19, 8);
+    for(u32 i = 0; i < 19; ++i)
+        meshopt_filter_quaternion(b + i * 4, 1, 8);
+    TEST_EQ("quaternion", memcmp(a, b, 19 * 8), 0, false);
+
+    memcpy(b, a, 19 * 8);
+    meshopt_filter_exponential(a, 19, 8);
+    for(u32 i = 0; i < 19; ++i)
+        meshopt_filter_exponential(b + i * 4, 1, 8);
+    TEST_EQ("exponential", memcmp(a, b, 19 * 8), 0, false);
+
+    // Known values
+    s8 oct[4] = {0, 0, 127, 0};
+    meshopt_filter_octahedral(oct, 1, 4);
+    TEST_EQ("octahedral_up", oct[2], 127, false);
+
+    s16 quat[4] = {0, 0, 0, (s16)((0x7ff << 2) | 3)}; // identity, w dropped
+    meshopt_filter_quaternion(quat, 1, 8);
+    fails = quat[0] != 0 || quat[1] != 0 || quat[2] != 0 || quat[3] != 32767;
+    TEST_EQ("quaternion_identity", fails, 0, false);
+
+    u32 expo = ((u32)(-2 & 0xff) << 24) | 6; // 6 * 2^-2
+    meshopt_filter_exponential(&expo, 1, 4);
+    float expo_f;
+    memcpy(&expo_f, &expo, 4);
+    TEST_FEQ("exponential_value", expo_f, 1.5f, false);
+
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Meshopt_Gltf_Extension", false, false);
+
+    // Buffer 0 is the compressed data (the triangles and single vertex from above), buffer 1 the fallback.
+    Gltf gltf = parse_gltf("test/test_meshopt.gltf");
+
+    TEST_EQ("buffer_count", gltf_buffer_get_count(&gltf), 2, false);
+    TEST_EQ("buffers[0].meshopt_fallback", gltf_buffer_by_index(&gltf, 0)->meshopt_fallback, 0, false);
+    TEST_EQ("buffers[1].meshopt_fallback", gltf_buffer_by_index(&gltf, 1)->meshopt_fallback, 1, false);
+    TEST_PTREQ("buffers[1].uri", gltf_buffer_by_index(&gltf, 1)->uri, nullptr, false);
+
+    Gltf_Buffer_View *view = gltf_buffer_view_by_index(&gltf, 0);
+    TEST_EQ("buffer_views[0].buffer", view->buffer, 1, false);
+    TEST_EQ("buffer_views[0].byte_length", view->byte_length, 12, false);
+    TEST_EQ("buffer_views[0].buffer_type", view->buffer_type, GLTF_BUFFER_TYPE_ELEMENT_ARRAY_BUFFER, false);
+    TEST_EQ("buffer_views[0].meshopt.mode", view->meshopt.mode, GLTF_MESHOPT_MODE_TRIANGLES, false);
+    TEST_EQ("buffer_views[0].meshopt.filter", view->meshopt.filter, GLTF_MESHOPT_FILTER_NONE, false);
+    TEST_EQ("buffer_views[0].meshopt.buffer", view->meshopt.buffer, 0, false);
+    TEST_EQ("buffer_views[0].meshopt.byte_offset", view->meshopt.byte_offset, 0, false);
+    TEST_EQ("buffer_views[0].meshopt.byte_length", view->meshopt.byte_length, 19, false);
+    TEST_EQ("buffer_views[0].meshopt.byte_stride", view->meshopt.byte_stride, 2, false);
+    TEST_EQ("buffer_views[0].meshopt.count", view->meshopt.count, 6, false);
+
+    const u8 *buffers[2];
+    buffers[0] = (u8*)malloc_t(gltf_buffer_by_index(&gltf, 0)->byte_length, 16);
+    buffers[1] = NULL;
+    gltf_buffer_decode_base64(gltf_buffer_by_index(&gltf, 0), (u8*)buffers[0]);
+
+    TEST_EQ("buffer_views[0].decode", meshopt_decode_buffer_view(&gltf, view, buffers, indices), true, false);
+    TEST_EQ("buffer_views[0].indices[5]", indices[5], 3, false);
+
+    // Malformed: compressed data past the end of its buffer, and more decoded data than the view holds.
+    Gltf_Buffer_View bad_view = *view;
+    bad_view.meshopt.byte_offset = gltf_buffer_by_index(&gltf, 0)->byte_length - 4;
+    TEST_EQ("buffer_views[0].src_overflow", meshopt_decode_buffer_view(&gltf, &bad_view, buffers, indices), false, false);
+    bad_view = *view;
+    bad_view.meshopt.count = view->meshopt.count * 2;
+    TEST_EQ("buffer_views[0].dst_overflow", meshopt_decode_buffer_view(&gltf, &bad_view, buffers, indices), false, false);
+
+    view = gltf_buffer_view_by_index(&gltf, 1);
+    TEST_EQ("buffer_views[1].byte_offset", view->byte_offset, 12, false);
+    TEST_EQ("buffer_views[1].byte_stride", view->byte_stride, 4, false);
+    TEST_EQ("buffer_views[1].meshopt.mode", view->meshopt.mode, GLTF_MESHOPT_MODE_ATTRIBUTES, false);
+    TEST_EQ("buffer_views[1].meshopt.filter", view->meshopt.filter, GLTF_MESHOPT_FILTER_EXPONENTIAL, false);
+    TEST_EQ("buffer_views[1].meshopt.byte_offset", view->meshopt.byte_offset, 20, false);
+    TEST_EQ("buffer_views[1].meshopt.byte_length", view->meshopt.byte_length, 37, false);
+    TEST_EQ("buffer_views[1].meshopt.count", view->meshopt.count, 1, false);
+
+    // 0x04030201: mantissa 0x030201, exponent 4
+    float value;
+    TEST_EQ("buffer_views[1].decode", meshopt_decode_buffer_view(&gltf, view, buffers, &value), true, false);
+    TEST_FEQ("buffer_views[1].value", value, (float)0x030201 * 16.0f, false);
+
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif
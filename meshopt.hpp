@@ -0,0 +1,42 @@
+#ifndef SOL_MESHOPT_HPP_INCLUDE_GUARD_
+#define SOL_MESHOPT_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "gltf.hpp"
+
+/*
+    EXT_meshopt_compression decoders.
+
+    Formats are as in the extension spec (which are meshoptimizer's codecs): vertex codec version 0 for ATTRIBUTES,
+    index codec versions 0/1 for TRIANGLES and index sequence codec versions 0/1 for INDICES.
+
+    The vertex codec is the one worth going wide on: byte groups are unpacked with pshufb (escape bytes are
+    compacted with a table indexed by the escape mask), and the zigzag delta is undone 16 vertices at a time with an
+    in register prefix sum. Filters are avx2, 8 elements at a time. The index codecs are a serial fifo machine, so
+    they are just kept tight and branch light.
+
+    Decoders write exactly 'count * stride' bytes to 'dst', and never read it back (filters are applied to each
+    vertex block before it is copied out), so 'dst' is allowed to be write combined staging memory.
+
+    Everything returns false on malformed data rather than asserting: the data comes off disk.
+*/
+
+bool meshopt_decode_vertex_buffer(void *dst, u32 count, u32 stride, const u8 *src, u64 src_size,
+                                  Gltf_Meshopt_Filter filter);
+bool meshopt_decode_index_buffer  (void *dst, u32 count, u32 index_size, const u8 *src, u64 src_size);
+bool meshopt_decode_index_sequence(void *dst, u32 count, u32 index_size, const u8 *src, u64 src_size);
+
+// In place filters. 'count' is the element count, 'stride' the element size in bytes.
+void meshopt_filter_octahedral (void *data, u32 count, u32 stride); // stride 4 (s8 x4) or 8 (s16 x4)
+void meshopt_filter_quaternion (void *data, u32 count, u32 stride); // stride 8 (s16 x4)
+void meshopt_filter_exponential(void *data, u32 count, u32 stride); // stride % 4 == 0
+
+// Decode a compressed buffer view into 'dst' (byte_length bytes) from the source buffer it references. False if the
+// compressed range is not inside that buffer, or if it decodes to more than the view's byte_length.
+bool meshopt_decode_buffer_view(Gltf *gltf, const Gltf_Buffer_View *view, const u8 *const *buffers, void *dst);
+
+#if TEST
+    void test_meshopt();
+#endif
+
+#endif // include guard
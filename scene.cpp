@@ -0,0 +1,650 @@
+#include "scene.hpp"
+#include "allocator.hpp"
+#include "print.h"
+#include "simd.hpp"
+
+#if TEST
+    #include "test.hpp"
+#endif
+
+#if BENCH
+    #include "test/bench.hpp"
+#endif
+
+                                            /* Scenes */
+
+static inline u32 scene_get_bit_word_count(u32 node_count) {
+    return (node_count >> 6) + 2; // One spare, so that eight bits can always be read as two words
+}
+
+void scene_create(Scene *scene, u32 node_count, const u32 *parents) {
+    u64 mark = get_mark_temp();
+
+    *scene = {};
+    scene->node_count = node_count;
+
+    // Children of each input node (counting sort by parent), then breadth first from the roots.
+    u32 *child_offsets = (u32*)malloc_t(sizeof(u32) * (node_count + 1), 4);
+    u32 *children      = (u32*)malloc_t(sizeof(u32) * node_count, 4);
+    memset(child_offsets, 0, sizeof(u32) * (node_count + 1));
+    for(u32 i = 0; i < node_count; ++i) {
+        assert((parents[i] < node_count || parents[i] == Max_u32) && "Scene parent out of range");
+        if (parents[i] != Max_u32)
+            child_offsets[parents[i] + 1]++;
+    }
+    for(u32 i = 0; i < node_count; ++i)
+        child_offsets[i + 1] += child_offsets[i];
+    u32 *cursors = (u32*)malloc_t(sizeof(u32) * node_count, 4);
+    memcpy(cursors, child_offsets, sizeof(u32) * node_count);
+    for(u32 i = 0; i < node_count; ++i)
+        if (parents[i] != Max_u32)
+            children[cursors[parents[i]]++] = i;
+
+    u32 *queue         = (u32*)malloc_t(sizeof(u32) * node_count, 4);
+    u32 *level_offsets = (u32*)malloc_t(sizeof(u32) * (node_count + 1), 4);
+    u32  tail          = 0;
+    for(u32 i = 0; i < node_count; ++i)
+        if (parents[i] == Max_u32)
+            queue[tail++] = i;
+
+    u32 level_count = 0;
+    u32 level_end   = tail;
+    u32 n;
+    level_offsets[0] = 0;
+    for(u32 head = 0; head < tail;) {
+        if (head == level_end) {
+            level_offsets[++level_count] = head;
+            level_end = tail;
+        }
+        n = queue[head++];
+        for(u32 c = child_offsets[n]; c < child_offsets[n + 1]; ++c)
+            queue[tail++] = children[c];
+    }
+    if (tail)
+        level_offsets[++level_count] = tail;
+    assert(tail == node_count && "Scene hierarchy has a cycle");
+
+    scene->level_count = level_count;
+
+    // One block: | level offsets | parents | sources | indices | local TRS x 10 | world | dirty | changed |.
+    // The TRS arrays are padded to eight floats for the update's loads.
+    u32 word_count   = scene_get_bit_word_count(node_count);
+    u64 size_levels  = align(sizeof(u32) * (level_count + 1), 32);
+    u64 size_nodes   = align(sizeof(u32) * node_count, 32);
+    u64 size_floats  = align(sizeof(float) * align(node_count, 8), 32);
+    u64 size_world   = align(sizeof(Mat4) * node_count, 32);
+    u64 size_bits    = sizeof(u64) * word_count;
+
+    u8 *block = malloc_h(size_levels + size_nodes * 3 + size_floats * 10 + size_world + size_bits * 2, 32);
+    u8 *p = block;
+    scene->level_offsets = (u32*)p; p += size_levels;
+    scene->parents       = (u32*)p; p += size_nodes;
+    scene->sources       = (u32*)p; p += size_nodes;
+    scene->indices       = (u32*)p; p += size_nodes;
+    for(u32 c = 0; c < 3; ++c) {
+        scene->translation[c] = (float*)p; p += size_floats;
+    }
+    for(u32 c = 0; c < 4; ++c) {
+        scene->rotation[c] = (float*)p; p += size_floats;
+    }
+    for(u32 c = 0; c < 3; ++c) {
+        scene->scale[c] = (float*)p; p += size_floats;
+    }
+    scene->world   = (Mat4*)p; p += size_world;
+    scene->dirty   = (u64*)p;  p += size_bits;
+    scene->changed = (u64*)p;
+
+    memcpy(scene->level_offsets, level_offsets, sizeof(u32) * (level_count + 1));
+    memcpy(scene->sources, queue, sizeof(u32) * node_count);
+    for(u32 i = 0; i < node_count; ++i)
+        scene->indices[queue[i]] = i;
+    for(u32 i = 0; i < node_count; ++i)
+        scene->parents[i] = parents[queue[i]] == Max_u32 ? Max_u32 : scene->indices[parents[queue[i]]];
+
+    memset(scene->translation[0], 0, size_floats * 10);
+    for(u32 i = 0; i < node_count; ++i) {
+        scene->rotation[3][i] = 1;
+        scene->scale[0][i]    = 1;
+        scene->scale[1][i]    = 1;
+        scene->scale[2][i]    = 1;
+    }
+
+    Mat4 identity = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+    for(u32 i = 0; i < node_count; ++i)
+        scene->world[i] = identity;
+
+    memset(scene->dirty,   0, size_bits);
+    memset(scene->changed, 0, size_bits);
+    for(u32 i = 0; i < node_count; ++i)
+        scene_mark_dirty(scene, i);
+
+    reset_to_mark_temp(mark);
+}
+
+void scene_free(Scene *scene) {
+    if (scene->level_offsets)
+        free_h(scene->level_offsets);
+    *scene = {};
+}
+
+void scene_from_gltf(Scene *scene, Gltf *gltf) {
+    // Before the mark: a lazy gltf parses its nodes into temp here, and they must stay.
+    u32 node_count = gltf_node_get_count(gltf);
+
+    u64 mark = get_mark_temp();
+
+    u32 *parents   = (u32*)malloc_t(sizeof(u32) * node_count, 4);
+    memset(parents, 0xff, sizeof(u32) * node_count);
+
+    const Gltf_Node *node = gltf->nodes;
+    for(u32 i = 0; i < node_count; ++i) {
+        for(u32 j = 0; j < (u32)node->child_count; ++j)
+            parents[node->children[j]] = i;
+        node = (const Gltf_Node*)((u8*)node + node->stride);
+    }
+    scene_create(scene, node_count, parents);
+
+    // The rest pose is the gltf's TRS with matrices decomposed.
+    Animation_Pose rest;
+    animation_pose_init(&rest, node_count, malloc_t(animation_pose_get_size(node_count), 4));
+    animation_pose_set_rest(&rest, gltf);
+    scene_set_local_from_pose(scene, &rest);
+
+    reset_to_mark_temp(mark);
+}
+
+void scene_set_local(Scene *scene, u32 node, const Gltf_Trs *trs) {
+    assert(node < scene->node_count && "Scene node out of range");
+    scene->translation[0][node] = trs->translation.x;
+    scene->translation[1][node] = trs->translation.y;
+    scene->translation[2][node] = trs->translation.z;
+    scene->rotation[0][node]    = trs->rotation.x;
+    scene->rotation[1][node]    = trs->rotation.y;
+    scene->rotation[2][node]    = trs->rotation.z;
+    scene->rotation[3][node]    = trs->rotation.w;
+    scene->scale[0][node]       = trs->scale.x;
+    scene->scale[1][node]       = trs->scale.y;
+    scene->scale[2][node]       = trs->scale.z;
+    scene_mark_dirty(scene, node);
+}
+
+void scene_set_local_from_pose(Scene *scene, const Animation_Pose *pose) {
+    assert(pose->node_count == scene->node_count && "Animation pose size does not match the scene");
+
+    u32  s;
+    bool same;
+    for(u32 i = 0; i < scene->node_count; ++i) {
+        s    = scene->sources[i];
+        same = true;
+        for(u32 c = 0; c < 3; ++c) {
+            same &= scene->translation[c][i] == pose->translation[c][s];
+            same &= scene->scale[c][i]       == pose->scale[c][s];
+        }
+        for(u32 c = 0; c < 4; ++c)
+            same &= scene->rotation[c][i] == pose->rotation[c][s];
+        if (same)
+            continue;
+
+        for(u32 c = 0; c < 3; ++c) {
+            scene->translation[c][i] = pose->translation[c][s];
+            scene->scale[c][i]       = pose->scale[c][s];
+        }
+        for(u32 c = 0; c < 4; ++c)
+            scene->rotation[c][i] = pose->rotation[c][s];
+        scene_mark_dirty(scene, i);
+    }
+}
+
+                                            /* Update */
+
+// Bits [i, i + 8) of a bit array.
+static inline u32 scene_get_bits8(const u64 *bits, u32 i) {
+    u64 ret = bits[i >> 6] >> (i & 63);
+    if ((i & 63) > 56)
+        ret |= bits[(i >> 6) + 1] << (64 - (i & 63));
+    return (u32)ret & 0xff;
+}
+
+// The 3x4 'm' (row major, translation in the fourth column) as a column major Mat4.
+static inline Mat4 scene_mat4_from_affine(float m00, float m01, float m02, float m03, float m10, float m11, float m12,
+                                          float m13, float m20, float m21, float m22, float m23)
+{
+    return {{m00, m10, m20, 0}, {m01, m11, m21, 0}, {m02, m12, m22, 0}, {m03, m13, m23, 1}};
+}
+
+// In place: row i of the result is lane i of the eight vectors.
+static inline void scene_transpose_8x8(__m256 r[8]) {
+    __m256 t[8];
+    for(u32 i = 0; i < 4; ++i) {
+        t[i * 2 + 0] = _mm256_unpacklo_ps(r[i * 2], r[i * 2 + 1]);
+        t[i * 2 + 1] = _mm256_unpackhi_ps(r[i * 2], r[i * 2 + 1]);
+    }
+    __m256 u[8];
+    for(u32 i = 0; i < 2; ++i) {
+        u[i * 4 + 0] = _mm256_shuffle_ps(t[i * 4 + 0], t[i * 4 + 2], 0x44);
+        u[i * 4 + 1] = _mm256_shuffle_ps(t[i * 4 + 0], t[i * 4 + 2], 0xee);
+        u[i * 4 + 2] = _mm256_shuffle_ps(t[i * 4 + 1], t[i * 4 + 3], 0x44);
+        u[i * 4 + 3] = _mm256_shuffle_ps(t[i * 4 + 1], t[i * 4 + 3], 0xee);
+    }
+    for(u32 i = 0; i < 4; ++i) {
+        r[i + 0] = _mm256_permute2f128_ps(u[i], u[i + 4], 0x20);
+        r[i + 4] = _mm256_permute2f128_ps(u[i], u[i + 4], 0x31);
+    }
+}
+
+//
+// Column major world matrices: world = parent * local is mul_mat4(local, parent) (see math.hpp, Mat4 rows are
+// columns). A batch whose eight nodes all need recomputing (the usual case when a subtree moves) multiplies eight wide,
+// with the parents' matrices gathered and the results transposed back into Mat4s. Otherwise the lanes which need it
+// go through mul_mat4(..) one by one.
+//
+void scene_update(Scene *scene) {
+    u32 word_count = scene_get_bit_word_count(scene->node_count);
+    memset(scene->changed, 0, sizeof(u64) * word_count);
+
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one  = _mm256_set1_ps(1.0f);
+    __m256 two  = _mm256_set1_ps(2.0f);
+
+    const float *world = (const float*)scene->world;
+
+    alignas(32) float m[12][8];
+    __m256 l[12];
+    __m256 pw[12];
+    __m256 r[16];
+    bool prev_changed = false;
+    bool level_changed;
+    u32  begin;
+    u32  end;
+    u32  need;
+    u32  lane;
+    u32  n;
+    u32  p;
+    Mat4 local;
+    for(u32 level = 0; level < scene->level_count; ++level) {
+        begin = scene->level_offsets[level];
+        end   = scene->level_offsets[level + 1];
+        level_changed = false;
+        for(u32 i = begin; i < end; i += 8) {
+            need = scene_get_bits8(scene->dirty, i);
+            if (prev_changed)
+                for(u32 j = 0; j < 8; ++j) {
+                    p     = scene->parents[i + j < end ? i + j : i];
+                    need |= (u32)((scene->changed[p >> 6] >> (p & 63)) & 1) << j;
+                }
+            if (end - i < 8)
+                need &= (1u << (end - i)) - 1;
+            if (!need)
+                continue;
+            level_changed = true;
+
+            __m256 tx = _mm256_loadu_ps(scene->translation[0] + i);
+            __m256 ty = _mm256_loadu_ps(scene->translation[1] + i);
+            __m256 tz = _mm256_loadu_ps(scene->translation[2] + i);
+            __m256 x  = _mm256_loadu_ps(scene->rotation[0] + i);
+            __m256 y  = _mm256_loadu_ps(scene->rotation[1] + i);
+            __m256 z  = _mm256_loadu_ps(scene->rotation[2] + i);
+            __m256 w  = _mm256_loadu_ps(scene->rotation[3] + i);
+            __m256 sx = _mm256_loadu_ps(scene->scale[0] + i);
+            __m256 sy = _mm256_loadu_ps(scene->scale[1] + i);
+            __m256 sz = _mm256_loadu_ps(scene->scale[2] + i);
+
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 xw = _mm256_mul_ps(x, w), yw = _mm256_mul_ps(y, w), zw = _mm256_mul_ps(z, w);
+
+            // Local, row major 3x4
+            l[0]  = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+            l[1]  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, zw)), sy);
+            l[2]  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, yw)), sz);
+            l[3]  = tx;
+            l[4]  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, zw)), sx);
+            l[5]  = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+            l[6]  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, xw)), sz);
+            l[7]  = ty;
+            l[8]  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, yw)), sx);
+            l[9]  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, xw)), sy);
+            l[10] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+            l[11] = tz;
+
+            if (need == 0xff && level) {
+                // Parent world, row major 3x4: element (row, col) is float col * 4 + row of the Mat4
+                __m256i parents = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i*)(scene->parents + i)), 4);
+                for(u32 row = 0; row < 3; ++row)
+                    for(u32 col = 0; col < 4; ++col)
+                        pw[row * 4 + col] = _mm256_i32gather_ps(world + col * 4 + row, parents, 4);
+
+                // Out in Mat4 order: column col is r[col * 4 .. col * 4 + 3]
+                for(u32 row = 0; row < 3; ++row) {
+                    for(u32 col = 0; col < 4; ++col) {
+                        __m256 e = _mm256_mul_ps(pw[row * 4 + 0], l[0 * 4 + col]);
+                        e = _mm256_add_ps(e, _mm256_mul_ps(pw[row * 4 + 1], l[1 * 4 + col]));
+                        e = _mm256_add_ps(e, _mm256_mul_ps(pw[row * 4 + 2], l[2 * 4 + col]));
+                        if (col == 3)
+                            e = _mm256_add_ps(e, pw[row * 4 + 3]);
+                        r[col * 4 + row] = e;
+                    }
+                }
+                r[3]  = zero;
+                r[7]  = zero;
+                r[11] = zero;
+                r[15] = one;
+
+                scene_transpose_8x8(r);
+                scene_transpose_8x8(r + 8);
+                float *dst = (float*)(scene->world + i);
+                for(u32 j = 0; j < 8; ++j) {
+                    _mm256_storeu_ps(dst + j * 16,     r[j]);
+                    _mm256_storeu_ps(dst + j * 16 + 8, r[j + 8]);
+                }
+                scene->changed[i >> 6] |= (u64)0xff << (i & 63);
+                if ((i & 63) > 56)
+                    scene->changed[(i >> 6) + 1] |= (u64)0xff >> (64 - (i & 63));
+                continue;
+            }
+
+            for(u32 e = 0; e < 12; ++e)
+                _mm256_store_ps(m[e], l[e]);
+            while(need) {
+                lane  = count_trailing_zeros_u32(need);
+                need &= need - 1;
+                n     = i + lane;
+
+                local = scene_mat4_from_affine(m[0][lane], m[1][lane], m[2][lane],  m[3][lane],
+                                               m[4][lane], m[5][lane], m[6][lane],  m[7][lane],
+                                               m[8][lane], m[9][lane], m[10][lane], m[11][lane]);
+                p = scene->parents[n];
+                scene->world[n] = p == Max_u32 ? local : mul_mat4(local, scene->world[p]);
+                scene->changed[n >> 6] |= (u64)1 << (n & 63);
+            }
+        }
+        prev_changed = level_changed;
+    }
+
+    memset(scene->dirty, 0, sizeof(u64) * word_count);
+}
+
+void scene_update_scalar(Scene *scene) {
+    u32 word_count = scene_get_bit_word_count(scene->node_count);
+
+    float x, y, z, w;
+    float sx, sy, sz;
+    u32   p;
+    Mat4  local;
+    for(u32 i = 0; i < scene->node_count; ++i) {
+        x  = scene->rotation[0][i];
+        y  = scene->rotation[1][i];
+        z  = scene->rotation[2][i];
+        w  = scene->rotation[3][i];
+        sx = scene->scale[0][i];
+        sy = scene->scale[1][i];
+        sz = scene->scale[2][i];
+
+        local = scene_mat4_from_affine(
+            (1 - 2 * (y * y + z * z)) * sx, 2 * (x * y - z * w) * sy, 2 * (x * z + y * w) * sz, scene->translation[0][i],
+            2 * (x * y + z * w) * sx, (1 - 2 * (x * x + z * z)) * sy, 2 * (y * z - x * w) * sz, scene->translation[1][i],
+            2 * (x * z - y * w) * sx, 2 * (y * z + x * w) * sy, (1 - 2 * (x * x + y * y)) * sz, scene->translation[2][i]);
+
+        p = scene->parents[i];
+        scene->world[i] = p == Max_u32 ? local : mul_mat4(local, scene->world[p]);
+    }
+
+    memset(scene->dirty,   0,    sizeof(u64) * word_count);
+    memset(scene->changed, 0,    sizeof(u64) * word_count);
+    for(u32 i = 0; i < scene->node_count; ++i)
+        scene->changed[i >> 6] |= (u64)1 << (i & 63);
+}
+
+                                            /* Tests */
+
+#if TEST || BENCH
+// A random tree of 'node_count' nodes in input order: node i's parent is any earlier node, except that every
+// 'root_every'th node is a root. Its local transforms are random.
+static void scene_create_random(Scene *scene, u32 node_count, u32 root_every, u32 seed) {
+    u64 mark = get_mark_temp();
+
+    u32 *parents = (u32*)malloc_t(sizeof(u32) * node_count, 4);
+    u32  rng     = seed;
+    for(u32 i = 0; i < node_count; ++i) {
+        rng = rng * 1664525 + 1013904223;
+        parents[i] = i % root_every == 0 ? Max_u32 : (rng >> 8) % i;
+    }
+    scene_create(scene, node_count, parents);
+
+    float r[4];
+    float len;
+    Gltf_Trs trs;
+    for(u32 i = 0; i < node_count; ++i) {
+        len = 0;
+        for(u32 c = 0; c < 4; ++c) {
+            rng  = rng * 1664525 + 1013904223;
+            r[c] = (float)(rng >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+            len += r[c] * r[c];
+        }
+        len = sqrtf(len);
+        trs.translation = {r[0], r[1], r[2]};
+        trs.rotation    = {r[0] / len, r[1] / len, r[2] / len, r[3] / len};
+        trs.scale       = {0.75f + r[3] * 0.25f, 0.75f + r[2] * 0.25f, 0.75f + r[1] * 0.25f};
+        scene_set_local(scene, scene->indices[i], &trs);
+    }
+
+    reset_to_mark_temp(mark);
+}
+
+static u32 scene_count_changed(const Scene *scene) {
+    u32 ret = 0;
+    for(u32 i = 0; i < scene_get_bit_word_count(scene->node_count); ++i)
+        ret += pop_count64(scene->changed[i]);
+    return ret;
+}
+#endif
+
+#if TEST
+static float test_scene_max_diff(const Mat4 *a, const Mat4 *b, u32 count) {
+    float ret = 0;
+    float d;
+    for(u32 i = 0; i < count * 16; ++i) {
+        d   = fabsf(((const float*)a)[i] - ((const float*)b)[i]);
+        ret = d > ret ? d : ret;
+    }
+    return ret;
+}
+
+void test_scene() {
+    u64 mark = get_mark_temp();
+
+    BEGIN_TEST_MODULE("Scene_Hand_Checked", false, false);
+    {
+        // Input 1 is the root, 2 and 3 its children, 0 is 2's child and 4 is 0's child.
+        u32 parents[] = {2, Max_u32, 1, 1, 0};
+        Scene scene;
+        scene_create(&scene, 5, parents);
+
+        TEST_EQ("level_count", scene.level_count, 4, false);
+        TEST_EQ("level_1",     scene.level_offsets[1], 1, false);
+        TEST_EQ("level_2",     scene.level_offsets[2], 3, false);
+        TEST_EQ("level_3",     scene.level_offsets[3], 4, false);
+        TEST_EQ("root",        scene.sources[0], 1, false);
+        TEST_EQ("leaf",        scene.sources[4], 4, false);
+
+        bool parents_first = true;
+        for(u32 i = 0; i < 5; ++i) {
+            parents_first &= scene.parents[i] == Max_u32 ? i == 0 : scene.parents[i] < i;
+            parents_first &= scene.indices[scene.sources[i]] == i;
+        }
+        TEST_EQ("parents_first", parents_first, true, false);
+
+        // Every node is one along x from its parent, and the root is turned 90 degrees about z: so each level is
+        // one further up y in the world.
+        Gltf_Trs trs;
+        trs.translation = {1, 0, 0};
+        for(u32 i = 0; i < 5; ++i)
+            scene_set_local(&scene, i, &trs);
+        trs.rotation = {0, 0, sqrtf(0.5f), sqrtf(0.5f)};
+        scene_set_local(&scene, scene.indices[1], &trs);
+
+        scene_update(&scene);
+        Mat4 *leaf = &scene.world[scene.indices[4]];
+        TEST_EQ("leaf_translation_x", fabsf(leaf->row3.x - 1.0f) < 1e-6f, true, false);
+        TEST_EQ("leaf_translation_y", fabsf(leaf->row3.y - 3.0f) < 1e-6f, true, false);
+        TEST_EQ("leaf_x_axis",        fabsf(leaf->row0.y - 1.0f) < 1e-6f, true, false);
+        TEST_EQ("all_changed", scene_count_changed(&scene), 5, false);
+
+        // Dirty tracking: nothing, a leaf, then a subtree
+        scene_update(&scene);
+        TEST_EQ("none_changed", scene_count_changed(&scene), 0, false);
+
+        trs = {};
+        scene_set_local(&scene, scene.indices[3], &trs);
+        scene_update(&scene);
+        TEST_EQ("leaf_changed",       scene_count_changed(&scene), 1, false);
+        TEST_EQ("leaf_changed_is_3",  scene_is_changed(&scene, scene.indices[3]), true, false);
+
+        trs.translation = {2, 0, 0};
+        scene_set_local(&scene, scene.indices[2], &trs);
+        scene_update(&scene);
+        TEST_EQ("subtree_changed", scene_count_changed(&scene), 3, false);
+        TEST_EQ("subtree_leaf",    scene_is_changed(&scene, scene.indices[4]), true, false);
+        TEST_EQ("subtree_sibling", scene_is_changed(&scene, scene.indices[3]), false, false);
+        TEST_EQ("moved_leaf_y", fabsf(leaf->row3.y - 4.0f) < 1e-6f, true, false);
+
+        scene_free(&scene);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Scene_Simd_Matches_Scalar", false, false);
+    {
+        // Levels of many sizes (so batches have tails and cross bit words), some roots which are not the first node.
+        const u32 node_count = 1000;
+        Scene scene;
+        Scene scalar;
+        scene_create_random(&scene,  node_count, 97, 11);
+        scene_create_random(&scalar, node_count, 97, 11);
+
+        scene_update(&scene);
+        scene_update_scalar(&scalar);
+        TEST_EQ("full", test_scene_max_diff(scene.world, scalar.world, node_count) < 1e-4f, true, false);
+
+        // Some subtrees moved: the partial update must land where a full one does.
+        u32 rng = 3;
+        Gltf_Trs trs;
+        for(u32 i = 0; i < 10; ++i) {
+            rng = rng * 1664525 + 1013904223;
+            u32 n = (rng >> 8) % node_count;
+            trs.translation = {(float)i, 0, 0};
+            scene_set_local(&scene,  n, &trs);
+            scene_set_local(&scalar, n, &trs);
+        }
+        scene_update(&scene);
+        scene_update_scalar(&scalar);
+        TEST_EQ("partial", test_scene_max_diff(scene.world, scalar.world, node_count) < 1e-4f, true, false);
+        TEST_LT("partial_changed_fewer", scene_count_changed(&scene), node_count, false);
+
+        scene_free(&scene);
+        scene_free(&scalar);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Scene_Cesium_Man", false, false);
+    {
+        Gltf gltf = parse_gltf("models/cesium-man/CesiumMan.gltf");
+        Scene scene;
+        scene_from_gltf(&scene, &gltf);
+        scene_update(&scene);
+
+        TEST_EQ("node_count", scene.node_count, 22, false);
+        TEST_EQ("root", scene.sources[0], 0, false);
+
+        // Nodes 0 and 1 are matrices, node 2 (the mesh) has no transform: its world is theirs.
+        Mat4 expected = mul_mat4(gltf_node_by_index(&gltf, 1)->matrix, gltf_node_by_index(&gltf, 0)->matrix);
+        TEST_EQ("matrix_nodes", test_scene_max_diff(&scene.world[scene.indices[1]], &expected, 1) < 1e-5f, true, false);
+        TEST_EQ("mesh_node",    test_scene_max_diff(&scene.world[scene.indices[2]], &expected, 1) < 1e-5f, true, false);
+
+        // The same pose again changes nothing
+        Animation_Pose rest;
+        animation_pose_init(&rest, scene.node_count, malloc_t(animation_pose_get_size(scene.node_count), 4));
+        animation_pose_set_rest(&rest, &gltf);
+        scene_set_local_from_pose(&scene, &rest);
+        scene_update(&scene);
+        TEST_EQ("rest_unchanged", scene_count_changed(&scene), 0, false);
+        scene_free(&scene);
+
+        // A lazy gltf's nodes are parsed by scene_from_gltf(..), and must still be there after it (temp memory it
+        // gave back would be reused, and overwritten, by the next allocation).
+        Gltf lazy = parse_gltf_lazy("models/cesium-man/CesiumMan.gltf");
+        scene_from_gltf(&scene, &lazy);
+        memset(malloc_t(64 * 1024, 16), 0xcd, 64 * 1024);
+        const Gltf_Node *node = gltf_node_by_index(&lazy, 0);
+        TEST_EQ("lazy_nodes", node->child_count == gltf_node_by_index(&gltf, 0)->child_count &&
+                              !memcmp(&node->matrix, &gltf_node_by_index(&gltf, 0)->matrix, sizeof(Mat4)), true, false);
+        scene_free(&scene);
+    }
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif // TEST
+
+#if BENCH
+//
+// 100k nodes in random trees (~30 levels), every update against the scalar full recompute, and the dirty tracking:
+// a percent of the nodes moved (and their subtrees with them), and nothing moved.
+//
+void bench_scene() {
+    BENCH_MODULE("Scene");
+
+    const u32 node_count = 100000;
+    Scene scene;
+    scene_create_random(&scene, node_count, 1000, 5);
+
+    const u32 iterations = 32;
+    u64 ns_full    = 0;
+    u64 ns_scalar  = 0;
+    u64 ns_partial = 0;
+    u64 ns_none    = 0;
+    u64 partial_changed = 0;
+
+    Bench_Timer timer;
+    Gltf_Trs    trs;
+    u32         rng = 9;
+    for(u32 it = 0; it < iterations; ++it) {
+        for(u32 i = 0; i < node_count; ++i)
+            scene_mark_dirty(&scene, i);
+        timer = begin_bench();
+        scene_update(&scene);
+        ns_full += end_bench(&timer);
+        bench_keep(scene.world[node_count - 1].row3.x);
+
+        timer = begin_bench();
+        scene_update_scalar(&scene);
+        ns_scalar += end_bench(&timer);
+        bench_keep(scene.world[node_count - 1].row3.x);
+
+        for(u32 i = 0; i < node_count / 100; ++i) {
+            rng = rng * 1664525 + 1013904223;
+            u32 n = (rng >> 8) % node_count;
+            trs.translation = {(float)it, 0, 0};
+            scene_set_local(&scene, n, &trs);
+        }
+        timer = begin_bench();
+        scene_update(&scene);
+        ns_partial += end_bench(&timer);
+        partial_changed += scene_count_changed(&scene);
+
+        timer = begin_bench();
+        scene_update(&scene);
+        ns_none += end_bench(&timer);
+    }
+
+    println("    %u nodes, %u levels:", (u64)node_count, (u64)scene.level_count);
+    println("        every node: simd %f ns/node, scalar %f ns/node, speedup %f",
+            (double)ns_full / ((u64)node_count * iterations), (double)ns_scalar / ((u64)node_count * iterations),
+            (double)ns_scalar / (double)ns_full);
+    println("        a hundredth of the nodes moved: %f us/update, %u nodes recomputed (%f ns/node)",
+            (double)ns_partial / iterations / 1000.0, partial_changed / iterations,
+            (double)ns_partial / (double)partial_changed);
+    println("        nothing moved: %f us/update", (double)ns_none / iterations / 1000.0);
+
+    scene_free(&scene);
+}
+#endif // BENCH
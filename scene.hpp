@@ -0,0 +1,81 @@
+#ifndef SOL_SCENE_HPP_INCLUDE_GUARD_
+#define SOL_SCENE_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "math.hpp"
+#include "gltf.hpp"
+#include "animation.hpp"
+
+/*
+    Scene: the runtime node hierarchy, flattened from a gltf's nodes (or any parent array) and holding the world
+    transform of every node.
+
+    Nodes are in levels by depth (breadth first, so siblings are together and every parent comes before its
+    children), with the parent index, local TRS (SoA) and world matrix of each node in arrays in that order. The
+    input's index of a node is 'sources', and the scene index of an input node is 'indices'.
+
+    scene_update(..) recomputes world transforms in one pass over the levels, eight nodes of a level at a time: the
+    local matrices are built with avx2 from the SoA TRS, then each is multiplied onto its parent's world matrix. A node
+    is recomputed only if its local transform was set since the last update (its 'dirty' bit), or its parent was
+    recomputed: a batch of eight with neither is skipped without being read. The recomputed nodes are left in the
+    'changed' bits for whoever caches things by world transform (bounds, culling).
+
+    World matrices are column major like gltf's: Mat4 'rowN' is column N.
+*/
+
+struct Scene {
+    u32 node_count;
+    u32 level_count;
+
+    u32 *level_offsets; // Level d is nodes [level_offsets[d], level_offsets[d + 1])
+    u32 *parents;       // Max_u32 for roots (only level 0)
+    u32 *sources;       // Index in the input of each node
+    u32 *indices;       // Scene index of each input node
+
+    float *translation[3]; // Local TRS, SoA
+    float *rotation[4];
+    float *scale[3];
+
+    Mat4 *world;
+    u64  *dirty;   // Bit per node: local transform set since the last update
+    u64  *changed; // Bit per node: world transform recomputed by the last update
+};
+
+// A scene of 'node_count' nodes, where parents[i] is the input index of input node i's parent (Max_u32 for roots).
+// Local transforms start as identity, and every node as dirty. The scene is one heap allocation, free it with
+// scene_free(..).
+void scene_create(Scene *scene, u32 node_count, const u32 *parents);
+void scene_free(Scene *scene);
+
+// Every node of 'gltf', at its rest transform. Input indices are gltf node indices.
+void scene_from_gltf(Scene *scene, Gltf *gltf);
+
+inline static void scene_mark_dirty(Scene *scene, u32 node) {
+    scene->dirty[node >> 6] |= (u64)1 << (node & 63);
+}
+inline static bool scene_is_changed(const Scene *scene, u32 node) {
+    return (scene->changed[node >> 6] >> (node & 63)) & 1;
+}
+
+// Set the local transform of node 'node' (a scene index).
+void scene_set_local(Scene *scene, u32 node, const Gltf_Trs *trs);
+
+// Set local transforms from a pose of the input's nodes (see animation.hpp). Only nodes whose transform differs are
+// marked dirty.
+void scene_set_local_from_pose(Scene *scene, const Animation_Pose *pose);
+
+// Recompute the world transforms of dirty nodes and their descendants.
+void scene_update(Scene *scene);
+
+// Reference: recompute every world transform, scalar.
+void scene_update_scalar(Scene *scene);
+
+#if TEST
+    void test_scene();
+#endif
+
+#if BENCH
+    void bench_scene();
+#endif
+
+#endif // include guard
@@ -427,12 +427,13 @@ inline static void simd_skip_whitespace(const char *string, u64 *offset) {
         a = _mm_loadu_si128((__m128i*)(string + inc));
         d = _mm_cmpeq_epi8(a, b);
         mask = _mm_movemask_epi8(d);
-        d = _mm_cmpeq_epi8(a, b);
+        d = _mm_cmpeq_epi8(a, c);
         mask |= _mm_movemask_epi8(d);
         d = _mm_cmpeq_epi8(a, e);
         mask |= _mm_movemask_epi8(d);
     }
-    int tz = count_trailing_zeros_u16(mask);
+    // mask marks the whitespace, so the first non whitespace char is the first zero bit
+    int tz = count_trailing_zeros_u16(~mask);
     *offset += inc + tz;
 }
 
@@ -542,4 +543,134 @@ inline static bool simd_find_int_interrupted(const char *string, char interrupt,
     return true;
 }
 
+                                        /* Base64 */
+
+// Scalar fallback for the tail of the input (and the padding chars), returns 0xff for a char outside the alphabet.
+inline static u8 base64_char_to_sextet(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return 0xff;
+}
+
+inline static u64 base64_get_decoded_size(const char *src, u64 len) {
+    u64 pad = 0;
+    if (len && src[len - 1] == '=') pad++;
+    if (len > 1 && src[len - 2] == '=') pad++;
+    return (len / 4) * 3 + ((len & 3) ? (len & 3) - 1 : 0) - pad;
+}
+
+//
+// Decode 'len' chars of base64 text from 'src' into 'dst', writing the number of decoded bytes to 'decoded_size'.
+// Returns false if 'src' contains a char which is not in the standard alphabet (whitespace included, data uris
+// do not contain any). 'dst' must have room for base64_get_decoded_size(..) bytes, nothing more is written.
+//
+// @SIMD The vector loop is the pshufb lookup method (Mula, Lemire): the high and low nibbles of each char index two
+// tables whose 'and' is non zero only for invalid chars, the high nibble (adjusted for '/') indexes the offset
+// which maps the char to its sextet, then maddubs/madd pack four sextets into three bytes per dword.
+//
+inline static bool simd_base64_decode(const char *src, u64 len, u8 *dst, u64 *decoded_size) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+    const __m256i slash       = _mm256_set1_epi8('/');
+    const __m256i merge_ab_bc = _mm256_set1_epi32(0x01400140);
+    const __m256i merge_abc   = _mm256_set1_epi32(0x00011000);
+    const __m256i pack_shuf   = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i pack_perm   = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+    __m256i a, b, hi, lo;
+    u64 i = 0;
+    u64 o = 0;
+
+    // Each iteration stores a full 32 byte register but only advances 24 bytes, so always leave at least 16 chars
+    // for the following iterations/tail to overwrite the junk: even ending in '==' they decode to 10 bytes (12 chars
+    // can be only 7). This also keeps '=' out of the vector loop.
+    while(i + 32 + 16 <= len) {
+        a  = _mm256_loadu_si256((__m256i*)(src + i));
+        hi = _mm256_and_si256(_mm256_srli_epi32(a, 4), nibble_mask);
+        lo = _mm256_and_si256(a, nibble_mask);
+
+        b = _mm256_and_si256(_mm256_shuffle_epi8(lut_lo, lo), _mm256_shuffle_epi8(lut_hi, hi));
+        if (!_mm256_testz_si256(b, b))
+            return false;
+
+        b = _mm256_cmpeq_epi8(a, slash);
+        b = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(b, hi));
+        a = _mm256_add_epi8(a, b);
+
+        a = _mm256_maddubs_epi16(a, merge_ab_bc);
+        a = _mm256_madd_epi16(a, merge_abc);
+        a = _mm256_shuffle_epi8(a, pack_shuf);
+        a = _mm256_permutevar8x32_epi32(a, pack_perm);
+
+        _mm256_storeu_si256((__m256i*)(dst + o), a);
+        i += 32;
+        o += 24;
+    }
+
+    u32 accum = 0;
+    u32 bits  = 0;
+    u8  sextet;
+    for(; i < len; ++i) {
+        if (src[i] == '=')
+            break;
+        sextet = base64_char_to_sextet(src[i]);
+        if (sextet == 0xff)
+            return false;
+        accum = (accum << 6) | sextet;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            dst[o] = (u8)(accum >> bits);
+            o++;
+        }
+    }
+
+    *decoded_size = o;
+    return true;
+}
+
+                                        /* Half Floats */
+
+// 8 wide float_to_half(..) (math.hpp), same rounding. There is no F16C in the build flags so this is all integer ops.
+inline static __m128i simd_float_to_half_8(__m256 f) {
+    __m256i x    = _mm256_castps_si256(f);
+    __m256i sign = _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(0x8000));
+    x = _mm256_and_si256(x, _mm256_set1_epi32(0x7fffffff));
+
+    __m256i odd    = _mm256_and_si256(_mm256_srli_epi32(x, 13), _mm256_set1_epi32(1));
+    __m256i normal = _mm256_add_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(0xc8000fff)), odd);
+    normal = _mm256_srli_epi32(normal, 13);
+
+    __m256 t           = _mm256_add_ps(_mm256_castsi256_ps(x), _mm256_set1_ps(0.5f));
+    __m256i subnormal  = _mm256_sub_epi32(_mm256_castps_si256(t), _mm256_set1_epi32(0x3f000000));
+
+    __m256i is_nan     = _mm256_cmpgt_epi32(x, _mm256_set1_epi32(0x7f800000));
+    __m256i inf_nan    = _mm256_or_si256(_mm256_set1_epi32(0x7c00), _mm256_and_si256(is_nan, _mm256_set1_epi32(0x200)));
+
+    __m256i is_sub     = _mm256_cmpgt_epi32(_mm256_set1_epi32(0x38800000), x);
+    __m256i is_big     = _mm256_cmpgt_epi32(x, _mm256_set1_epi32(0x477fffff));
+
+    __m256i h = _mm256_blendv_epi8(normal, subnormal, is_sub);
+    h = _mm256_blendv_epi8(h, inf_nan, is_big);
+    h = _mm256_or_si256(h, sign);
+
+    // Every lane fits in 16 bits so packus is just a narrow; pack leaves the lanes as [0-3 0-3 | 4-7 4-7].
+    h = _mm256_packus_epi32(h, h);
+    h = _mm256_permute4x64_epi64(h, 0x08);
+    return _mm256_castsi256_si128(h);
+}
+
 #endif // include guard
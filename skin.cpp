@@ -0,0 +1,917 @@
+#include <math.h>
+
+#include "skin.hpp"
+#include "accessor.hpp"
+#include "allocator.hpp"
+#include "print.h"
+#include "simd.hpp"
+
+#if TEST
+    #include "test.hpp"
+    #include "file.hpp"
+    #include "mesh.hpp"
+#endif
+
+#if BENCH
+    #include "test/bench.hpp"
+    #include "file.hpp"
+#endif
+
+                                            /* Skins */
+
+bool skin_from_gltf(Gltf *gltf, u32 skin_index, const u8 *const *buffers, Skin *skin) {
+    // A lazy gltf parses what is touched into temp, so skins, nodes and accessors are touched before the mark.
+    Gltf_Skin *gltf_skin  = gltf_skin_by_index(gltf, skin_index);
+    u32        node_count = gltf_node_get_count(gltf);
+    gltf_parse_section(gltf, GLTF_SECTION_ACCESSORS);
+
+    u64 mark = get_mark_temp();
+
+    *skin = {};
+    skin->joint_count = gltf_skin->joint_count;
+    skin->node_count  = node_count;
+
+    // One block: | joints | parents | order | inverse binds x 12 |. Joints and inverse binds are padded to a
+    // multiple of eight for skin_build_palettes(..).
+    u32 padded_joint_count = align(skin->joint_count, 8);
+    u64 size_joints  = align(sizeof(u32) * padded_joint_count, 32);
+    u64 size_nodes   = align(sizeof(u32) * node_count, 32);
+    u64 size_binds   = sizeof(float) * padded_joint_count;
+
+    u8 *block = malloc_h(size_joints + size_nodes * 2 + size_binds * 12, 32);
+    skin->joints  = (u32*)block;
+    skin->parents = (u32*)(block + size_joints);
+    skin->order   = (u32*)(block + size_joints + size_nodes);
+    for(u32 e = 0; e < 12; ++e)
+        skin->inverse_binds[e] = (float*)(block + size_joints + size_nodes * 2 + size_binds * e);
+
+    for(u32 i = 0; i < padded_joint_count; ++i)
+        skin->joints[i] = i < skin->joint_count ? (u32)gltf_skin->joints[i] : skin->joints[0];
+
+    memset(skin->parents, 0xff, sizeof(u32) * node_count);
+    const Gltf_Node *node = gltf->nodes;
+    for(u32 i = 0; i < node_count; ++i) {
+        for(u32 j = 0; j < (u32)node->child_count; ++j)
+            skin->parents[node->children[j]] = i;
+        node = (const Gltf_Node*)((u8*)node + node->stride);
+    }
+
+    // The joints and their ancestors, sorted by depth so that parents come first.
+    u32 *depths = (u32*)malloc_t(sizeof(u32) * node_count, 4);
+    memset(depths, 0xff, sizeof(u32) * node_count);
+
+    u32 max_depth = 0;
+    u32 depth;
+    u32 n;
+    for(u32 i = 0; i < skin->joint_count; ++i) {
+        n = skin->joints[i];
+        assert(n < node_count && "Skin joint out of range");
+        if (depths[n] != Max_u32)
+            continue;
+
+        depth = 0;
+        for(u32 p = skin->parents[n]; p != Max_u32; p = skin->parents[p])
+            depth++;
+        max_depth = depth > max_depth ? depth : max_depth;
+
+        for(u32 p = n; p != Max_u32 && depths[p] == Max_u32; p = skin->parents[p])
+            depths[p] = depth--;
+    }
+
+    u32 *depth_offsets = (u32*)malloc_t(sizeof(u32) * (max_depth + 2), 4);
+    memset(depth_offsets, 0, sizeof(u32) * (max_depth + 2));
+    for(u32 i = 0; i < node_count; ++i)
+        if (depths[i] != Max_u32)
+            depth_offsets[depths[i] + 1]++;
+    for(u32 i = 0; i < max_depth + 1; ++i)
+        depth_offsets[i + 1] += depth_offsets[i];
+
+    for(u32 i = 0; i < node_count; ++i)
+        if (depths[i] != Max_u32)
+            skin->order[depth_offsets[depths[i]]++] = i;
+    skin->order_count = depth_offsets[max_depth];
+
+    // Inverse binds are column major mat4s: element (row r, column c) is float c * 4 + r.
+    bool ok = true;
+    if (gltf_skin->inverse_bind_matrices < 0) {
+        for(u32 e = 0; e < 12; ++e)
+            for(u32 i = 0; i < padded_joint_count; ++i)
+                skin->inverse_binds[e][i] = e % 5 == 0 ? 1.0f : 0.0f; // 0, 5, 10 are the diagonal
+    } else {
+        const Gltf_Accessor *accessor = gltf_accessor_by_index(gltf, gltf_skin->inverse_bind_matrices);
+        assert(accessor->type == GLTF_ACCESSOR_TYPE_MAT4 && accessor->count >= (int)skin->joint_count &&
+               "Invalid inverse bind matrices");
+
+        float *matrices = (float*)malloc_t(gltf_accessor_get_read_size(accessor, ACCESSOR_READ_FORMAT_FLOAT), 4);
+        ok = gltf_accessor_read(gltf, accessor, buffers, ACCESSOR_READ_FORMAT_FLOAT, matrices);
+
+        u32 j;
+        for(u32 r = 0; r < 3; ++r)
+            for(u32 c = 0; c < 4; ++c)
+                for(u32 i = 0; i < padded_joint_count; ++i) {
+                    j = i < skin->joint_count ? i : 0;
+                    skin->inverse_binds[r * 4 + c][i] = matrices[j * 16 + c * 4 + r];
+                }
+    }
+
+    reset_to_mark_temp(mark);
+
+    if (!ok)
+        skin_free(skin);
+    return ok;
+}
+
+void skin_free(Skin *skin) {
+    if (skin->joints)
+        free_h(skin->joints);
+    *skin = {};
+}
+
+                                            /* Palettes */
+
+// 'c' = 'a' * 'b', treating each as a 4x4 with a bottom row of 0, 0, 0, 1.
+static inline void skin_matrix_mul(float *c, const float *a, const float *b) {
+    for(u32 r = 0; r < 3; ++r) {
+        for(u32 col = 0; col < 4; ++col)
+            c[r * 4 + col] = a[r * 4 + 0] * b[0 * 4 + col] + a[r * 4 + 1] * b[1 * 4 + col] +
+                             a[r * 4 + 2] * b[2 * 4 + col];
+        c[r * 4 + 3] += a[r * 4 + 3];
+    }
+}
+
+// T * R * S from a translation, a unit quaternion and a scale.
+static inline void skin_matrix_from_trs(float *m, const float *t, const float *q, const float *s) {
+    float x = q[0], y = q[1], z = q[2], w = q[3];
+    m[0]  = (1 - 2 * (y * y + z * z)) * s[0];
+    m[1]  = (    2 * (x * y - z * w)) * s[1];
+    m[2]  = (    2 * (x * z + y * w)) * s[2];
+    m[3]  = t[0];
+    m[4]  = (    2 * (x * y + z * w)) * s[0];
+    m[5]  = (1 - 2 * (x * x + z * z)) * s[1];
+    m[6]  = (    2 * (y * z - x * w)) * s[2];
+    m[7]  = t[1];
+    m[8]  = (    2 * (x * z - y * w)) * s[0];
+    m[9]  = (    2 * (y * z + x * w)) * s[1];
+    m[10] = (1 - 2 * (x * x + y * y)) * s[2];
+    m[11] = t[2];
+}
+
+u64 skin_get_palette_scratch_size(const Skin *skin) {
+    return sizeof(float) * align(skin->node_count, 8) * 24;
+}
+
+//
+// Scratch is the local and then the world matrix of every node, SoA: 12 arrays of padded node count each. The
+// local matrices of all nodes are built (eight nodes is one iteration, and most nodes of a skinned gltf are joints
+// anyway), the world matrices only of those in the skin's order.
+//
+void skin_build_palettes(const Skin *skin, u32 instance_count, const Animation_Pose *poses, void *scratch,
+                         Skin_Matrix *palettes)
+{
+    assert(((u64)scratch & 31) == 0 && "Skin palette scratch must be 32 byte aligned");
+
+    u32 stride = align(skin->node_count, 8);
+    float *local[12];
+    float *world[12];
+    for(u32 e = 0; e < 12; ++e) {
+        local[e] = (float*)scratch + stride * e;
+        world[e] = (float*)scratch + stride * (12 + e);
+    }
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 two = _mm256_set1_ps(2.0f);
+
+    alignas(32) float out[12][8];
+    float a[12];
+    float b[12];
+    float c[12];
+    u32 n;
+    u32 p;
+    const Animation_Pose *pose;
+    for(u32 inst = 0; inst < instance_count; ++inst) {
+        pose = &poses[inst];
+        assert(pose->node_count == skin->node_count && "Animation pose size does not match the skin");
+
+        // Local matrices, eight nodes at a time. Pose arrays are padded to eight floats, so the tail reads
+        // padding (and writes the padding of the scratch).
+        for(u32 i = 0; i < skin->node_count; i += 8) {
+            __m256 tx = _mm256_loadu_ps(pose->translation[0] + i);
+            __m256 ty = _mm256_loadu_ps(pose->translation[1] + i);
+            __m256 tz = _mm256_loadu_ps(pose->translation[2] + i);
+            __m256 x  = _mm256_loadu_ps(pose->rotation[0] + i);
+            __m256 y  = _mm256_loadu_ps(pose->rotation[1] + i);
+            __m256 z  = _mm256_loadu_ps(pose->rotation[2] + i);
+            __m256 w  = _mm256_loadu_ps(pose->rotation[3] + i);
+            __m256 sx = _mm256_loadu_ps(pose->scale[0] + i);
+            __m256 sy = _mm256_loadu_ps(pose->scale[1] + i);
+            __m256 sz = _mm256_loadu_ps(pose->scale[2] + i);
+
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 xw = _mm256_mul_ps(x, w), yw = _mm256_mul_ps(y, w), zw = _mm256_mul_ps(z, w);
+
+            _mm256_store_ps(local[0]  + i, _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx));
+            _mm256_store_ps(local[1]  + i, _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, zw)), sy));
+            _mm256_store_ps(local[2]  + i, _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, yw)), sz));
+            _mm256_store_ps(local[3]  + i, tx);
+            _mm256_store_ps(local[4]  + i, _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, zw)), sx));
+            _mm256_store_ps(local[5]  + i, _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy));
+            _mm256_store_ps(local[6]  + i, _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, xw)), sz));
+            _mm256_store_ps(local[7]  + i, ty);
+            _mm256_store_ps(local[8]  + i, _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, yw)), sx));
+            _mm256_store_ps(local[9]  + i, _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, xw)), sy));
+            _mm256_store_ps(local[10] + i, _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz));
+            _mm256_store_ps(local[11] + i, tz);
+        }
+
+        // World matrices, parents first
+        for(u32 i = 0; i < skin->order_count; ++i) {
+            n = skin->order[i];
+            p = skin->parents[n];
+            if (p == Max_u32) {
+                for(u32 e = 0; e < 12; ++e)
+                    world[e][n] = local[e][n];
+                continue;
+            }
+            for(u32 e = 0; e < 12; ++e) {
+                a[e] = world[e][p];
+                b[e] = local[e][n];
+            }
+            skin_matrix_mul(c, a, b);
+            for(u32 e = 0; e < 12; ++e)
+                world[e][n] = c[e];
+        }
+
+        // Joint matrices, eight joints at a time: world (gathered by node) times inverse bind
+        Skin_Matrix *palette = palettes + (u64)inst * skin->joint_count;
+        for(u32 j = 0; j < skin->joint_count; j += 8) {
+            __m256i nodes = _mm256_load_si256((const __m256i*)(skin->joints + j));
+
+            __m256 wm[12];
+            __m256 ib[12];
+            for(u32 e = 0; e < 12; ++e) {
+                wm[e] = _mm256_i32gather_ps(world[e], nodes, 4);
+                ib[e] = _mm256_load_ps(skin->inverse_binds[e] + j);
+            }
+
+            __m256 r;
+            for(u32 row = 0; row < 3; ++row) {
+                for(u32 col = 0; col < 4; ++col) {
+                    r = _mm256_mul_ps(wm[row * 4 + 0], ib[0 * 4 + col]);
+                    r = _mm256_add_ps(r, _mm256_mul_ps(wm[row * 4 + 1], ib[1 * 4 + col]));
+                    r = _mm256_add_ps(r, _mm256_mul_ps(wm[row * 4 + 2], ib[2 * 4 + col]));
+                    if (col == 3)
+                        r = _mm256_add_ps(r, wm[row * 4 + 3]);
+                    _mm256_store_ps(out[row * 4 + col], r);
+                }
+            }
+
+            u32 lane_count = skin->joint_count - j < 8 ? skin->joint_count - j : 8;
+            for(u32 l = 0; l < lane_count; ++l)
+                for(u32 e = 0; e < 12; ++e)
+                    palette[j + l].m[e] = out[e][l];
+        }
+    }
+}
+
+void skin_build_palettes_scalar(const Skin *skin, u32 instance_count, const Animation_Pose *poses, void *scratch,
+                                Skin_Matrix *palettes)
+{
+    Skin_Matrix *local = (Skin_Matrix*)scratch;
+    Skin_Matrix *world = local + skin->node_count;
+
+    float t[3];
+    float q[4];
+    float s[3];
+    float ib[12];
+    u32 n;
+    u32 p;
+    const Animation_Pose *pose;
+    for(u32 inst = 0; inst < instance_count; ++inst) {
+        pose = &poses[inst];
+        assert(pose->node_count == skin->node_count && "Animation pose size does not match the skin");
+
+        for(u32 i = 0; i < skin->order_count; ++i) {
+            n = skin->order[i];
+            for(u32 c = 0; c < 3; ++c) {
+                t[c] = pose->translation[c][n];
+                s[c] = pose->scale[c][n];
+            }
+            for(u32 c = 0; c < 4; ++c)
+                q[c] = pose->rotation[c][n];
+            skin_matrix_from_trs(local[n].m, t, q, s);
+
+            p = skin->parents[n];
+            if (p == Max_u32)
+                world[n] = local[n];
+            else
+                skin_matrix_mul(world[n].m, world[p].m, local[n].m);
+        }
+
+        Skin_Matrix *palette = palettes + (u64)inst * skin->joint_count;
+        for(u32 j = 0; j < skin->joint_count; ++j) {
+            for(u32 e = 0; e < 12; ++e)
+                ib[e] = skin->inverse_binds[e][j];
+            skin_matrix_mul(palette[j].m, world[skin->joints[j]].m, ib);
+        }
+    }
+}
+
+                                            /* Skinning */
+
+//
+// Four rows, each two vertices' four values ([v0.0 v0.1 v0.2 v0.3 v1.0 ..], [v2 v3], [v4 v5], [v6 v7]), to four
+// registers of one value for eight vertices. The unpacks and shuffles leave the vertices in the order
+// 0 2 4 6 1 3 5 7, which the permute undoes.
+//
+static inline void skin_transpose_4x8(__m256 r0, __m256 r1, __m256 r2, __m256 r3, __m256 *ret) {
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    ret[0] = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, 0x44), order);
+    ret[1] = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, 0xee), order);
+    ret[2] = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t1, t3, 0x44), order);
+    ret[3] = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t1, t3, 0xee), order);
+}
+
+// Octahedral snorm16 (see mesh_encode_normals_octahedral(..)), rounded to nearest rather than searched.
+static inline void skin_encode_octahedral_scalar(s16 *ret, const float *n) {
+    float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    float x  = l1 > 0 ? n[0] / l1 : 0;
+    float y  = l1 > 0 ? n[1] / l1 : 0;
+    if (n[2] < 0) {
+        float fold_x = (1 - fabsf(y)) * (x >= 0 ? 1 : -1);
+        float fold_y = (1 - fabsf(x)) * (y >= 0 ? 1 : -1);
+        x = fold_x;
+        y = fold_y;
+    }
+    ret[0] = (s16)nearbyintf(x * Max_s16);
+    ret[1] = (s16)nearbyintf(y * Max_s16);
+}
+
+static inline void skin_vertex_scalar(const Skin_Vertices *vertices, const Skin_Matrix *palette, u32 v,
+                                      const Skin_Output *output)
+{
+    float m[12] = {};
+    const u16   *joints  = vertices->joints  + v * 4;
+    const float *weights = vertices->weights + v * 4;
+    for(u32 k = 0; k < 4; ++k)
+        for(u32 e = 0; e < 12; ++e)
+            m[e] += weights[k] * palette[joints[k]].m[e];
+
+    const float *p = vertices->positions + v * 3;
+    float pos[3];
+    for(u32 r = 0; r < 3; ++r)
+        pos[r] = m[r * 4 + 0] * p[0] + m[r * 4 + 1] * p[1] + m[r * 4 + 2] * p[2] + m[r * 4 + 3];
+
+    float nrm[3] = {};
+    if (vertices->normals) {
+        const float *n = vertices->normals + v * 3;
+        for(u32 r = 0; r < 3; ++r)
+            nrm[r] = m[r * 4 + 0] * n[0] + m[r * 4 + 1] * n[1] + m[r * 4 + 2] * n[2];
+
+        float len = sqrtf(nrm[0] * nrm[0] + nrm[1] * nrm[1] + nrm[2] * nrm[2]);
+        float inv = len > 0 ? 1.0f / len : 0;
+        for(u32 r = 0; r < 3; ++r)
+            nrm[r] *= inv;
+    }
+
+    if (output->format == SKIN_OUTPUT_FORMAT_PACKED) {
+        u8 *dst = (u8*)output->packed + (u64)v * SKIN_PACKED_VERTEX_SIZE;
+        memcpy(dst, pos, sizeof(pos));
+        skin_encode_octahedral_scalar((s16*)(dst + 12), nrm);
+    } else {
+        memcpy(output->positions + v * 3, pos, sizeof(pos));
+        if (vertices->normals && output->normals)
+            memcpy(output->normals + v * 3, nrm, sizeof(nrm));
+    }
+}
+
+void skin_vertices_scalar(const Skin_Vertices *vertices, const Skin_Matrix *palette, const Skin_Output *output) {
+    for(u32 v = 0; v < vertices->count; ++v)
+        skin_vertex_scalar(vertices, palette, v, output);
+}
+
+void skin_vertices(const Skin_Vertices *vertices, const Skin_Matrix *palette, const Skin_Output *output) {
+    bool normals = vertices->normals != NULL;
+    bool packed  = output->format == SKIN_OUTPUT_FORMAT_PACKED;
+
+    __m256i offsets3  = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    __m256i twelve    = _mm256_set1_epi32(12);
+    __m256  zero      = _mm256_setzero_ps();
+    __m256  one       = _mm256_set1_ps(1.0f);
+    __m256  sign_mask = _mm256_set1_ps(-0.0f);
+
+    alignas(32) float out_pos[3][8];
+    alignas(32) float out_nrm[3][8];
+    alignas(32) s32   out_oct[2][8];
+
+    __m256 w[4];
+    __m256 j[4];
+    __m256 m[12];
+    __m256 p[3];
+    __m256 n[3];
+    __m256i idx;
+    u32 count8 = vertices->count & ~7u;
+    for(u32 v = 0; v < count8; v += 8) {
+        // Weights: 32 floats as four rows of two vertices
+        const float *wp = vertices->weights + v * 4;
+        skin_transpose_4x8(_mm256_loadu_ps(wp), _mm256_loadu_ps(wp + 8), _mm256_loadu_ps(wp + 16),
+                           _mm256_loadu_ps(wp + 24), w);
+
+        // Joints: 32 u16, widened to the same rows
+        __m256i j01 = _mm256_loadu_si256((const __m256i*)(vertices->joints + v * 4));
+        __m256i j23 = _mm256_loadu_si256((const __m256i*)(vertices->joints + v * 4 + 16));
+        skin_transpose_4x8(_mm256_castsi256_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(j01))),
+                           _mm256_castsi256_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(j01, 1))),
+                           _mm256_castsi256_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(j23))),
+                           _mm256_castsi256_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(j23, 1))), j);
+
+        // Blend the joint matrices. The first influence is always there, the others are often zero for every
+        // vertex in the batch (and then skipped).
+        idx = _mm256_mullo_epi32(_mm256_castps_si256(j[0]), twelve);
+        for(u32 e = 0; e < 12; ++e)
+            m[e] = _mm256_mul_ps(w[0], _mm256_i32gather_ps(palette->m + e, idx, 4));
+        for(u32 k = 1; k < 4; ++k) {
+            if (!_mm256_movemask_ps(_mm256_cmp_ps(w[k], zero, _CMP_NEQ_UQ)))
+                continue;
+            idx = _mm256_mullo_epi32(_mm256_castps_si256(j[k]), twelve);
+            for(u32 e = 0; e < 12; ++e)
+                m[e] = _mm256_add_ps(m[e], _mm256_mul_ps(w[k], _mm256_i32gather_ps(palette->m + e, idx, 4)));
+        }
+
+        for(u32 c = 0; c < 3; ++c)
+            p[c] = _mm256_i32gather_ps(vertices->positions + v * 3 + c, offsets3, 4);
+
+        __m256 r;
+        for(u32 row = 0; row < 3; ++row) {
+            r = _mm256_mul_ps(m[row * 4 + 0], p[0]);
+            r = _mm256_add_ps(r, _mm256_mul_ps(m[row * 4 + 1], p[1]));
+            r = _mm256_add_ps(r, _mm256_mul_ps(m[row * 4 + 2], p[2]));
+            r = _mm256_add_ps(r, m[row * 4 + 3]);
+            _mm256_store_ps(out_pos[row], r);
+        }
+
+        __m256 tn[3] = {zero, zero, zero};
+        if (normals) {
+            for(u32 c = 0; c < 3; ++c)
+                n[c] = _mm256_i32gather_ps(vertices->normals + v * 3 + c, offsets3, 4);
+            for(u32 row = 0; row < 3; ++row) {
+                r = _mm256_mul_ps(m[row * 4 + 0], n[0]);
+                r = _mm256_add_ps(r, _mm256_mul_ps(m[row * 4 + 1], n[1]));
+                tn[row] = _mm256_add_ps(r, _mm256_mul_ps(m[row * 4 + 2], n[2]));
+            }
+            __m256 len = _mm256_mul_ps(tn[0], tn[0]);
+            len = _mm256_add_ps(len, _mm256_mul_ps(tn[1], tn[1]));
+            len = _mm256_add_ps(len, _mm256_mul_ps(tn[2], tn[2]));
+            len = _mm256_sqrt_ps(len);
+
+            __m256 inv = _mm256_blendv_ps(zero, _mm256_div_ps(one, len), _mm256_cmp_ps(len, zero, _CMP_GT_OQ));
+            for(u32 c = 0; c < 3; ++c)
+                tn[c] = _mm256_mul_ps(tn[c], inv);
+        }
+
+        if (packed) {
+            __m256 l1 = _mm256_andnot_ps(sign_mask, tn[0]);
+            l1 = _mm256_add_ps(l1, _mm256_andnot_ps(sign_mask, tn[1]));
+            l1 = _mm256_add_ps(l1, _mm256_andnot_ps(sign_mask, tn[2]));
+
+            __m256 inv = _mm256_blendv_ps(zero, _mm256_div_ps(one, l1), _mm256_cmp_ps(l1, zero, _CMP_GT_OQ));
+            __m256 x   = _mm256_mul_ps(tn[0], inv);
+            __m256 y   = _mm256_mul_ps(tn[1], inv);
+
+            // Lower hemisphere folds over the diagonals: (1 - |y|) * sign(x), (1 - |x|) * sign(y), sign(0) = 1
+            __m256 sign_x = _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ), sign_mask);
+            __m256 sign_y = _mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_LT_OQ), sign_mask);
+            __m256 fold_x = _mm256_or_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign_mask, y)), sign_x);
+            __m256 fold_y = _mm256_or_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign_mask, x)), sign_y);
+            __m256 lower  = _mm256_cmp_ps(tn[2], zero, _CMP_LT_OQ);
+            x = _mm256_blendv_ps(x, fold_x, lower);
+            y = _mm256_blendv_ps(y, fold_y, lower);
+
+            __m256 max = _mm256_set1_ps((float)Max_s16);
+            _mm256_store_si256((__m256i*)out_oct[0], _mm256_cvtps_epi32(_mm256_mul_ps(x, max)));
+            _mm256_store_si256((__m256i*)out_oct[1], _mm256_cvtps_epi32(_mm256_mul_ps(y, max)));
+
+            u8 *dst = (u8*)output->packed + (u64)v * SKIN_PACKED_VERTEX_SIZE;
+            for(u32 l = 0; l < 8; ++l) {
+                float *pos = (float*)(dst + l * SKIN_PACKED_VERTEX_SIZE);
+                s16   *oct = (s16*)(dst + l * SKIN_PACKED_VERTEX_SIZE + 12);
+                pos[0] = out_pos[0][l];
+                pos[1] = out_pos[1][l];
+                pos[2] = out_pos[2][l];
+                oct[0] = (s16)out_oct[0][l];
+                oct[1] = (s16)out_oct[1][l];
+            }
+        } else {
+            float *dst = output->positions + v * 3;
+            for(u32 l = 0; l < 8; ++l) {
+                dst[l * 3 + 0] = out_pos[0][l];
+                dst[l * 3 + 1] = out_pos[1][l];
+                dst[l * 3 + 2] = out_pos[2][l];
+            }
+            if (normals && output->normals) {
+                for(u32 c = 0; c < 3; ++c)
+                    _mm256_store_ps(out_nrm[c], tn[c]);
+                dst = output->normals + v * 3;
+                for(u32 l = 0; l < 8; ++l) {
+                    dst[l * 3 + 0] = out_nrm[0][l];
+                    dst[l * 3 + 1] = out_nrm[1][l];
+                    dst[l * 3 + 2] = out_nrm[2][l];
+                }
+            }
+        }
+    }
+
+    for(u32 v = count8; v < vertices->count; ++v)
+        skin_vertex_scalar(vertices, palette, v, output);
+}
+
+                                            /* Tests */
+
+#if TEST || BENCH
+struct Skin_Test_Model {
+    Gltf           gltf;
+    u8            *buffer;
+    Animation_Clip clip;
+    Skin           skin;
+    Skin_Vertices  vertices;
+};
+
+// CesiumMan's clip, skin and (only) primitive, in the temp allocator (and the heap for the clip and skin).
+static bool skin_load_cesium_man(Skin_Test_Model *model) {
+    model->gltf = parse_gltf("models/cesium-man/CesiumMan.gltf");
+    Gltf_Buffer *gltf_buffer = gltf_buffer_by_index(&model->gltf, 0);
+
+    char uri[128];
+    string_format(uri, "models/cesium-man/%s", gltf_buffer->uri);
+    model->buffer = (u8*)file_read_bin_temp_large(uri, gltf_buffer->byte_length);
+
+    const u8 *buffers[] = {model->buffer};
+    if (!animation_clip_from_gltf(&model->gltf, 0, buffers, &model->clip))
+        return false;
+    if (!skin_from_gltf(&model->gltf, 0, buffers, &model->skin)) {
+        animation_clip_free(&model->clip);
+        return false;
+    }
+
+    Gltf_Mesh_Primitive *primitive = gltf_mesh_by_index(&model->gltf, 0)->primitives;
+    int joints  = -1;
+    int weights = -1;
+    for(int i = 0; i < primitive->extra_attribute_count; ++i) {
+        if (primitive->extra_attributes[i].n != 0)
+            continue;
+        if (primitive->extra_attributes[i].type == GLTF_MESH_ATTRIBUTE_TYPE_JOINTS)
+            joints = primitive->extra_attributes[i].accessor_index;
+        else if (primitive->extra_attributes[i].type == GLTF_MESH_ATTRIBUTE_TYPE_WEIGHTS)
+            weights = primitive->extra_attributes[i].accessor_index;
+    }
+    assert(joints >= 0 && weights >= 0 && primitive->position >= 0 && primitive->normal >= 0);
+
+    const Gltf_Accessor *accessors[4] = {
+        gltf_accessor_by_index(&model->gltf, primitive->position),
+        gltf_accessor_by_index(&model->gltf, primitive->normal),
+        gltf_accessor_by_index(&model->gltf, joints),
+        gltf_accessor_by_index(&model->gltf, weights),
+    };
+    Accessor_Read_Format formats[4] = {ACCESSOR_READ_FORMAT_FLOAT, ACCESSOR_READ_FORMAT_FLOAT,
+                                       ACCESSOR_READ_FORMAT_U16, ACCESSOR_READ_FORMAT_FLOAT};
+    void *data[4];
+    bool ok = true;
+    for(u32 i = 0; i < 4; ++i) {
+        data[i] = malloc_t(gltf_accessor_get_read_size(accessors[i], formats[i]), 4);
+        ok &= gltf_accessor_read(&model->gltf, accessors[i], buffers, formats[i], data[i]);
+    }
+
+    model->vertices = {
+        .count     = (u32)accessors[0]->count,
+        .positions = (const float*)data[0],
+        .normals   = (const float*)data[1],
+        .joints    = (const u16*)data[2],
+        .weights   = (const float*)data[3],
+    };
+    return ok;
+}
+
+static void skin_free_cesium_man(Skin_Test_Model *model) {
+    animation_clip_free(&model->clip);
+    skin_free(&model->skin);
+}
+
+// The temp allocator aligns offsets, not addresses.
+static void* skin_alloc_palette_scratch_temp(const Skin *skin) {
+    u8 *ret = malloc_t(skin_get_palette_scratch_size(skin) + 32, 4);
+    return (void*)(((u64)ret + 31) & ~(u64)31);
+}
+
+// Poses for 'count' instances of CesiumMan, spread across its clip.
+static Animation_Pose* skin_sample_cesium_man_temp(Skin_Test_Model *model, u32 count) {
+    Animation_Pose *poses = (Animation_Pose*)malloc_t(sizeof(Animation_Pose) * count, 8);
+    float          *times = (float*)malloc_t(sizeof(float) * count, 4);
+    u64             size  = animation_pose_get_size(model->clip.node_count);
+    for(u32 i = 0; i < count; ++i) {
+        animation_pose_init(&poses[i], model->clip.node_count, malloc_t(size, 4));
+        if (i == 0)
+            animation_pose_set_rest(&poses[0], &model->gltf);
+        else
+            animation_pose_copy(&poses[i], &poses[0]);
+        times[i] = model->clip.duration * (float)i / (float)count;
+    }
+    animation_sample(&model->clip, count, times, poses);
+    return poses;
+}
+#endif
+
+#if TEST
+static float test_skin_max_diff(const float *a, const float *b, u64 count) {
+    float ret = 0;
+    float d;
+    for(u64 i = 0; i < count; ++i) {
+        d   = fabsf(a[i] - b[i]);
+        ret = d > ret ? d : ret;
+    }
+    return ret;
+}
+
+// Two joints: a translation along x, and a quarter turn about z with a translation along y.
+static const Skin_Matrix TEST_SKIN_PALETTE[2] = {
+    {{1, 0, 0, 1,   0, 1, 0, 0,   0, 0, 1, 0}},
+    {{0, -1, 0, 0,  1, 0, 0, 2,   0, 0, 1, 0}},
+};
+
+void test_skin() {
+    u64 mark = get_mark_temp();
+
+    BEGIN_TEST_MODULE("Skin_Vertices", false, false);
+    {
+        // Three batches and a tail. Vertex i is on joint 0, joint 1, or half of each, by i % 3; the last vertex has
+        // four influences of a quarter.
+        const u32 count = 27;
+        float *positions = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        float *normals   = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        u16   *joints    = (u16*)  malloc_t(sizeof(u16)   * count * 4, 4);
+        float *weights   = (float*)malloc_t(sizeof(float) * count * 4, 4);
+        for(u32 i = 0; i < count; ++i) {
+            positions[i * 3 + 0] = (float)i;
+            positions[i * 3 + 1] = 1;
+            positions[i * 3 + 2] = 0.5f * i;
+            normals[i * 3 + 0] = (float)(i & 1);
+            normals[i * 3 + 1] = 0;
+            normals[i * 3 + 2] = (float)!(i & 1);
+
+            joints[i * 4 + 0] = 0;
+            joints[i * 4 + 1] = 1;
+            joints[i * 4 + 2] = 1;
+            joints[i * 4 + 3] = 0;
+            weights[i * 4 + 0] = i % 3 == 0 ? 1.0f : i % 3 == 1 ? 0.0f : 0.5f;
+            weights[i * 4 + 1] = 1.0f - weights[i * 4 + 0];
+            weights[i * 4 + 2] = 0;
+            weights[i * 4 + 3] = 0;
+        }
+        for(u32 k = 0; k < 4; ++k)
+            weights[(count - 1) * 4 + k] = 0.25f;
+
+        Skin_Vertices vertices = {count, positions, normals, joints, weights};
+
+        float *out_positions    = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        float *out_normals      = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        float *scalar_positions = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        float *scalar_normals   = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        Skin_Output output        = {.format = SKIN_OUTPUT_FORMAT_FLOAT, .positions = out_positions, .normals = out_normals};
+        Skin_Output scalar_output = {.format = SKIN_OUTPUT_FORMAT_FLOAT, .positions = scalar_positions, .normals = scalar_normals};
+        skin_vertices(&vertices, TEST_SKIN_PALETTE, &output);
+        skin_vertices_scalar(&vertices, TEST_SKIN_PALETTE, &scalar_output);
+
+        // 0: (0, 1, 0) translated by x
+        TEST_FEQ("joint_0.x", out_positions[0], 1.0f, false);
+        TEST_FEQ("joint_0.y", out_positions[1], 1.0f, false);
+        // 1: (1, 1, 0.5) turned to (-1, 1, 0.5), then up y
+        TEST_FEQ("joint_1.x", out_positions[3], -1.0f, false);
+        TEST_FEQ("joint_1.y", out_positions[4],  3.0f, false);
+        TEST_FEQ("joint_1.z", out_positions[5],  0.5f, false);
+        TEST_FEQ("joint_1_normal.y", out_normals[4], 1.0f, false); // (1, 0, 0) turned
+        // 2: (2, 1, 1) half way between (3, 1, 1) and (-1, 4, 1)
+        TEST_FEQ("half.x", out_positions[6], 1.0f, false);
+        TEST_FEQ("half.y", out_positions[7], 2.5f, false);
+        // Last (26, 1, 13), in the scalar tail: a quarter on each of four
+        TEST_FEQ("four_influences.x", out_positions[78], 0.5f * 27.0f + 0.5f * -1.0f, false);
+        TEST_FEQ("four_influences.y", out_positions[79], 0.5f * 1.0f  + 0.5f * 28.0f, false);
+
+        TEST_EQ("matches_scalar_positions", test_skin_max_diff(out_positions, scalar_positions, count * 3) < 1e-5f, true, false);
+        TEST_EQ("matches_scalar_normals",   test_skin_max_diff(out_normals,   scalar_normals,   count * 3) < 1e-5f, true, false);
+
+        // Packed: the same positions, and normals within the octahedral error
+        u8 *packed        = malloc_t(SKIN_PACKED_VERTEX_SIZE * count, 4);
+        u8 *scalar_packed = malloc_t(SKIN_PACKED_VERTEX_SIZE * count, 4);
+        Skin_Output packed_output        = {.format = SKIN_OUTPUT_FORMAT_PACKED, .packed = packed};
+        Skin_Output scalar_packed_output = {.format = SKIN_OUTPUT_FORMAT_PACKED, .packed = scalar_packed};
+        skin_vertices(&vertices, TEST_SKIN_PALETTE, &packed_output);
+        skin_vertices_scalar(&vertices, TEST_SKIN_PALETTE, &scalar_packed_output);
+
+        float position_diff = 0;
+        float normal_diff   = 0;
+        s32   oct_diff      = 0;
+        float n[3];
+        const s16 *oct;
+        const s16 *scalar_oct;
+        for(u32 i = 0; i < count; ++i) {
+            float d = test_skin_max_diff((const float*)(packed + i * SKIN_PACKED_VERTEX_SIZE), out_positions + i * 3, 3);
+            position_diff = d > position_diff ? d : position_diff;
+
+            oct        = (const s16*)(packed + i * SKIN_PACKED_VERTEX_SIZE + 12);
+            scalar_oct = (const s16*)(scalar_packed + i * SKIN_PACKED_VERTEX_SIZE + 12);
+            mesh_decode_octahedral(n, oct[0] / 32767.0f, oct[1] / 32767.0f);
+            d = test_skin_max_diff(n, out_normals + i * 3, 3);
+            normal_diff = d > normal_diff ? d : normal_diff;
+
+            for(u32 c = 0; c < 2; ++c)
+                oct_diff = abs(oct[c] - scalar_oct[c]) > oct_diff ? abs(oct[c] - scalar_oct[c]) : oct_diff;
+        }
+        TEST_FEQ("packed_positions", position_diff, 0.0f, false);
+        TEST_EQ("packed_normals", normal_diff < 1e-3f, true, false);
+        TEST_LT("packed_matches_scalar", oct_diff, 2, false);
+    }
+    END_TEST_MODULE();
+
+    BEGIN_TEST_MODULE("Skin_Cesium_Man", false, false);
+    {
+        Skin_Test_Model model;
+        bool ok = skin_load_cesium_man(&model);
+        TEST_EQ("load", ok, true, false);
+
+        Skin *skin = &model.skin;
+        TEST_EQ("joint_count", skin->joint_count, 19, false);
+        TEST_EQ("node_count",  skin->node_count,  22, false);
+        TEST_EQ("order_count", skin->order_count, 21, false); // Every joint, and the two matrix nodes above them
+        TEST_EQ("order_root",  skin->order[0], 0, false);
+        TEST_EQ("parent_1",    skin->parents[1], 0, false);
+        TEST_EQ("parent_3",    skin->parents[3], 1, false);
+        TEST_EQ("parent_0",    skin->parents[0], Max_u32, false);
+
+        bool parents_first = true;
+        for(u32 i = 0; i < skin->order_count; ++i)
+            for(u32 j = i; j < skin->order_count; ++j)
+                parents_first = parents_first && skin->parents[skin->order[i]] != skin->order[j];
+        TEST_EQ("parents_first", parents_first, true, false);
+
+        u32 instance_count = 16;
+        Animation_Pose *poses    = skin_sample_cesium_man_temp(&model, instance_count);
+        void           *scratch  = skin_alloc_palette_scratch_temp(skin);
+        Skin_Matrix    *palettes = (Skin_Matrix*)malloc_t(sizeof(Skin_Matrix) * skin->joint_count * instance_count, 4);
+        Skin_Matrix    *scalar   = (Skin_Matrix*)malloc_t(sizeof(Skin_Matrix) * skin->joint_count * instance_count, 4);
+
+        // At the rest pose every joint is where it was bound, so every joint matrix is the transform of the two
+        // matrix nodes above the skeleton (the skinned mesh is their child).
+        Animation_Pose rest;
+        animation_pose_init(&rest, skin->node_count, malloc_t(animation_pose_get_size(skin->node_count), 4));
+        animation_pose_set_rest(&rest, &model.gltf);
+        skin_build_palettes(skin, 1, &rest, scratch, palettes);
+
+        float roots[2][12];
+        for(u32 i = 0; i < 2; ++i) {
+            const float *matrix = (const float*)&gltf_node_by_index(&model.gltf, i)->matrix; // Column major
+            for(u32 r = 0; r < 3; ++r)
+                for(u32 c = 0; c < 4; ++c)
+                    roots[i][r * 4 + c] = matrix[c * 4 + r];
+        }
+        float root[12];
+        skin_matrix_mul(root, roots[0], roots[1]);
+
+        float rest_diff = 0;
+        for(u32 j = 0; j < skin->joint_count; ++j) {
+            float d = test_skin_max_diff(palettes[j].m, root, 12);
+            rest_diff = d > rest_diff ? d : rest_diff;
+        }
+        TEST_EQ("rest_is_root_transform", rest_diff < 1e-3f, true, false);
+
+        skin_build_palettes(skin, instance_count, poses, scratch, palettes);
+        skin_build_palettes_scalar(skin, instance_count, poses, scratch, scalar);
+        TEST_EQ("palettes_match_scalar",
+                test_skin_max_diff(palettes->m, scalar->m, (u64)skin->joint_count * instance_count * 12) < 1e-5f, true, false);
+
+        // Skin one instance mid stride against the reference
+        u32 count = model.vertices.count;
+        float *positions        = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        float *normals          = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        float *scalar_positions = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        float *scalar_normals   = (float*)malloc_t(sizeof(float) * count * 3, 4);
+        Skin_Output output        = {.format = SKIN_OUTPUT_FORMAT_FLOAT, .positions = positions, .normals = normals};
+        Skin_Output scalar_output = {.format = SKIN_OUTPUT_FORMAT_FLOAT, .positions = scalar_positions, .normals = scalar_normals};
+
+        const Skin_Matrix *palette = palettes + skin->joint_count * (instance_count / 2);
+        skin_vertices(&model.vertices, palette, &output);
+        skin_vertices_scalar(&model.vertices, palette, &scalar_output);
+        TEST_EQ("vertex_count", count, 3273, false);
+        TEST_EQ("positions_match_scalar", test_skin_max_diff(positions, scalar_positions, count * 3) < 1e-5f, true, false);
+        TEST_EQ("normals_match_scalar",   test_skin_max_diff(normals,   scalar_normals,   count * 3) < 1e-5f, true, false);
+
+        // The walk moves the skinned mesh away from the bind pose
+        TEST_EQ("animated", test_skin_max_diff(positions, model.vertices.positions, count * 3) > 1e-2f, true, false);
+
+        // From a lazy gltf, the same skin, and the sections it parsed are still there afterwards.
+        Gltf lazy = parse_gltf_lazy("models/cesium-man/CesiumMan.gltf");
+        const u8 *buffers[] = {model.buffer};
+        Skin lazy_skin;
+        ok = skin_from_gltf(&lazy, 0, buffers, &lazy_skin);
+        TEST_EQ("lazy_load", ok, true, false);
+        TEST_EQ("lazy_order_count", lazy_skin.order_count, skin->order_count, false);
+        TEST_EQ("lazy_inverse_binds", test_skin_max_diff(lazy_skin.inverse_binds[0], skin->inverse_binds[0],
+                                                         lazy_skin.joint_count) == 0.0f, true, false);
+        memset(malloc_t(64 * 1024, 16), 0xcd, 64 * 1024);
+        TEST_EQ("lazy_skins",     gltf_skin_by_index(&lazy, 0)->joint_count,
+                gltf_skin_by_index(&model.gltf, 0)->joint_count, false);
+        TEST_EQ("lazy_nodes",     gltf_node_by_index(&lazy, 0)->child_count,
+                gltf_node_by_index(&model.gltf, 0)->child_count, false);
+        TEST_EQ("lazy_accessors", gltf_accessor_by_index(&lazy, 0)->count,
+                gltf_accessor_by_index(&model.gltf, 0)->count, false);
+        skin_free(&lazy_skin);
+
+        skin_free_cesium_man(&model);
+    }
+    END_TEST_MODULE();
+
+    reset_to_mark_temp(mark);
+}
+#endif // TEST
+
+#if BENCH
+void bench_skin() {
+    BENCH_MODULE("Skin");
+
+    u64 mark = get_mark_temp();
+
+    Skin_Test_Model model;
+    if (!skin_load_cesium_man(&model)) {
+        println("    Failed to load CesiumMan's skin, skipping");
+        reset_to_mark_temp(mark);
+        return;
+    }
+
+    // CesiumMan instanced 1000 times, each at its own time in the clip. Every instance is skinned into the same
+    // output (a thousand instances of output do not fit in the temp allocator), so the writes stay in cache.
+    const u32 instance_count = 1000;
+    Skin           *skin     = &model.skin;
+    Animation_Pose *poses    = skin_sample_cesium_man_temp(&model, instance_count);
+    void           *scratch  = skin_alloc_palette_scratch_temp(skin);
+    Skin_Matrix    *palettes = (Skin_Matrix*)malloc_t(sizeof(Skin_Matrix) * skin->joint_count * instance_count, 4);
+
+    const u32 iterations = 16;
+    u64 joints = (u64)skin->joint_count * instance_count * iterations;
+
+    Bench_Timer timer = begin_bench();
+    for(u32 i = 0; i < iterations; ++i) {
+        skin_build_palettes(skin, instance_count, poses, scratch, palettes);
+        bench_keep(palettes[0].m[3]);
+    }
+    u64 ns_simd = end_bench(&timer);
+
+    timer = begin_bench();
+    for(u32 i = 0; i < iterations; ++i) {
+        skin_build_palettes_scalar(skin, instance_count, poses, scratch, palettes);
+        bench_keep(palettes[0].m[3]);
+    }
+    u64 ns_scalar = end_bench(&timer);
+
+    println("    palettes, %u instances (%u joints each): simd %f ns/joint, scalar %f ns/joint, speedup %f",
+            (u64)instance_count, (u64)skin->joint_count, (double)ns_simd / joints, (double)ns_scalar / joints,
+            (double)ns_scalar / (double)ns_simd);
+
+    u32 count = model.vertices.count;
+    Skin_Output outputs[2] = {
+        {.format    = SKIN_OUTPUT_FORMAT_FLOAT,
+         .positions = (float*)malloc_t(sizeof(float) * count * 3, 4),
+         .normals   = (float*)malloc_t(sizeof(float) * count * 3, 4)},
+        {.format    = SKIN_OUTPUT_FORMAT_PACKED,
+         .packed    = malloc_t(SKIN_PACKED_VERTEX_SIZE * count, 16)},
+    };
+    const char *output_names[2] = {"float", "packed"};
+
+    u64 vertices = (u64)count * instance_count;
+    for(u32 o = 0; o < 2; ++o) {
+        timer = begin_bench();
+        for(u32 i = 0; i < instance_count; ++i) {
+            skin_vertices(&model.vertices, palettes + skin->joint_count * i, &outputs[o]);
+            bench_keep(i);
+        }
+        ns_simd = end_bench(&timer);
+
+        timer = begin_bench();
+        for(u32 i = 0; i < instance_count; ++i) {
+            skin_vertices_scalar(&model.vertices, palettes + skin->joint_count * i, &outputs[o]);
+            bench_keep(i);
+        }
+        ns_scalar = end_bench(&timer);
+
+        println("    skinning %s, %u instances (%u vertices each): simd %f ns/vertex (%f Mverts/s), scalar %f ns/vertex (%f Mverts/s), speedup %f",
+                output_names[o], (u64)instance_count, (u64)count, (double)ns_simd / vertices,
+                (double)vertices * 1000.0 / ns_simd, (double)ns_scalar / vertices,
+                (double)vertices * 1000.0 / ns_scalar, (double)ns_scalar / (double)ns_simd);
+    }
+
+    skin_free_cesium_man(&model);
+    reset_to_mark_temp(mark);
+}
+#endif // BENCH
@@ -0,0 +1,92 @@
+#ifndef SOL_SKIN_HPP_INCLUDE_GUARD_
+#define SOL_SKIN_HPP_INCLUDE_GUARD_
+
+#include "basic.h"
+#include "gltf.hpp"
+#include "animation.hpp"
+
+/*
+    Skinning: joint palettes from sampled poses (see animation.hpp), and linear blend skinning on the cpu, for the
+    passes which want skinned vertices without a trip through the gpu (shadows, collision hulls).
+
+    A palette is a skin's joint matrices for one instance: the joint's world transform times its inverse bind
+    matrix. World is the node hierarchy from the scene roots: as per the spec, the transform of the node holding the
+    skinned mesh is ignored, so the skinned vertices are in the same space as the roots.
+
+    skin_build_palettes(..) takes many instances' poses. Per instance, the local matrices of every node come from the
+    pose eight nodes at a time (avx2, the pose is SoA), the hierarchy walk is scalar (only over the joints and their
+    ancestors), and the joint matrices are eight joints at a time again.
+
+    skin_vertices(..) blends each vertex's four joints (JOINTS_0 / WEIGHTS_0) eight vertices at a time: the weights
+    and joints are transposed in registers, the joint matrices are gathered from the palette, and an influence which
+    is zero for all eight vertices is skipped. The output is either float3 positions and normals, or packed: a float3
+    position and an octahedral snorm16 x2 normal (see mesh.hpp) per 16 byte vertex.
+
+    The _scalar versions are the references for the tests and benchmarks.
+*/
+
+// An affine transform, 3 rows of 4 (row major): the fourth column is the translation.
+struct Skin_Matrix {
+    float m[12];
+};
+
+struct Skin {
+    u32 joint_count;
+    u32 node_count;
+    u32 order_count;
+
+    u32 *joints;  // Node of each joint
+    u32 *parents; // Parent of each node, Max_u32 for roots
+    u32 *order;   // The joints and their ancestors, every parent before its children
+
+    float *inverse_binds[12]; // Per joint, SoA (one array per matrix element)
+};
+
+// Build a skin from skin 'skin' of 'gltf'. The skin is one heap allocation, free it with skin_free(..). Returns false
+// if the inverse bind matrices could not be read.
+bool skin_from_gltf(Gltf *gltf, u32 skin_index, const u8 *const *buffers, Skin *skin);
+void skin_free(Skin *skin);
+
+// Bytes of scratch memory for skin_build_palettes(..).
+u64 skin_get_palette_scratch_size(const Skin *skin);
+
+// Write the palette of instance i (joint_count matrices) to palettes + i * joint_count, from poses[i]. 'scratch' is
+// skin_get_palette_scratch_size(..) bytes, 32 byte aligned.
+void skin_build_palettes(const Skin *skin, u32 instance_count, const Animation_Pose *poses, void *scratch,
+                         Skin_Matrix *palettes);
+void skin_build_palettes_scalar(const Skin *skin, u32 instance_count, const Animation_Pose *poses, void *scratch,
+                                Skin_Matrix *palettes);
+
+struct Skin_Vertices {
+    u32          count;
+    const float *positions; // float3
+    const float *normals;   // float3, may be NULL
+    const u16   *joints;    // 4 per vertex (JOINTS_0), into the palette
+    const float *weights;   // 4 per vertex (WEIGHTS_0)
+};
+
+enum Skin_Output_Format {
+    SKIN_OUTPUT_FORMAT_FLOAT  = 0, // 'positions' and 'normals', float3
+    SKIN_OUTPUT_FORMAT_PACKED = 1, // 'packed', float3 position then octahedral snorm16 x2 normal, 16 bytes
+};
+static constexpr u32 SKIN_PACKED_VERTEX_SIZE = 16;
+
+struct Skin_Output {
+    Skin_Output_Format format;
+    float *positions;
+    float *normals; // May be NULL (and is ignored if the vertices have no normals)
+    void  *packed;
+};
+
+void skin_vertices(const Skin_Vertices *vertices, const Skin_Matrix *palette, const Skin_Output *output);
+void skin_vertices_scalar(const Skin_Vertices *vertices, const Skin_Matrix *palette, const Skin_Output *output);
+
+#if TEST
+    void test_skin();
+#endif
+
+#if BENCH
+    void bench_skin();
+#endif
+
+#endif // include guard
@@ -0,0 +1,73 @@
+#if BENCH
+
+#ifndef SOL_BENCH_HPP_INCLUDE_GUARD_
+#define SOL_BENCH_HPP_INCLUDE_GUARD_
+
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../typedef.h"
+#include "../print.h"
+
+//
+// Benchmarks live next to the code they measure (under '#if BENCH', like tests under '#if TEST'), and are run from
+// main() after the tests. They only print, they do not pass or fail.
+//
+// Usage:
+//     Bench_Timer timer = begin_bench();
+//     ... work ...
+//     u64 ns = end_bench(&timer);
+//     bench_report_throughput("parse_gltf", ns, bytes, iterations);
+//
+
+struct Bench_Timer {
+    u64 start;
+};
+
+inline static u64 bench_get_time_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000 + (u64)ts.tv_nsec;
+}
+inline static Bench_Timer begin_bench() {
+    return {bench_get_time_ns()};
+}
+inline static u64 end_bench(Bench_Timer *timer) {
+    return bench_get_time_ns() - timer->start;
+}
+
+// Keep the compiler from optimizing away the result of a benchmarked computation.
+template<typename T>
+inline static void bench_keep(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Drop a file from the page cache, so that the next read of it comes from disk ('cold' as opposed to 'warm').
+// Best effort: the kernel only drops clean pages which nothing else has mapped, hence the sync first.
+inline static void bench_drop_file_cache(const char *file_name) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+#define BENCH_MODULE(name) println("\n[Bench] %s", name)
+
+inline static void bench_report(const char *name, u64 ns, u64 iterations) {
+    println("    %s: %f ms total, %f ns/iter (%u iters)", name, (double)ns / 1e6,
+            (double)ns / (double)(iterations ? iterations : 1), iterations);
+}
+inline static void bench_report_throughput(const char *name, u64 ns, u64 bytes, u64 iterations) {
+    double seconds = (double)ns / 1e9;
+    println("    %s: %f ms/iter, %f MB/s", name, (double)ns / 1e6 / (double)(iterations ? iterations : 1),
+            (double)bytes * (double)iterations / (1024.0 * 1024.0) / seconds);
+}
+inline static void bench_report_rate(const char *name, const char *unit, u64 ns, u64 count) {
+    println("    %s: %f %s/s", name, (double)count / ((double)ns / 1e9), unit);
+}
+
+#endif // include guard
+
+#endif // BENCH
@@ -0,0 +1,392 @@
+#if BENCH
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "gltf_generator.hpp"
+#include "../assert.h"
+
+// Gltf constants
+static const u32 GLTF_GENERATOR_COMPONENT_U16    = 5123;
+static const u32 GLTF_GENERATOR_COMPONENT_FLOAT  = 5126;
+static const u32 GLTF_GENERATOR_TARGET_VERTEX    = 34962;
+static const u32 GLTF_GENERATOR_TARGET_INDEX     = 34963;
+static const u32 GLTF_GENERATOR_GLB_MAGIC        = 0x46546C67; // 'glTF'
+static const u32 GLTF_GENERATOR_GLB_CHUNK_JSON   = 0x4E4F534A; // 'JSON'
+static const u32 GLTF_GENERATOR_GLB_CHUNK_BIN    = 0x004E4942; // 'BIN\0'
+
+static const float GLTF_GENERATOR_GRID_SPACING   = 1.5; // Distance between the origins of neighbouring grids
+static const u32   GLTF_GENERATOR_GRID_ROW       = 1024;
+static const float GLTF_GENERATOR_FRAME_TIME     = 1.0 / 30.0;
+
+// Where everything is in the buffer. Every section is a multiple of four bytes, so nothing needs padding.
+struct Gltf_Generator_Layout {
+    u32 primitive_count;
+    u32 vertex_count;     // Per primitive
+    u32 index_count;      // Per primitive
+    u32 index_stride;     // Per primitive, index bytes aligned to four
+
+    u64 offset_indices;
+    u64 offset_positions;
+    u64 offset_normals;
+    u64 offset_tex_coords;
+    u64 offset_times;
+    u64 offset_translations;
+    u64 offset_rotations;
+    u64 size;
+};
+
+static Gltf_Generator_Layout gltf_generator_get_layout(const Gltf_Generator_Config *config) {
+    Gltf_Generator_Layout ret;
+
+    u32 quads_per_side = config->grid_size - 1;
+
+    ret.primitive_count = config->mesh_count * config->primitives_per_mesh;
+    ret.vertex_count    = config->grid_size * config->grid_size;
+    ret.index_count     = quads_per_side * quads_per_side * 6;
+    ret.index_stride    = (ret.index_count * sizeof(u16) + 3) & ~3;
+
+    u64 primitive_count = ret.primitive_count;
+    u64 keyframe_count  = config->animation_count ? config->keyframe_count : 0;
+
+    ret.offset_indices      = 0;
+    ret.offset_positions    = ret.offset_indices      + primitive_count * ret.index_stride;
+    ret.offset_normals      = ret.offset_positions    + primitive_count * ret.vertex_count * sizeof(float) * 3;
+    ret.offset_tex_coords   = ret.offset_normals      + primitive_count * ret.vertex_count * sizeof(float) * 3;
+    ret.offset_times        = ret.offset_tex_coords   + primitive_count * ret.vertex_count * sizeof(float) * 2;
+    ret.offset_translations = ret.offset_times        + keyframe_count  * sizeof(float);
+    ret.offset_rotations    = ret.offset_translations + keyframe_count  * config->animation_count * sizeof(float) * 3;
+    ret.size                = ret.offset_rotations    + keyframe_count  * config->animation_count * sizeof(float) * 4;
+
+    return ret;
+}
+
+static void gltf_generator_get_grid_origin(u32 primitive, float *x, float *z) {
+    *x = (float)(primitive % GLTF_GENERATOR_GRID_ROW) * GLTF_GENERATOR_GRID_SPACING;
+    *z = (float)(primitive / GLTF_GENERATOR_GRID_ROW) * GLTF_GENERATOR_GRID_SPACING;
+}
+
+Gltf_Generator_Config gltf_generator_config_from_entity_count(u64 entity_count) {
+    // Every mesh has one primitive, so four accessors: a mesh and a node come to six entities, and the rest is
+    // made up by materials and animations (each animation adds two accessors).
+    u64 mesh_count = entity_count / 7;
+
+    Gltf_Generator_Config ret = {};
+    ret.mesh_count          = mesh_count ? mesh_count : 1;
+    ret.primitives_per_mesh = 1;
+    ret.node_count          = ret.mesh_count;
+    ret.material_count      = entity_count / 64 ? entity_count / 64 : 1;
+    ret.animation_count     = entity_count / 64;
+    ret.keyframe_count      = 8;
+    ret.grid_size           = 2;
+    ret.glb                 = false;
+    return ret;
+}
+
+static void gltf_generator_write_json(FILE *file, const Gltf_Generator_Config *config,
+                                      const Gltf_Generator_Layout *layout, const char *bin_uri)
+{
+    u32 primitive_count = layout->primitive_count;
+    u32 time_accessor   = primitive_count * 4;
+
+    fprintf(file, "{\n\"asset\":{\"version\":\"2.0\",\"generator\":\"SlugVk3 gltf_generator\"},\n");
+    fprintf(file, "\"scene\":0,\n\"scenes\":[{\"nodes\":[0]}],\n");
+
+    // Accessors: [indices, positions, normals, tex coords] per primitive, then the keyframe times, then
+    // [translations, rotations] per animation.
+    fprintf(file, "\"accessors\":[\n");
+    float x, z;
+    for(u32 i = 0; i < primitive_count; ++i) {
+        gltf_generator_get_grid_origin(i, &x, &z);
+        fprintf(file,
+            "{\"bufferView\":0,\"byteOffset\":%llu,\"componentType\":%u,\"count\":%u,\"type\":\"SCALAR\"},\n"
+            "{\"bufferView\":1,\"byteOffset\":%llu,\"componentType\":%u,\"count\":%u,\"type\":\"VEC3\","
+            "\"max\":[%.4f,0.0,%.4f],\"min\":[%.4f,0.0,%.4f]},\n"
+            "{\"bufferView\":2,\"byteOffset\":%llu,\"componentType\":%u,\"count\":%u,\"type\":\"VEC3\"},\n"
+            "{\"bufferView\":3,\"byteOffset\":%llu,\"componentType\":%u,\"count\":%u,\"type\":\"VEC2\"}%s\n",
+            (unsigned long long)i * layout->index_stride, GLTF_GENERATOR_COMPONENT_U16, layout->index_count,
+            (unsigned long long)i * layout->vertex_count * 12, GLTF_GENERATOR_COMPONENT_FLOAT, layout->vertex_count,
+            x + 1, z + 1, x, z,
+            (unsigned long long)i * layout->vertex_count * 12, GLTF_GENERATOR_COMPONENT_FLOAT, layout->vertex_count,
+            (unsigned long long)i * layout->vertex_count * 8,  GLTF_GENERATOR_COMPONENT_FLOAT, layout->vertex_count,
+            (i + 1 == primitive_count && !config->animation_count) ? "" : ",");
+    }
+    if (config->animation_count) {
+        fprintf(file, "{\"bufferView\":4,\"componentType\":%u,\"count\":%u,\"type\":\"SCALAR\",\"max\":[%.4f],\"min\":[0.0]},\n",
+                GLTF_GENERATOR_COMPONENT_FLOAT, config->keyframe_count,
+                (config->keyframe_count - 1) * GLTF_GENERATOR_FRAME_TIME);
+        for(u32 i = 0; i < config->animation_count; ++i) {
+            fprintf(file,
+                "{\"bufferView\":5,\"byteOffset\":%llu,\"componentType\":%u,\"count\":%u,\"type\":\"VEC3\"},\n"
+                "{\"bufferView\":6,\"byteOffset\":%llu,\"componentType\":%u,\"count\":%u,\"type\":\"VEC4\"}%s\n",
+                (unsigned long long)i * config->keyframe_count * 12, GLTF_GENERATOR_COMPONENT_FLOAT, config->keyframe_count,
+                (unsigned long long)i * config->keyframe_count * 16, GLTF_GENERATOR_COMPONENT_FLOAT, config->keyframe_count,
+                i + 1 == config->animation_count ? "" : ",");
+        }
+    }
+    fprintf(file, "],\n");
+
+    // Animations
+    if (config->animation_count) {
+        fprintf(file, "\"animations\":[\n");
+        for(u32 i = 0; i < config->animation_count; ++i) {
+            u32 node = i % config->node_count;
+            fprintf(file,
+                "{\"channels\":[{\"sampler\":0,\"target\":{\"node\":%u,\"path\":\"translation\"}},"
+                "{\"sampler\":1,\"target\":{\"node\":%u,\"path\":\"rotation\"}}],"
+                "\"samplers\":[{\"input\":%u,\"interpolation\":\"LINEAR\",\"output\":%u},"
+                "{\"input\":%u,\"interpolation\":\"LINEAR\",\"output\":%u}]}%s\n",
+                node, node, time_accessor, time_accessor + 1 + i * 2, time_accessor, time_accessor + 2 + i * 2,
+                i + 1 == config->animation_count ? "" : ",");
+        }
+        fprintf(file, "],\n");
+    }
+
+    // Buffers
+    if (bin_uri)
+        fprintf(file, "\"buffers\":[{\"byteLength\":%llu,\"uri\":\"%s\"}],\n", (unsigned long long)layout->size, bin_uri);
+    else
+        fprintf(file, "\"buffers\":[{\"byteLength\":%llu}],\n", (unsigned long long)layout->size);
+
+    // Buffer views
+    fprintf(file, "\"bufferViews\":[\n");
+    fprintf(file, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu,\"target\":%u},\n",
+            (unsigned long long)layout->offset_indices,
+            (unsigned long long)(layout->offset_positions - layout->offset_indices), GLTF_GENERATOR_TARGET_INDEX);
+    fprintf(file, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu,\"target\":%u},\n",
+            (unsigned long long)layout->offset_positions,
+            (unsigned long long)(layout->offset_normals - layout->offset_positions), GLTF_GENERATOR_TARGET_VERTEX);
+    fprintf(file, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu,\"target\":%u},\n",
+            (unsigned long long)layout->offset_normals,
+            (unsigned long long)(layout->offset_tex_coords - layout->offset_normals), GLTF_GENERATOR_TARGET_VERTEX);
+    fprintf(file, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu,\"target\":%u}%s\n",
+            (unsigned long long)layout->offset_tex_coords,
+            (unsigned long long)(layout->offset_times - layout->offset_tex_coords), GLTF_GENERATOR_TARGET_VERTEX,
+            config->animation_count ? "," : "");
+    if (config->animation_count) {
+        fprintf(file, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu},\n",
+                (unsigned long long)layout->offset_times,
+                (unsigned long long)(layout->offset_translations - layout->offset_times));
+        fprintf(file, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu},\n",
+                (unsigned long long)layout->offset_translations,
+                (unsigned long long)(layout->offset_rotations - layout->offset_translations));
+        fprintf(file, "{\"buffer\":0,\"byteOffset\":%llu,\"byteLength\":%llu}\n",
+                (unsigned long long)layout->offset_rotations,
+                (unsigned long long)(layout->size - layout->offset_rotations));
+    }
+    fprintf(file, "],\n");
+
+    // Materials
+    fprintf(file, "\"materials\":[\n");
+    for(u32 i = 0; i < config->material_count; ++i) {
+        fprintf(file,
+            "{\"pbrMetallicRoughness\":{\"baseColorFactor\":[%.4f,%.4f,%.4f,1.0],\"metallicFactor\":%.4f,"
+            "\"roughnessFactor\":%.4f},\"doubleSided\":%s}%s\n",
+            (float)(i % 7) / 7, (float)(i % 11) / 11, (float)(i % 13) / 13, (float)(i % 5) / 5, (float)(i % 3) / 3,
+            i & 1 ? "true" : "false", i + 1 == config->material_count ? "" : ",");
+    }
+    fprintf(file, "],\n");
+
+    // Meshes
+    fprintf(file, "\"meshes\":[\n");
+    u32 primitive = 0;
+    for(u32 i = 0; i < config->mesh_count; ++i) {
+        fprintf(file, "{\"primitives\":[");
+        for(u32 j = 0; j < config->primitives_per_mesh; ++j) {
+            fprintf(file,
+                "{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u,\"material\":%u,\"mode\":4}%s",
+                primitive * 4 + 1, primitive * 4 + 2, primitive * 4 + 3, primitive * 4, primitive % config->material_count,
+                j + 1 == config->primitives_per_mesh ? "" : ",");
+            primitive++;
+        }
+        fprintf(file, "]}%s\n", i + 1 == config->mesh_count ? "" : ",");
+    }
+    fprintf(file, "],\n");
+
+    // Nodes, a binary tree
+    fprintf(file, "\"nodes\":[\n");
+    for(u32 i = 0; i < config->node_count; ++i) {
+        u64 child = (u64)i * 2 + 1;
+        fprintf(file, "{\"mesh\":%u,\"translation\":[%.4f,0.0,%.4f]", i % config->mesh_count,
+                (float)(i & 15) * 0.25f, (float)((i >> 4) & 15) * 0.25f);
+        if (child + 1 < config->node_count)
+            fprintf(file, ",\"children\":[%llu,%llu]", (unsigned long long)child, (unsigned long long)child + 1);
+        else if (child < config->node_count)
+            fprintf(file, ",\"children\":[%llu]", (unsigned long long)child);
+        fprintf(file, "}%s\n", i + 1 == config->node_count ? "" : ",");
+    }
+    fprintf(file, "]\n}\n");
+}
+
+static void gltf_generator_write_bin(FILE *file, const Gltf_Generator_Config *config, const Gltf_Generator_Layout *layout) {
+    u32 grid_size = config->grid_size;
+    u32 primitive_count = layout->primitive_count;
+
+    // Indices, the same for every primitive
+    u16 zero = 0;
+    for(u32 i = 0; i < primitive_count; ++i) {
+        for(u32 y = 0; y < grid_size - 1; ++y) {
+            for(u32 x = 0; x < grid_size - 1; ++x) {
+                u16 quad[6] = {
+                    (u16)(y * grid_size + x), (u16)((y + 1) * grid_size + x), (u16)(y * grid_size + x + 1),
+                    (u16)(y * grid_size + x + 1), (u16)((y + 1) * grid_size + x), (u16)((y + 1) * grid_size + x + 1),
+                };
+                fwrite(quad, sizeof(quad), 1, file);
+            }
+        }
+        if (layout->index_count & 1)
+            fwrite(&zero, sizeof(zero), 1, file);
+    }
+
+    // Positions
+    float step = 1.0 / (float)(grid_size - 1);
+    float origin_x, origin_z;
+    for(u32 i = 0; i < primitive_count; ++i) {
+        gltf_generator_get_grid_origin(i, &origin_x, &origin_z);
+        for(u32 y = 0; y < grid_size; ++y) {
+            for(u32 x = 0; x < grid_size; ++x) {
+                // The last vertex in a row is the origin plus one exactly, to match the accessor max.
+                float position[3] = {
+                    x + 1 == grid_size ? origin_x + 1 : origin_x + x * step, 0,
+                    y + 1 == grid_size ? origin_z + 1 : origin_z + y * step,
+                };
+                fwrite(position, sizeof(position), 1, file);
+            }
+        }
+    }
+
+    // Normals
+    float normal[3] = {0, 1, 0};
+    for(u64 i = 0; i < (u64)primitive_count * layout->vertex_count; ++i)
+        fwrite(normal, sizeof(normal), 1, file);
+
+    // Tex coords
+    for(u32 i = 0; i < primitive_count; ++i) {
+        for(u32 y = 0; y < grid_size; ++y) {
+            for(u32 x = 0; x < grid_size; ++x) {
+                float tex_coord[2] = {x * step, y * step};
+                fwrite(tex_coord, sizeof(tex_coord), 1, file);
+            }
+        }
+    }
+
+    if (!config->animation_count)
+        return;
+
+    // Keyframe times
+    for(u32 i = 0; i < config->keyframe_count; ++i) {
+        float time = i * GLTF_GENERATOR_FRAME_TIME;
+        fwrite(&time, sizeof(time), 1, file);
+    }
+
+    // Translations: bob up and down
+    for(u32 i = 0; i < config->animation_count; ++i) {
+        for(u32 j = 0; j < config->keyframe_count; ++j) {
+            float translation[3] = {0, (float)sin((float)j / (config->keyframe_count - 1) * 6.2831853f), 0};
+            fwrite(translation, sizeof(translation), 1, file);
+        }
+    }
+
+    // Rotations: one turn around y
+    for(u32 i = 0; i < config->animation_count; ++i) {
+        for(u32 j = 0; j < config->keyframe_count; ++j) {
+            float half_angle = (float)j / (config->keyframe_count - 1) * 3.1415927f;
+            float rotation[4] = {0, (float)sin(half_angle), 0, (float)cos(half_angle)};
+            fwrite(rotation, sizeof(rotation), 1, file);
+        }
+    }
+}
+
+static void gltf_generator_write_u32(FILE *file, u32 value) {
+    fwrite(&value, sizeof(value), 1, file);
+}
+
+bool gltf_generate(const char *dir, const char *name, const Gltf_Generator_Config *config, Gltf_Generator_Stats *stats) {
+    assert(config->mesh_count && config->primitives_per_mesh && config->node_count && config->material_count);
+    assert(config->grid_size >= 2 && config->grid_size <= 256 && "Primitives use u16 indices");
+    assert((!config->animation_count || config->keyframe_count >= 2) && "Linear keyframes need at least two frames");
+
+    Gltf_Generator_Layout layout = gltf_generator_get_layout(config);
+
+    char path[512];
+    char bin_uri[256];
+    snprintf(bin_uri, sizeof(bin_uri), "%s.bin", name);
+    snprintf(path, sizeof(path), "%s%s.%s", dir, name, config->glb ? "glb" : "gltf");
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    static char file_buffer[1024 * 1024]; // Lots of small writes
+    setvbuf(file, file_buffer, _IOFBF, sizeof(file_buffer));
+
+    u64 json_size;
+    if (config->glb) {
+        // Header and json chunk header are written once the json length is known.
+        const u64 header_size = 12 + 8;
+        fseek(file, header_size, SEEK_SET);
+        gltf_generator_write_json(file, config, &layout, NULL);
+
+        json_size = ftell(file) - header_size;
+        while(json_size & 3) { // The json chunk is padded with spaces
+            fputc(' ', file);
+            json_size++;
+        }
+
+        gltf_generator_write_u32(file, layout.size);
+        gltf_generator_write_u32(file, GLTF_GENERATOR_GLB_CHUNK_BIN);
+        gltf_generator_write_bin(file, config, &layout);
+
+        u64 total_size = ftell(file);
+        assert(total_size == header_size + json_size + 8 + layout.size);
+        assert(total_size <= 0xffffffff && "Glb files are limited to 4GB");
+
+        fseek(file, 0, SEEK_SET);
+        gltf_generator_write_u32(file, GLTF_GENERATOR_GLB_MAGIC);
+        gltf_generator_write_u32(file, 2);
+        gltf_generator_write_u32(file, total_size);
+        gltf_generator_write_u32(file, json_size);
+        gltf_generator_write_u32(file, GLTF_GENERATOR_GLB_CHUNK_JSON);
+    } else {
+        gltf_generator_write_json(file, config, &layout, bin_uri);
+        json_size = ftell(file);
+    }
+
+    bool ok = !ferror(file);
+    ok &= fclose(file) == 0;
+
+    if (ok && !config->glb) {
+        snprintf(path, sizeof(path), "%s%s", dir, bin_uri);
+        file = fopen(path, "wb");
+        if (!file)
+            return false;
+
+        setvbuf(file, file_buffer, _IOFBF, sizeof(file_buffer));
+        gltf_generator_write_bin(file, config, &layout);
+        assert((u64)ftell(file) == layout.size);
+
+        ok &= !ferror(file);
+        ok &= fclose(file) == 0;
+    }
+
+    if (stats) {
+        u64 animation_count = config->animation_count;
+
+        stats->accessor_count    = (u64)layout.primitive_count * 4 + (animation_count ? 1 + animation_count * 2 : 0);
+        stats->animation_count   = animation_count;
+        stats->buffer_view_count = animation_count ? 7 : 4;
+        stats->material_count    = config->material_count;
+        stats->mesh_count        = config->mesh_count;
+        stats->primitive_count   = layout.primitive_count;
+        stats->node_count        = config->node_count;
+        stats->entity_count      = stats->accessor_count + stats->animation_count + stats->buffer_view_count +
+                                   stats->material_count + stats->mesh_count     + stats->node_count        +
+                                   1 /* buffer */ + 1 /* scene */;
+        stats->json_size         = json_size;
+        stats->bin_size          = layout.size;
+    }
+
+    return ok;
+}
+
+#endif // BENCH
@@ -0,0 +1,54 @@
+#if BENCH
+
+#ifndef SOL_GLTF_GENERATOR_HPP_INCLUDE_GUARD_
+#define SOL_GLTF_GENERATOR_HPP_INCLUDE_GUARD_
+
+#include "../typedef.h"
+
+//
+// Writes synthetic but valid gltf files, for measuring the parser and model loading at scales which the hand
+// written fixtures in test/ do not reach. Used by the benchmarks, and by the standalone 'gltf_generator' target
+// (test/gltf_generator_main.cpp) for producing files to load by hand.
+//
+// Every primitive is a grid_size * grid_size vertex grid (POSITION, NORMAL, TEXCOORD_0, u16 indices) with its own
+// accessors; the grids are laid out side by side so that every POSITION min/max is different. Nodes form a binary
+// tree rooted at node 0, each one instancing mesh 'i % mesh_count'. Each animation has a translation and a
+// rotation channel on node 'i % node_count', sharing one keyframe time accessor.
+//
+// Vertex and index data share seven buffer views in one buffer, whatever the entity counts (model_from_gltf(..)
+// assumes a small number of buffer views).
+//
+struct Gltf_Generator_Config {
+    u32  mesh_count;          // >= 1
+    u32  primitives_per_mesh; // >= 1
+    u32  node_count;          // >= 1
+    u32  material_count;      // >= 1
+    u32  animation_count;
+    u32  keyframe_count;      // >= 2 if animation_count > 0
+    u32  grid_size;           // >= 2, <= 256 (u16 indices)
+    bool glb;                 // write one .glb, else a .gltf and a .bin
+};
+
+struct Gltf_Generator_Stats {
+    u64 accessor_count;
+    u64 animation_count;
+    u64 buffer_view_count;
+    u64 material_count;
+    u64 mesh_count;
+    u64 primitive_count;
+    u64 node_count;
+    u64 entity_count; // The total of the elements of every top level array in the file
+    u64 json_size;
+    u64 bin_size;
+};
+
+// A config with roughly 'entity_count' elements in total (see Gltf_Generator_Stats::entity_count for the exact number).
+Gltf_Generator_Config gltf_generator_config_from_entity_count(u64 entity_count);
+
+// Writes '<dir><name>.gltf' and '<dir><name>.bin', or '<dir><name>.glb'. 'dir' must end in a separator (as the
+// model dirs do). Returns false if a file could not be written.
+bool gltf_generate(const char *dir, const char *name, const Gltf_Generator_Config *config, Gltf_Generator_Stats *stats);
+
+#endif // include guard
+
+#endif // BENCH
@@ -0,0 +1,80 @@
+#if BENCH
+
+#include <stdlib.h>
+#include "gltf_generator.hpp"
+#include "../print.h"
+
+//
+// Standalone entry point for the 'gltf_generator' target (cmake -DBUILD_BENCH=ON):
+//
+//     gltf_generator <dir/> <name> [--entities n] [--meshes n] [--primitives n] [--nodes n] [--materials n]
+//                    [--animations n] [--keyframes n] [--grid n] [--glb]
+//
+// '--entities' picks every count at once (see gltf_generator_config_from_entity_count(..)); any counts which
+// follow it override its choice.
+//
+
+static void gltf_generator_print_usage() {
+    println("usage: gltf_generator <dir/> <name> [--entities n] [--meshes n] [--primitives n] [--nodes n]");
+    println("                      [--materials n] [--animations n] [--keyframes n] [--grid n] [--glb]");
+}
+
+int main(int argc, const char **argv) {
+    if (argc < 3) {
+        gltf_generator_print_usage();
+        return 1;
+    }
+
+    Gltf_Generator_Config config = gltf_generator_config_from_entity_count(1000);
+
+    for(int i = 3; i < argc; ++i) {
+        if (strcmp(argv[i], "--glb") == 0) {
+            config.glb = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            gltf_generator_print_usage();
+            return 1;
+        }
+
+        u64 n = strtoull(argv[i + 1], NULL, 10);
+        if (strcmp(argv[i], "--entities") == 0) {
+            bool glb = config.glb;
+            config = gltf_generator_config_from_entity_count(n);
+            config.glb = glb;
+        } else if (strcmp(argv[i], "--meshes") == 0) {
+            config.mesh_count = n;
+        } else if (strcmp(argv[i], "--primitives") == 0) {
+            config.primitives_per_mesh = n;
+        } else if (strcmp(argv[i], "--nodes") == 0) {
+            config.node_count = n;
+        } else if (strcmp(argv[i], "--materials") == 0) {
+            config.material_count = n;
+        } else if (strcmp(argv[i], "--animations") == 0) {
+            config.animation_count = n;
+        } else if (strcmp(argv[i], "--keyframes") == 0) {
+            config.keyframe_count = n;
+        } else if (strcmp(argv[i], "--grid") == 0) {
+            config.grid_size = n;
+        } else {
+            gltf_generator_print_usage();
+            return 1;
+        }
+        ++i;
+    }
+
+    Gltf_Generator_Stats stats;
+    if (!gltf_generate(argv[1], argv[2], &config, &stats)) {
+        println("Failed to write %s%s", argv[1], argv[2]);
+        return 1;
+    }
+
+    println("Wrote %s%s.%s: %u entities (%u meshes, %u primitives, %u accessors, %u nodes, %u materials, %u animations)",
+            argv[1], argv[2], config.glb ? "glb" : "gltf", stats.entity_count, stats.mesh_count, stats.primitive_count,
+            stats.accessor_count, stats.node_count, stats.material_count, stats.animation_count);
+    println("    json: %u bytes, bin: %u bytes", stats.json_size, stats.bin_size);
+
+    return 0;
+}
+
+#endif // BENCH